@@ -150,6 +150,20 @@ class PrimitiveDB:
   def add(self, physloc: PhysLocation):
     self._db.add_primitive(physloc._loc)
 
+  def save(self, path: str):
+    """Write the primitive locations to a binary file, so that the device setup
+    can be loaded with `load` instead of being rebuilt on every run."""
+    if not self._db.save(path):
+      raise IOError(f"could not save primitive DB to '{path}'")
+
+  @staticmethod
+  def load(path: str) -> PrimitiveDB:
+    """Create a PrimitiveDB from a file written by `save`."""
+    db = PrimitiveDB()
+    if not db._db.load(path):
+      raise IOError(f"could not load primitive DB from '{path}'")
+    return db
+
 
 class PlacementDB:
   from .instance import Instance
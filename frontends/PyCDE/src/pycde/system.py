@@ -26,6 +26,8 @@ import circt.support
 from contextvars import ContextVar
 from collections.abc import Iterable
 import gc
+import hashlib
+import inspect
 import os
 import pathlib
 import sys
@@ -46,7 +48,8 @@ class System:
   __slots__ = [
       "mod", "top_modules", "name", "passed", "_old_system_token", "_op_cache",
       "_generate_queue", "output_directory", "files", "mod_files",
-      "packaging_funcs", "sw_api_langs", "_instance_roots", "_placedb"
+      "packaging_funcs", "sw_api_langs", "_instance_roots", "_placedb",
+      "_generator_cache"
   ]
 
   PASSES = """
@@ -63,7 +66,8 @@ class System:
                top_modules: Union[list, _SpecializedModule],
                name: str = "PyCDESystem",
                output_directory: str = None,
-               sw_api_langs: List[str] = None):
+               sw_api_langs: List[str] = None,
+               generator_cache_dir: os.PathLike = None):
     self.passed = False
     self.mod = ir.Module.create()
     if isinstance(top_modules, Iterable):
@@ -80,6 +84,13 @@ class System:
 
     self._placedb: PlacementDB = None
 
+    # Cache of generator outputs, if requested or set in the environment.
+    if generator_cache_dir is None:
+      generator_cache_dir = os.environ.get("PYCDE_GENERATOR_CACHE")
+    self._generator_cache: _GeneratorCache = None
+    if generator_cache_dir is not None:
+      self._generator_cache = _GeneratorCache(generator_cache_dir)
+
     # The set of all files generated by PyCDE.
     self.files: Set[os.PathLike] = set()
     # The set of module SV files generated by PyCDE.
@@ -190,14 +201,22 @@ class System:
     if symbol is None:
       return
 
-    # Build the correct op.
-    op = spec_mod.create_cb(self, spec_mod, symbol)
+    has_generator = getattr(spec_mod, 'generator_cb', None) is not None
+    # Reuse the output of the generator from a previous run if it is in the
+    # generator cache. Otherwise, build the correct op.
+    op = None
+    if has_generator and self._generator_cache is not None:
+      op = self._generator_cache.load(self, spec_mod, symbol)
+    generated = op is not None
+    if not generated:
+      op = spec_mod.create_cb(self, spec_mod, symbol)
     # Install the op in the cache.
     install_func(op)
     # Add to the generation queue if the module has a generator callback.
-    if hasattr(spec_mod, 'generator_cb') and spec_mod.generator_cb is not None:
+    if has_generator:
       assert callable(spec_mod.generator_cb)
-      self._generate_queue.append(spec_mod)
+      if not generated:
+        self._generate_queue.append(spec_mod)
       file_name = spec_mod.modcls.__name__ + ".sv"
       outfn = self.output_directory / file_name
       self.files.add(outfn)
@@ -245,7 +264,13 @@ class System:
     with self:
       while len(self._generate_queue) > 0 and (iters is None or i < iters):
         m = self._generate_queue.pop()
+        num_top_level_ops = len(self.body.operations)
         m.generate()
+        # Only generators which did not create any other top-level op (e.g.
+        # other modules) can be replayed from the cache.
+        if self._generator_cache is not None and \
+            len(self.body.operations) == num_top_level_ops:
+          self._generator_cache.store(m, self._op_cache.get_circt_mod(m))
         i += 1
 
     # Run passes which must get run between generation and instance hierarch
@@ -368,6 +393,100 @@ class System:
       func(self)
 
 
+class _GeneratorCache:
+  """Stores the modules built by generators in a directory, such that later
+  runs can skip the generators whose inputs did not change. A module is found
+  by a hash of its name, parameters, ports and the source of its generator.
+  Functions called by the generator are not part of the hash, so the cache must
+  be cleared if they change.
+
+  Only modules which do not need any Python-side bookkeeping are cached: their
+  generator must not have created other modules and they must not use type
+  aliases. A cached module is only used if all the symbols it references
+  already exist."""
+
+  # Bump this to invalidate the caches of earlier versions.
+  VERSION = "1"
+
+  __slots__ = ["directory", "hits", "misses"]
+
+  def __init__(self, directory: os.PathLike):
+    self.directory = pathlib.Path(directory)
+    self.directory.mkdir(parents=True, exist_ok=True)
+    self.hits = 0
+    self.misses = 0
+
+  def _path(self, spec_mod: _SpecializedModule) -> pathlib.Path:
+    h = hashlib.sha256()
+
+    def add(s):
+      h.update(str(s).encode())
+      h.update(b"\0")
+
+    add(self.VERSION)
+    add(spec_mod.modcls.__module__ + "." + spec_mod.modcls.__qualname__)
+    add(spec_mod.name)
+    add(spec_mod.parameters)
+    for (name, type) in spec_mod.input_ports + spec_mod.output_ports:
+      add(name)
+      add(type)
+    for name, gen in spec_mod.generators.items():
+      add(name)
+      try:
+        add(inspect.getsource(gen.gen_func))
+      except (OSError, TypeError):
+        add(gen.gen_func.__code__.co_code.hex())
+    return self.directory / (h.hexdigest() + ".mlir")
+
+  @staticmethod
+  def _referenced_symbols(op: ir.Operation):
+    """Yield the names of all the symbols referenced by 'op' and the ops nested
+    in it."""
+    for named_attr in op.attributes:
+      if ir.FlatSymbolRefAttr.isinstance(named_attr.attr):
+        yield ir.FlatSymbolRefAttr(named_attr.attr).value
+    for region in op.regions:
+      for block in region.blocks:
+        for nested in block.operations:
+          yield from _GeneratorCache._referenced_symbols(nested.operation)
+
+  def load(self, sys: System, spec_mod: _SpecializedModule,
+           symbol: str) -> ir.Operation:
+    """Try to build the module from the cache. Returns the module op, appended
+    to the system, or None if there is no usable entry."""
+    path = self._path(spec_mod)
+    if not path.exists():
+      self.misses += 1
+      return None
+    try:
+      cached = ir.Module.parse(path.read_text())
+    except Exception:
+      self.misses += 1
+      return None
+    op = cached.body.operations[0]
+    own_symbol = ir.StringAttr(op.attributes["sym_name"]).value
+    for ref in _GeneratorCache._referenced_symbols(op.operation):
+      if ref != own_symbol and ref not in sys._op_cache.symbols:
+        self.misses += 1
+        return None
+    op.attributes["sym_name"] = ir.StringAttr.get(symbol)
+    sys.body.append(op)
+    self.hits += 1
+    return op
+
+  def store(self, spec_mod: _SpecializedModule, op: ir.Operation):
+    """Write the generated module 'op' to the cache."""
+    asm = op.operation.get_asm(enable_debug_info=True)
+    if "!hw.typealias" in asm:
+      return
+    path = self._path(spec_mod)
+    # Write to a temporary file first such that concurrent runs never see a
+    # partial entry.
+    tmp = path.with_suffix(f".{os.getpid()}.tmp")
+    tmp.write_text(asm)
+    os.replace(tmp, path)
+
+
 class _OpCache:
   """Used to cache CIRCT operations and handle symbols."""
 
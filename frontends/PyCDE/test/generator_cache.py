@@ -0,0 +1,62 @@
+# RUN: rm -rf %t && %PYTHON% %s %t | FileCheck %s
+
+from pycde import Input, Output, System, generator, module, types
+from pycde.dialects import comb
+
+import sys
+
+cache_dir = sys.argv[1] + "/cache"
+num_generated = 0
+
+
+@module
+class Leaf:
+  a = Input(types.i8)
+  x = Output(types.i8)
+
+  @generator
+  def build(ports):
+    global num_generated
+    num_generated += 1
+    ports.x = comb.AddOp(ports.a, ports.a)
+
+
+@module
+class Top:
+  a = Input(types.i8)
+  x = Output(types.i8)
+
+  @generator
+  def build(ports):
+    global num_generated
+    num_generated += 1
+    ports.x = Leaf(a=ports.a).x
+
+
+def run():
+  global num_generated
+  num_generated = 0
+  s = System([Top],
+             output_directory=sys.argv[1] + "/out",
+             generator_cache_dir=cache_dir)
+  s.generate()
+  print(f"generated: {num_generated}")
+  s.print()
+
+
+# Top instantiates another module, so it is never cached. Leaf is generated in
+# the first run only.
+# CHECK:       generated: 2
+# CHECK-LABEL: msft.module @Top
+# CHECK:         msft.instance @Leaf @Leaf(%a)
+# CHECK-LABEL: msft.module @Leaf
+# CHECK:         comb.add %a, %a : i8
+run()
+
+# CHECK:       generated: 1
+# CHECK-LABEL: msft.module @Top
+# CHECK:         msft.instance @Leaf @Leaf(%a)
+# CHECK-LABEL: msft.module @Leaf
+# CHECK-SAME:    fileName = "Leaf.sv"
+# CHECK:         comb.add %a, %a : i8
+run()
@@ -140,6 +140,15 @@ MLIR_CAPI_EXPORTED MlirType hwParamDeclRefAttrGetType(MlirAttribute decl);
 MLIR_CAPI_EXPORTED bool hwAttrIsAParamVerbatimAttr(MlirAttribute);
 MLIR_CAPI_EXPORTED MlirAttribute hwParamVerbatimAttrGet(MlirAttribute text);
 
+/// Create the value of an `hw.array_constant` of `arrayType` from a buffer of
+/// its elements, lowest index first, in the raw storage layout of dense
+/// integer attributes: `ceil(width / 8)` bytes per element, or one bit per
+/// element for `i1` elements. Return a null attribute if the element type is
+/// not an integer type, or the buffer does not match the type.
+MLIR_CAPI_EXPORTED MlirAttribute hwArrayConstantAttrGet(MlirType arrayType,
+                                                        size_t numBytes,
+                                                        const void *buffer);
+
 #ifdef __cplusplus
 }
 #endif
@@ -85,6 +85,14 @@ MLIR_CAPI_EXPORTED MlirLogicalResult circtMSFTPrimitiveDBAddPrimitive(
 MLIR_CAPI_EXPORTED bool
 circtMSFTPrimitiveDBIsValidLocation(CirctMSFTPrimitiveDB,
                                     MlirAttribute locAndPrim);
+/// Write the primitive locations to a binary file, which can be loaded again
+/// with `circtMSFTPrimitiveDBLoad`.
+MLIR_CAPI_EXPORTED MlirLogicalResult
+circtMSFTPrimitiveDBSave(CirctMSFTPrimitiveDB, MlirStringRef path);
+/// Add the primitive locations from a file written by
+/// `circtMSFTPrimitiveDBSave`.
+MLIR_CAPI_EXPORTED MlirLogicalResult
+circtMSFTPrimitiveDBLoad(CirctMSFTPrimitiveDB, MlirStringRef path);
 
 //===----------------------------------------------------------------------===//
 // PlacementDB.
@@ -117,6 +125,28 @@ MLIR_CAPI_EXPORTED MlirAttribute circtMSFTPlacementDBGetNearestFreeInColumn(
     CirctMSFTPlacementDB, CirctMSFTPrimitiveType prim, uint64_t column,
     uint64_t nearestToY);
 
+/// Place `numPlacements` primitives at once. Placement `i` assigns
+/// `subpaths[i]` of the dynamic instance `insts[i]` to the location
+/// (`prims[i]`, `xs[i]`, `ys[i]`, `nums[i]`), and stores the location op in
+/// `results[i]`, or a null op if the placement failed.
+MLIR_CAPI_EXPORTED void circtMSFTPlacementDBPlaceMany(
+    CirctMSFTPlacementDB, intptr_t numPlacements, MlirOperation const *insts,
+    MlirStringRef const *subpaths, CirctMSFTPrimitiveType const *prims,
+    uint64_t const *xs, uint64_t const *ys, uint64_t const *nums,
+    MlirLocation srcLoc, MlirOperation *results);
+/// Look up the instances at `numLocations` locations at once, storing a null
+/// op in `results` for unoccupied locations.
+MLIR_CAPI_EXPORTED void circtMSFTPlacementDBGetInstancesAt(
+    CirctMSFTPlacementDB, intptr_t numLocations,
+    CirctMSFTPrimitiveType const *prims, uint64_t const *xs,
+    uint64_t const *ys, uint64_t const *nums, MlirOperation *results);
+/// Find the nearest free locations for `numQueries` queries at once, storing a
+/// null attribute in `results` for columns without a free location.
+MLIR_CAPI_EXPORTED void circtMSFTPlacementDBGetNearestFreeInColumns(
+    CirctMSFTPlacementDB, intptr_t numQueries,
+    CirctMSFTPrimitiveType const *prims, uint64_t const *columns,
+    uint64_t const *nearestToYs, MlirAttribute *results);
+
 typedef void (*CirctMSFTPlacementCallback)(MlirAttribute loc,
                                            MlirOperation locOp, void *userData);
 /// Walk all the placements within 'bounds' ([xmin, xmax, ymin, ymax], inclusive
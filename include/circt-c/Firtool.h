@@ -0,0 +1,88 @@
+//===-- circt-c/Firtool.h - C API for the firtool pipeline --------*- C -*-===//
+//
+// This header declares the C interface for compiling FIRRTL to Verilog with
+// the pass pipeline of firtool, without starting a firtool process.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_C_FIRTOOL_H
+#define CIRCT_C_FIRTOOL_H
+
+#include "mlir-c/IR.h"
+#include "mlir-c/Pass.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Which aggregate values the type lowering preserves, as in the
+/// `--preserve-aggregate` option of firtool.
+typedef enum {
+  CIRCT_FIRTOOL_PRESERVE_AGGREGATE_NONE,
+  CIRCT_FIRTOOL_PRESERVE_AGGREGATE_1D_VEC,
+  CIRCT_FIRTOOL_PRESERVE_AGGREGATE_VEC,
+  CIRCT_FIRTOOL_PRESERVE_AGGREGATE_ALL,
+} CirctFirtoolPreserveAggregateMode;
+
+/// Which values may be optimized away, as in the `--preserve-values` option
+/// of firtool.
+typedef enum {
+  CIRCT_FIRTOOL_PRESERVE_VALUES_NONE,
+  CIRCT_FIRTOOL_PRESERVE_VALUES_NAMED,
+  CIRCT_FIRTOOL_PRESERVE_VALUES_ALL,
+} CirctFirtoolPreserveValuesMode;
+
+/// The options of the firtool pipeline, named after the firtool options. The
+/// strings are only referenced until the pipeline is built.
+typedef struct {
+  bool disableOptimization;
+  CirctFirtoolPreserveValuesMode preserveValues;
+  CirctFirtoolPreserveAggregateMode preserveAggregate;
+  bool preservePublicTypes;
+  bool dedup;
+  bool disableAnnotationsUnknown;
+  bool disableAnnotationsClassless;
+  bool replSeqMem;
+  MlirStringRef replSeqMemCircuit;
+  MlirStringRef replSeqMemFile;
+  bool ignoreReadEnableMem;
+  bool lowerMemories;
+  bool disableMemRandomization;
+  bool disableRegRandomization;
+  bool emitMetadata;
+  bool emitOMIR;
+  MlirStringRef omirOutFile;
+  /// The root of the paths of black box annotations. Defaults to the
+  /// directory of the input file name passed to the pipeline.
+  MlirStringRef blackBoxRootPath;
+  bool emitChiselAssertsAsSVA;
+  bool stripMuxPragmas;
+  bool extractTestCode;
+  bool stripFirDebugInfo;
+  bool stripDebugInfo;
+} CirctFirtoolOptions;
+
+/// Return the options with the defaults of firtool.
+MLIR_CAPI_EXPORTED CirctFirtoolOptions circtFirtoolOptionsGetDefault(void);
+
+/// Load the dialects which the input and the passes of the pipeline use.
+MLIR_CAPI_EXPORTED void circtFirtoolLoadDialects(MlirContext ctx);
+
+/// Add the whole pipeline, from FIRRTL to one Verilog file per module in
+/// `directory`, to `pm`, which must be anchored on the builtin module. The
+/// stages are nested and parallelized as in firtool. `module` is the module
+/// the pipeline will run on, and `inputFilename` the file it was read from.
+MLIR_CAPI_EXPORTED MlirLogicalResult circtFirtoolPopulateSplitVerilogPipeline(
+    MlirPassManager pm, MlirModule module, const CirctFirtoolOptions *options,
+    MlirStringRef inputFilename, MlirStringRef directory);
+
+/// Compile `module` from FIRRTL to one Verilog file per module in `directory`.
+MLIR_CAPI_EXPORTED MlirLogicalResult circtFirtoolCompileToSplitVerilog(
+    MlirModule module, const CirctFirtoolOptions *options,
+    MlirStringRef inputFilename, MlirStringRef directory);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CIRCT_C_FIRTOOL_H
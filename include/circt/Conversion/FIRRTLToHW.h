@@ -26,7 +26,8 @@ namespace circt {
 std::unique_ptr<mlir::Pass> createLowerFIRRTLToHWPass(
     bool enableAnnotationWarning = false, bool emitChiselAssertsAsSVA = false,
     bool stripMuxPragmas = false, bool disableMemRandomization = false,
-    bool disableRegRandomization = false);
+    bool disableRegRandomization = false, bool lowMemory = false,
+    uint64_t maxMemory = 0);
 
 } // namespace circt
 
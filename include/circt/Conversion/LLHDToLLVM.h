@@ -33,7 +33,8 @@ void populateLLHDToLLVMConversionPatterns(mlir::LLVMTypeConverter &converter,
                                           size_t &regCounter);
 
 /// Create an LLHD to LLVM conversion pass.
-std::unique_ptr<OperationPass<ModuleOp>> createConvertLLHDToLLVMPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createConvertLLHDToLLVMPass(bool batchDrives = false);
 
 } // namespace circt
 
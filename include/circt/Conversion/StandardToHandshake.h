@@ -85,7 +85,8 @@ public:
   LogicalResult feedForwardRewriting(ConversionPatternRewriter &rewriter);
   LogicalResult loopNetworkRewriting(ConversionPatternRewriter &rewriter);
 
-  BlockOps insertMergeOps(BlockValues blockLiveIns, blockArgPairs &mergePairs,
+  BlockOps insertMergeOps(const BlockValues &blockLiveIns,
+                          blockArgPairs &mergePairs,
                           ConversionPatternRewriter &rewriter);
 
   // Insert appropriate type of Merge CMerge for control-only path,
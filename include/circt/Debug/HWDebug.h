@@ -1,11 +1,99 @@
 #ifndef CIRCT_DEBUG_HWDEBUG_H
 #define CIRCT_DEBUG_HWDEBUG_H
 
+#include "mlir/IR/BuiltinOps.h"
 #include "mlir/Pass/Pass.h"
+#include "llvm/Support/Timer.h"
+
+namespace circt::hw {
+class InstanceGraph;
+} // namespace circt::hw
 
 namespace circt::debug {
+
+/// Configure the format of the exported hgdb symbol table.
+namespace HGDBOutputFormat {
+enum Format {
+  /// JSON debug table, converted by the hgdb runtime when it starts.
+  JSON,
+
+  /// SQL script that builds the flattened and indexed hgdb symbol table.
+  SQL,
+};
+} // namespace HGDBOutputFormat
+
+/// Opcodes of the postfix bytecode that breakpoint conditions are optionally
+/// emitted as. Operands are pushed on a stack, and every operator pops its
+/// operands and pushes its result.
+namespace HGDBConditionCode {
+enum Opcode : int64_t {
+  /// Push a signal, followed by its index in the module's signal table.
+  Signal,
+  /// Push a constant, followed by its value.
+  Constant,
+
+  // binary operators
+  Add,
+  Sub,
+  Mul,
+  DivU,
+  DivS,
+  ModU,
+  ModS,
+  And,
+  Or,
+  Xor,
+
+  // comparisons, in the order of comb::ICmpPredicate
+  Eq,
+  Ne,
+  LtS,
+  LeS,
+  GtS,
+  GeS,
+  LtU,
+  LeU,
+  GtU,
+  GeU,
+
+  /// Bitwise negation of the top of the stack.
+  Not,
+  /// Logical negation of the top of the stack.
+  LogicalNot,
+  /// Logical and of the two values on top of the stack.
+  LogicalAnd,
+};
+} // namespace HGDBConditionCode
+
+/// Time and memory spent in each phase of a debug table export, along with the
+/// size of the collected table.
+struct HGDBExportStatistics {
+  /// Walking the module bodies and building the scopes.
+  llvm::TimeRecord visit;
+  /// Merging sibling scopes and fixing up their filenames.
+  llvm::TimeRecord merge;
+  /// Streaming the table out.
+  llvm::TimeRecord emit;
+
+  size_t numModules = 0;
+  size_t numScopes = 0;
+  size_t numVariables = 0;
+};
+
+/// Build the hgdb table of every HW module in `module` and stream it to `os`.
+/// If `conditionCode` is set, breakpoint conditions are also emitted as
+/// bytecode. If `stats` is set, each phase of the export is measured into it.
+void exportDebugTable(mlir::ModuleOp module, hw::InstanceGraph &instanceGraph,
+                      llvm::raw_ostream &os,
+                      HGDBOutputFormat::Format format = HGDBOutputFormat::JSON,
+                      bool conditionCode = false,
+                      HGDBExportStatistics *stats = nullptr);
+
 std::unique_ptr<mlir::Pass>
-createExportHGDBPass(llvm::Optional<std::string> filename = {});
+createExportHGDBPass(llvm::Optional<std::string> filename = {},
+                     HGDBOutputFormat::Format format = HGDBOutputFormat::JSON,
+                     llvm::StringRef cacheFile = {},
+                     bool conditionCode = false, bool stripDebugInfo = false);
 
 #define GEN_PASS_REGISTRATION
 #include "circt/Debug/DebugPasses.h.inc"
@@ -13,18 +13,266 @@
 #ifndef CIRCT_DIALECT_ESI_COSIM_ENDPOINT_H
 #define CIRCT_DIALECT_ESI_COSIM_ENDPOINT_H
 
+#include "circt/Dialect/ESI/cosim/SharedMemory.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <functional>
 #include <map>
-#include <memory>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 namespace circt {
 namespace esi {
 namespace cosim {
 
+/// Counters of the traffic through a message queue. The producer and the
+/// consumer each own the counters they update, so the counters are updated
+/// without atomic read-modify-writes. Other threads may read slightly stale
+/// values.
+class QueueStats {
+public:
+  /// Bucket `i` of the latency histogram counts the messages which spent
+  /// [2^i, 2^(i+1)) microseconds in the queue. The first bucket also counts
+  /// the faster ones, and the last one the slower ones.
+  static constexpr unsigned numLatencyBuckets = 24;
+
+  struct Snapshot {
+    uint64_t messages;
+    uint64_t bytes;
+    uint64_t maxDepth;
+    uint64_t emptyPolls;
+    std::array<uint64_t, numLatencyBuckets> latency;
+  };
+
+  /// The monotonic time, in nanoseconds, used for the latencies.
+  static uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  /// Count a message queued by the producer.
+  void recordMessage(size_t size) {
+    increment(messages);
+    increment(bytes, size);
+  }
+  /// Record the number of messages in the queue after the producer queued one.
+  void recordDepth(uint64_t depth) {
+    if (depth > maxDepth.load(std::memory_order_relaxed))
+      maxDepth.store(depth, std::memory_order_relaxed);
+  }
+  /// Count a poll of the consumer which found no message.
+  void recordEmptyPoll() { increment(emptyPolls); }
+  /// Record the latency of a message released by the consumer, which was
+  /// queued at `pushTime`.
+  void recordPop(uint64_t pushTime) {
+    uint64_t micros = (now() - pushTime) / 1000;
+    unsigned bucket = 0;
+    while (micros > 1 && bucket + 1 < numLatencyBuckets) {
+      micros >>= 1;
+      ++bucket;
+    }
+    increment(latency[bucket]);
+  }
+
+  Snapshot getSnapshot() const {
+    Snapshot snapshot;
+    snapshot.messages = messages.load(std::memory_order_relaxed);
+    snapshot.bytes = bytes.load(std::memory_order_relaxed);
+    snapshot.maxDepth = maxDepth.load(std::memory_order_relaxed);
+    snapshot.emptyPolls = emptyPolls.load(std::memory_order_relaxed);
+    for (unsigned i = 0; i < numLatencyBuckets; ++i)
+      snapshot.latency[i] = latency[i].load(std::memory_order_relaxed);
+    return snapshot;
+  }
+
+private:
+  static void increment(std::atomic<uint64_t> &counter, uint64_t n = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+  }
+
+  /// Written by the producer.
+  std::atomic<uint64_t> messages{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> maxDepth{0};
+  /// Written by the consumer.
+  alignas(64) std::atomic<uint64_t> emptyPolls{0};
+  std::array<std::atomic<uint64_t>, numLatencyBuckets> latency{};
+};
+
+/// A message queue with a single producer thread and a single consumer thread.
+/// Messages live in a lock-free ring of preallocated slots, which both sides
+/// access in place: the producer writes a message straight into a slot it
+/// reserved, and the consumer reads it from the slot before releasing it. So
+/// queueing a message takes no lock, no allocation and no intermediate copy.
+/// Polling an empty queue costs an atomic load of the ring, plus one of the
+/// overflow counter.
+///
+/// Messages which do not fit in a slot, or are pushed while the ring is full,
+/// go to a locked overflow queue instead. To keep the messages in order, the
+/// producer keeps using the overflow queue until the consumer drained it, so
+/// that the overflow only ever holds messages newer than those in the ring.
+///
+/// The queue keeps statistics of its traffic, except for the empty polls which
+/// its users count, to leave out polls which are not made by the consumer.
+class MessageQueue {
+public:
+  using Blob = std::vector<uint8_t>;
+
+  /// Create a queue of `numSlots` slots of `slotSize` bytes. `numSlots` must
+  /// be a power of two.
+  MessageQueue(size_t slotSize, size_t numSlots = 64)
+      : slotSize(slotSize), mask(numSlots - 1), slots(numSlots),
+        pushTimes(numSlots) {
+    for (Blob &slot : slots)
+      slot.reserve(slotSize);
+  }
+  MessageQueue(const MessageQueue &) = delete;
+
+  /// Reserve the space of a message of at most `maxSize` bytes and return it.
+  /// The space is zeroed and aligned for 64-bit words. The message is queued
+  /// by `commit`, and a new reservation drops an uncommitted one. Must only be
+  /// called from the producer thread.
+  uint8_t *reserve(size_t maxSize) {
+    reserved = nullptr;
+    if (maxSize <= slotSize &&
+        overflowSize.load(std::memory_order_acquire) == 0) {
+      size_t h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) <= mask)
+        reserved = &slots[h & mask];
+    }
+    if (!reserved)
+      reserved = &pendingOverflow;
+    reserved->assign(maxSize, 0);
+    return reserved->data();
+  }
+
+  /// Queue the message of `size` bytes written to the reserved space.
+  void commit(size_t size) {
+    assert(reserved && size <= reserved->size() && "no reserved space");
+    reserved->resize(size);
+    uint64_t pushTime = QueueStats::now();
+    size_t h = head.load(std::memory_order_relaxed);
+    size_t numOverflow;
+    if (reserved != &pendingOverflow) {
+      pushTimes[h & mask] = pushTime;
+      head.store(++h, std::memory_order_release);
+      numOverflow = 0;
+    } else {
+      Lock g(overflowMutex);
+      overflow.push(std::move(pendingOverflow));
+      overflowTimes.push(pushTime);
+      numOverflow = overflowSize.fetch_add(1, std::memory_order_release) + 1;
+    }
+    reserved = nullptr;
+    stats.recordMessage(size);
+    stats.recordDepth(h - tail.load(std::memory_order_relaxed) + numOverflow);
+  }
+
+  /// Queue a copy of a message.
+  void push(const uint8_t *data, size_t size) {
+    std::copy(data, data + size, reserve(size));
+    commit(size);
+  }
+
+  /// Return the oldest message, or nullptr if the queue is empty. The message
+  /// stays valid until it is released by `pop`. Must only be called from the
+  /// consumer thread.
+  const Blob *front() {
+    if (current)
+      return current;
+    if (const Blob *slot = frontRing())
+      return slot;
+    if (overflowSize.load(std::memory_order_acquire) == 0)
+      return nullptr;
+    // The ring may have been filled with messages older than the overflow
+    // since it was checked.
+    if (const Blob *slot = frontRing())
+      return slot;
+    Lock g(overflowMutex);
+    currentOverflow = std::move(overflow.front());
+    overflow.pop();
+    currentPushTime = overflowTimes.front();
+    overflowTimes.pop();
+    overflowSize.fetch_sub(1, std::memory_order_release);
+    return current = &currentOverflow;
+  }
+
+  /// Release the message returned by `front`.
+  void pop() {
+    assert(current && "no message to pop");
+    stats.recordPop(currentPushTime);
+    if (current != &currentOverflow)
+      tail.fetch_add(1, std::memory_order_release);
+    current = nullptr;
+  }
+
+  /// Pop the oldest message into `msg`. Return true if there was a message in
+  /// the queue.
+  bool pop(Blob &msg) {
+    const Blob *next = front();
+    if (!next)
+      return false;
+    msg = *next;
+    pop();
+    return true;
+  }
+
+  QueueStats &getStats() { return stats; }
+  const QueueStats &getStats() const { return stats; }
+
+private:
+  const Blob *frontRing() {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire))
+      return nullptr;
+    currentPushTime = pushTimes[t & mask];
+    return current = &slots[t & mask];
+  }
+
+  using Lock = std::lock_guard<std::mutex>;
+
+  const size_t slotSize;
+  const size_t mask;
+  std::vector<Blob> slots;
+
+  /// The message being written by the producer, in a slot of the ring or in a
+  /// buffer bound for the overflow queue.
+  Blob *reserved = nullptr;
+  Blob pendingOverflow;
+  /// The message being read by the consumer, in a slot of the ring or taken
+  /// off the overflow queue.
+  const Blob *current = nullptr;
+  Blob currentOverflow;
+  uint64_t currentPushTime = 0;
+  /// The times at which the messages in the ring were pushed. The producer
+  /// writes them before publishing the message.
+  std::vector<uint64_t> pushTimes;
+
+  /// The number of messages pushed to and popped from the ring. The producer
+  /// and the consumer get separate cache lines, so that polling does not
+  /// contend with pushing.
+  alignas(64) std::atomic<size_t> head{0};
+  alignas(64) std::atomic<size_t> tail{0};
+
+  alignas(64) std::atomic<size_t> overflowSize{0};
+  std::mutex overflowMutex;
+  std::queue<Blob> overflow;
+  std::queue<uint64_t> overflowTimes;
+
+  QueueStats stats;
+};
+
 /// Implements a bi-directional, thread-safe bridge between the RPC server and
-/// DPI functions.
+/// DPI functions. Each direction has exactly one producer and one consumer:
+/// the RPC server thread and the simulator thread.
 ///
 /// Several of the methods below are inline with the declaration to make them
 /// candidates for inlining during compilation. This is particularly important
@@ -32,13 +280,10 @@ namespace cosim {
 /// want to slow down the simulation any more than necessary.
 class Endpoint {
 public:
-  /// Representing messages as shared pointers to vectors may be a performance
-  /// issue in the future but it is the easiest way to ensure memory
-  /// correctness.
-  using Blob = std::vector<uint8_t>;
-  using BlobPtr = std::shared_ptr<Blob>;
+  using Blob = MessageQueue::Blob;
 
   /// Construct an endpoint which knows and the type IDs in both directions.
+  /// The max sizes, in bytes, size the message slots of the queues.
   Endpoint(uint64_t sendTypeId, int sendTypeMaxSize, uint64_t recvTypeId,
            int recvTypeMaxSize);
   ~Endpoint();
@@ -54,55 +299,66 @@ public:
   bool setInUse();
   void returnForUse();
 
+  /// The queues in both directions, for in-place access to the messages.
+  MessageQueue &getQueueToSim() { return toCosim; }
+  MessageQueue &getQueueToClient() { return toClient; }
+  const MessageQueue &getQueueToSim() const { return toCosim; }
+  const MessageQueue &getQueueToClient() const { return toClient; }
+
+  /// Return the shared memory transport of the endpoint, or nullptr if no
+  /// client opened it with one. Once set up, the transport carries the
+  /// messages to the client, in place of the RPC interface. Messages to the
+  /// simulation can come from both.
+  ShmRegion *getShm() const { return shm.load(std::memory_order_acquire); }
+  /// Set up the shared memory transport, or return the existing one. Returns
+  /// nullptr on failure. Must be called from the RPC server thread.
+  ShmRegion *attachShm();
+  /// The statistics of the shared memory rings, as seen by the simulation.
+  /// Only the messages and bytes are counted, and the empty polls of the ring
+  /// to the simulation.
+  QueueStats &getShmStatsToSim() { return shmToSimStats; }
+  QueueStats &getShmStatsToClient() { return shmToClientStats; }
+  const QueueStats &getShmStatsToSim() const { return shmToSimStats; }
+  const QueueStats &getShmStatsToClient() const { return shmToClientStats; }
+
   /// Queue message to the simulation.
-  void pushMessageToSim(BlobPtr msg) {
-    Lock g(m);
-    toCosim.push(msg);
+  void pushMessageToSim(const uint8_t *data, size_t size) {
+    toCosim.push(data, size);
   }
 
   /// Pop from the to-simulator queue. Return true if there was a message in the
   /// queue.
-  bool getMessageToSim(BlobPtr &msg) {
-    Lock g(m);
-    if (toCosim.empty())
-      return false;
-    msg = toCosim.front();
-    toCosim.pop();
-    return true;
-  }
+  bool getMessageToSim(Blob &msg) { return toCosim.pop(msg); }
 
   /// Queue message to the RPC client.
-  void pushMessageToClient(BlobPtr msg) {
-    Lock g(m);
-    toClient.push(msg);
+  void pushMessageToClient(const uint8_t *data, size_t size) {
+    toClient.push(data, size);
   }
 
   /// Pop from the to-RPC-client queue. Return true if there was a message in
   /// the queue.
-  bool getMessageToClient(BlobPtr &msg) {
-    Lock g(m);
-    if (toClient.empty())
-      return false;
-    msg = toClient.front();
-    toClient.pop();
-    return true;
-  }
+  bool getMessageToClient(Blob &msg) { return toClient.pop(msg); }
 
 private:
   const uint64_t sendTypeId;
+  const int sendTypeMaxSize;
   const uint64_t recvTypeId;
+  const int recvTypeMaxSize;
   bool inUse;
 
   using Lock = std::lock_guard<std::mutex>;
 
-  /// This class needs to be thread-safe. All of the mutable member variables
-  /// are protected with this object-wide lock. This may be a performance issue
-  /// in the future.
+  /// Protects the inUse flag. The queues synchronize on their own.
   std::mutex m;
   /// Message queue from RPC client to the simulation.
-  std::queue<BlobPtr> toCosim;
+  MessageQueue toCosim;
   /// Message queue to RPC client from the simulation.
-  std::queue<BlobPtr> toClient;
+  MessageQueue toClient;
+
+  std::unique_ptr<ShmRegion> shmRegion;
+  std::atomic<ShmRegion *> shm{nullptr};
+  QueueStats shmToSimStats;
+  QueueStats shmToClientStats;
 };
 
 /// The Endpoint registry is where Endpoints report their existence (register)
@@ -133,6 +389,8 @@ public:
       const std::function<void(std::string id, const Endpoint &)> &f) const;
   /// Return the number of endpoints.
   size_t size() const;
+  /// Print the traffic statistics of all the endpoints.
+  void printStats(FILE *file) const;
 
 private:
   using Lock = std::lock_guard<std::mutex>;
@@ -17,8 +17,15 @@
 #define CIRCT_DIALECT_ESI_COSIM_SERVER_H
 
 #include "circt/Dialect/ESI/cosim/Endpoint.h"
+#include <chrono>
+#include <functional>
 #include <thread>
 
+namespace kj {
+template <typename T>
+class CrossThreadPromiseFulfiller;
+} // namespace kj
+
 namespace circt {
 namespace esi {
 namespace cosim {
@@ -38,6 +45,11 @@ public:
   void run(uint16_t port);
   void stop();
 
+  /// Have the server thread call `dump` every `interval`, to report the
+  /// statistics of the endpoints. Must be called before `run`.
+  void setStatsDump(std::chrono::milliseconds interval,
+                    std::function<void()> dump);
+
 private:
   using Lock = std::lock_guard<std::mutex>;
 
@@ -45,8 +57,17 @@ private:
   void mainLoop(uint16_t port);
 
   std::thread *mainThread;
-  volatile bool stopSig;
   std::mutex m;
+
+  std::chrono::milliseconds statsInterval;
+  std::function<void()> statsDump;
+
+  /// Wakes up the main loop to exit. Only set while the loop runs.
+  kj::CrossThreadPromiseFulfiller<void> *stopFulfiller;
+  /// Whether the server was stopped. Protected by stopMutex, along with
+  /// stopFulfiller.
+  bool stopSig;
+  std::mutex stopMutex;
 };
 
 } // namespace cosim
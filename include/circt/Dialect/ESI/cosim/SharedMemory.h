@@ -0,0 +1,168 @@
+//===- SharedMemory.h - Cosim shared memory transport -----------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Declare the shared memory transport, which lets a client on the same host
+// exchange the messages of an endpoint with the simulation without going
+// through RPC.
+//
+// A region is a POSIX shared memory object holding a header followed by two
+// rings, one per direction:
+//
+//   ShmRegionHeader
+//   ShmRingHeader, then numSlots slots    (to the simulation)
+//   ShmRingHeader, then numSlots slots    (to the client)
+//
+// Every slot is a little-endian 64-bit message size followed by `slotSize`
+// bytes of message data, which is a single capnp segment as with the RPC
+// interface. Each ring has a single producer and a single consumer, which
+// synchronize through the `head` and `tail` counters of the ring header. All
+// offsets are in bytes from the start of the region.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_DIALECT_ESI_COSIM_SHAREDMEMORY_H
+#define CIRCT_DIALECT_ESI_COSIM_SHAREDMEMORY_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace circt {
+namespace esi {
+namespace cosim {
+
+struct ShmRegionHeader {
+  static constexpr uint32_t magicNumber = 0x45534953; // "ESIS"
+  static constexpr uint32_t currentVersion = 1;
+
+  uint32_t magic;
+  uint32_t version;
+  uint64_t size;
+  uint64_t toSimOffset;
+  uint64_t toClientOffset;
+};
+
+struct ShmRingHeader {
+  /// The number of messages pushed to and popped from the ring, on separate
+  /// cache lines.
+  alignas(64) std::atomic<uint64_t> head;
+  alignas(64) std::atomic<uint64_t> tail;
+  alignas(64) uint64_t slotSize;
+  uint64_t numSlots;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared memory rings need address-free atomics");
+
+/// A view of a ring in a mapped region. The producer uses `reserve`, `commit`
+/// and `push`, the consumer `front` and `pop`.
+class ShmRing {
+public:
+  ShmRing() = default;
+  explicit ShmRing(ShmRingHeader *header)
+      : header(header), slotSize(header->slotSize),
+        numSlots(header->numSlots) {}
+
+  /// The bytes each slot takes in the region.
+  static uint64_t getSlotStride(uint64_t slotSize) {
+    return sizeof(uint64_t) + ((slotSize + 7) & ~uint64_t(7));
+  }
+  /// The bytes a ring takes in the region, including its header.
+  static uint64_t getRingSize(uint64_t slotSize, uint64_t numSlots) {
+    return sizeof(ShmRingHeader) + numSlots * getSlotStride(slotSize);
+  }
+
+  /// Return the space of the next message, or nullptr if the ring is full or
+  /// the message does not fit in a slot.
+  uint8_t *reserve(uint64_t size) {
+    if (size > slotSize)
+      return nullptr;
+    uint64_t h = header->head.load(std::memory_order_relaxed);
+    if (h - header->tail.load(std::memory_order_acquire) >= numSlots)
+      return nullptr;
+    return getSlot(h) + sizeof(uint64_t);
+  }
+  /// Publish the message of `size` bytes written to the reserved space.
+  void commit(uint64_t size) {
+    uint64_t h = header->head.load(std::memory_order_relaxed);
+    std::memcpy(getSlot(h), &size, sizeof(uint64_t));
+    header->head.store(h + 1, std::memory_order_release);
+  }
+  /// Copy a message into the ring. Return false if it is full, or if the
+  /// message does not fit in a slot.
+  bool push(const uint8_t *data, uint64_t size) {
+    uint8_t *slot = reserve(size);
+    if (!slot)
+      return false;
+    std::memcpy(slot, data, size);
+    commit(size);
+    return true;
+  }
+
+  /// Return the oldest message and set `size` to its size, or return nullptr
+  /// if the ring is empty. The message stays valid until `pop`.
+  const uint8_t *front(uint64_t &size) const {
+    uint64_t t = header->tail.load(std::memory_order_relaxed);
+    if (t == header->head.load(std::memory_order_acquire))
+      return nullptr;
+    const uint8_t *slot = getSlot(t);
+    std::memcpy(&size, slot, sizeof(uint64_t));
+    return slot + sizeof(uint64_t);
+  }
+  /// Release the oldest message.
+  void pop() { header->tail.fetch_add(1, std::memory_order_release); }
+
+private:
+  uint8_t *getSlot(uint64_t index) const {
+    return reinterpret_cast<uint8_t *>(header + 1) +
+           (index % numSlots) * getSlotStride(slotSize);
+  }
+
+  ShmRingHeader *header = nullptr;
+  uint64_t slotSize = 0;
+  uint64_t numSlots = 0;
+};
+
+/// A mapped shared memory region. The simulation creates it, and removes the
+/// shared memory object on destruction. Clients open it by name.
+class ShmRegion {
+public:
+  /// Create a region with rings of `numSlots` slots, of `toSimSlotSize` and
+  /// `toClientSlotSize` bytes. Return nullptr on failure.
+  static std::unique_ptr<ShmRegion> create(const std::string &name,
+                                           uint64_t toSimSlotSize,
+                                           uint64_t toClientSlotSize,
+                                           uint64_t numSlots = 256);
+  /// Map an existing region. Return nullptr on failure.
+  static std::unique_ptr<ShmRegion> open(const std::string &name);
+  ~ShmRegion();
+  ShmRegion(const ShmRegion &) = delete;
+
+  const std::string &getName() const { return name; }
+
+  /// The rings in both directions.
+  ShmRing toSim;
+  ShmRing toClient;
+
+private:
+  ShmRegion(std::string name, void *base, uint64_t size, bool owner);
+
+  std::string name;
+  void *base;
+  uint64_t size;
+  /// Whether this is the simulation's mapping, which owns the object.
+  bool owner;
+};
+
+} // namespace cosim
+} // namespace esi
+} // namespace circt
+
+#endif
@@ -35,6 +35,12 @@ extern int sv2cCosimserverEpTryGet(char *endpointId,
                                    // NOLINTNEXTLINE(misc-misplaced-const)
                                    const svOpenArrayHandle data,
                                    unsigned int *sizeBytes);
+/// Try to get several messages from a client, into consecutive slots.
+extern int sv2cCosimserverEpTryGetMany(char *endpointId,
+                                       // NOLINTNEXTLINE(misc-misplaced-const)
+                                       const svOpenArrayHandle data,
+                                       unsigned int msgSize,
+                                       unsigned int *numMsgs);
 /// Send a message to a client.
 extern int sv2cCosimserverEpTryPut(char *endpointId,
                                    // NOLINTNEXTLINE(misc-misplaced-const)
@@ -36,6 +36,10 @@ struct FIRParserOptions {
   /// This, along with numOMIRFiles provides structure to the buffers in the
   /// source manager.
   unsigned numAnnotationFiles;
+  /// If this is set to true, only the ports and instances of the modules are
+  /// parsed and all other statements in the module bodies are skipped.  This
+  /// is enough to build the instance graph of the circuit.
+  bool hierarchyOnly = false;
 };
 
 mlir::OwningOpRef<mlir::ModuleOp> importFIRFile(llvm::SourceMgr &sourceMgr,
@@ -17,6 +17,7 @@
 #include "circt/Dialect/FIRRTL/FIRRTLInstanceGraph.h"
 #include "circt/Dialect/FIRRTL/FIRRTLOps.h"
 #include "circt/Dialect/FIRRTL/Namespace.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/TypeSwitch.h"
 
 namespace circt {
@@ -135,12 +136,37 @@ struct CircuitTargetCache {
     return getOrCreateCacheFor(module).getTargetForName(name);
   }
 
+  /// Build the caches of all modules in `circuit` which don't have one yet, in
+  /// parallel.  Until the next change to the cache, lookups in these modules
+  /// only read from it and can happen concurrently.
+  void populate(CircuitOp circuit);
+
+  /// Resolve the distinct target paths in `paths` which aren't in the path
+  /// index yet, in parallel, and add the ones that resolve to it.
+  void resolvePaths(CircuitOp circuit, SymbolTable &symTbl,
+                    ArrayRef<StringRef> paths);
+
+  /// Look up a previously resolved target path, null if it isn't known.
+  const AnnoPathValue *lookupPath(StringRef path) const {
+    auto it = resolvedPaths.find(path);
+    return it == resolvedPaths.end() ? nullptr : &it->second;
+  }
+
+  /// Record the resolved target of a path.
+  void insertPath(StringRef path, const AnnoPathValue &value) {
+    resolvedPaths.try_emplace(path, value);
+  }
+
   /// Clear the cache completely.
-  void invalidate() { targetCaches.clear(); }
+  void invalidate() {
+    targetCaches.clear();
+    resolvedPaths.clear();
+  }
 
   /// Replace `oldOp` with `newOp` in the target cache. The new and old ops can
   /// have different names.
   void replaceOp(Operation *oldOp, Operation *newOp) {
+    resolvedPaths.clear();
     auto mod = newOp->getParentOfType<FModuleOp>();
     auto it = targetCaches.find(mod);
     if (it == targetCaches.end())
@@ -150,6 +176,7 @@ struct CircuitTargetCache {
 
   /// Add a new module port to the target cache.
   void insertPort(FModuleLike mod, size_t portNo) {
+    resolvedPaths.clear();
     auto it = targetCaches.find(mod);
     if (it == targetCaches.end())
       return;
@@ -167,6 +194,9 @@ struct CircuitTargetCache {
 
 private:
   DenseMap<Operation *, AnnoTargetCache> targetCaches;
+  /// Index of the target paths resolved so far.  Changes to the targets of the
+  /// circuit which may move existing targets clear it.
+  llvm::StringMap<AnnoPathValue> resolvedPaths;
 };
 
 /// Return an input \p target string in canonical form.  This converts a Legacy
@@ -183,7 +213,8 @@ Optional<AnnoPathValue> resolveEntities(TokenAnnoTarget path, CircuitOp circuit,
                                         SymbolTable &symTbl,
                                         CircuitTargetCache &cache);
 
-/// Resolve a string path to a named item inside a circuit.
+/// Resolve a string path to a named item inside a circuit.  The result is
+/// looked up in and recorded in the path index of `cache`.
 Optional<AnnoPathValue> resolvePath(StringRef rawPath, CircuitOp circuit,
                                     SymbolTable &symTbl,
                                     CircuitTargetCache &cache);
@@ -248,6 +279,11 @@ struct ApplyState {
   size_t numReusedHierPaths = 0;
   SmallVector<WiringProblem> wiringProblems;
 
+  /// Annotations which have been resolved and are waiting to be attached to
+  /// their targets.  These are attached in batches, in parallel across
+  /// modules.
+  SmallVector<std::pair<AnnoTarget, DictionaryAttr>> pendingAnnotations;
+
   ModuleNamespace &getNamespace(FModuleLike module) {
     auto &ptr = namespaces[module];
     if (!ptr)
@@ -229,6 +229,12 @@ public:
     return !annotations.empty() && hasAnnotationImpl(className);
   }
 
+  /// Return true if the operation has an annotation with the specified class
+  /// name. Unlike `AnnotationSet(op).hasAnnotation(className)`, this does not
+  /// materialize an empty annotation array for unannotated operations.
+  static bool hasAnnotation(Operation *op, StringRef className);
+  static bool hasAnnotation(Operation *op, StringAttr className);
+
   /// If this annotation set has an annotation with the specified class name,
   /// return it.  Otherwise return a null DictionaryAttr.
   Annotation getAnnotation(StringRef className) const {
@@ -144,6 +144,14 @@ std::pair<bool, Optional<mlir::LocationAttr>> maybeStringToLocation(
     StringRef spelling, bool skipParsing, StringAttr &locatorFilenameCache,
     FileLineColLoc &fileLineColLocCache, MLIRContext *context);
 
+/// Fuse `locs` into a single location. Fused locations without metadata are
+/// flattened, duplicate and unknown locations are dropped, and at most
+/// `maxLocs` distinct locations are kept. This bounds the size of locations
+/// which passes fuse over and over, such as the one of a constant that is
+/// shared by many operations.
+Location fuseLocs(MLIRContext *context, ArrayRef<Location> locs,
+                  unsigned maxLocs = 8);
+
 //===----------------------------------------------------------------------===//
 // Parallel utilities
 //===----------------------------------------------------------------------===//
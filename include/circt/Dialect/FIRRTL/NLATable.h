@@ -21,7 +21,10 @@
 namespace circt {
 namespace firrtl {
 
-/// This table tracks nlas and what modules participate in them.
+/// This table tracks nlas and what modules participate in them.  The NLAs are
+/// indexed by every module and every inner reference of their namepath, so
+/// that the NLAs through a module or an instance, or targeting a component,
+/// can be found without scanning.
 ///
 /// To use this class, retrieve a cached copy from the analysis manager:
 ///   auto &nlaTable = getAnalysis<NLATable>(getOperation());
@@ -44,6 +47,12 @@ public:
   /// NLATable.
   ArrayRef<HierPathOp> lookup(StringAttr name);
 
+  /// Lookup all NLAs whose namepath contains the inner reference `ref`, either
+  /// as an instance they pass through or as their leaf. This returns a
+  /// reference to the internal record, so make a copy before making any update
+  /// to the NLATable.
+  ArrayRef<HierPathOp> lookup(hw::InnerRefAttr ref);
+
   /// Resolve a symbol to an NLA.
   HierPathOp getNLA(StringAttr name);
 
@@ -73,19 +82,13 @@ public:
     // in any NLA.
     if (!instSym)
       return;
-    auto mod = inst->getParentOfType<FModuleOp>().getNameAttr();
-    // Get the NLAs that are common between the parent module and the target
-    // module. This should contain the NLAs that this InstanceOp participates
-    // in.
-    commonNLAs(inst->getParentOfType<FModuleOp>().getNameAttr(),
-               inst.getModuleNameAttr().getAttr(), nlas);
-    // Handle the case when there are more than one Instances for the same
-    // target module. Getting the `commonNLA`, in that case is not enough,
-    // remove the NLAs that donot have the InstanceOp as the innerSym.
-    for (auto nla : llvm::make_early_inc_range(nlas)) {
-      if (!nla.hasInnerSym(mod, instSym))
-        nlas.erase(nla);
-    }
+    auto ref = hw::InnerRefAttr::get(
+        inst->getParentOfType<FModuleOp>().getNameAttr(), instSym);
+    // The NLAs which end at the InstanceOp target the instance itself, and do
+    // not pass through it into the target module.
+    for (auto nla : lookup(ref))
+      if (nla.getNamepath().getValue().back() != ref)
+        nlas.insert(nla);
   }
 
   /// Get the NLAs that the module `modName` particiaptes in, and insert them
@@ -119,6 +122,17 @@ public:
   /// 'lookup'.
   void erase(HierPathOp nlaOp, SymbolTable *symbolTable = nullptr);
 
+  /// Remove a batch of NLAs from the analysis. This scans the list of NLAs of
+  /// each module and inner reference in their namepaths only once, instead of
+  /// once per erased NLA.
+  void eraseNLAs(ArrayRef<HierPathOp> nlaOps,
+                 SymbolTable *symbolTable = nullptr);
+
+  /// Replace the namepath of the NLA. This only updates the records of the
+  /// modules and inner references which are added to or removed from the
+  /// namepath, so the NLA keeps its position in the lists of the others.
+  void setNamepath(HierPathOp nla, ArrayAttr namepath);
+
   /// Record a new FModuleLike operation. This updates the Module name to Module
   /// operation map.
   void addModule(FModuleLike mod) { symToOp[mod.moduleNameAttr()] = mod; }
@@ -147,6 +161,13 @@ public:
   void updateModuleInNLA(HierPathOp nlaOp, StringAttr oldModule,
                          StringAttr newModule);
 
+  /// Replace the module `oldModule` with `newModule` in the namepaths of all
+  /// the nlas `nlaOps`. This is the same as calling `updateModuleInNLA` for
+  /// each of them, but only scans the list of NLAs of `oldModule` once. This
+  /// can delete and invalidate any reference returned by `lookup`.
+  void updateModuleInNLAs(ArrayRef<HierPathOp> nlaOps, StringAttr oldModule,
+                          StringAttr newModule);
+
   /// Rename a module, this updates the name to module tracking and the name to
   /// NLA tracking. This moves all the NLAs that `oldModName` is participating
   /// in to the `newModName`. The `oldModName` must exist in the name to module
@@ -184,9 +205,19 @@ public:
 private:
   NLATable(const NLATable &) = delete;
 
+  /// Move the records of the inner references of `oldModName` in the namepaths
+  /// of `nlas` to the new inner references computed by `getNewRef`. This must
+  /// be called before the namepaths are updated.
+  void
+  moveInnerRefs(ArrayRef<HierPathOp> nlas, StringAttr oldModName,
+                function_ref<hw::InnerRefAttr(hw::InnerRefAttr)> getNewRef);
+
   /// Map modules to the NLA's that target them.
   llvm::DenseMap<StringAttr, SmallVector<HierPathOp, 4>> nodeMap;
 
+  /// Map inner references to the NLA's whose namepath contains them.
+  llvm::DenseMap<hw::InnerRefAttr, SmallVector<HierPathOp, 1>> innerRefMap;
+
   /// Map symbol names to module and NLA operations.
   llvm::DenseMap<StringAttr, Operation *> symToOp;
 };
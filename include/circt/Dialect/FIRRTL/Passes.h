@@ -38,7 +38,9 @@ enum PreserveMode {
   /// Preserve only 1d vectors of ground type (e.g. UInt<2>[3]).
   OneDimVec,
 
-  /// Preserve only vectors (e.g. UInt<2>[3][3]).
+  /// Preserve only vectors (e.g. UInt<2>[3][3]). Bundles are scalarized, and
+  /// vectors of ground type nested in them are kept, such that they are lowered
+  /// to arrays by LowerToHW instead of one value per element.
   Vec,
 
   /// Preserve all aggregate values.
@@ -77,7 +79,9 @@ std::unique_ptr<mlir::Pass> createDedupPass();
 std::unique_ptr<mlir::Pass>
 createEmitOMIRPass(mlir::StringRef outputFilename = "");
 
-std::unique_ptr<mlir::Pass> createExpandWhensPass();
+std::unique_ptr<mlir::Pass>
+createExpandWhensPass(bool mergeConnections = false,
+                      bool aggressiveMerging = false);
 
 std::unique_ptr<mlir::Pass> createFlattenMemoryPass();
 
@@ -133,7 +137,7 @@ enum PreserveMode {
 std::unique_ptr<mlir::Pass>
 createDropNamesPass(PreserveValues::PreserveMode mode = PreserveValues::None);
 
-std::unique_ptr<mlir::Pass> createExtractInstancesPass();
+std::unique_ptr<mlir::Pass> createExtractInstancesPass(bool batched = false);
 
 std::unique_ptr<mlir::Pass> createIMDeadCodeElimPass();
 
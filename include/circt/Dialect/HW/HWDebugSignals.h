@@ -0,0 +1,45 @@
+//===- HWDebugSignals.h - Frontend-visible signals --------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines an analysis of the signals of each HW module which are
+// visible in the frontend, i.e. the ports and declarations annotated with
+// `hw.debug.name`. These are the signals of the hgdb variable table, and the
+// ones worth tracing when debugging a simulation.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_DIALECT_HW_HWDEBUGSIGNALS_H
+#define CIRCT_DIALECT_HW_HWDEBUGSIGNALS_H
+
+#include "circt/Dialect/HW/HWOps.h"
+#include "circt/Support/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+
+namespace circt {
+namespace hw {
+
+/// Return true if `op` declares a signal that is visible in the frontend.
+bool isDebugSignal(Operation *op);
+
+/// The frontend-visible signals of every HW module below an operation.
+class DebugSignals {
+public:
+  explicit DebugSignals(Operation *operation);
+
+  /// Return the names of the frontend-visible ports and declarations of
+  /// `module`, in port and then program order.
+  ArrayRef<StringAttr> getSignals(HWModuleOp module) const;
+
+private:
+  DenseMap<Operation *, SmallVector<StringAttr>> signals;
+};
+
+} // namespace hw
+} // namespace circt
+
+#endif // CIRCT_DIALECT_HW_HWDEBUGSIGNALS_H
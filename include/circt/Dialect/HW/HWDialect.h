@@ -16,6 +16,58 @@
 #include "circt/Support/LLVM.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/Dialect.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/RWMutex.h"
+
+#include <memory>
+
+namespace circt {
+namespace hw {
+namespace detail {
+/// Per-context memoization of parameter expressions. Building a parameter
+/// expression canonicalizes it, and evaluating one against a set of parameters
+/// rebuilds it bottom-up, so deeply parameterized designs keep recomputing the
+/// same subexpressions. This remembers both, keyed by their uniqued inputs.
+struct ParamExprCache {
+  using ExprKey = std::pair<unsigned, ArrayRef<Attribute>>;
+  using EvalKey = std::pair<ArrayAttr, Attribute>;
+
+  /// Return the canonical form of the expression `opcode(operands)`, or null
+  /// if it has not been built before.
+  Attribute lookupCanonical(unsigned opcode, ArrayRef<Attribute> operands) {
+    llvm::sys::SmartScopedReader<true> lock(mutex);
+    return canonical.lookup({opcode, operands});
+  }
+  void addCanonical(unsigned opcode, ArrayRef<Attribute> operands,
+                    Attribute result) {
+    llvm::sys::SmartScopedWriter<true> lock(mutex);
+    if (canonical.count({opcode, operands}))
+      return;
+    auto *storage = allocator.Allocate<Attribute>(operands.size());
+    std::uninitialized_copy(operands.begin(), operands.end(), storage);
+    canonical.insert({{opcode, {storage, operands.size()}}, result});
+  }
+
+  /// Return the result of evaluating `expr` against `parameters`, or null if
+  /// it has not been evaluated before.
+  Attribute lookupEvaluated(ArrayAttr parameters, Attribute expr) {
+    llvm::sys::SmartScopedReader<true> lock(mutex);
+    return evaluated.lookup({parameters, expr});
+  }
+  void addEvaluated(ArrayAttr parameters, Attribute expr, Attribute result) {
+    llvm::sys::SmartScopedWriter<true> lock(mutex);
+    evaluated.insert({{parameters, expr}, result});
+  }
+
+private:
+  llvm::sys::SmartRWMutex<true> mutex;
+  llvm::BumpPtrAllocator allocator;
+  DenseMap<ExprKey, Attribute> canonical;
+  DenseMap<EvalKey, Attribute> evaluated;
+};
+} // namespace detail
+} // namespace hw
+} // namespace circt
 
 // Pull in the dialect definition.
 #include "circt/Dialect/HW/HWDialect.h.inc"
@@ -29,7 +29,8 @@ public:
     return TypeSwitch<Operation *, ResultType>(op)
         .template Case<ConstantOp,
                        // Array operations
-                       ArraySliceOp, ArrayCreateOp, ArrayConcatOp, ArrayGetOp,
+                       ArraySliceOp, ArrayCreateOp, ArrayConstantOp,
+                       ArrayConcatOp, ArrayGetOp,
                        // Struct operations
                        StructCreateOp, StructExtractOp, StructInjectOp,
                        // Cast operation
@@ -70,6 +71,7 @@ public:
   HANDLE(ArraySliceOp, Unhandled);
   HANDLE(ArrayGetOp, Unhandled);
   HANDLE(ArrayCreateOp, Unhandled);
+  HANDLE(ArrayConstantOp, Unhandled);
   HANDLE(ArrayConcatOp, Unhandled);
   HANDLE(EnumConstantOp, Unhandled);
 #undef HANDLE
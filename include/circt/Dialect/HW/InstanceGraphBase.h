@@ -175,6 +175,11 @@ private:
 ///
 /// To use this class, retrieve a cached copy from the analysis manager:
 ///   auto &instanceGraph = getAnalysis<InstanceGraph>(getOperation());
+///
+/// The query methods may be called concurrently, e.g. from a parallel walk over
+/// the modules, as long as the graph isn't modified at the same time.  The
+/// methods computing cached results, such as `getPostOrder`, must have been
+/// called once before to populate their cache.
 class InstanceGraphBase {
   /// This is the list of InstanceGraphNodes in the graph.
   using NodeList = llvm::iplist<InstanceGraphNode>;
@@ -209,6 +214,18 @@ public:
   /// Return the parent under which all nodes are nested.
   Operation *getParent() { return parent; }
 
+  /// Get the nodes reachable from the top-level node in post-order, such that
+  /// every module comes after the modules it instantiates.  This is the order
+  /// of `llvm::post_order(&instanceGraph)`, computed once and cached until the
+  /// graph is modified.
+  ArrayRef<InstanceGraphNode *> getPostOrder();
+
+  /// Get all the nodes of the graph in inverse topological order, such that
+  /// every module comes after the modules it instantiates.  Unlike
+  /// `getPostOrder`, this includes the modules which are not reachable from the
+  /// top-level node.  This is cached like `getPostOrder`.
+  ArrayRef<InstanceGraphNode *> getInverseTopologicalOrder();
+
   /// Returns pointer to member of operation list.
   static NodeList InstanceGraphBase::*
   getSublistAccessgetSublistAccess(Operation *) {
@@ -240,6 +257,32 @@ public:
   /// of both InstanceOps must be the same.
   virtual void replaceInstance(HWInstanceLike inst, HWInstanceLike newInst);
 
+  /// Record a newly created instance.  The module containing the instance and
+  /// the module it instantiates must already be in the graph.
+  InstanceRecord *addInstance(HWInstanceLike instance);
+
+  /// Record a batch of newly created instances.  Passes which create instances
+  /// from a parallel walk over the modules can collect them and add them
+  /// afterwards instead of rebuilding the graph.
+  void addInstances(ArrayRef<HWInstanceLike> instances);
+
+  /// Remove an instance from the graph.  This must be called before the
+  /// instance is erased from the IR.
+  void eraseInstance(HWInstanceLike instance);
+
+  /// Remove a batch of instances from the graph, scanning the instance list of
+  /// each containing module only once.  This must be called before the
+  /// instances are erased from the IR.
+  void eraseInstances(ArrayRef<HWInstanceLike> instances);
+
+  /// Drop the cached traversals.  The methods above do this automatically, but
+  /// this must be called after changing the graph directly through
+  /// InstanceGraphNode or InstanceRecord.
+  void invalidateTraversals() {
+    postOrder.clear();
+    inverseTopologicalOrder.clear();
+  }
+
 protected:
   /// Create a new module graph of a circuit.  Must be called on the parent
   /// operation of HWModuleLike ops.
@@ -261,6 +304,10 @@ protected:
 
   /// A caching of the inferred top level module(s).
   llvm::SmallVector<InstanceGraphNode *> inferredTopLevelNodes;
+
+  /// Cached traversals of the graph.
+  SmallVector<InstanceGraphNode *, 0> postOrder;
+  SmallVector<InstanceGraphNode *, 0> inverseTopologicalOrder;
 };
 
 /// An absolute instance path.
@@ -289,6 +336,18 @@ struct InstancePathCache {
       : instanceGraph(instanceGraph) {}
   ArrayRef<InstancePath> getAbsolutePaths(HWModuleLike op);
 
+  /// Return the number of absolute paths to a module.  Only the counts are
+  /// cached, so this doesn't materialize the paths, whose number can grow
+  /// exponentially with the depth of the hierarchy.
+  size_t getNumAbsolutePaths(HWModuleLike op);
+
+  /// Call `callback` with each absolute path to a module, in the order of
+  /// `getAbsolutePaths`.  The paths are built in a single buffer reused for
+  /// all of them and are not cached, so they are only valid for the duration
+  /// of the callback.  Paths already cached for a parent module are reused.
+  void walkAbsolutePaths(HWModuleLike op,
+                         llvm::function_ref<void(InstancePath)> callback);
+
   /// Replace an InstanceOp. This is required to keep the cache updated.
   void replaceInstance(HWInstanceLike oldOp, HWInstanceLike newOp);
 
@@ -299,6 +358,9 @@ private:
   /// Cached absolute instance paths.
   DenseMap<Operation *, ArrayRef<InstancePath>> absolutePathsCache;
 
+  /// Cached number of absolute instance paths.
+  DenseMap<Operation *, size_t> numAbsolutePathsCache;
+
   /// Append an instance to a path.
   InstancePath appendInstance(InstancePath path, HWInstanceLike inst);
 };
@@ -0,0 +1,82 @@
+//===- HandshakeGraph.h - Handshake dataflow graph analysis -----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This header file defines an analysis indexing the dataflow graph of a
+// handshake function, which can be shared by the handshake transform passes.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_DIALECT_HANDSHAKE_HANDSHAKEGRAPH_H
+#define CIRCT_DIALECT_HANDSHAKE_HANDSHAKEGRAPH_H
+
+#include "circt/Support/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace circt {
+namespace handshake {
+
+/// The dataflow graph of a handshake function and its strongly connected
+/// components. Nodes are the ops of the function body, and every channel adds
+/// an edge from the op producing it to the op consuming it.
+///
+/// Passes which only insert ops on existing channels, such as buffers, forks
+/// and sinks, can keep the analysis up to date through `insertNode` and mark
+/// it preserved. Any other change to the graph invalidates it.
+class HandshakeGraph {
+public:
+  /// Build the graph of a handshake.func.
+  explicit HandshakeGraph(Operation *funcOp);
+
+  unsigned getNumNodes() const { return ops.size(); }
+  Operation *getOp(unsigned node) const { return ops[node]; }
+
+  /// Return the node of `op`, or None if `op` is not in the graph.
+  Optional<unsigned> lookupNode(Operation *op) const;
+
+  /// The nodes consuming the results of a node, and the nodes producing the
+  /// operands of a node, one entry per channel.
+  ArrayRef<unsigned> getSuccessors(unsigned node) const {
+    return successors[node];
+  }
+  ArrayRef<unsigned> getPredecessors(unsigned node) const {
+    return predecessors[node];
+  }
+
+  /// Return the strongly connected component of a node.
+  unsigned getSCC(unsigned node) const { return sccs[node]; }
+  unsigned getNumSCCs() const { return sccIsCyclic.size(); }
+
+  /// Return true if `op` lies on a cycle of the graph.
+  bool isInCycle(Operation *op) const;
+
+  /// Add `op`, which was just inserted on existing channels: the producers of
+  /// its operands fed all the users of its results before. The op lies on a
+  /// cycle if one of these channels did.
+  void insertNode(Operation *op);
+
+private:
+  /// Recompute the edges of `node` from its operands and the uses of its
+  /// results.
+  void updateEdges(unsigned node);
+  void computeSCCs();
+
+  SmallVector<Operation *> ops;
+  DenseMap<Operation *, unsigned> nodes;
+  SmallVector<SmallVector<unsigned, 2>> successors;
+  SmallVector<SmallVector<unsigned, 2>> predecessors;
+  SmallVector<unsigned> sccs;
+  /// Whether each SCC contains a cycle, which is the case for all SCCs of more
+  /// than one node and for single nodes consuming their own results.
+  SmallVector<bool> sccIsCyclic;
+};
+
+} // namespace handshake
+} // namespace circt
+
+#endif // CIRCT_DIALECT_HANDSHAKE_HANDSHAKEGRAPH_H
@@ -14,6 +14,7 @@
 #define CIRCT_HANDSHAKEOPS_OPS_H_
 
 #include "circt/Dialect/Handshake/HandshakeDialect.h"
+#include "circt/Dialect/Handshake/SimulationMemory.h"
 #include "circt/Support/LLVM.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
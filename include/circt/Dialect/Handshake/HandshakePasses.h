@@ -22,6 +22,7 @@
 namespace circt {
 namespace handshake {
 class FuncOp;
+class HandshakeGraph;
 
 std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>>
 createHandshakeDotPrintPass();
@@ -36,7 +37,8 @@ createHandshakeLowerExtmemToHWPass(std::optional<bool> createESIWrapper = {});
 std::unique_ptr<mlir::Pass> createHandshakeLegalizeMemrefsPass();
 std::unique_ptr<mlir::OperationPass<handshake::FuncOp>>
 createHandshakeInsertBuffersPass(const std::string &strategy = "all",
-                                 unsigned bufferSize = 2);
+                                 unsigned bufferSize = 2,
+                                 unsigned initiationInterval = 1);
 std::unique_ptr<mlir::Pass> createHandshakeLockFunctionsPass();
 
 /// Iterates over the handshake::FuncOp's in the program to build an instance
@@ -63,9 +65,13 @@ void insertFork(Value result, bool isLazy, OpBuilder &rewriter);
 // Adds a locking mechanism around the region.
 LogicalResult lockRegion(Region &r, OpBuilder &rewriter);
 
-// Applies the spcified buffering strategy on the region r.
+// Applies the spcified buffering strategy on the region r. The throughput
+// strategy sizes buffers for the given target initiation interval. If a graph
+// of the region is given, it is used and kept up to date.
 LogicalResult bufferRegion(Region &r, OpBuilder &rewriter, StringRef strategy,
-                           unsigned bufferSize);
+                           unsigned bufferSize,
+                           unsigned initiationInterval = 1,
+                           HandshakeGraph *graph = nullptr);
 
 /// Generate the code for registering passes.
 #define GEN_PASS_REGISTRATION
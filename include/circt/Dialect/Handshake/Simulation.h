@@ -16,14 +16,32 @@
 
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/MLIRContext.h"
+#include "llvm/Support/raw_ostream.h"
 #include <string>
 
 namespace circt {
 namespace handshake {
+struct SimulationOptions {
+  /// Lower standard functions once to a flat instruction array over typed
+  /// registers before they are executed.
+  bool precompile = false;
+  /// Compile standard functions to native code with the MLIR execution engine
+  /// instead. Takes precedence over `precompile`.
+  bool jit = false;
+  /// Print a report of op firings, channel stalls, buffer occupancy and the
+  /// critical path of handshake functions to stderr.
+  bool profile = false;
+};
+
+/// Execute `toplevelFunction` on the given arguments and print its results to
+/// `out`. Every call uses its own memory, so calls on the same module may run
+/// concurrently.
 bool simulate(llvm::StringRef toplevelFunction,
               llvm::ArrayRef<std::string> inputArgs,
               mlir::OwningOpRef<mlir::ModuleOp> &module,
-              mlir::MLIRContext &context);
+              mlir::MLIRContext &context,
+              const SimulationOptions &options = {},
+              llvm::raw_ostream &out = llvm::outs());
 } // namespace handshake
 } // namespace circt
 
@@ -0,0 +1,81 @@
+//===- SimulationMemory.h - Handshake simulation memory model ---*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the memory model used when simulating the standard and
+// handshake dialects.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_DIALECT_HANDSHAKE_SIMULATIONMEMORY_H
+#define CIRCT_DIALECT_HANDSHAKE_SIMULATIONMEMORY_H
+
+#include "mlir/IR/Types.h"
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/Any.h"
+#include <vector>
+
+namespace circt {
+namespace handshake {
+
+/// A memory allocation of the simulator. The elements are kept in a single
+/// contiguous byte array, in the little-endian bit layout of their element
+/// type, rather than as individually boxed values. Integers of up to 64 bits
+/// take the smallest power-of-two number of bytes that fits them, and wider
+/// elements take a whole number of 64-bit words.
+class MemoryBank {
+public:
+  /// Create a bank of `size` zero elements of `elementType`, which must be an
+  /// integer or float type.
+  MemoryBank(mlir::Type elementType, size_t size);
+
+  /// Return the number of elements of the bank.
+  size_t size() const { return numElements; }
+
+  /// Return the number of bytes each element takes.
+  unsigned getElementBytes() const { return elementBytes; }
+
+  /// Return whether the elements are floats.
+  bool isFloat() const { return semantics != nullptr; }
+
+  llvm::APInt loadInt(size_t index) const;
+  llvm::APFloat loadFloat(size_t index) const;
+  void storeInt(size_t index, const llvm::APInt &value);
+  /// Floats of other semantics are converted to the element type.
+  void storeFloat(size_t index, const llvm::APFloat &value);
+
+  /// Load and store elements boxed as the APInt or APFloat values of the
+  /// interpreting executers.
+  llvm::Any load(size_t index) const;
+  void store(size_t index, const llvm::Any &value);
+
+  /// Fill the bank with raw element data in the layout of the bank, such as a
+  /// little-endian array of int32_t or float for a memref of i32 or f32.
+  /// Return false if `data` does not hold exactly one value per element.
+  bool loadBinary(llvm::StringRef data);
+
+  /// Return the raw element data, such that compiled code can access the bank
+  /// directly.
+  uint8_t *getData() { return data.data(); }
+
+private:
+  unsigned width;
+  unsigned elementBytes;
+  /// The float semantics of the elements, or null for integers.
+  const llvm::fltSemantics *semantics = nullptr;
+  size_t numElements;
+  std::vector<uint8_t> data;
+};
+
+/// The memories of a simulation, indexed by their pseudo-pointers.
+using MemoryStore = std::vector<MemoryBank>;
+
+} // namespace handshake
+} // namespace circt
+
+#endif // CIRCT_DIALECT_HANDSHAKE_SIMULATIONMEMORY_H
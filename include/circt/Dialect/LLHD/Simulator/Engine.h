@@ -26,6 +26,9 @@ class ExecutionEngine;
 namespace llvm {
 class Error;
 class Module;
+namespace orc {
+class LLJIT;
+} // namespace orc
 } // namespace llvm
 
 namespace circt {
@@ -35,19 +38,36 @@ namespace sim {
 class Engine {
 public:
   /// Initialize an LLHD simulation engine. This initializes the state, as well
-  /// as the mlir::ExecutionEngine with the given module.
+  /// as the mlir::ExecutionEngine with the given module. If `objectFile` is
+  /// not empty, the units are instead loaded from that object, as written by
+  /// `dumpObject` for the same design, and the module is only used to build
+  /// the instance layout.
   Engine(
       llvm::raw_ostream &out, ModuleOp module,
       llvm::function_ref<mlir::LogicalResult(mlir::ModuleOp)> mlirTransformer,
       llvm::function_ref<llvm::Error(llvm::Module *)> llvmTransformer,
-      std::string root, TraceMode tm, ArrayRef<StringRef> sharedLibPaths);
+      std::string root, TraceMode tm, ArrayRef<StringRef> sharedLibPaths,
+      StringRef objectFile = {}, bool enableObjectDump = false);
 
   /// Default destructor
   ~Engine();
 
   /// Run simulation up to n steps or maxTime picoseconds of simulation time.
-  /// n=0 and T=0 make the simulation run indefinitely.
-  int simulate(int n, uint64_t maxTime);
+  /// n=0 and T=0 make the simulation run indefinitely. The instances woken up
+  /// in the same delta cycle are evaluated on `numThreads` threads. If
+  /// `checkpoint` is not empty, the simulation resumes from the state saved to
+  /// that file instead of starting at time zero.
+  int simulate(int n, uint64_t maxTime, unsigned numThreads = 1,
+               StringRef checkpoint = {});
+
+  /// Save the simulation state to the file at `path`, such that a simulation
+  /// of the same design can resume from it.
+  int saveState(StringRef path);
+
+  /// Write the compiled units to an object file, which later simulations of
+  /// the same design can load instead of compiling the module. The engine has
+  /// to be created with `enableObjectDump`.
+  int dumpObject(StringRef path);
 
   /// Build the instance layout of the design.
   void buildLayout(ModuleOp module);
@@ -58,6 +78,14 @@ public:
   /// Get the simulation state.
   const State *getState() const { return state.get(); }
 
+  /// Count the evaluations and scheduled events of all instances, and the time
+  /// spent evaluating them, during the simulation.
+  void enableProfiling();
+
+  /// Print the counters gathered while profiling, with the instances sorted by
+  /// the time spent evaluating them.
+  void printProfile(llvm::raw_ostream &os) const;
+
   /// Dump the instance layout stored in the State.
   void dumpStateLayout();
 
@@ -67,12 +95,33 @@ public:
 private:
   void walkEntity(EntityOp entity, Instance &child);
 
+  /// Load the compiled units from an object file.
+  llvm::Error loadObject(StringRef objectFile,
+                         ArrayRef<StringRef> sharedLibPaths);
+
+  /// Look up the packed wrapper of a compiled function.
+  llvm::Expected<void (*)(void **)> lookupPacked(StringRef name);
+
   llvm::raw_ostream &out;
   std::string root;
   std::unique_ptr<State> state;
   std::unique_ptr<mlir::ExecutionEngine> engine;
+  // The JIT linking the units loaded from an object file.
+  std::unique_ptr<llvm::orc::LLJIT> objectJit;
   ModuleOp module;
   TraceMode traceMode;
+
+  /// The counters of a profiled simulation which are not specific to one
+  /// instance.
+  struct SimulationProfile {
+    uint64_t realSteps = 0;
+    uint64_t deltaSteps = 0;
+    uint64_t changes = 0;
+    uint64_t updates = 0;
+    uint64_t wakeups = 0;
+  };
+  bool profiling = false;
+  SimulationProfile simProfile;
 };
 
 } // namespace sim
@@ -15,12 +15,17 @@
 #define CIRCT_DIALECT_LLHD_SIMULATOR_STATE_H
 
 #include "llvm/ADT/APInt.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Error.h"
 
+#include <chrono>
 #include <map>
 #include <queue>
 #include <regex>
+#include <thread>
 
 namespace circt {
 namespace llhd {
@@ -56,6 +61,8 @@ public:
   std::string toString() const;
 
   uint64_t getTime() const { return time; }
+  uint64_t getDelta() const { return delta; }
+  uint64_t getEps() const { return eps; }
 
 private:
   /// Simulation real time.
@@ -72,7 +79,9 @@ struct SignalDetail {
   uint64_t globalIndex;
 };
 
-/// The simulator's internal representation of a signal.
+/// The simulator's internal representation of a signal. This holds the
+/// information only needed to set up the simulation and to trace it; the
+/// state updated by every delta cycle lives in the `SignalTable`.
 class Signal {
 public:
   /// Construct an "empty" signal.
@@ -86,10 +95,6 @@ public:
   /// Default move constructor.
   Signal(Signal &&) = default;
 
-  /// Free 'value' since it is allocated using 'malloc' in the LLVM code
-  /// generated by LLHDToLLVM.
-  ~Signal();
-
   /// Returns true if the signals match in name, owner, size and value.
   bool operator==(const Signal &rhs) const {
     if (owner != rhs.owner || name != rhs.name || size != rhs.size)
@@ -128,6 +133,11 @@ public:
 
   size_t getElementSize() const { return elements.size(); }
 
+  /// Return the byte offset and the size of the i-th element of the signal.
+  std::pair<unsigned, unsigned> getElement(unsigned i) const {
+    return elements[i];
+  }
+
   void pushElement(std::pair<unsigned, unsigned> val) {
     elements.push_back(val);
   }
@@ -138,52 +148,6 @@ public:
     size = s;
   }
 
-  /// Update signal value when it is changed, the width of incoming signal
-  /// value and the stored signal value are identical.
-  /// As majority signals are smaller than 64 bits, this implementation
-  /// is much faster as it avoided memcpy in most cases.
-  /// @param v Pointer to signal value
-  /// @return true when signal is updated, false when not
-  bool updateWhenChanged(const uint64_t *v) {
-    switch (size) {
-    case 1: {
-      const uint8_t *newVal = reinterpret_cast<const uint8_t *>(v);
-      if (*value == *newVal)
-        return false;
-      *value = *newVal;
-      break;
-    }
-    case 2: {
-      const uint16_t *newVal = reinterpret_cast<const uint16_t *>(v);
-      if (*(uint16_t *)value == *newVal)
-        return false;
-      *(uint16_t *)value = *newVal;
-      break;
-    }
-    case 4: {
-      const uint32_t *newVal = reinterpret_cast<const uint32_t *>(v);
-      if (*(uint32_t *)value == *newVal)
-        return false;
-      *(uint32_t *)value = *newVal;
-      break;
-    }
-    case 8: {
-      if (*(uint64_t *)value == *v)
-        return false;
-      *(uint64_t *)value = *v;
-      break;
-    }
-    default: {
-      if (std::memcmp(value, v, size) == 0)
-        return false;
-      std::memcpy(value, v, size);
-      break;
-    }
-    }
-
-    return true;
-  }
-
   /// Return the value of the signal in hexadecimal string format.
   std::string toHexString() const;
 
@@ -203,6 +167,26 @@ private:
 
 /// The simulator's internal representation of one queue slot.
 struct Slot {
+  /// A drive of a signal. Values of up to 64 bits are stored inline, wider ones
+  /// in the slot's `wideValues`.
+  struct Change {
+    unsigned bitOffset;
+    unsigned width;
+    // The next change of the same signal, or `noChange`.
+    unsigned next;
+    // The value, or the index of its first word in `wideValues`.
+    uint64_t value;
+  };
+
+  /// The changes of one signal, linked in the order they were inserted.
+  struct DrivenSignal {
+    unsigned index;
+    unsigned first;
+    unsigned last;
+  };
+
+  static constexpr unsigned noChange = ~0u;
+
   /// Create a new empty slot.
   Slot(Time time) : time(time) {}
 
@@ -218,13 +202,20 @@ struct Slot {
   /// Insert a scheduled process wakeup.
   void insertChange(unsigned inst);
 
-  // A map from signal indexes to change buffers. Makes it easy to sort the
-  // changes such that we can process one signal at a time.
-  llvm::SmallVector<std::pair<unsigned, unsigned>, 32> changes;
-  // Buffers for the signal changes.
-  llvm::SmallVector<std::pair<unsigned, llvm::APInt>, 32> buffers;
-  // The number of used change buffers in the slot.
-  size_t changesSize = 0;
+  /// Return the value driven by a change.
+  llvm::APInt getValue(const Change &change) const;
+
+  /// Reset the slot such that its buffers can be reused.
+  void clear();
+
+  // The changes of the slot, bucketed by signal through `drivenSignals`.
+  llvm::SmallVector<Change, 32> changes;
+  // The words of the values wider than 64 bits.
+  llvm::SmallVector<uint64_t, 0> wideValues;
+  // The signals with changes in this slot, and the position of each of them in
+  // `drivenSignals`.
+  llvm::SmallVector<DrivenSignal, 16> drivenSignals;
+  llvm::SmallDenseMap<unsigned, unsigned, 16> signalPositions;
 
   // Processes with scheduled wakeup.
   llvm::SmallVector<unsigned, 4> scheduled;
@@ -233,11 +224,24 @@ struct Slot {
 };
 
 /// This is equivalent to and std::priorityQueue<Slot> ordered using the greater
-/// operator, which adds an insertion method to add changes to a slot.
+/// operator, which adds an insertion method to add changes to a slot. Slots
+/// are looked up by their time through a hash map, and the pending slots are
+/// kept in a binary heap, such that neither inserting nor popping an event has
+/// to visit every slot.
 class UpdateQueue : public llvm::SmallVector<Slot, 8> {
-  unsigned topSlot = 0;
+  /// The indices of all pending slots, as a heap with the earliest slot at the
+  /// front.
+  llvm::SmallVector<unsigned, 8> pending;
+  /// The pending slot of each scheduled time.
+  llvm::DenseMap<Time, unsigned> slotIndex;
   llvm::SmallVector<unsigned, 4> unused;
 
+  /// Heap order of `pending`: returns true if slot `lhs` is scheduled after
+  /// slot `rhs`.
+  bool isLater(unsigned lhs, unsigned rhs) const {
+    return begin()[rhs] < begin()[lhs];
+  }
+
 public:
   /// Check wheter a slot for the given time already exists. If that's the case,
   /// add the new change to it, else create a new slot and push it to the queue.
@@ -262,6 +266,9 @@ public:
   /// unused and resets its internal structures such that they can be reused.
   void pop();
 
+  /// Return the indices of the pending slots, in no particular order.
+  llvm::ArrayRef<unsigned> getPendingSlots() const { return pending; }
+
   unsigned events = 0;
 };
 
@@ -273,6 +280,19 @@ struct ProcState {
   uint8_t *resumeState;
 };
 
+/// The counters gathered for an instance when profiling a simulation.
+struct InstanceProfile {
+  // The number of evaluations of the instance, and how many of them happened
+  // in a delta or epsilon step rather than a real-time step.
+  uint64_t activations = 0;
+  uint64_t deltaActivations = 0;
+  // The number of drives and wakeups scheduled by the instance.
+  uint64_t drives = 0;
+  uint64_t wakeups = 0;
+  // The time spent evaluating the instance.
+  std::chrono::nanoseconds time{0};
+};
+
 /// The simulator internal representation of an instance.
 struct Instance {
   Instance() = default;
@@ -292,15 +312,134 @@ struct Instance {
   llvm::SmallVector<SignalDetail, 0> sensitivityList;
   ProcState *procState;
   uint8_t *entityState;
+  // The sizes of the process and entity state allocations, in bytes.
+  uint64_t procStateSize = 0;
+  uint64_t entityStateSize = 0;
   Time expectedWakeup;
   // A pointer to the base unit jitted function.
   void (*unitFPtr)(void **);
+  InstanceProfile profile;
 
   /// Free procState and entityState since they are allocated using 'malloc' in
   /// the LLVM code generated in LLHDToLLVM.
   ~Instance();
 };
 
+/// The values, sizes and triggered instances of all signals, stored as
+/// parallel arrays indexed by the global signal index. Once packed, the values
+/// are laid out contiguously in one arena, with every value starting on a
+/// 64-bit boundary.
+class SignalTable {
+public:
+  SignalTable() = default;
+  SignalTable(const SignalTable &) = delete;
+  ~SignalTable();
+
+  /// Move the values of `signals`, as allocated by the code generated by
+  /// LLHDToLLVM, to the arena and free the original allocations, making the
+  /// signals and the sensitivity lists of `instances` point to the arena.
+  void pack(llvm::MutableArrayRef<Signal> signals,
+            llvm::MutableArrayRef<Instance> instances);
+
+  bool isPacked() const { return arena != nullptr; }
+
+  uint8_t *getValue(unsigned index) const { return arena + offsets[index]; }
+
+  uint64_t getSize(unsigned index) const { return sizes[index]; }
+
+  llvm::ArrayRef<unsigned> getTriggeredInstanceIndices(unsigned index) const {
+    return llvm::makeArrayRef(triggers.data() + triggerOffsets[index],
+                              triggers.data() + triggerOffsets[index + 1]);
+  }
+
+  /// Update the value of signal `index` when it is changed, the width of
+  /// incoming signal value and the stored signal value are identical.
+  /// As majority signals are smaller than 64 bits, this implementation
+  /// is much faster as it avoided memcpy in most cases.
+  /// @param v Pointer to signal value
+  /// @return true when signal is updated, false when not
+  bool updateWhenChanged(unsigned index, const uint64_t *v) {
+    auto *value = getValue(index);
+    switch (sizes[index]) {
+    case 1: {
+      const uint8_t *newVal = reinterpret_cast<const uint8_t *>(v);
+      if (*value == *newVal)
+        return false;
+      *value = *newVal;
+      break;
+    }
+    case 2: {
+      const uint16_t *newVal = reinterpret_cast<const uint16_t *>(v);
+      if (*(uint16_t *)value == *newVal)
+        return false;
+      *(uint16_t *)value = *newVal;
+      break;
+    }
+    case 4: {
+      const uint32_t *newVal = reinterpret_cast<const uint32_t *>(v);
+      if (*(uint32_t *)value == *newVal)
+        return false;
+      *(uint32_t *)value = *newVal;
+      break;
+    }
+    case 8: {
+      if (*(uint64_t *)value == *v)
+        return false;
+      *(uint64_t *)value = *v;
+      break;
+    }
+    default: {
+      if (std::memcmp(value, v, sizes[index]) == 0)
+        return false;
+      std::memcpy(value, v, sizes[index]);
+      break;
+    }
+    }
+
+    return true;
+  }
+
+private:
+  uint8_t *arena = nullptr;
+  size_t arenaSize = 0;
+  // The byte offset of every signal value in the arena.
+  std::vector<uint64_t> offsets;
+  std::vector<uint64_t> sizes;
+  // The triggered instances of signal i are
+  // triggers[triggerOffsets[i]..triggerOffsets[i + 1]].
+  std::vector<unsigned> triggerOffsets;
+  std::vector<unsigned> triggers;
+};
+
+/// The events scheduled by one worker thread while the instances of a delta
+/// cycle are evaluated in parallel. Every event records the position of the
+/// instance scheduling it in the delta's wakeup list, such that the events can
+/// be applied in the same order as a sequential evaluation would.
+struct DeferredEvents {
+  struct Drive {
+    unsigned position;
+    Time time;
+    unsigned index;
+    int bitOffset;
+    unsigned width;
+    llvm::SmallVector<uint8_t, 8> bytes;
+  };
+  struct Wakeup {
+    unsigned position;
+    Time time;
+    unsigned inst;
+  };
+
+  // The thread recording into this buffer.
+  std::thread::id thread;
+  // The position of the instance currently evaluated by the thread in the
+  // wakeup list, and its index.
+  unsigned position = 0;
+  unsigned instance = 0;
+  std::vector<Drive> drives;
+  std::vector<Wakeup> wakeups;
+};
+
 /// The simulator's state. It contains the current simulation time, signal
 /// values and the event queue.
 struct State {
@@ -317,6 +456,19 @@ struct State {
   /// Push a new scheduled wakeup event in the event queue.
   void pushQueue(Time time, unsigned inst);
 
+  /// Push a drive of the `width` bits at `bytes` to signal `index` at
+  /// `bitOffset`, taking effect at absolute time `time`.
+  void pushDrive(Time time, unsigned index, int bitOffset, uint8_t *bytes,
+                 unsigned width);
+
+  /// Return the buffer the calling thread defers its events to, or null if
+  /// events go to the event queue directly.
+  DeferredEvents *getDeferredEvents();
+
+  /// Move the events deferred by all workers to the event queue, in the order
+  /// of the instances scheduling them.
+  void applyDeferredEvents();
+
   /// Find an instance in the instances list by name and return an
   /// iterator for it.
   llvm::SmallVectorTemplateCommon<Instance>::iterator
@@ -330,8 +482,21 @@ struct State {
 
   void addSignalElement(unsigned, unsigned, unsigned);
 
-  /// Add a pointer to the process persistence state to a process instance.
-  void addProcPtr(std::string name, ProcState *procStatePtr);
+  /// Move the signal values to the signal table, once all signals have been
+  /// allocated.
+  void packSignals();
+
+  /// Add a pointer to the process persistence state of `size` bytes to a
+  /// process instance.
+  void addProcPtr(std::string name, ProcState *procStatePtr, uint64_t size);
+
+  /// Write a checkpoint of the simulation time, the signal values, the state
+  /// of all instances and the pending events to `os`.
+  void save(llvm::raw_ostream &os) const;
+
+  /// Restore a checkpoint written by `save`. The state has to be initialized
+  /// for the same design as the checkpoint, with its signals packed.
+  llvm::Error restore(llvm::StringRef data);
 
   /// Dump a signal to the out stream. One entry is added for every instance
   /// the signal appears in.
@@ -346,7 +511,16 @@ struct State {
   Time time;
   std::string root;
   llvm::SmallVector<Instance, 0> instances;
+  // The workers of a parallel evaluation, and whether they currently defer
+  // their events.
+  std::vector<DeferredEvents> workers;
+  bool deferEvents = false;
+  // Whether the instances count their scheduled events, and the instance
+  // evaluated by a sequential simulation.
+  bool profiling = false;
+  unsigned activeInstance = 0;
   llvm::SmallVector<Signal, 0> signals;
+  SignalTable signalTable;
   UpdateQueue queue;
 };
 
@@ -354,4 +528,17 @@ struct State {
 } // namespace llhd
 } // namespace circt
 
+namespace llvm {
+template <>
+struct DenseMapInfo<circt::llhd::sim::Time> {
+  using Time = circt::llhd::sim::Time;
+  static Time getEmptyKey() { return Time(~0ULL, ~0ULL, ~0ULL); }
+  static Time getTombstoneKey() { return Time(~0ULL, ~0ULL, ~0ULL - 1); }
+  static unsigned getHashValue(const Time &time) {
+    return llvm::hash_combine(time.getTime(), time.getDelta(), time.getEps());
+  }
+  static bool isEqual(const Time &lhs, const Time &rhs) { return lhs == rhs; }
+};
+} // namespace llvm
+
 #endif // CIRCT_DIALECT_LLHD_SIMULATOR_STATE_H
@@ -27,7 +27,15 @@ namespace circt {
 namespace llhd {
 namespace sim {
 
-enum class TraceMode { Full, Reduced, Merged, MergedReduce, NamedOnly, None };
+enum class TraceMode {
+  Full,
+  Reduced,
+  Merged,
+  MergedReduce,
+  NamedOnly,
+  VCD,
+  None
+};
 
 class Trace {
   llvm::raw_ostream &out;
@@ -43,6 +51,31 @@ class Trace {
   // Buffer of last dumped change for each signal.
   std::map<std::pair<std::string, int>, std::string> lastValue;
 
+  /// A value dumped to a VCD trace: a signal, or one element of a structured
+  /// signal. A value is identified in the trace by its index in `vcdValues`.
+  struct VCDValue {
+    unsigned sigIndex;
+    int elem;
+    // The location of the value within the signal and within `vcdLastBytes`.
+    size_t sigOffset, lastOffset, size;
+  };
+  // All dumped values, grouped by signal. Empty until the header is written.
+  std::vector<VCDValue> vcdValues;
+  // The index of the first value of every signal in `vcdValues`.
+  std::vector<unsigned> vcdFirstValue;
+  // The raw bytes of every value as last dumped.
+  std::vector<uint8_t> vcdLastBytes;
+  // The signals changed since the last flush.
+  std::vector<unsigned> vcdChanged;
+  std::vector<bool> vcdIsChanged;
+  bool vcdDumpedAll = false;
+
+  /// Assign an identifier to every traced value, and write the VCD header
+  /// declaring them within their instance hierarchy.
+  void writeVCDHeader();
+  /// Flush the values changed since the last flush in VCD format.
+  void flushVCD();
+
   /// Push one change to the changes vector.
   void pushChange(unsigned inst, unsigned sigIndex, int elem);
   /// Push one change for each element of a signal if it is of a structured
@@ -25,6 +25,8 @@ std::unique_ptr<OperationPass<ModuleOp>> createProcessLoweringPass();
 
 std::unique_ptr<OperationPass<ModuleOp>> createFunctionEliminationPass();
 
+std::unique_ptr<OperationPass<ModuleOp>> createEntityInliningPass();
+
 std::unique_ptr<OperationPass<ProcOp>> createMemoryToBlockArgumentPass();
 
 std::unique_ptr<OperationPass<ProcOp>> createEarlyCodeMotionPass();
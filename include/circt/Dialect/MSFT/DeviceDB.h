@@ -19,6 +19,8 @@
 #include "mlir/IR/Operation.h"
 #include "llvm/ADT/DenseMap.h"
 
+#include <map>
+
 namespace circt {
 namespace msft {
 
@@ -37,6 +39,19 @@ public:
   /// Iterate over all the primitive locations, executing 'callback' on each
   /// one.
   void foreach (function_ref<void(PhysLocationAttr)> callback) const;
+  /// Iterate over all the primitive locations without creating attributes for
+  /// them, executing 'callback' with the type, column, row and number of each.
+  void foreachLocation(
+      function_ref<void(PrimitiveType, uint64_t, uint64_t, uint64_t)> callback)
+      const;
+
+  /// Write all the primitive locations to 'path' in a compact binary form,
+  /// which `load` reads back. Device primitives are static for each part, so
+  /// the file can be reused across runs instead of rebuilding the DB.
+  LogicalResult save(StringRef path) const;
+  /// Add all the primitive locations from a file written by `save`. The file
+  /// is memory-mapped rather than read.
+  LogicalResult load(StringRef path);
 
 private:
   using DimPrimitiveType = DenseSet<PrimitiveType>;
@@ -67,6 +82,8 @@ public:
   PlacementDB(mlir::ModuleOp topMod);
   PlacementDB(mlir::ModuleOp topMod, const PrimitiveDB &seed);
 
+  MLIRContext *getContext() const { return ctxt; }
+
   /// Contains the order to iterate in each dimension for walkPlacements. The
   /// dimensions are visited with columns first, then rows, then numbers within
   /// a cell.
@@ -129,15 +146,20 @@ private:
   MLIRContext *ctxt;
   mlir::ModuleOp topMod;
 
-  using DimDevType = DenseMap<PrimitiveType, PlacementCell>;
-  using DimNumMap = DenseMap<size_t, DimDevType>;
-  using DimYMap = DenseMap<size_t, DimNumMap>;
-  using DimXMap = DenseMap<size_t, DimYMap>;
+  // The dimensions are kept sorted, so that bounded and ordered walks only
+  // visit the columns and rows within their bounds. The cells are never moved,
+  // so pointers to them stay valid as more locations are added.
+  using DimDevType = std::map<PrimitiveType, PlacementCell>;
+  using DimNumMap = std::map<size_t, DimDevType>;
+  using DimYMap = std::map<size_t, DimNumMap>;
+  using DimXMap = std::map<size_t, DimYMap>;
   using RegionPlacements = SmallVector<PDPhysRegionOp>;
 
   /// Get the leaf node. Abstract this out to make it easier to change the
   /// underlying data structure.
   PlacementCell *getLeaf(PhysLocationAttr);
+  /// Get the leaf node if it exists, without adding it.
+  PlacementCell *findLeaf(PhysLocationAttr);
 
   DimXMap placements;
   RegionPlacements regionPlacements;
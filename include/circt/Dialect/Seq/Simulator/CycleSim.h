@@ -0,0 +1,99 @@
+//===- CycleSim.h - Compiled cycle-based simulator --------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a cycle-based simulator for flat modules of the HW, Comb
+// and Seq dialects. The combinational logic of the module is levelized and
+// compiled, through the HWToLLVM and CombToLLVM conversions and the MLIR
+// execution engine, into native functions which operate on a flat arena
+// holding the ports and registers of the module.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_DIALECT_SEQ_SIMULATOR_CYCLESIM_H
+#define CIRCT_DIALECT_SEQ_SIMULATOR_CYCLESIM_H
+
+#include "circt/Support/LLVM.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "llvm/ADT/APInt.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mlir {
+class ExecutionEngine;
+} // namespace mlir
+
+namespace circt {
+namespace seq {
+namespace sim {
+
+/// A port or register of the simulated module, stored in the state arena.
+struct Signal {
+  enum class Kind { Input, Clock, Output, Register };
+
+  std::string name;
+  Kind kind;
+  unsigned width;
+  /// The byte offset of the signal in the state arena.
+  unsigned offset;
+};
+
+class CycleSim {
+public:
+  /// Compile the module named `top` of `module`, which must neither contain
+  /// instances nor combinational cycles, and whose registers must be clocked
+  /// by input ports. Emits an error and returns null if the module cannot be
+  /// simulated.
+  static std::unique_ptr<CycleSim> create(ModuleOp module, StringRef top,
+                                          unsigned optLevel = 2);
+
+  ~CycleSim();
+
+  /// Return the ports and registers of the module, in the order of the input
+  /// ports, the output ports and the registers.
+  ArrayRef<Signal> getSignals() const { return signals; }
+
+  /// Return the indices of the clock signals, each of which has its own
+  /// evaluation function.
+  ArrayRef<unsigned> getClocks() const { return clocks; }
+
+  /// Return the index of the signal named `name`, or -1 if there is none.
+  int lookupSignal(StringRef name) const;
+
+  /// Set the value of an input, which must have the width of the signal.
+  void setValue(unsigned signal, const APInt &value);
+
+  /// Return the current value of a signal.
+  APInt getValue(unsigned signal) const;
+
+  /// Compute the outputs from the inputs and the registers.
+  LogicalResult evalComb();
+
+  /// Apply a rising edge of `clock`, an index into `getClocks()`, to the
+  /// registers it clocks. Resets, including asynchronous ones, are applied on
+  /// the edge.
+  LogicalResult evalClock(unsigned clock);
+
+private:
+  CycleSim() = default;
+
+  LogicalResult invoke(StringRef function);
+
+  std::vector<Signal> signals;
+  std::vector<unsigned> clocks;
+  /// The state arena, in 64-bit words such that every signal is aligned.
+  std::vector<uint64_t> arena;
+  std::unique_ptr<mlir::ExecutionEngine> engine;
+};
+
+} // namespace sim
+} // namespace seq
+} // namespace circt
+
+#endif // CIRCT_DIALECT_SEQ_SIMULATOR_CYCLESIM_H
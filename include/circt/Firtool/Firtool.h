@@ -0,0 +1,165 @@
+//===- Firtool.h - Definitions for the firtool pipeline ---------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the pass pipeline of firtool, such that tools embedding
+// CIRCT can compile FIRRTL with the same passes, nesting and parallelism as
+// firtool.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_FIRTOOL_FIRTOOL_H
+#define CIRCT_FIRTOOL_FIRTOOL_H
+
+#include "circt/Dialect/FIRRTL/Passes.h"
+#include "circt/Support/LLVM.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Pass/PassManager.h"
+
+#include <memory>
+#include <string>
+
+namespace circt {
+class CanonicalizerProfile;
+
+namespace firtool {
+
+/// The options of the firtool pipeline. The defaults match those of firtool.
+struct FirtoolOptions {
+  // Annotation lowering.
+  bool disableAnnotationsUnknown = false;
+  bool disableAnnotationsClassless = false;
+
+  // Optimizations.
+  bool disableOptimization = false;
+  firrtl::PreserveValues::PreserveMode preserveMode =
+      firrtl::PreserveValues::None;
+  bool dedup = false;
+  bool mergeConnectionsAggressively = false;
+  /// Merge connections right after ExpandWhens, in the same pass, rather than
+  /// by a separate MergeConnections pass late in the pipeline.
+  bool fuseMergeConnections = false;
+
+  // Type lowering.
+  firrtl::PreserveAggregate::PreserveMode preserveAggregate =
+      firrtl::PreserveAggregate::None;
+  bool preservePublicTypes = true;
+  /// Record the source of lowered values for the hgdb debug table.
+  bool insertDebugInfo = false;
+
+  // Memories.
+  bool replSeqMem = false;
+  std::string replSeqMemCircuit;
+  std::string replSeqMemFile;
+  bool ignoreReadEnableMem = false;
+  bool lowerMemories = false;
+  bool addVivadoRAMAddressConflictSynthesisBugWorkaround = false;
+
+  // Randomization.
+  bool disableMemRandomization = false;
+  bool disableRegRandomization = false;
+
+  // Metadata and side outputs.
+  bool emitMetadata = true;
+  bool emitOMIR = true;
+  std::string omirOutFile;
+  bool exportChiselInterface = false;
+  std::string chiselInterfaceOutDirectory;
+  std::string outputAnnotationFilename;
+  /// The output file or directory, relative to which Grand Central places its
+  /// signal mappings.
+  std::string outputFilename;
+  /// The root of the paths of black box annotations. Defaults to the
+  /// directory of the input file.
+  std::string blackBoxRootPath;
+
+  // Lowering to HW.
+  bool enableAnnotationWarning = false;
+  bool emitChiselAssertsAsSVA = false;
+  bool stripMuxPragmas = false;
+  bool lowMemory = false;
+  uint64_t maxMemory = 0;
+
+  // HW and SV cleanups.
+  bool extractTestCode = false;
+  bool etcDisableInstanceExtraction = false;
+  bool etcDisableModuleInlining = false;
+
+  // Verilog emission.
+  bool stripFirDebugInfo = true;
+  bool stripDebugInfo = false;
+
+  // Individual passes, mostly for testing.
+  bool disableInliner = false;
+  bool disableIMCP = false;
+  bool disableIMDCE = false;
+  bool disableLowerMemory = false;
+  bool disableLowerTypes = false;
+  bool disableExpandWhens = false;
+  bool disableAddSeqMemPorts = false;
+  bool disableLowerChirrtl = false;
+  bool disableWireDFT = false;
+  bool disableInferWidths = false;
+  bool disableInferResets = false;
+  bool disableInjectDutHierarchy = false;
+  bool disableExtractInstances = false;
+  bool batchExtractInstances = false;
+  bool disableMemToRegOfVec = false;
+  bool disablePrefixModules = false;
+  bool disableGrandCentral = false;
+  bool disableCheckCombCycles = false;
+  bool disableMergeConnections = false;
+  bool disableInferRW = false;
+
+  // Profiling.
+  /// If set, the canonicalizers of the pipeline count the attempts, rewrites
+  /// and time of their patterns in this profile, which writes its report once
+  /// the pipeline and the options are destroyed.
+  std::shared_ptr<CanonicalizerProfile> canonicalizerProfile;
+};
+
+/// Create the canonicalizer pass used throughout the pipeline, which does not
+/// simplify regions. If `profile` is set, the pass profiles its patterns into
+/// it.
+std::unique_ptr<mlir::Pass> createSimpleCanonicalizerPass(
+    std::shared_ptr<CanonicalizerProfile> profile = {});
+
+/// Add the passes which lower the annotations of the parsed circuit. firtool
+/// stops after these with `--parse-only`.
+LogicalResult populatePreprocessTransforms(mlir::PassManager &pm,
+                                           const FirtoolOptions &opt);
+
+/// Add the passes which lower CHIRRTL, or high FIRRTL, to low FIRRTL.
+/// `inputFilename` is the default root of black box paths.
+LogicalResult populateCHIRRTLToLowFIRRTL(mlir::PassManager &pm,
+                                         const FirtoolOptions &opt,
+                                         ModuleOp module,
+                                         StringRef inputFilename);
+
+/// Add the passes which lower low FIRRTL to the HW dialect.
+LogicalResult populateLowFIRRTLToHW(mlir::PassManager &pm,
+                                    const FirtoolOptions &opt);
+
+/// Add the passes which lower HW to SV and clean up the result.
+LogicalResult populateHWToSV(mlir::PassManager &pm, const FirtoolOptions &opt);
+
+/// Add the passes which prepare the modules for emission and emit them as a
+/// single Verilog file to `os`.
+LogicalResult populateExportVerilog(mlir::PassManager &pm,
+                                    const FirtoolOptions &opt,
+                                    llvm::raw_ostream &os);
+
+/// Add the passes which prepare the modules for emission and emit one Verilog
+/// file per module into `directory`.
+LogicalResult populateExportSplitVerilog(mlir::PassManager &pm,
+                                         const FirtoolOptions &opt,
+                                         StringRef directory);
+
+} // namespace firtool
+} // namespace circt
+
+#endif // CIRCT_FIRTOOL_FIRTOOL_H
@@ -15,6 +15,8 @@
 
 #include "circt/Scheduling/Problems.h"
 
+#include "mlir/IR/Threading.h"
+
 namespace circt {
 namespace scheduling {
 
@@ -80,6 +82,20 @@ LogicalResult scheduleLP(CyclicProblem &prob, Operation *lastOp);
 /// prob does not include \p lastOp.
 LogicalResult scheduleCPSAT(SharedOperatorsProblem &prob, Operation *lastOp);
 
+/// Schedule a batch of independent problems by invoking \p schedule, e.g. a
+/// lambda calling one of the algorithms above, on each of them. The problems
+/// are processed in parallel if multi-threading is enabled in \p context, so
+/// \p schedule must only modify the problem it is given, and the problems must
+/// not share operations. Diagnostics are reported in the order of \p problems.
+/// Fails if any of the problems could not be scheduled.
+template <typename ProblemT, typename ScheduleFn>
+LogicalResult scheduleInParallel(MLIRContext *context,
+                                 ArrayRef<ProblemT *> problems,
+                                 ScheduleFn &&schedule) {
+  return mlir::failableParallelForEach(
+      context, problems, [&](ProblemT *prob) { return schedule(*prob); });
+}
+
 } // namespace scheduling
 } // namespace circt
 
@@ -23,8 +23,12 @@
 #include "mlir/IR/BuiltinAttributes.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/ADT/SetVector.h"
 
+#include <memory>
+
 #define DEFINE_COMMON_MEMBERS(ProblemClass)                                    \
 protected:                                                                     \
   ProblemClass() {}                                                            \
@@ -39,6 +43,66 @@ public:                                                                        \
 
 namespace circt {
 namespace scheduling {
+namespace detail {
+
+/// Storage for a property of operations or dependences. Values are kept in a
+/// map until the owning problem is finalized, after which the problem's dense
+/// indices are shared with the storage and the values move to a contiguous
+/// array. Keys that do not have an index keep using the map.
+template <typename KeyT, typename T>
+class PropertyStorage {
+public:
+  using IndexMap = llvm::DenseMap<KeyT, unsigned>;
+
+  Optional<T> lookup(KeyT key) const {
+    if (indices) {
+      auto it = indices->find(key);
+      if (it != indices->end())
+        return denseValues[it->second];
+    }
+    return values.lookup(key);
+  }
+
+  Optional<T> &operator[](KeyT key) {
+    if (indices) {
+      auto it = indices->find(key);
+      if (it != indices->end())
+        return denseValues[it->second];
+    }
+    return values[key];
+  }
+
+  /// Access the value of the key with dense index \p idx. Only valid after
+  /// `finalize`.
+  Optional<T> lookupIndex(unsigned idx) const {
+    assert(indices && "property storage is not finalized");
+    return denseValues[idx];
+  }
+  Optional<T> &atIndex(unsigned idx) {
+    assert(indices && "property storage is not finalized");
+    return denseValues[idx];
+  }
+
+  /// Move the values of all keys in \p newIndices to the dense array.
+  void finalize(std::shared_ptr<const IndexMap> newIndices) {
+    if (indices == newIndices)
+      return;
+    SmallVector<Optional<T>, 0> newValues(newIndices->size());
+    for (auto &entry : *newIndices) {
+      newValues[entry.second] = lookup(entry.first);
+      values.erase(entry.first);
+    }
+    denseValues = std::move(newValues);
+    indices = std::move(newIndices);
+  }
+
+private:
+  llvm::DenseMap<KeyT, Optional<T>> values;
+  SmallVector<Optional<T>, 0> denseValues;
+  std::shared_ptr<const IndexMap> indices;
+};
+
+} // namespace detail
 
 /// This class models the most basic scheduling problem.
 ///
@@ -115,9 +179,9 @@ protected:
       llvm::DenseMap<Operation *, llvm::SmallSetVector<Operation *, 4>>;
 
   template <typename T>
-  using OperationProperty = llvm::DenseMap<Operation *, Optional<T>>;
+  using OperationProperty = detail::PropertyStorage<Operation *, T>;
   template <typename T>
-  using DependenceProperty = llvm::DenseMap<Dependence, Optional<T>>;
+  using DependenceProperty = detail::PropertyStorage<Dependence, T>;
   template <typename T>
   using OperatorTypeProperty = llvm::DenseMap<OperatorType, Optional<T>>;
   template <typename T>
@@ -143,12 +207,26 @@ private:
   // Operator type properties
   OperatorTypeProperty<unsigned> latency;
 
+  // Dense indices, set up by `finalize`
+  using OperationIndexMap = llvm::DenseMap<Operation *, unsigned>;
+  using DependenceIndexMap = llvm::DenseMap<Dependence, unsigned>;
+  SmallVector<unsigned, 0> dependenceOffsets;
+  SmallVector<Dependence, 0> dependences;
+  SmallVector<unsigned, 0> dependenceSources;
+
+protected:
+  std::shared_ptr<const OperationIndexMap> operationIndices;
+  std::shared_ptr<const DependenceIndexMap> dependenceIndices;
+
   //===--------------------------------------------------------------------===//
   // Problem construction
   //===--------------------------------------------------------------------===//
 public:
   /// Include \p op in this scheduling problem.
-  void insertOperation(Operation *op) { operations.insert(op); }
+  void insertOperation(Operation *op) {
+    assert(!isFinalized() && "cannot modify a finalized problem");
+    operations.insert(op);
+  }
 
   /// Include \p dep in the scheduling problem. Return failure if \p dep does
   /// not represent a valid def-use or auxiliary dependence between operations.
@@ -193,6 +271,54 @@ public:
   /// Return the set of operator types.
   const OperatorTypeSet &getOperatorTypes() { return operatorTypes; }
 
+  //===--------------------------------------------------------------------===//
+  // Dense indices
+  //===--------------------------------------------------------------------===//
+public:
+  /// Number the registered operations (in insertion order) and dependences
+  /// (grouped by destination operation, in `getDependences` order), and move
+  /// the operation and dependence properties to arrays indexed by these
+  /// numbers. Afterwards, no operations or dependences can be inserted, but
+  /// properties can still be read and written through either API. Does nothing
+  /// if the problem is already finalized.
+  void finalize();
+  bool isFinalized() { return operationIndices != nullptr; }
+
+  /// Return the dense index of \p op, which must be part of the finalized
+  /// problem.
+  unsigned getOperationIndex(Operation *op) {
+    assert(isFinalized() && "problem is not finalized");
+    return operationIndices->find(op)->second;
+  }
+  /// Return the operation with the dense index \p opIdx.
+  Operation *getOperation(unsigned opIdx) { return operations[opIdx]; }
+
+  /// Return the dense index of \p dep, which must be part of the finalized
+  /// problem.
+  unsigned getDependenceIndex(Dependence dep) {
+    assert(isFinalized() && "problem is not finalized");
+    return dependenceIndices->find(dep)->second;
+  }
+  /// Return the dependence with the dense index \p depIdx.
+  Dependence getDependence(unsigned depIdx) { return dependences[depIdx]; }
+  unsigned getNumDependences() { return dependences.size(); }
+
+  /// Return the dense indices of the incoming dependences of the operation
+  /// with the dense index \p opIdx, which are consecutive.
+  auto getDependenceIndices(unsigned opIdx) {
+    assert(isFinalized() && "problem is not finalized");
+    return llvm::seq(dependenceOffsets[opIdx], dependenceOffsets[opIdx + 1]);
+  }
+  /// Return the dense index of the source and destination operations of the
+  /// dependence with the dense index \p depIdx.
+  unsigned getDependenceSource(unsigned depIdx) {
+    return dependenceSources[depIdx];
+  }
+  unsigned getDependenceDestination(unsigned depIdx) {
+    return llvm::upper_bound(dependenceOffsets, depIdx) -
+           dependenceOffsets.begin() - 1;
+  }
+
   //===--------------------------------------------------------------------===//
   // Access to properties
   //===--------------------------------------------------------------------===//
@@ -204,6 +330,9 @@ public:
   void setLinkedOperatorType(Operation *op, OperatorType opr) {
     linkedOperatorType[op] = opr;
   }
+  Optional<OperatorType> getLinkedOperatorType(unsigned opIdx) {
+    return linkedOperatorType.lookupIndex(opIdx);
+  }
 
   /// The latency is the number of cycles \p opr needs to compute its result.
   Optional<unsigned> getLatency(OperatorType opr) {
@@ -218,6 +347,12 @@ public:
     return startTime.lookup(op);
   }
   void setStartTime(Operation *op, unsigned val) { startTime[op] = val; }
+  Optional<unsigned> getStartTime(unsigned opIdx) {
+    return startTime.lookupIndex(opIdx);
+  }
+  void setStartTime(unsigned opIdx, unsigned val) {
+    startTime.atIndex(opIdx) = val;
+  }
 
   //===--------------------------------------------------------------------===//
   // Optional names (for exporting and debugging instances)
@@ -256,6 +391,10 @@ public:
   // Property-specific validators
   //===--------------------------------------------------------------------===//
 protected:
+  /// Move the operation and dependence properties to dense storage. Problems
+  /// that declare such properties override this to finalize them as well.
+  virtual void finalizeProperties();
+
   /// \p op is linked to a registered operator type.
   virtual LogicalResult checkLinkedOperatorType(Operation *op);
   /// \p opr has a latency.
@@ -293,6 +432,12 @@ public:
     return distance.lookup(dep);
   }
   void setDistance(Dependence dep, unsigned val) { distance[dep] = val; }
+  Optional<unsigned> getDistance(unsigned depIdx) {
+    return distance.lookupIndex(depIdx);
+  }
+  void setDistance(unsigned depIdx, unsigned val) {
+    distance.atIndex(depIdx) = val;
+  }
 
   /// The initiation interval (II) is the number of time steps between
   /// subsequent iterations, i.e. a new iteration is started every II time
@@ -306,6 +451,8 @@ public:
   virtual PropertyStringVector getProperties() override;
 
 protected:
+  virtual void finalizeProperties() override;
+
   /// \p dep's source operation is available before \p dep's destination
   /// operation starts (\p dep's distance iterations later).
   virtual LogicalResult verifyPrecedence(Dependence dep) override;
@@ -363,11 +510,19 @@ public:
   void setStartTimeInCycle(Operation *op, float time) {
     startTimeInCycle[op] = time;
   }
+  Optional<float> getStartTimeInCycle(unsigned opIdx) {
+    return startTimeInCycle.lookupIndex(opIdx);
+  }
+  void setStartTimeInCycle(unsigned opIdx, float time) {
+    startTimeInCycle.atIndex(opIdx) = time;
+  }
 
   virtual PropertyStringVector getProperties(Operation *op) override;
   virtual PropertyStringVector getProperties(OperatorType opr) override;
 
 protected:
+  virtual void finalizeProperties() override;
+
   /// Incoming/outgoing delays are set for \p opr and non-negative. The delays
   /// are equal if \p opr is a zero-latency operator type.
   virtual LogicalResult checkDelays(OperatorType opr);
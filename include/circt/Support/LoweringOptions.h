@@ -98,6 +98,10 @@ struct LoweringOptions {
   /// If true, replicated ops are emitted to a header file.
   bool emitReplicatedOpsToHeader = false;
 
+  /// If true, split Verilog emission doesn't rewrite output files whose
+  /// contents didn't change, such that their modification times are kept.
+  bool skipUnchangedFiles = false;
+
   /// This option controls emitted location information style.
   enum LocationInfoStyle {
     Plain,                 // Default.
@@ -122,6 +126,9 @@ struct LoweringOptions {
     SpillLargeTermsWithNamehints = 1, // Spill wires for expressions with
                                       // namehints if the term size is greater
                                       // than `wireSpillingNamehintTermLimit`.
+    SpillLargeDuplicatedExpressions = 2, // Spill wide constants and inlined
+                                         // expressions which would otherwise
+                                         // be printed at each of their uses.
   };
 
   unsigned wireSpillingHeuristicSet = 0;
@@ -133,6 +140,11 @@ struct LoweringOptions {
   enum { DEFAULT_NAMEHINT_TERM_LIMIT = 3 };
   unsigned wireSpillingNamehintTermLimit = DEFAULT_NAMEHINT_TERM_LIMIT;
 
+  /// Duplicated expressions are spilled by `SpillLargeDuplicatedExpressions`
+  /// if their term size is at least this limit.
+  enum { DEFAULT_DUPLICATE_TERM_LIMIT = 8 };
+  unsigned wireSpillingDuplicateTermLimit = DEFAULT_DUPLICATE_TERM_LIMIT;
+
   /// If true, every expression passed to an instance port is driven by a wire.
   /// Some lint tools dislike expressions being inlined into input ports so this
   /// option avoids such warnings.
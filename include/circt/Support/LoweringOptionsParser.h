@@ -45,6 +45,7 @@ struct LoweringOptionsOption
                 "disallowLocalVariables, verifLabels, emittedLineLength=<n>, "
                 "maximumNumberOfTermsPerExpression=<n>, "
                 "explicitBitcast, emitReplicatedOpsToHeader, "
+                "skipUnchangedFiles, "
                 "locationInfoStyle={plain,wrapInAtSquareBracket,none}, "
                 "disallowPortDeclSharing, printDebugInfo, "
                 "disallowExpressionInliningInPorts, disallowMuxInlining"),
@@ -0,0 +1,50 @@
+//===- ParallelSchedule.h - Ordering of parallel work -----------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Utilities to order the per-module tasks of parallel passes by their size.
+//
+// mlir::parallelForEach hands out the elements of a range to the threads in
+// order. If a huge module comes last, a single thread is still busy with it
+// long after all other tasks are done. Starting with the largest tasks leaves
+// the small ones to fill the gaps at the end instead.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_SUPPORT_PARALLELSCHEDULE_H
+#define CIRCT_SUPPORT_PARALLELSCHEDULE_H
+
+#include "circt/Support/LLVM.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/Threading.h"
+#include "llvm/ADT/STLExtras.h"
+
+namespace circt {
+
+/// Estimate the work of a task processing `op` by the number of operations
+/// nested in it, including `op` itself.
+size_t estimateWork(Operation *op);
+
+/// Sort `ops`, which are operations or op classes, by their estimated work,
+/// largest first. Operations of equal size keep their relative order. The
+/// estimates are computed in parallel.
+template <typename OpTy>
+void sortByEstimatedWork(MLIRContext *context, MutableArrayRef<OpTy> ops) {
+  SmallVector<std::pair<size_t, OpTy>> work(ops.size());
+  mlir::parallelFor(context, 0, ops.size(), [&](size_t i) {
+    work[i] = {estimateWork(ops[i]), ops[i]};
+  });
+  llvm::stable_sort(work, [](const auto &a, const auto &b) {
+    return a.first > b.first;
+  });
+  for (size_t i = 0, e = ops.size(); i != e; ++i)
+    ops[i] = work[i].second;
+}
+
+} // namespace circt
+
+#endif // CIRCT_SUPPORT_PARALLELSCHEDULE_H
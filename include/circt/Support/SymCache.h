@@ -17,6 +17,9 @@
 #include "llvm/ADT/iterator.h"
 #include "llvm/Support/Casting.h"
 
+#include <array>
+#include <mutex>
+
 namespace circt {
 
 /// Base symbol cache class to allow for cache lookup through a pointer to some
@@ -128,6 +131,53 @@ public:
   }
 };
 
+/// A symbol cache which is safe to use concurrently, and which doesn't need to
+/// be populated up front.  The symbols defined in the blocks of the `top`
+/// operation are only collected when the cache is first queried, and both
+/// lookups and additions may then happen from multiple threads.  The cache is
+/// split into shards, each guarded by its own lock, to keep contention low.
+/// Iterating the cache is not thread safe.
+class LazySymbolCache : public SymbolCacheBase {
+public:
+  explicit LazySymbolCache(mlir::Operation *top) : top(top) {}
+
+  void addDefinition(mlir::Attribute key, mlir::Operation *op) override;
+
+  // Pull in getDefinition(mlir::FlatSymbolRefAttr symbol)
+  using SymbolCacheBase::getDefinition;
+  mlir::Operation *getDefinition(mlir::Attribute attr) const override;
+
+  SymbolCacheBase::Iterator begin() override;
+  SymbolCacheBase::Iterator end() override;
+
+private:
+  enum { NumShards = 16 };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    llvm::DenseMap<mlir::Attribute, mlir::Operation *> symbolCache;
+  };
+
+  Shard &getShard(mlir::Attribute key) const {
+    return shards[llvm::DenseMapInfo<mlir::Attribute>::getHashValue(key) %
+                  NumShards];
+  }
+
+  /// Collect the symbols defined in `top`, if this hasn't happened yet.
+  void populate() const;
+
+  /// The operation whose symbols are cached.
+  mlir::Operation *top;
+
+  /// Whether the symbols of `top` have been collected.
+  mutable std::once_flag populated;
+
+  mutable std::array<Shard, NumShards> shards;
+
+  /// Iterator support: walks the shards, and the entries of each shard.
+  struct LazySymbolCacheIteratorImpl;
+};
+
 } // namespace circt
 
 #endif // CIRCT_SUPPORT_SYMCACHE_H
@@ -0,0 +1,62 @@
+//===- TaskTrace.h - Per-thread task timelines ------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Utilities to record when the tasks of parallel passes, such as the lowering
+// of a single module, start and stop on each thread, and to write the recorded
+// timelines in the Chrome trace event format understood by chrome://tracing
+// and Perfetto.
+//
+// Unlike llvm::TimeTraceProfiler, which needs to be set up on every thread,
+// the recording is global, such that it covers the threads of the context's
+// thread pool.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_SUPPORT_TASKTRACE_H
+#define CIRCT_SUPPORT_TASKTRACE_H
+
+#include "circt/Support/LLVM.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+
+#include <chrono>
+#include <string>
+
+namespace circt {
+
+/// Start recording tasks on all threads. The calling thread becomes the first
+/// thread of the trace.
+void enableTaskTrace();
+
+/// Return true if tasks are being recorded.
+bool isTaskTraceEnabled();
+
+/// Write the tasks recorded so far as a Chrome trace event file and forget
+/// them. The threads are numbered in the order in which they first finished a
+/// task, and the tasks of each thread are ordered by their start time.
+void writeTaskTrace(llvm::raw_ostream &os);
+
+/// Record the lifetime of this object as a task on the current thread. The
+/// task is named `name`, e.g. the name of the pass, and `detail` describes the
+/// work done, e.g. the name of the module. `detail` is only called if tasks
+/// are being recorded.
+class TaskTraceScope {
+public:
+  TaskTraceScope(StringRef name, llvm::function_ref<std::string()> detail);
+  ~TaskTraceScope();
+  TaskTraceScope(const TaskTraceScope &) = delete;
+
+private:
+  bool active;
+  StringRef name;
+  std::string detail;
+  std::chrono::steady_clock::time_point start;
+};
+
+} // namespace circt
+
+#endif // CIRCT_SUPPORT_TASKTRACE_H
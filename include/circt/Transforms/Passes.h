@@ -17,8 +17,17 @@
 #include "mlir/Pass/Pass.h"
 #include <limits>
 
+namespace mlir {
+class GreedyRewriteConfig;
+} // namespace mlir
+
 namespace circt {
 
+/// The counters of the canonicalization patterns profiled by one or more
+/// ProfileCanonicalizer passes. The report is written when the last pass using
+/// the profile is destroyed.
+class CanonicalizerProfile;
+
 //===----------------------------------------------------------------------===//
 // Passes
 //===----------------------------------------------------------------------===//
@@ -27,6 +36,15 @@ std::unique_ptr<mlir::Pass> createFlattenMemRefPass();
 std::unique_ptr<mlir::Pass> createFlattenMemRefCallsPass();
 std::unique_ptr<mlir::Pass> createStripDebugInfoWithPredPass(
     const std::function<bool(mlir::Location)> &pred);
+std::unique_ptr<mlir::Pass> createProfileCanonicalizerPass();
+std::unique_ptr<mlir::Pass>
+createProfileCanonicalizerPass(const mlir::GreedyRewriteConfig &config,
+                               std::shared_ptr<CanonicalizerProfile> profile);
+
+/// Create a profile which writes its report to `reportFile`, or to stderr if
+/// it is "-".
+std::shared_ptr<CanonicalizerProfile>
+createCanonicalizerProfile(llvm::StringRef reportFile);
 
 //===----------------------------------------------------------------------===//
 // Utility functions.
@@ -4,6 +4,8 @@
 import circt
 from circt.dialects import hw
 
+import numpy as np
+
 from mlir.ir import (Context, Location, InsertionPoint, IntegerType,
                      IntegerAttr, Module, StringAttr, TypeAttr)
 
@@ -58,6 +60,14 @@ with Context() as ctx, Location.unknown():
       # CHECK: hw.struct_extract [[STRUCT1]]["a"] : !hw.struct<a: i32, b: i1>
       hw.StructExtractOp.create(struct1, 'a')
 
+      # CHECK: hw.array_constant dense<[1, 2, 3, -1]> : tensor<4xi12> : !hw.array<4xi12>
+      hw.ArrayConstantOp.create(IntegerType.get_signless(12),
+                                np.array([1, 2, 3, -1], dtype=np.int16))
+      # CHECK: hw.array_constant dense<[true, false, true]> : tensor<3xi1> : !hw.array<3xi1>
+      hw.ArrayConstantOp.create(i1, [1, 0, 1])
+      # CHECK: hw.array_constant dense<[5, 1193046]> : tensor<2xi24> : !hw.array<2xi24>
+      hw.ArrayConstantOp.create(IntegerType.get_signless(24), [5, 0x123456])
+
     hw.HWModuleOp(name="test", body_builder=build)
 
   print(m)
@@ -7,7 +7,9 @@ from circt.dialects import hw, msft
 
 import mlir.ir as ir
 import mlir.passmanager
+import os
 import sys
+import tempfile
 
 with ir.Context() as ctx, ir.Location.unknown():
   circt.register_dialects(ctx)
@@ -99,6 +101,15 @@ with ir.Context() as ctx, ir.Location.unknown():
   devdb.add_primitive(physAttr2)
   assert devdb.is_valid_location(physAttr)
 
+  # Round-trip the primitive DB through its binary file form.
+  with tempfile.TemporaryDirectory() as tmpdir:
+    devdb_path = os.path.join(tmpdir, "devdb.bin")
+    assert devdb.save(devdb_path)
+    devdb = msft.PrimitiveDB()
+    assert devdb.load(devdb_path)
+  assert devdb.is_valid_location(physAttr)
+  assert devdb.is_valid_location(physAttr2)
+
   seeded_pdb = msft.PlacementDB(mod, devdb)
 
   print(seeded_pdb.get_nearest_free_in_column(msft.M20K, 2, 49))
@@ -239,6 +250,28 @@ with ir.Context() as ctx, ir.Location.unknown():
   assert should_be_none is None
   assert pdb.get_instance_at(new_location) == old_loc_repl
 
+  # Place and query many primitives in one call each. The last placement
+  # conflicts with 'old_loc_repl'.
+  bulk_ops = pdb.place_many([dyn_inst] * 3, ["|a", "|b", "|c"],
+                            [msft.M20K] * 3,
+                            xs=[0, 1, 1],
+                            ys=[0, 0, 1],
+                            nums=[0, 1, 1],
+                            src_location=ir.Location.current)
+  assert bulk_ops[0] is not None and bulk_ops[1] is not None
+  assert bulk_ops[2] is None
+  located = pdb.get_instances_at([msft.M20K] * 3, [0, 1, 0], [0, 0, 1],
+                                 [0, 1, 0])
+  assert located[0] == bulk_ops[0] and located[1] == bulk_ops[1]
+  assert located[2] is None
+  for nearest in pdb.get_nearest_free_in_columns([msft.M20K] * 2, [0, 1],
+                                                 [0, 0]):
+    print(nearest)
+  # CHECK: #msft.physloc<M20K, 0, 0, 1>
+  # CHECK: #msft.physloc<M20K, 1, 0, 0>
+  for op in bulk_ops[:2]:
+    pdb.remove_placement(op)
+
   print("=== Errors:", file=sys.stderr)
   # TODO: Python's sys.stderr doesn't seem to be shared with C++ errors.
   # See https://github.com/llvm/circt/issues/1983 for more info.
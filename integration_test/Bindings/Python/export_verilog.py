@@ -7,6 +7,7 @@ from circt.dialects import hw
 
 from mlir.ir import (Context, Location, InsertionPoint, IntegerType, Module)
 
+from concurrent.futures import ThreadPoolExecutor
 import io
 import os
 
@@ -35,3 +36,23 @@ with Context() as ctx, Location.unknown():
   # DIRECTORY:   output out);
   # DIRECTORY:   assign out = 1'h1;
   # DIRECTORY: endmodule
+
+  # The exports release the GIL, so modules can be exported from several
+  # threads at once. The context stack is per thread.
+  def export(name):
+    with ctx, Location.unknown():
+      module = Module.create()
+      with InsertionPoint(module.body):
+        hw.HWModuleOp(
+            name=name,
+            output_ports=[("out", i1)],
+            body_builder=lambda m: {"out": hw.ConstantOp.create(i1, 0)})
+      buffer = io.StringIO()
+      circt.export_verilog(module, buffer)
+      return buffer.getvalue()
+
+  with ThreadPoolExecutor(max_workers=4) as executor:
+    outputs = list(executor.map(export, [f"threaded{i}" for i in range(8)]))
+  print(outputs[7])
+  # INMEMORY: module threaded7(
+  # INMEMORY:   assign out = 1'h0;
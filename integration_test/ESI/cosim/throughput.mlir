@@ -0,0 +1,36 @@
+// REQUIRES: esi-cosim
+// RUN: circt-opt %s --lower-esi-to-physical --lower-esi-ports --lower-esi-to-hw | circt-opt --export-verilog -o %t3.mlir > %t1.sv
+// RUN: circt-translate %s -export-esi-capnp -verify-diagnostics > %t2.capnp
+// RUN: esi-cosim-runner.py --schema %t2.capnp %s %t1.sv
+// PY: import throughput
+// PY: bench = throughput.ThroughputTester(rpcschemapath, simhostport)
+// PY: bench.run(num_msgs=500, latency_msgs=100, output="throughput.json")
+
+// Loopback endpoints of growing message sizes, for the cosim benchmark.
+
+hw.module @i8Loopback(%clk:i1, %rst:i1) -> () {
+  %recv = esi.cosim %clk, %rst, %resp, "LoopbackEP" : !esi.channel<i8> -> !esi.channel<i8>
+  %resp = esi.buffer %clk, %rst, %recv {stages=1} : i8
+}
+
+hw.module @i64Loopback(%clk:i1, %rst:i1) -> () {
+  %recv = esi.cosim %clk, %rst, %resp, "LoopbackEP" : !esi.channel<i64> -> !esi.channel<i64>
+  %resp = esi.buffer %clk, %rst, %recv {stages=1} : i64
+}
+
+hw.module @array8Loopback(%clk:i1, %rst:i1) -> () {
+  %recv = esi.cosim %clk, %rst, %resp, "LoopbackEP" : !esi.channel<!hw.array<8xi64>> -> !esi.channel<!hw.array<8xi64>>
+  %resp = esi.buffer %clk, %rst, %recv {stages=1} : !hw.array<8xi64>
+}
+
+hw.module @array64Loopback(%clk:i1, %rst:i1) -> () {
+  %recv = esi.cosim %clk, %rst, %resp, "LoopbackEP" : !esi.channel<!hw.array<64xi64>> -> !esi.channel<!hw.array<64xi64>>
+  %resp = esi.buffer %clk, %rst, %recv {stages=1} : !hw.array<64xi64>
+}
+
+hw.module @top(%clk:i1, %rst:i1) -> () {
+  hw.instance "i8" @i8Loopback(clk: %clk: i1, rst: %rst: i1) -> ()
+  hw.instance "i64" @i64Loopback(clk: %clk: i1, rst: %rst: i1) -> ()
+  hw.instance "array8" @array8Loopback(clk: %clk: i1, rst: %rst: i1) -> ()
+  hw.instance "array64" @array64Loopback(clk: %clk: i1, rst: %rst: i1) -> ()
+}
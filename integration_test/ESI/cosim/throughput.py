@@ -0,0 +1,114 @@
+#!/usr/bin/python3
+
+import json
+import random
+import statistics
+import time
+import esi_cosim
+
+
+class ThroughputTester(esi_cosim.CosimBase):
+  """Measures the message rate and round-trip latency of the loopback endpoints
+  in 'throughput.mlir', end to end through the RPC server, the endpoint queues
+  and the DPI calls of the simulation."""
+
+  # Endpoint ID, capnp struct name, field name and number of list elements (or
+  # None for an integer) of each loopback.
+  ENDPOINTS = [
+      ("top.i8.LoopbackEP", "I8", "i", None),
+      ("top.i64.LoopbackEP", "I64", "i", None),
+      ("top.array8.LoopbackEP", "ArrayOf8xI64", "l", 8),
+      ("top.array64.LoopbackEP", "ArrayOf64xI64", "l", 64),
+  ]
+
+  def new_msg(self, msgType, field, length):
+    if length is None:
+      value = random.randint(0, 2**8 - 1)
+    else:
+      value = [random.randint(0, 2**64 - 1) for _ in range(length)]
+    return msgType.new_message(**{field: value})
+
+  def check(self, sent, received, field, length):
+    expected = getattr(sent, field)
+    got = getattr(received, field)
+    if length is not None:
+      expected, got = list(expected), list(got)
+    assert expected == got, f"expected {expected}, got {got}"
+
+  def poll(self, ep, maxMsgs):
+    """Poll for messages without sleeping, so as not to add to the latency."""
+    while True:
+      resps = ep.recvMany(maxMsgs=maxMsgs).wait().resps
+      if len(resps) > 0:
+        return resps
+
+  def measure_latency(self, ep, msgType, field, length, num_msgs):
+    """Send one message at a time and time its return, in microseconds."""
+    latencies = []
+    for _ in range(num_msgs):
+      msg = self.new_msg(msgType, field, length)
+      start = time.perf_counter()
+      ep.send(msg).wait()
+      resp = self.poll(ep, 1)[0]
+      latencies.append((time.perf_counter() - start) * 1e6)
+      self.check(msg, resp.msg.as_struct(msgType), field, length)
+    return latencies
+
+  def measure_throughput(self, ep, msgType, field, length, num_msgs, window):
+    """Keep up to `window` messages in flight and return the number of
+    messages per second."""
+    sent = []
+    numReceived = 0
+    start = time.perf_counter()
+    while numReceived < num_msgs:
+      sends = []
+      while len(sent) < num_msgs and len(sent) - numReceived < window:
+        msg = self.new_msg(msgType, field, length)
+        sent.append(msg)
+        sends.append(ep.send(msg))
+      for send in sends:
+        send.wait()
+      for resp in self.poll(ep, window):
+        self.check(sent[numReceived], resp.msg.as_struct(msgType), field,
+                   length)
+        numReceived += 1
+    return num_msgs / (time.perf_counter() - start)
+
+  def run(self, num_msgs=1000, latency_msgs=100, window=32, output=None):
+    results = []
+    for epid, typeName, field, length in ThroughputTester.ENDPOINTS:
+      msgType = getattr(self.schema, typeName)
+      ep = self.openEP(epid, sendType=msgType, recvType=msgType)
+      msgBytes = len(self.new_msg(msgType, field, length).to_bytes())
+
+      latencies = self.measure_latency(ep, msgType, field, length,
+                                       latency_msgs)
+      rate = self.measure_throughput(ep, msgType, field, length, num_msgs,
+                                     window)
+      ep.close().wait()
+
+      latencies.sort()
+      result = {
+          "endpoint": epid,
+          "type": typeName,
+          "bytes": msgBytes,
+          "messages": num_msgs,
+          "window": window,
+          "msgs_per_sec": rate,
+          "mbytes_per_sec": rate * msgBytes / 1e6,
+          "latency_us": {
+              "min": latencies[0],
+              "median": statistics.median(latencies),
+              "p99": latencies[int(len(latencies) * 0.99)],
+          }
+      }
+      results.append(result)
+      print(f"{typeName:14} {msgBytes:6}B {rate:10.1f} msgs/s "
+            f"{result['mbytes_per_sec']:8.3f} MB/s "
+            f"latency median {result['latency_us']['median']:9.1f}us "
+            f"p99 {result['latency_us']['p99']:9.1f}us")
+
+    if output is not None:
+      with open(output, "w") as f:
+        json.dump(results, f, indent=2)
+    return results
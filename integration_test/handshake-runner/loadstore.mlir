@@ -1,4 +1,6 @@
 // RUN: handshake-runner %s 2 | FileCheck %s
+// RUN: handshake-runner --precompile %s 2 | FileCheck %s
+// RUN: handshake-runner --jit %s 2 | FileCheck %s
 // RUN: circt-opt -lower-std-to-handshake %s | handshake-runner - 2 | FileCheck %s
 // CHECK: 1
 
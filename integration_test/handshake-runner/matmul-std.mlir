@@ -1,4 +1,6 @@
 // RUN: handshake-runner %s | FileCheck %s
+// RUN: handshake-runner --precompile %s | FileCheck %s
+// RUN: handshake-runner --jit %s | FileCheck %s
 // RUN: circt-opt -lower-std-to-handshake %s | handshake-runner | FileCheck %s
 // CHECK: 0
 
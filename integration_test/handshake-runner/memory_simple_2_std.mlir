@@ -1,5 +1,9 @@
 // RUN: handshake-runner %s 2,3,4,5 | FileCheck %s
 // RUN: circt-opt -lower-std-to-handshake %s | handshake-runner - 2,3,4,5 | FileCheck %s
+// RUN: printf '\002\000\000\000\003\000\000\000\004\000\000\000\005\000\000\000' > %t.bin
+// RUN: handshake-runner %s binary:%t.bin | FileCheck %s
+// RUN: handshake-runner --precompile %s binary:%t.bin | FileCheck %s
+// RUN: handshake-runner --jit %s binary:%t.bin | FileCheck %s
 // CHECK: 5 5,3,4,5
 
 module {
@@ -1,6 +1,22 @@
 // RUN: handshake-runner %s "(64, 32, 64)" | FileCheck %s
 // CHECK: (128, 32)
 
+// RUN: printf '(64, 32, 64)\n\n(1, 2, 3)\n' > %t.batch
+// RUN: handshake-runner %s --batch=%t.batch | FileCheck %s --check-prefix=BATCH
+// BATCH: (128, 32)
+// BATCH-NEXT: (4, 2)
+
+// RUN: handshake-runner --profile %s "(64, 32, 64)" 2>&1 | FileCheck %s --check-prefix=PROFILE
+// PROFILE: Handshake profile: 3 cycles, 4 firings
+// PROFILE: Channel stalls
+// PROFILE-NEXT: %{{.+}}: 3 total, 3 max over 1 tokens
+// PROFILE-NEXT: %0#1: 1 total, 1 max over 1 tokens
+// PROFILE: Critical path (3 cycles):
+// PROFILE-NEXT: @0 input
+// PROFILE-NEXT: @1 handshake.unpack
+// PROFILE-NEXT: @2 arith.addi
+// PROFILE-NEXT: @3 handshake.pack
+
 module {
   handshake.func @main(%arg0: tuple<i64, i32, i64>, %ctrl: none, ...) -> (tuple<i64, i32>, none) {
     %0, %1, %2 = unpack %arg0 : tuple<i64, i32, i64>
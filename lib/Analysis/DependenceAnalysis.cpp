@@ -20,33 +20,54 @@
 #include "mlir/Dialect/Affine/LoopUtils.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Threading.h"
+#include "llvm/ADT/MapVector.h"
+
+#include <deque>
 
 using namespace mlir;
 using namespace circt::analysis;
 
+namespace {
+/// The memory access and enclosing ops of a memory operation, computed once
+/// per operation rather than once per pair of operations.
+struct MemoryOpInfo {
+  MemoryOpInfo(Operation *op) : op(op), access(op) {
+    getLoopIVs(*op, &enclosingLoops);
+    getEnclosingAffineOps(*op, &enclosingAffineOps);
+  }
+
+  Operation *op;
+  MemRefAccess access;
+  SmallVector<AffineForOp> enclosingLoops;
+  SmallVector<Operation *> enclosingAffineOps;
+};
+} // namespace
+
 /// Helper to iterate through memory operation pairs and check for dependences
-/// at a given loop nesting depth.
-static void checkMemrefDependence(SmallVectorImpl<Operation *> &memoryOps,
+/// at a given loop nesting depth. All of the operations must access the same
+/// memref, and have an entry in `results` already.
+static void checkMemrefDependence(ArrayRef<MemoryOpInfo *> memoryOps,
                                   unsigned depth,
                                   MemoryDependenceResult &results) {
-  for (auto *source : memoryOps) {
-    for (auto *destination : memoryOps) {
-      if (source == destination)
+  for (auto *sourceInfo : memoryOps) {
+    for (auto *destinationInfo : memoryOps) {
+      if (sourceInfo == destinationInfo)
         continue;
-
-      // Initialize the dependence list for this destination.
-      if (results.count(destination) == 0)
-        results[destination] = SmallVector<MemoryDependence>();
+      Operation *source = sourceInfo->op;
+      Operation *destination = destinationInfo->op;
+      SmallVector<MemoryDependence> &destinationDeps =
+          results.find(destination)->second;
 
       // Look for inter-iteration dependences on the same memory location.
-      MemRefAccess src(source);
-      MemRefAccess dst(destination);
+      const MemRefAccess &src = sourceInfo->access;
+      const MemRefAccess &dst = destinationInfo->access;
       FlatAffineValueConstraints dependenceConstraints;
       SmallVector<DependenceComponent, 2> depComps;
       DependenceResult result = checkMemrefAccessDependence(
           src, dst, depth, &dependenceConstraints, &depComps, true);
 
-      results[destination].emplace_back(source, result.value, depComps);
+      destinationDeps.emplace_back(source, result.value, depComps);
 
       // Also consider intra-iteration dependences on the same memory location.
       // This currently does not consider aliasing.
@@ -55,17 +76,14 @@ static void checkMemrefDependence(SmallVectorImpl<Operation *> &memoryOps,
 
       // Collect surrounding loops to use in dependence components. Only proceed
       // if we are in the innermost loop.
-      SmallVector<AffineForOp> enclosingLoops;
-      getLoopIVs(*destination, &enclosingLoops);
+      ArrayRef<AffineForOp> enclosingLoops = destinationInfo->enclosingLoops;
       if (enclosingLoops.size() != depth)
         continue;
 
       // Look for the common parent that src and dst share. If there is none,
       // there is nothing more to do.
-      SmallVector<Operation *> srcParents;
-      getEnclosingAffineOps(*source, &srcParents);
-      SmallVector<Operation *> dstParents;
-      getEnclosingAffineOps(*destination, &dstParents);
+      ArrayRef<Operation *> srcParents = sourceInfo->enclosingAffineOps;
+      ArrayRef<Operation *> dstParents = destinationInfo->enclosingAffineOps;
 
       Operation *commonParent = nullptr;
       for (auto *srcParent : llvm::reverse(srcParents)) {
@@ -112,7 +130,7 @@ static void checkMemrefDependence(SmallVectorImpl<Operation *> &memoryOps,
             intraDeps.push_back(depComp);
           }
 
-          results[destination].emplace_back(
+          destinationDeps.emplace_back(
               source, DependenceResult::HasDependence, intraDeps);
         }
       }
@@ -123,6 +141,10 @@ static void checkMemrefDependence(SmallVectorImpl<Operation *> &memoryOps,
 /// MemoryDependenceAnalysis traverses any AffineForOps in the FuncOp body and
 /// checks for memory access dependences. Results are captured in a
 /// MemoryDependenceResult, which can by queried by Operation.
+///
+/// Only accesses to the same memref can depend on each other, so the memory
+/// operations are bucketed by memref and the buckets are analyzed
+/// independently, in parallel if multithreading is enabled.
 circt::analysis::MemoryDependenceAnalysis::MemoryDependenceAnalysis(
     Operation *op) {
   auto funcOp = cast<func::FuncOp>(op);
@@ -131,16 +153,35 @@ circt::analysis::MemoryDependenceAnalysis::MemoryDependenceAnalysis(
   std::vector<SmallVector<AffineForOp, 2>> depthToLoops;
   mlir::gatherLoops(funcOp, depthToLoops);
 
-  // Collect load and store operations to check.
-  SmallVector<Operation *> memoryOps;
+  // Collect load and store operations to check, and initialize the dependence
+  // list of each of them.
+  std::deque<MemoryOpInfo> memoryOps;
   funcOp.walk([&](Operation *op) {
-    if (isa<AffineReadOpInterface, AffineWriteOpInterface>(op))
-      memoryOps.push_back(op);
+    if (isa<AffineReadOpInterface, AffineWriteOpInterface>(op)) {
+      memoryOps.emplace_back(op);
+      results[op] = SmallVector<MemoryDependence>();
+    }
   });
 
-  // For each depth, check memref accesses.
-  for (unsigned depth = 1, e = depthToLoops.size(); depth <= e; ++depth)
-    checkMemrefDependence(memoryOps, depth, results);
+  // Bucket the operations by the memref they access.
+  llvm::MapVector<Value, SmallVector<MemoryOpInfo *>> memrefToOps;
+  for (MemoryOpInfo &info : memoryOps)
+    memrefToOps[info.access.memref].push_back(&info);
+
+  // The intra-iteration checks compare operation positions, which lazily
+  // computes the operation order of their blocks. Compute it up front so the
+  // buckets only read it.
+  if (funcOp.getContext()->isMultithreadingEnabled())
+    funcOp.walk([](Block *block) { block->recomputeOpOrder(); });
+
+  // For each memref and depth, check memref accesses. Each bucket only updates
+  // the (already existing) dependence lists of its own operations.
+  unsigned numDepths = depthToLoops.size();
+  mlir::parallelForEach(
+      funcOp.getContext(), memrefToOps, [&](auto &memrefOpsPair) {
+        for (unsigned depth = 1; depth <= numDepths; ++depth)
+          checkMemrefDependence(memrefOpsPair.second, depth, results);
+      });
 }
 
 /// Returns the dependences, if any, that the given Operation depends on.
@@ -91,14 +91,18 @@ PYBIND11_MODULE(_circt, m) {
       },
       "Register CIRCT dialects on a PyMlirContext.");
 
+  // The exports release the GIL, such that other Python threads, e.g. building
+  // the IR of another module, can run in the meantime. Writing to the file
+  // object acquires it again.
   m.def("export_verilog", [](MlirModule mod, py::object fileObject) {
     circt::python::PyFileAccumulator accum(fileObject, false);
-    py::gil_scoped_release();
+    py::gil_scoped_release release;
     mlirExportVerilog(mod, accum.getCallback(), accum.getUserData());
   });
 
   m.def("export_split_verilog", [](MlirModule mod, std::string directory) {
     auto cDirectory = mlirStringRefCreateFromCString(directory.c_str());
+    py::gil_scoped_release release;
     mlirExportSplitVerilog(mod, cDirectory);
   });
 
@@ -33,8 +33,8 @@ llvm::DenseMap<std::string *, PyObject *> serviceGenFuncLookup;
 static MlirLogicalResult serviceGenFunc(MlirOperation reqOp,
                                         MlirOperation declOp, void *userData) {
   std::string *name = static_cast<std::string *>(userData);
+  py::gil_scoped_acquire acquire;
   py::handle genFunc(serviceGenFuncLookup[name]);
-  py::gil_scoped_acquire();
   py::object rc = genFunc(reqOp);
   return rc.cast<bool>() ? mlirLogicalResultSuccess()
                          : mlirLogicalResultFailure();
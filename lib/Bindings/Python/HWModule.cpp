@@ -31,6 +31,22 @@ void circt::python::populateDialectHWSubmodule(py::module &m) {
 
   m.def("get_bitwidth", &hwGetBitWidth);
 
+  m.def(
+      "get_array_constant_attr",
+      [](MlirType arrayType, py::buffer buffer) {
+        py::buffer_info info = buffer.request();
+        if (info.ndim != 1 || info.strides[0] != info.itemsize)
+          throw py::value_error("expected a contiguous one-dimensional buffer");
+        MlirAttribute attr = hwArrayConstantAttrGet(
+            arrayType, info.size * info.itemsize, info.ptr);
+        if (mlirAttributeIsNull(attr))
+          throw py::value_error("buffer does not match the array type");
+        return attr;
+      },
+      "Create the value of an 'hw.array_constant' from a buffer in the raw "
+      "storage layout of dense integer attributes.",
+      py::arg("array_type"), py::arg("buffer"));
+
   mlir_type_subclass(m, "InOutType", hwTypeIsAInOut)
       .def_classmethod("get",
                        [](py::object cls, MlirType innerType) {
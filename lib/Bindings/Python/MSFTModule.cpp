@@ -18,6 +18,7 @@
 
 #include "PybindUtils.h"
 #include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 namespace py = pybind11;
@@ -43,6 +44,14 @@ public:
   bool isValidLocation(MlirAttribute loc) {
     return circtMSFTPrimitiveDBIsValidLocation(db, loc);
   }
+  bool save(const std::string &path) {
+    return mlirLogicalResultIsSuccess(circtMSFTPrimitiveDBSave(
+        db, mlirStringRefCreate(path.c_str(), path.size())));
+  }
+  bool load(const std::string &path) {
+    return mlirLogicalResultIsSuccess(circtMSFTPrimitiveDBLoad(
+        db, mlirStringRefCreate(path.c_str(), path.size())));
+  }
 
   CirctMSFTPrimitiveDB db;
 };
@@ -77,6 +86,59 @@ public:
       return py::none();
     return getPhysLocationAttr(nearest);
   }
+
+  /// Integer arrays converted from NumPy arrays or Python sequences.
+  template <typename T>
+  using IntArray = py::array_t<T, py::array::c_style | py::array::forcecast>;
+
+  std::vector<MlirOperation>
+  placeMany(const std::vector<MlirOperation> &instOps,
+            const std::vector<std::string> &subpaths,
+            IntArray<CirctMSFTPrimitiveType> prims, IntArray<uint64_t> xs,
+            IntArray<uint64_t> ys, IntArray<uint64_t> nums,
+            MlirLocation srcLoc) {
+    size_t size = instOps.size();
+    checkSizes(size, {subpaths.size(), size_t(prims.size()),
+                      size_t(xs.size()), size_t(ys.size()),
+                      size_t(nums.size())});
+    std::vector<MlirStringRef> cSubpaths;
+    cSubpaths.reserve(size);
+    for (auto &subpath : subpaths)
+      cSubpaths.push_back(mlirStringRefCreate(subpath.c_str(), subpath.size()));
+    std::vector<MlirOperation> results(size);
+    circtMSFTPlacementDBPlaceMany(db, size, instOps.data(), cSubpaths.data(),
+                                  prims.data(), xs.data(), ys.data(),
+                                  nums.data(), srcLoc, results.data());
+    return results;
+  }
+  std::vector<MlirOperation>
+  getInstancesAt(IntArray<CirctMSFTPrimitiveType> prims, IntArray<uint64_t> xs,
+                 IntArray<uint64_t> ys, IntArray<uint64_t> nums) {
+    size_t size = prims.size();
+    checkSizes(size, {size_t(xs.size()), size_t(ys.size()),
+                      size_t(nums.size())});
+    std::vector<MlirOperation> results(size);
+    circtMSFTPlacementDBGetInstancesAt(db, size, prims.data(), xs.data(),
+                                       ys.data(), nums.data(), results.data());
+    return results;
+  }
+  py::list getNearestFreeInColumns(IntArray<CirctMSFTPrimitiveType> prims,
+                                   IntArray<uint64_t> columns,
+                                   IntArray<uint64_t> nearestToYs) {
+    size_t size = prims.size();
+    checkSizes(size, {size_t(columns.size()), size_t(nearestToYs.size())});
+    std::vector<MlirAttribute> nearest(size);
+    circtMSFTPlacementDBGetNearestFreeInColumns(
+        db, size, prims.data(), columns.data(), nearestToYs.data(),
+        nearest.data());
+    py::list results;
+    for (MlirAttribute attr : nearest)
+      results.append(attr.ptr ? py::reinterpret_steal<py::object>(
+                                    getPhysLocationAttr(attr))
+                              : py::none());
+    return results;
+  }
+
   void walkPlacements(
       py::function pycb,
       std::tuple<py::object, py::object, py::object, py::object> bounds,
@@ -112,6 +174,12 @@ public:
   }
 
 private:
+  static void checkSizes(size_t size, std::initializer_list<size_t> sizes) {
+    for (size_t other : sizes)
+      if (other != size)
+        throw py::value_error("all arguments must have the same length");
+  }
+
   CirctMSFTPlacementDB db;
 };
 
@@ -245,7 +313,12 @@ void circt::python::populateDialectMSFTSubmodule(py::module &m) {
            "Inform the DB about a new placement.", py::arg("loc_and_prim"))
       .def("is_valid_location", &PrimitiveDB::isValidLocation,
            "Query the DB as to whether or not a primitive exists.",
-           py::arg("loc"));
+           py::arg("loc"))
+      .def("save", &PrimitiveDB::save,
+           "Write the primitive locations to a binary file.", py::arg("path"))
+      .def("load", &PrimitiveDB::load,
+           "Add the primitive locations from a file written by 'save'.",
+           py::arg("path"));
 
   py::class_<PlacementDB>(m, "PlacementDB")
       .def(py::init<MlirModule, PrimitiveDB *>(), py::arg("top"),
@@ -265,6 +338,25 @@ void circt::python::populateDialectMSFTSubmodule(py::module &m) {
            "Get the instance at location. Returns None if nothing exists "
            "there. Otherwise, returns (path, subpath, op) of the instance "
            "there.")
+      .def("place_many", &PlacementDB::placeMany,
+           "Place many primitives in one call. Placement 'i' assigns "
+           "'subpaths[i]' of 'dyn_insts[i]' to the location given by the "
+           "i-th elements of the primitive type, x, y and num arrays, which "
+           "may be lists or NumPy arrays. Returns the list of location ops, "
+           "with None for the placements which failed.",
+           py::arg("dyn_insts"), py::arg("subpaths"), py::arg("prim_types"),
+           py::arg("xs"), py::arg("ys"), py::arg("nums"),
+           py::arg("src_location") = py::none())
+      .def("get_instances_at", &PlacementDB::getInstancesAt,
+           "Get the instances at many locations in one call. Returns the list "
+           "of location ops, with None for the unoccupied locations.",
+           py::arg("prim_types"), py::arg("xs"), py::arg("ys"), py::arg("nums"))
+      .def("get_nearest_free_in_columns",
+           &PlacementDB::getNearestFreeInColumns,
+           "Find the nearest free primitive locations in many columns in one "
+           "call. Returns the list of locations, with None for the columns "
+           "without a free location.",
+           py::arg("prim_types"), py::arg("columns"), py::arg("nearest_to_ys"))
       .def("walk_placements", &PlacementDB::walkPlacements,
            "Walk the placements, with possible bounds. Bounds are (xmin, xmax, "
            "ymin, ymax) with 'None' being unbounded.",
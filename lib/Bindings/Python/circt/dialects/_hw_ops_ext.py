@@ -444,6 +444,40 @@ class ArrayCreateOp:
     return hw.ArrayCreateOp(hw.ArrayType.get(type, len(vals)), vals)
 
 
+class ArrayConstantOp:
+
+  @staticmethod
+  def create(element_type, values):
+    """Create a constant array of `element_type` integers from a sequence or a
+    NumPy array of its elements, lowest index first. Values are truncated to the
+    element width. NumPy arrays whose items have the storage size of the element
+    type are handed to the attribute without any per-element conversion."""
+    import numpy as np
+
+    values = np.asarray(values)
+    if values.ndim != 1 or values.size == 0:
+      raise ValueError("Expected a non-empty one-dimensional array")
+    width = element_type.width
+    if width == 1:
+      buffer = np.packbits(values.astype(np.uint8, copy=False),
+                           bitorder="little")
+    elif width <= 64:
+      num_bytes = (width + 7) // 8
+      if num_bytes in (1, 2, 4, 8):
+        buffer = np.ascontiguousarray(
+            values.astype(f"u{num_bytes}", copy=False))
+      else:
+        # There is no NumPy integer type of this size, so drop the upper bytes
+        # of little-endian 64-bit integers.
+        buffer = values.astype("<u8").view(np.uint8).reshape(-1, 8)
+        buffer = np.ascontiguousarray(buffer[:, :num_bytes]).reshape(-1)
+    else:
+      raise ValueError("Elements wider than 64 bits are not supported")
+    array_type = hw.ArrayType.get(element_type, values.size)
+    return hw.ArrayConstantOp(
+        array_type, hw.get_array_constant_attr(array_type, buffer))
+
+
 class ArrayConcatOp:
 
   @staticmethod
@@ -220,3 +220,19 @@ MLIR_CAPI_EXPORTED MlirAttribute hwParamVerbatimAttrGet(MlirAttribute text) {
   auto type = NoneType::get(ctx);
   return wrap(ParamVerbatimAttr::get(ctx, textAttr, type));
 }
+
+MLIR_CAPI_EXPORTED MlirAttribute hwArrayConstantAttrGet(MlirType cArrayType,
+                                                        size_t numBytes,
+                                                        const void *buffer) {
+  auto arrayType = unwrap(cArrayType).cast<ArrayType>();
+  auto elementType = arrayType.getElementType().dyn_cast<IntegerType>();
+  if (!elementType)
+    return {nullptr};
+  auto type =
+      RankedTensorType::get({int64_t(arrayType.getSize())}, elementType);
+  ArrayRef<char> rawBuffer(static_cast<const char *>(buffer), numBytes);
+  bool isSplat;
+  if (!DenseElementsAttr::isValidRawBuffer(type, rawBuffer, isSplat))
+    return {nullptr};
+  return wrap(DenseElementsAttr::getFromRawBuffer(type, rawBuffer));
+}
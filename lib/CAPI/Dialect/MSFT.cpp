@@ -56,6 +56,14 @@ bool circtMSFTPrimitiveDBIsValidLocation(CirctMSFTPrimitiveDB self,
   PhysLocationAttr loc = unwrap(cLoc).cast<PhysLocationAttr>();
   return unwrap(self)->isValidLocation(loc);
 }
+MlirLogicalResult circtMSFTPrimitiveDBSave(CirctMSFTPrimitiveDB self,
+                                           MlirStringRef path) {
+  return wrap(unwrap(self)->save(unwrap(path)));
+}
+MlirLogicalResult circtMSFTPrimitiveDBLoad(CirctMSFTPrimitiveDB self,
+                                           MlirStringRef path) {
+  return wrap(unwrap(self)->load(unwrap(path)));
+}
 
 //===----------------------------------------------------------------------===//
 // PlacementDB.
@@ -122,6 +130,47 @@ MlirAttribute circtMSFTPlacementDBGetNearestFreeInColumn(
                                                  nearestToY));
 }
 
+static PhysLocationAttr getPhysLocation(MLIRContext *ctxt,
+                                        CirctMSFTPrimitiveType prim, uint64_t x,
+                                        uint64_t y, uint64_t num) {
+  return PhysLocationAttr::get(
+      ctxt, PrimitiveTypeAttr::get(ctxt, (PrimitiveType)prim), x, y, num);
+}
+
+void circtMSFTPlacementDBPlaceMany(
+    CirctMSFTPlacementDB db, intptr_t numPlacements, MlirOperation const *insts,
+    MlirStringRef const *subpaths, CirctMSFTPrimitiveType const *prims,
+    uint64_t const *xs, uint64_t const *ys, uint64_t const *nums,
+    MlirLocation csrcLoc, MlirOperation *results) {
+  Location srcLoc = unwrap(csrcLoc);
+  MLIRContext *ctxt = srcLoc.getContext();
+  for (intptr_t i = 0; i < numPlacements; ++i) {
+    auto inst = cast<DynamicInstanceOp>(unwrap(insts[i]));
+    auto loc = getPhysLocation(ctxt, prims[i], xs[i], ys[i], nums[i]);
+    results[i] =
+        wrap(unwrap(db)->place(inst, loc, unwrap(subpaths[i]), srcLoc));
+  }
+}
+void circtMSFTPlacementDBGetInstancesAt(CirctMSFTPlacementDB db,
+                                        intptr_t numLocations,
+                                        CirctMSFTPrimitiveType const *prims,
+                                        uint64_t const *xs, uint64_t const *ys,
+                                        uint64_t const *nums,
+                                        MlirOperation *results) {
+  MLIRContext *ctxt = unwrap(db)->getContext();
+  for (intptr_t i = 0; i < numLocations; ++i)
+    results[i] = wrap(unwrap(db)->getInstanceAt(
+        getPhysLocation(ctxt, prims[i], xs[i], ys[i], nums[i])));
+}
+void circtMSFTPlacementDBGetNearestFreeInColumns(
+    CirctMSFTPlacementDB db, intptr_t numQueries,
+    CirctMSFTPrimitiveType const *prims, uint64_t const *columns,
+    uint64_t const *nearestToYs, MlirAttribute *results) {
+  for (intptr_t i = 0; i < numQueries; ++i)
+    results[i] = wrap(unwrap(db)->getNearestFreeInColumn(
+        (PrimitiveType)prims[i], columns[i], nearestToYs[i]));
+}
+
 /// Walk all the placements within 'bounds' ([xmin, xmax, ymin, ymax], inclusive
 /// on all sides), with -1 meaning unbounded.
 MLIR_CAPI_EXPORTED void circtMSFTPlacementDBWalkPlacements(
@@ -0,0 +1,135 @@
+//===- Firtool.cpp - C Interface to the firtool pipeline ------------------===//
+//
+//  Implements a C Interface for the pass pipeline of firtool.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt-c/Firtool.h"
+
+#include "circt/Dialect/Comb/CombDialect.h"
+#include "circt/Dialect/FIRRTL/CHIRRTLDialect.h"
+#include "circt/Dialect/FIRRTL/FIRRTLDialect.h"
+#include "circt/Dialect/HW/HWDialect.h"
+#include "circt/Dialect/SV/SVDialect.h"
+#include "circt/Dialect/Seq/SeqDialect.h"
+#include "circt/Firtool/Firtool.h"
+#include "mlir/CAPI/IR.h"
+#include "mlir/CAPI/Pass.h"
+#include "mlir/CAPI/Support.h"
+
+using namespace circt;
+
+CirctFirtoolOptions circtFirtoolOptionsGetDefault() {
+  firtool::FirtoolOptions defaults;
+  CirctFirtoolOptions options;
+  options.disableOptimization = defaults.disableOptimization;
+  options.preserveValues = CIRCT_FIRTOOL_PRESERVE_VALUES_NONE;
+  options.preserveAggregate = CIRCT_FIRTOOL_PRESERVE_AGGREGATE_NONE;
+  options.preservePublicTypes = defaults.preservePublicTypes;
+  options.dedup = defaults.dedup;
+  options.disableAnnotationsUnknown = defaults.disableAnnotationsUnknown;
+  options.disableAnnotationsClassless = defaults.disableAnnotationsClassless;
+  options.replSeqMem = defaults.replSeqMem;
+  options.replSeqMemCircuit = mlirStringRefCreate(nullptr, 0);
+  options.replSeqMemFile = mlirStringRefCreate(nullptr, 0);
+  options.ignoreReadEnableMem = defaults.ignoreReadEnableMem;
+  options.lowerMemories = defaults.lowerMemories;
+  options.disableMemRandomization = defaults.disableMemRandomization;
+  options.disableRegRandomization = defaults.disableRegRandomization;
+  options.emitMetadata = defaults.emitMetadata;
+  options.emitOMIR = defaults.emitOMIR;
+  options.omirOutFile = mlirStringRefCreate(nullptr, 0);
+  options.blackBoxRootPath = mlirStringRefCreate(nullptr, 0);
+  options.emitChiselAssertsAsSVA = defaults.emitChiselAssertsAsSVA;
+  options.stripMuxPragmas = defaults.stripMuxPragmas;
+  options.extractTestCode = defaults.extractTestCode;
+  options.stripFirDebugInfo = defaults.stripFirDebugInfo;
+  options.stripDebugInfo = defaults.stripDebugInfo;
+  return options;
+}
+
+/// Convert the C options. `directory` is the output directory.
+static firtool::FirtoolOptions
+getFirtoolOptions(const CirctFirtoolOptions &options, StringRef directory) {
+  firtool::FirtoolOptions opt;
+  opt.disableOptimization = options.disableOptimization;
+  switch (options.preserveValues) {
+  case CIRCT_FIRTOOL_PRESERVE_VALUES_NONE:
+    opt.preserveMode = firrtl::PreserveValues::None;
+    break;
+  case CIRCT_FIRTOOL_PRESERVE_VALUES_NAMED:
+    opt.preserveMode = firrtl::PreserveValues::Named;
+    break;
+  case CIRCT_FIRTOOL_PRESERVE_VALUES_ALL:
+    opt.preserveMode = firrtl::PreserveValues::All;
+    break;
+  }
+  switch (options.preserveAggregate) {
+  case CIRCT_FIRTOOL_PRESERVE_AGGREGATE_NONE:
+    opt.preserveAggregate = firrtl::PreserveAggregate::None;
+    break;
+  case CIRCT_FIRTOOL_PRESERVE_AGGREGATE_1D_VEC:
+    opt.preserveAggregate = firrtl::PreserveAggregate::OneDimVec;
+    break;
+  case CIRCT_FIRTOOL_PRESERVE_AGGREGATE_VEC:
+    opt.preserveAggregate = firrtl::PreserveAggregate::Vec;
+    break;
+  case CIRCT_FIRTOOL_PRESERVE_AGGREGATE_ALL:
+    opt.preserveAggregate = firrtl::PreserveAggregate::All;
+    break;
+  }
+  opt.preservePublicTypes = options.preservePublicTypes;
+  opt.dedup = options.dedup;
+  opt.disableAnnotationsUnknown = options.disableAnnotationsUnknown;
+  opt.disableAnnotationsClassless = options.disableAnnotationsClassless;
+  opt.replSeqMem = options.replSeqMem;
+  opt.replSeqMemCircuit = unwrap(options.replSeqMemCircuit).str();
+  opt.replSeqMemFile = unwrap(options.replSeqMemFile).str();
+  opt.ignoreReadEnableMem = options.ignoreReadEnableMem;
+  opt.lowerMemories = options.lowerMemories;
+  opt.disableMemRandomization = options.disableMemRandomization;
+  opt.disableRegRandomization = options.disableRegRandomization;
+  opt.emitMetadata = options.emitMetadata;
+  opt.emitOMIR = options.emitOMIR;
+  opt.omirOutFile = unwrap(options.omirOutFile).str();
+  opt.blackBoxRootPath = unwrap(options.blackBoxRootPath).str();
+  opt.emitChiselAssertsAsSVA = options.emitChiselAssertsAsSVA;
+  opt.stripMuxPragmas = options.stripMuxPragmas;
+  opt.extractTestCode = options.extractTestCode;
+  opt.stripFirDebugInfo = options.stripFirDebugInfo;
+  opt.stripDebugInfo = options.stripDebugInfo;
+  opt.outputFilename = directory.str();
+  return opt;
+}
+
+void circtFirtoolLoadDialects(MlirContext ctx) {
+  unwrap(ctx)->loadDialect<chirrtl::CHIRRTLDialect, firrtl::FIRRTLDialect,
+                           hw::HWDialect, comb::CombDialect, seq::SeqDialect,
+                           sv::SVDialect>();
+}
+
+MlirLogicalResult circtFirtoolPopulateSplitVerilogPipeline(
+    MlirPassManager pm, MlirModule module, const CirctFirtoolOptions *options,
+    MlirStringRef inputFilename, MlirStringRef directory) {
+  auto &passManager = *unwrap(pm);
+  auto opt = getFirtoolOptions(*options, unwrap(directory));
+  if (failed(firtool::populatePreprocessTransforms(passManager, opt)) ||
+      failed(firtool::populateCHIRRTLToLowFIRRTL(
+          passManager, opt, unwrap(module), unwrap(inputFilename))) ||
+      failed(firtool::populateLowFIRRTLToHW(passManager, opt)) ||
+      failed(firtool::populateHWToSV(passManager, opt)) ||
+      failed(firtool::populateExportSplitVerilog(passManager, opt,
+                                                 unwrap(directory))))
+    return mlirLogicalResultFailure();
+  return mlirLogicalResultSuccess();
+}
+
+MlirLogicalResult circtFirtoolCompileToSplitVerilog(
+    MlirModule module, const CirctFirtoolOptions *options,
+    MlirStringRef inputFilename, MlirStringRef directory) {
+  mlir::PassManager pm(unwrap(module)->getContext());
+  if (mlirLogicalResultIsFailure(circtFirtoolPopulateSplitVerilogPipeline(
+          wrap(&pm), module, options, inputFilename, directory)))
+    return mlirLogicalResultFailure();
+  return wrap(pm.run(unwrap(module)));
+}
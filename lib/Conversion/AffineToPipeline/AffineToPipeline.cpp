@@ -55,7 +55,8 @@ private:
   LogicalResult
   lowerAffineStructures(MemoryDependenceAnalysis &dependenceAnalysis);
   LogicalResult populateOperatorTypes(SmallVectorImpl<AffineForOp> &loopNest);
-  LogicalResult solveSchedulingProblem(SmallVectorImpl<AffineForOp> &loopNest);
+  LogicalResult
+  solveSchedulingProblems(ArrayRef<SmallVector<AffineForOp>> loopNests);
   LogicalResult createPipelinePipeline(SmallVectorImpl<AffineForOp> &loopNest);
 
   CyclicSchedulingAnalysis *schedulingAnalysis;
@@ -74,9 +75,9 @@ void AffineToPipeline::runOnOperation() {
   // Get scheduling analysis for the whole function.
   schedulingAnalysis = &getAnalysis<CyclicSchedulingAnalysis>();
 
-  // Collect perfectly nested loops and work on them.
-  auto outerLoops = getOperation().getOps<AffineForOp>();
-  for (auto root : llvm::make_early_inc_range(outerLoops)) {
+  // Collect perfectly nested loops.
+  SmallVector<SmallVector<AffineForOp>> loopNests;
+  for (auto root : getOperation().getOps<AffineForOp>()) {
     SmallVector<AffineForOp> nestedLoops;
     getPerfectlyNestedLoops(nestedLoops, root);
 
@@ -84,18 +85,22 @@ void AffineToPipeline::runOnOperation() {
     if (nestedLoops.size() != 1)
       continue;
 
-    // Populate the target operator types.
+    loopNests.push_back(std::move(nestedLoops));
+  }
+
+  // Populate the target operator types.
+  for (auto &nestedLoops : loopNests)
     if (failed(populateOperatorTypes(nestedLoops)))
       return signalPassFailure();
 
-    // Solve the scheduling problem computed by the analysis.
-    if (failed(solveSchedulingProblem(nestedLoops)))
-      return signalPassFailure();
+  // Solve the scheduling problems computed by the analysis.
+  if (failed(solveSchedulingProblems(loopNests)))
+    return signalPassFailure();
 
-    // Convert the IR.
+  // Convert the IR.
+  for (auto &nestedLoops : loopNests)
     if (failed(createPipelinePipeline(nestedLoops)))
       return signalPassFailure();
-  }
 }
 
 /// Apply the affine map from an 'affine.load' operation to its operands, and
@@ -289,50 +294,66 @@ LogicalResult AffineToPipeline::populateOperatorTypes(
   return success();
 }
 
-/// Solve the pre-computed scheduling problem.
-LogicalResult AffineToPipeline::solveSchedulingProblem(
-    SmallVectorImpl<AffineForOp> &loopNest) {
-  // Scheduling analyis only considers the innermost loop nest for now.
-  auto forOp = loopNest.back();
+/// Solve the pre-computed scheduling problems. The loops are independent, so
+/// their problems are solved in parallel.
+LogicalResult AffineToPipeline::solveSchedulingProblems(
+    ArrayRef<SmallVector<AffineForOp>> loopNests) {
+  SmallVector<CyclicProblem *> problems;
+  for (auto &loopNest : loopNests) {
+    // Scheduling analyis only considers the innermost loop nest for now.
+    auto forOp = loopNest.back();
+
+    // Retrieve the cyclic scheduling problem for this loop.
+    CyclicProblem &problem = schedulingAnalysis->getProblem(forOp);
+
+    // Optionally debug problem inputs.
+    LLVM_DEBUG(forOp.getBody()->walk<WalkOrder::PreOrder>([&](Operation *op) {
+      llvm::dbgs() << "Scheduling inputs for " << *op;
+      auto opr = problem.getLinkedOperatorType(op);
+      llvm::dbgs() << "\n  opr = " << opr;
+      llvm::dbgs() << "\n  latency = " << problem.getLatency(*opr);
+      for (auto dep : problem.getDependences(op))
+        if (dep.isAuxiliary())
+          llvm::dbgs() << "\n  dep = { distance = " << problem.getDistance(dep)
+                       << ", source = " << *dep.getSource() << " }";
+      llvm::dbgs() << "\n\n";
+    }));
 
-  // Retrieve the cyclic scheduling problem for this loop.
-  CyclicProblem &problem = schedulingAnalysis->getProblem(forOp);
+    // Verify the problem.
+    if (failed(problem.check()))
+      return failure();
 
-  // Optionally debug problem inputs.
-  LLVM_DEBUG(forOp.getBody()->walk<WalkOrder::PreOrder>([&](Operation *op) {
-    llvm::dbgs() << "Scheduling inputs for " << *op;
-    auto opr = problem.getLinkedOperatorType(op);
-    llvm::dbgs() << "\n  opr = " << opr;
-    llvm::dbgs() << "\n  latency = " << problem.getLatency(*opr);
-    for (auto dep : problem.getDependences(op))
-      if (dep.isAuxiliary())
-        llvm::dbgs() << "\n  dep = { distance = " << problem.getDistance(dep)
-                     << ", source = " << *dep.getSource() << " }";
-    llvm::dbgs() << "\n\n";
-  }));
-
-  // Verify and solve the problem.
-  if (failed(problem.check()))
-    return failure();
+    problems.push_back(&problem);
+  }
 
-  auto *anchor = forOp.getBody()->getTerminator();
-  if (failed(scheduleSimplex(problem, anchor)))
+  // Solve the problems. Each problem is contained in its loop, whose
+  // terminator is the anchor.
+  auto solved = scheduleInParallel(
+      &getContext(), ArrayRef<CyclicProblem *>(problems),
+      [](CyclicProblem &problem) {
+        auto forOp = cast<AffineForOp>(problem.getContainingOp());
+        return scheduleSimplex(problem, forOp.getBody()->getTerminator());
+      });
+  if (failed(solved))
     return failure();
 
-  // Verify the solution.
-  if (failed(problem.verify()))
-    return failure();
+  for (auto *problem : problems) {
+    // Verify the solution.
+    if (failed(problem->verify()))
+      return failure();
 
-  // Optionally debug problem outputs.
-  LLVM_DEBUG({
-    llvm::dbgs() << "Scheduled initiation interval = "
-                 << problem.getInitiationInterval() << "\n\n";
-    forOp.getBody()->walk<WalkOrder::PreOrder>([&](Operation *op) {
-      llvm::dbgs() << "Scheduling outputs for " << *op;
-      llvm::dbgs() << "\n  start = " << problem.getStartTime(op);
-      llvm::dbgs() << "\n\n";
+    // Optionally debug problem outputs.
+    LLVM_DEBUG({
+      llvm::dbgs() << "Scheduled initiation interval = "
+                   << problem->getInitiationInterval() << "\n\n";
+      auto forOp = cast<AffineForOp>(problem->getContainingOp());
+      forOp.getBody()->walk<WalkOrder::PreOrder>([&](Operation *op) {
+        llvm::dbgs() << "Scheduling outputs for " << *op;
+        llvm::dbgs() << "\n  start = " << problem->getStartTime(op);
+        llvm::dbgs() << "\n\n";
+      });
     });
-  });
+  }
 
   return success();
 }
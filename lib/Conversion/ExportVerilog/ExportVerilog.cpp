@@ -30,6 +30,7 @@
 #include "circt/Support/LoweringOptions.h"
 #include "circt/Support/Path.h"
 #include "circt/Support/PrettyPrinterHelpers.h"
+#include "circt/Support/TaskTrace.h"
 #include "circt/Support/Version.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
@@ -38,9 +39,12 @@
 #include "mlir/Support/FileUtilities.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SaveAndRestore.h"
 #include "llvm/Support/ToolOutputFile.h"
@@ -875,6 +879,10 @@ public:
   /// Pretty printer.
   PrettyPrinter pp;
 
+  /// Token buffer used by expression emission. Kept here to reuse its
+  /// allocation across all the expressions of the emitted operations.
+  SmallVector<Token> exprTokens;
+
 private:
   VerilogEmitterState(const VerilogEmitterState &) = delete;
   void operator=(const VerilogEmitterState &) = delete;
@@ -1730,8 +1738,8 @@ public:
               SmallPtrSetImpl<Operation *> &emittedExprs,
               ModuleNameManager &names)
       : EmitterBase(emitter.state), emitter(emitter),
-        emittedExprs(emittedExprs), buffer(tokens), ps(buffer, state.saver),
-        names(names) {
+        emittedExprs(emittedExprs), tokens(state.exprTokens), buffer(tokens),
+        ps(buffer, state.saver), names(names) {
     assert(state.pp.getListener() == &state.saver);
   }
 
@@ -1912,6 +1920,7 @@ private:
   SubExprInfo visitTypeOp(ArraySliceOp op);
   SubExprInfo visitTypeOp(ArrayGetOp op);
   SubExprInfo visitTypeOp(ArrayCreateOp op);
+  SubExprInfo visitTypeOp(ArrayConstantOp op);
   SubExprInfo visitTypeOp(ArrayConcatOp op);
   SubExprInfo visitTypeOp(StructCreateOp op);
   SubExprInfo visitTypeOp(StructExtractOp op);
@@ -1994,8 +2003,9 @@ private:
   /// location information tracking.
   SmallPtrSetImpl<Operation *> &emittedExprs;
 
-  /// Tokens buffered for inserting casts/parens after emitting children.
-  SmallVector<Token> tokens;
+  /// Tokens buffered for inserting casts/parens after emitting children. This
+  /// is the emitter state's buffer, which is empty between expressions.
+  SmallVectorImpl<Token> &tokens;
 
   /// Stores tokens until told to flush.  Uses provided buffer (tokens).
   BufferingPP buffer;
@@ -2514,6 +2524,67 @@ SubExprInfo ExprEmitter::visitTypeOp(ArrayCreateOp op) {
   return {Unary, IsUnsigned};
 }
 
+// Emitted like an array_create of constants, with the highest index first.
+SubExprInfo ExprEmitter::visitTypeOp(ArrayConstantOp op) {
+  if (hasSVAttributes(op))
+    emitError(op, "SV attributes emission is unimplemented for the op");
+
+  auto value = op.getValue();
+  unsigned width = value.getElementType().getIntOrFloatBitWidth();
+  if (width == 0) {
+    emitOpError(op, "will not emit zero width constants in the general case");
+    ps << "<<unsupported zero width constant: "
+       << PPExtString(op->getName().getStringRef()) << ">>";
+    return {Unary, IsUnsigned};
+  }
+
+  auto formatElement = [&](const APInt &element, SmallVectorImpl<char> &str) {
+    (Twine(width) + "'h").toVector(str);
+    if (width <= 64) {
+      auto hex = llvm::utohexstr(element.getZExtValue());
+      str.append(hex.begin(), hex.end());
+    } else {
+      element.toStringUnsigned(str, 16);
+    }
+  };
+  if (value.isSplat()) {
+    SmallString<32> element;
+    formatElement(value.getSplatValue<APInt>(), element);
+    ps << "{";
+    ps.addAsString(value.getNumElements());
+    ps << "{" << PPSaveString(element) << "}}";
+    return {Unary, IsUnsigned};
+  }
+
+  // Constant tables such as ROMs can have millions of elements. Format groups
+  // of elements into a single token each, rather than emitting several tokens
+  // per element, such that a broken list has one group of about 60 characters
+  // per line.
+  size_t elementSize =
+      std::to_string(width).size() + 2 + llvm::divideCeil(width, 4);
+  size_t groupSize = std::max<size_t>(1, 60 / (elementSize + 2));
+  auto elements = value.value_begin<APInt>();
+  SmallString<256> group;
+  ps.scopedBox(PP::cbox2, [&]() {
+    ps << "{" << PP::zerobreak;
+    for (size_t end = value.getNumElements(); end != 0;) {
+      size_t begin = end > groupSize ? end - groupSize : 0;
+      group.clear();
+      for (size_t i = end; i != begin; --i) {
+        if (i != end)
+          group += ", ";
+        formatElement(elements[i - 1], group);
+      }
+      if (end != size_t(value.getNumElements()))
+        ps << "," << PP::space;
+      ps << PPSaveString(group);
+      end = begin;
+    }
+    ps << BreakToken(0, -2) << "}";
+  });
+  return {Unary, IsUnsigned};
+}
+
 SubExprInfo ExprEmitter::visitTypeOp(ArrayConcatOp op) {
   if (hasSVAttributes(op))
     emitError(op, "SV attributes emission is unimplemented for the op");
@@ -3985,14 +4056,11 @@ LogicalResult StmtEmitter::visitStmt(InstanceOp op) {
 
   ps << PP::nbsp << PPExtString(names.getName(op)) << " (";
 
-  SmallVector<PortInfo> portInfo = getAllModulePortInfos(op);
-
-  // Get the max port name length so we can align the '('.
-  size_t maxNameLength = 0;
-  for (auto &elt : portInfo) {
-    maxNameLength =
-        std::max(maxNameLength, getPortVerilogName(moduleOp, elt).size());
-  }
+  // The port names and the max port name length, used to align the '(', come
+  // from the port table of the referenced module.
+  auto &portTable = state.shared.getModulePortTable(moduleOp);
+  ArrayRef<PortInfo> portInfo = portTable.ports;
+  size_t maxNameLength = portTable.maxNameLength;
 
   auto getWireForValue = [&](Value result) {
     return result.getUsers().begin()->getOperand(0);
@@ -4049,7 +4117,7 @@ LogicalResult StmtEmitter::visitStmt(InstanceOp op) {
     }
 
     ps.scopedBox(isZeroWidth ? PP::neverbox : PP::ibox2, [&]() {
-      auto portName = getPortVerilogName(moduleOp, elt);
+      auto portName = portTable.verilogNames[portNum];
       ps << "." << PPExtString(portName);
       ps.spaces(maxNameLength - portName.size() + 1);
       ps << "(";
@@ -5111,6 +5179,26 @@ void SharedEmitterState::gatherFiles(bool separateModules) {
   // We've built the whole symbol cache.  Freeze it so things can start
   // querying it (potentially concurrently).
   symbolCache.freeze();
+
+  // Build the port table of each module, so that instances of it don't have
+  // to look up the port names again.
+  SmallVector<Operation *> modules;
+  for (auto &op : *designOp.getBody())
+    if (hw::isAnyModule(&op))
+      modules.push_back(&op);
+  SmallVector<ModulePortTable> tables(modules.size());
+  mlir::parallelFor(designOp.getContext(), 0, modules.size(), [&](size_t i) {
+    auto &table = tables[i];
+    table.ports = getAllModulePortInfos(modules[i]);
+    table.verilogNames.reserve(table.ports.size());
+    for (auto &port : table.ports) {
+      auto name = getPortVerilogName(modules[i], port);
+      table.verilogNames.push_back(name);
+      table.maxNameLength = std::max(table.maxNameLength, name.size());
+    }
+  });
+  for (auto [moduleOp, table] : llvm::zip(modules, tables))
+    modulePortTables.insert({moduleOp, std::move(table)});
 }
 
 /// Given a FileInfo, collect all the replicated and designated operations
@@ -5205,41 +5293,56 @@ void SharedEmitterState::emitOps(EmissionList &thingsToEmit, raw_ostream &os,
     return;
   }
 
-  // If we are parallelizing emission, we emit each independent operation to a
-  // string buffer in parallel, then concat at the end.
-  parallelForEach(context, thingsToEmit, [&](StringOrOpToEmit &stringOrOp) {
-    auto *op = stringOrOp.getOperation();
-    if (!op)
-      return; // Ignore things that are already strings.
+  // If we are parallelizing emission, we emit the independent operations of a
+  // window of entries to string buffers in parallel, then write the window out
+  // and release its buffers before moving on to the next one. This bounds the
+  // output held in memory to a window instead of the entire file.
+  const size_t windowSize = 1024;
+  auto entries = MutableArrayRef<StringOrOpToEmit>(thingsToEmit);
+  for (size_t begin = 0, end = entries.size(); begin < end;
+       begin += windowSize) {
+    auto window = entries.slice(begin, std::min(windowSize, end - begin));
+    parallelForEach(context, window, [&](StringOrOpToEmit &stringOrOp) {
+      auto *op = stringOrOp.getOperation();
+      if (!op)
+        return; // Ignore things that are already strings.
+
+      // BindOp emission reaches into the hw.module of the instance, and that
+      // body may be being transformed by its own emission.  Defer their
+      // emission to the serial phase.  They are speedy to emit anyway.
+      if (isa<BindOp>(op) || modulesContainingBinds.count(op))
+        return;
 
-    // BindOp emission reaches into the hw.module of the instance, and that
-    // body may be being transformed by its own emission.  Defer their
-    // emission to the serial phase.  They are speedy to emit anyway.
-    if (isa<BindOp>(op) || modulesContainingBinds.count(op))
-      return;
+      TaskTraceScope trace("export-verilog", [&] {
+        if (auto name = op->getAttrOfType<StringAttr>(
+                SymbolTable::getSymbolAttrName()))
+          return name.str();
+        return op->getName().getStringRef().str();
+      });
+      SmallString<256> buffer;
+      llvm::raw_svector_ostream tmpStream(buffer);
+      VerilogEmitterState state(designOp, *this, options, symbolCache,
+                                globalNames, tmpStream);
+      emitOperation(state, op);
+      stringOrOp.setString(buffer);
+    });
 
-    SmallString<256> buffer;
-    llvm::raw_svector_ostream tmpStream(buffer);
-    VerilogEmitterState state(designOp, *this, options, symbolCache,
-                              globalNames, tmpStream);
-    emitOperation(state, op);
-    stringOrOp.setString(buffer);
-  });
+    // Emit each entry of the window now that we know it is a string.
+    for (auto &entry : window) {
+      // Almost everything is lowered to a string, just concat the strings onto
+      // the output stream.
+      auto *op = entry.getOperation();
+      if (!op) {
+        os << entry.getStringData();
+        entry.releaseString();
+        continue;
+      }
 
-  // Finally emit each entry now that we know it is a string.
-  for (auto &entry : thingsToEmit) {
-    // Almost everything is lowered to a string, just concat the strings onto
-    // the output stream.
-    auto *op = entry.getOperation();
-    if (!op) {
-      os << entry.getStringData();
-      continue;
+      // If this wasn't emitted to a string (e.g. it is a bind) do so now.
+      VerilogEmitterState state(designOp, *this, options, symbolCache,
+                                globalNames, os);
+      emitOperation(state, op);
     }
-
-    // If this wasn't emitted to a string (e.g. it is a bind) do so now.
-    VerilogEmitterState state(designOp, *this, options, symbolCache,
-                              globalNames, os);
-    emitOperation(state, op);
   }
 }
 
@@ -5329,22 +5432,37 @@ std::unique_ptr<mlir::Pass> circt::createExportVerilogPass() {
 // Split Emitter
 //===----------------------------------------------------------------------===//
 
-static std::unique_ptr<llvm::ToolOutputFile>
-createOutputFile(StringRef fileName, StringRef dirname,
-                 SharedEmitterState &emitter) {
-  // Determine the output path from the output directory and filename.
+/// Determine the output path from the output directory and filename.
+static SmallString<128> getOutputPath(StringRef fileName, StringRef dirname) {
   SmallString<128> outputFilename(dirname);
   appendPossiblyAbsolutePath(outputFilename, fileName);
-  auto outputDir = llvm::sys::path::parent_path(outputFilename);
+  return outputFilename;
+}
 
-  // Create the output directory if needed.
+static LogicalResult createOutputDirectory(StringRef outputDir,
+                                           SharedEmitterState &emitter) {
   std::error_code error = llvm::sys::fs::create_directories(outputDir);
   if (error) {
     emitter.designOp.emitError("cannot create output directory \"")
         << outputDir << "\": " << error.message();
     emitter.encounteredError = true;
-    return {};
+    return failure();
   }
+  return success();
+}
+
+/// Open an output file in `dirname`. If `createDirectory` is false, the
+/// directory containing the file must already exist.
+static std::unique_ptr<llvm::ToolOutputFile>
+createOutputFile(StringRef fileName, StringRef dirname,
+                 SharedEmitterState &emitter, bool createDirectory = true) {
+  auto outputFilename = getOutputPath(fileName, dirname);
+
+  // Create the output directory if needed.
+  if (createDirectory &&
+      failed(createOutputDirectory(
+          llvm::sys::path::parent_path(outputFilename), emitter)))
+    return {};
 
   // Open the output file.
   std::string errorMessage;
@@ -5359,19 +5477,38 @@ createOutputFile(StringRef fileName, StringRef dirname,
 static void createSplitOutputFile(StringAttr fileName, FileInfo &file,
                                   StringRef dirname,
                                   SharedEmitterState &emitter) {
-  auto output = createOutputFile(fileName, dirname, emitter);
-  if (!output)
-    return;
-
   SharedEmitterState::EmissionList list;
   emitter.collectOpsForFile(file, list,
                             emitter.options.emitReplicatedOpsToHeader);
 
-  // Emit the file, copying the global options into the individual module
-  // state.  Don't parallelize emission of the ops within this file - we
-  // already parallelize per-file emission and we pay a string copy overhead
-  // for parallelization.
-  emitter.emitOps(list, output->os(), /*parallelize=*/false);
+  // Emit the file into a buffer, copying the global options into the
+  // individual module state.  Don't parallelize emission of the ops within this
+  // file - we already parallelize per-file emission and we pay a string copy
+  // overhead for parallelization.  The buffer is then written out with a single
+  // write instead of one per stream buffer flush, which matters for designs
+  // split into many small files.
+  std::string contents;
+  {
+    llvm::raw_string_ostream os(contents);
+    emitter.emitOps(list, os, /*parallelize=*/false);
+  }
+
+  // If unchanged files are to be left alone, compare the buffer against the
+  // file on disk before writing anything.
+  if (emitter.options.skipUnchangedFiles) {
+    auto existing = llvm::MemoryBuffer::getFile(
+        getOutputPath(fileName, dirname), /*IsText=*/false,
+        /*RequiresNullTerminator=*/false);
+    if (existing && (*existing)->getBuffer() == contents)
+      return;
+  }
+
+  // The output directories are created up front by the caller.
+  auto output = createOutputFile(fileName, dirname, emitter,
+                                 /*createDirectory=*/false);
+  if (!output)
+    return;
+  output->os() << contents;
   output->keep();
 }
 
@@ -5402,6 +5539,18 @@ static LogicalResult exportSplitVerilogImpl(ModuleOp module,
     }
   }
 
+  // Create the output directories once, rather than checking for them from
+  // every file.
+  llvm::SetVector<StringRef> outputDirs;
+  SmallVector<SmallString<128>> outputPaths;
+  outputPaths.reserve(emitter.files.size());
+  for (auto &it : emitter.files)
+    outputPaths.push_back(getOutputPath(it.first, dirname));
+  for (auto &path : outputPaths)
+    outputDirs.insert(llvm::sys::path::parent_path(path));
+  for (auto outputDir : outputDirs)
+    (void)createOutputDirectory(outputDir, emitter);
+
   // Emit each file in parallel if context enables it.
   parallelForEach(module->getContext(), emitter.files.begin(),
                   emitter.files.end(), [&](auto &it) {
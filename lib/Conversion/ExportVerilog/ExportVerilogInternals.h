@@ -210,6 +210,14 @@ public:
     pointerData = (const void *)data;
   }
 
+  /// Free the string data of the entry once it has been written out, leaving
+  /// an empty entry behind.
+  void releaseString() {
+    if (const void *ptr = pointerData.dyn_cast<const void *>())
+      free(const_cast<void *>(ptr));
+    pointerData = (Operation *)nullptr;
+  }
+
   // These move just fine.
   StringOrOpToEmit(StringOrOpToEmit &&rhs)
       : pointerData(rhs.pointerData), length(rhs.length) {
@@ -225,6 +233,18 @@ private:
 
 /// This class tracks the top-level state for the emitters, which is built and
 /// then shared across all per-file emissions that happen in parallel.
+/// The ports of a module as they are printed at each instance of it.  This is
+/// built once per module at "gatherFiles" time and is immutable afterwards, so
+/// the emitters can read it concurrently.
+struct ModulePortTable {
+  /// The ports of the module, in `getAllModulePortInfos` order.
+  SmallVector<hw::PortInfo> ports;
+  /// The Verilog name of each port, parallel to `ports`.
+  SmallVector<StringRef> verilogNames;
+  /// The length of the longest Verilog port name.
+  size_t maxNameLength = 0;
+};
+
 struct SharedEmitterState {
   /// The MLIR module to emit.
   ModuleOp designOp;
@@ -258,6 +278,16 @@ struct SharedEmitterState {
   /// operations that have a sv.bind in them.
   SmallPtrSet<Operation *, 8> modulesContainingBinds;
 
+  /// The port table of each module, built at "gatherFiles" time.
+  DenseMap<Operation *, ModulePortTable> modulePortTables;
+
+  /// Return the port table of the specified module.
+  const ModulePortTable &getModulePortTable(Operation *module) const {
+    auto it = modulePortTables.find(module);
+    assert(it != modulePortTables.end() && "module without a port table");
+    return it->second;
+  }
+
   /// Information about renamed global symbols, parameters, etc.
   const GlobalNameTable globalNames;
 
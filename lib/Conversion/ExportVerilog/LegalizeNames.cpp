@@ -14,6 +14,7 @@
 #include "ExportVerilogInternals.h"
 #include "circt/Dialect/HW/HWAttributes.h"
 #include "circt/Dialect/HW/HWOps.h"
+#include "mlir/IR/Threading.h"
 
 using namespace circt;
 using namespace sv;
@@ -108,10 +109,18 @@ public:
   GlobalNameTable takeGlobalNameTable() { return std::move(globalNameTable); }
 
 private:
-  /// Check to see if the port names of the specified module conflict with
-  /// keywords or themselves.  If so, add the replacement names to
-  /// globalNameTable.
-  void legalizeModuleNames(HWModuleOp module);
+  /// Check to see if the name of the specified module conflicts with other
+  /// global names or keywords.  If so, set the replacement name on the module.
+  void legalizeModuleName(HWModuleOp module);
+
+  /// Check to see if the port, parameter and value names of the specified
+  /// module conflict with keywords or themselves.  These names are local to the
+  /// module, so this only touches the module itself and can run in parallel.
+  /// Renamed parameters are returned in `renamedParams`, for the caller to add
+  /// them to globalNameTable.
+  static void legalizeModuleLocalNames(
+      HWModuleOp module,
+      SmallVectorImpl<std::pair<StringAttr, StringAttr>> &renamedParams);
   void legalizeInterfaceNames(InterfaceOp interface);
 
   // Gathers prefixes of enum types by inspecting typescopes in the module.
@@ -149,9 +158,11 @@ GlobalNameResolver::GlobalNameResolver(mlir::ModuleOp topLevel) {
   }
 
   // Legalize module and interface names.
+  SmallVector<HWModuleOp> modules;
   for (auto &op : *topLevel.getBody()) {
     if (auto module = dyn_cast<HWModuleOp>(op)) {
-      legalizeModuleNames(module);
+      legalizeModuleName(module);
+      modules.push_back(module);
       continue;
     }
 
@@ -163,6 +174,17 @@ GlobalNameResolver::GlobalNameResolver(mlir::ModuleOp topLevel) {
     }
   }
 
+  // Legalize the names within each module in parallel, then record the renamed
+  // parameters in module order.
+  SmallVector<SmallVector<std::pair<StringAttr, StringAttr>, 0>> renamedParams(
+      modules.size());
+  mlir::parallelFor(topLevel.getContext(), 0, modules.size(), [&](size_t i) {
+    legalizeModuleLocalNames(modules[i], renamedParams[i]);
+  });
+  for (auto [module, params] : llvm::zip(modules, renamedParams))
+    for (auto [oldName, newName] : params)
+      globalNameTable.addRenamedParam(module, oldName, newName.getValue());
+
   // Gather enum prefixes.
   gatherEnumPrefixes(topLevel);
 }
@@ -184,10 +206,9 @@ void GlobalNameResolver::gatherEnumPrefixes(mlir::ModuleOp topLevel) {
   }
 }
 
-/// Check to see if the port names of the specified module conflict with
-/// keywords or themselves.  If so, add the replacement names to
-/// globalNameTable.
-void GlobalNameResolver::legalizeModuleNames(HWModuleOp module) {
+/// Check to see if the name of the specified module conflicts with other global
+/// names or keywords.  If so, set the replacement name on the module.
+void GlobalNameResolver::legalizeModuleName(HWModuleOp module) {
   MLIRContext *ctxt = module.getContext();
   // If the module's symbol itself conflicts, then set a "verilogName" attribute
   // on the module to reflect the name we need to use.
@@ -195,7 +216,15 @@ void GlobalNameResolver::legalizeModuleNames(HWModuleOp module) {
   auto newName = globalNameResolver.getLegalName(oldName);
   if (newName != oldName)
     module->setAttr("verilogName", StringAttr::get(ctxt, newName));
+}
 
+/// Check to see if the port, parameter and value names of the specified module
+/// conflict with keywords or themselves.  If so, set the replacement names on
+/// the ports and declarations, and return the renamed parameters.
+void GlobalNameResolver::legalizeModuleLocalNames(
+    HWModuleOp module,
+    SmallVectorImpl<std::pair<StringAttr, StringAttr>> &renamedParams) {
+  MLIRContext *ctxt = module.getContext();
   NameCollisionResolver nameResolver;
   auto verilogNameAttr = StringAttr::get(ctxt, "hw.verilogName");
   // Legalize the port names.
@@ -217,7 +246,8 @@ void GlobalNameResolver::legalizeModuleNames(HWModuleOp module) {
     auto paramAttr = param.cast<ParamDeclAttr>();
     auto newName = nameResolver.getLegalName(paramAttr.getName());
     if (newName != paramAttr.getName().getValue())
-      globalNameTable.addRenamedParam(module, paramAttr.getName(), newName);
+      renamedParams.push_back(
+          {paramAttr.getName(), StringAttr::get(ctxt, newName)});
   }
 
   SmallVector<std::pair<Operation *, StringAttr>> declAndNames;
@@ -23,6 +23,7 @@
 #include "circt/Dialect/Comb/CombOps.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/CommandLine.h"
@@ -599,6 +600,16 @@ bool EmittedExpressionStateManager::dispatchHeuristic(Operation &op) {
         return true;
     }
 
+  // Expressions with multiple uses which are still inlined are printed at each
+  // of their uses, together with all the terms inlined into them.
+  if (options.isWireSpillingHeuristicEnabled(
+          LoweringOptions::SpillLargeDuplicatedExpressions))
+    if (!op.getResult(0).hasOneUse() &&
+        ExportVerilog::isExpressionEmittedInline(&op) &&
+        getExpressionState(op.getResult(0)).size >=
+            options.wireSpillingDuplicateTermLimit)
+      return true;
+
   return false;
 }
 
@@ -626,6 +637,40 @@ bool EmittedExpressionStateManager::shouldSpillWireBasedOnState(Operation &op) {
   return dispatchHeuristic(op);
 }
 
+/// Merge identical constants wider than 64 bits and spill the ones with multiple
+/// uses to a wire at the beginning of the module. Constants are otherwise
+/// printed at each of their uses.
+static void spillLargeDuplicatedConstants(HWModuleOp module) {
+  SmallVector<ConstantOp> wideConstants;
+  module.walk([&](ConstantOp cst) {
+    if (cst.getValue().getBitWidth() > 64)
+      wideConstants.push_back(cst);
+  });
+
+  Block *body = module.getBodyBlock();
+  llvm::MapVector<Attribute, ConstantOp> leaders;
+  for (auto cst : wideConstants) {
+    auto [it, inserted] = leaders.insert({cst.getValueAttr(), cst});
+    if (inserted)
+      continue;
+    // The uses may live in different regions, so the merged constant has to
+    // be defined at the top level of the module.
+    auto leader = it->second;
+    if (leader->getBlock() != body)
+      leader->moveBefore(&body->front());
+    cst.replaceAllUsesWith(leader.getResult());
+    cst.erase();
+  }
+
+  for (auto &[value, cst] : leaders) {
+    if (cst->use_empty() || cst->hasOneUse())
+      continue;
+    if (cst->getBlock() != body)
+      cst->moveBefore(&body->front());
+    lowerUsersToTemporaryWire(*cst);
+  }
+}
+
 /// After the legalization, we are able to know accurate verilog AST structures.
 /// So this function walks and prettifies verilog IR with a heuristic method
 /// specified by `options.wireSpillingHeuristic` based on the structures.
@@ -958,6 +1003,10 @@ void ExportVerilog::prepareHWModule(hw::HWModuleOp module,
   // Legalization.
   legalizeHWModule(*module.getBodyBlock(), options);
 
+  if (options.isWireSpillingHeuristicEnabled(
+          LoweringOptions::SpillLargeDuplicatedExpressions))
+    spillLargeDuplicatedConstants(module);
+
   EmittedExpressionStateManager expressionStateManager(options);
   // Spill wires to prettify verilog outputs.
   prettifyAfterLegalization(*module.getBodyBlock(), expressionStateManager);
@@ -29,6 +29,8 @@
 #include "circt/Dialect/Seq/SeqOps.h"
 #include "circt/Support/BackedgeBuilder.h"
 #include "circt/Support/Namespace.h"
+#include "circt/Support/ParallelSchedule.h"
+#include "circt/Support/TaskTrace.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
@@ -38,6 +40,8 @@
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/Parallel.h"
+#include "llvm/Support/Process.h"
+#include <mutex>
 
 using namespace circt;
 using namespace firrtl;
@@ -454,6 +458,8 @@ struct FIRRTLModuleLowering : public LowerFIRRTLToHWBase<FIRRTLModuleLowering> {
   void setEnableAnnotationWarning() { enableAnnotationWarning = true; }
   void setEmitChiselAssertAsSVA() { emitChiselAssertsAsSVA = true; }
   void setStripMuxPragmas() { stripMuxPragmas = true; }
+  void setLowMemory() { lowMemory = true; }
+  void setMaxMemory(uint64_t mebibytes) { maxMemory = mebibytes; }
 
 private:
   void lowerFileHeader(CircuitOp op, CircuitLoweringState &loweringState);
@@ -474,6 +480,10 @@ private:
 
   LogicalResult lowerModuleBody(FModuleOp oldModule,
                                 CircuitLoweringState &loweringState);
+  LogicalResult lowerModuleBodies(ArrayRef<FModuleOp> modules,
+                                  CircuitLoweringState &loweringState);
+  LogicalResult lowerModuleBodiesInOrder(ArrayRef<FModuleOp> modules,
+                                         CircuitLoweringState &loweringState);
   LogicalResult lowerModuleOperations(hw::HWModuleOp module,
                                       CircuitLoweringState &loweringState);
 
@@ -487,7 +497,7 @@ private:
 std::unique_ptr<mlir::Pass> circt::createLowerFIRRTLToHWPass(
     bool enableAnnotationWarning, bool emitChiselAssertsAsSVA,
     bool stripMuxPragmas, bool disableMemRandomization,
-    bool disableRegRandomization) {
+    bool disableRegRandomization, bool lowMemory, uint64_t maxMemory) {
   auto pass = std::make_unique<FIRRTLModuleLowering>();
   if (enableAnnotationWarning)
     pass->setEnableAnnotationWarning();
@@ -499,6 +509,10 @@ std::unique_ptr<mlir::Pass> circt::createLowerFIRRTLToHWPass(
     pass->setDisableMemRandomization();
   if (disableRegRandomization)
     pass->setDisableRegRandomization();
+  if (lowMemory)
+    pass->setLowMemory();
+  if (maxMemory)
+    pass->setMaxMemory(maxMemory);
   return pass;
 }
 
@@ -529,6 +543,7 @@ void FIRRTLModuleLowering::runOnOperation() {
       &getAnalysis<InstanceGraph>(), &getAnalysis<NLATable>());
 
   SmallVector<FModuleOp, 32> modulesToProcess;
+  SmallVector<HierPathOp> hierPaths;
 
   AnnotationSet circuitAnno(circuit);
   moveVerifAnno(getOperation(), circuitAnno, extractAssertAnnoClass,
@@ -576,6 +591,7 @@ void FIRRTLModuleLowering::runOnOperation() {
         })
         .Case<HierPathOp>([&](auto nla) {
           // Just drop it.
+          hierPaths.push_back(nla);
         })
         .Default([&](Operation *op) {
           // We don't know what this op is.  If it has no illegal FIRRTL types,
@@ -587,6 +603,12 @@ void FIRRTLModuleLowering::runOnOperation() {
             return signalPassFailure();
         });
   }
+
+  // Hierarchical paths are only consulted while lowering ports.
+  if (lowMemory)
+    for (auto hierPath : hierPaths)
+      hierPath.erase();
+
   // Handle the creation of the module hierarchy metadata.
 
   // Collect the two sets of hierarchy files from the circuit. Some of them will
@@ -665,14 +687,10 @@ void FIRRTLModuleLowering::runOnOperation() {
     lowerMemoryDecls(memories, state);
 
   // Now that we've lowered all of the modules, move the bodies over and
-  // update any instances that refer to the old modules.
-  auto result = mlir::failableParallelForEachN(
-      &getContext(), 0, modulesToProcess.size(), [&](auto index) {
-        return lowerModuleBody(modulesToProcess[index], state);
-      });
-
-  // If any module bodies failed to lower, return early.
-  if (failed(result))
+  // update any instances that refer to the old modules.  If any module bodies
+  // failed to lower, return early.
+  if (failed(lowMemory ? lowerModuleBodiesInOrder(modulesToProcess, state)
+                       : lowerModuleBodies(modulesToProcess, state)))
     return signalPassFailure();
 
   // Move binds from inside modules to outside modules.
@@ -691,6 +709,76 @@ void FIRRTLModuleLowering::runOnOperation() {
   circuit.erase();
 }
 
+/// Lower the bodies of the given modules in parallel.  While the heap use is
+/// within a tenth of `maxMemory`, the bodies are lowered one at a time, since
+/// every body in flight briefly holds both its FIRRTL and its HW operations.
+/// The largest bodies are lowered first.
+LogicalResult
+FIRRTLModuleLowering::lowerModuleBodies(ArrayRef<FModuleOp> moduleList,
+                                        CircuitLoweringState &state) {
+  uint64_t threshold = maxMemory * 1024 * 1024;
+  threshold -= threshold / 10;
+  SmallVector<FModuleOp> modules(moduleList.begin(), moduleList.end());
+  sortByEstimatedWork<FModuleOp>(&getContext(), modules);
+  std::mutex serialLoweringMutex;
+  return mlir::failableParallelForEachN(
+      &getContext(), 0, modules.size(), [&](auto index) {
+        if (threshold && llvm::sys::Process::GetMallocUsage() >= threshold) {
+          std::lock_guard<std::mutex> lock(serialLoweringMutex);
+          return lowerModuleBody(modules[index], state);
+        }
+        return lowerModuleBody(modules[index], state);
+      });
+}
+
+/// Lower the bodies of the given modules one at a time, top-down in the
+/// instance hierarchy, such that at most one module holds both FIRRTL and HW
+/// operations.  A FIRRTL module is erased as soon as its body and the bodies of
+/// all modules instantiating it are lowered.
+LogicalResult
+FIRRTLModuleLowering::lowerModuleBodiesInOrder(ArrayRef<FModuleOp> modules,
+                                               CircuitLoweringState &state) {
+  auto *instanceGraph = state.getInstanceGraph();
+
+  // Count the instances of each module in bodies that are not lowered yet.
+  DenseMap<Operation *, unsigned> pendingInstances;
+  for (auto *node : *instanceGraph)
+    for (auto *record : *node)
+      ++pendingInstances[record->getTarget()->getModule().getOperation()];
+
+  auto eraseModule = [&](Operation *module) {
+    state.oldToNewModuleMap.erase(module);
+    module->erase();
+  };
+
+  // Lower the modules once all of their instantiating modules are lowered.
+  DenseSet<Operation *> toLower;
+  SmallVector<FModuleOp> worklist;
+  for (auto module : modules) {
+    toLower.insert(module);
+    if (!pendingInstances.lookup(module))
+      worklist.push_back(module);
+  }
+  while (!worklist.empty()) {
+    auto module = worklist.pop_back_val();
+    auto *node = instanceGraph->lookup(module);
+    if (failed(lowerModuleBody(module, state)))
+      return failure();
+
+    for (auto *record : *node) {
+      auto *target = record->getTarget()->getModule().getOperation();
+      if (--pendingInstances[target])
+        continue;
+      if (toLower.contains(target))
+        worklist.push_back(cast<FModuleOp>(target));
+      else
+        eraseModule(target);
+    }
+    eraseModule(module);
+  }
+  return success();
+}
+
 void FIRRTLModuleLowering::lowerMemoryDecls(ArrayRef<FirMemory> mems,
                                             CircuitLoweringState &state) {
   assert(!mems.empty());
@@ -710,8 +798,17 @@ void FIRRTLModuleLowering::lowerMemoryDecls(ArrayRef<FirMemory> mems,
 
   Type b1Type = IntegerType::get(&getContext(), 1);
 
-  for (auto &mem : mems) {
+  // The ports and parameters of a memory wrapper only depend on the memory, so
+  // build them in parallel. The wrapper names and modules are then created in
+  // order below.
+  struct MemoryWrapperInfo {
     SmallVector<hw::PortInfo> ports;
+    SmallVector<NamedAttribute, 11> genAttrs;
+  };
+  SmallVector<MemoryWrapperInfo> wrappers(mems.size());
+  mlir::parallelFor(&getContext(), 0, mems.size(), [&](size_t index) {
+    auto &mem = mems[index];
+    auto &ports = wrappers[index].ports;
     size_t inputPin = 0;
     size_t outputPin = 0;
     // We don't need a single bit mask, it can be combined with enable. Create
@@ -781,7 +878,10 @@ void FIRRTLModuleLowering::lowerMemoryDecls(ArrayRef<FirMemory> mems,
         b.getNamedAttr("writeUnderWrite",
                        hw::WUWAttr::get(b.getContext(), mem.writeUnderWrite)),
         b.getNamedAttr("writeClockIDs", b.getI32ArrayAttr(mem.writeClockIDs))};
+    wrappers[index].genAttrs.append(std::begin(genAttrs), std::end(genAttrs));
+  });
 
+  for (auto [mem, wrapper] : llvm::zip(mems, wrappers)) {
     // Make the global module for the memory
     // Set a name for the memory wrapper module, the combMem is an arbitrary
     // suffix. It is important to derive the name from the original MemOp name,
@@ -794,8 +894,8 @@ void FIRRTLModuleLowering::lowerMemoryDecls(ArrayRef<FirMemory> mems,
     // used for all the deduped memories.
     state.memoryNameMap[mem.getFirMemoryName()] = memoryName;
     auto genOp = b.create<hw::HWModuleGeneratedOp>(
-        mem.loc, memorySchema, memoryName, ports, StringRef(), ArrayAttr(),
-        genAttrs);
+        mem.loc, memorySchema, memoryName, wrapper.ports, StringRef(),
+        ArrayAttr(), wrapper.genAttrs);
     // Also set the appropriate directory.
     if (!mem.isInDut)
       if (auto testBenchDir = state.getTestBenchDirectory())
@@ -1358,6 +1458,8 @@ static SmallVector<SubfieldOp> getAllFieldAccesses(Value structValue,
 LogicalResult
 FIRRTLModuleLowering::lowerModuleBody(FModuleOp oldModule,
                                       CircuitLoweringState &loweringState) {
+  TaskTraceScope trace("lower-firrtl-to-hw",
+                       [&] { return oldModule.getName().str(); });
   auto newModule =
       dyn_cast_or_null<hw::HWModuleOp>(loweringState.getNewModule(oldModule));
   // Don't touch modules if we failed to lower ports.
@@ -2236,12 +2338,22 @@ template <typename ResultOpType, typename... CtorArgTypes>
 LogicalResult FIRRTLLowering::setLoweringTo(Operation *orig,
                                             CtorArgTypes... args) {
   auto result = builder.createOrFold<ResultOpType>(args...);
-  if (auto debugAttr = orig->getAttr("hw.debug.name")) {
-    auto *op = result.getDefiningOp();
-    op->setAttr("hw.debug.name", debugAttr);
+  if (auto *op = result.getDefiningOp()) {
+    // Copy the debug name and the name hint together, so that the attribute
+    // dictionary of the new op is rebuilt at most once.
+    auto debugAttr = orig->getAttr("hw.debug.name");
+    auto nameAttr = orig->getAttrOfType<StringAttr>("name");
+    bool copyName =
+        nameAttr && !op->hasAttr("sv.namehint") && !op->hasAttr("name");
+    if (debugAttr || copyName) {
+      NamedAttrList attrs(op->getAttrDictionary());
+      if (debugAttr)
+        attrs.set("hw.debug.name", debugAttr);
+      if (copyName)
+        attrs.set("sv.namehint", nameAttr);
+      op->setAttrs(attrs.getDictionary(op->getContext()));
+    }
   }
-  if (auto *op = result.getDefiningOp())
-    tryCopyName(op, orig);
   return setPossiblyFoldedLowering(orig->getResult(0), result);
 }
 
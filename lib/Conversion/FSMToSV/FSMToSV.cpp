@@ -15,6 +15,7 @@
 #include "circt/Dialect/Seq/SeqOps.h"
 #include "circt/Support/BackedgeBuilder.h"
 #include "mlir/Transforms/RegionUtils.h"
+#include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/TypeSwitch.h"
 
 #include <memory>
@@ -82,6 +83,16 @@ static void cloneConstantsIntoRegion(Region &region, OpBuilder &builder) {
 
 namespace {
 
+// The ways in which the states of a machine can be encoded.
+enum class EncodingKind {
+  // A typedecl'd enum per machine, leaving the encoding to the tools.
+  Enum,
+  // Integers numbering the states in the order in which they are defined.
+  Binary,
+  // One bit per state, such that every case only needs to test a single bit.
+  OneHot
+};
+
 class StateEncoding {
   // An class for handling state encoding. The class is designed to
   // abstract away how states are selected in case patterns, referred to as
@@ -89,7 +100,7 @@ class StateEncoding {
 
 public:
   StateEncoding(OpBuilder &b, hw::TypeScopeOp typeScope, MachineOp machine,
-                hw::HWModuleOp hwModule);
+                hw::HWModuleOp hwModule, EncodingKind kind);
 
   // Get the encoded value for a state.
   Value encode(StateOp state);
@@ -99,9 +110,18 @@ public:
   // Returns the type which encodes the state values.
   Type getStateType() { return stateType; }
 
+  // Returns true if the value is the encoding of a state.
+  bool isEncodedState(Value value) { return valueToState.count(value); }
+
   // Returns a case pattern which matches the provided state.
   std::unique_ptr<sv::CasePattern> getCasePattern(StateOp state);
 
+  // Returns the kind of case statement to use with the case patterns.
+  CaseStmtType getCaseStmtType() {
+    return kind == EncodingKind::OneHot ? CaseStmtType::CaseZStmt
+                                        : CaseStmtType::CaseStmt;
+  }
+
 protected:
   // Creates a constant value in the module for the given encoded state
   // and records the state value in the mappings. An inner symbol is
@@ -126,15 +146,41 @@ protected:
   // The enum type for the states.
   Type stateType;
 
+  // How the states are encoded.
+  EncodingKind kind;
+
   OpBuilder &b;
   MachineOp machine;
   hw::HWModuleOp hwModule;
 };
 
 StateEncoding::StateEncoding(OpBuilder &b, hw::TypeScopeOp typeScope,
-                             MachineOp machine, hw::HWModuleOp hwModule)
-    : typeScope(typeScope), b(b), machine(machine), hwModule(hwModule) {
+                             MachineOp machine, hw::HWModuleOp hwModule,
+                             EncodingKind kind)
+    : typeScope(typeScope), kind(kind), b(b), machine(machine),
+      hwModule(hwModule) {
   Location loc = machine.getLoc();
+  if (kind != EncodingKind::Enum) {
+    // Create integer constants for the states, numbered in order of their
+    // definition.
+    size_t numStates = machine.getNumStates();
+    unsigned width = kind == EncodingKind::OneHot
+                         ? numStates
+                         : llvm::Log2_64_Ceil(numStates);
+    stateType = b.getIntegerType(width);
+
+    OpBuilder::InsertionGuard guard(b);
+    b.setInsertionPointToStart(&hwModule.getBody().front());
+    for (auto it : llvm::enumerate(machine.getBody().getOps<StateOp>())) {
+      APInt value = kind == EncodingKind::OneHot
+                        ? APInt::getOneBitSet(width, it.index())
+                        : APInt(width, it.index());
+      setEncoding(it.value(), b.create<hw::ConstantOp>(loc, value),
+                  /*wire=*/true);
+    }
+    return;
+  }
+
   llvm::SmallVector<Attribute> stateNames;
 
   for (auto state : machine.getBody().getOps<StateOp>())
@@ -182,6 +228,22 @@ StateOp StateEncoding::decode(Value value) {
 
 // Returns a case pattern which matches the provided state.
 std::unique_ptr<sv::CasePattern> StateEncoding::getCasePattern(StateOp state) {
+  if (kind != EncodingKind::Enum) {
+    APInt value =
+        cast<hw::ConstantOp>(valueToSrcValue[encode(state)].getDefiningOp())
+            .getValue();
+    if (kind == EncodingKind::Binary)
+      return std::make_unique<sv::CaseBitPattern>(value, b.getContext());
+
+    // Only test the hot bit of the state in the casez statement; the other
+    // bits are don't-cares.
+    SmallVector<sv::CasePatternBit> bits;
+    for (unsigned i = 0, e = value.getBitWidth(); i != e; ++i)
+      bits.push_back(value[i] ? sv::CasePatternBit::One
+                              : sv::CasePatternBit::AnyZ);
+    return std::make_unique<sv::CaseBitPattern>(bits, b.getContext());
+  }
+
   // Get the field attribute for the state - fetch it through the encoding.
   auto fieldAttr =
       cast<hw::EnumConstantOp>(valueToSrcValue[encode(state)].getDefiningOp())
@@ -212,8 +274,9 @@ void StateEncoding::setEncoding(StateOp state, Value v, bool wire) {
 class MachineOpConverter {
 public:
   MachineOpConverter(OpBuilder &builder, hw::TypeScopeOp typeScope,
-                     MachineOp machineOp)
-      : machineOp(machineOp), typeScope(typeScope), b(builder) {}
+                     MachineOp machineOp, EncodingKind encodingKind)
+      : machineOp(machineOp), typeScope(typeScope),
+        encodingKind(encodingKind), b(builder) {}
 
   // Converts the machine op to a hardware module.
   // 1. Creates a HWModuleOp for the machine op, with the same I/O as the FSM +
@@ -320,6 +383,9 @@ private:
   // A typescope to emit the FSM enum type within.
   hw::TypeScopeOp typeScope;
 
+  // How the states of the machine are encoded.
+  EncodingKind encodingKind;
+
   OpBuilder &b;
 };
 
@@ -365,7 +431,7 @@ void MachineOpConverter::buildStateCaseMux(
 
   // Case assignments.
   caseMux = b.create<sv::CaseOp>(
-      machineOp.getLoc(), CaseStmtType::CaseStmt, select,
+      machineOp.getLoc(), encoding->getCaseStmtType(), select,
       /*numCases=*/machineOp.getNumStates(), [&](size_t caseIdx) {
         StateOp state = orderedStates[caseIdx];
         return encoding->getCasePattern(state);
@@ -422,8 +488,8 @@ LogicalResult MachineOpConverter::dispatch() {
   auto reset = hwModuleOp.front().getArgument(clkRstIdxs.resetIdx);
 
   // 2) Build state and variable registers.
-  encoding =
-      std::make_unique<StateEncoding>(b, typeScope, machineOp, hwModuleOp);
+  encoding = std::make_unique<StateEncoding>(b, typeScope, machineOp,
+                                             hwModuleOp, encodingKind);
   auto stateType = encoding->getStateType();
 
   auto nextStateWire =
@@ -534,10 +600,31 @@ LogicalResult MachineOpConverter::dispatch() {
     }
   }
 
+  // If no state has a guarded transition, the next state only depends on the
+  // current one. With a binary encoding, the states then index a table of
+  // their successors, rather than being decoded by the case statement.
+  Value nextStateTable;
+  if (encodingKind == EncodingKind::Binary &&
+      llvm::all_of(orderedStates, [&](StateOp state) {
+        return encoding->isEncodedState(stateConvResults[state].nextState);
+      })) {
+    // The first operand of an array_create is its last element.
+    SmallVector<Value> table;
+    for (auto state : llvm::reverse(orderedStates))
+      table.push_back(stateConvResults[state].nextState);
+    // Pad the table to the size addressable by the state register.
+    size_t tableSize = size_t(1) << stateType.getIntOrFloatBitWidth();
+    table.insert(table.begin(), tableSize - table.size(),
+                 encoding->encode(machineOp.getInitialStateOp()));
+    nextStateTable = b.create<hw::ArrayGetOp>(
+        loc, b.create<hw::ArrayCreateOp>(loc, table), stateReg);
+  }
+
   // Materialize the case mux.
   llvm::SmallVector<CaseMuxItem, 4> nextStateCaseAssignments;
-  nextStateCaseAssignments.push_back(
-      CaseMuxItem{nextStateWire, stateReg, nextStateFromState});
+  if (!nextStateTable)
+    nextStateCaseAssignments.push_back(
+        CaseMuxItem{nextStateWire, stateReg, nextStateFromState});
   for (auto &[_, caseMuxItem] : variableCaseMuxItems)
     nextStateCaseAssignments.push_back(caseMuxItem);
   nextStateCaseAssignments.append(outputCaseAssignments.begin(),
@@ -547,7 +634,10 @@ LogicalResult MachineOpConverter::dispatch() {
     auto alwaysCombOp = b.create<sv::AlwaysCombOp>(loc);
     OpBuilder::InsertionGuard g(b);
     b.setInsertionPointToStart(alwaysCombOp.getBodyBlock());
-    buildStateCaseMux(nextStateCaseAssignments);
+    if (nextStateTable)
+      b.create<sv::BPAssignOp>(loc, nextStateWire, nextStateTable);
+    if (!nextStateCaseAssignments.empty())
+      buildStateCaseMux(nextStateCaseAssignments);
   }
 
   // Replace variable values with their register counterparts.
@@ -664,6 +754,16 @@ void FSMToSVPass::runOnOperation() {
   auto b = OpBuilder(module);
   SmallVector<Operation *, 16> opToErase;
 
+  auto encodingKind = llvm::StringSwitch<Optional<EncodingKind>>(stateEncoding)
+                          .Case("enum", EncodingKind::Enum)
+                          .Case("binary", EncodingKind::Binary)
+                          .Case("one-hot", EncodingKind::OneHot)
+                          .Default(llvm::None);
+  if (!encodingKind) {
+    module.emitError() << "unknown state encoding '" << stateEncoding << "'";
+    return signalPassFailure();
+  }
+
   // Create a typescope shared by all of the FSMs. This typescope will be
   // emitted in a single separate file to avoid polluting each output file with
   // typedefs.
@@ -680,7 +780,7 @@ void FSMToSVPass::runOnOperation() {
 
   // Traverse all machines and convert.
   for (auto machine : llvm::make_early_inc_range(module.getOps<MachineOp>())) {
-    MachineOpConverter converter(b, typeScope, machine);
+    MachineOpConverter converter(b, typeScope, machine, *encodingKind);
 
     if (failed(converter.dispatch())) {
       signalPassFailure();
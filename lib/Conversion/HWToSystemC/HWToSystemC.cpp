@@ -13,11 +13,15 @@
 #include "circt/Conversion/HWToSystemC.h"
 #include "../PassDetail.h"
 #include "circt/Dialect/Comb/CombDialect.h"
+#include "circt/Dialect/Comb/CombOps.h"
 #include "circt/Dialect/HW/HWOps.h"
+#include "circt/Dialect/Seq/SeqOps.h"
 #include "circt/Dialect/SystemC/SystemCOps.h"
+#include "circt/Support/Namespace.h"
 #include "mlir/Dialect/EmitC/IR/EmitC.h"
 #include "mlir/IR/BuiltinDialect.h"
 #include "mlir/Transforms/DialectConversion.h"
+#include "mlir/Transforms/TopologicalSortUtils.h"
 #include "llvm/ADT/TypeSwitch.h"
 
 using namespace mlir;
@@ -35,8 +39,15 @@ namespace {
 /// the body of the module into the new SystemC module by splitting up the body
 /// into field declarations, initializations done in a newly added systemc.ctor,
 /// and internal methods to be registered in the constructor.
+///
+/// For a cycle-based model, the body is moved into an `eval` member function
+/// instead, which is not registered as an SC_METHOD but called by the user
+/// once per clock edge. Registers become plain member variables, which `eval`
+/// updates after computing the outputs in topological order.
 struct ConvertHWModule : public OpConversionPattern<HWModuleOp> {
-  using OpConversionPattern::OpConversionPattern;
+  ConvertHWModule(TypeConverter &typeConverter, MLIRContext *context,
+                  bool cycleBased)
+      : OpConversionPattern(typeConverter, context), cycleBased(cycleBased) {}
 
   LogicalResult
   matchAndRewrite(HWModuleOp module, OpAdaptor adaptor,
@@ -49,6 +60,23 @@ struct ConvertHWModule : public OpConversionPattern<HWModuleOp> {
                      [](auto port) { return port.isInOut(); }))
       return emitError(module->getLoc(), "inout arguments not supported yet");
 
+    // Collect the registers of a cycle-based model. All of them are updated by
+    // one call to `eval`, so they must share a clock.
+    SmallVector<seq::CompRegOp> regs;
+    if (cycleBased) {
+      Value clock;
+      for (auto reg : module.getBodyBlock()->getOps<seq::CompRegOp>()) {
+        if (clock && reg.getClk() != clock)
+          return emitError(reg.getLoc(),
+                           "cycle-based models support only a single clock");
+        clock = reg.getClk();
+        regs.push_back(reg);
+      }
+      if (!module.getBodyBlock()->getOps<InstanceOp>().empty())
+        return emitError(module->getLoc(),
+                         "instances not supported in cycle-based models yet");
+    }
+
     // Create the SystemC module.
     SmallVector<PortInfo> ports = module.getAllPorts();
     for (size_t i = 0; i < ports.size(); ++i)
@@ -73,9 +101,24 @@ struct ConvertHWModule : public OpConversionPattern<HWModuleOp> {
 
     // Create a systemc.func operation inside the module after the ctor.
     // TODO: implement logic to extract a better name and properly unique it.
+    StringRef funcName = cycleBased ? "eval" : "innerLogic";
     rewriter.setInsertionPointToStart(scModule.getBodyBlock());
-    auto scFunc = rewriter.create<SCFuncOp>(
-        module.getLoc(), rewriter.getStringAttr("innerLogic"));
+    auto scFunc = rewriter.create<SCFuncOp>(module.getLoc(),
+                                            rewriter.getStringAttr(funcName));
+
+    // Declare a member variable for every register of a cycle-based model.
+    Namespace names;
+    for (auto &port : ports)
+      names.newName(port.name.getValue());
+    names.newName(funcName);
+    SmallVector<Value> regMembers;
+    rewriter.setInsertionPoint(scFunc);
+    for (auto reg : regs) {
+      StringRef name = reg.getName().empty() ? "reg" : reg.getName();
+      regMembers.push_back(rewriter.create<VariableOp>(
+          reg.getLoc(), typeConverter->convertType(reg.getType()),
+          rewriter.getStringAttr(names.newName(name)), Value()));
+    }
 
     // Inline the HW module body into the systemc.func body.
     // TODO: do some dominance analysis to detect use-before-def and cycles in
@@ -85,18 +128,21 @@ struct ConvertHWModule : public OpConversionPattern<HWModuleOp> {
     Region &scFuncBody = scFunc.getBody();
     rewriter.inlineRegionBefore(module.getBody(), scFuncBody, scFuncBody.end());
 
-    // Register the systemc.func inside the systemc.ctor
-    rewriter.setInsertionPointToStart(
-        scModule.getOrCreateCtor().getBodyBlock());
-    rewriter.create<MethodOp>(scModule.getLoc(), scFunc.getHandle());
-
-    // Register the sensitivities of above SC_METHOD registration.
-    SmallVector<Value> sensitivityValues(
-        llvm::make_filter_range(scModule.getArguments(), [](BlockArgument arg) {
-          return !arg.getType().isa<OutputType>();
-        }));
-    if (!sensitivityValues.empty())
-      rewriter.create<SensitiveOp>(scModule.getLoc(), sensitivityValues);
+    // Register the systemc.func inside the systemc.ctor, unless the model is
+    // cycle-based.
+    if (!cycleBased) {
+      rewriter.setInsertionPointToStart(
+          scModule.getOrCreateCtor().getBodyBlock());
+      rewriter.create<MethodOp>(scModule.getLoc(), scFunc.getHandle());
+
+      // Register the sensitivities of above SC_METHOD registration.
+      SmallVector<Value> sensitivityValues(llvm::make_filter_range(
+          scModule.getArguments(), [](BlockArgument arg) {
+            return !arg.getType().isa<OutputType>();
+          }));
+      if (!sensitivityValues.empty())
+        rewriter.create<SensitiveOp>(scModule.getLoc(), sensitivityValues);
+    }
 
     // Move the block arguments of the systemc.func (that we got from the
     // hw.module) to the systemc.module
@@ -112,6 +158,22 @@ struct ConvertHWModule : public OpConversionPattern<HWModuleOp> {
       scFuncBody.eraseArgument(0);
     }
 
+    if (cycleBased) {
+      // Read the current values of the registers.
+      for (auto [reg, member] : llvm::zip(regs, regMembers))
+        reg.getResult().replaceAllUsesWith(
+            typeConverter->materializeSourceConversion(
+                rewriter, reg.getLoc(), reg.getType(), member));
+
+      // Without the registers, all uses must be reachable in a straight line
+      // from the definitions, which are allowed to come after them in a graph
+      // region.
+      if (!sortTopologically(scFunc.getBodyBlock()))
+        return emitError(module->getLoc(),
+                         "combinational cycles not supported in cycle-based "
+                         "models");
+    }
+
     // Erase the HW module.
     rewriter.eraseOp(module);
 
@@ -130,12 +192,36 @@ struct ConvertHWModule : public OpConversionPattern<HWModuleOp> {
       rewriter.create<SignalWriteOp>(outputOp->getLoc(), portValue, converted);
     }
 
+    // Compute the next values of all registers into local variables before
+    // updating them, such that every register sees the old values of the
+    // others.
+    SmallVector<Value> nextValues;
+    for (auto [reg, member] : llvm::zip(regs, regMembers)) {
+      Value next = reg.getInput();
+      if (reg.getReset())
+        next = rewriter.create<comb::MuxOp>(reg.getLoc(), reg.getReset(),
+                                            reg.getResetValue(), next);
+      auto converted = typeConverter->materializeTargetConversion(
+          rewriter, reg.getLoc(), member.getType(), next);
+      auto name = cast<VariableOp>(member.getDefiningOp()).getName();
+      nextValues.push_back(rewriter.create<VariableOp>(
+          reg.getLoc(), member.getType(),
+          rewriter.getStringAttr(names.newName(name + "_next")), converted));
+    }
+    for (auto [reg, member, next] : llvm::zip(regs, regMembers, nextValues)) {
+      rewriter.create<AssignOp>(reg.getLoc(), member, next);
+      rewriter.eraseOp(reg);
+    }
+
     // Erase the HW OutputOp.
     outputOp->dropAllReferences();
     rewriter.eraseOp(outputOp);
 
     return success();
   }
+
+private:
+  bool cycleBased;
 };
 
 /// Convert hw.instance operations to systemc.instance.decl and a
@@ -276,9 +362,11 @@ static void populateLegality(ConversionTarget &target) {
 }
 
 static void populateOpConversion(RewritePatternSet &patterns,
-                                 TypeConverter &typeConverter) {
-  patterns.add<ConvertHWModule, ConvertInstance>(typeConverter,
-                                                 patterns.getContext());
+                                 TypeConverter &typeConverter,
+                                 bool cycleBased) {
+  patterns.add<ConvertHWModule>(typeConverter, patterns.getContext(),
+                                cycleBased);
+  patterns.add<ConvertInstance>(typeConverter, patterns.getContext());
 }
 
 static void populateTypeConversion(TypeConverter &converter) {
@@ -362,7 +450,7 @@ void HWToSystemCPass::runOnOperation() {
   RewritePatternSet patterns(&context);
   populateLegality(target);
   populateTypeConversion(typeConverter);
-  populateOpConversion(patterns, typeConverter);
+  populateOpConversion(patterns, typeConverter, cycleBased);
 
   if (failed(applyFullConversion(module, target, std::move(patterns))))
     signalPassFailure();
@@ -21,6 +21,7 @@
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/MathExtras.h"
@@ -755,8 +756,24 @@ static FModuleLike checkSubModuleOp(CircuitOp circuitOp, StringRef modName) {
   return circuitOp.lookupSymbol<FModuleLike>(modName);
 }
 
-static FModuleLike checkSubModuleOp(CircuitOp circuitOp, Operation *oldOp) {
-  auto moduleOp = checkSubModuleOp(circuitOp, getSubModuleName(oldOp));
+/// The sub-modules created for the operations of all functions, keyed by their
+/// name. The name encodes the operation kind, types and discriminating
+/// attributes, such that structurally identical operations share a single
+/// sub-module.
+using SubModuleCache = llvm::StringMap<FModuleLike>;
+
+static FModuleLike checkSubModuleOp(CircuitOp circuitOp, StringRef modName,
+                                    SubModuleCache &subModules) {
+  auto &moduleOp = subModules[modName];
+  if (!moduleOp)
+    moduleOp = checkSubModuleOp(circuitOp, modName);
+  return moduleOp;
+}
+
+static FModuleLike checkSubModuleOp(CircuitOp circuitOp, Operation *oldOp,
+                                    StringRef modName,
+                                    SubModuleCache &subModules) {
+  auto moduleOp = checkSubModuleOp(circuitOp, modName, subModules);
 
   if (isa<handshake::InstanceOp>(oldOp))
     assert(moduleOp &&
@@ -768,12 +785,15 @@ static FModuleLike checkSubModuleOp(CircuitOp circuitOp, Operation *oldOp) {
 /// All standard expressions and handshake elastic components will be converted
 /// to a FIRRTL sub-module and be instantiated in the top-module.
 static FModuleOp createSubModuleOp(FModuleOp topModuleOp, Operation *oldOp,
+                                   StringRef modName,
+                                   SubModuleCache &subModules,
                                    ConversionPatternRewriter &rewriter) {
   rewriter.setInsertionPoint(topModuleOp);
   auto ports = getPortInfoForOp(rewriter, oldOp);
-  return rewriter.create<FModuleOp>(
-      topModuleOp.getLoc(), rewriter.getStringAttr(getSubModuleName(oldOp)),
-      ports);
+  auto moduleOp = rewriter.create<FModuleOp>(
+      topModuleOp.getLoc(), rewriter.getStringAttr(modName), ports);
+  subModules[modName] = moduleOp;
+  return moduleOp;
 }
 
 /// Extract all subfields of all ports of the sub-module.
@@ -3040,7 +3060,8 @@ static std::string getInstanceName(Operation *op) {
 /// 1)  Create and go into a new FIRRTL top-module;
 /// 2)  Inline Handshake FuncOp region into the FIRRTL top-module;
 /// 3)  Traverse and convert each Standard or Handshake operation:
-///   i)    Check if an identical sub-module exists. If so, skip to vi);
+///   i)    Check if an identical sub-module exists, in this or any previously
+///         lowered function. If so, skip to vi);
 ///   ii)   Create and go into a new FIRRTL sub-module;
 ///   iii)  Extract data (if applied), valid, and ready subfield from each port
 ///         of the sub-module;
@@ -3061,9 +3082,9 @@ static std::string getInstanceName(Operation *op) {
 struct HandshakeFuncOpLowering : public OpConversionPattern<handshake::FuncOp> {
   using OpConversionPattern<handshake::FuncOp>::OpConversionPattern;
   HandshakeFuncOpLowering(MLIRContext *context, CircuitOp circuitOp,
-                          bool enableFlattening)
+                          SubModuleCache &subModules, bool enableFlattening)
       : OpConversionPattern<handshake::FuncOp>(context), circuitOp(circuitOp),
-        setFlattenAttr(enableFlattening) {}
+        subModules(subModules), setFlattenAttr(enableFlattening) {}
 
   LogicalResult
   matchAndRewrite(handshake::FuncOp funcOp, OpAdaptor adaptor,
@@ -3108,12 +3129,14 @@ struct HandshakeFuncOpLowering : public OpConversionPattern<handshake::FuncOp> {
       // This branch takes care of all non-timing operations that require to
       // be instantiated in the top-module.
       else if (op.getDialect()->getNamespace() != "firrtl") {
-        FModuleLike subModuleOp = checkSubModuleOp(circuitOp, &op);
+        std::string subModuleName = getSubModuleName(&op);
+        FModuleLike subModuleOp =
+            checkSubModuleOp(circuitOp, &op, subModuleName, subModules);
 
         // Check if the sub-module already exists.
         if (!subModuleOp) {
-          FModuleOp newSubModuleOp =
-              createSubModuleOp(topModuleOp, &op, rewriter);
+          FModuleOp newSubModuleOp = createSubModuleOp(
+              topModuleOp, &op, subModuleName, subModules, rewriter);
           subModuleOp = newSubModuleOp;
 
           Location insertLoc = newSubModuleOp.getLoc();
@@ -3153,6 +3176,9 @@ private:
   /// mutable due to circuitOp.getBody() being non-const.
   mutable CircuitOp circuitOp;
 
+  /// The sub-modules created so far, shared by the lowerings of all functions.
+  SubModuleCache &subModules;
+
   /// If true, the top-level module will have the FIRRTL inlining attribute set.
   /// All module instances will be recursively inlined into the top module.
   bool setFlattenAttr;
@@ -3197,11 +3223,13 @@ public:
     // Convert the handshake.func operations in post-order wrt. the instance
     // graph. This ensures that any referenced submodules (through
     // handshake.instance) has already been lowered, and their FIRRTL module
-    // equivalents are available.
+    // equivalents are available. The sub-modules of the operations are shared
+    // by all functions.
+    SubModuleCache subModules;
     for (auto funcName : llvm::reverse(sortedFuncs)) {
       RewritePatternSet patterns(op.getContext());
       patterns.insert<HandshakeFuncOpLowering>(op.getContext(), circuitOp,
-                                               enableFlattening);
+                                               subModules, enableFlattening);
       auto funcOp = op.lookupSymbol(funcName);
       assert(funcOp && "Symbol not found in module!");
       if (failed(applyPartialConversion(funcOp, target, std::move(patterns)))) {
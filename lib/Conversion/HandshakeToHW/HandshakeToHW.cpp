@@ -25,6 +25,7 @@
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "llvm/ADT/TypeSwitch.h"
@@ -44,11 +45,37 @@ static Type tupleToStruct(TypeRange types) {
   return toValidType(mlir::TupleType::get(types[0].getContext(), types));
 }
 
+/// The implementation modules of the handshake ops, shared by the lowering of
+/// all functions. Modules are keyed by their sub-module name, which encodes the
+/// structural signature of the ops they implement.
+struct SubModuleCache {
+  llvm::StringMap<hw::HWModuleLike> modules;
+  /// The implementation module of each op of the function being lowered, as
+  /// resolved before its conversion.
+  DenseMap<Operation *, hw::HWModuleLike> opModules;
+};
+
+/// Interface of the conversion patterns which create an implementation module
+/// for the op they lower.
+class SubModuleBuilder {
+public:
+  virtual ~SubModuleBuilder() = default;
+
+  /// Create the implementation module of 'op', named 'name', with the
+  /// insertion point of 'b'. 'b' may have no insertion point, in which case
+  /// the module is left detached.
+  virtual hw::HWModuleLike buildSubModule(Operation *op, StringAttr name,
+                                          OpBuilder &b) const = 0;
+};
+
 // Shared state used by various functions; captured in a struct to reduce the
 // number of arguments that we have to pass around.
 struct HandshakeLoweringState {
   ModuleOp parentModule;
   NameUniquer nameUniquer;
+  SubModuleCache &subModules;
+  /// The pattern building the implementation modules of each op kind.
+  DenseMap<OperationName, const SubModuleBuilder *> subModuleBuilders = {};
 };
 
 // A type converter is needed to perform the in-flight materialization of "raw"
@@ -245,21 +272,16 @@ static std::string getSubModuleName(Operation *oldOp) {
 // HW Sub-module Related Functions
 //===----------------------------------------------------------------------===//
 
-/// Check whether a submodule with the same name has been created elsewhere in
-/// the top level module. Return the matched module operation if true, otherwise
-/// return nullptr.
-static Operation *checkSubModuleOp(mlir::ModuleOp parentModule,
-                                   StringRef modName) {
-  if (auto mod = parentModule.lookupSymbol<HWModuleOp>(modName))
-    return mod;
-  if (auto mod = parentModule.lookupSymbol<HWModuleExternOp>(modName))
-    return mod;
-  return nullptr;
-}
-
-static Operation *checkSubModuleOp(mlir::ModuleOp parentModule,
-                                   Operation *oldOp) {
-  auto *moduleOp = checkSubModuleOp(parentModule, getSubModuleName(oldOp));
+/// Check whether a submodule for the signature of 'oldOp' has been created
+/// before. Return the matched module operation if true, otherwise return
+/// nullptr and set 'modName' to the name the submodule should be created with.
+static HWModuleLike checkSubModuleOp(SubModuleCache &cache, Operation *oldOp,
+                                     std::string &modName) {
+  HWModuleLike moduleOp = cache.opModules.lookup(oldOp);
+  if (!moduleOp) {
+    modName = getSubModuleName(oldOp);
+    moduleOp = cache.modules.lookup(modName);
+  }
 
   if (isa<handshake::InstanceOp>(oldOp))
     assert(moduleOp &&
@@ -707,13 +729,16 @@ addSequentialIOOperandsIfNeeded(Operation *op,
 }
 
 template <typename T>
-class HandshakeConversionPattern : public OpConversionPattern<T> {
+class HandshakeConversionPattern : public OpConversionPattern<T>,
+                                   public SubModuleBuilder {
 public:
   HandshakeConversionPattern(ESITypeConverter &typeConverter,
                              MLIRContext *context, OpBuilder &submoduleBuilder,
                              HandshakeLoweringState &ls)
       : OpConversionPattern<T>::OpConversionPattern(typeConverter, context),
-        submoduleBuilder(submoduleBuilder), ls(ls) {}
+        submoduleBuilder(submoduleBuilder), ls(ls) {
+    ls.subModuleBuilders[OperationName(T::getOperationName(), context)] = this;
+  }
 
   using OpAdaptor = typename T::Adaptor;
 
@@ -724,25 +749,12 @@ public:
     // Check if a submodule has already been created for the op. If so,
     // instantiate the submodule. Else, run the pattern-defined module
     // builder.
-    hw::HWModuleLike implModule = checkSubModuleOp(ls.parentModule, op);
+    std::string modName;
+    hw::HWModuleLike implModule = checkSubModuleOp(ls.subModules, op, modName);
     if (!implModule) {
-      auto portInfo = ModulePortInfo(getPortInfoForOp(op));
-
-      implModule = submoduleBuilder.create<hw::HWModuleOp>(
-          op.getLoc(), submoduleBuilder.getStringAttr(getSubModuleName(op)),
-          portInfo, [&](OpBuilder &b, hw::HWModulePortAccessor &ports) {
-            // if 'op' has clock trait, extract these and provide them to the
-            // RTL builder.
-            Value clk, rst;
-            if (op->template hasTrait<mlir::OpTrait::HasClock>()) {
-              clk = ports.getInput("clock");
-              rst = ports.getInput("reset");
-            }
-
-            BackedgeBuilder bb(b, op.getLoc());
-            RTLBuilder s(ports.getModulePortInfo(), b, op.getLoc(), clk, rst);
-            this->buildModule(op, bb, s, ports);
-          });
+      implModule = buildSubModule(
+          op, submoduleBuilder.getStringAttr(modName), submoduleBuilder);
+      ls.subModules.modules[modName] = implModule;
     }
 
     // Instantiate the submodule.
@@ -753,6 +765,27 @@ public:
     return success();
   }
 
+  hw::HWModuleLike buildSubModule(Operation *oldOp, StringAttr name,
+                                  OpBuilder &builder) const override {
+    auto op = cast<T>(oldOp);
+    auto portInfo = ModulePortInfo(getPortInfoForOp(op));
+    return builder.create<hw::HWModuleOp>(
+        op.getLoc(), name, portInfo,
+        [&](OpBuilder &b, hw::HWModulePortAccessor &ports) {
+          // if 'op' has clock trait, extract these and provide them to the
+          // RTL builder.
+          Value clk, rst;
+          if (op->template hasTrait<mlir::OpTrait::HasClock>()) {
+            clk = ports.getInput("clock");
+            rst = ports.getInput("reset");
+          }
+
+          BackedgeBuilder bb(b, op.getLoc());
+          RTLBuilder s(ports.getModulePortInfo(), b, op.getLoc(), clk, rst);
+          this->buildModule(op, bb, s, ports);
+        });
+  }
+
   virtual void buildModule(T op, BackedgeBuilder &bb, RTLBuilder &builder,
                            hw::HWModulePortAccessor &ports) const = 0;
 
@@ -1788,12 +1821,13 @@ public:
   matchAndRewrite(T op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
 
-    hw::HWModuleLike implModule = checkSubModuleOp(ls.parentModule, op);
+    std::string modName;
+    hw::HWModuleLike implModule = checkSubModuleOp(ls.subModules, op, modName);
     if (!implModule) {
       auto portInfo = ModulePortInfo(getPortInfoForOp(op));
       implModule = submoduleBuilder.create<hw::HWModuleExternOp>(
-          op.getLoc(), submoduleBuilder.getStringAttr(getSubModuleName(op)),
-          portInfo);
+          op.getLoc(), submoduleBuilder.getStringAttr(modName), portInfo);
+      ls.subModules.modules[modName] = implModule;
     }
 
     llvm::SmallVector<Value> operands = adaptor.getOperands();
@@ -1858,10 +1892,58 @@ public:
 // HW Top-module Related Functions
 //===----------------------------------------------------------------------===//
 
+/// Create the implementation modules of all ops of 'op' whose signature has no
+/// module yet. The modules are built in parallel, detached, and then inserted
+/// in the order in which the ops appear in the function, which is the order
+/// the conversion patterns would have created them in.
+static void buildSubModules(handshake::FuncOp op, HandshakeLoweringState &ls,
+                            OpBuilder &moduleBuilder) {
+  SubModuleCache &cache = ls.subModules;
+  cache.opModules.clear();
+
+  // Resolve the module of every op, and collect one op of each new signature.
+  SmallVector<std::pair<Operation *, std::string>> newModules;
+  SmallVector<std::pair<Operation *, unsigned>> newModuleUsers;
+  llvm::StringMap<unsigned> newModuleIndices;
+  for (Block &block : op.getBody()) {
+    for (Operation &innerOp : block) {
+      if (!ls.subModuleBuilders.count(innerOp.getName()))
+        continue;
+      std::string modName = getSubModuleName(&innerOp);
+      if (auto implModule = cache.modules.lookup(modName)) {
+        cache.opModules[&innerOp] = implModule;
+        continue;
+      }
+      auto it = newModuleIndices.try_emplace(modName, newModules.size()).first;
+      if (it->second == newModules.size())
+        newModules.push_back({&innerOp, modName});
+      newModuleUsers.push_back({&innerOp, it->second});
+    }
+  }
+
+  MLIRContext *ctx = op.getContext();
+  SmallVector<hw::HWModuleLike> implModules(newModules.size());
+  mlir::parallelFor(ctx, 0, newModules.size(), [&](size_t i) {
+    auto &[implOp, modName] = newModules[i];
+    OpBuilder builder(ctx);
+    implModules[i] =
+        ls.subModuleBuilders.lookup(implOp->getName())
+            ->buildSubModule(implOp, builder.getStringAttr(modName), builder);
+  });
+
+  for (auto [newModule, implModule] : llvm::zip(newModules, implModules)) {
+    moduleBuilder.insert(implModule.getOperation());
+    cache.modules[newModule.second] = implModule;
+  }
+  for (auto [user, index] : newModuleUsers)
+    cache.opModules[user] = implModules[index];
+}
+
 static LogicalResult convertFuncOp(ESITypeConverter &typeConverter,
                                    ConversionTarget &target,
                                    handshake::FuncOp op,
-                                   OpBuilder &moduleBuilder) {
+                                   OpBuilder &moduleBuilder,
+                                   SubModuleCache &subModules) {
 
   std::map<std::string, unsigned> instanceNameCntr;
   NameUniquer instanceUniquer = [&](Operation *op) {
@@ -1878,7 +1960,7 @@ static LogicalResult convertFuncOp(ESITypeConverter &typeConverter,
   };
 
   auto ls = HandshakeLoweringState{op->getParentOfType<mlir::ModuleOp>(),
-                                   instanceUniquer};
+                                   instanceUniquer, subModules};
   RewritePatternSet patterns(op.getContext());
   patterns.insert<FuncOpConversionPattern, ReturnConversionPattern>(
       op.getContext());
@@ -1916,7 +1998,10 @@ static LogicalResult convertFuncOp(ESITypeConverter &typeConverter,
       TruncateConversionPattern, IndexCastConversionPattern>(
       typeConverter, op.getContext(), moduleBuilder, ls);
 
-  if (failed(applyPartialConversion(op, target, std::move(patterns))))
+  buildSubModules(op, ls, moduleBuilder);
+  auto result = applyPartialConversion(op, target, std::move(patterns));
+  subModules.opModules.clear();
+  if (failed(result))
     return op->emitOpError() << "error during conversion";
   return success();
 }
@@ -1960,16 +2045,25 @@ public:
     // graph. This ensures that any referenced submodules (through
     // handshake.instance) has already been lowered, and their HW module
     // equivalents are available.
+    // Implementation modules are created once per op signature and reused
+    // by all functions, including any HW modules which are already present.
+    SubModuleCache subModules;
+    for (auto hwModule : mod.getOps<hw::HWModuleLike>())
+      subModules.modules[hwModule.moduleName()] = hwModule;
+
     OpBuilder submoduleBuilder(mod.getContext());
     submoduleBuilder.setInsertionPointToStart(mod.getBody());
     for (auto &funcName : llvm::reverse(sortedFuncs)) {
       auto funcOp = mod.lookupSymbol<handshake::FuncOp>(funcName);
       assert(funcOp && "handshake.func not found in module!");
-      if (failed(
-              convertFuncOp(typeConverter, target, funcOp, submoduleBuilder))) {
+      if (failed(convertFuncOp(typeConverter, target, funcOp, submoduleBuilder,
+                               subModules))) {
         signalPassFailure();
         return;
       }
+      // The lowered function may itself be instantiated by later functions.
+      if (auto hwModule = mod.lookupSymbol<hw::HWModuleLike>(funcName))
+        subModules.modules[funcName] = hwModule;
     }
 
     // Second stage: Convert any handshake.extmemory operations and the
@@ -26,8 +26,11 @@
 #include "mlir/Conversion/ReconcileUnrealizedCasts/ReconcileUnrealizedCasts.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/RegionGraphTraits.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/DialectConversion.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SCCIterator.h"
 
 using namespace mlir;
 using namespace circt;
@@ -1045,14 +1048,16 @@ struct InstOpConversion : public ConvertToLLVMPattern {
                             "addSigStructElement", addSigStructElemFuncTy);
 
     // Get or insert allocProc library call definition.
-    auto allocProcFuncTy =
-        LLVM::LLVMFunctionType::get(voidTy, {i8PtrTy, i8PtrTy, i8PtrTy});
+    // Signature: (i8* state, i8* owner, i8* procState, i64 size) -> void
+    auto allocProcFuncTy = LLVM::LLVMFunctionType::get(
+        voidTy, {i8PtrTy, i8PtrTy, i8PtrTy, i64Ty});
     auto allocProcFunc = getOrInsertFunction(module, rewriter, op->getLoc(),
                                              "allocProc", allocProcFuncTy);
 
     // Get or insert allocEntity library call definition.
-    auto allocEntityFuncTy =
-        LLVM::LLVMFunctionType::get(voidTy, {i8PtrTy, i8PtrTy, i8PtrTy});
+    // Signature: (i8* state, i8* owner, i8* entityState, i64 size) -> void
+    auto allocEntityFuncTy = LLVM::LLVMFunctionType::get(
+        voidTy, {i8PtrTy, i8PtrTy, i8PtrTy, i64Ty});
     auto allocEntityFunc = getOrInsertFunction(
         module, rewriter, op->getLoc(), "allocEntity", allocEntityFuncTy);
 
@@ -1128,7 +1133,7 @@ struct InstOpConversion : public ConvertToLLVMPattern {
       // Add reg state pointer to global state.
       initBuilder.create<LLVM::CallOp>(
           op->getLoc(), llvm::None, SymbolRefAttr::get(allocEntityFunc),
-          ArrayRef<Value>({initStatePtr, owner, regMall}));
+          ArrayRef<Value>({initStatePtr, owner, regMall, regSize}));
 
       // Index of the signal in the entity's signal table.
       int initCounter = 0;
@@ -1346,7 +1351,8 @@ struct InstOpConversion : public ConvertToLLVMPattern {
       initBuilder.create<LLVM::StoreOp>(op->getLoc(), sensesBC,
                                         procStateSensesPtr);
 
-      std::array<Value, 3> allocProcArgs({initStatePtr, owner, procStateMall});
+      std::array<Value, 4> allocProcArgs(
+          {initStatePtr, owner, procStateMall, procStateSize});
       initBuilder.create<LLVM::CallOp>(op->getLoc(), llvm::None,
                                        SymbolRefAttr::get(allocProcFunc),
                                        allocProcArgs);
@@ -1962,6 +1968,142 @@ struct StoreOpConversion : ConvertToLLVMPattern {
 using LoadOpConversion =
     OneToOneConvertToLLVMPattern<llhd::LoadOp, LLVM::LoadOp>;
 
+//===----------------------------------------------------------------------===//
+// Drive batching
+//===----------------------------------------------------------------------===//
+
+/// Returns true if the control flow graph of the given region has a cycle, in
+/// which case a drive can be executed more than once per activation.
+static bool hasCycle(Region &region) {
+  for (auto it = llvm::scc_begin(&region); !it.isAtEnd(); ++it)
+    if (it.hasCycle())
+      return true;
+  return false;
+}
+
+/// Replace the `driveSignal` calls of the given unit function by stores of the
+/// call arguments to a buffer of drives on the stack. The buffer is passed to
+/// the `driveSignals` runtime call before the function returns, or before a
+/// drive would overflow it. The drives are thus scheduled in the same order.
+static void batchDrives(LLVM::LLVMFuncOp func, ArrayRef<LLVM::CallOp> drives,
+                        LLVM::LLVMFuncOp drvsFunc, Type driveTy) {
+  auto *ctx = func.getContext();
+  auto loc = func.getLoc();
+  auto i32Ty = IntegerType::get(ctx, 32);
+  auto i64Ty = IntegerType::get(ctx, 64);
+  auto drivePtrTy = LLVM::LLVMPointerType::get(driveTy);
+  int64_t capacity = drives.size();
+  auto bufferTy = LLVM::LLVMArrayType::get(driveTy, capacity);
+  Value statePtr = func.getArgument(0);
+
+  OpBuilder builder(ctx);
+  auto getI64Const = [&](Location loc, int64_t value) -> Value {
+    return builder.create<LLVM::ConstantOp>(loc, i64Ty,
+                                            builder.getI64IntegerAttr(value));
+  };
+
+  // Allocate the buffer and the count of recorded drives.
+  builder.setInsertionPointToStart(&func.getBody().front());
+  auto oneC = builder.create<LLVM::ConstantOp>(loc, i32Ty,
+                                               builder.getI32IntegerAttr(1));
+  auto buffer = builder.create<LLVM::AllocaOp>(
+      loc, LLVM::LLVMPointerType::get(bufferTy), oneC, 8);
+  Value bufferStart = builder.create<LLVM::BitcastOp>(loc, drivePtrTy, buffer);
+  Value countPtr = builder.create<LLVM::AllocaOp>(
+      loc, LLVM::LLVMPointerType::get(i64Ty), oneC, 8);
+  builder.create<LLVM::StoreOp>(loc, getI64Const(loc, 0), countPtr);
+
+  auto createFlush = [&](Location loc, Value count) {
+    builder.create<LLVM::CallOp>(loc, llvm::None, SymbolRefAttr::get(drvsFunc),
+                                 ValueRange({statePtr, bufferStart, count}));
+  };
+
+  // Without cycles, every drive is executed at most once per activation and
+  // cannot overflow the buffer.
+  bool checkCapacity = hasCycle(func.getBody());
+
+  for (auto drive : drives) {
+    auto loc = drive.getLoc();
+    builder.setInsertionPoint(drive);
+    Value index = builder.create<LLVM::LoadOp>(loc, countPtr);
+
+    if (checkCapacity) {
+      // Flush the buffer if it is full, continuing with the first entry.
+      Value count = index;
+      auto *block = drive->getBlock();
+      auto *continueBlock = block->splitBlock(drive);
+      index = continueBlock->addArgument(i64Ty, loc);
+
+      builder.createBlock(continueBlock);
+      Value capacityC = getI64Const(loc, capacity);
+      createFlush(loc, capacityC);
+      auto *flushBlock = builder.getInsertionBlock();
+      builder.create<LLVM::BrOp>(loc, ValueRange(getI64Const(loc, 0)),
+                                 continueBlock);
+
+      builder.setInsertionPointToEnd(block);
+      auto isFull = builder.create<LLVM::ICmpOp>(
+          loc, LLVM::ICmpPredicate::eq, count, getI64Const(loc, capacity));
+      builder.create<LLVM::CondBrOp>(loc, isFull, flushBlock, ValueRange(),
+                                     continueBlock, ValueRange(count));
+      builder.setInsertionPoint(drive);
+    }
+
+    // Record the drive and bump the count.
+    Value entry = builder.create<LLVM::UndefOp>(loc, driveTy);
+    for (auto &en : llvm::enumerate(drive.getOperands().drop_front()))
+      entry = builder.create<LLVM::InsertValueOp>(loc, entry, en.value(),
+                                                  en.index());
+    auto entryPtr = builder.create<LLVM::GEPOp>(loc, drivePtrTy, bufferStart,
+                                                ArrayRef<Value>(index));
+    builder.create<LLVM::StoreOp>(loc, entry, entryPtr);
+    auto next = builder.create<LLVM::AddOp>(loc, index, getI64Const(loc, 1));
+    builder.create<LLVM::StoreOp>(loc, next, countPtr);
+    drive.erase();
+  }
+
+  // Pass the recorded drives to the runtime on every exit of the unit.
+  func.walk([&](LLVM::ReturnOp ret) {
+    builder.setInsertionPoint(ret);
+    createFlush(ret.getLoc(),
+                builder.create<LLVM::LoadOp>(ret.getLoc(), countPtr));
+  });
+}
+
+/// Batch the drives of every unit function in the given module.
+static void batchDrives(ModuleOp module) {
+  auto drvFunc = module.lookupSymbol<LLVM::LLVMFuncOp>("driveSignal");
+  if (!drvFunc)
+    return;
+
+  // Collect the drives of each unit function, in order.
+  llvm::MapVector<LLVM::LLVMFuncOp, SmallVector<LLVM::CallOp>> drives;
+  module.walk([&](LLVM::CallOp call) {
+    if (call.getCallee() == drvFunc.getName())
+      drives[call->getParentOfType<LLVM::LLVMFuncOp>()].push_back(call);
+  });
+
+  // The drive struct matches `PendingDrive` in the runtime library: {signal,
+  // valuePtr, width, time, delta, eps}, i.e. the `driveSignal` arguments
+  // without the state.
+  auto *ctx = module.getContext();
+  auto drvFuncTy = drvFunc.getFunctionType();
+  auto driveTy = LLVM::LLVMStructType::getLiteral(
+      ctx, drvFuncTy.getParams().drop_front());
+  auto drvsFuncTy = LLVM::LLVMFunctionType::get(
+      drvFuncTy.getReturnType(),
+      {drvFuncTy.getParamType(0), LLVM::LLVMPointerType::get(driveTy),
+       IntegerType::get(ctx, 64)});
+
+  OpBuilder moduleBuilder(module.getBodyRegion());
+  auto drvsFunc = moduleBuilder.create<LLVM::LLVMFuncOp>(
+      drvFunc.getLoc(), "driveSignals", drvsFuncTy);
+
+  for (auto &[func, funcDrives] : drives)
+    batchDrives(func, funcDrives, drvsFunc, driveTy);
+  drvFunc.erase();
+}
+
 //===----------------------------------------------------------------------===//
 // Pass initialization
 //===----------------------------------------------------------------------===//
@@ -1969,6 +2111,9 @@ using LoadOpConversion =
 namespace {
 struct LLHDToLLVMLoweringPass
     : public ConvertLLHDToLLVMBase<LLHDToLLVMLoweringPass> {
+  LLHDToLLVMLoweringPass(bool batchDrives) {
+    this->batchDrives = batchDrives;
+  }
   void runOnOperation() override;
 };
 } // namespace
@@ -2064,10 +2209,14 @@ void LLHDToLLVMLoweringPass::runOnOperation() {
 
   // Apply the full conversion.
   if (failed(applyFullConversion(getOperation(), target, std::move(patterns))))
-    signalPassFailure();
+    return signalPassFailure();
+
+  if (batchDrives)
+    ::batchDrives(getOperation());
 }
 
 /// Create an LLHD to LLVM conversion pass.
-std::unique_ptr<OperationPass<ModuleOp>> circt::createConvertLLHDToLLVMPass() {
-  return std::make_unique<LLHDToLLVMLoweringPass>();
+std::unique_ptr<OperationPass<ModuleOp>>
+circt::createConvertLLHDToLLVMPass(bool batchDrives) {
+  return std::make_unique<LLHDToLLVMLoweringPass>(batchDrives);
 }
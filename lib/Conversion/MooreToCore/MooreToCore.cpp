@@ -19,6 +19,7 @@
 #include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinDialect.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "llvm/ADT/TypeSwitch.h"
 
@@ -286,7 +287,36 @@ static void populateLegality(ConversionTarget &target) {
   });
 }
 
-static void populateTypeConversion(TypeConverter &typeConverter) {
+/// A mapping from the Moore types used in a module to their converted types.
+using TypeConversionCache = DenseMap<Type, Type>;
+
+/// Convert all Moore types used by the ops in `module` up front, such that the
+/// type converters of the parallel conversions only need to look them up.
+static void buildTypeConversionCache(ModuleOp module,
+                                     TypeConverter &typeConverter,
+                                     TypeConversionCache &cache) {
+  auto addTypes = [&](TypeRange types) {
+    for (auto type : types) {
+      if (!isMooreType(type) || cache.count(type))
+        continue;
+      // Types which fail to convert are reported by the ops using them.
+      if (auto converted = typeConverter.convertType(type))
+        cache.insert({type, converted});
+    }
+  };
+
+  module.walk([&](Operation *op) {
+    addTypes(op->getResultTypes());
+    for (auto &region : op->getRegions())
+      for (auto &block : region)
+        addTypes(block.getArgumentTypes());
+    if (auto func = dyn_cast<func::FuncOp>(op))
+      addTypes(func.getResultTypes());
+  });
+}
+
+static void populateTypeConversion(TypeConverter &typeConverter,
+                                   const TypeConversionCache *cache = nullptr) {
   typeConverter.addConversion([&](IntType type) {
     return mlir::IntegerType::get(type.getContext(), type.getBitSize());
   });
@@ -306,6 +336,16 @@ static void populateTypeConversion(TypeConverter &typeConverter) {
 
   // Valid target types.
   typeConverter.addConversion([](mlir::IntegerType type) { return type; });
+
+  // Look up the types converted in bulk before any other conversion. This is
+  // added last, such that it is tried first.
+  if (cache)
+    typeConverter.addConversion([cache](Type type) -> Optional<Type> {
+      auto it = cache->find(type);
+      if (it == cache->end())
+        return llvm::None;
+      return it->second;
+    });
 }
 
 static void populateOpConversion(RewritePatternSet &patterns,
@@ -351,12 +391,41 @@ void MooreToCorePass::runOnOperation() {
   ModuleOp module = getOperation();
 
   ConversionTarget target(context);
-  TypeConverter typeConverter;
-  RewritePatternSet patterns(&context);
   populateLegality(target);
-  populateTypeConversion(typeConverter);
-  populateOpConversion(patterns, typeConverter);
 
-  if (failed(applyFullConversion(module, target, std::move(patterns))))
+  // Convert the types of the whole module once, rather than in every thread.
+  TypeConversionCache typeCache;
+  {
+    TypeConverter typeConverter;
+    populateTypeConversion(typeConverter);
+    buildTypeConversionCache(module, typeConverter, typeCache);
+  }
+
+  // Converts `op` and its regions. The type converter caches conversions
+  // without synchronization, so every conversion uses its own converter and
+  // patterns.
+  auto convert = [&](Operation *op) {
+    TypeConverter typeConverter;
+    RewritePatternSet patterns(&context);
+    populateTypeConversion(typeConverter, &typeCache);
+    populateOpConversion(patterns, typeConverter);
+    return applyFullConversion(op, target, std::move(patterns));
+  };
+
+  // Convert the isolated top-level ops, i.e. entities and functions, in
+  // parallel. Any other ops are converted together with the module afterwards.
+  SmallVector<Operation *> isolatedOps;
+  bool hasOtherOps = false;
+  for (auto &op : *module.getBody()) {
+    if (op.hasTrait<OpTrait::IsIsolatedFromAbove>() &&
+        !isa_and_nonnull<MooreDialect>(op.getDialect()))
+      isolatedOps.push_back(&op);
+    else
+      hasOtherOps = true;
+  }
+  if (failed(failableParallelForEach(&context, isolatedOps, convert)))
+    return signalPassFailure();
+
+  if (hasOtherOps && failed(convert(module)))
     signalPassFailure();
 }
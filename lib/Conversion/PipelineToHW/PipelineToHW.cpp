@@ -23,7 +23,51 @@ using namespace mlir;
 using namespace circt;
 using namespace pipeline;
 
-static LogicalResult lowerPipeline(PipelineOp pipeline, OpBuilder &builder) {
+/// Lower the registers of 'stage' to a single `seq.compreg`, holding the
+/// concatenation of all of the register inputs. Returns false if the registers
+/// could not be packed, in which case nothing is created.
+static bool lowerPackedStageRegisters(PipelineStageRegisterOp stage,
+                                      StringAttr regName, Value clk, Value rst,
+                                      OpBuilder &builder) {
+  auto loc = stage.getLoc();
+  SmallVector<int64_t> widths;
+  int64_t totalWidth = 0;
+  for (Value regIn : stage.getRegIns()) {
+    int64_t width = hw::getBitWidth(regIn.getType());
+    if (width <= 0)
+      return false;
+    widths.push_back(width);
+    totalWidth += width;
+  }
+
+  // Concatenate the register inputs. The first register input ends up in the
+  // most significant bits.
+  SmallVector<Value> packedIns;
+  for (auto [regIn, width] : llvm::zip(stage.getRegIns(), widths)) {
+    Type intType = builder.getIntegerType(width);
+    if (regIn.getType() != intType)
+      regIn = builder.create<hw::BitcastOp>(loc, intType, regIn);
+    packedIns.push_back(regIn);
+  }
+  Type packedType = builder.getIntegerType(totalWidth);
+  Value packedIn = builder.create<comb::ConcatOp>(loc, packedType, packedIns);
+  auto reg = builder.create<seq::CompRegOp>(
+      loc, packedType, packedIn, clk, regName, rst, Value(), StringAttr());
+
+  // Slice the register outputs back out.
+  int64_t lowBit = totalWidth;
+  for (auto [regOut, width] : llvm::zip(stage.getRegOuts(), widths)) {
+    lowBit -= width;
+    Value slice = builder.create<comb::ExtractOp>(loc, reg, lowBit, width);
+    if (regOut.getType() != slice.getType())
+      slice = builder.create<hw::BitcastOp>(loc, regOut.getType(), slice);
+    regOut.replaceAllUsesWith(slice);
+  }
+  return true;
+}
+
+static LogicalResult lowerPipeline(PipelineOp pipeline, OpBuilder &builder,
+                                   bool packStageRegisters) {
   if (pipeline.isLatencyInsensitive())
     return pipeline.emitOpError() << "Only latency-sensitive pipelines are "
                                      "supported at the moment";
@@ -51,6 +95,14 @@ static LogicalResult lowerPipeline(PipelineOp pipeline, OpBuilder &builder) {
               Value(), StringAttr());
           stage.getValid().replaceAllUsesWith(validReg);
 
+          if (packStageRegisters && stage.getRegIns().size() > 1 &&
+              lowerPackedStageRegisters(
+                  stage,
+                  builder.getStringAttr("s" + std::to_string(stageIdx) +
+                                        "_regs"),
+                  clk, rst, builder))
+            return;
+
           for (auto &it : llvm::enumerate(stage.getRegIns())) {
             auto regIdx = it.index();
             auto regIn = it.value();
@@ -88,7 +140,7 @@ void PipelineToHWPass::runOnOperation() {
   // `PipelineOp` due to the `PipelineOp` being erased during this pass.
   for (auto pipeline :
        llvm::make_early_inc_range(getOperation().getOps<PipelineOp>()))
-    if (failed(lowerPipeline(pipeline, builder)))
+    if (failed(lowerPipeline(pipeline, builder, packStageRegisters)))
       signalPassFailure();
 }
 
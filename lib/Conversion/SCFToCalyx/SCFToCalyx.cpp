@@ -92,6 +92,25 @@ class ComponentLoweringState
 public:
   ComponentLoweringState(calyx::ComponentOp component)
       : calyx::ComponentLoweringStateInterface(component) {}
+
+  /// Returns the pipelined functional unit of type TLibraryOp operating on
+  /// values of type 'width', which is shared by all operations of that kind
+  /// and width in the component. The unit is created on first use.
+  template <typename TLibraryOp>
+  TLibraryOp getSharedLibraryOpInstance(OpBuilder &builder, Location loc,
+                                        Type width) {
+    auto &unit = sharedUnits[{TypeID::get<TLibraryOp>(), width}];
+    if (!unit) {
+      Type one = builder.getI1Type();
+      unit = getNewLibraryOpInstance<TLibraryOp>(
+          builder, loc, {one, one, one, width, width, width, one});
+    }
+    return cast<TLibraryOp>(unit);
+  }
+
+private:
+  /// The shared pipelined functional units, by library operation and width.
+  DenseMap<std::pair<TypeID, Type>, Operation *> sharedUnits;
 };
 
 //===----------------------------------------------------------------------===//
@@ -101,7 +120,12 @@ public:
 /// Iterate through the operations of a source function and instantiate
 /// components or primitives based on the type of the operations.
 class BuildOpGroups : public calyx::FuncOpPartialLoweringPattern {
-  using FuncOpPartialLoweringPattern::FuncOpPartialLoweringPattern;
+public:
+  BuildOpGroups(MLIRContext *context, LogicalResult &resRef,
+                DenseMap<FuncOp, calyx::ComponentOp> &map,
+                calyx::CalyxLoweringState &state, bool shareFunctionalUnits)
+      : FuncOpPartialLoweringPattern(context, resRef, map, state),
+        shareFunctionalUnits(shareFunctionalUnits) {}
 
   LogicalResult
   partiallyLowerFuncToComp(FuncOp funcOp,
@@ -141,6 +165,9 @@ class BuildOpGroups : public calyx::FuncOpPartialLoweringPattern {
   }
 
 private:
+  /// Whether pipelined functional units are shared between operations.
+  bool shareFunctionalUnits;
+
   /// Op builder specializations.
   LogicalResult buildOp(PatternRewriter &rewriter, scf::YieldOp yieldOp) const;
   LogicalResult buildOp(PatternRewriter &rewriter,
@@ -234,6 +261,20 @@ private:
         op->getLoc(), groupName);
   }
 
+  /// Returns the pipelined functional unit of type TOpType for the source
+  /// operation 'op', which is either a new one or the component's shared one.
+  template <typename TOpType, typename TSrcOp>
+  TOpType getPipeLibraryOp(PatternRewriter &rewriter, TSrcOp op) const {
+    Location loc = op.getLoc();
+    Type width = op.getResult().getType(), one = rewriter.getI1Type();
+    if (shareFunctionalUnits)
+      return getState<ComponentLoweringState>()
+          .getSharedLibraryOpInstance<TOpType>(rewriter, loc, width);
+    return getState<ComponentLoweringState>()
+        .getNewLibraryOpInstance<TOpType>(
+            rewriter, loc, {one, one, one, width, width, width, one});
+  }
+
   /// buildLibraryBinaryPipeOp will build a TCalyxLibBinaryPipeOp, to
   /// deal with MulIOp, DivUIOp and RemUIOp.
   template <typename TOpType, typename TSrcOp>
@@ -242,11 +283,13 @@ private:
     StringRef opName = TSrcOp::getOperationName().split(".").second;
     Location loc = op.getLoc();
     Type width = op.getResult().getType();
-    // Pass the result from the Operation to the Calyx primitive.
-    op.getResult().replaceAllUsesWith(out);
     auto reg = createRegister(
         op.getLoc(), rewriter, getComponent(), width.getIntOrFloatBitWidth(),
         getState<ComponentLoweringState>().getUniqueName(opName));
+    // Pass the result from the Operation to the Calyx primitive. A shared unit
+    // computes other results later on, so its users read the register.
+    op.getResult().replaceAllUsesWith(shareFunctionalUnits ? reg.getOut()
+                                                           : out);
     // Operation pipelines are not combinational, so a GroupOp is required.
     auto group = createGroupForOp<calyx::GroupOp>(rewriter, op);
     getState<ComponentLoweringState>().addBlockScheduleable(op->getBlock(),
@@ -372,12 +415,7 @@ LogicalResult BuildOpGroups::buildOp(PatternRewriter &rewriter,
 
 LogicalResult BuildOpGroups::buildOp(PatternRewriter &rewriter,
                                      MulIOp mul) const {
-  Location loc = mul.getLoc();
-  Type width = mul.getResult().getType(), one = rewriter.getI1Type();
-  auto mulPipe =
-      getState<ComponentLoweringState>()
-          .getNewLibraryOpInstance<calyx::MultPipeLibOp>(
-              rewriter, loc, {one, one, one, width, width, width, one});
+  auto mulPipe = getPipeLibraryOp<calyx::MultPipeLibOp>(rewriter, mul);
   return buildLibraryBinaryPipeOp<calyx::MultPipeLibOp>(
       rewriter, mul, mulPipe,
       /*out=*/mulPipe.getOut());
@@ -385,12 +423,7 @@ LogicalResult BuildOpGroups::buildOp(PatternRewriter &rewriter,
 
 LogicalResult BuildOpGroups::buildOp(PatternRewriter &rewriter,
                                      DivUIOp div) const {
-  Location loc = div.getLoc();
-  Type width = div.getResult().getType(), one = rewriter.getI1Type();
-  auto divPipe =
-      getState<ComponentLoweringState>()
-          .getNewLibraryOpInstance<calyx::DivUPipeLibOp>(
-              rewriter, loc, {one, one, one, width, width, width, one});
+  auto divPipe = getPipeLibraryOp<calyx::DivUPipeLibOp>(rewriter, div);
   return buildLibraryBinaryPipeOp<calyx::DivUPipeLibOp>(
       rewriter, div, divPipe,
       /*out=*/divPipe.getOut());
@@ -398,12 +431,7 @@ LogicalResult BuildOpGroups::buildOp(PatternRewriter &rewriter,
 
 LogicalResult BuildOpGroups::buildOp(PatternRewriter &rewriter,
                                      DivSIOp div) const {
-  Location loc = div.getLoc();
-  Type width = div.getResult().getType(), one = rewriter.getI1Type();
-  auto divPipe =
-      getState<ComponentLoweringState>()
-          .getNewLibraryOpInstance<calyx::DivSPipeLibOp>(
-              rewriter, loc, {one, one, one, width, width, width, one});
+  auto divPipe = getPipeLibraryOp<calyx::DivSPipeLibOp>(rewriter, div);
   return buildLibraryBinaryPipeOp<calyx::DivSPipeLibOp>(
       rewriter, div, divPipe,
       /*out=*/divPipe.getOut());
@@ -411,12 +439,7 @@ LogicalResult BuildOpGroups::buildOp(PatternRewriter &rewriter,
 
 LogicalResult BuildOpGroups::buildOp(PatternRewriter &rewriter,
                                      RemUIOp rem) const {
-  Location loc = rem.getLoc();
-  Type width = rem.getResult().getType(), one = rewriter.getI1Type();
-  auto remPipe =
-      getState<ComponentLoweringState>()
-          .getNewLibraryOpInstance<calyx::RemUPipeLibOp>(
-              rewriter, loc, {one, one, one, width, width, width, one});
+  auto remPipe = getPipeLibraryOp<calyx::RemUPipeLibOp>(rewriter, rem);
   return buildLibraryBinaryPipeOp<calyx::RemUPipeLibOp>(
       rewriter, rem, remPipe,
       /*out=*/remPipe.getOut());
@@ -424,12 +447,7 @@ LogicalResult BuildOpGroups::buildOp(PatternRewriter &rewriter,
 
 LogicalResult BuildOpGroups::buildOp(PatternRewriter &rewriter,
                                      RemSIOp rem) const {
-  Location loc = rem.getLoc();
-  Type width = rem.getResult().getType(), one = rewriter.getI1Type();
-  auto remPipe =
-      getState<ComponentLoweringState>()
-          .getNewLibraryOpInstance<calyx::RemSPipeLibOp>(
-              rewriter, loc, {one, one, one, width, width, width, one});
+  auto remPipe = getPipeLibraryOp<calyx::RemSPipeLibOp>(rewriter, rem);
   return buildLibraryBinaryPipeOp<calyx::RemSPipeLibOp>(
       rewriter, rem, remPipe,
       /*out=*/remPipe.getOut());
@@ -1336,7 +1354,8 @@ void SCFToCalyxPass::runOnOperation() {
   /// originated from. This is used during control schedule generation. By
   /// having a distinct group for each operation, groups are analogous to SSA
   /// values in the source program.
-  addOncePattern<BuildOpGroups>(loweringPatterns, funcMap, *loweringState);
+  addOncePattern<BuildOpGroups>(loweringPatterns, funcMap, *loweringState,
+                                shareFunctionalUnits);
 
   /// This pattern traverses the CFG of the program and generates a control
   /// schedule based on the calyx::GroupOp's which were registered for each
@@ -39,6 +39,7 @@
 #include "mlir/Support/LLVM.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/raw_ostream.h"
@@ -252,80 +253,20 @@ void removeBasicBlocks(handshake::FuncOp funcOp) {
   removeBasicBlocks(funcOp.getBody());
 }
 
-static HandshakeLowering::BlockValues getBlockUses(Region &f) {
+using BlockValueSets = DenseMap<Block *, SetVector<Value>>;
+
+static BlockValueSets getBlockUses(Region &f) {
   // Returns map of values used in block but defined outside of block
   // For liveness analysis
-  HandshakeLowering::BlockValues uses;
-  for (Block &block : f) {
-    // Operands of operations in b which do not originate from operations or
-    // arguments of b
-    for (Operation &op : block) {
-      for (int i = 0, e = op.getNumOperands(); i < e; ++i) {
-        Block *operandBlock;
-        if (op.getOperand(i).isa<BlockArgument>()) {
-          // Operand is block argument, get its owner block
-          operandBlock = op.getOperand(i).cast<BlockArgument>().getOwner();
-        } else {
-          // Operand comes from operation, get the block of its defining op
-          auto *operand = op.getOperand(i).getDefiningOp();
-          assert(operand != NULL);
-          operandBlock = operand->getBlock();
-        }
-        // If operand defined in some other block, add to uses
-        if (operandBlock != &block)
-          // Add only unique uses
-          if (std::find(uses[&block].begin(), uses[&block].end(),
-                        op.getOperand(i)) == uses[&block].end())
-            uses[&block].push_back(op.getOperand(i));
-      }
-    }
-  }
+  BlockValueSets uses;
+  for (Block &block : f)
+    for (Operation &op : block)
+      for (Value operand : op.getOperands())
+        if (operand.getParentBlock() != &block)
+          uses[&block].insert(operand);
   return uses;
 }
 
-static HandshakeLowering::BlockValues getBlockDefs(Region &f) {
-  // Returns map of values defined in each block
-  // For liveness analysis
-  HandshakeLowering::BlockValues defs;
-  for (Block &block : f) {
-    // Values produced by operations in b
-    for (Operation &op : block) {
-      if (op.getNumResults() > 0) {
-        for (auto result : op.getResults())
-          defs[&block].push_back(result);
-      }
-    }
-    // Argument values of b
-    for (auto &arg : block.getArguments())
-      defs[&block].push_back(arg);
-  }
-
-  return defs;
-}
-
-static std::vector<Value> vectorUnion(ArrayRef<Value> v1, ArrayRef<Value> v2) {
-  // Returns v1 U v2
-  // Assumes unique values in v1
-  std::vector<Value> v1c = v1;
-  for (int i = 0, e = v2.size(); i < e; ++i) {
-    Value val = v2[i];
-    if (std::find(v1.begin(), v1.end(), val) == v1.end())
-      v1c.push_back(val);
-  }
-  return v1c;
-}
-
-static std::vector<Value> vectorDiff(ArrayRef<Value> v1, ArrayRef<Value> v2) {
-  // Returns v1 - v2
-  std::vector<Value> d;
-  for (int i = 0, e = v1.size(); i < e; ++i) {
-    Value val = v1[i];
-    if (std::find(v2.begin(), v2.end(), val) == v2.end())
-      d.push_back(val);
-  }
-  return d;
-}
-
 static LogicalResult isValidMemrefType(Location loc, mlir::MemRefType type) {
   if (type.getNumDynamicDims() != 0 || type.getShape().size() != 1)
     return emitError(loc) << "memref's must be both statically sized and "
@@ -337,44 +278,47 @@ static HandshakeLowering::BlockValues livenessAnalysis(Region &f) {
   // Liveness analysis algorithm adapted from:
   // https://suif.stanford.edu/~courses/cs243/lectures/l2.pdf
   // See slide 19 (Liveness: Iterative Algorithm)
+  //
+  // The sets are ordered so that merges are inserted in a deterministic order,
+  // and since a value is defined in exactly one block, whether a value is
+  // defined in a block is a constant time check.
 
   // blockUses: values used in block but not defined in block
-  HandshakeLowering::BlockValues blockUses = getBlockUses(f);
+  BlockValueSets blockUses = getBlockUses(f);
 
-  // blockDefs: values defined in block
-  HandshakeLowering::BlockValues blockDefs = getBlockDefs(f);
-
-  HandshakeLowering::BlockValues blockLiveIns;
+  BlockValueSets blockLiveIns;
 
   bool change = true;
   // Iterate while there are any changes to any of the livein sets
   while (change) {
     change = false;
 
-    // liveOuts(b): all liveins of all successors of b
-    // liveOuts(b) = U (blockLiveIns(s)) forall successors s of b
     for (Block &block : f) {
-      std::vector<Value> liveOuts;
-      for (int i = 0, e = block.getNumSuccessors(); i < e; ++i) {
-        Block *succ = block.getSuccessor(i);
-        liveOuts = vectorUnion(liveOuts, blockLiveIns[succ]);
+      // liveIns(b) = blockUses(b) U (liveOuts(b) - blockDefs(b)), where
+      // liveOuts(b) = U (blockLiveIns(s)) forall successors s of b
+      SetVector<Value> liveIns = blockUses.lookup(&block);
+      for (Block *succ : block.getSuccessors()) {
+        auto it = blockLiveIns.find(succ);
+        if (it == blockLiveIns.end())
+          continue;
+        for (Value val : it->second)
+          if (val.getParentBlock() != &block)
+            liveIns.insert(val);
       }
 
-      // diff(b):  liveouts of b which are not defined in b
-      // diff(b) = liveOuts(b) - blockDefs(b)
-      auto diff = vectorDiff(liveOuts, blockDefs[&block]);
-
-      // liveIns(b) = blockUses(b) U diff(b)
-      auto tmpLiveIns = vectorUnion(blockUses[&block], diff);
-
       // Update blockLiveIns if new liveins found
-      if (tmpLiveIns.size() > blockLiveIns[&block].size()) {
-        blockLiveIns[&block] = tmpLiveIns;
+      auto &current = blockLiveIns[&block];
+      if (liveIns.size() > current.size()) {
+        current = std::move(liveIns);
         change = true;
       }
     }
   }
-  return blockLiveIns;
+
+  HandshakeLowering::BlockValues result;
+  for (auto &it : blockLiveIns)
+    result[it.first] = it.second.takeVector();
+  return result;
 }
 
 static unsigned getBlockPredecessorCount(Block *block) {
@@ -413,14 +357,17 @@ Operation *HandshakeLowering::insertMerge(Block *block, Value val,
 }
 
 HandshakeLowering::BlockOps
-HandshakeLowering::insertMergeOps(HandshakeLowering::BlockValues blockLiveIns,
-                                  HandshakeLowering::blockArgPairs &mergePairs,
-                                  ConversionPatternRewriter &rewriter) {
+HandshakeLowering::insertMergeOps(
+    const HandshakeLowering::BlockValues &blockLiveIns,
+    HandshakeLowering::blockArgPairs &mergePairs,
+    ConversionPatternRewriter &rewriter) {
   HandshakeLowering::BlockOps blockMerges;
   for (Block &block : r) {
     // Live-ins identified by liveness analysis
     rewriter.setInsertionPointToStart(&block);
-    for (auto &val : blockLiveIns[&block]) {
+    auto liveIns = blockLiveIns.find(&block);
+    for (auto val : liveIns == blockLiveIns.end() ? ArrayRef<Value>()
+                                                  : liveIns->second) {
       Operation *newOp = insertMerge(&block, val, rewriter);
       blockMerges[&block].push_back(newOp);
       mergePairs[val] = newOp;
@@ -451,23 +398,28 @@ static bool blockHasSrcOp(Value val, Block *block) {
   return (op->getBlock() == block);
 }
 
+/// Maps a block and the helper value (defining value) of a merge in that block
+/// to the merge, so that the merge propagating a value into a successor can be
+/// found without searching the merges of the predecessor.
+using BlockMergeMap = DenseMap<std::pair<Block *, Value>, Operation *>;
+
 // Get value from predBlock which will be set as operand of op (merge)
 static Value getMergeOperand(Operation *op, Block *predBlock,
-                             HandshakeLowering::BlockOps blockMerges) {
+                             const BlockMergeMap &mergeOfValue) {
   // Helper value (defining value of merge) to identify Merges which propagate
   // the same defining value
   Value srcVal = op->getOperand(0);
   Block *block = op->getBlock();
 
   // Value comes from predecessor block (i.e., not an argument of this block)
-  if (std::find(block->getArguments().begin(), block->getArguments().end(),
-                srcVal) == block->getArguments().end()) {
+  auto arg = srcVal.dyn_cast<BlockArgument>();
+  if (!arg || arg.getOwner() != block) {
     // Value is not defined by operation in predBlock
     if (!blockHasSrcOp(srcVal, predBlock)) {
       // Find the corresponding Merge
-      for (Operation *predOp : blockMerges[predBlock])
-        if (predOp->getOperand(0) == srcVal)
-          return predOp->getResult(0);
+      auto it = mergeOfValue.find({predBlock, srcVal});
+      if (it != mergeOfValue.end())
+        return it->second->getResult(0);
     } else
       return srcVal;
   }
@@ -475,7 +427,7 @@ static Value getMergeOperand(Operation *op, Block *predBlock,
   // Value is argument of this block
   // Operand of terminator in predecessor block should be input to Merge
   else {
-    unsigned index = srcVal.cast<BlockArgument>().getArgNumber();
+    unsigned index = arg.getArgNumber();
     Operation *termOp = predBlock->getTerminator();
     if (mlir::cf::CondBranchOp br = dyn_cast<mlir::cf::CondBranchOp>(termOp)) {
       if (block == br.getTrueDest())
@@ -525,20 +477,32 @@ static ConditionalBranchOp getControlCondBranch(Block *block) {
 }
 
 static void reconnectMergeOps(Region &f,
-                              HandshakeLowering::BlockOps blockMerges,
+                              HandshakeLowering::BlockOps &blockMerges,
                               HandshakeLowering::blockArgPairs &mergePairs) {
   // All merge operands are initially set to original (defining) value.
   // We here replace defining value with appropriate value from predecessor
   // block. The predecessor can either be a merge, the original defining value,
   // or a branch Operand. Operand(0) is helper defining value for identifying
   // matching merges, it does not correspond to any predecessor block.
+  BlockMergeMap mergeOfValue;
+  for (auto &it : blockMerges)
+    for (Operation *op : it.second)
+      mergeOfValue.try_emplace({it.first, op->getOperand(0)}, op);
 
   for (Block &block : f) {
+    // Uses of each value by the non-merge operations of this block, in
+    // operation and operand order.
+    DenseMap<Value, SmallVector<OpOperand *, 2>> blockUses;
+    for (Operation &opp : block)
+      if (!isa<MergeLikeOpInterface>(opp))
+        for (OpOperand &operand : opp.getOpOperands())
+          blockUses[operand.get()].push_back(&operand);
+
     for (Operation *op : blockMerges[&block]) {
       int count = 1;
       // Set appropriate operand from predecessor block
       for (auto *predBlock : block.getPredecessors()) {
-        Value mgOperand = getMergeOperand(op, predBlock, blockMerges);
+        Value mgOperand = getMergeOperand(op, predBlock, mergeOfValue);
         assert(mgOperand != nullptr);
         if (!mgOperand.getDefiningOp()) {
           assert(mergePairs.count(mgOperand));
@@ -549,9 +513,10 @@ static void reconnectMergeOps(Region &f,
       }
       // Reconnect all operands originating from livein defining value through
       // corresponding merge of that block
-      for (Operation &opp : block)
-        if (!isa<MergeLikeOpInterface>(opp))
-          opp.replaceUsesOfWith(op->getOperand(0), op->getResult(0));
+      auto uses = blockUses.find(op->getOperand(0));
+      if (uses != blockUses.end())
+        for (OpOperand *use : uses->second)
+          use->set(op->getResult(0));
     }
   }
 
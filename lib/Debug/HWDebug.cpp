@@ -1,16 +1,28 @@
 #define GET_OP_CLASSES
 
 #include <memory>
+#include <tuple>
 
 #include "circt/Debug/HWDebug.h"
 #include "circt/Dialect/Comb/CombVisitors.h"
+#include "circt/Dialect/HW/HWDebugSignals.h"
+#include "circt/Dialect/HW/HWInstanceGraph.h"
 #include "circt/Dialect/HW/HWOps.h"
 #include "circt/Dialect/HW/HWVisitors.h"
 #include "circt/Dialect/SV/SVOps.h"
 #include "circt/Dialect/SV/SVVisitors.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/IR/Value.h"
 #include "mlir/Pass/Pass.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SHA256.h"
+#include "llvm/Support/StringSaver.h"
 
 mlir::StringRef getPortVerilogName(mlir::Operation *module,
                                    circt::hw::PortInfo port);
@@ -84,17 +96,35 @@ static StringRef getSymOpName(Operation *symOp) {
       });
 }
 
+/// A signal edge that an always block is evaluated on.
+struct HWDebugTrigger {
+  mlir::StringRef signal;
+  // posedge, negedge or edge
+  mlir::StringRef edge;
+};
+
 struct HWDebugScope {
 public:
   explicit HWDebugScope(HWDebugContext &context, mlir::Operation *op)
       : context(context), op(op) {}
 
-  llvm::SmallVector<HWDebugScope *> scopes;
+  // Most scopes are leaf line entries without any children, so don't reserve
+  // any inline storage here.
+  llvm::SmallVector<HWDebugScope *, 0> scopes;
 
   mlir::StringRef filename;
   uint32_t line = 0;
   uint32_t column = 0;
-  mlir::StringAttr condition;
+  // interned in the module's arena
+  mlir::StringRef condition;
+  // postfix bytecode of the condition, only set if it is requested
+  llvm::ArrayRef<int64_t> conditionCode;
+  // the edges an always block is sensitive to, interned in the module's arena.
+  // the runtime only needs to evaluate the breakpoints inside the block on
+  // these edges
+  llvm::ArrayRef<HWDebugTrigger> triggers;
+  // set for always_comb blocks, which are not sampled on any clock
+  bool combinational = false;
 
   HWDebugScope *parent = nullptr;
 
@@ -103,9 +133,8 @@ public:
   mlir::Operation *op;
 
   // NOLINTNEXTLINE
-  [[nodiscard]] virtual llvm::json::Value toJSON() const {
-    auto res = getScopeJSON(type() == HWDebugScopeType::Block);
-    return res;
+  virtual void toJSON(llvm::json::OStream &os) const {
+    os.object([&] { emitScopeJSON(os, type() == HWDebugScopeType::Block); });
   }
 
   [[nodiscard]] virtual HWDebugScopeType type() const {
@@ -115,41 +144,60 @@ public:
   virtual ~HWDebugScope() = default;
 
 protected:
+  /// Write the attributes shared by every scope into the currently open JSON
+  /// object. Child scopes are streamed directly to the output so that only the
+  /// current path of the scope tree is live at any time.
   // NOLINTNEXTLINE
-  [[nodiscard]] llvm::json::Object getScopeJSON(bool includeScope) const {
-    llvm::json::Object res;
+  void emitScopeJSON(llvm::json::OStream &os, bool includeScope) const {
     auto scopeType = type();
     if (scopeType != HWDebugScopeType::Block &&
         scopeType != HWDebugScopeType::Module) {
       // block and module does not have line number
-      res["line"] = line;
+      os.attribute("line", line);
       if (column > 0) {
-        res["column"] = column;
+        os.attribute("column", column);
       }
     }
 
-    res["type"] = toString(scopeType);
+    os.attribute("type", toString(scopeType));
     if (includeScope) {
-      setScope(res);
+      setScope(os);
     }
     if (type() == HWDebugScopeType::Block && !filename.empty()) {
-      res["filename"] = filename;
+      os.attribute("filename", filename);
     }
-    if (condition && condition.size() != 0) {
-      res["condition"] = condition.strref();
+    if (!condition.empty()) {
+      os.attribute("condition", condition);
+    }
+    if (!conditionCode.empty()) {
+      os.attributeArray("condition_code", [&] {
+        for (auto word : conditionCode)
+          os.value(word);
+      });
+    }
+    if (!triggers.empty()) {
+      os.attributeArray("triggers", [&] {
+        for (auto const &trigger : triggers) {
+          os.array([&] {
+            os.value(trigger.signal);
+            os.value(trigger.edge);
+          });
+        }
+      });
+    }
+    if (combinational) {
+      os.attribute("combinational", true);
     }
-    return res;
   }
 
   // NOLINTNEXTLINE
-  void setScope(llvm::json::Object &obj) const {
-    llvm::json::Array array;
-    array.reserve(scopes.size());
-    for (auto const *scope : scopes) {
-      if (scope)
-        array.emplace_back(scope->toJSON());
-    }
-    obj["scope"] = std::move(array);
+  void setScope(llvm::json::OStream &os) const {
+    os.attributeArray("scope", [&] {
+      for (auto const *scope : scopes) {
+        if (scope)
+          scope->toJSON(os);
+      }
+    });
   }
 };
 
@@ -165,12 +213,8 @@ struct HWDebugLineInfo : HWDebugScope {
   HWDebugLineInfo(HWDebugContext &context, LineType type, mlir::Operation *op)
       : HWDebugScope(context, op), lineType(type) {}
 
-  [[nodiscard]] llvm::json::Value toJSON() const override {
-    auto res = getScopeJSON(false);
-    if (condition && condition.size() != 0) {
-      res["condition"] = condition.strref();
-    }
-    return res;
+  void toJSON(llvm::json::OStream &os) const override {
+    os.object([&] { emitScopeJSON(os, false); });
   }
 
   [[nodiscard]] HWDebugScopeType type() const override {
@@ -183,25 +227,172 @@ struct HWDebugVarDef {
   mlir::StringRef value;
   // for how it's always RTL value
   bool rtl = true;
-  mlir::StringAttr id;
-
-  HWDebugVarDef(mlir::StringRef name, mlir::StringRef value, bool rtl,
-                mlir::StringAttr id)
-      : name(name), value(value), rtl(rtl), id(id) {}
+  // Numeric ID, optionally qualified by the module name in the incremental
+  // mode. Variables without an ID are written inline.
+  llvm::Optional<uint32_t> id;
+  mlir::StringRef idPrefix;
+
+  HWDebugVarDef(mlir::StringRef name, mlir::StringRef value, bool rtl)
+      : name(name), value(value), rtl(rtl) {}
+
+  [[nodiscard]] std::string getID() const {
+    if (idPrefix.empty())
+      return std::to_string(*id);
+    return (idPrefix + "." + llvm::Twine(*id)).str();
+  }
 
-  [[nodiscard]] llvm::json::Value toJSON() const {
+  void toJSON(llvm::json::OStream &os) const {
     if (id) {
-      return llvm::json::Value(id);
+      os.value(getID());
+      return;
     }
-    return llvm::json::Object({{"name", name}, {"value", value}, {"rtl", rtl}});
+    os.object([&] {
+      os.attribute("name", name);
+      os.attribute("value", value);
+      os.attribute("rtl", rtl);
+    });
   }
 
-  [[nodiscard]] llvm::json::Value toJSONDefinition() const {
-    return llvm::json::Object(
-        {{"name", name}, {"value", value}, {"rtl", rtl}, {"id", id.strref()}});
+  void toJSONDefinition(llvm::json::OStream &os) const {
+    os.object([&] {
+      os.attribute("name", name);
+      os.attribute("value", value);
+      os.attribute("rtl", rtl);
+      os.attribute("id", getID());
+    });
   }
 };
 
+struct HWDebugVarDeclareLineInfo : public HWDebugLineInfo {
+  HWDebugVarDeclareLineInfo(HWDebugContext &context, mlir::Operation *op)
+      : HWDebugLineInfo(context, LineType::Declare, op) {}
+
+  HWDebugVarDef *variable;
+
+  void toJSON(llvm::json::OStream &os) const override {
+    os.object([&] {
+      emitScopeJSON(os, false);
+      os.attributeBegin("variable");
+      variable->toJSON(os);
+      os.attributeEnd();
+    });
+  }
+};
+
+struct HWDebugVarAssignLineInfo : public HWDebugLineInfo {
+  // This also encodes mapping information
+  HWDebugVarAssignLineInfo(HWDebugContext &context, mlir::Operation *op)
+      : HWDebugLineInfo(context, LineType::Assign, op) {}
+
+  HWDebugVarDef *variable;
+
+  void toJSON(llvm::json::OStream &os) const override {
+    os.object([&] {
+      emitScopeJSON(os, false);
+      os.attributeBegin("variable");
+      variable->toJSON(os);
+      os.attributeEnd();
+    });
+  }
+};
+
+/// Owns every scope, variable definition and condition string created while
+/// collecting a single module. Each module gets its own arena so that modules
+/// can be visited concurrently without sharing any mutable state. Nodes are
+/// bump allocated and strings are interned once per module, which keeps the
+/// MLIRContext uniquer out of the collection.
+class HWDebugArena {
+public:
+  template <typename T, typename... Args>
+  T *createScope(Args &&...args) {
+    return new (getAllocator<T>().Allocate()) T(std::forward<Args>(args)...);
+  }
+
+  HWDebugVarDef *createVarDef(mlir::StringRef name, mlir::StringRef value) {
+    return new (varAllocator.Allocate()) HWDebugVarDef(name, value, true);
+  }
+
+  mlir::StringRef internString(mlir::StringRef str) {
+    return strings.save(str);
+  }
+
+  llvm::ArrayRef<int64_t> internCode(llvm::ArrayRef<int64_t> code) {
+    if (code.empty())
+      return {};
+    auto *words = stringAllocator.Allocate<int64_t>(code.size());
+    std::uninitialized_copy(code.begin(), code.end(), words);
+    return {words, code.size()};
+  }
+
+  llvm::ArrayRef<HWDebugTrigger>
+  internTriggers(llvm::ArrayRef<HWDebugTrigger> triggers) {
+    if (triggers.empty())
+      return {};
+    auto *entries = stringAllocator.Allocate<HWDebugTrigger>(triggers.size());
+    std::uninitialized_copy(triggers.begin(), triggers.end(), entries);
+    return {entries, triggers.size()};
+  }
+
+private:
+  llvm::SpecificBumpPtrAllocator<HWDebugScope> scopeAllocator;
+  llvm::SpecificBumpPtrAllocator<HWDebugVarDeclareLineInfo> declAllocator;
+  llvm::SpecificBumpPtrAllocator<HWDebugVarAssignLineInfo> assignAllocator;
+  llvm::SpecificBumpPtrAllocator<HWDebugVarDef> varAllocator;
+  llvm::BumpPtrAllocator stringAllocator;
+  llvm::UniqueStringSaver strings{stringAllocator};
+
+  // Kept in creation order. IDs are assigned once all modules are collected.
+  llvm::MapVector<const mlir::Operation *, HWDebugVarDef *> vars;
+
+  template <typename T>
+  llvm::SpecificBumpPtrAllocator<T> &getAllocator() {
+    if constexpr (std::is_same<T, HWDebugVarDeclareLineInfo>::value)
+      return declAllocator;
+    else if constexpr (std::is_same<T, HWDebugVarAssignLineInfo>::value)
+      return assignAllocator;
+    else
+      return scopeAllocator;
+  }
+
+  friend HWDebugBuilder;
+  friend HWDebugContext;
+  friend struct HWModuleInfo;
+};
+
+/// The serialized JSON of a single module entry and of the variables it
+/// defines.
+struct HWDebugTableFragment {
+  std::string table;
+  std::vector<std::string> variables;
+  // the location of every breakpoint of the module, for the breakpoint index
+  std::vector<std::pair<std::string, uint32_t>> breakpoints;
+};
+
+/// A line scope of a module, which the runtime can set a breakpoint on. The
+/// condition includes the conditions of all the enclosing scopes, so the
+/// runtime does not need to walk the scope tree to decide whether the
+/// breakpoint is enabled.
+struct HWDebugBreakpoint {
+  mlir::StringRef filename;
+  uint32_t line = 0;
+  uint32_t column = 0;
+  mlir::StringRef condition;
+  llvm::ArrayRef<int64_t> conditionCode;
+};
+
+/// Join the conditions of nested scopes, outermost first.
+static std::string joinConditions(llvm::ArrayRef<mlir::StringRef> conditions) {
+  if (conditions.size() == 1)
+    return conditions.front().str();
+  std::string condition;
+  for (auto cond : conditions) {
+    if (!condition.empty())
+      condition.append(" && ");
+    condition.append(("(" + cond + ")").str());
+  }
+  return condition;
+}
+
 struct HWModuleInfo : public HWDebugScope {
 public:
   // module names
@@ -211,6 +402,19 @@ public:
   llvm::DenseMap<mlir::StringRef, mlir::StringRef> instances;
   mlir::SmallVector<const HWDebugVarDef *> outputVars;
 
+  // storage for all the scopes and variables inside this module
+  HWDebugArena arena;
+
+  // Only used by the incremental mode: the content hash of the module, and
+  // its table either reused from the cache or serialized for it. Modules with
+  // a fragment are written from it rather than from their scopes.
+  std::string hash;
+  llvm::Optional<HWDebugTableFragment> fragment;
+
+  // The line scopes of this module, in the order in which they appear in the
+  // scope tree. Their position is their ID within the module.
+  llvm::SmallVector<HWDebugBreakpoint, 0> breakpoints;
+
   explicit HWModuleInfo(HWDebugContext &context,
                         circt::hw::HWModuleOp *moduleOp)
       : HWDebugScope(context, moduleOp->getOperation()) {
@@ -226,35 +430,51 @@ public:
       }
       // also add to the generator variables
       if (port.debugAttr) {
-        outputPorts.emplace_back(std::make_unique<HWDebugVarDef>(
-            port.debugAttr.strref(), n, true, mlir::StringAttr{}));
+        outputPorts.emplace_back(
+            std::make_unique<HWDebugVarDef>(port.debugAttr.strref(), n, true));
         variables.emplace_back(outputPorts.back().get());
         outputVars[port.argNum] = outputPorts.back().get();
       }
     }
   }
 
-  [[nodiscard]] llvm::json::Value toJSON() const override {
-    auto res = getScopeJSON(true);
-    res["name"] = name;
+  void toJSON(llvm::json::OStream &os) const override {
+    os.object([&] {
+      emitScopeJSON(os, true);
+      os.attribute("name", name);
 
-    llvm::json::Array vars;
-    vars.reserve(variables.size());
-    for (auto const *varDef : variables) {
-      vars.emplace_back(varDef->toJSON());
-    }
-    res["variables"] = std::move(vars);
+      writeVariables(os);
+
+      writeRTLIndex(os);
 
-    if (!instances.empty()) {
-      llvm::json::Array insts;
-      insts.reserve(instances.size());
-      for (auto const &[n, def] : instances) {
-        insts.emplace_back(llvm::json::Object{{"name", n}, {"module", def}});
+      if (!instances.empty()) {
+        os.attributeArray("instances", [&] {
+          for (auto const &[n, def] : instances) {
+            os.object([&] {
+              os.attribute("name", n);
+              os.attribute("module", def);
+            });
+          }
+        });
       }
-      res["instances"] = std::move(insts);
-    }
 
-    return res;
+      if (!signals.empty()) {
+        os.attributeArray("signals", [&] {
+          for (auto signal : signals)
+            os.value(signal);
+        });
+      }
+
+      writeBreakpoints(os);
+    });
+  }
+
+  /// Collect the breakpoints of this module and the conditions under which
+  /// they are enabled. This has to run after the scopes are normalized.
+  void collectBreakpoints() {
+    breakpoints.clear();
+    llvm::SmallVector<const HWDebugScope *> enclosing;
+    collectBreakpoints(this, filename, enclosing);
   }
 
   [[nodiscard]] HWDebugScopeType type() const override {
@@ -265,106 +485,486 @@ public:
     return portNames.lookup(value);
   }
 
+  /// Position of the RTL signal `name` in the signal table that condition
+  /// bytecode refers to.
+  unsigned getSignalIndex(mlir::StringRef name) {
+    auto [it, inserted] = signalIndices.try_emplace(name, signals.size());
+    if (inserted)
+      signals.emplace_back(name);
+    return it->second;
+  }
+
 private:
   llvm::DenseMap<mlir::Value, mlir::StringRef> portNames;
+  llvm::SmallVector<mlir::StringRef> signals;
+  llvm::DenseMap<mlir::StringRef, unsigned> signalIndices;
+
+  /// Stream [RTL name, variable ID] pairs for every variable of this module,
+  /// sorted by RTL name. Simulator signals can then be mapped to variables by
+  /// a binary search, without rebuilding a map every time hgdb attaches.
+  void writeRTLIndex(llvm::json::OStream &os) const {
+    llvm::SmallVector<const HWDebugVarDef *> index;
+    for (auto const &[_, var] : arena.vars) {
+      if (var->rtl && var->id)
+        index.emplace_back(var);
+    }
+    if (index.empty())
+      return;
+    llvm::stable_sort(index,
+                      [](const HWDebugVarDef *a, const HWDebugVarDef *b) {
+                        return a->value < b->value;
+                      });
+    os.attributeArray("rtl_index", [&] {
+      for (auto const *var : index) {
+        os.array([&] {
+          os.value(var->value);
+          os.value(var->getID());
+        });
+      }
+    });
+  }
   llvm::SmallVector<std::unique_ptr<HWDebugVarDef>> outputPorts;
-};
 
-struct HWDebugVarDeclareLineInfo : public HWDebugLineInfo {
-  HWDebugVarDeclareLineInfo(HWDebugContext &context, mlir::Operation *op)
-      : HWDebugLineInfo(context, LineType::Declare, op) {}
+  /// Split the name of a lowered aggregate field, e.g. `io.a.0` or `io.a_0`,
+  /// into its root and its field path, if its RTL name is derived from them as
+  /// `io_a_0`. Return an empty root otherwise.
+  static std::pair<mlir::StringRef, mlir::StringRef>
+  splitAggregateField(const HWDebugVarDef *var) {
+    auto [root, field] = var->name.split('.');
+    if (field.empty() || !var->rtl)
+      return {};
+    auto value = var->value;
+    if (!value.consume_front(root) || !value.consume_front("_") ||
+        value.size() != field.size())
+      return {};
+    for (size_t i = 0; i < field.size(); i++) {
+      auto c = field[i] == '.' ? '_' : field[i];
+      if (value[i] != c)
+        return {};
+    }
+    return {root, field};
+  }
 
-  HWDebugVarDef *variable;
+  /// Stream the generator variables. The variables written inline that are
+  /// fields of the same lowered aggregate, typically the ports of a bundle,
+  /// are written as a single entry listing the field paths. Field `f` of
+  /// aggregate `name` is the frontend variable `name.f`, which maps to the RTL
+  /// signal `name_f` with every `.` of `f` replaced by `_`. Variables with an
+  /// ID are already defined once in the table, so they are written as is.
+  void writeVariables(llvm::json::OStream &os) const {
+    llvm::MapVector<mlir::StringRef, llvm::SmallVector<mlir::StringRef>>
+        aggregates;
+    for (auto const *varDef : variables) {
+      if (varDef->id)
+        continue;
+      auto [root, field] = splitAggregateField(varDef);
+      if (!root.empty())
+        aggregates[root].emplace_back(field);
+    }
 
-  [[nodiscard]] llvm::json::Value toJSON() const override {
-    auto res = HWDebugLineInfo::toJSON();
-    (*res.getAsObject())["variable"] = variable->toJSON();
-    return res;
+    os.attributeArray("variables", [&] {
+      llvm::SmallDenseSet<mlir::StringRef> written;
+      for (auto const *varDef : variables) {
+        auto root =
+            varDef->id ? mlir::StringRef() : splitAggregateField(varDef).first;
+        auto it = root.empty() ? aggregates.end() : aggregates.find(root);
+        if (it == aggregates.end() || it->second.size() < 2) {
+          varDef->toJSON(os);
+          continue;
+        }
+        // the aggregate is written in place of its first field
+        if (!written.insert(root).second)
+          continue;
+        os.object([&] {
+          os.attribute("name", root);
+          os.attribute("value", root);
+          os.attribute("rtl", true);
+          os.attributeArray("fields", [&] {
+            for (auto field : it->second)
+              os.value(field);
+          });
+        });
+      }
+    });
   }
-};
-
-struct HWDebugVarAssignLineInfo : public HWDebugLineInfo {
-  // This also encodes mapping information
-  HWDebugVarAssignLineInfo(HWDebugContext &context, mlir::Operation *op)
-      : HWDebugLineInfo(context, LineType::Assign, op) {}
 
-  HWDebugVarDef *variable;
+  // NOLINTNEXTLINE(misc-no-recursion)
+  void
+  collectBreakpoints(const HWDebugScope *scope, mlir::StringRef filename,
+                     llvm::SmallVectorImpl<const HWDebugScope *> &enclosing) {
+    auto type = scope->type();
+    bool hasCondition = !scope->condition.empty();
+    if (hasCondition)
+      enclosing.emplace_back(scope);
+
+    if (type == HWDebugScopeType::Block || type == HWDebugScopeType::Module) {
+      if (!scope->filename.empty())
+        filename = scope->filename;
+      for (auto const *entry : scope->scopes) {
+        if (entry)
+          collectBreakpoints(entry, filename, enclosing);
+      }
+    } else if (scope->line != 0) {
+      auto &breakpoint = breakpoints.emplace_back();
+      breakpoint.filename = filename;
+      breakpoint.line = scope->line;
+      breakpoint.column = scope->column;
+      if (!enclosing.empty()) {
+        llvm::SmallVector<mlir::StringRef> conditions;
+        for (auto const *cond : enclosing)
+          conditions.emplace_back(cond->condition);
+        breakpoint.condition = arena.internString(joinConditions(conditions));
+
+        // The bytecode of the chain evaluates every condition and combines
+        // them, which is only possible if all of them have bytecode.
+        if (llvm::all_of(enclosing, [](const HWDebugScope *cond) {
+              return !cond->conditionCode.empty();
+            })) {
+          llvm::SmallVector<int64_t> code;
+          for (auto const *cond : enclosing) {
+            code.append(cond->conditionCode.begin(), cond->conditionCode.end());
+            if (cond != enclosing.front())
+              code.emplace_back(HGDBConditionCode::LogicalAnd);
+          }
+          breakpoint.conditionCode = arena.internCode(code);
+        }
+      }
+    }
 
-  [[nodiscard]] llvm::json::Value toJSON() const override {
-    auto res = HWDebugLineInfo::toJSON();
-    (*res.getAsObject())["variable"] = variable->toJSON();
-    return res;
+    if (hasCondition)
+      enclosing.pop_back();
   }
-};
 
-mlir::StringRef findTop(const llvm::SmallVector<HWModuleInfo *> &modules) {
-  llvm::SmallDenseSet<mlir::StringRef> names;
-  for (auto const *mod : modules) {
-    names.insert(mod->name);
-  }
-  for (auto const *m : modules) {
-    for (auto const &[_, name] : m->instances) {
-      names.erase(name);
-    }
+  /// Stream [filename, line, column, condition, condition code] for every
+  /// breakpoint of this module, in ID order. The condition code is only
+  /// present if it was requested.
+  void writeBreakpoints(llvm::json::OStream &os) const {
+    if (breakpoints.empty())
+      return;
+    os.attributeArray("breakpoints", [&] {
+      for (auto const &breakpoint : breakpoints) {
+        os.array([&] {
+          os.value(breakpoint.filename);
+          os.value(breakpoint.line);
+          os.value(breakpoint.column);
+          os.value(breakpoint.condition);
+          if (!breakpoint.conditionCode.empty()) {
+            os.array([&] {
+              for (auto word : breakpoint.conditionCode)
+                os.value(word);
+            });
+          }
+        });
+      }
+    });
   }
-  assert(names.size() == 1);
-  return *names.begin();
-}
+};
 
 class HWDebugContext {
 public:
-  [[nodiscard]] llvm::json::Value toJSON() const {
-    llvm::json::Object res{{"generator", "circt"}};
-    llvm::json::Array array;
-    array.reserve(modules.size());
-    for (auto const *module : modules) {
-      array.emplace_back(std::move(module->toJSON()));
-    }
-    res["table"] = std::move(array);
-    // if we have variable reference in the context
-    if (!vars.empty()) {
-      array.clear();
-      array.reserve(vars.size());
-      for (auto const &[_, var] : vars) {
-        array.emplace_back(std::move(var->toJSONDefinition()));
+  /// Stream the whole debug table to `os`. Modules and scopes are written one
+  /// at a time, so no JSON DOM for the design is ever materialized.
+  void toJSON(llvm::json::OStream &os) const {
+    os.object([&] {
+      os.attribute("generator", "circt");
+      os.attributeArray("table", [&] {
+        for (auto const *module : modules) {
+          if (module->fragment)
+            os.rawValue(module->fragment->table);
+          else
+            module->toJSON(os);
+        }
+      });
+      // if we have variable reference in the context
+      if (hasVariables()) {
+        os.attributeArray("variables", [&] {
+          for (auto const *module : modules) {
+            if (module->fragment) {
+              for (auto const &var : module->fragment->variables)
+                os.rawValue(var);
+              continue;
+            }
+            for (auto const &[_, var] : module->arena.vars) {
+              var->toJSONDefinition(os);
+            }
+          }
+        });
+      }
+      writeHierarchy(os);
+      writeBreakpointIndex(os);
+      os.attribute("top", top ? top->name : "");
+    });
+  }
+
+  /// Find the top module and index the hierarchy through the instance graph.
+  /// Modules without a debug table, e.g. external ones, are never the top.
+  void setInstanceGraph(circt::hw::InstanceGraph &graph) {
+    instanceGraph = &graph;
+    for (unsigned i = 0; i < modules.size(); i++)
+      moduleIndices[modules[i]->op] = i;
+    top = nullptr;
+    auto tops = graph.getInferredTopLevelNodes();
+    if (failed(tops))
+      return;
+    for (auto *node : *tops) {
+      auto it = moduleIndices.find(node->getModule().getOperation());
+      if (it != moduleIndices.end()) {
+        top = modules[it->second];
+        break;
       }
-      res["variables"] = std::move(array);
     }
-    auto top = findTop(modules);
-    res["top"] = top;
-    return res;
   }
 
-  template <typename T, typename... Args>
-  T *createScope(Args &&...args) {
-    auto ptr = std::make_unique<T>(std::forward<Args>(args)...);
+  [[nodiscard]] const HWModuleInfo *getTop() const { return top; }
+
+  HWModuleInfo *createModule(circt::hw::HWModuleOp *op) {
+    auto ptr = std::make_unique<HWModuleInfo>(*this, op);
     auto *res = ptr.get();
-    scopes.emplace_back(std::move(ptr));
-    if constexpr (std::is_same<T, HWModuleInfo>::value) {
-      modules.emplace_back(res);
-    }
+    setEntryLocation(*res, op->getLoc());
+    moduleStorage.emplace_back(std::move(ptr));
+    modules.emplace_back(res);
     return res;
   }
 
-  HWDebugScope *getNormalScope(::mlir::Operation *op) {
-    auto *ptr = createScope<HWDebugScope>(*this, op);
-    if (op)
-      setEntryLocation(*ptr, op->getLoc());
-    return ptr;
+  /// Number the variables of every module. This has to run after all the
+  /// modules are collected, and walks them in module order so that the IDs do
+  /// not depend on how the collection was scheduled. If `moduleLocal` is set,
+  /// IDs are numbered per module and prefixed with the module name, which
+  /// keeps them stable when the table of other modules changes.
+  void assignVariableIDs(bool moduleLocal) {
+    uint32_t numVars = 0;
+    for (auto *module : modules) {
+      if (moduleLocal)
+        numVars = 0;
+      for (auto &[_, var] : module->arena.vars) {
+        var->id = numVars++;
+        if (moduleLocal)
+          var->idPrefix = module->name;
+      }
+    }
+  }
+
+  [[nodiscard]] bool hasVariables() const {
+    return llvm::any_of(modules, [](HWModuleInfo *module) {
+      return module->fragment ? !module->fragment->variables.empty()
+                              : !module->arena.vars.empty();
+    });
   }
 
-  [[nodiscard]] const llvm::SmallVector<HWModuleInfo *> &getModules() const {
+  [[nodiscard]] llvm::ArrayRef<HWModuleInfo *> getModules() const {
     return modules;
   }
 
 private:
   llvm::SmallVector<HWModuleInfo *> modules;
-  llvm::SmallVector<std::unique_ptr<HWDebugScope>> scopes;
-  llvm::DenseMap<const mlir::Operation *, std::unique_ptr<HWDebugVarDef>> vars;
+  llvm::SmallVector<std::unique_ptr<HWModuleInfo>> moduleStorage;
+
+  circt::hw::InstanceGraph *instanceGraph = nullptr;
+  // position of each module in the table
+  llvm::DenseMap<mlir::Operation *, unsigned> moduleIndices;
+  const HWModuleInfo *top = nullptr;
+
+  /// Stream the instance hierarchy below the top module. Every module table is
+  /// only written once, and every instance is listed as [parent, name, table
+  /// index], where parent is the position of the parent instance in this
+  /// list. Full paths are therefore never repeated.
+  void writeHierarchy(llvm::json::OStream &os) const {
+    os.attributeArray("hierarchy", [&] {
+      if (!top || !instanceGraph)
+        return;
+      auto *topNode =
+          instanceGraph->lookup(mlir::cast<circt::hw::HWModuleLike>(top->op));
+      os.array([&] {
+        os.value(-1);
+        os.value(top->name);
+        os.value(moduleIndices.lookup(top->op));
+      });
+      int64_t numInstances = 0;
+      llvm::SmallVector<std::pair<circt::hw::InstanceGraphNode *, int64_t>>
+          worklist;
+      worklist.emplace_back(topNode, numInstances++);
+      while (!worklist.empty()) {
+        auto [node, id] = worklist.pop_back_val();
+        for (auto *record : *node) {
+          auto *target = record->getTarget();
+          auto it = moduleIndices.find(target->getModule().getOperation());
+          if (it == moduleIndices.end())
+            continue;
+          os.array([&] {
+            os.value(id);
+            os.value(getSymOpName(record->getInstance().getOperation()));
+            os.value(it->second);
+          });
+          worklist.emplace_back(target, numInstances++);
+        }
+      }
+    });
+  }
 
-  friend HWDebugBuilder;
+  /// Stream [filename, line, table index, breakpoint ID] for the breakpoints
+  /// of every module, sorted by filename and line. The runtime can then find
+  /// the breakpoints at a source line by a binary search rather than walking
+  /// the scopes of every module.
+  void writeBreakpointIndex(llvm::json::OStream &os) const {
+    struct Entry {
+      mlir::StringRef filename;
+      uint32_t line;
+      unsigned table;
+      unsigned id;
+    };
+    llvm::SmallVector<Entry, 0> index;
+    for (unsigned table = 0; table < modules.size(); table++) {
+      auto const &breakpoints = modules[table]->breakpoints;
+      for (unsigned id = 0; id < breakpoints.size(); id++)
+        index.push_back(
+            {breakpoints[id].filename, breakpoints[id].line, table, id});
+    }
+    llvm::sort(index, [](const Entry &a, const Entry &b) {
+      return std::tie(a.filename, a.line, a.table, a.id) <
+             std::tie(b.filename, b.line, b.table, b.id);
+    });
+    os.attributeArray("breakpoint_index", [&] {
+      for (auto const &entry : index) {
+        os.array([&] {
+          os.value(entry.filename);
+          os.value(entry.line);
+          os.value(entry.table);
+          os.value(entry.id);
+        });
+      }
+    });
+  }
 };
 
+/// Debug table fragments from a previous run, keyed by the content hash of the
+/// module they were produced from.
+class HWDebugTableCache {
+public:
+  /// Load the cache file. A missing or malformed file is an empty cache.
+  void load(llvm::StringRef filename) {
+    auto buffer = llvm::MemoryBuffer::getFile(filename);
+    if (!buffer)
+      return;
+    auto json = llvm::json::parse((*buffer)->getBuffer());
+    if (!json) {
+      llvm::consumeError(json.takeError());
+      return;
+    }
+    auto *root = json->getAsObject();
+    auto *entries = root ? root->getArray("modules") : nullptr;
+    if (!entries)
+      return;
+    for (auto &entry : *entries) {
+      auto *obj = entry.getAsObject();
+      if (!obj)
+        continue;
+      auto hash = obj->getString("hash");
+      auto table = obj->getString("table");
+      auto *vars = obj->getArray("variables");
+      if (!hash || !table || !vars)
+        continue;
+      HWDebugTableFragment fragment;
+      fragment.table = table->str();
+      for (auto &var : *vars) {
+        if (auto str = var.getAsString())
+          fragment.variables.emplace_back(str->str());
+      }
+      if (auto *breakpoints = obj->getArray("breakpoints")) {
+        for (auto &entry : *breakpoints) {
+          auto *pair = entry.getAsArray();
+          if (!pair || pair->size() != 2)
+            continue;
+          auto file = (*pair)[0].getAsString();
+          auto line = (*pair)[1].getAsInteger();
+          if (file && line)
+            fragment.breakpoints.emplace_back(file->str(), *line);
+        }
+      }
+      fragments[*hash] = std::move(fragment);
+    }
+  }
+
+  const HWDebugTableFragment *lookup(llvm::StringRef hash) const {
+    auto it = fragments.find(hash);
+    return it == fragments.end() ? nullptr : &it->second;
+  }
+
+  /// Write the fragments of the current run, dropping the ones of modules that
+  /// no longer exist.
+  static void save(llvm::StringRef filename,
+                   llvm::ArrayRef<HWModuleInfo *> modules) {
+    std::error_code error;
+    llvm::raw_fd_ostream os(filename, error);
+    if (error)
+      return;
+    llvm::json::OStream json(os);
+    json.object([&] {
+      json.attribute("version", 2);
+      json.attributeArray("modules", [&] {
+        for (auto const *module : modules) {
+          json.object([&] {
+            json.attribute("hash", module->hash);
+            json.attribute("table", module->fragment->table);
+            json.attributeArray("variables", [&] {
+              for (auto const &var : module->fragment->variables)
+                json.value(var);
+            });
+            json.attributeArray("breakpoints", [&] {
+              for (auto const &[file, line] : module->fragment->breakpoints)
+                json.array([&] {
+                  json.value(file);
+                  json.value(line);
+                });
+            });
+          });
+        }
+      });
+    });
+  }
+
+private:
+  llvm::StringMap<HWDebugTableFragment> fragments;
+};
+
+/// Feeds everything written to it into a SHA256 hash.
+class HashOStream : public llvm::raw_ostream {
+public:
+  explicit HashOStream(llvm::SHA256 &sha) : sha(sha) {}
+  ~HashOStream() override { flush(); }
+
+private:
+  llvm::SHA256 &sha;
+  uint64_t pos = 0;
+
+  void write_impl(const char *ptr, size_t size) override {
+    sha.update(llvm::ArrayRef<uint8_t>(
+        reinterpret_cast<const uint8_t *>(ptr), size));
+    pos += size;
+  }
+
+  uint64_t current_pos() const override { return pos; }
+};
+
+/// Compute a hash of everything the debug table of `mod` is derived from: the
+/// module itself, including locations and attributes, the names of the
+/// modules it instantiates, and the export options.
+std::string getModuleHash(circt::hw::HWModuleOp mod, bool conditionCode) {
+  llvm::SHA256 sha;
+  {
+    HashOStream os(sha);
+    os << "condition-code=" << conditionCode << '\n';
+    mod->print(os, mlir::OpPrintingFlags()
+                       .enableDebugInfo()
+                       .useLocalScope()
+                       .assumeVerified());
+    for (auto inst : mod.getBodyBlock()->getOps<circt::hw::InstanceOp>()) {
+      auto *referenced = inst.getReferencedModule(nullptr);
+      os << circt::hw::getVerilogModuleNameAttr(referenced).getValue() << '\n';
+    }
+  }
+  return llvm::toHex(sha.final(), /*LowerCase=*/true);
+}
+
 // NOLINTNEXTLINE
 mlir::FileLineColLoc getFileLineColLocFromLoc(const mlir::Location &location) {
   // if it's a fused location, the first one will be used
@@ -397,7 +997,8 @@ void setEntryLocation(HWDebugScope &scope, const mlir::Location &location) {
 
 class HWDebugBuilder {
 public:
-  HWDebugBuilder(HWDebugContext &context) : context(context) {}
+  HWDebugBuilder(HWDebugContext &context, HWDebugArena &arena)
+      : context(context), arena(arena) {}
 
   HWDebugVarDeclareLineInfo *createVarDeclaration(::mlir::Value value) {
     auto loc = value.getLoc();
@@ -408,7 +1009,7 @@ public:
 
     // need to get the containing module, as well as the line number
     // information
-    auto *info = context.createScope<HWDebugVarDeclareLineInfo>(context, op);
+    auto *info = arena.createScope<HWDebugVarDeclareLineInfo>(context, op);
     setEntryLocation(*info, loc);
     info->variable = createVarDef(targetOp);
     return info;
@@ -423,7 +1024,7 @@ public:
 
     auto loc = op->getLoc();
 
-    auto *assign = context.createScope<HWDebugVarAssignLineInfo>(context, op);
+    auto *assign = arena.createScope<HWDebugVarAssignLineInfo>(context, op);
     setEntryLocation(*assign, loc);
 
     assign->variable = createVarDef(targetOp);
@@ -432,8 +1033,8 @@ public:
   }
 
   HWDebugVarDef *createVarDef(::mlir::Operation *op) {
-    auto it = context.vars.find(op);
-    if (it == context.vars.end()) {
+    auto it = arena.vars.find(op);
+    if (it == arena.vars.end()) {
       // The OP has to have this attr. need to check before calling this
       // function
       auto frontEndName =
@@ -444,27 +1045,34 @@ public:
       } else {
         rtlName = getSymOpName(op);
       }
-      // For now, we use the size of the map as ID
-      auto id = mlir::StringAttr::get(op->getContext(),
-                                      std::to_string(context.vars.size()));
-      auto var =
-          std::make_unique<HWDebugVarDef>(frontEndName, rtlName, true, id);
+      // The ID is filled in by HWDebugContext::assignVariableIDs once every
+      // module has been collected
+      auto *var = arena.createVarDef(frontEndName, rtlName);
 
-      it = context.vars.insert(std::make_pair(op, std::move(var))).first;
+      it = arena.vars.insert(std::make_pair(op, var)).first;
     }
 
-    return it->second.get();
+    return it->second;
   }
 
-  HWModuleInfo *createModule(circt::hw::HWModuleOp *op) {
-    auto *info = context.createScope<HWModuleInfo>(context, op);
-    setEntryLocation(*info, op->getLoc());
-    return info;
+  mlir::StringRef internString(mlir::StringRef str) {
+    return arena.internString(str);
+  }
+
+  llvm::ArrayRef<int64_t> internCode(llvm::ArrayRef<int64_t> code) {
+    return arena.internCode(code);
+  }
+
+  llvm::ArrayRef<HWDebugTrigger>
+  internTriggers(llvm::ArrayRef<HWDebugTrigger> triggers) {
+    return arena.internTriggers(triggers);
   }
 
   HWDebugScope *createScope(::mlir::Operation *op,
                             HWDebugScope *parent = nullptr) {
-    auto *res = context.getNormalScope(op);
+    auto *res = arena.createScope<HWDebugScope>(context, op);
+    if (op)
+      setEntryLocation(*res, op->getLoc());
     if (parent) {
       res->parent = parent;
       parent->scopes.emplace_back(res);
@@ -474,6 +1082,7 @@ public:
 
 private:
   HWDebugContext &context;
+  HWDebugArena &arena;
 
   static mlir::Operation *getDebugOp(mlir::Value value, mlir::Operation *op) {
     auto *valueOP = value.getDefiningOp();
@@ -487,6 +1096,17 @@ private:
   }
 };
 
+/// A printed expression, and its bytecode if it was requested and every
+/// operation in it can be encoded.
+struct DebugExpr {
+  mlir::StringRef text;
+  llvm::Optional<llvm::ArrayRef<int64_t>> code;
+};
+
+/// Printed expressions of a single module, keyed by the value they print.
+/// The strings and the bytecode are interned in the module's arena.
+using DebugExprCache = llvm::DenseMap<mlir::Value, DebugExpr>;
+
 // hgdb only supports a subsets of operations, nor does it support sign
 // conversion. if the expression is complex we need to insert another pass that
 // generate a temp wire that holds the expression and use that in hgdb instead.
@@ -496,8 +1116,12 @@ class DebugExprPrinter
       public circt::hw::TypeOpVisitor<DebugExprPrinter>,
       public circt::sv::Visitor<DebugExprPrinter> {
 public:
-  explicit DebugExprPrinter(llvm::raw_ostream &os, HWModuleInfo *module)
-      : os(os), module(module) {}
+  /// If `code` is set, the expression is also appended to it as postfix
+  /// bytecode. `hasCode()` tells whether the bytecode is complete.
+  explicit DebugExprPrinter(llvm::raw_svector_ostream &os, HWModuleInfo *module,
+                            DebugExprCache &cache, HWDebugBuilder &builder,
+                            llvm::SmallVectorImpl<int64_t> *code = nullptr)
+      : os(os), module(module), cache(cache), builder(builder), code(code) {}
 
   void printExpr(mlir::Value value) {
     auto *op = value.getDefiningOp();
@@ -505,37 +1129,81 @@ public:
       auto name = getSymOpName(op);
       if (!name.empty()) {
         os << name;
+        emitSignal(name);
         return;
       }
     }
     if (op) {
+      // every sub-expression is only ever printed once per module
+      auto it = cache.find(value);
+      if (it != cache.end()) {
+        os << it->second.text;
+        if (code) {
+          // the expression may be cached before the bytecode was requested
+          if (it->second.code)
+            code->append(it->second.code->begin(), it->second.code->end());
+          else
+            validCode = false;
+        }
+        return;
+      }
+      auto start = os.tell();
+      auto codeStart = code ? code->size() : 0;
+      bool wasValid = validCode;
+      validCode = true;
       dispatchCombinationalVisitor(op);
+      DebugExpr expr{builder.internString(os.str().drop_front(start)), {}};
+      if (code && validCode)
+        expr.code = builder.internCode(
+            llvm::makeArrayRef(*code).drop_front(codeStart));
+      validCode &= wasValid;
+      cache[value] = expr;
     } else {
       auto ref = module->getPortName(value);
       os << ref;
+      emitSignal(ref);
     }
   }
+
+  [[nodiscard]] bool hasCode() const { return code && validCode; }
+
   // comb ops
   using CombinationalVisitor::visitComb;
   // supported
-  void visitComb(circt::comb::AddOp op) { visitBinary(op, "+"); }
-  void visitComb(circt::comb::SubOp op) { visitBinary(op, "-"); }
+  void visitComb(circt::comb::AddOp op) {
+    visitBinary(op, "+", HGDBConditionCode::Add);
+  }
+  void visitComb(circt::comb::SubOp op) {
+    visitBinary(op, "-", HGDBConditionCode::Sub);
+  }
   void visitComb(circt::comb::MulOp op) {
     assert(op.getNumOperands() == 2 && "prelowering should handle variadics");
-    return visitBinary(op, "*");
+    return visitBinary(op, "*", HGDBConditionCode::Mul);
+  }
+  void visitComb(circt::comb::DivUOp op) {
+    visitBinary(op, "/", HGDBConditionCode::DivU);
+  }
+  void visitComb(circt::comb::DivSOp op) {
+    visitBinary(op, "/", HGDBConditionCode::DivS);
+  }
+  void visitComb(circt::comb::ModUOp op) {
+    visitBinary(op, "%", HGDBConditionCode::ModU);
+  }
+  void visitComb(circt::comb::ModSOp op) {
+    visitBinary(op, "%", HGDBConditionCode::ModS);
   }
-  void visitComb(circt::comb::DivUOp op) { visitBinary(op, "/"); }
-  void visitComb(circt::comb::DivSOp op) { visitBinary(op, "/"); }
-  void visitComb(circt::comb::ModUOp op) { visitBinary(op, "%"); }
-  void visitComb(circt::comb::ModSOp op) { visitBinary(op, "%"); }
 
-  void visitComb(circt::comb::AndOp op) { visitBinary(op, "&"); }
-  void visitComb(circt::comb::OrOp op) { visitBinary(op, "|"); }
+  void visitComb(circt::comb::AndOp op) {
+    visitBinary(op, "&", HGDBConditionCode::And);
+  }
+  void visitComb(circt::comb::OrOp op) {
+    visitBinary(op, "|", HGDBConditionCode::Or);
+  }
   void visitComb(circt::comb::XorOp op) {
     if (op.isBinaryNot())
-      visitUnary(op, "~");
+      visitUnary(op, "~", HGDBConditionCode::Not);
     else
-      visitBinary(op, "^");
+      visitBinary(op, "^", HGDBConditionCode::Xor);
   }
 
   void visitComb(circt::comb::ICmpOp op) {
@@ -544,7 +1212,10 @@ public:
     const char *symop[] = {"==", "!=", "<",  "<=", ">",
                            ">=", "<",  "<=", ">",  ">="};
     auto pred = static_cast<uint64_t>(op.getPredicate());
-    visitBinary(op, symop[pred]);
+    // the bytecode opcodes follow the order of the predicates
+    visitBinary(op, symop[pred],
+                static_cast<HGDBConditionCode::Opcode>(HGDBConditionCode::Eq +
+                                                       pred));
   }
 
   // type ops
@@ -569,7 +1240,8 @@ public:
     abort();
   }
 
-  void visitBinary(mlir::Operation *op, mlir::StringRef opStr) {
+  void visitBinary(mlir::Operation *op, mlir::StringRef opStr,
+                   HGDBConditionCode::Opcode opcode) {
     // always emit paraphrases
     os << '(';
     auto left = op->getOperand(0);
@@ -578,20 +1250,36 @@ public:
     auto right = op->getOperand(1);
     printExpr(right);
     os << ')';
+    if (code)
+      code->emplace_back(opcode);
   }
 
-  void visitUnary(mlir::Operation *op, mlir::StringRef opStr) {
+  void visitUnary(mlir::Operation *op, mlir::StringRef opStr,
+                  HGDBConditionCode::Opcode opcode) {
     // always emit paraphrases
     os << '(';
     os << opStr;
     auto target = op->getOperand(0);
     printExpr(target);
     os << ')';
+    if (code)
+      code->emplace_back(opcode);
   }
 
 private:
-  llvm::raw_ostream &os;
+  llvm::raw_svector_ostream &os;
   HWModuleInfo *module;
+  DebugExprCache &cache;
+  HWDebugBuilder &builder;
+  llvm::SmallVectorImpl<int64_t> *code;
+  bool validCode = true;
+
+  void emitSignal(mlir::StringRef name) {
+    if (!code)
+      return;
+    code->emplace_back(HGDBConditionCode::Signal);
+    code->emplace_back(module->getSignalIndex(name));
+  }
 
   void printConstant(const llvm::APInt &value) {
     bool isNegated = false;
@@ -606,18 +1294,34 @@ private:
       value.toStringUnsigned(valueStr, 10);
     }
     os << valueStr;
+
+    if (!code)
+      return;
+    // only encode the constants that fit into a bytecode word
+    auto magnitude = isNegated ? -value : value;
+    if (magnitude.getActiveBits() > 63) {
+      validCode = false;
+      return;
+    }
+    auto word = static_cast<int64_t>(magnitude.getZExtValue());
+    code->emplace_back(HGDBConditionCode::Constant);
+    code->emplace_back(isNegated ? -word : word);
   }
 };
 
 class DebugStmtVisitor : public circt::hw::StmtVisitor<DebugStmtVisitor>,
                          public circt::sv::Visitor<DebugStmtVisitor, void> {
 public:
-  DebugStmtVisitor(HWDebugBuilder &builder, HWModuleInfo *module)
-      : builder(builder), module(module), currentScope(module) {}
+  DebugStmtVisitor(HWDebugBuilder &builder, HWModuleInfo *module,
+                   bool conditionCode = false)
+      : builder(builder), module(module), currentScope(module),
+        conditionCode(conditionCode) {}
 
   using StmtVisitor::visitStmt;
 
-  void visitStmt(circt::hw::InstanceOp op) {
+  void visitStmt(circt::hw::InstanceOp op) { addInstance(module, op); }
+
+  static void addInstance(HWModuleInfo *module, circt::hw::InstanceOp op) {
     auto instNameRef = getSymOpName(op);
     // need to find definition names
     auto *mod = op.getReferencedModule(nullptr);
@@ -700,6 +1404,15 @@ public:
   void visitSV(circt::sv::AlwaysOp op) {
     // creating a scope
     auto *scope = builder.createScope(op, currentScope);
+    llvm::SmallVector<HWDebugTrigger> triggers;
+    for (size_t i = 0; i < op.getNumConditions(); i++) {
+      auto cond = op.getCondition(i);
+      if (!addTrigger(triggers, cond.value, cond.event)) {
+        triggers.clear();
+        break;
+      }
+    }
+    scope->triggers = builder.internTriggers(triggers);
     auto *temp = currentScope;
     currentScope = scope;
     visitBlock(*op.getBodyBlock());
@@ -708,6 +1421,7 @@ public:
 
   void visitSV(circt::sv::AlwaysCombOp op) { // creating a scope
     auto *scope = builder.createScope(op, currentScope);
+    scope->combinational = true;
     auto *temp = currentScope;
     currentScope = scope;
     visitBlock(*op.getBodyBlock());
@@ -715,9 +1429,19 @@ public:
   }
 
   void visitSV(circt::sv::AlwaysFFOp op) {
+    // both blocks run on the clock edge, and on the reset edge if the reset is
+    // asynchronous
+    llvm::SmallVector<HWDebugTrigger, 2> triggers;
+    if (addTrigger(triggers, op.getClock(), op.getClockEdge()) &&
+        op.getResetStyle() == circt::sv::ResetType::AsyncReset &&
+        !addTrigger(triggers, op.getReset(), *op.getResetEdge()))
+      triggers.clear();
+    auto sensitivity = builder.internTriggers(triggers);
+
     if (op.getResetBlock()) {
       // creating a scope
       auto *scope = builder.createScope(op, currentScope);
+      scope->triggers = sensitivity;
       auto *temp = currentScope;
       currentScope = scope;
       visitBlock(*op.getResetBlock());
@@ -726,6 +1450,7 @@ public:
     {
       // creating a scope
       auto *scope = builder.createScope(op, currentScope);
+      scope->triggers = sensitivity;
       auto *temp = currentScope;
       currentScope = scope;
       visitBlock(*op.getBodyBlock());
@@ -743,11 +1468,10 @@ public:
 
   void visitSV(circt::sv::IfOp op) {
     // first, the statement itself is a line
-    auto cond = getCondString(op.getCond());
-    if (cond.empty()) {
+    auto cond = getCond(op.getCond());
+    if (cond.text.empty()) {
       op.getCond().getDefiningOp()->emitError(
           "Unsupported if statement condition");
-      cond = getCondString(op.getCond());
       return;
     }
     builder.createScope(op, currentScope);
@@ -757,7 +1481,7 @@ public:
         auto *trueBlock = builder.createScope(op, currentScope);
         auto *temp = currentScope;
         currentScope = trueBlock;
-        trueBlock->condition = mlir::StringAttr::get(op.getContext(), cond);
+        setCondition(trueBlock, cond);
         visitBlock(*body);
         currentScope = temp;
       }
@@ -769,8 +1493,7 @@ public:
         auto *elseBlock = builder.createScope(op, currentScope);
         auto *temp = currentScope;
         currentScope = elseBlock;
-        elseBlock->condition =
-            mlir::StringAttr::get(op->getContext(), "!" + cond);
+        setCondition(elseBlock, getNegatedCond(op.getCond()));
         visitBlock(*elseBody);
         currentScope = temp;
       }
@@ -778,23 +1501,34 @@ public:
   }
 
   void visitSV(circt::sv::CaseOp op) {
-    auto cond = getCondString(op.getCond());
+    auto condExpr = getCond(op.getCond());
+    auto cond = condExpr.text.str();
     if (cond.empty()) {
       op->emitError("Unsupported case statement condition");
       return;
     }
 
-    auto addScope = [op, this](const std::string &caseCond,
-                               mlir::Block *block) {
+    auto addScope = [this](const std::string &caseCond,
+                           llvm::ArrayRef<int64_t> caseCode,
+                           mlir::Block *block) {
       // use nullptr since it's auxiliary
       auto *scope = builder.createScope(nullptr, currentScope);
       auto *temp = currentScope;
       currentScope = scope;
-      scope->condition = StringAttr::get(op->getContext(), caseCond);
+      scope->condition = builder.internString(caseCond);
+      scope->conditionCode = builder.internCode(caseCode);
       visitBlock(*block);
       currentScope = temp;
     };
 
+    // append `cond <opcode> value` to the bytecode
+    auto compare = [&](llvm::SmallVectorImpl<int64_t> &code, uint64_t value,
+                       HGDBConditionCode::Opcode opcode) {
+      code.append(condExpr.code->begin(), condExpr.code->end());
+      code.append({HGDBConditionCode::Constant, static_cast<int64_t>(value),
+                   opcode});
+    };
+
     mlir::Block *defaultBlock = nullptr;
     llvm::SmallVector<uint64_t> values;
     for (auto const &caseInfo : op.getCases()) {
@@ -805,25 +1539,34 @@ public:
       } else {
         // Currently, hgdb doesn't support z or ?
         // so we have to turn the pattern into an integer
-        auto attr = pattern->attr();
-        if (auto value = mlir::isa<mlir::IntegerAttr>(attr)) {
-          auto caseCond = cond + " == " + std::to_string(value);
-          addScope(caseCond, caseInfo.block);
-          values.emplace_back(value);
+        auto value = getCaseValue(pattern.get());
+        if (value) {
+          auto caseCond = cond + " == " + std::to_string(*value);
+          llvm::SmallVector<int64_t> caseCode;
+          if (condExpr.code)
+            compare(caseCode, *value, HGDBConditionCode::Eq);
+          addScope(caseCond, caseCode, caseInfo.block);
+          values.emplace_back(*value);
         }
       }
     }
     if (defaultBlock) {
       // negate all values
       std::string defaultCond;
+      llvm::SmallVector<int64_t> defaultCode;
       for (auto i = 0u; i < values.size(); i++) {
         defaultCond.append("(" + cond + " != " + std::to_string(values[i]) +
                            ")");
         if (i != (values.size() - 1)) {
           defaultCond.append(" && ");
         }
+        if (condExpr.code) {
+          compare(defaultCode, values[i], HGDBConditionCode::Ne);
+          if (i > 0)
+            defaultCode.emplace_back(HGDBConditionCode::LogicalAnd);
+        }
       }
-      addScope(defaultCond, defaultBlock);
+      addScope(defaultCond, defaultCode, defaultBlock);
     }
   }
 
@@ -846,17 +1589,77 @@ private:
   HWModuleInfo *module;
   HWDebugScope *currentScope;
 
-  bool hasDebug(mlir::Operation *op) {
-    auto r = op && op->hasAttr("hw.debug.name");
-    return r;
-  }
+  bool hasDebug(mlir::Operation *op) { return circt::hw::isDebugSignal(op); }
+
+  // whether conditions are also emitted as bytecode
+  bool conditionCode;
+
+  // printed conditions, shared by all the scopes in this module
+  DebugExprCache exprCache;
+  DebugExprCache negatedExprCache;
 
-  std::string getCondString(mlir::Value value) const {
-    std::string cond;
-    llvm::raw_string_ostream os(cond);
-    DebugExprPrinter p(os, module);
+  DebugExpr getCond(mlir::Value value) {
+    SmallString<64> cond;
+    llvm::raw_svector_ostream os(cond);
+    llvm::SmallVector<int64_t> code;
+    DebugExprPrinter p(os, module, exprCache, builder,
+                       conditionCode ? &code : nullptr);
     p.printExpr(value);
-    return cond;
+    DebugExpr expr{builder.internString(cond), {}};
+    if (p.hasCode())
+      expr.code = builder.internCode(code);
+    return expr;
+  }
+
+  /// Add the edge of `signal` to `triggers`. Return false if the signal can
+  /// not be printed, in which case the runtime has to evaluate the block on
+  /// every edge.
+  bool addTrigger(llvm::SmallVectorImpl<HWDebugTrigger> &triggers,
+                  mlir::Value signal, circt::sv::EventControl edge) {
+    auto expr = getCond(signal);
+    if (expr.text.empty())
+      return false;
+    triggers.push_back({expr.text, circt::sv::stringifyEventControl(edge)});
+    return true;
+  }
+
+  DebugExpr getNegatedCond(mlir::Value value) {
+    auto it = negatedExprCache.find(value);
+    if (it != negatedExprCache.end())
+      return it->second;
+    auto cond = getCond(value);
+    DebugExpr negated{cond.text, {}};
+    if (!cond.text.empty()) {
+      negated.text = builder.internString(("!" + cond.text).str());
+      if (cond.code) {
+        llvm::SmallVector<int64_t> code(cond.code->begin(), cond.code->end());
+        code.emplace_back(HGDBConditionCode::LogicalNot);
+        negated.code = builder.internCode(code);
+      }
+    }
+    negatedExprCache[value] = negated;
+    return negated;
+  }
+
+  static void setCondition(HWDebugScope *scope, const DebugExpr &cond) {
+    scope->condition = cond.text;
+    if (cond.code)
+      scope->conditionCode = *cond.code;
+  }
+
+  /// The value matched by a case pattern, if it has no x or z bits and fits
+  /// into 64 bits.
+  static llvm::Optional<uint64_t>
+  getCaseValue(const circt::sv::CasePattern *pattern) {
+    auto *bits = llvm::dyn_cast<circt::sv::CaseBitPattern>(pattern);
+    if (!bits || bits->hasX() || bits->hasZ() || bits->getWidth() > 64)
+      return {};
+    uint64_t value = 0;
+    for (size_t i = 0, e = bits->getWidth(); i < e; ++i) {
+      if (bits->getBit(i) == circt::sv::CasePatternBit::One)
+        value |= uint64_t(1) << i;
+    }
+    return value;
   }
 
   // NOLINTNEXTLINE
@@ -868,15 +1671,15 @@ private:
           [&](circt::comb::MuxOp mux) {
             // create a new scope, which can be merged later on
             auto *temp = currentScope;
+            auto cond = getCond(mux.getCond());
+            if (cond.text.empty()) {
+              mux->emitError("Unable to obtain mux condition expression");
+            }
             // true
             {
               auto *scope =
                   builder.createScope(mux.getOperation(), currentScope);
-              auto cond = getCondString(mux.getCond());
-              if (cond.empty()) {
-                mux->emitError("Unable to obtain mux condition expression");
-              }
-              scope->condition = StringAttr::get(op->getContext(), cond);
+              setCondition(scope, cond);
               currentScope = scope;
               handleAssign(target, mux.getTrueValue(),
                            mux.getTrueValue().getDefiningOp(), assignOp);
@@ -886,12 +1689,7 @@ private:
             {
               auto *scope =
                   builder.createScope(mux.getOperation(), currentScope);
-              auto cond = getCondString(mux.getCond());
-              if (cond.empty()) {
-                mux->emitError("Unable to obtain mux condition expression");
-              }
-              scope->condition =
-                  mlir::StringAttr::get(op->getContext(), "!" + cond);
+              setCondition(scope, getNegatedCond(mux.getCond()));
               currentScope = scope;
               handleAssign(target, mux.getFalseValue(),
                            mux.getFalseValue().getDefiningOp(), assignOp);
@@ -915,134 +1713,482 @@ mlir::StringAttr getFilenameFromScopeOp(HWDebugScope *scope) {
   return loc ? loc.getFilename() : mlir::StringAttr{};
 }
 
-// NOLINTNEXTLINE
-void setScopeFilename(HWDebugScope *scope, HWDebugBuilder &builder) {
-  // assuming the current scope is already fixed
-  auto scopeFilename = getFilenameFromScopeOp(scope);
-  for (auto i = 0u; i < scope->scopes.size(); i++) {
-    auto *entry = scope->scopes[i];
-    auto entryFilename = getFilenameFromScopeOp(entry);
-    // unable to determine this scope's filename
-    if (!entryFilename) {
-      // delete it from the scope
-      scope->scopes[i] = nullptr;
-      continue;
-    }
-    if (entryFilename != scopeFilename ||
-        scope->type() != HWDebugScopeType::Block) {
-      // need to set this entry's filename
+/// Set the filename of every scope below `root`, and merge sibling blocks that
+/// share a filename and a condition. Scopes are visited top-down, since
+/// merging two blocks turns their children into siblings that may be merged in
+/// turn, but every scope is only visited once. Siblings are compacted in place
+/// and keep their order.
+void setScopeFilename(HWDebugScope *root, HWDebugBuilder &builder) {
+  llvm::SmallVector<HWDebugScope *> worklist;
+  worklist.emplace_back(root);
+  llvm::SmallDenseMap<std::pair<mlir::StringRef, mlir::StringRef>,
+                      HWDebugScope *, 8>
+      blocks;
+  while (!worklist.empty()) {
+    auto *scope = worklist.pop_back_val();
+    // assuming the current scope is already fixed
+    auto scopeFilename = getFilenameFromScopeOp(scope);
+    blocks.clear();
+    unsigned numScopes = 0;
+    for (auto *entry : scope->scopes) {
+      auto entryFilename = getFilenameFromScopeOp(entry);
+      // unable to determine this scope's filename, so drop it
+      if (!entryFilename)
+        continue;
+      if (entryFilename != scopeFilename ||
+          scope->type() != HWDebugScopeType::Block) {
+        // need to set this entry's filename
+        if (entry->type() == HWDebugScopeType::Block) {
+          entry->filename = entryFilename;
+        } else {
+          // need to create a scope to contain this one
+          auto *newScope = builder.createScope(entry->op);
+          // set the line to 0 since it's an artificial scope
+          newScope->line = 0;
+          newScope->filename = entryFilename;
+          newScope->scopes.emplace_back(entry);
+          entry->parent = newScope;
+          newScope->parent = scope;
+          entry = newScope;
+        }
+      }
+      // we assume at this stage most of the entries are block entry now,
+      // and only those can be merged into an earlier sibling
       if (entry->type() == HWDebugScopeType::Block) {
-        // set its filename
-        entry->filename = entryFilename;
-      } else {
-        // need to create a scope to contain this one
-        auto *newScope = builder.createScope(entry->op);
-        // set the line to 0 since it's an artificial scope
-        newScope->line = 0;
-        newScope->filename = entryFilename;
-        newScope->scopes.emplace_back(entry);
-        entry->parent = newScope;
-        newScope->parent = scope;
-        scope->scopes[i] = newScope;
+        auto [it, inserted] =
+            blocks.try_emplace({entry->filename, entry->condition}, entry);
+        if (!inserted) {
+          auto *target = it->second;
+          for (auto *child : entry->scopes)
+            child->parent = target;
+          target->scopes.append(entry->scopes.begin(), entry->scopes.end());
+          continue;
+        }
       }
+      scope->scopes[numScopes++] = entry;
     }
+    scope->scopes.truncate(numScopes);
+
+    // visit the children in order
+    worklist.append(scope->scopes.rbegin(), scope->scopes.rend());
   }
-  // merge scopes with the same filename
-  // we assume at this stage most of the entries are block entry now
-  // we can only merge
-  llvm::DenseMap<std::pair<mlir::StringRef, mlir::StringAttr>, HWDebugScope *>
-      filenameMapping;
-  for (auto i = 0u; i < scope->scopes.size(); i++) {
-    auto *entry = scope->scopes[i];
-    if (!entry)
-      continue;
-    if (entry->type() == HWDebugScopeType::Block) {
-      auto filename = entry->filename;
-      auto cond = entry->condition;
-      auto keyEntry = std::make_pair(filename, cond);
-      if (filenameMapping.find(keyEntry) == filenameMapping.end()) {
-        filenameMapping[keyEntry] = entry;
-      } else {
-        auto *parent = filenameMapping[keyEntry];
-        // merge
-        parent->scopes.reserve(entry->scopes.size() + parent->scopes.size());
-        for (auto *p : entry->scopes) {
-          parent->scopes.emplace_back(p);
-          p->parent = p;
-        }
+}
+
+/// Writes the debug table as a SQL script that builds the hgdb symbol table
+/// directly, so the runtime does not have to convert the JSON table when the
+/// simulator starts. Unlike the JSON table the design is flattened here: every
+/// instance gets its own breakpoints and variables, and breakpoint conditions
+/// already include the conditions of their enclosing scopes.
+class HWDebugSQLWriter {
+public:
+  HWDebugSQLWriter(const HWDebugContext &context, llvm::raw_ostream &os)
+      : context(context), os(os) {}
+
+  void write() {
+    for (auto *module : context.getModules())
+      moduleDefs[module->name] = module;
+
+    os << "BEGIN TRANSACTION;\n";
+    writeSchema();
+    if (auto const *top = context.getTop())
+      writeInstance(top, top->name);
+    // indices are cheaper to build once all the rows are in
+    os << "CREATE INDEX breakpoint_filename_line ON breakpoint(filename, "
+          "line_num);\n"
+       << "CREATE INDEX breakpoint_instance ON breakpoint(instance_id);\n"
+       << "CREATE INDEX context_variable_breakpoint ON "
+          "context_variable(breakpoint_id);\n"
+       << "CREATE INDEX generator_variable_instance ON "
+          "generator_variable(instance_id);\n"
+       << "CREATE INDEX variable_value ON variable(value);\n";
+    os << "COMMIT;\n";
+  }
+
+private:
+  const HWDebugContext &context;
+  llvm::raw_ostream &os;
 
-        // delete the old entry
-        scope->scopes[i] = nullptr;
+  llvm::DenseMap<mlir::StringRef, const HWModuleInfo *> moduleDefs;
+  llvm::DenseMap<std::pair<unsigned, const HWDebugVarDef *>, unsigned>
+      variableIDs;
+  unsigned numInstances = 0;
+  unsigned numBreakpoints = 0;
+  unsigned numScopes = 0;
+
+  void writeSchema() {
+    os << "CREATE TABLE instance(id INTEGER PRIMARY KEY, name TEXT, "
+          "annotation TEXT);\n"
+       << "CREATE TABLE breakpoint(id INTEGER PRIMARY KEY, instance_id "
+          "INTEGER, filename TEXT, line_num INTEGER, column_num INTEGER, "
+          "condition TEXT, trigger TEXT);\n"
+       << "CREATE TABLE scope(scope INTEGER PRIMARY KEY, breakpoints "
+          "TEXT);\n"
+       << "CREATE TABLE variable(id INTEGER PRIMARY KEY, value TEXT, is_rtl "
+          "INTEGER);\n"
+       << "CREATE TABLE generator_variable(name TEXT, instance_id INTEGER, "
+          "variable_id INTEGER, annotation TEXT);\n"
+       << "CREATE TABLE context_variable(name TEXT, breakpoint_id INTEGER, "
+          "variable_id INTEGER);\n"
+       << "CREATE TABLE assignment(name TEXT, value TEXT, breakpoint_id "
+          "INTEGER, condition TEXT);\n";
+  }
+
+  void writeString(mlir::StringRef str) {
+    os << '\'';
+    for (auto c : str) {
+      if (c == '\'')
+        os << '\'';
+      os << c;
+    }
+    os << '\'';
+  }
+
+  unsigned getVariableID(unsigned instanceID, mlir::StringRef path,
+                         const HWDebugVarDef *var) {
+    auto [it, inserted] = variableIDs.insert(
+        {{instanceID, var}, static_cast<unsigned>(variableIDs.size())});
+    if (inserted) {
+      os << "INSERT INTO variable VALUES(" << it->second << ", ";
+      // RTL values are relative to the instance they live in
+      if (var->rtl)
+        writeString((path + "." + var->value).str());
+      else
+        writeString(var->value);
+      os << ", " << (var->rtl ? 1 : 0) << ");\n";
+    }
+    return it->second;
+  }
+
+  // NOLINTNEXTLINE
+  void writeInstance(const HWModuleInfo *module, mlir::StringRef path) {
+    auto instanceID = numInstances++;
+    os << "INSERT INTO instance VALUES(" << instanceID << ", ";
+    writeString(path);
+    os << ", '');\n";
+
+    for (auto const *var : module->variables) {
+      auto varID = getVariableID(instanceID, path, var);
+      os << "INSERT INTO generator_variable VALUES(";
+      writeString(var->name);
+      os << ", " << instanceID << ", " << varID << ", '');\n";
+    }
+
+    llvm::SmallVector<mlir::StringRef> conditions;
+    llvm::SmallVector<unsigned> breakpoints;
+    writeScope(module, instanceID, path, module->filename, conditions,
+               breakpoints);
+
+    for (auto const &[instName, defName] : module->instances) {
+      // external modules don't have any debug information
+      if (auto const *child = moduleDefs.lookup(defName))
+        writeInstance(child, (path + "." + instName).str());
+    }
+  }
+
+  // NOLINTNEXTLINE
+  void writeScope(const HWDebugScope *scope, unsigned instanceID,
+                  mlir::StringRef path, mlir::StringRef filename,
+                  llvm::SmallVectorImpl<mlir::StringRef> &conditions,
+                  llvm::SmallVectorImpl<unsigned> &breakpoints) {
+    auto type = scope->type();
+    bool hasCondition = !scope->condition.empty();
+    if (hasCondition)
+      conditions.emplace_back(scope->condition);
+
+    if (type == HWDebugScopeType::Block || type == HWDebugScopeType::Module) {
+      if (!scope->filename.empty())
+        filename = scope->filename;
+      llvm::SmallVector<unsigned> blockBreakpoints;
+      for (auto const *entry : scope->scopes) {
+        if (entry)
+          writeScope(entry, instanceID, path, filename, conditions,
+                     blockBreakpoints);
+      }
+      if (!blockBreakpoints.empty()) {
+        os << "INSERT INTO scope VALUES(" << numScopes++ << ", '";
+        llvm::interleave(blockBreakpoints, os, " ");
+        os << "');\n";
+      }
+      breakpoints.append(blockBreakpoints.begin(), blockBreakpoints.end());
+    } else if (scope->line != 0) {
+      auto breakpointID = numBreakpoints++;
+      auto condition = joinConditions(conditions);
+      os << "INSERT INTO breakpoint VALUES(" << breakpointID << ", "
+         << instanceID << ", ";
+      writeString(filename);
+      os << ", " << scope->line << ", " << scope->column << ", ";
+      writeString(condition);
+      os << ", '');\n";
+      breakpoints.emplace_back(breakpointID);
+
+      const HWDebugVarDef *var = nullptr;
+      if (type == HWDebugScopeType::Declare)
+        var = static_cast<const HWDebugVarDeclareLineInfo *>(scope)->variable;
+      else if (type == HWDebugScopeType::Assign)
+        var = static_cast<const HWDebugVarAssignLineInfo *>(scope)->variable;
+      if (var) {
+        auto varID = getVariableID(instanceID, path, var);
+        os << "INSERT INTO context_variable VALUES(";
+        writeString(var->name);
+        os << ", " << breakpointID << ", " << varID << ");\n";
+        if (type == HWDebugScopeType::Assign) {
+          os << "INSERT INTO assignment VALUES(";
+          writeString(var->name);
+          os << ", ";
+          writeString(var->value);
+          os << ", " << breakpointID << ", '');\n";
+        }
       }
     }
+
+    if (hasCondition)
+      conditions.pop_back();
   }
-  // clear the nullptr
-  scope->scopes.erase(std::remove_if(scope->scopes.begin(), scope->scopes.end(),
-                                     [](auto *p) { return !p; }),
-                      scope->scopes.end());
+};
 
-  // recursively setting filenames
-  for (auto *entry : scope->scopes) {
-    setScopeFilename(entry, builder);
+/// Run `fn`, and add the time and memory it took to `record` if it is set.
+template <typename Fn>
+static void measurePhase(llvm::TimeRecord *record, Fn fn) {
+  if (!record) {
+    fn();
+    return;
   }
+  auto elapsed = llvm::TimeRecord::getCurrentTime(true);
+  fn();
+  auto end = llvm::TimeRecord::getCurrentTime(false);
+  end -= elapsed;
+  *record += end;
 }
 
-void exportDebugTable(mlir::ModuleOp moduleOp, Optional<std::string> filename) {
-  // collect all the files
-  HWDebugContext context;
-  HWDebugBuilder builder(context);
-  for (auto &op : *moduleOp.getBody()) {
-    mlir::TypeSwitch<mlir::Operation *>(&op).Case<circt::hw::HWModuleOp>(
-        [&builder](circt::hw::HWModuleOp mod) {
-          // get verilog name
-          auto defName = circt::hw::getVerilogModuleNameAttr(mod);
-          auto *module = builder.createModule(&mod);
-          module->name = defName;
-          DebugStmtVisitor visitor(builder, module);
+static size_t countScopes(const HWDebugScope *scope) {
+  size_t count = 1;
+  for (auto const *child : scope->scopes)
+    count += countScopes(child);
+  return count;
+}
+
+/// Drop the `hw.debug.*` attributes of `op`.
+static void removeDebugAttrs(mlir::Operation *op) {
+  llvm::SmallVector<mlir::StringAttr> names;
+  for (auto attr : op->getAttrs())
+    if (attr.getName().getValue().startswith("hw.debug."))
+      names.emplace_back(attr.getName());
+  for (auto name : names)
+    op->removeAttr(name);
+}
+
+/// Drop the locations and the `hw.debug.*` attributes of every op in the body
+/// of `mod`, once its table is recorded. The module op itself is left alone,
+/// since other modules read its attributes through their instances.
+static void stripModuleBodyDebugInfo(circt::hw::HWModuleOp mod) {
+  auto unknownLoc = mlir::UnknownLoc::get(mod.getContext());
+  for (auto arg : mod.getArguments())
+    arg.setLoc(unknownLoc);
+  mod.getBodyBlock()->walk([&](mlir::Operation *op) {
+    op->setLoc(unknownLoc);
+    removeDebugAttrs(op);
+    for (auto &region : op->getRegions())
+      for (auto &block : region)
+        for (auto arg : block.getArguments())
+          arg.setLoc(unknownLoc);
+  });
+}
+
+/// Collect the debug info of every HW module. If `cache` is set, modules whose
+/// hash is found in it are not visited, and reuse the cached table. If
+/// `stripDebugInfo` is set, the locations and debug attributes of each module
+/// are dropped as soon as its table no longer needs them, in the same
+/// parallel task, rather than by a separate walk over the IR.
+static void collectDebugTable(HWDebugContext &context, mlir::ModuleOp moduleOp,
+                              circt::hw::InstanceGraph &instanceGraph,
+                              const HWDebugTableCache *cache,
+                              bool conditionCode, HGDBExportStatistics *stats,
+                              bool stripDebugInfo = false) {
+  for (auto mod : moduleOp.getBody()->getOps<circt::hw::HWModuleOp>()) {
+    // get verilog name
+    auto defName = circt::hw::getVerilogModuleNameAttr(mod);
+    auto *module = context.createModule(&mod);
+    module->name = defName;
+  }
+
+  // Modules are independent of each other: each one gets its own builder and
+  // arena, and only touches ops inside its own body.
+  measurePhase(stats ? &stats->visit : nullptr, [&] {
+    mlir::parallelForEach(
+        moduleOp.getContext(), context.getModules(),
+        [&](HWModuleInfo *module) {
+          auto mod = mlir::cast<circt::hw::HWModuleOp>(module->op);
           auto *body = mod.getBodyBlock();
+          if (cache) {
+            module->hash = getModuleHash(mod, conditionCode);
+            if (auto const *fragment = cache->lookup(module->hash)) {
+              module->fragment = *fragment;
+              // the locations are still needed for the breakpoint index
+              for (auto const &[file, line] : fragment->breakpoints) {
+                auto &breakpoint = module->breakpoints.emplace_back();
+                breakpoint.filename = module->arena.internString(file);
+                breakpoint.line = line;
+              }
+              // the instances are still needed to find the top module
+              for (auto inst : body->getOps<circt::hw::InstanceOp>())
+                DebugStmtVisitor::addInstance(module, inst);
+              return;
+            }
+          }
+          HWDebugBuilder builder(context, module->arena);
+          DebugStmtVisitor visitor(builder, module, conditionCode);
           visitor.visitBlock(*body);
         });
+  });
+
+  measurePhase(stats ? &stats->merge : nullptr, [&] {
+    mlir::parallelForEach(
+        moduleOp.getContext(), context.getModules(),
+        [&](HWModuleInfo *module) {
+          if (!module->fragment) {
+            // Fixing filenames and other scope ordering
+            HWDebugBuilder builder(context, module->arena);
+            setScopeFilename(module, builder);
+            module->collectBreakpoints();
+          }
+          if (stripDebugInfo)
+            stripModuleBodyDebugInfo(
+                mlir::cast<circt::hw::HWModuleOp>(module->op));
+        });
+  });
+
+  if (stripDebugInfo) {
+    for (auto *module : context.getModules()) {
+      module->op->setLoc(mlir::UnknownLoc::get(moduleOp.getContext()));
+      removeDebugAttrs(module->op);
+    }
   }
-  // Fixing filenames and other scope ordering
-  auto const &modules = context.getModules();
-  for (auto *m : modules) {
-    setScopeFilename(m, builder);
-  }
-  auto json = context.toJSON();
 
-  if (filename) {
-    std::error_code error;
-    if (*filename == "-") {
-      llvm::outs() << json;
-    } else {
-      llvm::raw_fd_ostream os(*filename, error);
-      if (!error) {
-        os << json;
-      }
-      os.close();
+  context.assignVariableIDs(cache != nullptr);
+  context.setInstanceGraph(instanceGraph);
+
+  if (stats) {
+    for (auto const *module : context.getModules()) {
+      stats->numModules++;
+      stats->numScopes += countScopes(module);
+      stats->numVariables += module->arena.vars.size();
     }
+  }
+}
+
+static void writeDebugTable(const HWDebugContext &context,
+                            HGDBOutputFormat::Format format,
+                            llvm::raw_ostream &os) {
+  switch (format) {
+  case HGDBOutputFormat::JSON: {
+    llvm::json::OStream json(os);
+    context.toJSON(json);
+    break;
+  }
+  case HGDBOutputFormat::SQL:
+    HWDebugSQLWriter(context, os).write();
+    break;
+  }
+}
+
+void exportDebugTable(mlir::ModuleOp moduleOp,
+                      circt::hw::InstanceGraph &instanceGraph,
+                      llvm::raw_ostream &os, HGDBOutputFormat::Format format,
+                      bool conditionCode, HGDBExportStatistics *stats) {
+  HWDebugContext context;
+  collectDebugTable(context, moduleOp, instanceGraph, nullptr, conditionCode,
+                    stats);
+  measurePhase(stats ? &stats->emit : nullptr,
+               [&] { writeDebugTable(context, format, os); });
+}
+
+static void exportDebugTable(mlir::ModuleOp moduleOp,
+                             circt::hw::InstanceGraph &instanceGraph,
+                             llvm::StringRef filename,
+                             HGDBOutputFormat::Format format,
+                             llvm::StringRef cacheFile, bool conditionCode,
+                             bool stripDebugInfo) {
+  // The incremental mode only applies to the JSON table, which is written per
+  // definition. The SQL table is flattened across the hierarchy.
+  bool incremental = !cacheFile.empty() && format == HGDBOutputFormat::JSON;
+  HWDebugTableCache cache;
+  if (incremental)
+    cache.load(cacheFile);
+
+  HWDebugContext context;
+  collectDebugTable(context, moduleOp, instanceGraph,
+                    incremental ? &cache : nullptr, conditionCode, nullptr,
+                    stripDebugInfo);
+
+  if (incremental) {
+    // serialize the modules that changed so they can be cached
+    mlir::parallelForEach(
+        moduleOp.getContext(), context.getModules(), [](HWModuleInfo *module) {
+          if (module->fragment)
+            return;
+          HWDebugTableFragment fragment;
+          {
+            llvm::raw_string_ostream os(fragment.table);
+            llvm::json::OStream json(os);
+            module->toJSON(json);
+          }
+          for (auto const &[_, var] : module->arena.vars) {
+            auto &str = fragment.variables.emplace_back();
+            llvm::raw_string_ostream os(str);
+            llvm::json::OStream json(os);
+            var->toJSONDefinition(json);
+          }
+          for (auto const &breakpoint : module->breakpoints)
+            fragment.breakpoints.emplace_back(breakpoint.filename.str(),
+                                              breakpoint.line);
+          module->fragment = std::move(fragment);
+        });
+  }
+
+  std::error_code error;
+  if (filename == "-") {
+    writeDebugTable(context, format, llvm::outs());
   } else {
-    llvm::outs() << json;
+    llvm::raw_fd_ostream os(filename, error);
+    if (!error) {
+      writeDebugTable(context, format, os);
+    }
+    os.close();
   }
+
+  if (incremental)
+    HWDebugTableCache::save(cacheFile, context.getModules());
 }
 
 struct ExportDebugTablePass
     : public circt::debug::HWExportHGDBBase<ExportDebugTablePass> {
-  ExportDebugTablePass(llvm::Optional<std::string> filename)
-      : filename(filename) {}
+  ExportDebugTablePass(llvm::Optional<std::string> filenameFlag,
+                       HGDBOutputFormat::Format formatFlag,
+                       llvm::StringRef cacheFileFlag, bool conditionCodeFlag,
+                       bool stripDebugInfoFlag) {
+    if (filenameFlag)
+      filename = *filenameFlag;
+    format = formatFlag;
+    cacheFile = cacheFileFlag.str();
+    conditionCode = conditionCodeFlag;
+    stripDebugInfo = stripDebugInfoFlag;
+  }
 
   void runOnOperation() override {
-    exportDebugTable(getOperation(), filename);
+    exportDebugTable(getOperation(), getAnalysis<circt::hw::InstanceGraph>(),
+                     filename, format, cacheFile, conditionCode,
+                     stripDebugInfo);
     markAllAnalysesPreserved();
   }
-
-private:
-  Optional<std::string> filename;
 };
 
 std::unique_ptr<mlir::Pass>
-createExportHGDBPass(Optional<std::string> filename) {
-  return std::make_unique<ExportDebugTablePass>(filename);
+createExportHGDBPass(Optional<std::string> filename,
+                     HGDBOutputFormat::Format format,
+                     llvm::StringRef cacheFile, bool conditionCode,
+                     bool stripDebugInfo) {
+  return std::make_unique<ExportDebugTablePass>(filename, format, cacheFile,
+                                                conditionCode, stripDebugInfo);
 }
 
 } // namespace circt::debug
\ No newline at end of file
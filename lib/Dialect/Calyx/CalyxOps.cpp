@@ -870,16 +870,23 @@ LogicalResult WiresOp::verify() {
     auto component = llvm::cast<ComponentOp>(componentInterface);
     auto control = component.getControlOp();
 
-    // Verify each group is referenced in the control section.
-    for (auto &&op : *getBodyBlock()) {
-      if (!isa<GroupInterface>(op))
-        continue;
-      auto group = cast<GroupInterface>(op);
-      auto groupName = group.symName();
-      if (mlir::SymbolTable::symbolKnownUseEmpty(groupName, control))
-        return op.emitOpError()
-               << "with name: " << groupName
-               << " is unused in the control execution schedule";
+    // Verify each group is referenced in the control section. The symbol uses
+    // of the control are collected once rather than walking the control for
+    // every group.
+    if (auto controlUses = mlir::SymbolTable::getSymbolUses(control)) {
+      DenseSet<StringAttr> usedSymbols;
+      for (auto &use : *controlUses)
+        usedSymbols.insert(use.getSymbolRef().getRootReference());
+      for (auto &&op : *getBodyBlock()) {
+        if (!isa<GroupInterface>(op))
+          continue;
+        auto group = cast<GroupInterface>(op);
+        auto groupName = group.symName();
+        if (!usedSymbols.count(groupName))
+          return op.emitOpError()
+                 << "with name: " << groupName
+                 << " is unused in the control execution schedule";
+      }
     }
   }
 
@@ -1081,10 +1088,41 @@ LogicalResult CombGroupOp::readsAnyPort(ValueRange ports) {
   return anyPortsReadByGroup(*this, ports);
 }
 
+namespace {
+/// The ports driven and read by the assignments of a group. These are
+/// collected in a single pass over the group, such that verifying all of its
+/// assignments is linear in the size of the group, rather than scanning all the
+/// uses of the cell ports for every assignment.
+struct GroupPortUses {
+  explicit GroupPortUses(GroupInterface group) {
+    for (auto assign : group.getBody()->getOps<AssignOp>()) {
+      driven.insert(assign.getDest());
+      read.insert(assign.getSrc());
+    }
+  }
+
+  LogicalResult drivesAllPorts(ValueRange ports) const {
+    return success(
+        llvm::all_of(ports, [&](Value port) { return driven.count(port); }));
+  }
+  LogicalResult drivesAnyPort(ValueRange ports) const {
+    return success(
+        llvm::any_of(ports, [&](Value port) { return driven.count(port); }));
+  }
+  LogicalResult readsAnyPort(ValueRange ports) const {
+    return success(
+        llvm::any_of(ports, [&](Value port) { return read.count(port); }));
+  }
+
+  DenseSet<Value> driven, read;
+};
+} // namespace
+
 /// Verifies that certain ports of primitives are either driven or read
 /// together.
 static LogicalResult verifyPrimitivePortDriving(AssignOp assign,
-                                                GroupInterface group) {
+                                                GroupInterface group,
+                                                const GroupPortUses &uses) {
   Operation *destDefiningOp = assign.getDest().getDefiningOp();
   if (destDefiningOp == nullptr)
     return success();
@@ -1097,8 +1135,8 @@ static LogicalResult verifyPrimitivePortDriving(AssignOp assign,
           .Case<RegisterOp>([&](auto op) {
             // We only want to verify this is written to if the {write enable,
             // in} port is driven.
-            return succeeded(group.drivesAnyPort({op.getWriteEn(), op.getIn()}))
-                       ? group.drivesAllPorts({op.getWriteEn(), op.getIn()})
+            return succeeded(uses.drivesAnyPort({op.getWriteEn(), op.getIn()}))
+                       ? uses.drivesAllPorts({op.getWriteEn(), op.getIn()})
                        : success();
           })
           .Case<MemoryOp>([&](auto op) {
@@ -1113,8 +1151,8 @@ static LogicalResult verifyPrimitivePortDriving(AssignOp assign,
             // We only want to verify the write ports if either write_data or
             // write_en is driven.
             return succeeded(
-                       group.drivesAnyPort({op.writeData(), op.writeEn()}))
-                       ? group.drivesAllPorts(requiredWritePorts)
+                       uses.drivesAnyPort({op.writeData(), op.writeEn()}))
+                       ? uses.drivesAllPorts(requiredWritePorts)
                        : success();
           })
           .Case<AndLibOp, OrLibOp, XorLibOp, AddLibOp, SubLibOp, GtLibOp,
@@ -1122,8 +1160,8 @@ static LogicalResult verifyPrimitivePortDriving(AssignOp assign,
                 RshLibOp, SgtLibOp, SltLibOp, SeqLibOp, SneqLibOp, SgeLibOp,
                 SleLibOp, SrshLibOp>([&](auto op) {
             Value lhs = op.getLeft(), rhs = op.getRight();
-            return succeeded(group.drivesAnyPort({lhs, rhs}))
-                       ? group.drivesAllPorts({lhs, rhs})
+            return succeeded(uses.drivesAnyPort({lhs, rhs}))
+                       ? uses.drivesAllPorts({lhs, rhs})
                        : success();
           })
           .Default([&](auto op) { return success(); });
@@ -1148,8 +1186,8 @@ static LogicalResult verifyPrimitivePortDriving(AssignOp assign,
             // If reading memory, all address ports should be driven. Note that
             // we only want to verify the read ports if read_data is used in the
             // group.
-            return succeeded(group.readsAnyPort({op.readData()}))
-                       ? group.drivesAllPorts(op.addrPorts())
+            return succeeded(uses.readsAnyPort({op.readData()}))
+                       ? uses.drivesAllPorts(op.addrPorts())
                        : success();
           })
           .Default([&](auto op) { return success(); });
@@ -1168,11 +1206,12 @@ LogicalResult calyx::verifyGroupInterface(Operation *op) {
   if (group == nullptr)
     return success();
 
+  GroupPortUses uses(group);
   for (auto &&groupOp : *group.getBody()) {
     auto assign = dyn_cast<AssignOp>(groupOp);
     if (assign == nullptr)
       continue;
-    if (failed(verifyPrimitivePortDriving(assign, group)))
+    if (failed(verifyPrimitivePortDriving(assign, group, uses)))
       return failure();
   }
 
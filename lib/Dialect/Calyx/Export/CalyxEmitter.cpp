@@ -19,10 +19,14 @@
 #include "circt/Support/LLVM.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Tools/mlir-translate/Translation.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/TypeSwitch.h"
 
+#include <atomic>
+
 using namespace circt;
 using namespace calyx;
 using namespace mlir;
@@ -172,6 +176,7 @@ struct Emitter {
 
   // Module emission
   void emitModule(ModuleOp op);
+  void emitModuleBodyOp(Operation &bodyOp);
 
   // Metadata emission for the Cider debugger.
   void emitCiderMetadata(mlir::ModuleOp op) {
@@ -533,14 +538,44 @@ LogicalResult Emitter::finalize() { return failure(encounteredError); }
 
 /// Emit an entire program.
 void Emitter::emitModule(ModuleOp op) {
-  for (auto &bodyOp : *op.getBody()) {
-    if (auto componentOp = dyn_cast<ComponentInterface>(bodyOp))
-      emitComponent(componentOp);
-    else if (auto hwModuleExternOp = dyn_cast<hw::HWModuleExternOp>(bodyOp))
-      emitPrimitiveExtern(hwModuleExternOp);
-    else
-      emitOpError(&bodyOp, "Unexpected op");
+  MLIRContext *context = op.getContext();
+  if (!context->isMultithreadingEnabled()) {
+    for (auto &bodyOp : *op.getBody())
+      emitModuleBodyOp(bodyOp);
+    return;
   }
+
+  // Components are emitted independently of each other, so emit them into
+  // separate buffers in parallel, and write the buffers out in program order.
+  // The diagnostics are reported in program order as well.
+  SmallVector<Operation *> bodyOps(
+      llvm::make_pointer_range(op.getBody()->getOperations()));
+  SmallVector<std::string> buffers(bodyOps.size());
+  std::atomic<bool> anyError(false);
+  ParallelDiagnosticHandler diagHandler(context);
+  mlir::parallelFor(context, 0, bodyOps.size(), [&](size_t i) {
+    diagHandler.setOrderIDForThread(i);
+    llvm::raw_string_ostream stream(buffers[i]);
+    Emitter emitter(stream);
+    emitter.emitModuleBodyOp(*bodyOps[i]);
+    if (emitter.encounteredError)
+      anyError = true;
+    diagHandler.eraseOrderIDForThread();
+  });
+
+  for (auto &buffer : buffers)
+    os << buffer;
+  encounteredError |= anyError;
+}
+
+/// Emit a component or primitive of a program.
+void Emitter::emitModuleBodyOp(Operation &bodyOp) {
+  if (auto componentOp = dyn_cast<ComponentInterface>(bodyOp))
+    emitComponent(componentOp);
+  else if (auto hwModuleExternOp = dyn_cast<hw::HWModuleExternOp>(bodyOp))
+    emitPrimitiveExtern(hwModuleExternOp);
+  else
+    emitOpError(&bodyOp, "Unexpected op");
 }
 
 /// Emit a component.
@@ -34,6 +34,10 @@ static size_t getNecessaryBitWidth(size_t numStates) {
 
 class CompileControlVisitor {
 public:
+  /// The groups of `component`'s wires are looked up in `symTable`, to which
+  /// the generated compilation groups are added.
+  explicit CompileControlVisitor(SymbolTable &symTable) : symTable(symTable) {}
+
   void dispatch(Operation *op, ComponentOp component) {
     TypeSwitch<Operation *>(op)
         .template Case<SeqOp, EnableOp>(
@@ -49,6 +53,10 @@ private:
   void visit(EnableOp, ComponentOp &) {
     // nothing to do
   }
+
+  /// The symbol table of the component's wires, which is shared by all
+  /// compiled control operations instead of being rebuilt for each of them.
+  SymbolTable &symTable;
 };
 
 /// Generates a latency-insensitive FSM to realize a sequential operation.
@@ -88,7 +96,6 @@ void CompileControlVisitor::visit(SeqOp seq, ComponentOp &component) {
       builder.create<GroupOp>(wires->getLoc(), builder.getStringAttr("seq"));
 
   // Guarantees a unique SymbolName for the group.
-  SymbolTable symTable(wires);
   symTable.insert(seqGroup);
 
   size_t fsmIndex = 0;
@@ -184,7 +191,8 @@ struct CompileControlPass : public CompileControlBase<CompileControlPass> {
 
 void CompileControlPass::runOnOperation() {
   ComponentOp component = getOperation();
-  CompileControlVisitor CompileControlVisitor;
+  SymbolTable symTable(component.getWiresOp());
+  CompileControlVisitor CompileControlVisitor(symTable);
   component.getControlOp().walk(
       [&](Operation *op) { CompileControlVisitor.dispatch(op, component); });
 
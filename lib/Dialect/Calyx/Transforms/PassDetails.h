@@ -30,13 +30,19 @@ namespace calyx {
 template <typename Op>
 static void updateGroupAssignmentGuards(OpBuilder &builder, GroupOp &group,
                                         Op &op) {
+  // Assignments of a group often share their guard, e.g. the FSM state
+  // comparison of a compiled control group, so build each conjunction once.
+  DenseMap<Value, Value> updatedGuards;
   group.walk([&](AssignOp assign) {
-    if (assign.getGuard())
+    if (Value guard = assign.getGuard()) {
       // If the assignment is guarded already, take the bitwise & of the current
       // guard and the group's go signal.
-      assign->setOperand(2, builder.create<comb::AndOp>(
-                                group.getLoc(), assign.getGuard(), op, false));
-    else
+      Value &updatedGuard = updatedGuards[guard];
+      if (!updatedGuard)
+        updatedGuard =
+            builder.create<comb::AndOp>(group.getLoc(), guard, op, false);
+      assign->setOperand(2, updatedGuard);
+    } else
       // Otherwise, just insert it as the guard.
       assign->insertOperands(2, {op});
   });
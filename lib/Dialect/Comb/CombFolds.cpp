@@ -1604,119 +1604,147 @@ OpFoldResult ConcatOp::fold(ArrayRef<Attribute> constants) {
   return getIntAttr(result, getContext());
 }
 
-LogicalResult ConcatOp::canonicalize(ConcatOp op, PatternRewriter &rewriter) {
-  auto inputs = op.getInputs();
-  auto size = inputs.size();
-  assert(size > 1 && "expected 2 or more operands");
-
-  // This function is used when we flatten neighboring operands of a
-  // (variadic) concat into a new vesion of the concat.  first/last indices
-  // are inclusive.
-  auto flattenConcat = [&](size_t firstOpIndex, size_t lastOpIndex,
-                           ValueRange replacements) -> LogicalResult {
-    SmallVector<Value, 4> newOperands;
-    newOperands.append(inputs.begin(), inputs.begin() + firstOpIndex);
-    newOperands.append(replacements.begin(), replacements.end());
-    newOperands.append(inputs.begin() + lastOpIndex + 1, inputs.end());
-    if (newOperands.size() == 1)
-      replaceOpAndCopyName(rewriter, op, newOperands[0]);
-    else
-      replaceOpWithNewOpAndCopyName<ConcatOp>(rewriter, op, op.getType(),
-                                              newOperands);
-    return success();
-  };
-
-  Value commonOperand = inputs[0];
-  for (size_t i = 0; i != size; ++i) {
-    // Check to see if all operands are the same.
-    if (inputs[i] != commonOperand)
-      commonOperand = Value();
-
-    // If an operand to the concat is itself a concat, then we can fold them
-    // together.
-    if (auto subConcat = inputs[i].getDefiningOp<ConcatOp>())
-      return flattenConcat(i, i, subConcat->getOperands());
-
-    // Check for canonicalization due to neighboring operands.
-    if (i != 0) {
-      // Merge neighboring constants.
-      if (auto cst = inputs[i].getDefiningOp<hw::ConstantOp>()) {
-        if (auto prevCst = inputs[i - 1].getDefiningOp<hw::ConstantOp>()) {
-          unsigned prevWidth = prevCst.getValue().getBitWidth();
-          unsigned thisWidth = cst.getValue().getBitWidth();
-          auto resultCst = cst.getValue().zext(prevWidth + thisWidth);
-          resultCst |= prevCst.getValue().zext(prevWidth + thisWidth)
-                       << thisWidth;
-          Value replacement =
-              rewriter.create<hw::ConstantOp>(op.getLoc(), resultCst);
-          return flattenConcat(i - 1, i, replacement);
-        }
-      }
+namespace {
+/// A run of bits in a concatenation being normalized by `ConcatOp`
+/// canonicalization: a constant, a contiguous range of bits extracted from a
+/// value, or a value replicated some number of times.  `original` is the
+/// operand the run was built from, if it wasn't merged with any other operand.
+struct ConcatRun {
+  enum Kind { Constant, Extract, Replicate } kind;
+  Value original;
+  /// The extracted or replicated value.
+  Value value;
+  APInt constant;
+  /// The low bit and width of an extract, or the multiple of a replicate.
+  unsigned lowBit = 0, width = 0, multiple = 0;
+
+  explicit ConcatRun(Value operand) : original(operand) {
+    if (auto cst = operand.getDefiningOp<hw::ConstantOp>()) {
+      kind = Constant;
+      constant = cst.getValue();
+    } else if (auto extract = operand.getDefiningOp<ExtractOp>()) {
+      kind = Extract;
+      value = extract.getInput();
+      lowBit = extract.getLowBit();
+      width = extract.getType().cast<IntegerType>().getWidth();
+    } else if (auto repl = operand.getDefiningOp<ReplicateOp>()) {
+      kind = Replicate;
+      value = repl.getOperand();
+      multiple = repl.getMultiple();
+    } else {
+      kind = Replicate;
+      value = operand;
+      multiple = 1;
+    }
+  }
 
-      // If the two operands are the same, turn them into a replicate.
-      if (inputs[i] == inputs[i - 1]) {
-        Value replacement =
-            rewriter.createOrFold<ReplicateOp>(op.getLoc(), inputs[i], 2);
-        return flattenConcat(i - 1, i, replacement);
-      }
+  /// Return the value replicated by this run, and how many times.
+  std::pair<Value, unsigned> getReplicated() const {
+    if (kind == Replicate)
+      return {value, multiple};
+    return {original, 1};
+  }
+
+  /// Try to merge the run of the next, lower, bits of the concatenation into
+  /// this one.
+  bool merge(const ConcatRun &next) {
+    // Merge neighboring constants.
+    if (kind == Constant && next.kind == Constant) {
+      unsigned thisWidth = constant.getBitWidth();
+      unsigned nextWidth = next.constant.getBitWidth();
+      auto merged = next.constant.zext(thisWidth + nextWidth);
+      merged |= constant.zext(thisWidth + nextWidth) << nextWidth;
+      constant = merged;
+      original = {};
+      return true;
+    }
 
-      // If this input is a replicate, see if we can fold it with the previous
-      // one.
-      if (auto repl = inputs[i].getDefiningOp<ReplicateOp>()) {
-        // ... x, repl(x, n), ...  ==> ..., repl(x, n+1), ...
-        if (repl.getOperand() == inputs[i - 1]) {
-          Value replacement = rewriter.createOrFold<ReplicateOp>(
-              op.getLoc(), repl.getOperand(), repl.getMultiple() + 1);
-          return flattenConcat(i - 1, i, replacement);
-        }
-        // ... repl(x, n), repl(x, m), ...  ==> ..., repl(x, n+m), ...
-        if (auto prevRepl = inputs[i - 1].getDefiningOp<ReplicateOp>()) {
-          if (prevRepl.getOperand() == repl.getOperand()) {
-            Value replacement = rewriter.createOrFold<ReplicateOp>(
-                op.getLoc(), repl.getOperand(),
-                repl.getMultiple() + prevRepl.getMultiple());
-            return flattenConcat(i - 1, i, replacement);
-          }
-        }
-      }
+    // Merge neighboring extracts of neighboring inputs, e.g.
+    // {A[3], A[2]} -> A[3:2]
+    if (kind == Extract && next.kind == Extract && value == next.value &&
+        lowBit == next.lowBit + next.width) {
+      lowBit = next.lowBit;
+      width += next.width;
+      original = {};
+      return true;
+    }
 
-      // ... repl(x, n), x, ...  ==> ..., repl(x, n+1), ...
-      if (auto repl = inputs[i - 1].getDefiningOp<ReplicateOp>()) {
-        if (repl.getOperand() == inputs[i]) {
-          Value replacement = rewriter.createOrFold<ReplicateOp>(
-              op.getLoc(), inputs[i], repl.getMultiple() + 1);
-          return flattenConcat(i - 1, i, replacement);
-        }
-      }
+    // ... x, x, ...              ==> ..., repl(x, 2), ...
+    // ... repl(x, n), x, ...     ==> ..., repl(x, n+1), ...
+    // ... x, repl(x, n), ...     ==> ..., repl(x, n+1), ...
+    // ... repl(x, n), repl(x, m) ==> ..., repl(x, n+m), ...
+    auto [thisValue, thisMultiple] = getReplicated();
+    auto [nextValue, nextMultiple] = next.getReplicated();
+    if (!thisValue || thisValue != nextValue)
+      return false;
+    kind = Replicate;
+    value = thisValue;
+    multiple = thisMultiple + nextMultiple;
+    original = {};
+    return true;
+  }
 
-      // Merge neighboring extracts of neighboring inputs, e.g.
-      // {A[3], A[2]} -> A[3:2]
-      if (auto extract = inputs[i].getDefiningOp<ExtractOp>()) {
-        if (auto prevExtract = inputs[i - 1].getDefiningOp<ExtractOp>()) {
-          if (extract.getInput() == prevExtract.getInput()) {
-            auto thisWidth = extract.getType().cast<IntegerType>().getWidth();
-            if (prevExtract.getLowBit() == extract.getLowBit() + thisWidth) {
-              auto prevWidth = prevExtract.getType().getIntOrFloatBitWidth();
-              auto resType = rewriter.getIntegerType(thisWidth + prevWidth);
-              Value replacement = rewriter.create<ExtractOp>(
-                  op.getLoc(), resType, extract.getInput(),
-                  extract.getLowBit());
-              return flattenConcat(i - 1, i, replacement);
-            }
-          }
-        }
-      }
+  /// Return the value of this run, creating it if needed.
+  Value materialize(Location loc, PatternRewriter &rewriter) const {
+    if (original)
+      return original;
+    switch (kind) {
+    case Constant:
+      return rewriter.create<hw::ConstantOp>(loc, constant);
+    case Extract:
+      return rewriter.createOrFold<ExtractOp>(
+          loc, rewriter.getIntegerType(width), value, lowBit);
+    case Replicate:
+      return rewriter.createOrFold<ReplicateOp>(loc, value, multiple);
     }
+    llvm_unreachable("unknown concat run kind");
   }
+};
+} // end anonymous namespace
 
-  // If all operands were the same, then this is a replicate.
-  if (commonOperand) {
-    replaceOpWithNewOpAndCopyName<ReplicateOp>(rewriter, op, op.getType(),
-                                               commonOperand);
-    return success();
+/// Append the runs of the operands of `op` to `runs`, looking through nested
+/// concatenations and merging neighboring runs as they are added.
+static void collectConcatRuns(ConcatOp op, SmallVectorImpl<ConcatRun> &runs) {
+  for (auto input : op.getInputs()) {
+    if (auto subConcat = input.getDefiningOp<ConcatOp>()) {
+      collectConcatRuns(subConcat, runs);
+      continue;
+    }
+    ConcatRun run(input);
+    if (runs.empty() || !runs.back().merge(run))
+      runs.push_back(std::move(run));
   }
+}
 
-  return failure();
+LogicalResult ConcatOp::canonicalize(ConcatOp op, PatternRewriter &rewriter) {
+  auto inputs = op.getInputs();
+  assert(inputs.size() > 1 && "expected 2 or more operands");
+
+  // Normalize the whole concatenation in a single pass: flatten nested concats
+  // and merge all runs of neighboring constants, adjacent extracts and
+  // replicated values.  Long chains of bit-blasted concats and extracts would
+  // otherwise be merged a pair of operands per rewrite.
+  SmallVector<ConcatRun, 4> runs;
+  collectConcatRuns(op, runs);
+
+  // Nothing to do if every run is still one of the original operands.
+  if (runs.size() == inputs.size() &&
+      llvm::all_of(llvm::zip(runs, inputs), [](auto pair) {
+        return std::get<0>(pair).original == std::get<1>(pair);
+      }))
+    return failure();
+
+  SmallVector<Value, 4> newOperands;
+  newOperands.reserve(runs.size());
+  for (auto &run : runs)
+    newOperands.push_back(run.materialize(op.getLoc(), rewriter));
+
+  if (newOperands.size() == 1)
+    replaceOpAndCopyName(rewriter, op, newOperands[0]);
+  else
+    replaceOpWithNewOpAndCopyName<ConcatOp>(rewriter, op, op.getType(),
+                                            newOperands);
+  return success();
 }
 
 //===----------------------------------------------------------------------===//
@@ -28,6 +28,7 @@
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
 #include "mlir/IR/SymbolTable.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/DialectConversion.h"
 
@@ -349,9 +350,15 @@ void ESIToPhysicalPass::runOnOperation() {
   RewritePatternSet patterns(&getContext());
   patterns.insert<ChannelBufferLowering>(&getContext());
 
-  // Run the conversion.
-  if (failed(
-          applyPartialConversion(getOperation(), target, std::move(patterns))))
+  // Run the conversion. Buffers only involve the ops around them, so the
+  // modules are converted independently and in parallel.
+  mlir::FrozenRewritePatternSet frozenPatterns(std::move(patterns));
+  SmallVector<Operation *> ops(
+      llvm::make_pointer_range(getOperation().getOps()));
+  auto convert = [&](Operation *op) {
+    return applyPartialConversion(op, target, frozenPatterns);
+  };
+  if (failed(mlir::failableParallelForEach(&getContext(), ops, convert)))
     signalPassFailure();
 }
 
@@ -396,17 +403,26 @@ void ESIPortsPass::runOnOperation() {
   });
 
   // Find all modules and try to modify them to have wires with valid/ready
-  // semantics. Remember the modified ones.
+  // semantics. Remember the modified ones. This only changes the ports and
+  // bodies of the modules themselves, so it is done in parallel.
+  SmallVector<HWModuleOp> mods(top.getOps<HWModuleOp>());
+  SmallVector<bool> modUpdated(mods.size());
+  mlir::parallelFor(&getContext(), 0, mods.size(),
+                    [&](size_t i) { modUpdated[i] = updateFunc(mods[i]); });
   DenseMap<StringRef, HWModuleOp> modsMutated;
-  for (auto mod : top.getOps<HWModuleOp>())
-    if (updateFunc(mod))
+  for (auto [mod, updated] : llvm::zip(mods, modUpdated))
+    if (updated)
       modsMutated[mod.getName()] = mod;
 
-  // Find all instances and update them.
-  top.walk([&modsMutated, this](InstanceOp inst) {
-    auto mapIter = modsMutated.find(inst.getModuleName());
-    if (mapIter != modsMutated.end())
-      updateInstance(mapIter->second, inst);
+  // Find all instances and update them. The updates only create ops next to
+  // the instances, so the modules containing them are processed in parallel.
+  SmallVector<Operation *> ops(llvm::make_pointer_range(top.getOps()));
+  mlir::parallelForEach(&getContext(), ops, [&](Operation *op) {
+    op->walk([&](InstanceOp inst) {
+      auto mapIter = modsMutated.find(inst.getModuleName());
+      if (mapIter != modsMutated.end())
+        updateInstance(mapIter->second, inst);
+    });
   });
 
   build = nullptr;
@@ -324,6 +324,15 @@ void ESIConnectServicesPass::runOnOperation() {
   }
 }
 
+/// Return the service to which a to_client or to_server request is made.
+static SymbolRefAttr getRequestedService(Operation *req) {
+  if (auto toClient = dyn_cast<RequestToClientConnectionOp>(req))
+    return toClient.getServicePortAttr().getModuleRef();
+  return cast<RequestToServerConnectionOp>(req)
+      .getServicePortAttr()
+      .getModuleRef();
+}
+
 LogicalResult ESIConnectServicesPass::process(hw::HWMutableModuleLike mod) {
   Block &modBlock = mod->getRegion(0).front();
 
@@ -337,37 +346,41 @@ LogicalResult ESIConnectServicesPass::process(hw::HWMutableModuleLike mod) {
       anyServiceInst = b;
   }
 
-  // Decompose the 'inout' requests int to 'in' and 'out' requests.
-  mod.walk([&](RequestInOutChannelOp reqInOut) {
+  // Index the requests in a single walk, decomposing the 'inout' requests
+  // into 'in' and 'out' requests on the way.
+  SmallVector<Operation *, 16> reqs;
+  mod.walk([&](Operation *op) {
+    if (isa<RequestToClientConnectionOp, RequestToServerConnectionOp>(op)) {
+      reqs.push_back(op);
+      return;
+    }
+    auto reqInOut = dyn_cast<RequestInOutChannelOp>(op);
+    if (!reqInOut)
+      return;
     ImplicitLocOpBuilder b(reqInOut.getLoc(), reqInOut);
-    b.create<RequestToServerConnectionOp>(reqInOut.getServicePortAttr(),
-                                          reqInOut.getToServer(),
-                                          reqInOut.getClientNamePathAttr());
+    reqs.push_back(b.create<RequestToServerConnectionOp>(
+        reqInOut.getServicePortAttr(), reqInOut.getToServer(),
+        reqInOut.getClientNamePathAttr()));
     auto toClientReq = b.create<RequestToClientConnectionOp>(
         reqInOut.getToClient().getType(), reqInOut.getServicePortAttr(),
         reqInOut.getClientNamePathAttr());
+    reqs.push_back(toClientReq);
     reqInOut.getToClient().replaceAllUsesWith(toClientReq.getToClient());
     reqInOut.erase();
   });
 
-  // Find all of the "local" requests.
-  mod.walk([&](Operation *op) {
-    if (auto req = dyn_cast<RequestToClientConnectionOp>(op)) {
-      auto service = req.getServicePortAttr().getModuleRef();
-      auto implOpF = localImplReqs.find(service);
-      if (implOpF != localImplReqs.end())
-        req->moveBefore(implOpF->second, implOpF->second->end());
-      else if (anyServiceInst)
-        req->moveBefore(anyServiceInst, anyServiceInst->end());
-    } else if (auto req = dyn_cast<RequestToServerConnectionOp>(op)) {
-      auto service = req.getServicePortAttr().getModuleRef();
-      auto implOpF = localImplReqs.find(service);
-      if (implOpF != localImplReqs.end())
-        req->moveBefore(implOpF->second, implOpF->second->end());
-      else if (anyServiceInst)
-        req->moveBefore(anyServiceInst, anyServiceInst->end());
-    }
-  });
+  // Find all of the "local" requests. Remember the others, since the local
+  // ones may be erased by the generators.
+  SmallVector<Operation *, 8> nonLocalReqs;
+  for (Operation *req : reqs) {
+    auto implOpF = localImplReqs.find(getRequestedService(req));
+    if (implOpF != localImplReqs.end())
+      req->moveBefore(implOpF->second, implOpF->second->end());
+    else if (anyServiceInst)
+      req->moveBefore(anyServiceInst, anyServiceInst->end());
+    else
+      nonLocalReqs.push_back(req);
+  }
 
   // Replace each service instance with a generation request. If a service
   // generator is registered, generate the server.
@@ -384,19 +397,23 @@ LogicalResult ESIConnectServicesPass::process(hw::HWMutableModuleLike mod) {
   // Identify the non-local reqs which need to be surfaced from this module.
   SmallVector<RequestToClientConnectionOp, 4> nonLocalToClientReqs;
   SmallVector<RequestToServerConnectionOp, 4> nonLocalToServerReqs;
-  mod.walk([&](Operation *op) {
-    if (auto req = dyn_cast<RequestToClientConnectionOp>(op)) {
-      auto service = req.getServicePortAttr().getModuleRef();
-      auto implOpF = localImplReqs.find(service);
-      if (implOpF == localImplReqs.end())
-        nonLocalToClientReqs.push_back(req);
-    } else if (auto req = dyn_cast<RequestToServerConnectionOp>(op)) {
-      auto service = req.getServicePortAttr().getModuleRef();
-      auto implOpF = localImplReqs.find(service);
-      if (implOpF == localImplReqs.end())
-        nonLocalToServerReqs.push_back(req);
-    }
-  });
+  auto addNonLocal = [&](Operation *op) {
+    if (auto req = dyn_cast<RequestToClientConnectionOp>(op))
+      nonLocalToClientReqs.push_back(req);
+    else
+      nonLocalToServerReqs.push_back(cast<RequestToServerConnectionOp>(op));
+  };
+  if (!anyServiceInst) {
+    llvm::for_each(nonLocalReqs, addNonLocal);
+  } else {
+    // The generator of a service instance implementing any service may have
+    // consumed the requests handed to it, so look for the remaining ones.
+    mod.walk([&](Operation *op) {
+      if (isa<RequestToClientConnectionOp, RequestToServerConnectionOp>(op) &&
+          !localImplReqs.count(getRequestedService(op)))
+        addNonLocal(op);
+    });
+  }
 
   // Surface all of the requests which cannot be fulfilled locally.
   if (nonLocalToClientReqs.empty() && nonLocalToServerReqs.empty())
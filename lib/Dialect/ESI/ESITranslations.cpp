@@ -2,6 +2,7 @@
 //
 // ESI translations:
 // - Cap'nProto schema generation
+// - C++ message codec generation
 //
 //===----------------------------------------------------------------------===//
 
@@ -167,6 +168,56 @@ LogicalResult circt::esi::exportCosimSchema(ModuleOp module,
   return schema.emit();
 }
 
+//===----------------------------------------------------------------------===//
+// ESI Cosim C++ codec generation.
+//
+// Software talking to the cosim endpoints can encode and decode their messages
+// with the generic capnp builder and reader. This translation instead creates a
+// header with a struct per `esi.cosim` type, packing and unpacking the message
+// words directly. It requires CAPNP to be enabled.
+//===----------------------------------------------------------------------===//
+
+LogicalResult circt::esi::exportCosimCppCodecs(ModuleOp module,
+                                               llvm::raw_ostream &os) {
+  SmallVector<capnp::TypeSchema> types;
+  auto walkResult = module.walk([&types](CosimEndpointOp ep) {
+    Type epTypes[] = {ep.getSend().getType(), ep.getRecv().getType()};
+    for (Type type : epTypes) {
+      capnp::TypeSchema schema(type);
+      if (!schema.isSupported()) {
+        ep.emitOpError("Type '") << type << "' not supported.";
+        return mlir::WalkResult::interrupt();
+      }
+      types.push_back(schema);
+    }
+    return mlir::WalkResult::advance();
+  });
+  if (walkResult.wasInterrupted())
+    return failure();
+
+  // We need a sorted list to ensure determinism.
+  llvm::sort(types.begin(), types.end(),
+             [](capnp::TypeSchema &a, capnp::TypeSchema &b) {
+               return a.capnpTypeID() > b.capnpTypeID();
+             });
+  auto end = std::unique(types.begin(), types.end());
+
+  os << "// ESI generated message codecs.\n"
+     << "// Messages are single capnp segments, as sent over the cosim RPC\n"
+     << "// interface, on a little-endian host.\n\n"
+     << "#pragma once\n\n"
+     << "#include <array>\n"
+     << "#include <cstdint>\n"
+     << "#include <cstring>\n\n"
+     << "namespace esi_cosim {\n";
+  capnp::TypeSchema::writeCppCodecPreamble(os);
+  for (auto typeIter = types.begin(); typeIter < end; ++typeIter)
+    if (failed(typeIter->writeCppCodec(os)))
+      return failure();
+  os << "} // namespace esi_cosim\n";
+  return success();
+}
+
 #else // Not CAPNP
 
 LogicalResult circt::esi::exportCosimSchema(ModuleOp module,
@@ -175,6 +226,12 @@ LogicalResult circt::esi::exportCosimSchema(ModuleOp module,
                          "Not compiled with CAPNP support");
 }
 
+LogicalResult circt::esi::exportCosimCppCodecs(ModuleOp module,
+                                               llvm::raw_ostream &os) {
+  return mlir::emitError(UnknownLoc::get(module.getContext()),
+                         "Not compiled with CAPNP support");
+}
+
 #endif
 
 //===----------------------------------------------------------------------===//
@@ -189,5 +246,11 @@ void circt::esi::registerESITranslations() {
         registry.insert<ESIDialect, circt::hw::HWDialect, circt::sv::SVDialect,
                         mlir::func::FuncDialect, mlir::BuiltinDialect>();
       });
+  mlir::TranslateFromMLIRRegistration cosimToCpp(
+      "export-esi-cosim-cpp", "ESI Cosim C++ message codec generation",
+      exportCosimCppCodecs, [](mlir::DialectRegistry &registry) {
+        registry.insert<ESIDialect, circt::hw::HWDialect, circt::sv::SVDialect,
+                        mlir::func::FuncDialect, mlir::BuiltinDialect>();
+      });
 #endif
 }
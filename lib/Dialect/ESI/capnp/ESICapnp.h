@@ -68,6 +68,13 @@ public:
   /// Write out the schema in its entirety.
   mlir::LogicalResult write(llvm::raw_ostream &os) const;
 
+  /// Write out a C++ struct for this type, with functions packing and
+  /// unpacking it directly to and from the words of a message segment.
+  mlir::LogicalResult writeCppCodec(llvm::raw_ostream &os) const;
+  /// Write out the helpers used by the C++ codecs, which must precede them in
+  /// the same namespace. They need <array>, <cstdint> and <cstring>.
+  static void writeCppCodecPreamble(llvm::raw_ostream &os);
+
   /// Build an HW/SV dialect capnp encoder for this type.
   mlir::Value buildEncoder(mlir::OpBuilder &, mlir::Value clk,
                            mlir::Value valid, mlir::Value rawData) const;
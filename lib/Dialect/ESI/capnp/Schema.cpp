@@ -101,6 +101,7 @@ public:
   StringRef name() const;
   LogicalResult write(llvm::raw_ostream &os) const;
   void writeMetadata(llvm::raw_ostream &os) const;
+  LogicalResult writeCppCodec(llvm::raw_ostream &os) const;
 
   bool operator==(const TypeSchemaImpl &) const;
 
@@ -1229,6 +1230,263 @@ hw::HWModuleOp TypeSchemaImpl::buildDecoder(Value clk, Value valid,
   return retMod;
 }
 
+//===----------------------------------------------------------------------===//
+// C++ message codec generation.
+//
+// Software which knows the ESI type of a message does not need the generic
+// capnp reader and builder: the layout of the message is fixed by the schema,
+// so it can be packed and unpacked with direct loads, stores and shifts on the
+// words of the segment. The generated code lays out messages the same way as
+// the encode gasket: the root struct right after the root pointer, followed by
+// the lists in field order.
+//===----------------------------------------------------------------------===//
+
+/// Write the C++ type holding the capnp encoding of 'type'. Zero-width values
+/// have no storage, so they must be skipped by the caller.
+static void emitCppType(Type type, llvm::raw_ostream &os) {
+  llvm::TypeSwitch<Type>(type)
+      .Case([&os](IntegerType intTy) {
+        auto w = intTy.getWidth();
+        assert(w > 0 && w <= 64 && "Unsupported integer width");
+        if (w == 1) {
+          os << "bool";
+          return;
+        }
+        os << (intTy.isSigned() ? "int" : "uint")
+           << std::max<uint64_t>(8, llvm::PowerOf2Ceil(w)) << "_t";
+      })
+      .Case([&os](hw::ArrayType arrTy) {
+        os << "std::array<";
+        emitCppType(arrTy.getElementType(), os);
+        os << ", " << arrTy.getSize() << ">";
+      })
+      .Default([](Type) {
+        assert(false && "Type not supported. Please check support first with "
+                        "isSupported()");
+      });
+}
+
+/// Return true if values of 'type' have no storage in C++.
+static bool isZeroWidth(Type type) {
+  if (auto arrTy = type.dyn_cast<hw::ArrayType>())
+    return isZeroWidth(arrTy.getElementType());
+  return type.isInteger(0);
+}
+
+/// Write an expression storing `value`, of capnp type 'type', in the low bits
+/// of a word.
+static void emitCppToWord(::capnp::schema::Type::Reader type, StringRef value,
+                          llvm::raw_ostream &os) {
+  if (bits(type) == 1) {
+    os << "uint64_t(" << value << ")";
+    return;
+  }
+  os << "uint64_t(uint" << bits(type) << "_t(" << value << "))";
+}
+
+/// Write an expression extracting the value of 'mType', encoded as capnp
+/// 'type', from bit `shift` of `word`.
+static void emitCppFromWord(::capnp::schema::Type::Reader type, Type mType,
+                            StringRef word, StringRef shift,
+                            llvm::raw_ostream &os) {
+  if (bits(type) == 1) {
+    os << "((" << word << " >> " << shift << ") & 1) != 0";
+    return;
+  }
+  emitCppType(mType, os);
+  os << "(" << word << " >> " << shift << ")";
+}
+
+/// The helpers shared by the generated codecs.
+static constexpr const char *cppCodecPreamble = R"(
+/// Return the data section of the root struct of a message segment, or nullptr
+/// if the root is not a struct with these section sizes.
+inline const uint64_t *getRootStruct(const uint64_t *words, size_t size,
+                                     uint64_t dataWords, uint64_t ptrWords) {
+  if (size < 1 || (words[0] & 3) != 0 ||
+      (words[0] >> 32) != ((ptrWords << 16) | dataWords))
+    return nullptr;
+  if (dataWords == 0 && ptrWords == 0)
+    return words;
+  int64_t offset = 1 + (int32_t(uint32_t(words[0])) >> 2);
+  if (offset < 1 || uint64_t(offset) + dataWords + ptrWords > size)
+    return nullptr;
+  return words + offset;
+}
+
+/// Find the list `ptr` points to. A null pointer is an empty list. Return false
+/// if the pointer is not to a list of at most `maxLength` elements of
+/// `elemSize` encoding within the segment.
+inline bool getList(const uint64_t *words, size_t size, const uint64_t *ptr,
+                    uint64_t elemSize, uint64_t elemBits, size_t maxLength,
+                    const uint64_t *&list, size_t &length) {
+  uint64_t p = *ptr;
+  list = nullptr;
+  length = 0;
+  if (p == 0)
+    return true;
+  if ((p & 3) != 1 || ((p >> 32) & 7) != elemSize)
+    return false;
+  length = p >> 35;
+  int64_t offset = (ptr - words) + 1 + (int32_t(uint32_t(p)) >> 2);
+  if (length > maxLength || offset < 0 ||
+      uint64_t(offset) + (length * elemBits + 63) / 64 > size)
+    return false;
+  list = words + offset;
+  return true;
+}
+
+)";
+
+/// Emit a C++ struct for this type with `pack` and `unpack` functions which
+/// work on the words of a single message segment. The generated code relies on
+/// the helpers from `TypeSchema::writeCppCodecPreamble`.
+LogicalResult TypeSchemaImpl::writeCppCodec(llvm::raw_ostream &rawOS) const {
+  IndentingOStream os(rawOS);
+  auto st = getTypeSchema().getProto().getStruct();
+  uint64_t dataWords = st.getDataWordCount();
+  uint64_t ptrWords = st.getPointerCount();
+  uint64_t numWords = size() / 64;
+
+  // The root struct pointer. An empty struct has an offset of -1.
+  uint64_t rootPtr = (ptrWords << 48) | (dataWords << 32);
+  if (dataWords == 0 && ptrWords == 0)
+    rootPtr |= 0xFFFFFFFC;
+
+  os.indent() << "/// ESI type " << type << ".\n";
+  os.indent() << "struct " << name() << " {\n";
+  os.addIndent();
+  for (auto field : fieldTypes) {
+    if (isZeroWidth(field.type))
+      continue;
+    os.indent();
+    emitCppType(field.type, rawOS);
+    os << " " << field.name.getValue() << ";\n";
+  }
+  os << "\n";
+  os.indent() << "static constexpr uint64_t capnpTypeID = "
+              << llvm::format_hex(capnpTypeID(), 16 + 2) << "ULL;\n";
+  os.indent() << "/// The size of an encoded message, in 64-bit words.\n";
+  os.indent() << "static constexpr size_t numWords = " << numWords << ";\n\n";
+
+  // Encoder. Lists are allocated after the root struct, in field order.
+  os.indent() << "/// Encode into `words`, which must have room for `numWords` "
+                 "words.\n";
+  os.indent() << "void pack(uint64_t *words) const {\n";
+  os.addIndent();
+  os.indent() << "std::memset(words, 0, numWords * sizeof(uint64_t));\n";
+  os.indent() << "words[0] = " << llvm::format_hex(rootPtr, 16 + 2)
+              << "ULL;\n";
+  uint64_t nextListWord = 1 + dataWords + ptrWords;
+  for (auto field : st.getFields()) {
+    Type mType = fieldTypes[field.getCodeOrder()].type;
+    StringRef fieldName = fieldTypes[field.getCodeOrder()].name.getValue();
+    auto cType = field.getSlot().getType();
+    uint64_t offset = field.getSlot().getOffset();
+
+    if (!isPointerType(cType)) {
+      if (isZeroWidth(mType))
+        continue;
+      uint64_t bit = offset * bits(cType);
+      os.indent() << "words[" << 1 + bit / 64 << "] |= ";
+      emitCppToWord(cType, fieldName, rawOS);
+      os << " << " << bit % 64 << ";\n";
+      continue;
+    }
+
+    auto arrTy = mType.cast<hw::ArrayType>();
+    auto elemType = cType.getList().getElementType();
+    uint64_t elemBits = bits(elemType);
+    uint64_t ptrWord = 1 + dataWords + offset;
+    uint64_t listPtr = (uint64_t(arrTy.getSize()) << 35) |
+                       (uint64_t(bitsEncoding(elemType)) << 32) |
+                       (((nextListWord - ptrWord - 1) << 2) & 0xFFFFFFFC) | 1;
+    os.indent() << "words[" << ptrWord << "] = "
+                << llvm::format_hex(listPtr, 16 + 2) << "ULL;\n";
+    if (elemBits != 0) {
+      uint64_t perWord = 64 / elemBits;
+      os.indent() << "for (size_t i = 0; i < " << arrTy.getSize()
+                  << "; ++i)\n";
+      os.addIndent();
+      os.indent() << "words[" << nextListWord << " + i / " << perWord
+                  << "] |= ";
+      emitCppToWord(elemType, (fieldName + "[i]").str(), rawOS);
+      os << " << (i % " << perWord << " * " << elemBits << ");\n";
+      os.reduceIndent();
+    }
+    nextListWord += llvm::divideCeil(arrTy.getSize() * elemBits, 64);
+  }
+  assert(nextListWord == numWords && "Layout does not match the size");
+  os.reduceIndent();
+  os.indent() << "}\n\n";
+
+  // Decoder. Unlike the encoder, it follows the pointers in the message, so it
+  // accepts any message with this layout, canonical or not.
+  os.indent() << "/// Decode from a message segment of `size` words. Return "
+                 "false if it does\n";
+  os.indent() << "/// not hold a message of this type.\n";
+  os.indent() << "bool unpack(const uint64_t *words, size_t size) {\n";
+  os.addIndent();
+  os.indent() << "const uint64_t *data = getRootStruct(words, size, "
+              << dataWords << ", " << ptrWords << ");\n";
+  os.indent() << "if (!data)\n";
+  os.indent() << "  return false;\n";
+  for (auto field : st.getFields()) {
+    Type mType = fieldTypes[field.getCodeOrder()].type;
+    StringRef fieldName = fieldTypes[field.getCodeOrder()].name.getValue();
+    auto cType = field.getSlot().getType();
+    uint64_t offset = field.getSlot().getOffset();
+
+    if (!isPointerType(cType)) {
+      if (isZeroWidth(mType))
+        continue;
+      uint64_t bit = offset * bits(cType);
+      os.indent() << fieldName << " = ";
+      emitCppFromWord(cType, mType, ("data[" + Twine(bit / 64) + "]").str(),
+                      std::to_string(bit % 64), rawOS);
+      os << ";\n";
+      continue;
+    }
+
+    auto arrTy = mType.cast<hw::ArrayType>();
+    auto elemType = cType.getList().getElementType();
+    uint64_t elemBits = bits(elemType);
+    os.indent() << "{\n";
+    os.addIndent();
+    os.indent() << "const uint64_t *list;\n";
+    os.indent() << "size_t length;\n";
+    os.indent() << "if (!getList(words, size, data + "
+                << dataWords + offset << ", " << bitsEncoding(elemType)
+                << ", " << elemBits << ", " << arrTy.getSize()
+                << ", list, length))\n";
+    os.indent() << "  return false;\n";
+    if (elemBits != 0) {
+      uint64_t perWord = 64 / elemBits;
+      os.indent() << fieldName << " = {};\n";
+      os.indent() << "for (size_t i = 0; i < length; ++i)\n";
+      os.addIndent();
+      os.indent() << fieldName << "[i] = ";
+      emitCppFromWord(elemType, arrTy.getElementType(),
+                      ("list[i / " + Twine(perWord) + "]").str(),
+                      ("(i % " + Twine(perWord) + " * " + Twine(elemBits) +
+                       ")")
+                          .str(),
+                      rawOS);
+      os << ";\n";
+      os.reduceIndent();
+    }
+    os.reduceIndent();
+    os.indent() << "}\n";
+  }
+  os.indent() << "return true;\n";
+  os.reduceIndent();
+  os.indent() << "}\n";
+
+  os.reduceIndent();
+  os.indent() << "};\n\n";
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // TypeSchema wrapper.
 //===----------------------------------------------------------------------===//
@@ -1260,6 +1518,14 @@ circt::esi::capnp::TypeSchema::write(llvm::raw_ostream &os) const {
 void circt::esi::capnp::TypeSchema::writeMetadata(llvm::raw_ostream &os) const {
   s->writeMetadata(os);
 }
+LogicalResult
+circt::esi::capnp::TypeSchema::writeCppCodec(llvm::raw_ostream &os) const {
+  return s->writeCppCodec(os);
+}
+void circt::esi::capnp::TypeSchema::writeCppCodecPreamble(
+    llvm::raw_ostream &os) {
+  os << cppCodecPreamble;
+}
 bool circt::esi::capnp::TypeSchema::operator==(const TypeSchema &that) const {
   return *s == *that.s;
 }
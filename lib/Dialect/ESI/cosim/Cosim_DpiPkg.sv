@@ -74,4 +74,21 @@ import "DPI-C" sv2cCosimserverEpTryGet =
     inout  int unsigned data_size
     );
 
+// Attempt to recieve several messages from a client in a single call.
+//   - Returns negative when call failed (e.g. EP not registered).
+//   - The messages are put in consecutive msg_size byte slots of data[], each
+//   zero-padded to msg_size.
+import "DPI-C" sv2cCosimserverEpTryGetMany =
+  function int cosim_ep_tryget_many(
+    // The ID of the endpoint from which data should be recieved.
+    input string endpoint_id,
+    // The buffer in which to put the messages.
+    inout byte unsigned data[],
+    // The size of the slot of each message, in bytes.
+    input int unsigned msg_size,
+    // Input: the maximum number of messages to get. If -1, fill data[].
+    // Output: the number of messages recieved.
+    inout int unsigned num_msgs
+    );
+
 endpackage // Cosim_DpiPkg
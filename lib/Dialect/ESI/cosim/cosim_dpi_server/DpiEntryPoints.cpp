@@ -32,15 +32,15 @@ static std::mutex serverMutex;
 // ---- Helper functions ----
 
 /// Emit the contents of 'msg' to the log file in hex.
-static void log(char *epId, bool toClient, const Endpoint::BlobPtr &msg) {
+static void log(char *epId, bool toClient, const uint8_t *msg,
+                size_t msgSize) {
   std::lock_guard<std::mutex> g(serverMutex);
   if (!logFile)
     return;
 
   fprintf(logFile, "[ep: %50s to: %4s]", epId, toClient ? "host" : "sim");
-  size_t msgSize = msg->size();
   for (size_t i = 0; i < msgSize; ++i) {
-    auto b = (*msg)[i];
+    auto b = msg[i];
     // Separate 32-bit words.
     if (i % 4 == 0 && i > 0)
       fprintf(logFile, " ");
@@ -65,6 +65,30 @@ static int findPort() {
   return std::strtoull(portEnv, nullptr, 10);
 }
 
+/// Get the interval, in seconds, at which to dump the endpoint statistics. If
+/// it isn't specified via an environment variable, return 0 to disable the
+/// dumps.
+static int findStatsInterval() {
+  const char *intervalEnv = getenv("COSIM_STATS_INTERVAL");
+  if (intervalEnv == nullptr)
+    return 0;
+  return std::max(atoi(intervalEnv), 0);
+}
+
+/// Print the endpoint statistics to the log file, or stdout if there is none.
+/// Called from the RPC server thread.
+static void dumpStats() {
+  // Finishing holds the lock while it waits for the RPC server thread, in which
+  // case this dump is skipped.
+  std::unique_lock<std::mutex> g(serverMutex, std::try_to_lock);
+  if (!g.owns_lock() || server == nullptr)
+    return;
+  FILE *out = logFile ? logFile : stdout;
+  fprintf(out, "[cosim] Endpoint statistics:\n");
+  server->endpoints.printStats(out);
+  fflush(out);
+}
+
 /// Check that an array is an array of bytes and has some size.
 // NOLINTNEXTLINE(misc-misplaced-const)
 static int validateSvOpenArray(const svOpenArrayHandle data,
@@ -112,6 +136,93 @@ DPI int sv2cCosimserverEpRegister(char *endpointId, long long sendTypeId,
   return -1;
 }
 
+/// A message to the simulation, read in place from the RPC queue or from the
+/// shared memory ring of the endpoint.
+struct MessageToSim {
+  const uint8_t *data;
+  uint64_t size;
+  bool fromShm;
+};
+
+/// Return the oldest message to the simulation, if any.
+static bool frontToSim(Endpoint *ep, MessageToSim &msg) {
+  if (const Endpoint::Blob *blob = ep->getQueueToSim().front()) {
+    msg = {blob->data(), blob->size(), false};
+    return true;
+  }
+  if (ShmRegion *shm = ep->getShm()) {
+    msg.data = shm->toSim.front(msg.size);
+    msg.fromShm = true;
+    if (msg.data)
+      return true;
+    ep->getShmStatsToSim().recordEmptyPoll();
+  }
+  ep->getQueueToSim().getStats().recordEmptyPoll();
+  return false;
+}
+
+/// Release the message returned by `frontToSim`.
+static void popToSim(Endpoint *ep, const MessageToSim &msg) {
+  if (msg.fromShm) {
+    ep->getShmStatsToSim().recordMessage(msg.size);
+    ep->getShm()->toSim.pop();
+  } else
+    ep->getQueueToSim().pop();
+}
+
+/// Move the messages which were queued while the shared memory ring to the
+/// client was full to the ring.
+static void flushToClient(Endpoint *ep, ShmRegion *shm) {
+  MessageQueue &queue = ep->getQueueToClient();
+  while (const Endpoint::Blob *msg = queue.front()) {
+    if (!shm->toClient.push(msg->data(), msg->size()))
+      return;
+    ep->getShmStatsToClient().recordMessage(msg->size());
+    queue.pop();
+  }
+}
+
+/// Copy a message to the simulator's buffer and set its size, following the
+/// conventions of `sv2cCosimserverEpTryGet`.
+static int copyToSvArray(const uint8_t *msg, size_t msgSize,
+                         // NOLINTNEXTLINE(misc-misplaced-const)
+                         const svOpenArrayHandle data,
+                         unsigned int *dataSize) {
+  if (validateSvOpenArray(data, sizeof(int8_t)) != 0) {
+    printf("ERROR: DPI-func=%s line=%d event=invalid-sv-array\n", __func__,
+           __LINE__);
+    return -2;
+  }
+
+  // Detect or verify size of buffer.
+  if (*dataSize == ~0u) {
+    *dataSize = svSizeOfArray(data);
+  } else if (*dataSize > (unsigned)svSizeOfArray(data)) {
+    printf("ERROR: DPI-func=%s line %d event=invalid-size (max %d)\n", __func__,
+           __LINE__, (unsigned)svSizeOfArray(data));
+    return -3;
+  }
+  // Verify it'll fit.
+  if (msgSize > *dataSize) {
+    printf("ERROR: Message size too big to fit in HW buffer\n");
+    return -5;
+  }
+
+  // Copy the message data.
+  size_t i;
+  for (i = 0; i < msgSize; ++i) {
+    auto b = msg[i];
+    *(char *)svGetArrElemPtr1(data, i) = b;
+  }
+  // Zero out the rest of the buffer.
+  for (; i < *dataSize; ++i) {
+    *(char *)svGetArrElemPtr1(data, i) = 0;
+  }
+  // Set the output data size.
+  *dataSize = msgSize;
+  return 0;
+}
+
 // Attempt to recieve data from a client.
 //   - Returns negative when call failed (e.g. EP not registered).
 //   - If no message, return 0 with dataSize == 0.
@@ -131,9 +242,14 @@ DPI int sv2cCosimserverEpTryGet(char *endpointId,
     return -4;
   }
 
-  Endpoint::BlobPtr msg;
-  // Poll for a message.
-  if (!ep->getMessageToSim(msg)) {
+  // Polls happen at every clock, which keeps messages to a shared memory
+  // client flowing when its ring fills up.
+  if (ShmRegion *shm = ep->getShm())
+    flushToClient(ep, shm);
+
+  // Poll for a message, which is read in place.
+  MessageToSim msg;
+  if (!frontToSim(ep, msg)) {
     // No message.
     *dataSize = 0;
     return 0;
@@ -142,41 +258,73 @@ DPI int sv2cCosimserverEpTryGet(char *endpointId,
   // simulator is going to poll up to every tick and there's not going to be
   // a message most of the time, this is important for performance.
 
-  log(endpointId, false, msg);
+  log(endpointId, false, msg.data, msg.size);
+  int rc = copyToSvArray(msg.data, msg.size, data, dataSize);
+  popToSim(ep, msg);
+  return rc;
+}
+
+// Attempt to recieve several messages from a client, to drain them in a single
+// call.
+//   - Returns negative when call failed (e.g. EP not registered).
+//   - The messages are put in consecutive 'msgSize' byte slots of 'data', each
+//     zero-padded. Fails if a message does not fit in a slot.
+//   - On input, 'numMsgs' is the maximum number of messages to get, or ~0 to
+//     fill 'data'. On output, it is the number of messages received.
+DPI int sv2cCosimserverEpTryGetMany(char *endpointId,
+                                    // NOLINTNEXTLINE(misc-misplaced-const)
+                                    const svOpenArrayHandle data,
+                                    unsigned int msgSize,
+                                    unsigned int *numMsgs) {
+  if (server == nullptr)
+    return -1;
+
+  Endpoint *ep = server->endpoints[endpointId];
+  if (!ep) {
+    fprintf(stderr, "Endpoint not found in registry!\n");
+    return -4;
+  }
+
+  if (ShmRegion *shm = ep->getShm())
+    flushToClient(ep, shm);
+
+  unsigned int maxMsgs = *numMsgs;
+  *numMsgs = 0;
+  MessageToSim msg;
+  if (!frontToSim(ep, msg))
+    return 0;
 
   if (validateSvOpenArray(data, sizeof(int8_t)) != 0) {
     printf("ERROR: DPI-func=%s line=%d event=invalid-sv-array\n", __func__,
            __LINE__);
     return -2;
   }
-
-  // Detect or verify size of buffer.
-  if (*dataSize == ~0u) {
-    *dataSize = svSizeOfArray(data);
-  } else if (*dataSize > (unsigned)svSizeOfArray(data)) {
-    printf("ERROR: DPI-func=%s line %d event=invalid-size (max %d)\n", __func__,
-           __LINE__, (unsigned)svSizeOfArray(data));
+  if (msgSize == 0) {
+    printf("ERROR: DPI-func=%s line %d event=invalid-size (0)\n", __func__,
+           __LINE__);
     return -3;
   }
-  // Verify it'll fit.
-  size_t msgSize = msg->size();
-  if (msgSize > *dataSize) {
-    printf("ERROR: Message size too big to fit in HW buffer\n");
-    return -5;
-  }
+  maxMsgs = std::min(maxMsgs, (unsigned)svSizeOfArray(data) / msgSize);
+  if (maxMsgs == 0)
+    return 0;
 
-  // Copy the message data.
-  size_t i;
-  for (i = 0; i < msgSize; ++i) {
-    auto b = (*msg)[i];
-    *(char *)svGetArrElemPtr1(data, i) = b;
-  }
-  // Zero out the rest of the buffer.
-  for (; i < *dataSize; ++i) {
-    *(char *)svGetArrElemPtr1(data, i) = 0;
-  }
-  // Set the output data size.
-  *dataSize = msg->size();
+  do {
+    log(endpointId, false, msg.data, msg.size);
+    if (msg.size > msgSize) {
+      printf("ERROR: Message size too big to fit in HW buffer\n");
+      popToSim(ep, msg);
+      return -5;
+    }
+    // Copy the message data and zero out the rest of its slot.
+    size_t base = *numMsgs * msgSize;
+    size_t i;
+    for (i = 0; i < msg.size; ++i)
+      *(char *)svGetArrElemPtr1(data, base + i) = msg.data[i];
+    for (; i < msgSize; ++i)
+      *(char *)svGetArrElemPtr1(data, base + i) = 0;
+    popToSim(ep, msg);
+    ++*numMsgs;
+  } while (*numMsgs < maxMsgs && frontToSim(ep, msg));
   return 0;
 }
 
@@ -205,19 +353,33 @@ DPI int sv2cCosimserverEpTryPut(char *endpointId,
     return -3;
   }
 
-  Endpoint::BlobPtr blob = std::make_shared<Endpoint::Blob>(dataSize);
-  // Copy the message data into 'blob'.
-  for (int i = 0; i < dataSize; ++i) {
-    (*blob)[i] = *(char *)svGetArrElemPtr1(data, i);
-  }
-  // Queue the blob.
   Endpoint *ep = server->endpoints[endpointId];
   if (!ep) {
     fprintf(stderr, "Endpoint not found in registry!\n");
     return -4;
   }
-  log(endpointId, true, blob);
-  ep->pushMessageToClient(blob);
+  // Copy the message data straight into the shared memory ring to the client,
+  // if it has one. The queue takes the messages which do not fit, in order.
+  MessageQueue &queue = ep->getQueueToClient();
+  ShmRegion *shm = ep->getShm();
+  uint8_t *msg = nullptr;
+  if (shm) {
+    flushToClient(ep, shm);
+    if (!queue.front())
+      msg = shm->toClient.reserve(dataSize);
+  }
+  bool toShm = msg != nullptr;
+  if (!toShm)
+    msg = queue.reserve(dataSize);
+  for (int i = 0; i < dataSize; ++i) {
+    msg[i] = *(char *)svGetArrElemPtr1(data, i);
+  }
+  log(endpointId, true, msg, dataSize);
+  if (toShm) {
+    shm->toClient.commit(dataSize);
+    ep->getShmStatsToClient().recordMessage(dataSize);
+  } else
+    queue.commit(dataSize);
   return 0;
 }
 
@@ -250,6 +412,8 @@ DPI int sv2cCosimserverInit() {
     // Find the port and run.
     printf("[cosim] Starting RPC server.\n");
     server = new RpcServer();
+    if (int interval = findStatsInterval())
+      server->setStatsDump(std::chrono::seconds(interval), dumpStats);
     server->run(findPort());
   }
   return 0;
@@ -12,11 +12,20 @@
 
 #include "circt/Dialect/ESI/cosim/Endpoint.h"
 
+#include <algorithm>
+#include <string>
+#include <unistd.h>
+
 using namespace circt::esi::cosim;
 
 Endpoint::Endpoint(uint64_t sendTypeId, int sendTypeMaxSize,
                    uint64_t recvTypeId, int recvTypeMaxSize)
-    : sendTypeId(sendTypeId), recvTypeId(recvTypeId), inUse(false) {}
+    : sendTypeId(sendTypeId), sendTypeMaxSize(sendTypeMaxSize),
+      recvTypeId(recvTypeId), recvTypeMaxSize(recvTypeMaxSize), inUse(false),
+      // The simulation receives messages of the recv type and sends messages
+      // of the send type.
+      toCosim(std::max(recvTypeMaxSize, 0)),
+      toClient(std::max(sendTypeMaxSize, 0)) {}
 Endpoint::~Endpoint() {}
 
 bool Endpoint::setInUse() {
@@ -27,6 +36,20 @@ bool Endpoint::setInUse() {
   return true;
 }
 
+ShmRegion *Endpoint::attachShm() {
+  if (ShmRegion *region = getShm())
+    return region;
+
+  // Shared memory object names need to be unique on the host.
+  static std::atomic<unsigned> nextRegion{0};
+  std::string name = "/esi-cosim-" + std::to_string(getpid()) + "-" +
+                     std::to_string(nextRegion++);
+  shmRegion = ShmRegion::create(name, std::max(recvTypeMaxSize, 0),
+                                std::max(sendTypeMaxSize, 0));
+  shm.store(shmRegion.get(), std::memory_order_release);
+  return shmRegion.get();
+}
+
 void Endpoint::returnForUse() {
   Lock g(m);
   if (!inUse)
@@ -70,3 +93,42 @@ size_t EndpointRegistry::size() const {
   Lock g(const_cast<EndpointRegistry *>(this)->m);
   return endpoints.size();
 }
+
+/// Print the statistics of one direction of an endpoint.
+static void printQueueStats(FILE *file, const char *direction,
+                            const QueueStats &stats) {
+  QueueStats::Snapshot snapshot = stats.getSnapshot();
+  fprintf(file,
+          "  to %-12s messages: %llu bytes: %llu max depth: %llu "
+          "empty polls: %llu\n",
+          direction, (unsigned long long)snapshot.messages,
+          (unsigned long long)snapshot.bytes,
+          (unsigned long long)snapshot.maxDepth,
+          (unsigned long long)snapshot.emptyPolls);
+  if (std::all_of(snapshot.latency.begin(), snapshot.latency.end(),
+                  [](uint64_t count) { return count == 0; }))
+    return;
+  fprintf(file, "    latency (us):");
+  for (unsigned i = 0; i < QueueStats::numLatencyBuckets; ++i) {
+    if (!snapshot.latency[i])
+      continue;
+    if (i + 1 < QueueStats::numLatencyBuckets)
+      fprintf(file, " <%llu: ", 2ull << i);
+    else
+      fprintf(file, " >=%llu: ", 1ull << i);
+    fprintf(file, "%llu", (unsigned long long)snapshot.latency[i]);
+  }
+  fprintf(file, "\n");
+}
+
+void EndpointRegistry::printStats(FILE *file) const {
+  iterateEndpoints([&](std::string id, const Endpoint &ep) {
+    fprintf(file, "[ep: %s]\n", id.c_str());
+    printQueueStats(file, "sim", ep.getQueueToSim().getStats());
+    printQueueStats(file, "client", ep.getQueueToClient().getStats());
+    if (ep.getShm()) {
+      printQueueStats(file, "sim (shm)", ep.getShmStatsToSim());
+      printQueueStats(file, "client (shm)", ep.getShmStatsToClient());
+    }
+  });
+}
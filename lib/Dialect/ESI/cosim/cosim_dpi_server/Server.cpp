@@ -20,6 +20,8 @@
 #include "circt/Dialect/ESI/cosim/Server.h"
 #include "circt/Dialect/ESI/cosim/CosimDpi.capnp.h"
 #include <capnp/ez-rpc.h>
+#include <kj/async.h>
+#include <kj/vector.h>
 #include <thread>
 #include <unistd.h>
 
@@ -51,6 +53,8 @@ public:
   kj::Promise<void> send(SendContext) override;
   kj::Promise<void> recv(RecvContext) override;
   kj::Promise<void> close(CloseContext) override;
+  kj::Promise<void> sendMany(SendManyContext) override;
+  kj::Promise<void> recvMany(RecvManyContext) override;
 };
 
 /// Implements the `CosimDpiServer` interface from the RPC schema.
@@ -65,6 +69,8 @@ public:
   kj::Promise<void> list(ListContext ctxt) override;
   /// Open a specific interface, locking it in the process.
   kj::Promise<void> open(OpenContext ctxt) override;
+  /// Report the statistics of all the interfaces.
+  kj::Promise<void> stats(StatsContext ctxt) override;
 };
 } // anonymous namespace
 
@@ -76,60 +82,118 @@ EndpointServer::~EndpointServer() {
     endpoint.returnForUse();
 }
 
+/// Read the message in a blob in place and pass it to `use`, which copies it
+/// into a response.
+template <typename UseFn>
+static void readMessage(const Endpoint::Blob &blob, UseFn use) {
+  KJ_REQUIRE(blob.size() % 8 == 0,
+             "Response msg was malformed. Size of response was not a "
+             "multiple of 8 bytes.");
+  // Wrap the message in a single segment.
+  auto segment =
+      kj::ArrayPtr<capnp::word>((word *)blob.data(), blob.size() / 8)
+          .asConst();
+  // Create a single-element array of segments.
+  kj::ArrayPtr<const kj::ArrayPtr<const capnp::word>> segments(&segment, 1);
+  // Create an object which will read the segments into a message on send.
+  SegmentArrayMessageReader msgReader(segments);
+  use(msgReader.getRoot<AnyPointer>());
+}
+
+/// Copy an RPC message to the queue. The message is copied once, straight into
+/// the queue, in the flat single segment format the DPI side expects.
+static void writeMessage(capnp::AnyPointer::Reader capnpMsgPointer,
+                         MessageQueue &queue) {
+  KJ_REQUIRE(capnpMsgPointer.isStruct(),
+             "Only messages can go in the 'msg' parameter");
+
+  // The message takes its root pointer plus its content.
+  size_t maxWords = capnpMsgPointer.targetSize().wordCount + 1;
+  auto *buffer = (word *)queue.reserve(maxWords * sizeof(word));
+  size_t msgSize;
+  {
+    FlatMessageBuilder builder(kj::arrayPtr(buffer, maxWords));
+    builder.setRoot(capnpMsgPointer);
+    auto segments = builder.getSegmentsForOutput();
+    KJ_ASSERT(segments.size() == 1);
+    msgSize = segments[0].asBytes().size();
+  }
+  queue.commit(msgSize);
+}
+
 /// This is the client polling for a message. If one is available, send it.
 /// TODO: implement a blocking call with a timeout.
 kj::Promise<void> EndpointServer::recv(RecvContext context) {
   KJ_REQUIRE(open, "EndPoint closed already");
+  KJ_REQUIRE(!endpoint.getShm(), "Endpoint uses shared memory");
   KJ_REQUIRE(!context.getParams().getBlock(),
              "Blocking recv() not supported yet");
 
-  // Try to pop a message.
-  Endpoint::BlobPtr blob;
-  auto msgPresent = endpoint.getMessageToClient(blob);
-  context.getResults().setHasData(msgPresent);
-  if (msgPresent) {
-    KJ_REQUIRE(blob->size() % 8 == 0,
-               "Response msg was malformed. Size of response was not a "
-               "multiple of 8 bytes.");
-    // Copy the blob into a single segment.
-    auto segment =
-        kj::ArrayPtr<capnp::word>((word *)blob->data(), blob->size() / 8)
-            .asConst();
-    // Create a single-element array of segments.
-    kj::Array<kj::ArrayPtr<const capnp::word>> segments =
-        kj::heapArray({segment});
-    // Create an object which will read the segments into a message on send.
-    std::unique_ptr<SegmentArrayMessageReader> msgReader =
-        std::make_unique<SegmentArrayMessageReader>(segments);
-    // Send.
-    context.getResults().getResp().set(msgReader->getRoot<AnyPointer>());
+  // Try to pop a message. It is read in place from the queue.
+  MessageQueue &queue = endpoint.getQueueToClient();
+  const Endpoint::Blob *blob = queue.front();
+  context.getResults().setHasData(blob != nullptr);
+  if (!blob)
+    queue.getStats().recordEmptyPoll();
+  if (blob) {
+    // Release the slot once the message was copied into the response.
+    KJ_DEFER(queue.pop());
+    readMessage(*blob, [&](AnyPointer::Reader msg) {
+      context.getResults().getResp().set(msg);
+    });
   }
   return kj::READY_NOW;
 }
 
 /// 'Send' is from the client perspective, so this is a message we are
-/// recieving. The only way I could figure out to copy the raw message is a
-/// double copy. I was have issues getting libkj's arrays to play nice with
-/// others.
+/// recieving.
 kj::Promise<void> EndpointServer::send(SendContext context) {
   KJ_REQUIRE(open, "EndPoint closed already");
-  auto capnpMsgPointer = context.getParams().getMsg();
-  KJ_REQUIRE(capnpMsgPointer.isStruct(),
-             "Only messages can go in the 'msg' parameter");
+  writeMessage(context.getParams().getMsg(), endpoint.getQueueToSim());
+  return kj::READY_NOW;
+}
+
+/// Pop as many messages as the limits of the client allow. The list of
+/// responses has to be sized up front, so the messages are first copied to
+/// orphans of the response message, which the list then adopts.
+kj::Promise<void> EndpointServer::recvMany(RecvManyContext context) {
+  KJ_REQUIRE(open, "EndPoint closed already");
+  KJ_REQUIRE(!endpoint.getShm(), "Endpoint uses shared memory");
+  auto params = context.getParams();
+  uint32_t maxMsgs = params.getMaxMsgs();
+  uint64_t maxBytes = params.getMaxBytes();
+
+  MessageQueue &queue = endpoint.getQueueToClient();
+  capnp::Orphanage orphanage = context.getResultsOrphanage();
+  kj::Vector<capnp::Orphan<capnp::AnyPointer>> msgs;
+  uint64_t numBytes = 0;
+  while (maxMsgs == 0 || msgs.size() < maxMsgs) {
+    const Endpoint::Blob *blob = queue.front();
+    if (!blob)
+      break;
+    numBytes += blob->size();
+    if (maxBytes != 0 && numBytes > maxBytes && !msgs.empty())
+      break;
+    KJ_DEFER(queue.pop());
+    readMessage(*blob, [&](AnyPointer::Reader msg) {
+      msgs.add(orphanage.newOrphanCopy(msg));
+    });
+  }
 
-  // Copy the incoming message into a flat, single segment buffer.
-  auto msgSize = capnpMsgPointer.targetSize();
-  auto builder = std::make_unique<MallocMessageBuilder>(
-      msgSize.wordCount + 1, AllocationStrategy::FIXED_SIZE);
-  builder->setRoot(capnpMsgPointer);
-  auto segments = builder->getSegmentsForOutput();
-  KJ_ASSERT(segments.size() == 1);
-
-  // Now copy it into a blob and queue it.
-  auto fstSegmentData = segments[0].asBytes();
-  auto blob = std::make_shared<Endpoint::Blob>(fstSegmentData.begin(),
-                                               fstSegmentData.end());
-  endpoint.pushMessageToSim(blob);
+  if (msgs.empty())
+    queue.getStats().recordEmptyPoll();
+  auto resps = context.getResults().initResps(msgs.size());
+  for (size_t i = 0, e = msgs.size(); i < e; ++i)
+    resps[i].getMsg().adopt(kj::mv(msgs[i]));
+  return kj::READY_NOW;
+}
+
+/// Queue all the messages of the client, in order.
+kj::Promise<void> EndpointServer::sendMany(SendManyContext context) {
+  KJ_REQUIRE(open, "EndPoint closed already");
+  MessageQueue &queue = endpoint.getQueueToSim();
+  for (auto msg : context.getParams().getMsgs())
+    writeMessage(msg.getMsg(), queue);
   return kj::READY_NOW;
 }
 
@@ -157,20 +221,69 @@ kj::Promise<void> CosimServer::list(ListContext context) {
 }
 
 kj::Promise<void> CosimServer::open(OpenContext ctxt) {
-  Endpoint *ep = reg[ctxt.getParams().getIface().getEndpointID()];
+  auto params = ctxt.getParams();
+  Endpoint *ep = reg[params.getIface().getEndpointID()];
   KJ_REQUIRE(ep != nullptr, "Could not find endpoint");
+  // The messages from the simulation cannot go back to the RPC interface, as
+  // the simulation thread has become the consumer of their queue.
+  KJ_REQUIRE(params.getUseShm() || !ep->getShm(),
+             "Endpoint uses shared memory");
 
   auto gotLock = ep->setInUse();
   KJ_REQUIRE(gotLock, "Endpoint in use");
 
+  if (params.getUseShm()) {
+    ShmRegion *shm = ep->attachShm();
+    if (!shm)
+      ep->returnForUse();
+    KJ_REQUIRE(shm != nullptr, "Could not set up shared memory");
+    ctxt.getResults().setShmName(shm->getName());
+  }
+
   ctxt.getResults().setIface(EsiDpiEndpoint<AnyPointer, AnyPointer>::Client(
       kj::heap<EndpointServer>(*ep)));
   return kj::READY_NOW;
 }
 
+/// Fill in the statistics of a queue.
+static void setQueueStats(EsiDpiQueueStats::Builder builder,
+                          const QueueStats &stats) {
+  QueueStats::Snapshot snapshot = stats.getSnapshot();
+  builder.setMessages(snapshot.messages);
+  builder.setBytes(snapshot.bytes);
+  builder.setMaxDepth(snapshot.maxDepth);
+  builder.setEmptyPolls(snapshot.emptyPolls);
+  auto histogram = builder.initLatencyHistogram(QueueStats::numLatencyBuckets);
+  for (unsigned i = 0; i < QueueStats::numLatencyBuckets; ++i)
+    histogram.set(i, snapshot.latency[i]);
+}
+
+kj::Promise<void> CosimServer::stats(StatsContext context) {
+  // The registry can grow between the two calls, so the list is sized for the
+  // endpoints visited.
+  std::vector<std::pair<std::string, const Endpoint *>> eps;
+  reg.iterateEndpoints([&](std::string id, const Endpoint &ep) {
+    eps.emplace_back(std::move(id), &ep);
+  });
+  auto list = context.getResults().initEndpoints(eps.size());
+  for (size_t i = 0, e = eps.size(); i < e; ++i) {
+    const Endpoint &ep = *eps[i].second;
+    list[i].setEndpointID(eps[i].first);
+    setQueueStats(list[i].initToSim(), ep.getQueueToSim().getStats());
+    setQueueStats(list[i].initToClient(), ep.getQueueToClient().getStats());
+    if (ep.getShm()) {
+      setQueueStats(list[i].initShmToSim(), ep.getShmStatsToSim());
+      setQueueStats(list[i].initShmToClient(), ep.getShmStatsToClient());
+    }
+  }
+  return kj::READY_NOW;
+}
+
 /// ----- RpcServer definitions.
 
-RpcServer::RpcServer() : mainThread(nullptr), stopSig(false) {}
+RpcServer::RpcServer()
+    : mainThread(nullptr), statsInterval(0), stopFulfiller(nullptr),
+      stopSig(false) {}
 RpcServer::~RpcServer() { stop(); }
 
 /// Write the port number to a file. Necessary when we allow 'EzRpcServer' to
@@ -183,6 +296,15 @@ static void writePort(uint16_t port) {
   fclose(fd);
 }
 
+/// Call `f` every `interval`, until the returned promise is dropped.
+static kj::Promise<void> repeatEvery(kj::Timer &timer, kj::Duration interval,
+                                     const std::function<void()> &f) {
+  return timer.afterDelay(interval).then([&timer, interval, &f]() {
+    f();
+    return repeatEvery(timer, interval, f);
+  });
+}
+
 void RpcServer::mainLoop(uint16_t port) {
   capnp::EzRpcServer rpcServer(kj::heap<CosimServer>(endpoints),
                                /* bindAddress */ "*", port);
@@ -195,20 +317,36 @@ void RpcServer::mainLoop(uint16_t port) {
   writePort(port);
   printf("[COSIM] Listening on port: %u\n", (unsigned int)port);
 
-  // OK, this is uber hacky, but it unblocks me and isn't _too_ inefficient. The
-  // problem is that I can't figure out how read the stop signal from libkj
-  // asyncrony land.
-  //
-  // IIRC the main libkj wait loop uses `select()` (or something similar on
-  // Windows) on its FDs. As a result, any code which checks the stop variable
-  // doesn't run until there is some I/O. Probably the right way is to set up a
-  // pipe to deliver a shutdown signal.
-  //
-  // TODO: Figure out how to do this properly, if possible.
-  while (!stopSig) {
-    waitScope.poll();
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  kj::Promise<void> statsLoop = kj::READY_NOW;
+  if (statsDump)
+    statsLoop = repeatEvery(rpcServer.getIoProvider().getTimer(),
+                            statsInterval.count() * kj::MILLISECONDS, statsDump)
+                    .eagerlyEvaluate(nullptr);
+
+  // Block in the event loop until stop() fulfills the stop promise. The
+  // fulfiller wakes up the loop from the simulator thread, so RPC requests are
+  // served as soon as they arrive rather than on the next polling interval.
+  auto stopPaf = kj::newPromiseAndCrossThreadFulfiller<void>();
+  {
+    Lock g(stopMutex);
+    if (stopSig)
+      return;
+    stopFulfiller = stopPaf.fulfiller.get();
   }
+  stopPaf.promise.wait(waitScope);
+  Lock g(stopMutex);
+  stopFulfiller = nullptr;
+}
+
+void RpcServer::setStatsDump(std::chrono::milliseconds interval,
+                             std::function<void()> dump) {
+  Lock g(m);
+  if (mainThread != nullptr) {
+    fprintf(stderr, "Warning: cannot set the stats dump of a running server!");
+    return;
+  }
+  statsInterval = interval;
+  statsDump = std::move(dump);
 }
 
 /// Start the server if not already started.
@@ -226,8 +364,16 @@ void RpcServer::stop() {
   Lock g(m);
   if (mainThread == nullptr) {
     fprintf(stderr, "RpcServer not Run()\n");
-  } else if (!stopSig) {
-    stopSig = true;
+  } else {
+    {
+      Lock stopLock(stopMutex);
+      if (stopSig)
+        return;
+      stopSig = true;
+      // If the loop has not started yet, it sees stopSig instead.
+      if (stopFulfiller)
+        stopFulfiller->fulfill();
+    }
     mainThread->join();
   }
 }
@@ -0,0 +1,143 @@
+//===- SharedMemory.cpp - Cosim shared memory transport ---------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Definitions for the cosim shared memory regions, on top of POSIX shared
+// memory objects.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/ESI/cosim/SharedMemory.h"
+
+#include <cstdio>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace circt::esi::cosim;
+
+/// Round up to a cache line.
+static uint64_t alignUp(uint64_t offset) { return (offset + 63) & ~63ull; }
+
+ShmRegion::ShmRegion(std::string name, void *base, uint64_t size, bool owner)
+    : name(std::move(name)), base(base), size(size), owner(owner) {
+  auto *bytes = static_cast<uint8_t *>(base);
+  auto *header = static_cast<ShmRegionHeader *>(base);
+  auto getRing = [&](uint64_t offset) {
+    return ShmRing(reinterpret_cast<ShmRingHeader *>(bytes + offset));
+  };
+  toSim = getRing(header->toSimOffset);
+  toClient = getRing(header->toClientOffset);
+}
+
+#ifdef _WIN32
+
+std::unique_ptr<ShmRegion> ShmRegion::create(const std::string &name,
+                                             uint64_t toSimSlotSize,
+                                             uint64_t toClientSlotSize,
+                                             uint64_t numSlots) {
+  fprintf(stderr, "Shared memory cosim is not supported on Windows.\n");
+  return nullptr;
+}
+
+std::unique_ptr<ShmRegion> ShmRegion::open(const std::string &name) {
+  fprintf(stderr, "Shared memory cosim is not supported on Windows.\n");
+  return nullptr;
+}
+
+ShmRegion::~ShmRegion() {}
+
+#else
+
+std::unique_ptr<ShmRegion> ShmRegion::create(const std::string &name,
+                                             uint64_t toSimSlotSize,
+                                             uint64_t toClientSlotSize,
+                                             uint64_t numSlots) {
+  uint64_t toSimOffset = alignUp(sizeof(ShmRegionHeader));
+  uint64_t toClientOffset =
+      alignUp(toSimOffset + ShmRing::getRingSize(toSimSlotSize, numSlots));
+  uint64_t size =
+      toClientOffset + ShmRing::getRingSize(toClientSlotSize, numSlots);
+
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    perror("[COSIM] shm_open");
+    return nullptr;
+  }
+  void *base = MAP_FAILED;
+  if (ftruncate(fd, size) == 0)
+    base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    perror("[COSIM] mapping shared memory");
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  // A new object is zero-filled, which leaves the rings empty.
+  auto *bytes = static_cast<uint8_t *>(base);
+  auto initRing = [&](uint64_t offset, uint64_t slotSize) {
+    auto *ring = reinterpret_cast<ShmRingHeader *>(bytes + offset);
+    ring->slotSize = slotSize;
+    ring->numSlots = numSlots;
+  };
+  initRing(toSimOffset, toSimSlotSize);
+  initRing(toClientOffset, toClientSlotSize);
+  auto *header = static_cast<ShmRegionHeader *>(base);
+  header->size = size;
+  header->toSimOffset = toSimOffset;
+  header->toClientOffset = toClientOffset;
+  header->version = ShmRegionHeader::currentVersion;
+  // Publish the layout last, for clients polling for the magic number.
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = ShmRegionHeader::magicNumber;
+
+  return std::unique_ptr<ShmRegion>(
+      new ShmRegion(name, base, size, /*owner=*/true));
+}
+
+std::unique_ptr<ShmRegion> ShmRegion::open(const std::string &name) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    perror("[COSIM] shm_open");
+    return nullptr;
+  }
+  struct stat st;
+  void *base = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(ShmRegionHeader))
+    base = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    fprintf(stderr, "[COSIM] Could not map shared memory '%s'.\n",
+            name.c_str());
+    return nullptr;
+  }
+
+  auto *header = static_cast<ShmRegionHeader *>(base);
+  if (header->magic != ShmRegionHeader::magicNumber ||
+      header->version != ShmRegionHeader::currentVersion ||
+      header->size != (uint64_t)st.st_size) {
+    fprintf(stderr, "[COSIM] '%s' is not a cosim shared memory region.\n",
+            name.c_str());
+    munmap(base, st.st_size);
+    return nullptr;
+  }
+  return std::unique_ptr<ShmRegion>(
+      new ShmRegion(name, base, st.st_size, /*owner=*/false));
+}
+
+ShmRegion::~ShmRegion() {
+  munmap(base, size);
+  if (owner)
+    shm_unlink(name.c_str());
+}
+
+#endif
@@ -17,6 +17,7 @@
 #include "circt/Dialect/FIRRTL/Namespace.h"
 #include "circt/Support/LLVM.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Tools/mlir-translate/Translation.h"
 #include "llvm/ADT/APSInt.h"
 #include "llvm/ADT/StringSet.h"
@@ -37,6 +38,10 @@ namespace {
 /// An emitter for FIRRTL dialect operations to .fir output.
 struct Emitter {
   Emitter(llvm::raw_ostream &os) : os(os) {}
+  /// Create an emitter for one module of a circuit, see `emitCircuit`.
+  Emitter(llvm::raw_ostream &os, unsigned indent,
+          const DenseMap<Operation *, StringRef> &invalidValueNames)
+      : os(os), currentIndent(indent), invalidValueNames(&invalidValueNames) {}
   LogicalResult finalize();
 
   // Indentation
@@ -203,32 +208,71 @@ private:
     valueNames.insert({value, it.first->getKey()});
   }
 
-  /// The current circuit namespace valid within the call to `emitCircuit`.
-  CircuitNamespace circuitNamespace;
+  /// The wire names given to the invalid values of the circuit, which are
+  /// picked up front by `emitCircuit` such that modules can be emitted in
+  /// parallel.
+  const DenseMap<Operation *, StringRef> *invalidValueNames = nullptr;
 };
 } // namespace
 
 LogicalResult Emitter::finalize() { return failure(encounteredError); }
 
+/// Check whether an invalid value is used somewhere else than the RHS of a
+/// connect, in which case it is emitted as an invalidated wire.
+static bool needsInvalidWire(InvalidValueOp op) {
+  return !llvm::all_of(op->getUses(), [&](OpOperand &use) {
+    return use.getOperandNumber() == 1 &&
+           isa<ConnectOp, StrictConnectOp>(use.getOwner());
+  });
+}
+
 /// Emit an entire circuit.
 void Emitter::emitCircuit(CircuitOp op) {
-  circuitNamespace.add(op);
   indent() << "circuit " << op.getName() << " :\n";
   addIndent();
+
+  // Gather the modules to emit. The names of the invalid value wires come from
+  // the circuit namespace, so pick them in circuit order before emitting the
+  // modules in parallel.
+  CircuitNamespace circuitNamespace(op);
+  DenseMap<Operation *, StringRef> invalidNames;
+  SmallVector<Operation *> modules;
+  Operation *unsupportedOp = nullptr;
   for (auto &bodyOp : *op.getBodyBlock()) {
-    if (encounteredError)
+    if (!isa<FModuleOp, FExtModuleOp>(bodyOp)) {
+      unsupportedOp = &bodyOp;
       break;
-    TypeSwitch<Operation *>(&bodyOp)
-        .Case<FModuleOp, FExtModuleOp>([&](auto op) {
-          emitModule(op);
-          os << "\n";
-        })
-        .Default([&](auto op) {
-          emitOpError(op, "not supported for emission inside circuit");
-        });
+    }
+    modules.push_back(&bodyOp);
+    bodyOp.walk([&](InvalidValueOp invalid) {
+      if (needsInvalidWire(invalid))
+        invalidNames.insert({invalid, circuitNamespace.newName("_invalid")});
+    });
   }
+
+  // Emit each module into its own buffer, then concatenate them in circuit
+  // order up to and including the first module that failed to emit.
+  SmallVector<SmallString<0>> buffers(modules.size());
+  SmallVector<bool> moduleFailed(modules.size());
+  mlir::parallelFor(op.getContext(), 0, modules.size(), [&](size_t i) {
+    llvm::raw_svector_ostream bufferStream(buffers[i]);
+    Emitter emitter(bufferStream, currentIndent, invalidNames);
+    TypeSwitch<Operation *>(modules[i])
+        .Case<FModuleOp, FExtModuleOp>(
+            [&](auto module) { emitter.emitModule(module); });
+    moduleFailed[i] = failed(emitter.finalize());
+  });
+  for (auto [buffer, hasFailed] : llvm::zip(buffers, moduleFailed)) {
+    os << buffer << "\n";
+    if (hasFailed) {
+      encounteredError = true;
+      break;
+    }
+  }
+
+  if (!encounteredError && unsupportedOp)
+    emitOpError(unsupportedOp, "not supported for emission inside circuit");
   reduceIndent();
-  circuitNamespace.clear();
 }
 
 /// Emit an entire module.
@@ -608,14 +652,11 @@ void Emitter::emitStatement(MemoryPortAccessOp op) {
 
 void Emitter::emitStatement(InvalidValueOp op) {
   // Only emit this invalid value if it is used somewhere else than the RHS of
-  // a connect.
-  if (llvm::all_of(op->getUses(), [&](OpOperand &use) {
-        return use.getOperandNumber() == 1 &&
-               isa<ConnectOp, StrictConnectOp>(use.getOwner());
-      }))
+  // a connect, in which case `emitCircuit` has picked a name for it.
+  auto name = invalidValueNames->lookup(op);
+  if (name.empty())
     return;
 
-  auto name = circuitNamespace.newName("_invalid");
   addValueName(op, name);
   indent() << "wire " << name << " : ";
   emitType(op.getType());
@@ -12,6 +12,8 @@
 
 #include "circt/Dialect/FIRRTL/FIRRTLAnnotationHelper.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
+#include "llvm/ADT/StringSet.h"
 
 using namespace circt;
 using namespace firrtl;
@@ -296,10 +298,11 @@ Optional<TokenAnnoTarget> firrtl::tokenizePath(StringRef origTarget) {
   return retval;
 }
 
-Optional<AnnoPathValue> firrtl::resolvePath(StringRef rawPath,
-                                            CircuitOp circuit,
-                                            SymbolTable &symTbl,
-                                            CircuitTargetCache &cache) {
+/// Resolve a string path without going through the path index.
+static Optional<AnnoPathValue> resolvePathImpl(StringRef rawPath,
+                                               CircuitOp circuit,
+                                               SymbolTable &symTbl,
+                                               CircuitTargetCache &cache) {
   auto pathStr = canonicalizeTarget(rawPath);
   StringRef path{pathStr};
 
@@ -313,6 +316,18 @@ Optional<AnnoPathValue> firrtl::resolvePath(StringRef rawPath,
   return resolveEntities(*tokens, circuit, symTbl, cache);
 }
 
+Optional<AnnoPathValue> firrtl::resolvePath(StringRef rawPath,
+                                            CircuitOp circuit,
+                                            SymbolTable &symTbl,
+                                            CircuitTargetCache &cache) {
+  if (auto *known = cache.lookupPath(rawPath))
+    return *known;
+  auto result = resolvePathImpl(rawPath, circuit, symTbl, cache);
+  if (result)
+    cache.insertPath(rawPath, *result);
+  return result;
+}
+
 InstanceOp firrtl::addPortsToModule(
     FModuleLike mod, InstanceOp instOnPath, FIRRTLType portType, Direction dir,
     StringRef newName, InstancePathCache &instancePathcache,
@@ -432,6 +447,50 @@ void AnnoTargetCache::gatherTargets(FModuleLike mod) {
   mod.walk([&](Operation *op) { insertOp(op); });
 }
 
+void CircuitTargetCache::populate(CircuitOp circuit) {
+  SmallVector<FModuleLike> modules;
+  for (auto module : circuit.getBodyBlock()->getOps<FModuleLike>())
+    if (!targetCaches.count(module))
+      modules.push_back(module);
+
+  SmallVector<Optional<AnnoTargetCache>> caches(modules.size());
+  mlir::parallelFor(circuit.getContext(), 0, modules.size(),
+                    [&](size_t index) {
+                      caches[index].emplace(modules[index]);
+                    });
+  for (size_t i = 0, e = modules.size(); i != e; ++i)
+    targetCaches.try_emplace(modules[i], std::move(*caches[i]));
+}
+
+void CircuitTargetCache::resolvePaths(CircuitOp circuit, SymbolTable &symTbl,
+                                      ArrayRef<StringRef> paths) {
+  SmallVector<StringRef> unresolved;
+  llvm::StringSet<> seen;
+  for (auto path : paths)
+    if (!resolvedPaths.count(path) && seen.insert(path).second)
+      unresolved.push_back(path);
+  if (unresolved.empty())
+    return;
+
+  // With all module caches built, resolution only reads from the cache.
+  populate(circuit);
+  SmallVector<Optional<AnnoPathValue>> results(unresolved.size());
+  {
+    // Paths which fail to resolve are left out of the index; resolvePath tries
+    // them again, and reports the error, when the annotation is applied.
+    mlir::ScopedDiagnosticHandler handler(
+        circuit.getContext(), [](mlir::Diagnostic &) { return success(); });
+    mlir::parallelFor(circuit.getContext(), 0, unresolved.size(),
+                      [&](size_t index) {
+                        results[index] = resolvePathImpl(
+                            unresolved[index], circuit, symTbl, *this);
+                      });
+  }
+  for (size_t i = 0, e = unresolved.size(); i != e; ++i)
+    if (results[i])
+      resolvedPaths.try_emplace(unresolved[i], std::move(*results[i]));
+}
+
 LogicalResult
 firrtl::findLCAandSetPath(AnnoPathValue &srcTarget, AnnoPathValue &dstTarget,
                           SmallVector<InstanceOp> &pathFromSrcToDst,
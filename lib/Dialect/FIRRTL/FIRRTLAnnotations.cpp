@@ -230,6 +230,16 @@ bool AnnotationSet::hasAnnotationImpl(StringRef className) const {
   return getAnnotationImpl(className) != Annotation();
 }
 
+bool AnnotationSet::hasAnnotation(Operation *op, StringRef className) {
+  auto annotations = op->getAttrOfType<ArrayAttr>(getAnnotationAttrName());
+  return annotations && AnnotationSet(annotations).hasAnnotation(className);
+}
+
+bool AnnotationSet::hasAnnotation(Operation *op, StringAttr className) {
+  auto annotations = op->getAttrOfType<ArrayAttr>(getAnnotationAttrName());
+  return annotations && AnnotationSet(annotations).hasAnnotation(className);
+}
+
 bool AnnotationSet::hasDontTouch() const {
   return hasAnnotation(dontTouchAnnoClass);
 }
@@ -255,7 +265,7 @@ bool AnnotationSet::removeDontTouch() {
 }
 
 bool AnnotationSet::hasDontTouch(Operation *op) {
-  return AnnotationSet(op).hasDontTouch();
+  return hasAnnotation(op, dontTouchAnnoClass);
 }
 
 bool AnnotationSet::setDontTouch(Operation *op, bool dontTouch) {
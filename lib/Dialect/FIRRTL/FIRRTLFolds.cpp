@@ -1176,40 +1176,67 @@ OpFoldResult MuxPrimOp::fold(ArrayRef<Attribute> operands) {
 
 namespace {
 
-// If the mux has a known output width, pad the operands up to this width.
-// Most folds on mux require that folded operands are of the same width as
-// the mux itself.
-class MuxPad : public mlir::RewritePattern {
+// All the canonicalizations of a mux with a known output width, in a single
+// pattern so that every changed mux is only matched once:
+//
+//  - Muxes nested in an operand on the same condition are bypassed, following
+//    the whole chain at once:
+//      mux(cond, x, mux(cond, y, z)) -> mux(cond, x, z)
+//      mux(cond, mux(cond, y, z), x) -> mux(cond, y, x)
+//  - The operands are padded up to the output width, since most folds on mux
+//    require that folded operands are of the same width as the mux itself.
+class MuxCanonicalize : public mlir::RewritePattern {
 public:
-  MuxPad(MLIRContext *context)
+  MuxCanonicalize(MLIRContext *context)
       : RewritePattern(MuxPrimOp::getOperationName(), 0, context) {}
 
   LogicalResult
   matchAndRewrite(Operation *op,
                   mlir::PatternRewriter &rewriter) const override {
     auto mux = cast<MuxPrimOp>(op);
-    auto width = mux.getType().getBitWidthOrSentinel();
+    auto type = mux.getType();
+    auto width = type.getBitWidthOrSentinel();
     if (width < 0)
       return failure();
 
+    // Cheap precondition: unless one of the operands is a mux or of another
+    // width than the result, there is nothing to do.
+    auto isCandidate = [&](Value input) {
+      return input.getDefiningOp<MuxPrimOp>() || input.getType() != type;
+    };
+    if (!isCandidate(mux.getHigh()) && !isCandidate(mux.getLow()))
+      return failure();
+
+    // Follow the chain of muxes on the same condition on one side, as long as
+    // all of them have the type of this mux.
+    auto bypass = [&](Value input, bool high) {
+      while (auto inner = input.getDefiningOp<MuxPrimOp>()) {
+        if (inner.getSel() != mux.getSel() || inner.getType() != type ||
+            inner.getHigh().getType() != type ||
+            inner.getLow().getType() != type)
+          break;
+        input = high ? inner.getHigh() : inner.getLow();
+      }
+      return input;
+    };
+
     auto pad = [&](Value input) -> Value {
       auto inputWidth = input.getType()
                             .template cast<FIRRTLBaseType>()
                             .getBitWidthOrSentinel();
       if (inputWidth < 0 || width == inputWidth)
         return input;
-      return rewriter
-          .create<PadPrimOp>(mux.getLoc(), mux.getType(), input, width)
+      return rewriter.create<PadPrimOp>(mux.getLoc(), type, input, width)
           .getResult();
     };
 
-    auto newHigh = pad(mux.getHigh());
-    auto newLow = pad(mux.getLow());
+    auto newHigh = pad(bypass(mux.getHigh(), /*high=*/true));
+    auto newLow = pad(bypass(mux.getLow(), /*high=*/false));
     if (newHigh == mux.getHigh() && newLow == mux.getLow())
       return failure();
 
     replaceOpWithNewOpAndCopyName<MuxPrimOp>(
-        rewriter, op, mux.getType(), ValueRange{mux.getSel(), newHigh, newLow},
+        rewriter, op, type, ValueRange{mux.getSel(), newHigh, newLow},
         mux->getAttrs());
     return success();
   }
@@ -1218,8 +1245,7 @@ public:
 
 void MuxPrimOp::getCanonicalizationPatterns(RewritePatternSet &results,
                                             MLIRContext *context) {
-  results.add<MuxPad, patterns::MuxSameCondLow, patterns::MuxSameCondHigh>(
-      context);
+  results.add<MuxCanonicalize>(context);
 }
 
 OpFoldResult PadPrimOp::fold(ArrayRef<Attribute> operands) {
@@ -214,7 +214,7 @@ size_t firrtl::getNumPorts(Operation *op) {
 /// should prevent certain types of canonicalizations.
 bool firrtl::hasDontTouch(Operation *op) {
   return op->getAttr(hw::InnerName::getInnerNameAttrName()) ||
-         AnnotationSet(op).hasDontTouch();
+         AnnotationSet::hasDontTouch(op);
 }
 
 /// Check whether a block argument ("port") or the operation defining a value
@@ -936,7 +936,7 @@ unsigned BundleType::getFieldID(unsigned index) {
 
 unsigned BundleType::getIndexForFieldID(unsigned fieldID) {
   assert(getElements().size() && "Bundle must have >0 fields");
-  auto fieldIDs = getImpl()->fieldIDs;
+  ArrayRef<unsigned> fieldIDs = getImpl()->fieldIDs;
   auto *it = std::prev(llvm::upper_bound(fieldIDs, fieldID));
   return std::distance(fieldIDs.begin(), it);
 }
@@ -945,7 +945,6 @@ std::pair<FIRRTLBaseType, unsigned>
 BundleType::getSubTypeByFieldID(unsigned fieldID) {
   if (fieldID == 0)
     return {*this, 0};
-  auto fieldIDs = getImpl()->fieldIDs;
   auto subfieldIndex = getIndexForFieldID(fieldID);
   auto subfieldType = getElementType(subfieldIndex);
   auto subfieldID = fieldID - getFieldID(subfieldIndex);
@@ -976,6 +975,7 @@ struct VectorTypeStorage : mlir::TypeStorage {
   VectorTypeStorage(KeyTy value) : value(value) {
     auto properties = value.first.getRecursiveTypeProperties();
     passiveContainsAnalogTypeInfo.setInt(properties.toFlags());
+    maxFieldID = value.second * (value.first.getMaxFieldID() + 1);
   }
 
   bool operator==(const KeyTy &key) const { return key == value; }
@@ -986,6 +986,7 @@ struct VectorTypeStorage : mlir::TypeStorage {
   }
 
   KeyTy value;
+  size_t maxFieldID;
 
   /// This holds the bits for the type's recursive properties, and can hold a
   /// pointer to a passive version of the type.
@@ -1051,9 +1052,7 @@ FVectorType::getSubTypeByFieldID(size_t fieldID) {
   return {getElementType(), fieldID - getFieldID(subfieldIndex)};
 }
 
-size_t FVectorType::getMaxFieldID() {
-  return getNumElements() * (getElementType().getMaxFieldID() + 1);
-}
+size_t FVectorType::getMaxFieldID() { return getImpl()->maxFieldID; }
 
 std::pair<size_t, bool> FVectorType::rootChildFieldID(size_t fieldID,
                                                       size_t index) {
@@ -12,6 +12,7 @@
 
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/TypeSwitch.h"
 
 using namespace circt;
@@ -723,3 +724,25 @@ circt::firrtl::maybeStringToLocation(StringRef spelling, bool skipParsing,
   }
   return {true, result};
 }
+
+Location circt::firrtl::fuseLocs(MLIRContext *context, ArrayRef<Location> locs,
+                                 unsigned maxLocs) {
+  llvm::SmallSetVector<Location, 8> uniqueLocs;
+  auto addLoc = [&](Location loc) {
+    if (uniqueLocs.size() < maxLocs && !loc.isa<UnknownLoc>())
+      uniqueLocs.insert(loc);
+  };
+  for (auto loc : locs) {
+    auto fusedLoc = loc.dyn_cast<FusedLoc>();
+    if (fusedLoc && !fusedLoc.getMetadata())
+      llvm::for_each(fusedLoc.getLocations(), addLoc);
+    else
+      addLoc(loc);
+  }
+
+  if (uniqueLocs.empty())
+    return UnknownLoc::get(context);
+  if (uniqueLocs.size() == 1)
+    return uniqueLocs.front();
+  return FusedLoc::get(context, uniqueLocs.getArrayRef());
+}
@@ -17,6 +17,8 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <cstring>
+
 using namespace circt;
 using namespace firrtl;
 using llvm::SMLoc;
@@ -208,6 +210,39 @@ Optional<unsigned> FIRLexer::getIndentation(const FIRToken &tok) const {
 // Lexer Implementation Methods
 //===----------------------------------------------------------------------===//
 
+namespace {
+/// Classification of the characters that the lexer skips over in runs, so that
+/// each byte of the run is checked with a single table lookup rather than a
+/// chain of comparisons.
+struct CharClasses {
+  constexpr CharClasses() {
+    for (char c = 'a'; c <= 'z'; ++c)
+      identifier[static_cast<unsigned char>(c)] = true;
+    for (char c = 'A'; c <= 'Z'; ++c)
+      identifier[static_cast<unsigned char>(c)] = true;
+    for (char c = '0'; c <= '9'; ++c)
+      identifier[static_cast<unsigned char>(c)] = true;
+    for (char c : {'_', '$', '-'})
+      identifier[static_cast<unsigned char>(c)] = true;
+    for (char c : {' ', '\t', '\n', '\r', ','})
+      whitespace[static_cast<unsigned char>(c)] = true;
+  }
+
+  bool isIdentifier(char c) const {
+    return identifier[static_cast<unsigned char>(c)];
+  }
+  bool isWhitespace(char c) const {
+    return whitespace[static_cast<unsigned char>(c)];
+  }
+
+private:
+  bool identifier[256] = {};
+  bool whitespace[256] = {};
+};
+} // namespace
+
+static constexpr CharClasses charClasses;
+
 FIRToken FIRLexer::lexTokenImpl() {
   while (true) {
     const char *tokStart = curPtr;
@@ -233,7 +268,10 @@ FIRToken FIRLexer::lexTokenImpl() {
     case '\n':
     case '\r':
     case ',':
-      // Handle whitespace.
+      // Handle whitespace.  Indentation makes long runs of it common, so skip
+      // the whole run here.
+      while (charClasses.isWhitespace(*curPtr))
+        ++curPtr;
       continue;
 
     case '_':
@@ -383,8 +421,7 @@ FIRToken FIRLexer::lexInlineAnnotation(const char *tokStart) {
 ///
 FIRToken FIRLexer::lexIdentifierOrKeyword(const char *tokStart) {
   // Match the rest of the identifier regex: [0-9a-zA-Z_$-]*
-  while (llvm::isAlpha(*curPtr) || llvm::isDigit(*curPtr) || *curPtr == '_' ||
-         *curPtr == '$' || *curPtr == '-')
+  while (charClasses.isIdentifier(*curPtr))
     ++curPtr;
 
   StringRef spelling(tokStart, curPtr - tokStart);
@@ -413,24 +450,21 @@ FIRToken FIRLexer::lexIdentifierOrKeyword(const char *tokStart) {
 
 /// Skip a comment line, starting with a ';' and going to end of line.
 void FIRLexer::skipComment() {
-  while (true) {
-    switch (*curPtr++) {
-    case '\n':
-    case '\r':
-      // Newline is end of comment.
-      return;
-    case 0:
-      // If this is the end of the buffer, end the comment.
-      if (curPtr - 1 == curBuffer.end()) {
-        --curPtr;
-        return;
-      }
-      [[fallthrough]];
-    default:
-      // Skip over other characters.
-      break;
-    }
-  }
+  // Look for the end of the line with memchr, which the C library vectorizes.
+  // A nul character inside the comment is skipped like any other character.
+  const char *bufEnd = curBuffer.end();
+  const auto *eol = static_cast<const char *>(
+      std::memchr(curPtr, '\n', static_cast<size_t>(bufEnd - curPtr)));
+  if (!eol)
+    eol = bufEnd;
+  // A carriage return ends the comment as well.
+  if (const auto *cr = static_cast<const char *>(
+          std::memchr(curPtr, '\r', static_cast<size_t>(eol - curPtr))))
+    eol = cr;
+
+  // Newline is end of comment. If this is the end of the buffer, stay on the
+  // eof marker.
+  curPtr = eol == bufEnd ? bufEnd : eol + 1;
 }
 
 /// StringLit      ::= '"' UnquotedString? '"'
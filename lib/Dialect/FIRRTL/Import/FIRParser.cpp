@@ -248,6 +248,11 @@ private:
   StringAttr locatorFilenameCache;
   /// This is a single-entry cache for FileLineCol locations.
   FileLineColLoc fileLineColLocCache;
+
+protected:
+  /// The locations of the info locators seen so far, keyed by their spelling.
+  /// This is owned by the module being parsed, if any.
+  llvm::DenseMap<StringRef, LocationAttr> *locatorCache = nullptr;
 };
 
 } // end anonymous namespace
@@ -353,6 +358,16 @@ ParseResult FIRParser::parseOptionalInfoLocator(LocationAttr &result) {
   auto spelling = getTokenSpelling();
   consumeToken(FIRToken::fileinfo);
 
+  // Chisel emits the same locator for many statements, so look for one decoded
+  // before in this module first.
+  if (locatorCache && !constants.options.ignoreInfoLocators) {
+    auto it = locatorCache->find(spelling);
+    if (it != locatorCache->end()) {
+      result = it->second;
+      return success();
+    }
+  }
+
   auto locationPair = maybeStringToLocation(
       spelling, constants.options.ignoreInfoLocators, locatorFilenameCache,
       fileLineColLocCache, getContext());
@@ -371,6 +386,8 @@ ParseResult FIRParser::parseOptionalInfoLocator(LocationAttr &result) {
 
   // Otherwise, set the location attribute and return.
   result = locationPair.second.value();
+  if (locatorCache)
+    locatorCache->try_emplace(spelling, result);
   return success();
 }
 
@@ -784,11 +801,17 @@ namespace {
 struct FIRModuleContext : public FIRParser {
   explicit FIRModuleContext(SharedParserConstants &constants, FIRLexer &lexer,
                             std::string moduleTarget)
-      : FIRParser(constants, lexer), moduleTarget(std::move(moduleTarget)) {}
+      : FIRParser(constants, lexer), moduleTarget(std::move(moduleTarget)) {
+    locatorCache = &moduleLocatorCache;
+  }
 
   /// This is the module target used by annotations referring to this module.
   std::string moduleTarget;
 
+  /// The locations of the info locators of this module, shared by all parsers
+  /// of its body.
+  llvm::DenseMap<StringRef, LocationAttr> moduleLocatorCache;
+
   // The expression-oriented nature of firrtl syntax produces tons of constant
   // nodes which are obviously redundant.  Instead of literally producing them
   // in the parser, do an implicit CSE to reduce parse time and silliness in the
@@ -1099,10 +1122,13 @@ struct FIRStmtParser : public FIRParser {
         builder(mlir::ImplicitLocOpBuilder::atBlockEnd(
             UnknownLoc::get(getContext()), &blockToInsertInto)),
         locationProcessor(this->builder), moduleContext(moduleContext),
-        modNameSpace(modNameSpace) {}
+        modNameSpace(modNameSpace) {
+    locatorCache = &moduleContext.moduleLocatorCache;
+  }
 
   ParseResult parseSimpleStmt(unsigned stmtIndent);
   ParseResult parseSimpleStmtBlock(unsigned indent);
+  ParseResult parseInstancesOnly(unsigned indent);
 
 private:
   /// Return the current modulet target, e.g., "~Foo|Bar".
@@ -1164,6 +1190,7 @@ private:
 
   // Declarations
   ParseResult parseInstance();
+  ParseResult parseInstanceDecl(FIRToken startTok);
   ParseResult parseCombMem();
   ParseResult parseSeqMem();
   ParseResult parseMem(unsigned memIndent);
@@ -1869,6 +1896,46 @@ ParseResult FIRStmtParser::parseSimpleStmtBlock(unsigned indent) {
   }
 }
 
+/// Skip over a block of statements, only materializing the instances in it
+/// (including the ones nested in when/else blocks).  This is used to build the
+/// circuit hierarchy without parsing the rest of the module bodies.
+ParseResult FIRStmtParser::parseInstancesOnly(unsigned indent) {
+  // An 'inst' keyword only begins an instance when it starts a statement:
+  // either at the start of a line or after the ':' or 'else' of a single-line
+  // when statement.
+  bool atStmtStart = true;
+  while (true) {
+    if (getToken().isAny(FIRToken::eof, FIRToken::error))
+      return success();
+
+    if (auto tokIndent = getIndentation()) {
+      if (*tokIndent <= indent)
+        return success();
+      atStmtStart = true;
+    }
+
+    if (!atStmtStart || getToken().isNot(FIRToken::kw_inst)) {
+      atStmtStart = getToken().isAny(FIRToken::colon, FIRToken::kw_else);
+      consumeToken();
+      continue;
+    }
+    atStmtStart = false;
+
+    // `inst` may also be the name of something used on the left hand side of
+    // a connect; skip those statements like any other.
+    auto startTok = consumeToken(FIRToken::kw_inst);
+    if (getToken().isAny(FIRToken::period, FIRToken::l_square, FIRToken::kw_is,
+                         FIRToken::less_equal, FIRToken::less_minus))
+      continue;
+
+    locationProcessor.startStatement();
+    auto result = parseInstanceDecl(startTok);
+    locationProcessor.endStatement(*this);
+    if (failed(result))
+      return failure();
+  }
+}
+
 ParseResult FIRStmtParser::parseSimpleStmt(unsigned stmtIndent) {
   locationProcessor.startStatement();
   auto result = parseSimpleStmtImpl(stmtIndent);
@@ -2328,6 +2395,11 @@ ParseResult FIRStmtParser::parseInstance() {
   if (auto isExpr = parseExpWithLeadingKeyword(startTok))
     return *isExpr;
 
+  return parseInstanceDecl(startTok);
+}
+
+/// Parse the rest of an instance declaration after the leading 'inst'.
+ParseResult FIRStmtParser::parseInstanceDecl(FIRToken startTok) {
   StringRef id;
   StringRef moduleName;
   if (parseId(id, "expected instance name") ||
@@ -3126,7 +3198,10 @@ FIRCircuitParser::parseModuleBody(DeferredModuleToParse &deferredModule) {
   FIRStmtParser stmtParser(*moduleOp.getBodyBlock(), moduleContext,
                            modNameSpace);
 
-  // Parse the moduleBlock.
+  // Parse the moduleBlock.  If only the hierarchy was requested, just pick the
+  // instances out of it.
+  if (getConstants().options.hierarchyOnly)
+    return stmtParser.parseInstancesOnly(deferredModule.indent);
   auto result = stmtParser.parseSimpleStmtBlock(deferredModule.indent);
   if (failed(result))
     return result;
@@ -3213,28 +3288,7 @@ ParseResult FIRCircuitParser::parseCircuit(
                              inlineAnnotations, annos))
       return failure();
 
-  // Deal with the annotation file if one was specified
-  for (auto *annotationsBuf : annotationsBufs)
-    if (importAnnotationsRaw(inlineAnnotationsLoc, circuitTarget,
-                             annotationsBuf->getBuffer(), annos))
-      return failure();
-
   parseAnnotationTimer.stop();
-  auto parseOMIRTimer = ts.nest("Parse OMIR");
-
-  // Process OMIR files as annotations with a class of
-  // "freechips.rocketchip.objectmodel.OMNode"
-  for (auto *omirBuf : omirBufs)
-    if (importOMIR(circuit, info.getFIRLoc(), circuitTarget,
-                   omirBuf->getBuffer(), annos))
-      return failure();
-
-  parseOMIRTimer.stop();
-
-  // Get annotations that are supposed to be specially handled by the
-  // LowerAnnotations pass.
-  if (!annos.empty())
-    circuit->setAttr(rawAnnotations, b.getArrayAttr(annos));
 
   // A timer to get execution time of module parsing.
   auto parseTimer = ts.nest("Parse modules");
@@ -3283,16 +3337,40 @@ DoneParsing:
   // proactively touch it to make sure that it is always already created.
   (void)getLexer().translateLocation(info.getFIRLoc());
 
-  // Next, parse all the module bodies.
+  // Next, parse all the module bodies.  The annotation and OMIR files do not
+  // depend on the modules, so they are parsed alongside them.  They are
+  // scheduled first since a single file is usually larger than any module, and
+  // each of them gets its own list so that their order is kept.
+  size_t numAnnotationFiles = annotationsBufs.size();
+  size_t numJSONFiles = numAnnotationFiles + omirBufs.size();
+  SmallVector<SmallVector<Attribute>> fileAnnos(numJSONFiles);
   auto anyFailed = mlir::failableParallelForEachN(
-      getContext(), 0, deferredModules.size(), [&](size_t index) {
-        if (parseModuleBody(deferredModules[index]))
+      getContext(), 0, numJSONFiles + deferredModules.size(),
+      [&](size_t index) -> LogicalResult {
+        if (index < numAnnotationFiles)
+          return importAnnotationsRaw(inlineAnnotationsLoc, circuitTarget,
+                                      annotationsBufs[index]->getBuffer(),
+                                      fileAnnos[index]);
+        // Process OMIR files as annotations with a class of
+        // "freechips.rocketchip.objectmodel.OMNode"
+        if (index < numJSONFiles)
+          return importOMIR(circuit, info.getFIRLoc(), circuitTarget,
+                            omirBufs[index - numAnnotationFiles]->getBuffer(),
+                            fileAnnos[index]);
+        if (parseModuleBody(deferredModules[index - numJSONFiles]))
           return failure();
         return success();
       });
   if (failed(anyFailed))
     return failure();
 
+  // Get annotations that are supposed to be specially handled by the
+  // LowerAnnotations pass.
+  for (auto &attrs : fileAnnos)
+    annos.append(attrs.begin(), attrs.end());
+  if (!annos.empty())
+    circuit->setAttr(rawAnnotations, b.getArrayAttr(annos));
+
   auto main = circuit.getMainModule();
   if (!main) {
     // Give more specific error if no modules defined at all
@@ -189,14 +189,14 @@ InnerSymbolTableCollection::populateAndVerifyTables(Operation *innerRefNSOp) {
       innerRefNSOp->getContext(), innerSymTableOps, [&](auto *op) {
         auto it = symbolTables.find(op);
         assert(it != symbolTables.end());
-        if (!it->second) {
-          auto result = InnerSymbolTable::get(op);
-          if (failed(result))
-            return failure();
-          it->second = std::make_unique<InnerSymbolTable>(std::move(*result));
+        // Tables that were already created on demand are kept.
+        if (it->second)
           return success();
-        }
-        return failure();
+        auto result = InnerSymbolTable::get(op);
+        if (failed(result))
+          return failure();
+        it->second = std::make_unique<InnerSymbolTable>(std::move(*result));
+        return success();
       });
 }
 
@@ -9,6 +9,7 @@
 #include "circt/Dialect/FIRRTL/NLATable.h"
 #include "circt/Dialect/FIRRTL/FIRRTLOps.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "llvm/ADT/SetVector.h"
 
 using namespace circt;
 using namespace firrtl;
@@ -37,6 +38,13 @@ ArrayRef<HierPathOp> NLATable::lookup(StringAttr name) {
   return iter->second;
 }
 
+ArrayRef<HierPathOp> NLATable::lookup(hw::InnerRefAttr ref) {
+  auto iter = innerRefMap.find(ref);
+  if (iter == innerRefMap.end())
+    return {};
+  return iter->second;
+}
+
 ArrayRef<HierPathOp> NLATable::lookup(Operation *op) {
   auto name = op->getAttrOfType<StringAttr>("sym_name");
   if (!name)
@@ -59,8 +67,10 @@ void NLATable::addNLA(HierPathOp nla) {
   for (auto ent : nla.getNamepath()) {
     if (auto mod = ent.dyn_cast<FlatSymbolRefAttr>())
       nodeMap[mod.getAttr()].push_back(nla);
-    else if (auto inr = ent.dyn_cast<hw::InnerRefAttr>())
+    else if (auto inr = ent.dyn_cast<hw::InnerRefAttr>()) {
       nodeMap[inr.getModule()].push_back(nla);
+      innerRefMap[inr].push_back(nla);
+    }
   }
 }
 
@@ -69,14 +79,104 @@ void NLATable::erase(HierPathOp nla, SymbolTable *symbolTable) {
   for (auto ent : nla.getNamepath())
     if (auto mod = ent.dyn_cast<FlatSymbolRefAttr>())
       llvm::erase_value(nodeMap[mod.getAttr()], nla);
-    else if (auto inr = ent.dyn_cast<hw::InnerRefAttr>())
+    else if (auto inr = ent.dyn_cast<hw::InnerRefAttr>()) {
       llvm::erase_value(nodeMap[inr.getModule()], nla);
+      llvm::erase_value(innerRefMap[inr], nla);
+    }
   if (symbolTable)
     symbolTable->erase(nla);
 }
 
+void NLATable::eraseNLAs(ArrayRef<HierPathOp> nlaOps,
+                         SymbolTable *symbolTable) {
+  DenseSet<HierPathOp> erased(nlaOps.begin(), nlaOps.end());
+  DenseSet<StringAttr> modules;
+  DenseSet<hw::InnerRefAttr> innerRefs;
+  for (auto nla : nlaOps) {
+    symToOp.erase(nla.getSymNameAttr());
+    for (auto ent : nla.getNamepath())
+      if (auto mod = ent.dyn_cast<FlatSymbolRefAttr>())
+        modules.insert(mod.getAttr());
+      else if (auto inr = ent.dyn_cast<hw::InnerRefAttr>()) {
+        modules.insert(inr.getModule());
+        innerRefs.insert(inr);
+      }
+  }
+  auto isErased = [&](HierPathOp nla) { return erased.count(nla); };
+  for (auto mod : modules)
+    llvm::erase_if(nodeMap[mod], isErased);
+  for (auto inr : innerRefs)
+    llvm::erase_if(innerRefMap[inr], isErased);
+  if (symbolTable)
+    for (auto nla : nlaOps)
+      symbolTable->erase(nla);
+}
+
+void NLATable::setNamepath(HierPathOp nla, ArrayAttr namepath) {
+  // Collect the modules and inner references of a namepath.
+  auto collect = [](ArrayAttr path, SmallSetVector<StringAttr, 4> &modules,
+                    SmallSetVector<hw::InnerRefAttr, 4> &innerRefs) {
+    for (auto ent : path)
+      if (auto mod = ent.dyn_cast<FlatSymbolRefAttr>())
+        modules.insert(mod.getAttr());
+      else if (auto inr = ent.dyn_cast<hw::InnerRefAttr>()) {
+        modules.insert(inr.getModule());
+        innerRefs.insert(inr);
+      }
+  };
+  SmallSetVector<StringAttr, 4> oldModules, newModules;
+  SmallSetVector<hw::InnerRefAttr, 4> oldInnerRefs, newInnerRefs;
+  collect(nla.getNamepathAttr(), oldModules, oldInnerRefs);
+  collect(namepath, newModules, newInnerRefs);
+
+  for (auto mod : oldModules)
+    if (!newModules.count(mod))
+      llvm::erase_value(nodeMap[mod], nla);
+  for (auto mod : newModules)
+    if (!oldModules.count(mod))
+      nodeMap[mod].push_back(nla);
+  for (auto inr : oldInnerRefs)
+    if (!newInnerRefs.count(inr))
+      llvm::erase_value(innerRefMap[inr], nla);
+  for (auto inr : newInnerRefs)
+    if (!oldInnerRefs.count(inr))
+      innerRefMap[inr].push_back(nla);
+  nla.setNamepathAttr(namepath);
+}
+
+void NLATable::moveInnerRefs(
+    ArrayRef<HierPathOp> nlas, StringAttr oldModName,
+    function_ref<hw::InnerRefAttr(hw::InnerRefAttr)> getNewRef) {
+  // Every NLA containing an inner reference of the module is in the list of the
+  // module, so the records of these inner references can be moved as a whole.
+  SmallSetVector<hw::InnerRefAttr, 4> oldRefs;
+  for (auto nla : nlas)
+    for (auto ent : nla.getNamepath())
+      if (auto inr = ent.dyn_cast<hw::InnerRefAttr>())
+        if (inr.getModule() == oldModName)
+          oldRefs.insert(inr);
+  for (auto oldRef : oldRefs) {
+    auto iter = innerRefMap.find(oldRef);
+    if (iter == innerRefMap.end())
+      continue;
+    auto moved = std::move(iter->second);
+    innerRefMap.erase(iter);
+    auto &newList = innerRefMap[getNewRef(oldRef)];
+    newList.append(moved.begin(), moved.end());
+  }
+}
+
 void NLATable::updateModuleInNLA(HierPathOp nlaOp, StringAttr oldModule,
                                  StringAttr newModule) {
+  // Only this NLA moves, the other NLAs through the same inner references keep
+  // referring to the old module.
+  for (auto ent : nlaOp.getNamepath())
+    if (auto inr = ent.dyn_cast<hw::InnerRefAttr>())
+      if (inr.getModule() == oldModule) {
+        llvm::erase_value(innerRefMap[inr], nlaOp);
+        innerRefMap[hw::InnerRefAttr::get(newModule, inr.getName())].push_back(
+            nlaOp);
+      }
   nlaOp.updateModule(oldModule, newModule);
   auto &nlas = nodeMap[oldModule];
   auto *iter = std::find(nlas.begin(), nlas.end(), nlaOp);
@@ -88,6 +188,40 @@ void NLATable::updateModuleInNLA(HierPathOp nlaOp, StringAttr oldModule,
   }
 }
 
+void NLATable::updateModuleInNLAs(ArrayRef<HierPathOp> nlaOps,
+                                  StringAttr oldModule, StringAttr newModule) {
+  DenseSet<HierPathOp> updated;
+  for (auto nlaOp : nlaOps) {
+    if (!updated.insert(nlaOp).second)
+      continue;
+    for (auto ent : nlaOp.getNamepath())
+      if (auto inr = ent.dyn_cast<hw::InnerRefAttr>())
+        if (inr.getModule() == oldModule) {
+          llvm::erase_value(innerRefMap[inr], nlaOp);
+          innerRefMap[hw::InnerRefAttr::get(newModule, inr.getName())]
+              .push_back(nlaOp);
+        }
+    nlaOp.updateModule(oldModule, newModule);
+  }
+
+  // Move the updated NLAs which were recorded for the old module, in the order
+  // of its list.
+  auto iter = nodeMap.find(oldModule);
+  if (iter == nodeMap.end())
+    return;
+  SmallVector<HierPathOp> moved;
+  llvm::erase_if(iter->second, [&](HierPathOp nlaOp) {
+    if (!updated.count(nlaOp))
+      return false;
+    moved.push_back(nlaOp);
+    return true;
+  });
+  if (iter->second.empty())
+    nodeMap.erase(iter);
+  if (!moved.empty())
+    nodeMap[newModule].append(moved.begin(), moved.end());
+}
+
 void NLATable::updateModuleInNLA(StringAttr name, StringAttr oldModule,
                                  StringAttr newModule) {
   auto nlaOp = getNLA(name);
@@ -103,6 +237,9 @@ void NLATable::renameModule(StringAttr oldModName, StringAttr newModName) {
   auto iter = nodeMap.find(oldModName);
   if (iter == nodeMap.end())
     return;
+  moveInnerRefs(iter->second, oldModName, [&](hw::InnerRefAttr ref) {
+    return hw::InnerRefAttr::get(newModName, ref.getName());
+  });
   for (auto nla : iter->second)
     nla.updateModule(oldModName, newModName);
   nodeMap[newModName] = iter->second;
@@ -117,10 +254,23 @@ void NLATable::renameModuleAndInnerRef(
 
   if (newModName == oldModName)
     return;
-  for (auto nla : lookup(oldModName)) {
+  auto iter = nodeMap.find(oldModName);
+  if (iter == nodeMap.end())
+    return;
+  // Take the list out of the map, growing the list of the new module may
+  // reallocate the buckets of the map.
+  auto nlas = std::move(iter->second);
+  nodeMap.erase(iter);
+  moveInnerRefs(nlas, oldModName, [&](hw::InnerRefAttr ref) {
+    auto symName = ref.getName();
+    auto to = innerSymRenameMap.find(symName);
+    if (to != innerSymRenameMap.end())
+      symName = to->second;
+    return hw::InnerRefAttr::get(newModName, symName);
+  });
+  auto &newNLAs = nodeMap[newModName];
+  for (auto nla : nlas) {
     nla.updateModuleAndInnerRef(oldModName, newModName, innerSymRenameMap);
-    nodeMap[newModName].push_back(nla);
+    newNLAs.push_back(nla);
   }
-  nodeMap.erase(oldModName);
-  return;
 }
@@ -15,10 +15,12 @@
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
 #include "circt/Dialect/FIRRTL/FIRRTLVisitors.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/SCCIterator.h"
 #include "llvm/ADT/SmallSet.h"
+#include <atomic>
 #include <variant>
 
 #define DEBUG_TYPE "check-comb-cycles"
@@ -712,93 +714,122 @@ void dumpSimpleCycle(SCCIterator &scc, FModuleOp module,
 class CheckCombCyclesPass : public CheckCombCyclesBase<CheckCombCyclesPass> {
   void runOnOperation() override {
     auto &instanceGraph = getAnalysis<InstanceGraph>();
-    bool detectedCycle = false;
 
-    // Traverse modules in a post order to make sure the combinational paths
-    // between IOs of a module have been detected and recorded in `combPathsMap`
-    // before we handle its parent modules.
-    for (auto node : llvm::post_order<InstanceGraph *>(&instanceGraph)) {
-      if (auto module = dyn_cast<FModuleOp>(*node->getModule())) {
-        NodeContext context(&map, &instanceGraph,
-                            module.getOps<FConnectLike>());
-        auto dummyNode = Node(nullptr, &context);
-
-        // Traversing SCCs in the combinational graph to detect cycles. As
-        // FIRRTL module is an SSA region, all cycles must contain at least one
-        // connect op. Thus we introduce a dummy source node to iterate on the
-        // `dest`s of all connect ops in the module.
-        for (auto combSCC = SCCIterator::begin(dummyNode); !combSCC.isAtEnd();
-             ++combSCC) {
-          if (combSCC.hasCycle()) {
-            detectedCycle = true;
-            auto errorDiag = mlir::emitError(
-                module.getLoc(),
-                "detected combinational cycle in a FIRRTL module");
-            if (printSimpleCycle)
-              dumpSimpleCycle(combSCC, module, errorDiag);
-            else {
-              for (auto node : *combSCC) {
-                auto &noteDiag = errorDiag.attachNote(node.value.getLoc());
-                noteDiag << "this operation is part of the combinational cycle";
-              }
+    // The combinational paths between IOs of a module must have been detected
+    // and recorded in `combPathsMap` before we handle its parent modules.
+    // Group the modules by their level in the instance hierarchy, bottom up,
+    // such that the modules of one level only depend on the summaries of the
+    // levels below and can be checked concurrently.
+    DenseMap<Operation *, unsigned> levels;
+    SmallVector<SmallVector<Operation *, 0>> levelModules;
+    for (auto *node : llvm::post_order<InstanceGraph *>(&instanceGraph)) {
+      Operation *module = node->getModule();
+      unsigned level = 0;
+      for (auto *instance : *node)
+        level = std::max(
+            level, levels.lookup(instance->getTarget()->getModule()) + 1);
+      levels[module] = level;
+      if (levelModules.size() <= level)
+        levelModules.resize(level + 1);
+      levelModules[level].push_back(module);
+      // Create every entry up front, so that the concurrent lookups of the
+      // summaries below never modify the map itself.
+      map[module];
+    }
+
+    std::atomic<bool> detectedCycle = false;
+    for (auto &level : levelModules)
+      mlir::parallelForEach(&getContext(), level, [&](Operation *module) {
+        if (checkModule(module, &instanceGraph))
+          detectedCycle = true;
+      });
+
+    map.clear();
+    if (detectedCycle)
+      signalPassFailure();
+    markAllAnalysesPreserved();
+  }
+
+  /// Detect the combinational cycles within a module and record the
+  /// combinational paths between its IOs in `map`. Returns true if a cycle was
+  /// found.
+  bool checkModule(Operation *op, InstanceGraph *instanceGraph) {
+    bool detectedCycle = false;
+    if (auto module = dyn_cast<FModuleOp>(op)) {
+      NodeContext context(&map, instanceGraph, module.getOps<FConnectLike>());
+      auto dummyNode = Node(nullptr, &context);
+
+      // Traversing SCCs in the combinational graph to detect cycles. As
+      // FIRRTL module is an SSA region, all cycles must contain at least one
+      // connect op. Thus we introduce a dummy source node to iterate on the
+      // `dest`s of all connect ops in the module.
+      for (auto combSCC = SCCIterator::begin(dummyNode); !combSCC.isAtEnd();
+           ++combSCC) {
+        if (combSCC.hasCycle()) {
+          detectedCycle = true;
+          auto errorDiag = mlir::emitError(
+              module.getLoc(),
+              "detected combinational cycle in a FIRRTL module");
+          if (printSimpleCycle)
+            dumpSimpleCycle(combSCC, module, errorDiag);
+          else {
+            for (auto node : *combSCC) {
+              auto &noteDiag = errorDiag.attachNote(node.value.getLoc());
+              noteDiag << "this operation is part of the combinational cycle";
             }
           }
         }
+      }
 
-        SmallVector<bool, 8> directionVec;
-        for (auto &port : module.getPorts())
-          directionVec.push_back(port.isOutput());
-
-        auto &combPaths = map[module];
-        NodeDenseSet nodeSet;
-        SmallVector<size_t, 2> outputVec;
-        unsigned index = 0;
-
-        // Record all combinational paths.
-        for (auto &port : module.getPorts()) {
-          nodeSet.clear();
-          outputVec.clear();
-          auto arg = module.getArgument(index++);
-          if (port.isOutput()) {
-            combPaths.push_back(outputVec);
-            continue;
-          }
-          Node inputNode(arg, &context);
-          // There exists a path to self.
-          outputVec.push_back(arg.getArgNumber());
-          for (auto node : llvm::depth_first_ext<Node>(inputNode, nodeSet)) {
-            if (auto output = node.value.dyn_cast<BlockArgument>())
-              if (directionVec[output.getArgNumber()])
-                outputVec.push_back(output.getArgNumber());
-          }
+      SmallVector<bool, 8> directionVec;
+      for (auto &port : module.getPorts())
+        directionVec.push_back(port.isOutput());
+
+      auto &combPaths = map[module];
+      NodeDenseSet nodeSet;
+      SmallVector<size_t, 2> outputVec;
+      unsigned index = 0;
+
+      // Record all combinational paths.
+      for (auto &port : module.getPorts()) {
+        nodeSet.clear();
+        outputVec.clear();
+        auto arg = module.getArgument(index++);
+        if (port.isOutput()) {
           combPaths.push_back(outputVec);
+          continue;
         }
-        continue;
+        Node inputNode(arg, &context);
+        // There exists a path to self.
+        outputVec.push_back(arg.getArgNumber());
+        for (auto node : llvm::depth_first_ext<Node>(inputNode, nodeSet)) {
+          if (auto output = node.value.dyn_cast<BlockArgument>())
+            if (directionVec[output.getArgNumber()])
+              outputVec.push_back(output.getArgNumber());
+        }
+        combPaths.push_back(outputVec);
       }
-      if (auto extModule = dyn_cast<FExtModuleOp>(*node->getModule())) {
-        // TODO: Handle FExtModuleOp with `ExtModulePathAnnotation`s.
-        auto &combPaths = map[extModule];
-        SmallVector<size_t, 2> outputVec;
-
-        // Record all trivial combinational paths.
-        for (size_t index = 0; index < extModule.getNumPorts(); ++index) {
-          outputVec.clear();
-          if (extModule.getPortDirection(index) == Direction::Out) {
-            combPaths.push_back(outputVec);
-            continue;
-          }
-          // Record the trivial path to self.
-          outputVec.push_back(index);
+      return detectedCycle;
+    }
+    if (auto extModule = dyn_cast<FExtModuleOp>(op)) {
+      // TODO: Handle FExtModuleOp with `ExtModulePathAnnotation`s.
+      auto &combPaths = map[extModule];
+      SmallVector<size_t, 2> outputVec;
+
+      // Record all trivial combinational paths.
+      for (size_t index = 0; index < extModule.getNumPorts(); ++index) {
+        outputVec.clear();
+        if (extModule.getPortDirection(index) == Direction::Out) {
           combPaths.push_back(outputVec);
+          continue;
         }
-        continue;
+        // Record the trivial path to self.
+        outputVec.push_back(index);
+        combPaths.push_back(outputVec);
       }
-      llvm_unreachable("invalid instance graph node");
+      return false;
     }
-
-    if (detectedCycle)
-      signalPassFailure();
-    markAllAnalysesPreserved();
+    llvm_unreachable("invalid instance graph node");
   }
 
 private:
@@ -63,11 +63,11 @@ LogicalResult CreateSiFiveMetadataPass::emitMemoryMetadata() {
   auto instancePathCache = InstancePathCache(getAnalysis<InstanceGraph>());
 
   // This lambda, writes to the given Json stream all the relevant memory
-  // attributes. Also adds the memory attrbutes to the string for creating the
+  // attributes. Also adds the memory attrbutes to the stream for creating the
   // memmory conf file.
   auto createMemMetadata = [&](FMemModuleOp mem,
                                llvm::json::OStream &jsonStream,
-                               std::string &seqMemConfStr) {
+                               raw_ostream &seqMemConf) {
     // Get the memory data width.
     auto width = mem.getDataWidth();
     // Metadata needs to be printed for memories which are candidates for
@@ -102,10 +102,9 @@ LogicalResult CreateSiFiveMetadataPass::emitMemoryMetadata() {
     auto memExtName = mem.getName();
     auto maskGranStr =
         !isMasked ? "" : " mask_gran " + std::to_string(maskGran);
-    seqMemConfStr = (StringRef(seqMemConfStr) + "name " + memExtName +
-                     " depth " + Twine(mem.getDepth()) + " width " +
-                     Twine(width) + " ports " + portStr + maskGranStr + "\n")
-                        .str();
+    seqMemConf << "name " << memExtName << " depth " << mem.getDepth()
+               << " width " << width << " ports " << portStr << maskGranStr
+               << "\n";
     // This adds a Json array element entry corresponding to this memory.
     jsonStream.object([&] {
       jsonStream.attribute("module_name", memExtName);
@@ -131,26 +130,30 @@ LogicalResult CreateSiFiveMetadataPass::emitMemoryMetadata() {
         }
       });
       // Record all the hierarchy names.
-      SmallVector<std::string> hierNames;
+      SmallString<128> hierName;
       jsonStream.attributeArray("hierarchy", [&] {
-        // Get the absolute path for the parent memory, to create the
-        // hierarchy names.
-        auto paths = instancePathCache.getAbsolutePaths(mem);
-        for (auto p : paths) {
+        // Walk the absolute paths for the parent memory, to create the
+        // hierarchy names.  The paths are not needed afterwards, so don't
+        // materialize them.
+        instancePathCache.walkAbsolutePaths(mem, [&](hw::InstancePath p) {
           if (p.empty())
-            continue;
-          auto top = p.front();
-          std::string hierName =
-              top->getParentOfType<FModuleOp>().getName().str();
-          for (auto inst : p) {
-            auto parentModule = inst->getParentOfType<FModuleOp>();
-            if (dutMod == parentModule)
-              hierName = parentModule.getName().str();
-            hierName = (Twine(hierName) + "." + inst.instanceName()).str();
+            return;
+          // The hierarchy name starts at the innermost instance of the DUT,
+          // or at the top module if the path does not go through the DUT.
+          // Find it first, so that the name is built once in a single buffer.
+          size_t start = 0;
+          for (size_t i = p.size(); i != 0; --i)
+            if (p[i - 1]->getParentOfType<FModuleOp>() == dutMod) {
+              start = i - 1;
+              break;
+            }
+          hierName = p[start]->getParentOfType<FModuleOp>().getName();
+          for (auto inst : p.drop_front(start)) {
+            hierName += '.';
+            hierName += inst.instanceName();
           }
-          hierNames.push_back(hierName);
           jsonStream.value(hierName);
-        }
+        });
       });
     });
   };
@@ -172,15 +175,16 @@ LogicalResult CreateSiFiveMetadataPass::emitMemoryMetadata() {
   llvm::json::OStream dutJson(dutOs, 2);
 
   std::string seqMemConfStr;
+  llvm::raw_string_ostream seqMemConfOs(seqMemConfStr);
   dutJson.array([&] {
     for (auto &dutM : dutMems)
-      createMemMetadata(dutM, dutJson, seqMemConfStr);
+      createMemMetadata(dutM, dutJson, seqMemConfOs);
   });
   testBenchJson.array([&] {
     // The tbConfStr is populated here, but unused, it will not be printed to
     // file.
     for (auto &tbM : tbMems)
-      createMemMetadata(tbM, testBenchJson, seqMemConfStr);
+      createMemMetadata(tbM, testBenchJson, seqMemConfOs);
   });
 
   auto *context = &getContext();
@@ -432,7 +436,7 @@ void CreateSiFiveMetadataPass::runOnOperation() {
 
   // Find the device under test and create a set of all modules underneath it.
   auto it = llvm::find_if(*body, [&](Operation &op) -> bool {
-    return AnnotationSet(&op).hasAnnotation(dutAnnoClass);
+    return AnnotationSet::hasAnnotation(&op, dutAnnoClass);
   });
   if (it != body->end()) {
     dutMod = dyn_cast<FModuleOp>(*it);
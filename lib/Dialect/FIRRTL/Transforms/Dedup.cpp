@@ -24,6 +24,7 @@
 #include "circt/Support/LLVM.h"
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Support/LogicalResult.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseMapInfo.h"
@@ -59,9 +60,15 @@ llvm::raw_ostream &printHash(llvm::raw_ostream &stream, std::string data) {
   return printHex(stream, bytes);
 }
 
-struct StructuralHasher {
-  explicit StructuralHasher(MLIRContext *context) {
+/// The structural hashes of the modules hashed so far, by module name.
+using ModuleHashes = DenseMap<StringAttr, std::array<uint8_t, 32>>;
+
+/// The state shared by all structural hashers.  This is only read while
+/// hashing, so many hashers can run concurrently.
+struct StructuralHasherSharedConstants {
+  explicit StructuralHasherSharedConstants(MLIRContext *context) {
     portTypesAttr = StringAttr::get(context, "portTypes");
+    moduleNameAttr = StringAttr::get(context, "moduleName");
     nonessentialAttributes.insert(StringAttr::get(context, "annotations"));
     nonessentialAttributes.insert(StringAttr::get(context, "name"));
     nonessentialAttributes.insert(StringAttr::get(context, "portAnnotations"));
@@ -71,6 +78,19 @@ struct StructuralHasher {
     nonessentialAttributes.insert(StringAttr::get(context, "inner_sym"));
   };
 
+  // This is a set of every attribute we should ignore.
+  DenseSet<Attribute> nonessentialAttributes;
+  // This is a cached "portTypes" string attr.
+  StringAttr portTypesAttr;
+  // This is a cached "moduleName" string attr.
+  StringAttr moduleNameAttr;
+};
+
+struct StructuralHasher {
+  StructuralHasher(const StructuralHasherSharedConstants &constants,
+                   const ModuleHashes &moduleHashes)
+      : constants(constants), moduleHashes(moduleHashes) {}
+
   std::array<uint8_t, 32> hash(FModuleLike module) {
     update(&(*module));
     auto hash = sha.final();
@@ -132,10 +152,21 @@ private:
       auto name = namedAttr.getName();
       auto value = namedAttr.getValue();
       // Skip names and annotations.
-      if (nonessentialAttributes.contains(name))
+      if (constants.nonessentialAttributes.contains(name))
         continue;
+      // Hash instantiated modules by their structure instead of their name.
+      // This makes the hash independent of which module of a group of
+      // duplicates the instance refers to.
+      if (name == constants.moduleNameAttr)
+        if (auto moduleName = value.dyn_cast<FlatSymbolRefAttr>()) {
+          auto it = moduleHashes.find(moduleName.getAttr());
+          if (it != moduleHashes.end()) {
+            sha.update(it->second);
+            continue;
+          }
+        }
       // Hash the port types.
-      if (name == portTypesAttr) {
+      if (name == constants.portTypesAttr) {
         auto portTypes = value.cast<ArrayAttr>().getAsValueRange<TypeAttr>();
         for (auto type : portTypes)
           update(type);
@@ -183,10 +214,9 @@ private:
   unsigned currentIndex = 0;
   DenseMap<Value, unsigned> indexes;
 
-  // This is a set of every attribute we should ignore.
-  DenseSet<Attribute> nonessentialAttributes;
-  // This is a cached "portTypes" string attr.
-  StringAttr portTypesAttr;
+  const StructuralHasherSharedConstants &constants;
+  // The hashes of the modules which have already been hashed.
+  const ModuleHashes &moduleHashes;
 
   // This is the actual running hash calculation. This is a stateful element
   // that should be reinitialized after each hash is produced.
@@ -799,15 +829,16 @@ private:
     }
   }
 
-  /// This erases the NLA op, and removes the NLA from every module's NLA map,
-  /// but it does not delete the NLA reference from the target operation's
-  /// annotations.
-  void eraseNLA(HierPathOp nla) {
-    // Erase the NLA from the leaf module's nlaMap.
-    targetMap.erase(nla.getNameAttr());
-    nlaTable->erase(nla);
-    nlaCache.erase(nla.getNamepathAttr());
-    symbolTable.erase(nla);
+  /// This erases the NLA ops, and removes the NLAs from every module's NLA
+  /// map, but it does not delete the NLA references from the target
+  /// operations' annotations.
+  void eraseNLAs(ArrayRef<HierPathOp> nlas) {
+    // Erase the NLAs from the leaf modules' nlaMap.
+    for (auto nla : nlas) {
+      targetMap.erase(nla.getNameAttr());
+      nlaCache.erase(nla.getNamepathAttr());
+    }
+    nlaTable->eraseNLAs(nlas, &symbolTable);
   }
 
   /// Process all NLAs referencing the "from" module to point to the "to"
@@ -822,7 +853,8 @@ private:
     // Change the NLA to target the toModule.
     nlaTable->renameModuleAndInnerRef(toName, fromName, renameMap);
     // Now we walk the NLA searching for ones that require more context to be
-    // added.
+    // added. The replaced NLAs are erased together at the end.
+    SmallVector<HierPathOp> replacedNLAs;
     for (auto nla : moduleNLAs) {
       auto elements = nla.getNamepath().getValue();
       // If we don't need to add more context, we're done here.
@@ -865,9 +897,11 @@ private:
           targetMap[nla.getAttr()].insert(target);
       }
 
-      // Erase the old NLA and remove it from all breadcrumbs.
-      eraseNLA(nla);
+      replacedNLAs.push_back(nla);
     }
+
+    // Erase the old NLAs and remove them from all breadcrumbs.
+    eraseNLAs(replacedNLAs);
   }
 
   /// Process all the NLAs that the two modules participate in, replacing
@@ -1259,7 +1293,6 @@ class DedupPass : public DedupBase<DedupPass> {
     auto *nlaTable = &getAnalysis<NLATable>();
     SymbolTable symbolTable(circuit);
     Deduper deduper(instanceGraph, symbolTable, nlaTable, circuit);
-    StructuralHasher hasher(&getContext());
     Equivalence equiv(context, instanceGraph);
     auto anythingChanged = false;
 
@@ -1283,6 +1316,42 @@ class DedupPass : public DedupBase<DedupPass> {
           return cast<FModuleLike>(*node->getModule());
         }));
 
+    // Hash all modules up front.  A module's hash covers the hashes of the
+    // modules it instantiates, so the modules are hashed one level of the
+    // instance hierarchy at a time, bottom up, and each level in parallel.
+    // Modules marked NoDedup are not hashed, and instances of them are hashed
+    // by name.
+    ModuleHashes hashes;
+    {
+      StructuralHasherSharedConstants hasherConstants(context);
+      DenseMap<Operation *, unsigned> levels;
+      SmallVector<SmallVector<FModuleLike, 0>> levelModules;
+      for (auto module : modules) {
+        unsigned level = 0;
+        for (auto *instance :
+             *instanceGraph[::cast<hw::HWModuleLike>(*module)])
+          level = std::max(level,
+                           levels.lookup(instance->getTarget()->getModule()) +
+                               1);
+        levels[module] = level;
+        if (AnnotationSet(module).hasAnnotation(noDedupClass))
+          continue;
+        if (levelModules.size() <= level)
+          levelModules.resize(level + 1);
+        levelModules[level].push_back(module);
+      }
+
+      for (auto &level : levelModules) {
+        SmallVector<std::array<uint8_t, 32>, 0> levelHashes(level.size());
+        mlir::parallelFor(context, 0, level.size(), [&](size_t index) {
+          StructuralHasher hasher(hasherConstants, hashes);
+          levelHashes[index] = hasher.hash(level[index]);
+        });
+        for (auto [module, hash] : llvm::zip(level, levelHashes))
+          hashes[module.moduleNameAttr()] = hash;
+      }
+    }
+
     for (auto module : modules) {
       auto moduleName = module.moduleNameAttr();
       // If the module is marked with NoDedup, just skip it.
@@ -1294,8 +1363,8 @@ class DedupPass : public DedupBase<DedupPass> {
         dedupMap[moduleName] = moduleName;
         continue;
       }
-      // Calculate the hash of the module.
-      auto h = hasher.hash(module);
+      // Look up the hash of the module.
+      auto h = hashes.lookup(moduleName);
       // Check if there a module with the same hash.
       auto it = moduleHashes.find(h);
       if (it != moduleHashes.end()) {
@@ -1390,7 +1459,9 @@ class DedupPass : public DedupBase<DedupPass> {
     // can block the deduplication of the parent modules.
     fixupAllModules(instanceGraph);
 
-    markAnalysesPreserved<NLATable>();
+    // The instance graph was updated as modules were merged, and the NLA table
+    // as paths were rewritten, so neither has to be rebuilt by later passes.
+    markAnalysesPreserved<InstanceGraph, NLATable>();
     if (!anythingChanged)
       markAllAnalysesPreserved();
   }
@@ -71,6 +71,11 @@ private:
   void emitTrackedTarget(DictionaryAttr node, llvm::json::OStream &jsonStream,
                          bool dutInstance);
 
+  /// The serialized module/instance hierarchy of an NLA, and whether it is
+  /// rooted at the DUT rather than the circuit.
+  using NLAPath = std::pair<bool, SmallString<64>>;
+  const NLAPath &getNLAPath(HierPathOp nla, bool dutInstance);
+
   SmallString<8> addSymbolImpl(Attribute symbol) {
     unsigned id;
     auto it = symbolIndices.find(symbol);
@@ -139,6 +144,10 @@ private:
 
   /// Cached NLA table analysis.
   NLATable *nlaTable;
+
+  /// The serialized hierarchy of each NLA used by a tracker, memoized since
+  /// many trackers share the same NLA.
+  DenseMap<std::pair<Operation *, bool>, NLAPath> nlaPaths;
 };
 } // namespace
 
@@ -518,6 +527,7 @@ void EmitOMIRPass::runOnOperation() {
   removeTempNLAs.clear();
   moduleNamespaces.clear();
   instancesByName.clear();
+  nlaPaths.clear();
   CircuitOp circuitOp = getOperation();
 
   // Gather the relevant annotations from the circuit. On the one hand these are
@@ -1087,51 +1097,14 @@ void EmitOMIRPass::emitTrackedTarget(DictionaryAttr node,
 
   // Serialize the local or non-local module/instance hierarchy path.
   if (tracker.nla) {
-    bool notFirst = false;
-    hw::InnerRefAttr instName;
-    for (auto nameRef : tracker.nla.getNamepath()) {
-      StringAttr modName;
-      if (auto innerRef = nameRef.dyn_cast<hw::InnerRefAttr>())
-        modName = innerRef.getModule();
-      else if (auto ref = nameRef.dyn_cast<FlatSymbolRefAttr>())
-        modName = ref.getAttr();
-      if (!dutInstance && modName == dutModuleName) {
-        // Check if the DUT module occurs in the instance path.
-        // Print the path relative to the DUT, if the nla is inside the DUT.
-        // Keep the path for dutInstance relative to test harness. (SFC
-        // implementation in TestHarnessOMPhase.scala)
-        target = type;
-        target.append(":~");
-        target.append(dutModuleName);
-        target.push_back('|');
-        notFirst = false;
-        instName = {};
-      }
-
-      Operation *module = nlaTable->getModule(modName);
-      assert(module);
-      if (notFirst)
-        target.push_back('/');
-      notFirst = true;
-      if (instName) {
-        target.append(addSymbol(instName));
-        target.push_back(':');
-      }
-      target.append(addSymbol(module));
-
-      if (auto innerRef = nameRef.dyn_cast<hw::InnerRefAttr>()) {
-        // Find an instance with the given name in this module. Ensure it has a
-        // symbol that we can refer to.
-        auto instOp = instancesByName.lookup(innerRef);
-        if (!instOp)
-          continue;
-        LLVM_DEBUG(llvm::dbgs() << "Marking NLA-participating instance "
-                                << innerRef.getName() << " in module "
-                                << modName << " as dont-touch\n");
-        tempSymInstances.erase(instOp);
-        instName = getInnerRefTo(instOp);
-      }
+    auto &[rootedAtDut, path] = getNLAPath(tracker.nla, dutInstance);
+    if (rootedAtDut) {
+      target = type;
+      target.append(":~");
+      target.append(dutModuleName);
+      target.push_back('|');
     }
+    target.append(path);
   } else {
     FModuleOp module = dyn_cast<FModuleOp>(tracker.op);
     if (!module)
@@ -1193,6 +1166,61 @@ void EmitOMIRPass::emitTrackedTarget(DictionaryAttr node,
   jsonStream.value(target);
 }
 
+/// Serialize the module/instance hierarchy encoded by an NLA. This also marks
+/// the instances along the path with symbols, which only has to happen once.
+const EmitOMIRPass::NLAPath &EmitOMIRPass::getNLAPath(HierPathOp nla,
+                                                      bool dutInstance) {
+  auto [it, inserted] = nlaPaths.try_emplace({nla, dutInstance});
+  if (!inserted)
+    return it->second;
+  auto &[rootedAtDut, path] = it->second;
+  rootedAtDut = false;
+  bool notFirst = false;
+  hw::InnerRefAttr instName;
+  for (auto nameRef : nla.getNamepath()) {
+    StringAttr modName;
+    if (auto innerRef = nameRef.dyn_cast<hw::InnerRefAttr>())
+      modName = innerRef.getModule();
+    else if (auto ref = nameRef.dyn_cast<FlatSymbolRefAttr>())
+      modName = ref.getAttr();
+    if (!dutInstance && modName == dutModuleName) {
+      // Check if the DUT module occurs in the instance path.
+      // Print the path relative to the DUT, if the nla is inside the DUT.
+      // Keep the path for dutInstance relative to test harness. (SFC
+      // implementation in TestHarnessOMPhase.scala)
+      rootedAtDut = true;
+      path.clear();
+      notFirst = false;
+      instName = {};
+    }
+
+    Operation *module = nlaTable->getModule(modName);
+    assert(module);
+    if (notFirst)
+      path.push_back('/');
+    notFirst = true;
+    if (instName) {
+      path.append(addSymbol(instName));
+      path.push_back(':');
+    }
+    path.append(addSymbol(module));
+
+    if (auto innerRef = nameRef.dyn_cast<hw::InnerRefAttr>()) {
+      // Find an instance with the given name in this module. Ensure it has a
+      // symbol that we can refer to.
+      auto instOp = instancesByName.lookup(innerRef);
+      if (!instOp)
+        continue;
+      LLVM_DEBUG(llvm::dbgs() << "Marking NLA-participating instance "
+                              << innerRef.getName() << " in module "
+                              << modName << " as dont-touch\n");
+      tempSymInstances.erase(instOp);
+      instName = getInnerRefTo(instOp);
+    }
+  }
+  return it->second;
+}
+
 hw::InnerRefAttr EmitOMIRPass::getInnerRefTo(Operation *op) {
   return ::getInnerRefTo(op, "omir_sym",
                          [&](FModuleOp module) -> ModuleNamespace & {
@@ -17,6 +17,7 @@
 #include "circt/Dialect/FIRRTL/FIRRTLVisitors.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Support/FieldRef.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
 
@@ -206,6 +207,18 @@ public:
     declare(type, flow);
   }
 
+  /// Create a connect that carries the debug name `debugAttr`, if it is set.
+  /// The attribute is added when the op is created, so that its attribute
+  /// dictionary does not have to be rebuilt.
+  static ConnectOp createConnect(OpBuilder &b, Location loc, Value dest,
+                                 Value src, Attribute debugAttr) {
+    if (!debugAttr)
+      return b.create<ConnectOp>(loc, dest, src);
+    return b.create<ConnectOp>(
+        loc, TypeRange{}, ValueRange{dest, src},
+        NamedAttribute(b.getStringAttr("hw.debug.name"), debugAttr));
+  }
+
   /// Take two connection operations and merge them into a new connect under a
   /// condition.  Destination of both connects should be `dest`.
   ConnectOp flattenConditionalConnections(OpBuilder &b, Location loc,
@@ -213,7 +226,8 @@ public:
                                           Operation *whenTrueConn,
                                           Operation *whenFalseConn) {
     auto fusedLoc =
-        b.getFusedLoc({loc, whenTrueConn->getLoc(), whenFalseConn->getLoc()});
+        fuseLocs(b.getContext(),
+                 {loc, whenTrueConn->getLoc(), whenFalseConn->getLoc()});
     auto whenTrue = getConnectedValue(whenTrueConn);
     auto trueIsInvalid =
         isa_and_nonnull<InvalidValueOp>(whenTrue.getDefiningOp());
@@ -231,16 +245,10 @@ public:
       newValue = b.createOrFold<MuxPrimOp>(fusedLoc, cond, whenTrue, whenFalse);
     else if (trueIsInvalid)
       newValue = whenFalse;
-    auto connectOp = b.create<ConnectOp>(loc, dest, newValue);
-
-    if (auto debugAttr = whenTrueConn->getAttr("hw.debug.name")) {
-      connectOp->setAttr("hw.debug.name", debugAttr);
-    } else if (whenFalseConn && whenFalseConn->hasAttr("hw.debug.name")) {
-      connectOp->setAttr("hw.debug.name",
-                         whenFalseConn->getAttr("hw.debug.name"));
-    }
-
-    return connectOp;
+    auto debugAttr = whenTrueConn->getAttr("hw.debug.name");
+    if (!debugAttr && whenFalseConn)
+      debugAttr = whenFalseConn->getAttr("hw.debug.name");
+    return createConnect(b, loc, dest, newValue, debugAttr);
   }
 
   void visitDecl(WireOp op) { declareSinks(op.getResult(), Flow::Duplex); }
@@ -283,10 +291,8 @@ public:
     // aggergate type, connect each ground type element.
     auto builder = OpBuilder(op->getBlock(), ++Block::iterator(op));
     auto fn = [&](Value value) {
-      auto connect = builder.create<ConnectOp>(value.getLoc(), value, value);
-      if (auto debugAttr = op->getAttr("hw.debug.name")) {
-        connect->setAttr("hw.debug.name", debugAttr);
-      }
+      auto connect = createConnect(builder, value.getLoc(), value, value,
+                                   op->getAttr("hw.debug.name"));
       driverMap[getFieldRefFromValue(value)] = connect;
     };
     foreachSubelement(builder, op.getResult(), fn);
@@ -337,6 +343,10 @@ public:
   /// then there is an incomplete initialization error.
   void mergeScopes(Location loc, DriverMap &thenScope, DriverMap &elseScope,
                    Value thenCondition) {
+    // The destinations set in both blocks, which are fully handled while
+    // processing the `then` block. These are skipped rather than erased from
+    // the `else` scope, since erasing from a MapVector is linear in its size.
+    DenseSet<FieldRef> mergedDests;
 
     // Process all connects in the `then` block.
     for (auto &destAndConnect : thenScope) {
@@ -369,7 +379,7 @@ public:
         setLastConnect(dest, newConnect);
 
         // Do not process connect in the else scope.
-        elseScope.erase(dest);
+        mergedDests.insert(dest);
         continue;
       }
 
@@ -397,6 +407,8 @@ public:
     for (auto &destAndConnect : elseScope) {
       auto dest = std::get<0>(destAndConnect);
       auto elseConnect = std::get<1>(destAndConnect);
+      if (mergedDests.contains(dest))
+        continue;
 
       auto outerIt = driverMap.find(dest);
       if (outerIt == driverMap.end()) {
@@ -656,18 +668,32 @@ LogicalResult ModuleVisitor::checkInitialization() {
 
 namespace {
 class ExpandWhensPass : public ExpandWhensBase<ExpandWhensPass> {
+public:
+  ExpandWhensPass(bool mergeConnectionsFlag, bool aggressiveMergingFlag) {
+    mergeConnections = mergeConnectionsFlag;
+    aggressiveMerging = aggressiveMergingFlag;
+  }
+
+private:
   void runOnOperation() override;
 };
 } // end anonymous namespace
 
 void ExpandWhensPass::runOnOperation() {
   ModuleVisitor visitor;
-  if (!visitor.run(getOperation()))
-    markAllAnalysesPreserved();
+  bool changed = visitor.run(getOperation());
   if (failed(visitor.checkInitialization()))
-    signalPassFailure();
+    return signalPassFailure();
+  // Every connect is final at this point, so the connections of the module
+  // can be merged while it is still being processed by this thread.
+  if (mergeConnections)
+    changed |= firrtl::mergeConnections(getOperation(), aggressiveMerging);
+  if (!changed)
+    markAllAnalysesPreserved();
 }
 
-std::unique_ptr<mlir::Pass> circt::firrtl::createExpandWhensPass() {
-  return std::make_unique<ExpandWhensPass>();
+std::unique_ptr<mlir::Pass>
+circt::firrtl::createExpandWhensPass(bool mergeConnections,
+                                     bool aggressiveMerging) {
+  return std::make_unique<ExpandWhensPass>(mergeConnections, aggressiveMerging);
 }
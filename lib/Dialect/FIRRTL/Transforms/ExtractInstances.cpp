@@ -56,6 +56,21 @@ struct ExtractionInfo {
   bool stopAtDUT;
 };
 
+/// An instance which is moved up by one level of hierarchy, along with the
+/// NLAs it participates in.
+struct ExtractionMove {
+  InstanceOp inst;
+  ExtractionInfo info;
+  /// The index of the first parent module port added for the instance.
+  unsigned portOffset;
+  /// The NLAs which pass through or end at the instance.
+  DenseSet<HierPathOp> instanceNLAs;
+  /// The non-local annotations of the instance, by NLA.
+  DenseMap<HierPathOp, SmallVector<Annotation>> instNonlocalAnnos;
+  /// The `instanceNLAs`, sorted by name for a deterministic output.
+  SmallVector<HierPathOp> sortedInstanceNLAs;
+};
+
 struct ExtractInstancesPass
     : public ExtractInstancesBase<ExtractInstancesPass> {
   void runOnOperation() override;
@@ -468,106 +483,129 @@ void ExtractInstancesPass::extractInstances() {
         inst->getParentOfType<FModuleLike>().moduleNameAttr();
 
   while (!extractionWorklist.empty()) {
-    InstanceOp inst;
-    ExtractionInfo info;
-    std::tie(inst, info) = extractionWorklist.pop_back_val();
-    auto parent = inst->getParentOfType<FModuleOp>();
-
-    // Figure out the wiring prefix to use for this instance. If we are supposed
-    // to use a wiring prefix (`info.prefix` is non-empty), we assemble a
-    // `<prefix>_<N>` string, where `N` is an unsigned integer used to uniquifiy
-    // the prefix. This is very close to what the original Scala implementation
-    // of the pass does, which would group instances to be extracted by prefix
-    // and then iterate over them with the index in the group being used as `N`.
-    StringRef prefix;
-    if (!info.prefix.empty()) {
-      auto &prefixSlot = instPrefices[inst];
-      if (prefixSlot.empty()) {
-        auto idx = prefixUniqueIDs[info.prefix]++;
-        (Twine(info.prefix) + "_" + Twine(idx)).toVector(prefixSlot);
-      }
-      prefix = prefixSlot;
+    // Pick the next instance to move. In batched mode, all other instances in
+    // the worklist which reside in the same module are moved along with it, so
+    // that the module and its instantiations are only rewritten once.
+    SmallVector<std::pair<InstanceOp, ExtractionInfo>> batch;
+    batch.push_back(extractionWorklist.pop_back_val());
+    auto parent = batch.front().first->getParentOfType<FModuleOp>();
+    if (batched) {
+      auto inParent = [&](const std::pair<InstanceOp, ExtractionInfo> &entry) {
+        return entry.first->getParentOfType<FModuleOp>() == parent;
+      };
+      for (auto &entry : llvm::reverse(extractionWorklist))
+        if (inParent(entry))
+          batch.push_back(entry);
+      llvm::erase_if(extractionWorklist, inParent);
     }
 
-    // If the instance is already in the right place (outside the DUT or already
-    // in the root module), there's nothing left for us to do. Otherwise we
-    // proceed to bubble it up one level in the hierarchy and add the resulting
-    // instances back to the worklist.
-    if (!dutModules.contains(parent) ||
-        instanceGraph->lookup(parent)->noUses() ||
-        (info.stopAtDUT && dutRootModules.contains(parent))) {
-      LLVM_DEBUG(llvm::dbgs() << "\nNo need to further move " << inst << "\n");
-      extractedInstances.push_back({inst, info});
-      continue;
-    }
-    LLVM_DEBUG({
-      llvm::dbgs() << "\nMoving ";
-      if (!prefix.empty())
-        llvm::dbgs() << "`" << prefix << "` ";
-      llvm::dbgs() << inst << "\n";
-    });
-
     // Add additional ports to the parent module as a replacement for the
-    // instance port signals once the instance is extracted.
+    // instance port signals once the instances are extracted.
     unsigned numParentPorts = parent.getNumPorts();
-    unsigned numInstPorts = inst.getNumResults();
-
-    for (unsigned portIdx = 0; portIdx < numInstPorts; ++portIdx) {
-      // Assemble the new port name as "<prefix>_<name>", where the prefix is
-      // provided by the extraction annotation.
-      auto name = inst.getPortNameStr(portIdx);
-      auto nameAttr = StringAttr::get(
-          &getContext(),
-          prefix.empty() ? Twine(name) : Twine(prefix) + "_" + name);
-
-      PortInfo newPort{nameAttr,
-                       inst.getResult(portIdx).getType().cast<FIRRTLType>(),
-                       direction::flip(inst.getPortDirection(portIdx))};
-      newPort.loc = inst.getResult(portIdx).getLoc();
-      newPorts.push_back({numParentPorts, newPort});
-      LLVM_DEBUG(llvm::dbgs()
-                 << "- Adding port " << newPort.direction << " "
-                 << newPort.name.getValue() << ": " << newPort.type << "\n");
+    SmallVector<ExtractionMove> moves;
+    for (auto &[inst, info] : batch) {
+      // Figure out the wiring prefix to use for this instance. If we are
+      // supposed to use a wiring prefix (`info.prefix` is non-empty), we
+      // assemble a `<prefix>_<N>` string, where `N` is an unsigned integer used
+      // to uniquifiy the prefix. This is very close to what the original Scala
+      // implementation of the pass does, which would group instances to be
+      // extracted by prefix and then iterate over them with the index in the
+      // group being used as `N`.
+      StringRef prefix;
+      if (!info.prefix.empty()) {
+        auto &prefixSlot = instPrefices[inst];
+        if (prefixSlot.empty()) {
+          auto idx = prefixUniqueIDs[info.prefix]++;
+          (Twine(info.prefix) + "_" + Twine(idx)).toVector(prefixSlot);
+        }
+        prefix = prefixSlot;
+      }
+
+      // If the instance is already in the right place (outside the DUT or
+      // already in the root module), there's nothing left for us to do.
+      // Otherwise we proceed to bubble it up one level in the hierarchy and add
+      // the resulting instances back to the worklist.
+      if (!dutModules.contains(parent) ||
+          instanceGraph->lookup(parent)->noUses() ||
+          (info.stopAtDUT && dutRootModules.contains(parent))) {
+        LLVM_DEBUG(llvm::dbgs()
+                   << "\nNo need to further move " << inst << "\n");
+        extractedInstances.push_back({inst, info});
+        continue;
+      }
+      LLVM_DEBUG({
+        llvm::dbgs() << "\nMoving ";
+        if (!prefix.empty())
+          llvm::dbgs() << "`" << prefix << "` ";
+        llvm::dbgs() << inst << "\n";
+      });
+
+      auto &move = moves.emplace_back();
+      move.inst = inst;
+      move.info = info;
+      move.portOffset = numParentPorts + newPorts.size();
+      for (unsigned portIdx = 0, e = inst.getNumResults(); portIdx < e;
+           ++portIdx) {
+        // Assemble the new port name as "<prefix>_<name>", where the prefix is
+        // provided by the extraction annotation.
+        auto name = inst.getPortNameStr(portIdx);
+        auto nameAttr = StringAttr::get(
+            &getContext(),
+            prefix.empty() ? Twine(name) : Twine(prefix) + "_" + name);
+
+        PortInfo newPort{nameAttr,
+                         inst.getResult(portIdx).getType().cast<FIRRTLType>(),
+                         direction::flip(inst.getPortDirection(portIdx))};
+        newPort.loc = inst.getResult(portIdx).getLoc();
+        newPorts.push_back({numParentPorts, newPort});
+        LLVM_DEBUG(llvm::dbgs()
+                   << "- Adding port " << newPort.direction << " "
+                   << newPort.name.getValue() << ": " << newPort.type << "\n");
+      }
     }
+    if (moves.empty())
+      continue;
     parent.insertPorts(newPorts);
     anythingChanged = true;
 
-    // Replace all uses of the existing instance ports with the newly-created
-    // module ports.
-    for (unsigned portIdx = 0; portIdx < numInstPorts; ++portIdx) {
-      inst.getResult(portIdx).replaceAllUsesWith(
-          parent.getArgument(numParentPorts + portIdx));
+    for (auto &move : moves) {
+      auto inst = move.inst;
+      // Replace all uses of the existing instance ports with the newly-created
+      // module ports.
+      for (unsigned portIdx = 0, e = inst.getNumResults(); portIdx < e;
+           ++portIdx)
+        inst.getResult(portIdx).replaceAllUsesWith(
+            parent.getArgument(move.portOffset + portIdx));
+      assert(inst.use_empty() && "instance ports should have been detached");
+      // Get the NLAs that pass through the InstanceOp `inst`.
+      // This does not returns NLAs that have the `inst` as the leaf.
+      nlaTable.getInstanceNLAs(inst, move.instanceNLAs);
+      // Map of the NLAs, that are applied to the InstanceOp. That is the NLA
+      // terminates on the InstanceOp.
+      AnnotationSet::removeAnnotations(inst, [&](Annotation anno) {
+        // Only consider annotations with a `circt.nonlocal` field.
+        auto nlaName = anno.getMember<FlatSymbolRefAttr>("circt.nonlocal");
+        if (!nlaName)
+          return false;
+        // Track the NLA.
+        if (HierPathOp nla = nlaTable.getNLA(nlaName.getAttr())) {
+          move.instNonlocalAnnos[nla].push_back(anno);
+          move.instanceNLAs.insert(nla);
+        }
+        return true;
+      });
+
+      // Sort the instance NLAs we've collected by the NLA name to have a
+      // deterministic output.
+      move.sortedInstanceNLAs.assign(move.instanceNLAs.begin(),
+                                     move.instanceNLAs.end());
+      llvm::sort(move.sortedInstanceNLAs, [](auto a, auto b) {
+        return a.getSymName() < b.getSymName();
+      });
     }
-    assert(inst.use_empty() && "instance ports should have been detached");
-    DenseSet<HierPathOp> instanceNLAs;
-    // Get the NLAs that pass through the InstanceOp `inst`.
-    // This does not returns NLAs that have the `inst` as the leaf.
-    nlaTable.getInstanceNLAs(inst, instanceNLAs);
-    // Map of the NLAs, that are applied to the InstanceOp. That is the NLA
-    // terminates on the InstanceOp.
-    DenseMap<HierPathOp, SmallVector<Annotation>> instNonlocalAnnos;
-    AnnotationSet::removeAnnotations(inst, [&](Annotation anno) {
-      // Only consider annotations with a `circt.nonlocal` field.
-      auto nlaName = anno.getMember<FlatSymbolRefAttr>("circt.nonlocal");
-      if (!nlaName)
-        return false;
-      // Track the NLA.
-      if (HierPathOp nla = nlaTable.getNLA(nlaName.getAttr())) {
-        instNonlocalAnnos[nla].push_back(anno);
-        instanceNLAs.insert(nla);
-      }
-      return true;
-    });
-
-    // Sort the instance NLAs we've collected by the NLA name to have a
-    // deterministic output.
-    SmallVector<HierPathOp> sortedInstanceNLAs(instanceNLAs.begin(),
-                                               instanceNLAs.end());
-    llvm::sort(sortedInstanceNLAs,
-               [](auto a, auto b) { return a.getSymName() < b.getSymName(); });
 
-    // Move the original instance one level up such that it is right next to
-    // the instances of the parent module, and wire the instance ports up to
+    // Move the original instances one level up such that they are right next
+    // to the instances of the parent module, and wire the instance ports up to
     // the newly added parent module ports.
     auto *instParentNode =
         instanceGraph->lookup(cast<hw::HWModuleLike>(*parent));
@@ -582,234 +620,253 @@ void ExtractInstancesPass::extractInstances() {
         oldParentInst.getResult(portIdx).replaceAllUsesWith(
             newParentInst.getResult(portIdx));
 
-      // Clone the existing instance and remove it from its current parent, such
-      // that we can insert it at its extracted location.
-      auto newInst = inst.cloneAndInsertPorts({});
-      newInst->remove();
-
-      // Ensure that the `inner_sym` of the instance is unique within the parent
-      // module we're extracting it to.
-      if (auto instSym = getInnerSymName(inst)) {
-        auto newName =
-            getModuleNamespace(newParent).newName(instSym.getValue());
-        if (newName != instSym.getValue())
-          newInst.setInnerSymAttr(
-              hw::InnerSymAttr::get(StringAttr::get(&getContext(), newName)));
-      }
-
-      // Add the moved instance and hook it up to the added ports.
-      ImplicitLocOpBuilder builder(inst.getLoc(), newParentInst);
-      builder.setInsertionPointAfter(newParentInst);
-      builder.insert(newInst);
-      for (unsigned portIdx = 0; portIdx < numInstPorts; ++portIdx) {
-        auto dst = newInst.getResult(portIdx);
-        auto src = newParentInst.getResult(numParentPorts + portIdx);
-        if (newPorts[portIdx].second.direction == Direction::In)
-          std::swap(src, dst);
-        builder.create<StrictConnectOp>(dst, src);
-      }
-
-      // Move the wiring prefix from the old to the new instance. We just look
-      // up the prefix for the old instance and if it exists, we remove it and
-      // assign it to the new instance. This has the effect of making the first
-      // new instance we create inherit the wiring prefix, and all additional
-      // new instances (e.g. through multiple instantiation of the parent) will
-      // pick a new prefix.
-      auto oldPrefix = instPrefices.find(inst);
-      if (oldPrefix != instPrefices.end()) {
-        LLVM_DEBUG(llvm::dbgs()
-                   << "  - Reusing prefix `" << oldPrefix->second << "`\n");
-        auto newPrefix = std::move(oldPrefix->second);
-        instPrefices.erase(oldPrefix);
-        instPrefices.insert({newInst, newPrefix});
-      }
-
-      // Inherit the old instance's extraction path.
-      extractionPaths.try_emplace(newInst); // (create entry first)
-      auto &extractionPath = (extractionPaths[newInst] = extractionPaths[inst]);
-      extractionPath.push_back(getInnerRefTo(newParentInst));
-      originalInstanceParents.try_emplace(newInst); // (create entry first)
-      originalInstanceParents[newInst] = originalInstanceParents[inst];
-      // Record the Nonlocal annotations that need to be applied to the new
-      // Inst.
-      SmallVector<Annotation> newInstNonlocalAnnos;
-
-      // Update all NLAs that touch the moved instance.
-      for (auto nla : sortedInstanceNLAs) {
-        LLVM_DEBUG(llvm::dbgs() << "  - Updating " << nla << "\n");
+      SmallVector<std::pair<InstanceOp, ExtractionInfo>> newInsts;
+      for (auto &move : moves) {
+        auto inst = move.inst;
+        auto &info = move.info;
+        unsigned numInstPorts = inst.getNumResults();
+        auto &sortedInstanceNLAs = move.sortedInstanceNLAs;
+        auto &instNonlocalAnnos = move.instNonlocalAnnos;
+
+        // Clone the existing instance and remove it from its current parent,
+        // such that we can insert it at its extracted location.
+        auto newInst = inst.cloneAndInsertPorts({});
+        newInst->remove();
+
+        // Ensure that the `inner_sym` of the instance is unique within the
+        // parent module we're extracting it to.
+        if (auto instSym = getInnerSymName(inst)) {
+          auto newName =
+              getModuleNamespace(newParent).newName(instSym.getValue());
+          if (newName != instSym.getValue())
+            newInst.setInnerSymAttr(
+                hw::InnerSymAttr::get(StringAttr::get(&getContext(), newName)));
+        }
 
-        // Find the position of the instance in the NLA path. This is going to
-        // be the position at which we have to modify the NLA.
-        SmallVector<Attribute> nlaPath(nla.getNamepath().begin(),
-                                       nla.getNamepath().end());
-        unsigned nlaIdx = findInstanceInNLA(inst, nla);
+        // Add the moved instance and hook it up to the added ports.
+        ImplicitLocOpBuilder builder(inst.getLoc(), newParentInst);
+        builder.setInsertionPointAfter(newParentInst);
+        builder.insert(newInst);
+        for (unsigned portIdx = 0; portIdx < numInstPorts; ++portIdx) {
+          auto dst = newInst.getResult(portIdx);
+          auto src = newParentInst.getResult(move.portOffset + portIdx);
+          if (newPorts[move.portOffset - numParentPorts + portIdx]
+                  .second.direction == Direction::In)
+            std::swap(src, dst);
+          builder.create<StrictConnectOp>(dst, src);
+        }
 
-        // Handle the case where the instance no longer shows up in the NLA's
-        // path. This usually happens if the instance is extracted into multiple
-        // parents (because the current parent module is multiply instantiated).
-        // In that case NLAs that were specific to one instance may have been
-        // moved when we arrive at the second instance, and the NLA is already
-        // updated.
-        if (nlaIdx >= nlaPath.size()) {
-          LLVM_DEBUG(llvm::dbgs() << "    - Instance no longer in path\n");
-          continue;
+        // Move the wiring prefix from the old to the new instance. We just look
+        // up the prefix for the old instance and if it exists, we remove it and
+        // assign it to the new instance. This has the effect of making the
+        // first new instance we create inherit the wiring prefix, and all
+        // additional new instances (e.g. through multiple instantiation of the
+        // parent) will pick a new prefix.
+        auto oldPrefix = instPrefices.find(inst);
+        if (oldPrefix != instPrefices.end()) {
+          LLVM_DEBUG(llvm::dbgs()
+                     << "  - Reusing prefix `" << oldPrefix->second << "`\n");
+          auto newPrefix = std::move(oldPrefix->second);
+          instPrefices.erase(oldPrefix);
+          instPrefices.insert({newInst, newPrefix});
         }
-        LLVM_DEBUG(llvm::dbgs() << "    - Position " << nlaIdx << "\n");
 
-        // Handle the case where the NLA's path doesn't go through the
-        // instance's new parent module, which happens if the current parent
-        // module is multiply instantiated. In that case, we only move over NLAs
-        // that actually affect the instance through the new parent module.
-        if (nlaIdx > 0) {
-          auto innerRef = nlaPath[nlaIdx - 1].dyn_cast<InnerRefAttr>();
-          if (innerRef &&
-              !(innerRef.getModule() == newParent.moduleNameAttr() &&
-                innerRef.getName() == getInnerSymName(newParentInst))) {
+        // Inherit the old instance's extraction path.
+        extractionPaths.try_emplace(newInst); // (create entry first)
+        auto &extractionPath =
+            (extractionPaths[newInst] = extractionPaths[inst]);
+        extractionPath.push_back(getInnerRefTo(newParentInst));
+        originalInstanceParents.try_emplace(newInst); // (create entry first)
+        originalInstanceParents[newInst] = originalInstanceParents[inst];
+        // Record the Nonlocal annotations that need to be applied to the new
+        // Inst.
+        SmallVector<Annotation> newInstNonlocalAnnos;
+
+        // Update all NLAs that touch the moved instance.
+        for (auto nla : sortedInstanceNLAs) {
+          LLVM_DEBUG(llvm::dbgs() << "  - Updating " << nla << "\n");
+
+          // Find the position of the instance in the NLA path. This is going to
+          // be the position at which we have to modify the NLA.
+          SmallVector<Attribute> nlaPath(nla.getNamepath().begin(),
+                                         nla.getNamepath().end());
+          unsigned nlaIdx = findInstanceInNLA(inst, nla);
+
+          // Handle the case where the instance no longer shows up in the NLA's
+          // path. This usually happens if the instance is extracted into
+          // multiple parents (because the current parent module is multiply
+          // instantiated). In that case NLAs that were specific to one instance
+          // may have been moved when we arrive at the second instance, and the
+          // NLA is already updated.
+          if (nlaIdx >= nlaPath.size()) {
+            LLVM_DEBUG(llvm::dbgs() << "    - Instance no longer in path\n");
+            continue;
+          }
+          LLVM_DEBUG(llvm::dbgs() << "    - Position " << nlaIdx << "\n");
+
+          // Handle the case where the NLA's path doesn't go through the
+          // instance's new parent module, which happens if the current parent
+          // module is multiply instantiated. In that case, we only move over
+          // NLAs that actually affect the instance through the new parent
+          // module.
+          if (nlaIdx > 0) {
+            auto innerRef = nlaPath[nlaIdx - 1].dyn_cast<InnerRefAttr>();
+            if (innerRef &&
+                !(innerRef.getModule() == newParent.moduleNameAttr() &&
+                  innerRef.getName() == getInnerSymName(newParentInst))) {
+              LLVM_DEBUG(llvm::dbgs()
+                         << "    - Ignored since NLA parent " << innerRef
+                         << " does not pass through extraction parent\n");
+              continue;
+            }
+          }
+
+          // There are two interesting cases now:
+          // - If `nlaIdx == 0`, the NLA is rooted at the module the instance
+          //   was located in prior to extraction. This indicates that the NLA
+          //   applies to all instances of that parent module. Since we are
+          //   extracting *out* of that module, we have to create a new NLA
+          //   rooted at the new parent module after extraction.
+          // - If `nlaIdx > 0`, the NLA is rooted further up in the hierarchy
+          //   and we can simply remove the old parent module from the path.
+
+          // Handle the case where we need to come up with a new NLA for this
+          // instance since we've moved it past the module at which the old NLA
+          // was rooted at.
+          if (nlaIdx == 0) {
             LLVM_DEBUG(llvm::dbgs()
-                       << "    - Ignored since NLA parent " << innerRef
-                       << " does not pass through extraction parent\n");
+                       << "    - Re-rooting " << nlaPath[0] << "\n");
+            assert(nlaPath[0].isa<InnerRefAttr>() &&
+                   "head of hierpath must be an InnerRefAttr");
+            nlaPath[0] =
+                InnerRefAttr::get(newParent.moduleNameAttr(),
+                                  nlaPath[0].cast<InnerRefAttr>().getName());
+
+            if (instParentNode->hasOneUse()) {
+              // Simply update the existing NLA since our parent is only
+              // instantiated once, and we therefore are not creating multiple
+              // instances through the extraction.
+              nlaTable.erase(nla);
+              nla.setNamepathAttr(builder.getArrayAttr(nlaPath));
+              for (auto anno : instNonlocalAnnos.lookup(nla))
+                newInstNonlocalAnnos.push_back(anno);
+              nlaTable.addNLA(nla);
+              LLVM_DEBUG(llvm::dbgs() << "    - Modified to " << nla << "\n");
+            } else {
+              // Since we are extracting to multiple parent locations, create a
+              // new NLA for each instantiation site.
+              auto newNla = cloneWithNewNameAndPath(nla, nlaPath);
+              for (auto anno : instNonlocalAnnos.lookup(nla)) {
+                anno.setMember("circt.nonlocal",
+                               FlatSymbolRefAttr::get(newNla.getSymNameAttr()));
+                newInstNonlocalAnnos.push_back(anno);
+              }
+
+              nlaTable.addNLA(newNla);
+              LLVM_DEBUG(llvm::dbgs() << "    - Created " << newNla << "\n");
+              // CAVEAT(fschuiki): This results in annotations in the
+              // subhierarchy below `inst` with the old NLA symbol name, instead
+              // of those annotations duplicated for each of the newly-created
+              // NLAs. This shouldn't come up in our current use cases, but is a
+              // weakness of the current implementation. Instead, we should keep
+              // an NLA replication table that we fill with mappings from old
+              // NLA names to lists of new NLA names. A post-pass would then
+              // traverse the entire subhierarchy and go replicate all
+              // annotations with the old names.
+              inst.emitWarning("extraction of instance `")
+                  << inst.instanceName()
+                  << "` could break non-local annotations rooted at `"
+                  << parent.moduleName() << "`";
+            }
             continue;
           }
-        }
 
-        // There are two interesting cases now:
-        // - If `nlaIdx == 0`, the NLA is rooted at the module the instance was
-        //   located in prior to extraction. This indicates that the NLA applies
-        //   to all instances of that parent module. Since we are extracting
-        //   *out* of that module, we have to create a new NLA rooted at the new
-        //   parent module after extraction.
-        // - If `nlaIdx > 0`, the NLA is rooted further up in the hierarchy and
-        //   we can simply remove the old parent module from the path.
-
-        // Handle the case where we need to come up with a new NLA for this
-        // instance since we've moved it past the module at which the old NLA
-        // was rooted at.
-        if (nlaIdx == 0) {
-          LLVM_DEBUG(llvm::dbgs() << "    - Re-rooting " << nlaPath[0] << "\n");
-          assert(nlaPath[0].isa<InnerRefAttr>() &&
-                 "head of hierpath must be an InnerRefAttr");
-          nlaPath[0] =
-              InnerRefAttr::get(newParent.moduleNameAttr(),
-                                nlaPath[0].cast<InnerRefAttr>().getName());
-
-          if (instParentNode->hasOneUse()) {
-            // Simply update the existing NLA since our parent is only
-            // instantiated once, and we therefore are not creating multiple
-            // instances through the extraction.
-            nlaTable.erase(nla);
-            nla.setNamepathAttr(builder.getArrayAttr(nlaPath));
-            for (auto anno : instNonlocalAnnos.lookup(nla))
+          // In the subequent code block we are going to remove one element from
+          // the NLA path, corresponding to the fact that the extracted instance
+          // has moved up in the hierarchy by one level. Removing that element
+          // may leave the NLA in a degenerate state, with only a single element
+          // in its path. If that is the case we have to convert the NLA into a
+          // regular local annotation.
+          if (nlaPath.size() == 2) {
+            for (auto anno : instNonlocalAnnos.lookup(nla)) {
+              anno.removeMember("circt.nonlocal");
               newInstNonlocalAnnos.push_back(anno);
-            nlaTable.addNLA(nla);
-            LLVM_DEBUG(llvm::dbgs() << "    - Modified to " << nla << "\n");
-          } else {
-            // Since we are extracting to multiple parent locations, create a
-            // new NLA for each instantiation site.
+              LLVM_DEBUG(llvm::dbgs() << "    - Converted to local "
+                                      << anno.getDict() << "\n");
+            }
+            nlaTable.erase(nla);
+            nlasToRemove.insert(nla);
+            continue;
+          }
+
+          // At this point the NLA looks like `NewParent::X, OldParent::BB`, and
+          // the `nlaIdx` points at `OldParent::BB`. To make our lives easier,
+          // since we know that `nlaIdx` is a `InnerRefAttr`, we'll modify
+          // `OldParent::BB` to be `NewParent::BB` and delete `NewParent::X`.
+          StringAttr parentName =
+              nlaPath[nlaIdx - 1].cast<InnerRefAttr>().getModule();
+          Attribute newRef;
+          if (nlaPath[nlaIdx].isa<InnerRefAttr>())
+            newRef = InnerRefAttr::get(parentName, getInnerSymName(newInst));
+          else
+            newRef = FlatSymbolRefAttr::get(parentName);
+          LLVM_DEBUG(llvm::dbgs()
+                     << "    - Replacing " << nlaPath[nlaIdx - 1] << " and "
+                     << nlaPath[nlaIdx] << " with " << newRef << "\n");
+          nlaPath[nlaIdx] = newRef;
+          nlaPath.erase(nlaPath.begin() + nlaIdx - 1);
+
+          if (newRef.isa<FlatSymbolRefAttr>()) {
+            // Since the original NLA ended at the instance's parent module,
+            // there is no guarantee that the instance is the sole user of the
+            // NLA (as opposed to the original NLA explicitly naming the
+            // instance). Create a new NLA.
             auto newNla = cloneWithNewNameAndPath(nla, nlaPath);
+            nlaTable.addNLA(newNla);
+            LLVM_DEBUG(llvm::dbgs() << "    - Created " << newNla << "\n");
             for (auto anno : instNonlocalAnnos.lookup(nla)) {
               anno.setMember("circt.nonlocal",
                              FlatSymbolRefAttr::get(newNla.getSymNameAttr()));
               newInstNonlocalAnnos.push_back(anno);
             }
-
-            nlaTable.addNLA(newNla);
-            LLVM_DEBUG(llvm::dbgs() << "    - Created " << newNla << "\n");
-            // CAVEAT(fschuiki): This results in annotations in the subhierarchy
-            // below `inst` with the old NLA symbol name, instead of those
-            // annotations duplicated for each of the newly-created NLAs. This
-            // shouldn't come up in our current use cases, but is a weakness of
-            // the current implementation. Instead, we should keep an NLA
-            // replication table that we fill with mappings from old NLA names
-            // to lists of new NLA names. A post-pass would then traverse the
-            // entire subhierarchy and go replicate all annotations with the old
-            // names.
-            inst.emitWarning("extraction of instance `")
-                << inst.instanceName()
-                << "` could break non-local annotations rooted at `"
-                << parent.moduleName() << "`";
+          } else {
+            nlaTable.setNamepath(nla, builder.getArrayAttr(nlaPath));
+            LLVM_DEBUG(llvm::dbgs() << "    - Modified to " << nla << "\n");
+            for (auto anno : instNonlocalAnnos.lookup(nla))
+              newInstNonlocalAnnos.push_back(anno);
           }
-          continue;
-        }
 
-        // In the subequent code block we are going to remove one element from
-        // the NLA path, corresponding to the fact that the extracted instance
-        // has moved up in the hierarchy by one level. Removing that element may
-        // leave the NLA in a degenerate state, with only a single element in
-        // its path. If that is the case we have to convert the NLA into a
-        // regular local annotation.
-        if (nlaPath.size() == 2) {
-          for (auto anno : instNonlocalAnnos.lookup(nla)) {
-            anno.removeMember("circt.nonlocal");
-            newInstNonlocalAnnos.push_back(anno);
-            LLVM_DEBUG(llvm::dbgs() << "    - Converted to local "
-                                    << anno.getDict() << "\n");
-          }
-          nlaTable.erase(nla);
-          nlasToRemove.insert(nla);
+          // No update to NLATable required, since it will be deleted from the
+          // parent, and it should already exist in the new parent module.
           continue;
         }
-
-        // At this point the NLA looks like `NewParent::X, OldParent::BB`, and
-        // the `nlaIdx` points at `OldParent::BB`. To make our lives easier,
-        // since we know that `nlaIdx` is a `InnerRefAttr`, we'll modify
-        // `OldParent::BB` to be `NewParent::BB` and delete `NewParent::X`.
-        StringAttr parentName =
-            nlaPath[nlaIdx - 1].cast<InnerRefAttr>().getModule();
-        Attribute newRef;
-        if (nlaPath[nlaIdx].isa<InnerRefAttr>())
-          newRef = InnerRefAttr::get(parentName, getInnerSymName(newInst));
-        else
-          newRef = FlatSymbolRefAttr::get(parentName);
-        LLVM_DEBUG(llvm::dbgs()
-                   << "    - Replacing " << nlaPath[nlaIdx - 1] << " and "
-                   << nlaPath[nlaIdx] << " with " << newRef << "\n");
-        nlaPath[nlaIdx] = newRef;
-        nlaPath.erase(nlaPath.begin() + nlaIdx - 1);
-
-        if (newRef.isa<FlatSymbolRefAttr>()) {
-          // Since the original NLA ended at the instance's parent module, there
-          // is no guarantee that the instance is the sole user of the NLA (as
-          // opposed to the original NLA explicitly naming the instance). Create
-          // a new NLA.
-          auto newNla = cloneWithNewNameAndPath(nla, nlaPath);
-          nlaTable.addNLA(newNla);
-          LLVM_DEBUG(llvm::dbgs() << "    - Created " << newNla << "\n");
-          for (auto anno : instNonlocalAnnos.lookup(nla)) {
-            anno.setMember("circt.nonlocal",
-                           FlatSymbolRefAttr::get(newNla.getSymNameAttr()));
-            newInstNonlocalAnnos.push_back(anno);
-          }
-        } else {
-          nla.setNamepathAttr(builder.getArrayAttr(nlaPath));
-          LLVM_DEBUG(llvm::dbgs() << "    - Modified to " << nla << "\n");
-          for (auto anno : instNonlocalAnnos.lookup(nla))
-            newInstNonlocalAnnos.push_back(anno);
-        }
-
-        // No update to NLATable required, since it will be deleted from the
-        // parent, and it should already exist in the new parent module.
-        continue;
+        AnnotationSet newInstAnnos(newInst);
+        newInstAnnos.addAnnotations(newInstNonlocalAnnos);
+        newInstAnnos.applyToOperation(newInst);
+
+        // Collect the moved instance for the extraction worklist such that it
+        // bubbled up further if needed.
+        newInsts.push_back({newInst, info});
+        LLVM_DEBUG(llvm::dbgs() << "  - Updated to " << newInst << "\n");
       }
-      AnnotationSet newInstAnnos(newInst);
-      newInstAnnos.addAnnotations(newInstNonlocalAnnos);
-      newInstAnnos.applyToOperation(newInst);
-
-      // Add the moved instance to the extraction worklist such that it gets
-      // bubbled up further if needed.
-      extractionWorklist.push_back({newInst, info});
-      LLVM_DEBUG(llvm::dbgs() << "  - Updated to " << newInst << "\n");
+      // Add the moved instances to the worklist such that the first one is
+      // picked next, as the instances of one batch are moved together again.
+      extractionWorklist.append(newInsts.rbegin(), newInsts.rend());
 
       // Keep instance graph up-to-date.
       instanceGraph->replaceInstance(oldParentInst, newParentInst);
       oldParentInst.erase();
     }
-    // Remove the obsolete NLAs from the instance of the parent module, since
-    // the extracted instance no longer resides in that module and any NLAs to
-    // it no longer go through the parent module.
-    nlaTable.removeNLAsfromModule(instanceNLAs, parent.getNameAttr());
 
-    // Clean up the original instance.
-    inst.erase();
+    for (auto &move : moves) {
+      // Remove the obsolete NLAs from the instance of the parent module, since
+      // the extracted instance no longer resides in that module and any NLAs
+      // to it no longer go through the parent module.
+      nlaTable.removeNLAsfromModule(move.instanceNLAs, parent.getNameAttr());
+
+      // Clean up the original instance.
+      move.inst.erase();
+    }
     newPorts.clear();
   }
 
@@ -918,10 +975,9 @@ void ExtractInstancesPass::groupInstances() {
         // CAVEAT: This is likely to conflict with additional users of `nla`
         // that have nothing to do with this instance. Might need some NLATable
         // machinery at some point to allow for these things to be updated.
-        nla.setNamepathAttr(builder.getArrayAttr(nlaPath));
+        // This also adds the NLA to the wrapper module.
+        nlaTable.setNamepath(nla, builder.getArrayAttr(nlaPath));
         LLVM_DEBUG(llvm::dbgs() << "    - Modified to " << nla << "\n");
-        // Add the NLA to the wrapper module.
-        nlaTable.addNLAtoModule(nla, wrapperNameAttr);
       }
     }
 
@@ -1055,6 +1111,9 @@ void ExtractInstancesPass::createTraceFiles() {
 // Pass Creation
 //===----------------------------------------------------------------------===//
 
-std::unique_ptr<mlir::Pass> circt::firrtl::createExtractInstancesPass() {
-  return std::make_unique<ExtractInstancesPass>();
+std::unique_ptr<mlir::Pass>
+circt::firrtl::createExtractInstancesPass(bool batched) {
+  auto pass = std::make_unique<ExtractInstancesPass>();
+  pass->batched = batched;
+  return pass;
 }
@@ -23,6 +23,7 @@
 #include "circt/Dialect/HW/HWOps.h"
 #include "circt/Dialect/SV/SVOps.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
@@ -733,6 +734,10 @@ private:
   /// A store of the YAML representation of interfaces.
   DenseMap<Attribute, sv::InterfaceOp> interfaceMap;
 
+  /// Create the body of an interface from the elements collected for it.
+  void populateInterface(sv::InterfaceOp iface,
+                         const InterfaceElemsBuilder &ifaceBuilder);
+
   /// Returns an operation's `inner_sym`, adding one if necessary.
   StringAttr getOrAddInnerSym(Operation *op);
 
@@ -1521,6 +1526,53 @@ HWModuleLike GrandCentralPass::getEnclosingModule(Value value,
   return op->getParentOfType<HWModuleLike>();
 }
 
+/// Create the signals and verbatim instantiations of an interface from the
+/// elements collected for it. This only touches the body of the interface.
+void GrandCentralPass::populateInterface(
+    sv::InterfaceOp iface, const InterfaceElemsBuilder &ifaceBuilder) {
+  auto builder = OpBuilder::atBlockEnd(iface.getBodyBlock());
+  for (auto elem : ifaceBuilder.elementsList) {
+    auto uloc = builder.getUnknownLoc();
+    auto description = elem.description;
+    if (description) {
+      auto descriptionOp = builder.create<sv::VerbatimOp>(
+          uloc, ("// " + cleanupDescription(description.getValue())));
+
+      // If we need to generate a YAML representation of this interface,
+      // then add an attribute indicating that this `sv::VerbatimOp` is
+      // actually a description.
+      if (maybeHierarchyFileYAML)
+        descriptionOp->setAttr("firrtl.grandcentral.yaml.type",
+                               builder.getStringAttr("description"));
+    }
+    if (auto *str = std::get_if<VerbatimType>(&elem.elemType)) {
+      auto instanceOp = builder.create<sv::VerbatimOp>(
+          uloc, str->toStr(elem.elemName.getValue()));
+
+      // If we need to generate a YAML representation of the interface, then
+      // add attirbutes that describe what this `sv::VerbatimOp` is.
+      if (maybeHierarchyFileYAML) {
+        if (str->instantiation)
+          instanceOp->setAttr("firrtl.grandcentral.yaml.type",
+                              builder.getStringAttr("instance"));
+        else
+          instanceOp->setAttr("firrtl.grandcentral.yaml.type",
+                              builder.getStringAttr("unsupported"));
+        instanceOp->setAttr("firrtl.grandcentral.yaml.name", elem.elemName);
+        instanceOp->setAttr("firrtl.grandcentral.yaml.dimensions",
+                            builder.getI32ArrayAttr(str->dimensions));
+        instanceOp->setAttr(
+            "firrtl.grandcentral.yaml.symbol",
+            FlatSymbolRefAttr::get(builder.getContext(), str->str));
+      }
+      continue;
+    }
+
+    auto tpe = std::get<Type>(elem.elemType);
+    builder.create<sv::InterfaceSignalOp>(uloc, elem.elemName.getValue(), tpe);
+  }
+}
+
 /// This method contains the business logic of this pass.
 void GrandCentralPass::runOnOperation() {
   LLVM_DEBUG(llvm::dbgs() << "===- Running Grand Central Views/Interface Pass "
@@ -2026,6 +2078,8 @@ void GrandCentralPass::runOnOperation() {
   // then the top-level instantiate interface will be marked for extraction via
   // a SystemVerilog bind.
   SmallVector<sv::InterfaceOp, 2> interfaceVec;
+  SmallVector<std::pair<sv::InterfaceOp, InterfaceElemsBuilder>, 0>
+      interfaceBodies;
   SmallDenseMap<FModuleLike, SmallVector<InterfaceElemsBuilder>>
       companionToInterfaceMap;
   auto compareInterfaceSignal = [&](InterfaceElemsBuilder &lhs,
@@ -2141,54 +2195,9 @@ void GrandCentralPass::runOnOperation() {
                            &getContext(), getOutputDirectory().getValue(),
                            /*excludeFromFileList=*/true));
       iface.setCommentAttr(builder.getStringAttr("VCS coverage exclude_file"));
-      builder.setInsertionPointToEnd(
-          cast<sv::InterfaceOp>(iface).getBodyBlock());
       interfaceMap[FlatSymbolRefAttr::get(builder.getContext(),
                                           ifaceBuilder.iFaceName)] = iface;
-      for (auto elem : ifaceBuilder.elementsList) {
-
-        auto uloc = builder.getUnknownLoc();
-
-        auto description = elem.description;
-
-        if (description) {
-          auto descriptionOp = builder.create<sv::VerbatimOp>(
-              uloc, ("// " + cleanupDescription(description.getValue())));
-
-          // If we need to generate a YAML representation of this interface,
-          // then add an attribute indicating that this `sv::VerbatimOp` is
-          // actually a description.
-          if (maybeHierarchyFileYAML)
-            descriptionOp->setAttr("firrtl.grandcentral.yaml.type",
-                                   builder.getStringAttr("description"));
-        }
-        if (auto *str = std::get_if<VerbatimType>(&elem.elemType)) {
-          auto instanceOp = builder.create<sv::VerbatimOp>(
-              uloc, str->toStr(elem.elemName.getValue()));
-
-          // If we need to generate a YAML representation of the interface, then
-          // add attirbutes that describe what this `sv::VerbatimOp` is.
-          if (maybeHierarchyFileYAML) {
-            if (str->instantiation)
-              instanceOp->setAttr("firrtl.grandcentral.yaml.type",
-                                  builder.getStringAttr("instance"));
-            else
-              instanceOp->setAttr("firrtl.grandcentral.yaml.type",
-                                  builder.getStringAttr("unsupported"));
-            instanceOp->setAttr("firrtl.grandcentral.yaml.name", elem.elemName);
-            instanceOp->setAttr("firrtl.grandcentral.yaml.dimensions",
-                                builder.getI32ArrayAttr(str->dimensions));
-            instanceOp->setAttr(
-                "firrtl.grandcentral.yaml.symbol",
-                FlatSymbolRefAttr::get(builder.getContext(), str->str));
-          }
-          continue;
-        }
-
-        auto tpe = std::get<Type>(elem.elemType);
-        builder.create<sv::InterfaceSignalOp>(uloc, elem.elemName.getValue(),
-                                              tpe);
-      }
+      interfaceBodies.emplace_back(iface, ifaceBuilder);
     }
 
     ++numViews;
@@ -2215,6 +2224,12 @@ void GrandCentralPass::runOnOperation() {
       continue;
   }
 
+  // The interfaces were created empty above. Their bodies only depend on the
+  // elements collected for each of them, so populate them in parallel.
+  mlir::parallelForEach(&getContext(), interfaceBodies, [&](auto &body) {
+    populateInterface(body.first, body.second);
+  });
+
   // If a `GrandCentralHierarchyFileAnnotation` was passed in, generate a YAML
   // representation of the interfaces that we produced with the filename that
   // that annotation provided.
@@ -113,6 +113,10 @@ struct PortWiring {
   Literal literal;
   /// The non-local anchor further specifying where to connect.
   HierPathOp nla;
+  /// The full instance paths to the tapped object, i.e. `prefices` with the
+  /// instances of the NLA path appended. Resolved once per black box and
+  /// shared by all of its implementations.
+  SmallVector<SmallVector<HWInstanceLike>, 1> targetPaths;
   /// True if the tapped target is known to be zero-width.  This indicates that
   /// the port should not be wired.  The port will be removed by LowerToHW.
   bool zeroWidth = false;
@@ -912,6 +916,10 @@ class GrandCentralTapsPass : public GrandCentralTapsBase<GrandCentralTapsPass> {
   /// Cached module namespaces.
   DenseMap<Operation *, ModuleNamespace> moduleNamespaces;
 
+  /// Cached inner references to the instances of the hierarchical names. Taps
+  /// commonly share a prefix, which is only symbolized once this way.
+  DenseMap<Operation *, InnerRefAttr> instanceRefs;
+
   /// The circuit symbol table, used to look up NLAs.
   SymbolTable *circuitSymbols;
 };
@@ -921,7 +929,9 @@ void GrandCentralTapsPass::runOnOperation() {
   LLVM_DEBUG(llvm::dbgs() << "Running the GCT Data Taps pass\n");
   SymbolTable symtbl(circuitOp);
   circuitSymbols = &symtbl;
-  InnerSymbolTableCollection innerSymTblCol(circuitOp);
+  // The inner symbol tables are only needed for the few modules instance paths
+  // are resolved in, so build them on demand.
+  InnerSymbolTableCollection innerSymTblCol;
   InnerRefNamespace innerRefNS{symtbl, innerSymTblCol};
 
   // Here's a rough idea of what the Scala code is doing:
@@ -1067,9 +1077,29 @@ void GrandCentralTapsPass::runOnOperation() {
       processAnnotation(portAnno, blackBox, instancePaths);
     }
 
+    // Resolve the full instance path to every tapped object up front. These
+    // do not depend on the data tap instance, so they are shared by all of
+    // the implementations below. The instances of an NLA path are only
+    // looked up once per port rather than once per prefix and instance.
+    for (auto &wiring : portWiring) {
+      if (wiring.zeroWidth || wiring.literal)
+        continue;
+      SmallVector<HWInstanceLike> nlaPath;
+      if (wiring.nla)
+        for (auto segment : wiring.nla.getNamepath().getValue().drop_back())
+          if (auto ref = segment.dyn_cast<InnerRefAttr>())
+            nlaPath.push_back(cast<HWInstanceLike>(innerRefNS.lookupOp(ref)));
+      wiring.targetPaths.reserve(wiring.prefices.size());
+      for (auto prefix : wiring.prefices) {
+        auto &targetPath = wiring.targetPaths.emplace_back(prefix.begin(),
+                                                           prefix.end());
+        targetPath.append(nlaPath.begin(), nlaPath.end());
+      }
+    }
+
     LLVM_DEBUG({
       llvm::dbgs() << "- Wire up as follows:\n";
-      for (auto wiring : portWiring) {
+      for (auto &wiring : portWiring) {
         llvm::dbgs() << "- Port " << wiring.portNum << ":\n";
         for (auto path : wiring.prefices) {
           llvm::dbgs() << "  - " << path;
@@ -1129,7 +1159,7 @@ void GrandCentralTapsPass::runOnOperation() {
       builder.setInsertionPointToEnd(impl.getBodyBlock());
 
       // Connect the output ports to the appropriate tapped object.
-      for (auto port : portWiring) {
+      for (auto &port : portWiring) {
         LLVM_DEBUG(llvm::dbgs() << "- Wiring up port " << port.portNum << "\n");
 
         // Ignore the port if it is marked for deletion.
@@ -1158,20 +1188,8 @@ void GrandCentralTapsPass::runOnOperation() {
         // Determine the shortest hierarchical prefix from this black box
         // instance to the tapped object.
         Optional<SmallVector<HWInstanceLike>> shortestPrefix;
-        for (auto prefix : port.prefices) {
-
-          // Append the NLA path to the instance graph-determined path.
-          SmallVector<HWInstanceLike> prefixWithNLA(prefix.begin(),
-                                                    prefix.end());
-          if (port.nla) {
-            for (auto segment : port.nla.getNamepath().getValue().drop_back())
-              if (auto ref = segment.dyn_cast<InnerRefAttr>()) {
-                prefixWithNLA.push_back(
-                    cast<HWInstanceLike>(innerRefNS.lookupOp(ref)));
-              }
-          }
-
-          auto relative = stripCommonPrefix(prefixWithNLA, path);
+        for (auto &targetPath : port.targetPaths) {
+          auto relative = stripCommonPrefix(targetPath, path);
           if (!shortestPrefix || relative.size() < shortestPrefix->size())
             shortestPrefix.emplace(relative.begin(), relative.end());
         }
@@ -1205,8 +1223,12 @@ void GrandCentralTapsPass::runOnOperation() {
         // Concatenate the prefix into a proper full hierarchical name.
         addSymbol(
             FlatSymbolRefAttr::get(SymbolTable::getSymbolName(rootModule)));
-        for (auto inst : *shortestPrefix)
-          addSymbol(getInnerRefTo(inst));
+        for (auto inst : *shortestPrefix) {
+          auto &ref = instanceRefs[inst];
+          if (!ref)
+            ref = getInnerRefTo(inst);
+          addSymbol(ref);
+        }
         FIRRTLBaseType tpe;
         if (port.target.getOp()) {
           Attribute leaf;
@@ -18,12 +18,17 @@
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Support/APInt.h"
+#include "circt/Support/ParallelSchedule.h"
+#include "circt/Support/TaskTrace.h"
 #include "mlir/IR/Threading.h"
 #include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ScopedPrinter.h"
 
+#include <atomic>
+
 using namespace circt;
 using namespace firrtl;
 
@@ -188,7 +193,10 @@ namespace {
 struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
 
   void runOnOperation() override;
-  void rewriteModuleBody(FModuleOp module);
+
+  /// Replace the values of a module found to be constant, and erase the ops
+  /// that become dead. Returns true if the module was changed.
+  bool rewriteModuleBody(FModuleOp module);
 
   /// Returns true if the given block is executable.
   bool isBlockExecutable(Block *block) const {
@@ -209,7 +217,7 @@ struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
         logger.getOStream() << "Setting overdefined : (" << value << ")\n";
       });
       entry.markOverdefined();
-      changedLatticeValueWorklist.push_back(value);
+      changedLatticeValueWorklist.insert(value);
     }
   }
 
@@ -222,7 +230,7 @@ struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
         logger.getOStream() << "Setting unwritten : (" << value << ")\n";
       });
       entry.markUnwritten();
-      changedLatticeValueWorklist.push_back(value);
+      changedLatticeValueWorklist.insert(value);
     }
   }
 
@@ -240,7 +248,7 @@ struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
         logger.getOStream()
             << "Changed to " << valueEntry << " : (" << value << ")\n";
       });
-      changedLatticeValueWorklist.push_back(value);
+      changedLatticeValueWorklist.insert(value);
     }
   }
   void mergeLatticeValue(Value value, LatticeValue source) {
@@ -275,7 +283,7 @@ struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
     // If we've changed this value then revisit all the users.
     auto &valueEntry = latticeValues[value];
     if (valueEntry != source) {
-      changedLatticeValueWorklist.push_back(value);
+      changedLatticeValueWorklist.insert(value);
       valueEntry = source;
     }
   }
@@ -313,8 +321,11 @@ private:
   SmallPtrSet<Block *, 16> executableBlocks;
 
   /// A worklist of values whose LatticeValue recently changed, indicating the
-  /// users need to be reprocessed.
-  SmallVector<Value, 64> changedLatticeValueWorklist;
+  /// users need to be reprocessed. A value that changes again before it is
+  /// popped is kept only once, since its users are revisited with its latest
+  /// lattice value anyway.
+  llvm::SetVector<Value, SmallVector<Value, 64>, DenseSet<Value>>
+      changedLatticeValueWorklist;
 
   /// This keeps track of users the instance results that correspond to output
   /// ports.
@@ -354,10 +365,26 @@ void IMConstPropPass::runOnOperation() {
     }
   }
 
-  // Rewrite any constants in the modules.
-  mlir::parallelForEach(circuit.getContext(),
-                        circuit.getBodyBlock()->getOps<FModuleOp>(),
-                        [&](auto op) { rewriteModuleBody(op); });
+  // Rewrite any constants in the modules, largest first.
+  std::atomic<bool> anyChanged = false;
+  SmallVector<FModuleOp> modules(circuit.getBodyBlock()->getOps<FModuleOp>());
+  sortByEstimatedWork<FModuleOp>(circuit.getContext(), modules);
+  mlir::parallelForEach(circuit.getContext(), modules,
+                        [&](auto op) {
+                          TaskTraceScope trace("firrtl-imconstprop", [&] {
+                            return op.getName().str();
+                          });
+                          if (rewriteModuleBody(op))
+                            anyChanged = true;
+                        });
+
+  // The pass never adds or removes instances. If it did not change anything
+  // at all, which is common once the pipeline reaches its fixpoint, every
+  // analysis stays valid for the next iteration of the pipeline.
+  if (!anyChanged)
+    markAllAnalysesPreserved();
+  else
+    markAnalysesPreserved<InstanceGraph>();
 
   // Clean up our state for next time.
   instanceGraph = nullptr;
@@ -733,11 +760,13 @@ void IMConstPropPass::visitOperation(Operation *op) {
   }
 }
 
-void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
+bool IMConstPropPass::rewriteModuleBody(FModuleOp module) {
   auto *body = module.getBodyBlock();
   // If a module is unreachable, just ignore it.
   if (!executableBlocks.count(body))
-    return;
+    return false;
+
+  bool changed = false;
 
   auto builder = OpBuilder::atBlockBegin(body);
 
@@ -747,8 +776,8 @@ void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
     auto constIt = constPool.find({constantValue, type});
     if (constIt != constPool.end()) {
       auto *cst = constIt->second;
-      // Add location to the constant
-      cst->setLoc(builder.getFusedLoc(cst->getLoc(), loc));
+      // Add location to the constant, of which many operations may share one.
+      cst->setLoc(fuseLocs(builder.getContext(), {cst->getLoc(), loc}));
       return cst->getResult(0);
     }
     auto savedIP = builder.saveInsertionPoint();
@@ -758,6 +787,7 @@ void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
     builder.restoreInsertionPoint(savedIP);
     assert(cst && "all FIRRTL constants can be materialized");
     constPool.insert({{constantValue, type}, cst});
+    changed = true;
     return cst->getResult(0);
   };
 
@@ -778,9 +808,12 @@ void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
 
     // Replace all uses of this value with the constant, unless this is the
     // destination of a connect.  We leave those alone to avoid upsetting flow.
-    value.replaceUsesWithIf(cstValue, [](OpOperand &operand) {
-      return !isa<FConnectLike>(operand.getOwner()) ||
-             operand.getOperandNumber() != 0;
+    value.replaceUsesWithIf(cstValue, [&](OpOperand &operand) {
+      if (isa<FConnectLike>(operand.getOwner()) &&
+          operand.getOperandNumber() == 0)
+        return false;
+      changed = true;
+      return true;
     });
     return true;
   };
@@ -802,6 +835,7 @@ void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
         if (isDeletableWireOrReg(destOp) && !isOverdefined(connect.getDest())) {
           connect.erase();
           ++numErasedOp;
+          changed = true;
         }
       }
       continue;
@@ -817,6 +851,7 @@ void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
         (wouldOpBeTriviallyDead(&op) || isDeletableWireOrReg(&op))) {
       LLVM_DEBUG({ logger.getOStream() << "Trivially dead : " << op << "\n"; });
       op.erase();
+      changed = true;
       continue;
     }
 
@@ -839,9 +874,11 @@ void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
       LLVM_DEBUG({ logger.getOStream() << "Made dead : " << op << "\n"; });
       op.erase();
       ++numErasedOp;
+      changed = true;
       continue;
     }
   }
+  return changed;
 }
 
 std::unique_ptr<mlir::Pass> circt::firrtl::createIMConstPropPass() {
@@ -9,6 +9,7 @@
 #include "PassDetails.h"
 #include "circt/Dialect/FIRRTL/FIRRTLInstanceGraph.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
+#include "circt/Support/ParallelSchedule.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
 #include "mlir/IR/Threading.h"
 #include "llvm/ADT/BitVector.h"
@@ -247,9 +248,10 @@ void IMDeadCodeElimPass::runOnOperation() {
   for (auto module : circuit.getBodyBlock()->getOps<FModuleOp>())
     rewriteModuleSignature(module);
 
-  // Rewrite module bodies parallelly.
-  mlir::parallelForEach(circuit.getContext(),
-                        circuit.getBodyBlock()->getOps<FModuleOp>(),
+  // Rewrite module bodies parallelly, largest first.
+  SmallVector<FModuleOp> bodies(circuit.getBodyBlock()->getOps<FModuleOp>());
+  sortByEstimatedWork<FModuleOp>(circuit.getContext(), bodies);
+  mlir::parallelForEach(circuit.getContext(), bodies,
                         [&](auto op) { rewriteModuleBody(op); });
 
   // Erase empty modules. To erase empty modules transitively, it is necessary
@@ -264,6 +266,10 @@ void IMDeadCodeElimPass::runOnOperation() {
 
   for (auto module : modules)
     eraseEmptyModule(module);
+
+  // The instance graph was kept up to date as instances and modules were
+  // replaced and erased.
+  markAnalysesPreserved<InstanceGraph>();
 }
 
 void IMDeadCodeElimPass::visitValue(Value value) {
@@ -279,10 +285,14 @@ void IMDeadCodeElimPass::visitValue(Value value) {
     auto portDirection = module.getPortDirection(blockArg.getArgNumber());
     // If the port is input, it's necessary to mark corresponding input ports of
     // instances as alive. We don't have to propagate the liveness of output
-    // ports.
-    if (portDirection == Direction::In)
-      for (auto userOfResultPort : resultPortToInstanceResultMapping[blockArg])
-        markAlive(userOfResultPort);
+    // ports. Look the port up without inserting into the mapping, such that
+    // ports of uninstantiated modules don't grow it.
+    if (portDirection == Direction::In) {
+      auto it = resultPortToInstanceResultMapping.find(blockArg);
+      if (it != resultPortToInstanceResultMapping.end())
+        for (auto userOfResultPort : it->second)
+          markAlive(userOfResultPort);
+    }
     return;
   }
 
@@ -393,10 +403,12 @@ void IMDeadCodeElimPass::rewriteModuleSignature(FModuleOp module) {
     // If the port is known alive, then we can't delete it except for write-only
     // output ports.
     if (isKnownAlive(argument)) {
+      auto it = resultPortToInstanceResultMapping.find(argument);
       bool deadOutputPortAtAnyInstantiation =
           module.getPortDirection(index) == Direction::Out &&
-          llvm::all_of(resultPortToInstanceResultMapping[argument],
-                       [&](Value result) { return isAssumedDead(result); });
+          (it == resultPortToInstanceResultMapping.end() ||
+           llvm::all_of(it->second,
+                        [&](Value result) { return isAssumedDead(result); }));
 
       if (!deadOutputPortAtAnyInstantiation)
         continue;
@@ -521,6 +533,8 @@ void IMDeadCodeElimPass::eraseEmptyModule(FModuleOp module) {
     use->erase();
     instance.erase();
   }
+  // The records were erased directly, drop the traversals they are part of.
+  instanceGraph->invalidateTraversals();
 
   // If there is an instance with a symbol, we don't delete the module itself.
   if (!instancesWithSymbols.empty()) {
@@ -20,6 +20,7 @@
 #include "circt/Support/FieldRef.h"
 #include "mlir/IR/Dominance.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/EquivalenceClasses.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/TinyPtrVector.h"
@@ -420,11 +421,14 @@ struct InferResetsPass : public InferResetsBase<InferResetsPass> {
   // Reset type inference
 
   void traceResets(CircuitOp circuit);
-  void traceResets(InstanceOp inst);
-  void traceResets(Value dst, Value src, Location loc);
-  void traceResets(Value value);
+  void traceResets(FModuleOp module, SmallVectorImpl<ResetDrive> &drives);
+  void traceResets(InstanceOp inst, SmallVectorImpl<ResetDrive> &drives);
+  void traceResets(Value dst, Value src, Location loc,
+                   SmallVectorImpl<ResetDrive> &drives);
   void traceResets(Type dstType, Value dst, unsigned dstID, Type srcType,
-                   Value src, unsigned srcID, Location loc);
+                   Value src, unsigned srcID, Location loc,
+                   SmallVectorImpl<ResetDrive> &drives);
+  void recordResetDrive(const ResetDrive &drive);
 
   LogicalResult inferAndUpdateResets();
   FailureOr<ResetKind> inferReset(ResetNetwork net);
@@ -731,24 +735,42 @@ static bool typeContainsReset(FIRRTLType type) {
 void InferResetsPass::traceResets(CircuitOp circuit) {
   LLVM_DEBUG(
       llvm::dbgs() << "\n===----- Tracing uninferred resets -----===\n\n");
-  circuit.walk([&](Operation *op) {
+
+  // Finding the drives involving resets only looks at the module itself and
+  // the ports of instantiated modules, so every module is traced in parallel.
+  // The drives are then unified into reset networks serially, in the same
+  // order as a walk over the circuit would produce them.
+  SmallVector<FModuleOp> modules(circuit.getBodyBlock()->getOps<FModuleOp>());
+  SmallVector<SmallVector<ResetDrive, 0>> moduleDrives(modules.size());
+  mlir::parallelFor(circuit.getContext(), 0, modules.size(), [&](size_t i) {
+    traceResets(modules[i], moduleDrives[i]);
+  });
+  for (auto &drives : moduleDrives)
+    for (auto &drive : drives)
+      recordResetDrive(drive);
+}
+
+/// Collect the drives involving a `ResetType` in a module, in walk order.
+void InferResetsPass::traceResets(FModuleOp module,
+                                  SmallVectorImpl<ResetDrive> &drives) {
+  module.walk([&](Operation *op) {
     TypeSwitch<Operation *>(op)
         .Case<ConnectOp, StrictConnectOp>([&](auto op) {
-          traceResets(op.getDest(), op.getSrc(), op.getLoc());
+          traceResets(op.getDest(), op.getSrc(), op.getLoc(), drives);
         })
 
-        .Case<InstanceOp>([&](auto op) { traceResets(op); })
+        .Case<InstanceOp>([&](auto op) { traceResets(op, drives); })
         .Case<RefSendOp>([&](auto op) {
           // Trace using base types.
           traceResets(op.getType().getType(), op.getResult(), 0,
                       op.getBase().getType().template cast<FIRRTLBaseType>(),
-                      op.getBase(), 0, op.getLoc());
+                      op.getBase(), 0, op.getLoc(), drives);
         })
         .Case<RefResolveOp>([&](auto op) {
           // Trace using base types.
           traceResets(op.getType(), op.getResult(), 0,
                       op.getRef().getType().template cast<RefType>().getType(),
-                      op.getRef(), 0, op.getLoc());
+                      op.getRef(), 0, op.getLoc(), drives);
         })
 
         .Case<InvalidValueOp>([&](auto op) {
@@ -780,7 +802,7 @@ void InferResetsPass::traceResets(CircuitOp circuit) {
           auto index = op.getFieldIndex();
           traceResets(op.getType(), op.getResult(), 0,
                       bundleType.getElements()[index].type, op.getInput(),
-                      getFieldID(bundleType, index), op.getLoc());
+                      getFieldID(bundleType, index), op.getLoc(), drives);
         })
 
         .Case<SubindexOp, SubaccessOp>([&](auto op) {
@@ -799,14 +821,15 @@ void InferResetsPass::traceResets(CircuitOp circuit) {
               op.getInput().getType().template cast<FVectorType>();
           traceResets(op.getType(), op.getResult(), 0,
                       vectorType.getElementType(), op.getInput(),
-                      getFieldID(vectorType), op.getLoc());
+                      getFieldID(vectorType), op.getLoc(), drives);
         });
   });
 }
 
 /// Trace reset signals through an instance. This essentially associates the
 /// instance's port values with the target module's port values.
-void InferResetsPass::traceResets(InstanceOp inst) {
+void InferResetsPass::traceResets(InstanceOp inst,
+                                  SmallVectorImpl<ResetDrive> &drives) {
   // Lookup the referenced module. Nothing to do if its an extmodule.
   auto module = dyn_cast<FModuleOp>(*instanceGraph->getReferencedModule(inst));
   if (!module)
@@ -821,22 +844,24 @@ void InferResetsPass::traceResets(InstanceOp inst) {
     Value srcPort = it.value();
     if (dir == Direction::Out)
       std::swap(dstPort, srcPort);
-    traceResets(dstPort, srcPort, it.value().getLoc());
+    traceResets(dstPort, srcPort, it.value().getLoc(), drives);
   }
 }
 
 /// Analyze a connect of one (possibly aggregate) value to another.
 /// Each drive involving a `ResetType` is recorded.
-void InferResetsPass::traceResets(Value dst, Value src, Location loc) {
+void InferResetsPass::traceResets(Value dst, Value src, Location loc,
+                                  SmallVectorImpl<ResetDrive> &drives) {
   // Analyze the actual connection.
-  traceResets(dst.getType(), dst, 0, src.getType(), src, 0, loc);
+  traceResets(dst.getType(), dst, 0, src.getType(), src, 0, loc, drives);
 }
 
 /// Analyze a connect of one (possibly aggregate) value to another.
 /// Each drive involving a `ResetType` is recorded.
 void InferResetsPass::traceResets(Type dstType, Value dst, unsigned dstID,
                                   Type srcType, Value src, unsigned srcID,
-                                  Location loc) {
+                                  Location loc,
+                                  SmallVectorImpl<ResetDrive> &drives) {
   if (auto dstBundle = dstType.dyn_cast<BundleType>()) {
     auto srcBundle = srcType.cast<BundleType>();
     for (unsigned dstIdx = 0, e = dstBundle.getNumElements(); dstIdx < e;
@@ -850,11 +875,11 @@ void InferResetsPass::traceResets(Type dstType, Value dst, unsigned dstID,
       if (dstElt.isFlip) {
         traceResets(srcElt.type, src, srcID + getFieldID(srcBundle, *srcIdx),
                     dstElt.type, dst, dstID + getFieldID(dstBundle, dstIdx),
-                    loc);
+                    loc, drives);
       } else {
         traceResets(dstElt.type, dst, dstID + getFieldID(dstBundle, dstIdx),
                     srcElt.type, src, srcID + getFieldID(srcBundle, *srcIdx),
-                    loc);
+                    loc, drives);
       }
     }
     return;
@@ -877,7 +902,7 @@ void InferResetsPass::traceResets(Type dstType, Value dst, unsigned dstID,
     // the field ID and make sure in `updateType` that we handle vectors
     // accordingly.
     traceResets(dstElType, dst, dstID + getFieldID(dstVector), srcElType, src,
-                srcID + getFieldID(srcVector), loc);
+                srcID + getFieldID(srcVector), loc, drives);
     return;
   }
 
@@ -885,7 +910,7 @@ void InferResetsPass::traceResets(Type dstType, Value dst, unsigned dstID,
   if (auto dstRef = dstType.dyn_cast<RefType>()) {
     auto srcRef = srcType.cast<RefType>();
     return traceResets(dstRef.getType(), dst, dstID, srcRef.getType(), src,
-                       srcID, loc);
+                       srcID, loc, drives);
   }
 
   // Handle reset connections.
@@ -898,17 +923,23 @@ void InferResetsPass::traceResets(Type dstType, Value dst, unsigned dstID,
 
   FieldRef dstField(dst, dstID);
   FieldRef srcField(src, srcID);
-  LLVM_DEBUG(llvm::dbgs() << "Visiting driver '" << dstField << "' = '"
-                          << srcField << "' (" << dstType << " = " << srcType
-                          << ")\n");
+  drives.push_back({{dstField, dstBase}, {srcField, srcBase}, loc});
+}
+
+/// Unify the reset networks of the two ends of a drive and keep note of the
+/// drive in the resulting network.
+void InferResetsPass::recordResetDrive(const ResetDrive &drive) {
+  LLVM_DEBUG(llvm::dbgs() << "Visiting driver '" << drive.dst.field << "' = '"
+                          << drive.src.field << "' (" << drive.dst.type
+                          << " = " << drive.src.type << ")\n");
 
   // Determine the leaders for the dst and src reset networks before we make
   // the connection. This will allow us to later detect if dst got merged
   // into src, or src into dst.
   ResetSignal dstLeader =
-      *resetClasses.findLeader(resetClasses.insert({dstField, dstBase}));
+      *resetClasses.findLeader(resetClasses.insert(drive.dst));
   ResetSignal srcLeader =
-      *resetClasses.findLeader(resetClasses.insert({srcField, srcBase}));
+      *resetClasses.findLeader(resetClasses.insert(drive.src));
 
   // Unify the two reset networks.
   ResetSignal unionLeader = *resetClasses.unionSets(dstLeader, srcLeader);
@@ -929,8 +960,7 @@ void InferResetsPass::traceResets(Type dstType, Value dst, unsigned dstID,
 
   // Keep note of this drive so we can point the user at the right location
   // in case something goes wrong.
-  resetDrives[unionLeader].push_back(
-      {{dstField, dstBase}, {srcField, srcBase}, loc});
+  resetDrives[unionLeader].push_back(drive);
 }
 
 //===----------------------------------------------------------------------===//
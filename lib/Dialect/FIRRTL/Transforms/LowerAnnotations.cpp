@@ -26,7 +26,9 @@
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Dialect/HW/HWAttributes.h"
 #include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/Debug.h"
@@ -44,60 +46,80 @@ static ArrayAttr getAnnotationsFrom(Operation *op) {
   return ArrayAttr::get(op->getContext(), {});
 }
 
-/// Construct the annotation array with a new thing appended.
-static ArrayAttr appendArrayAttr(ArrayAttr array, Attribute a) {
-  if (!array)
-    return ArrayAttr::get(a.getContext(), ArrayRef<Attribute>{a});
-  SmallVector<Attribute> old(array.begin(), array.end());
-  old.push_back(a);
-  return ArrayAttr::get(a.getContext(), old);
+/// Build the annotation to attach to a resolved target.  If the target is a
+/// field of an aggregate, the annotation records its field ID.
+static DictionaryAttr buildAnnotation(MLIRContext *context, unsigned fieldIdx,
+                                      ArrayRef<NamedAttribute> anno) {
+  if (!fieldIdx)
+    return DictionaryAttr::get(context, anno);
+  SmallVector<NamedAttribute> annoField(anno.begin(), anno.end());
+  annoField.emplace_back(
+      StringAttr::get(context, "circt.fieldID"),
+      IntegerAttr::get(IntegerType::get(context, 32, IntegerType::Signless),
+                       fieldIdx));
+  return DictionaryAttr::get(context, annoField);
 }
 
-/// Update an ArrayAttribute by replacing one entry.
-static ArrayAttr replaceArrayAttrElement(ArrayAttr array, size_t elem,
-                                         Attribute newVal) {
-  SmallVector<Attribute> old(array.begin(), array.end());
-  old[elem] = newVal;
-  return ArrayAttr::get(array.getContext(), old);
-}
+/// Apply new annotations to resolved targets, in order.  This handles ports,
+/// aggregates, modules, wires, etc.  The annotation arrays of each operation
+/// are rebuilt once, however many annotations are added to it.
+static void
+addAnnotations(ArrayRef<std::pair<AnnoTarget, DictionaryAttr>> annos) {
+  llvm::MapVector<Operation *, SmallVector<Attribute>> opAnnos;
+  llvm::MapVector<Operation *, SmallVector<SmallVector<Attribute>>> portAnnos;
+  for (auto [ref, annotation] : annos) {
+    auto *op = ref.getOp();
+    if (ref.isa<OpAnnoTarget>()) {
+      auto [it, inserted] = opAnnos.insert({op, {}});
+      if (inserted)
+        llvm::append_range(it->second, getAnnotationsFrom(op));
+      it->second.push_back(annotation);
+      continue;
+    }
 
-/// Apply a new annotation to a resolved target.  This handles ports,
-/// aggregates, modules, wires, etc.
-static void addAnnotation(AnnoTarget ref, unsigned fieldIdx,
-                          ArrayRef<NamedAttribute> anno) {
-  auto *context = ref.getOp()->getContext();
-  DictionaryAttr annotation;
-  if (fieldIdx) {
-    SmallVector<NamedAttribute> annoField(anno.begin(), anno.end());
-    annoField.emplace_back(
-        StringAttr::get(context, "circt.fieldID"),
-        IntegerAttr::get(IntegerType::get(context, 32, IntegerType::Signless),
-                         fieldIdx));
-    annotation = DictionaryAttr::get(context, annoField);
-  } else {
-    annotation = DictionaryAttr::get(context, anno);
+    auto [it, inserted] = portAnnos.insert({op, {}});
+    if (inserted) {
+      auto numPorts = getNumPorts(op);
+      it->second.resize(numPorts);
+      auto portAnno = op->getAttrOfType<ArrayAttr>(getPortAnnotationAttrName());
+      if (portAnno && portAnno.size() == numPorts)
+        for (size_t i = 0; i != numPorts; ++i)
+          if (auto annos = portAnno[i].dyn_cast<ArrayAttr>())
+            llvm::append_range(it->second[i], annos);
+    }
+    it->second[ref.cast<PortAnnoTarget>().getPortNo()].push_back(annotation);
   }
 
-  if (ref.isa<OpAnnoTarget>()) {
-    auto newAnno = appendArrayAttr(getAnnotationsFrom(ref.getOp()), annotation);
-    ref.getOp()->setAttr(getAnnotationAttrName(), newAnno);
-    return;
+  for (auto &[op, annos] : opAnnos)
+    op->setAttr(getAnnotationAttrName(),
+                ArrayAttr::get(op->getContext(), annos));
+  for (auto &[op, ports] : portAnnos) {
+    SmallVector<Attribute> portAttrs;
+    portAttrs.reserve(ports.size());
+    for (auto &annos : ports)
+      portAttrs.push_back(ArrayAttr::get(op->getContext(), annos));
+    op->setAttr(getPortAnnotationAttrName(),
+                ArrayAttr::get(op->getContext(), portAttrs));
   }
+}
+
+/// Attach all pending annotations to their targets.  All targets in a module
+/// are updated together, and the modules are updated in parallel.
+static void applyPendingAnnotations(ApplyState &state) {
+  if (state.pendingAnnotations.empty())
+    return;
 
-  auto portRef = ref.cast<PortAnnoTarget>();
-  auto portAnnoRaw = ref.getOp()->getAttr(getPortAnnotationAttrName());
-  ArrayAttr portAnno = portAnnoRaw.dyn_cast_or_null<ArrayAttr>();
-  if (!portAnno || portAnno.size() != getNumPorts(ref.getOp())) {
-    SmallVector<Attribute> emptyPortAttr(
-        getNumPorts(ref.getOp()),
-        ArrayAttr::get(ref.getOp()->getContext(), {}));
-    portAnno = ArrayAttr::get(ref.getOp()->getContext(), emptyPortAttr);
+  llvm::MapVector<Operation *,
+                  SmallVector<std::pair<AnnoTarget, DictionaryAttr>>>
+      byModule;
+  for (auto &pending : state.pendingAnnotations) {
+    Operation *parent = pending.first.getModule();
+    byModule[parent ? parent : pending.first.getOp()].push_back(pending);
   }
-  portAnno = replaceArrayAttrElement(
-      portAnno, portRef.getPortNo(),
-      appendArrayAttr(portAnno[portRef.getPortNo()].dyn_cast<ArrayAttr>(),
-                      annotation));
-  ref.getOp()->setAttr("portAnnotations", portAnno);
+  state.pendingAnnotations.clear();
+
+  mlir::parallelForEach(state.circuit.getContext(), byModule.takeVector(),
+                        [](auto &entry) { addAnnotations(entry.second); });
 }
 
 /// Make an anchor for a non-local annotation.  Use the expanded path to build
@@ -154,21 +176,10 @@ static Optional<AnnoPathValue> noResolve(DictionaryAttr anno,
 }
 
 /// Implementation of standard resolution.  First parses the target path, then
-/// resolves it.
+/// resolves it.  Paths are recorded in the path index of the target cache.
 static Optional<AnnoPathValue> stdResolveImpl(StringRef rawPath,
                                               ApplyState &state) {
-  auto pathStr = canonicalizeTarget(rawPath);
-  StringRef path{pathStr};
-
-  auto tokens = tokenizePath(path);
-  if (!tokens) {
-    mlir::emitError(state.circuit.getLoc())
-        << "Cannot tokenize annotation path " << rawPath;
-    return {};
-  }
-
-  return resolveEntities(*tokens, state.circuit, state.symTbl,
-                         state.targetCaches);
+  return resolvePath(rawPath, state.circuit, state.symTbl, state.targetCaches);
 }
 
 /// (SFC) FIRRTL SingleTargetAnnotation resolver.  Uses the 'target' field of
@@ -231,7 +242,9 @@ static LogicalResult applyWithoutTargetImpl(const AnnoPathValue &target,
           {StringAttr::get(anno.getContext(), "circt.nonlocal"), sym});
     }
   }
-  addAnnotation(target.ref, target.fieldIdx, newAnnoAttrs);
+  state.pendingAnnotations.push_back(
+      {target.ref,
+       buildAnnotation(anno.getContext(), target.fieldIdx, newAnnoAttrs)});
   return success();
 }
 
@@ -282,11 +295,11 @@ static LogicalResult drop(const AnnoPathValue &target, DictionaryAttr anno,
 
 namespace {
 struct AnnoRecord {
-  llvm::function_ref<Optional<AnnoPathValue>(DictionaryAttr, ApplyState &)>
-      resolver;
-  llvm::function_ref<LogicalResult(const AnnoPathValue &, DictionaryAttr,
-                                   ApplyState &)>
-      applier;
+  using Resolver = Optional<AnnoPathValue> (*)(DictionaryAttr, ApplyState &);
+  using Applier = LogicalResult (*)(const AnnoPathValue &, DictionaryAttr,
+                                    ApplyState &);
+  Resolver resolver;
+  Applier applier;
 };
 
 /// Resolution and application of a "firrtl.annotations.NoTargetAnnotation".
@@ -420,6 +433,17 @@ bool firrtl::isAnnoClassLowered(StringRef className) {
   return annotationRecords.count(className);
 }
 
+/// Return true if the applier of `record` does more than attach the annotation
+/// to its target: it adds to the worklist, or inspects and changes the IR.
+/// Everything else only reads the IR while resolving, so runs of such
+/// annotations can be resolved in parallel.
+static bool hasCustomApplier(const AnnoRecord &record) {
+  static const AnnoRecord::Applier customAppliers[] = {
+      applyGCTView,           applyGCTDataTaps, applyGCTMemTaps,
+      applyGCTSignalMappings, applyOMIR,        applyTraceName};
+  return llvm::is_contained(customAppliers, record.applier);
+}
+
 //===----------------------------------------------------------------------===//
 // Pass Infrastructure
 //===----------------------------------------------------------------------===//
@@ -428,7 +452,11 @@ namespace {
 struct LowerAnnotationsPass
     : public LowerFIRRTLAnnotationsBase<LowerAnnotationsPass> {
   void runOnOperation() override;
-  LogicalResult applyAnnotation(DictionaryAttr anno, ApplyState &state);
+  const AnnoRecord *getAnnotationRecord(DictionaryAttr anno,
+                                        ApplyState &state);
+  LogicalResult applyAnnotation(DictionaryAttr anno, const AnnoRecord &record,
+                                Optional<AnnoPathValue> target,
+                                ApplyState &state);
   LogicalResult solveWiringProblems(ApplyState &state);
 
   bool ignoreUnhandledAnno = false;
@@ -437,39 +465,52 @@ struct LowerAnnotationsPass
 };
 } // end anonymous namespace
 
-LogicalResult LowerAnnotationsPass::applyAnnotation(DictionaryAttr anno,
-                                                    ApplyState &state) {
-  LLVM_DEBUG(llvm::dbgs() << "  - anno: " << anno << "\n";);
-
+/// Find the record handling the class of an annotation.  Returns null and
+/// emits an error if the annotation cannot be handled.
+const AnnoRecord *
+LowerAnnotationsPass::getAnnotationRecord(DictionaryAttr anno,
+                                          ApplyState &state) {
   // Lookup the class
   StringRef annoClassVal;
   if (auto annoClass = anno.getNamed("class"))
     annoClassVal = annoClass->getValue().cast<StringAttr>().getValue();
   else if (ignoreClasslessAnno)
     annoClassVal = "circt.missing";
-  else
-    return mlir::emitError(state.circuit.getLoc())
-           << "Annotation without a class: " << anno;
+  else {
+    mlir::emitError(state.circuit.getLoc())
+        << "Annotation without a class: " << anno;
+    return nullptr;
+  }
 
   // See if we handle the class
   auto *record = getAnnotationHandler(annoClassVal, false);
   if (!record) {
     ++numUnhandled;
-    if (!ignoreUnhandledAnno)
-      return mlir::emitError(state.circuit.getLoc())
-             << "Unhandled annotation: " << anno;
+    if (!ignoreUnhandledAnno) {
+      mlir::emitError(state.circuit.getLoc())
+          << "Unhandled annotation: " << anno;
+      return nullptr;
+    }
 
     // Try again, requesting the fallback handler.
     record = getAnnotationHandler(annoClassVal, ignoreUnhandledAnno);
     assert(record);
   }
+  return record;
+}
+
+LogicalResult
+LowerAnnotationsPass::applyAnnotation(DictionaryAttr anno,
+                                      const AnnoRecord &record,
+                                      Optional<AnnoPathValue> target,
+                                      ApplyState &state) {
+  LLVM_DEBUG(llvm::dbgs() << "  - anno: " << anno << "\n";);
 
   // Try to apply the annotation
-  auto target = record->resolver(anno, state);
   if (!target)
     return mlir::emitError(state.circuit.getLoc())
            << "Unable to resolve target of annotation: " << anno;
-  if (record->applier(*target, anno, state).failed())
+  if (record.applier(*target, anno, state).failed())
     return mlir::emitError(state.circuit.getLoc())
            << "Unable to apply annotation: " << anno;
   return success();
@@ -821,11 +862,52 @@ void LowerAnnotationsPass::runOnOperation() {
   InstancePathCache instancePathCache(getAnalysis<InstanceGraph>());
   ApplyState state{circuit, modules, addToWorklist, instancePathCache};
   LLVM_DEBUG(llvm::dbgs() << "Processing annotations:\n");
+
+  // Annotations which are only attached to their targets are collected into a
+  // batch.  The target paths of a batch are resolved in parallel, and then the
+  // annotations are applied in order; only the creation of hierarchical paths
+  // for non-local annotations remains serial.  The batch is applied, and its annotations
+  // attached, before any annotation with a custom applier runs.
+  SmallVector<std::pair<DictionaryAttr, const AnnoRecord *>> batch;
+  auto applyBatch = [&]() {
+    if (batch.empty())
+      return;
+    // Add all target paths of the batch to the path index at once, so that
+    // the resolvers below only look them up.
+    SmallVector<StringRef> paths;
+    for (auto [anno, record] : batch)
+      if (record->resolver == stdResolve || record->resolver == tryResolve)
+        if (auto target = anno.getAs<StringAttr>("target"))
+          paths.push_back(target.getValue());
+    state.targetCaches.resolvePaths(circuit, modules, paths);
+
+    for (auto [anno, record] : batch)
+      if (failed(applyAnnotation(anno, *record, record->resolver(anno, state),
+                                 state)))
+        ++numFailures;
+    batch.clear();
+  };
+
   while (!worklistAttrs.empty()) {
     auto attr = worklistAttrs.pop_back_val();
-    if (applyAnnotation(attr, state).failed())
+    auto *record = getAnnotationRecord(attr, state);
+    if (!record) {
+      ++numFailures;
+      continue;
+    }
+    if (!hasCustomApplier(*record)) {
+      batch.push_back({attr, record});
+      continue;
+    }
+
+    applyBatch();
+    applyPendingAnnotations(state);
+    if (failed(applyAnnotation(attr, *record, record->resolver(attr, state),
+                               state)))
       ++numFailures;
   }
+  applyBatch();
+  applyPendingAnnotations(state);
 
   if (failed(solveWiringProblems(state)))
     ++numFailures;
@@ -18,6 +18,7 @@
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Dialect/HW/HWAttributes.h"
 #include "mlir/IR/Dominance.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/STLFunctionalExtras.h"
@@ -83,6 +84,13 @@ FirMemory getSummary(MemOp op) {
 }
 
 namespace {
+/// The memories of a module which can be lowered, along with their summaries.
+struct ModuleMemories {
+  FModuleOp module;
+  bool shouldDedup;
+  SmallVector<std::pair<MemOp, FirMemory>> memories;
+};
+
 struct LowerMemoryPass : public LowerMemoryBase<LowerMemoryPass> {
 
   /// Get the cached namespace for a module.
@@ -90,7 +98,7 @@ struct LowerMemoryPass : public LowerMemoryBase<LowerMemoryPass> {
     return moduleNamespaces.try_emplace(module, module).first->second;
   }
 
-  SmallVector<PortInfo> getMemoryModulePorts(const FirMemory &mem);
+  const SmallVector<PortInfo> &getMemoryModulePorts(const FirMemory &mem);
   FMemModuleOp emitMemoryModule(MemOp op, const FirMemory &summary,
                                 const SmallVectorImpl<PortInfo> &ports);
   FMemModuleOp getOrCreateMemModule(MemOp op, const FirMemory &summary,
@@ -101,7 +109,7 @@ struct LowerMemoryPass : public LowerMemoryBase<LowerMemoryPass> {
   InstanceOp emitMemoryInstance(MemOp op, FModuleOp module,
                                 const FirMemory &summary);
   void lowerMemory(MemOp mem, const FirMemory &summary, bool shouldDedup);
-  LogicalResult runOnModule(FModuleOp module, bool shouldDedup);
+  LogicalResult collectMemories(ModuleMemories &entry);
   void runOnOperation() override;
 
   /// Cached module namespaces.
@@ -112,11 +120,21 @@ struct LowerMemoryPass : public LowerMemoryBase<LowerMemoryPass> {
   /// The set of all memories seen so far.  This is used to "deduplicate"
   /// memories by emitting modules one module for equivalent memories.
   std::map<FirMemory, FMemModuleOp> memories;
+
+  /// The ports of the memory modules, which only depend on the configuration
+  /// of the memory and are shared by all the memories with that
+  /// configuration.
+  std::map<FirMemory, SmallVector<PortInfo>> memoryPorts;
 };
 } // end anonymous namespace
 
-SmallVector<PortInfo>
+const SmallVector<PortInfo> &
 LowerMemoryPass::getMemoryModulePorts(const FirMemory &mem) {
+  auto [it, inserted] = memoryPorts.try_emplace(mem);
+  auto &ports = it->second;
+  if (!inserted)
+    return ports;
+
   auto *context = &getContext();
 
   // We don't need a single bit mask, it can be combined with enable. Create
@@ -130,7 +148,6 @@ LowerMemoryPass::getMemoryModulePorts(const FirMemory &mem) {
   Location loc = UnknownLoc::get(context);
   AnnotationSet annotations = AnnotationSet(context);
 
-  SmallVector<PortInfo> ports;
   auto addPort = [&](const Twine &name, FIRRTLType type, Direction direction) {
     auto nameAttr = StringAttr::get(context, name);
     ports.push_back(
@@ -213,7 +230,7 @@ LowerMemoryPass::getOrCreateMemModule(MemOp op, const FirMemory &summary,
 void LowerMemoryPass::lowerMemory(MemOp mem, const FirMemory &summary,
                                   bool shouldDedup) {
   auto *context = &getContext();
-  auto ports = getMemoryModulePorts(summary);
+  auto &ports = getMemoryModulePorts(summary);
 
   // Get a non-colliding name for the memory module, and update the summary.
   auto newName = circuitNamespace.newName(mem.getName());
@@ -479,9 +496,11 @@ InstanceOp LowerMemoryPass::emitMemoryInstance(MemOp op, FModuleOp module,
   return inst;
 }
 
-LogicalResult LowerMemoryPass::runOnModule(FModuleOp module, bool shouldDedup) {
-  for (auto op :
-       llvm::make_early_inc_range(module.getBodyBlock()->getOps<MemOp>())) {
+/// Summarize the memories of a module and keep the ones which can be lowered.
+/// This only reads the module, such that modules can be summarized in
+/// parallel.
+LogicalResult LowerMemoryPass::collectMemories(ModuleMemories &entry) {
+  for (auto op : entry.module.getBodyBlock()->getOps<MemOp>()) {
     // Check that the memory has been properly lowered already.
     if (!op.getDataType().isa<UIntType>())
       return op->emitError(
@@ -499,7 +518,7 @@ LogicalResult LowerMemoryPass::runOnModule(FModuleOp module, bool shouldDedup) {
           (summary.numReadPorts <= 1) && summary.dataWidth > 0))
       continue;
 
-    lowerMemory(op, summary, shouldDedup);
+    entry.memories.emplace_back(op, std::move(summary));
   }
   return success();
 }
@@ -515,7 +534,7 @@ void LowerMemoryPass::runOnOperation() {
   // If no module is marked as the DUT, then the top module is the DUT.
   auto *dut = instanceGraph.getTopLevelNode();
   auto it = llvm::find_if(*body, [&](Operation &op) -> bool {
-    return AnnotationSet(&op).hasAnnotation(dutAnnoClass);
+    return AnnotationSet::hasAnnotation(&op, dutAnnoClass);
   });
   if (it != body->end())
     dut = instanceGraph.lookup(&(*it));
@@ -526,18 +545,28 @@ void LowerMemoryPass::runOnOperation() {
     dutModuleSet.insert(node->getModule());
   });
 
+  // We don't dedup memories in the testharness with any other memories.
+  SmallVector<ModuleMemories> modules;
+  for (auto module : body->getOps<FModuleOp>())
+    modules.push_back({module, dutModuleSet.contains(module), {}});
+
+  // Summarizing the memories only reads their own module, but creating the
+  // memory modules updates the circuit, so only the former runs in parallel.
+  if (failed(mlir::failableParallelForEach(
+          &getContext(), modules,
+          [&](ModuleMemories &entry) { return collectMemories(entry); })))
+    return signalPassFailure();
+
   // We iterate the circuit from top-to-bottom to make sure that we get
   // consistent memory names.
-  for (auto module : body->getOps<FModuleOp>()) {
-    // We don't dedup memories in the testharness with any other memories.
-    auto shouldDedup = dutModuleSet.contains(module);
-    if (failed(runOnModule(module, shouldDedup)))
-      return signalPassFailure();
-  }
+  for (auto &entry : modules)
+    for (auto &[op, summary] : entry.memories)
+      lowerMemory(op, summary, entry.shouldDedup);
 
   circuitNamespace.clear();
   symbolTable = nullptr;
   memories.clear();
+  memoryPorts.clear();
 }
 
 std::unique_ptr<mlir::Pass> circt::firrtl::createLowerMemoryPass() {
@@ -39,6 +39,8 @@
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Dialect/HW/HWAttributes.h"
 #include "circt/Dialect/SV/SVOps.h"
+#include "circt/Support/ParallelSchedule.h"
+#include "circt/Support/TaskTrace.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
 #include "mlir/IR/Threading.h"
 #include "llvm/ADT/APSInt.h"
@@ -327,6 +329,7 @@ struct AttrCache {
     innerSymAttr = StringAttr::get(context, "inner_sym");
     nameAttr = StringAttr::get(context, "name");
     nameKindAttr = StringAttr::get(context, "nameKind");
+    debugNameAttr = StringAttr::get(context, "hw.debug.name");
     sPortDirections = StringAttr::get(context, "portDirections");
     sPortNames = StringAttr::get(context, "portNames");
     sPortTypes = StringAttr::get(context, "portTypes");
@@ -337,8 +340,9 @@ struct AttrCache {
   AttrCache(const AttrCache &) = default;
 
   Type i64ty;
-  StringAttr innerSymAttr, nameAttr, nameKindAttr, sPortDirections, sPortNames,
-      sPortTypes, sPortSyms, sPortAnnotations, sEmpty;
+  StringAttr innerSymAttr, nameAttr, nameKindAttr, debugNameAttr,
+      sPortDirections, sPortNames, sPortTypes, sPortSyms, sPortAnnotations,
+      sEmpty;
 };
 
 // The visitors all return true if the operation should be deleted, false if
@@ -568,13 +572,13 @@ bool TypeLoweringVisitor::lowerProducer(
   SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
 
   if (!peelType(srcType, fieldTypes, aggregatePreservationMode)) {
-    if (insertDebugInfo && !op->hasAttr("hw.debug.name")) {
+    if (insertDebugInfo && !op->hasAttr(cache.debugNameAttr)) {
       // If it's not a temp nodes produced by Chisel. For now, we use a
       // naming heuristics: all temp nodes are prefixed with _. However, in
       // case where users create such node, this hack will fail
       if (auto nameAttr = op->getAttrOfType<StringAttr>("name")) {
         if (nameAttr.size() > 0 && nameAttr.data()[0] != '_')
-          op->setAttr("hw.debug.name", nameAttr);
+          op->setAttr(cache.debugNameAttr, nameAttr);
       }
     }
     return false;
@@ -622,14 +626,17 @@ bool TypeLoweringVisitor::lowerProducer(
         filterAnnotations(context, oldAnno, srcType, field);
     auto newVal = clone(field, loweredAttrs);
 
-    // Carry over the name, if present.
+    // Carry over the name, if present. All the attributes are updated at
+    // once, so the attribute dictionary of the new op is only rebuilt once.
     if (auto *newOp = newVal.getDefiningOp()) {
+      NamedAttrList newAttrs(newOp->getAttrDictionary());
       if (!loweredName.empty())
-        newOp->setAttr(cache.nameAttr, StringAttr::get(context, loweredName));
+        newAttrs.set(cache.nameAttr, StringAttr::get(context, loweredName));
       if (nameKindAttr)
-        newOp->setAttr(cache.nameKindAttr, nameKindAttr);
+        newAttrs.set(cache.nameKindAttr, nameKindAttr);
       if (insertDebugInfo)
-        newOp->setAttr("hw.debug.name", StringAttr::get(context, targetName));
+        newAttrs.set(cache.debugNameAttr, StringAttr::get(context, targetName));
+      newOp->setAttrs(newAttrs.getDictionary(context));
     }
     lowered.push_back(newVal);
   }
@@ -751,8 +758,7 @@ bool TypeLoweringVisitor::lowerArg(FModuleLike module, size_t argIndex,
     // Use its default name instead
     if (insertDebugInfo) {
       auto attrs = mlir::DictionaryAttr::get(
-          context, {{StringAttr::get(context, "hw.debug.name"),
-                     newArgs[argIndex].name}});
+          context, {{cache.debugNameAttr, newArgs[argIndex].name}});
       newArgs[argIndex].annotations.addAnnotations(attrs);
     }
     return false;
@@ -770,7 +776,7 @@ bool TypeLoweringVisitor::lowerArg(FModuleLike module, size_t argIndex,
     if (insertDebugInfo) {
       auto attrs = mlir::DictionaryAttr::get(
           context,
-          {{StringAttr::get(context, "hw.debug.name"),
+          {{cache.debugNameAttr,
             StringAttr::get(context, originalName.str() + "." +
                                          field.value().suffix.substr(1))}});
 
@@ -857,13 +863,13 @@ bool TypeLoweringVisitor::visitStmt(ConnectOp op) {
               auto portName = instOp.getPortName(resultNo);
               auto nameStr = nameAttr.cast<mlir::StringAttr>().str() + "_" +
                              portName.str();
-              op->setAttr("hw.debug.name",
+              op->setAttr(cache.debugNameAttr,
                           mlir::StringAttr::get(context, nameStr));
               break;
             }
           }
         } else {
-          op->setAttr("hw.debug.name", nameAttr);
+          op->setAttr(cache.debugNameAttr, nameAttr);
         }
       }
     }
@@ -1135,9 +1141,9 @@ bool TypeLoweringVisitor::visitDecl(WireOp op) {
                                    attrs, StringAttr{});
   };
   auto handled = lowerProducer(op, clone);
-  if (insertDebugInfo && !handled && !op->hasAttr("hw.debug.name")) {
-    if (auto nameAttr = op->getAttr("name")) {
-      op->setAttr("hw.debug.name", nameAttr);
+  if (insertDebugInfo && !handled && !op->hasAttr(cache.debugNameAttr)) {
+    if (auto nameAttr = op->getAttr(cache.nameAttr)) {
+      op->setAttr(cache.debugNameAttr, nameAttr);
     }
   }
   return handled;
@@ -1166,8 +1172,8 @@ bool TypeLoweringVisitor::visitDecl(RegResetOp op) {
   auto handled = lowerProducer(op, clone);
   if (insertDebugInfo && !handled) {
     // not a bundle type. op not changed
-    if (auto name = op->getAttr("name")) {
-      op->setAttr("hw.debug.name", name);
+    if (auto name = op->getAttr(cache.nameAttr)) {
+      op->setAttr(cache.debugNameAttr, name);
     }
   }
   return handled;
@@ -1466,11 +1472,16 @@ void LowerTypesPass::runOnOperation() {
                    if (auto module = dyn_cast<FModuleLike>(op))
                      ops.push_back(module);
                  });
+  // Lower the largest modules first, such that a huge module does not keep a
+  // single thread busy after all others are done.
+  sortByEstimatedWork<FModuleLike>(&getContext(), ops);
 
   LLVM_DEBUG(llvm::dbgs() << "Recording Inner Symbol Renames:\n");
 
   // This lambda, executes in parallel for each Op within the circt.
   auto lowerModules = [&](FModuleLike op) -> LogicalResult {
+    TaskTraceScope trace("firrtl-lower-types",
+                         [&] { return op.moduleName().str(); });
     auto tl = TypeLoweringVisitor(&getContext(), preserveAggregate,
                                   preservePublicTypes, symTbl, cache,
                                   insertDebugInfo);
@@ -237,30 +237,7 @@ class LowerXMRPass : public LowerXMRBase<LowerXMRPass> {
     auto remoteOpPath = getRemoteRefSend(resolve.getRef());
     if (!remoteOpPath)
       return failure();
-    SmallVector<Attribute> refSendPath;
-    // Verbatim XMR begins with the Top level module.
-    refSendPath.push_back(refSendPathList[remoteOpPath.value()]
-                              .first.cast<InnerRefAttr>()
-                              .getModuleRef());
-    SmallString<128> xmrString;
-    Attribute lastInnerRef;
-    size_t lastIndex;
-    unsigned index = 0;
-    for (; remoteOpPath; ++index) {
-      lastIndex = remoteOpPath.value();
-      auto entr = refSendPathList[remoteOpPath.value()];
-      refSendPath.push_back(entr.first);
-      lastInnerRef = entr.first;
-      remoteOpPath = entr.second;
-      ("{{" + Twine(index) + "}}").toVector(xmrString);
-      xmrString += '.';
-    }
-    ("{{" + Twine(index) + "}}").toVector(xmrString);
-    auto iter = xmrPathSuffix.find(lastIndex);
-    // If this xmr has a suffix string (internal path into a module, that is not
-    // yet generated).
-    if (iter != xmrPathSuffix.end())
-      xmrString += ("." + iter->getSecond()).str();
+    auto &[xmrString, refSendPath] = getXMRPath(*remoteOpPath);
     if (auto vec = resolve.getResult().getType().dyn_cast<FVectorType>()) {
       // If the RefType is a vector, then replace all its users with [i] suffix,
       // instead of creatign a temp wire to the vector xmr, and then followup
@@ -293,6 +270,39 @@ class LowerXMRPass : public LowerXMRBase<LowerXMRPass> {
     return success();
   }
 
+  /// Get the verbatim XMR string and its symbols for the path starting at the
+  /// given entry of `refSendPathList`. These are memoized, since all resolves
+  /// of a reference that is forwarded through many instances share the path.
+  std::pair<SmallString<128>, SmallVector<Attribute>> &
+  getXMRPath(size_t pathStart) {
+    auto [it, inserted] = xmrPathCache.try_emplace(pathStart);
+    auto &[xmrString, refSendPath] = it->second;
+    if (!inserted)
+      return it->second;
+
+    // Verbatim XMR begins with the Top level module.
+    refSendPath.push_back(
+        refSendPathList[pathStart].first.cast<InnerRefAttr>().getModuleRef());
+    Optional<size_t> remoteOpPath = pathStart;
+    size_t lastIndex;
+    unsigned index = 0;
+    for (; remoteOpPath; ++index) {
+      lastIndex = remoteOpPath.value();
+      auto entr = refSendPathList[remoteOpPath.value()];
+      refSendPath.push_back(entr.first);
+      remoteOpPath = entr.second;
+      ("{{" + Twine(index) + "}}").toVector(xmrString);
+      xmrString += '.';
+    }
+    ("{{" + Twine(index) + "}}").toVector(xmrString);
+    auto iter = xmrPathSuffix.find(lastIndex);
+    // If this xmr has a suffix string (internal path into a module, that is not
+    // yet generated).
+    if (iter != xmrPathSuffix.end())
+      xmrString += ("." + iter->getSecond()).str();
+    return it->second;
+  }
+
   void setPortToRemove(Operation *op, size_t index, size_t numPorts) {
     if (refPortsToRemoveMap[op].size() < numPorts)
       refPortsToRemoveMap[op].resize(numPorts);
@@ -497,6 +507,7 @@ class LowerXMRPass : public LowerXMRBase<LowerXMRPass> {
     refPortsToRemoveMap.clear();
     dataflowAt.clear();
     refSendPathList.clear();
+    xmrPathCache.clear();
   }
 
   /// Cached module namespaces.
@@ -536,6 +547,11 @@ class LowerXMRPass : public LowerXMRBase<LowerXMRPass> {
 
   /// Record the internal path to an external module or a memory.
   DenseMap<size_t, SmallString<128>> xmrPathSuffix;
+
+  /// The memoized XMR strings and symbols of the paths starting at each entry
+  /// of `refSendPathList`.
+  DenseMap<size_t, std::pair<SmallString<128>, SmallVector<Attribute>>>
+      xmrPathCache;
 };
 
 std::unique_ptr<mlir::Pass> circt::firrtl::createLowerXMRPass() {
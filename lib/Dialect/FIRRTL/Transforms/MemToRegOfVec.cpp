@@ -44,7 +44,7 @@ struct MemToRegOfVecPass : public MemToRegOfVecBase<MemToRegOfVecPass> {
 
     // Find the device under test and create a set of all modules underneath it.
     auto it = llvm::find_if(*body, [&](Operation &op) -> bool {
-      return AnnotationSet(&op).hasAnnotation(dutAnnoClass);
+      return AnnotationSet::hasAnnotation(&op, dutAnnoClass);
     });
     if (it != body->end()) {
       auto &instanceGraph = getAnalysis<InstanceGraph>();
@@ -59,6 +59,9 @@ struct MemToRegOfVecPass : public MemToRegOfVecBase<MemToRegOfVecPass> {
                             if (auto mod = dyn_cast<FModuleOp>(op))
                               runOnModule(mod);
                           });
+
+    // Only memories are replaced, the instance hierarchy is unchanged.
+    markAnalysesPreserved<InstanceGraph>();
   }
 
   void runOnModule(FModuleOp mod) {
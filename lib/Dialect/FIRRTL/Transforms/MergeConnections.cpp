@@ -285,13 +285,18 @@ struct MergeConnectionsPass
 
 } // namespace
 
+bool circt::firrtl::mergeConnections(FModuleOp module,
+                                     bool enableAggressiveMerging) {
+  MergeConnection mergeConnection(module, enableAggressiveMerging);
+  return mergeConnection.run();
+}
+
 void MergeConnectionsPass::runOnOperation() {
   LLVM_DEBUG(llvm::dbgs() << "===----- Running MergeConnections "
                              "--------------------------------------===\n"
                           << "Module: '" << getOperation().getName() << "'\n";);
 
-  MergeConnection mergeConnection(getOperation(), enableAggressiveMerging);
-  bool changed = mergeConnection.run();
+  bool changed = mergeConnections(getOperation(), enableAggressiveMerging);
 
   if (!changed)
     return markAllAnalysesPreserved();
@@ -14,6 +14,7 @@
 #include "circt/Dialect/FIRRTL/AnnotationDetails.h"
 #include "circt/Dialect/FIRRTL/CHIRRTLDialect.h"
 #include "circt/Dialect/FIRRTL/FIRRTLAnnotations.h"
+#include "circt/Dialect/FIRRTL/FIRRTLInstanceGraph.h"
 #include "circt/Dialect/FIRRTL/FIRRTLOps.h"
 #include "circt/Dialect/FIRRTL/FIRRTLTypes.h"
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
@@ -497,8 +498,9 @@ static void replaceRefEdges(SmallVectorImpl<Backedge> &edges) {
 namespace {
 class Inliner {
 public:
-  /// Initialize the inliner to run on this circuit.
-  Inliner(CircuitOp circuit);
+  /// Initialize the inliner to run on this circuit.  The instance graph is
+  /// kept up to date as instances are inlined and modules are deleted.
+  Inliner(CircuitOp circuit, InstanceGraph &instanceGraph);
 
   /// Run the inliner.
   void run();
@@ -594,6 +596,9 @@ private:
   // A symbol table with references to each module in a circuit.
   SymbolTable symbolTable;
 
+  /// The instance graph of the circuit, updated as the inliner runs.
+  InstanceGraph &instanceGraph;
+
   /// The set of live modules.  Anything not recorded in this set will be
   /// removed by dead code elimination.
   DenseSet<Operation *> liveModules;
@@ -835,7 +840,8 @@ void Inliner::cloneAndRename(
       }
     }
   rename(prefix, newOp, moduleNamespace, validHierPaths);
-  if (isa<InstanceOp>(&op)) {
+  if (auto newInstance = dyn_cast<InstanceOp>(newOp)) {
+    instanceGraph.addInstance(newInstance);
     auto innerRef =
         InnerRefAttr::get(newOp->getParentOfType<FModuleOp>().getNameAttr(),
                           getInnerSymName(newOp));
@@ -854,11 +860,11 @@ void Inliner::cloneAndRename(
 }
 
 bool Inliner::shouldFlatten(Operation *op) {
-  return AnnotationSet(op).hasAnnotation(flattenAnnoClass);
+  return AnnotationSet::hasAnnotation(op, flattenAnnoClass);
 }
 
 bool Inliner::shouldInline(Operation *op) {
-  return AnnotationSet(op).hasAnnotation(inlineAnnoClass);
+  return AnnotationSet::hasAnnotation(op, inlineAnnoClass);
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
@@ -973,6 +979,7 @@ void Inliner::flattenInstances(FModuleOp module) {
     activeHierpaths = parentActivePaths;
 
     // Erase the replaced instance.
+    instanceGraph.eraseInstance(instance);
     instance.erase();
     wires.clear();
   }
@@ -1177,6 +1184,7 @@ void Inliner::inlineInstances(FModuleOp parent) {
     activeHierpaths = parentActivePaths;
 
     // Erase the replaced instance.
+    instanceGraph.eraseInstance(instance);
     instance.erase();
     wires.clear();
   }
@@ -1250,8 +1258,9 @@ void Inliner::identifyNLAsTargetingOnlyModules() {
   }
 }
 
-Inliner::Inliner(CircuitOp circuit)
-    : circuit(circuit), context(circuit.getContext()), symbolTable(circuit) {}
+Inliner::Inliner(CircuitOp circuit, InstanceGraph &instanceGraph)
+    : circuit(circuit), context(circuit.getContext()), symbolTable(circuit),
+      instanceGraph(instanceGraph) {}
 
 void Inliner::run() {
   CircuitNamespace circuitNamespace(circuit);
@@ -1294,13 +1303,21 @@ void Inliner::run() {
   }
 
   // Delete all unreferenced modules.  Mark any NLAs that originate from dead
-  // modules as also dead.
-  for (auto mod : llvm::make_early_inc_range(
-           circuit.getBodyBlock()->getOps<FModuleLike>())) {
+  // modules as also dead.  Dead modules may instantiate each other, so drop
+  // their instances from the instance graph before removing their nodes.
+  SmallVector<FModuleLike> deadModules;
+  for (auto mod : circuit.getBodyBlock()->getOps<FModuleLike>()) {
     if (liveModules.count(mod))
       continue;
     for (auto nla : rootMap[mod.moduleNameAttr()])
       nlaMap[nla].markDead();
+    deadModules.push_back(mod);
+    for (auto *record : llvm::make_early_inc_range(
+             *instanceGraph.lookup(mod.moduleNameAttr())))
+      record->erase();
+  }
+  for (auto mod : deadModules) {
+    instanceGraph.erase(instanceGraph.lookup(mod.moduleNameAttr()));
     mod.erase();
   }
 
@@ -1330,75 +1347,79 @@ void Inliner::run() {
   // Garbage collect any annotations which are now dead.  Duplicate annotations
   // which are now split.
   for (auto fmodule : circuit.getBodyBlock()->getOps<FModuleOp>()) {
+    SmallVector<Attribute> newAnnotations;
+    auto processNLAs = [&](Annotation anno) -> bool {
+      if (auto sym = anno.getMember<FlatSymbolRefAttr>("circt.nonlocal")) {
+        // If the symbol isn't in the NLA map, just skip it.  This avoids
+        // problems where the nlaMap "[]" will try to construct a default
+        // MutableNLA map (which it should never do).
+        if (!nlaMap.count(sym.getAttr()))
+          return false;
+
+        auto mnla = nlaMap[sym.getAttr()];
+
+        // Garbage collect dead NLA references.  This cleans up NLAs that go
+        // through modules which we never visited.
+        if (mnla.isDead())
+          return true;
+
+        // Do nothing if there are no additional NLAs to add or if we're
+        // dealing with a root module.  Root modules have already been updated
+        // earlier in the pass.  We only need to update NLA paths which are
+        // not the root.
+        auto newTops = mnla.getAdditionalSymbols();
+        if (newTops.size() == 0 || mnla.hasRoot(fmodule))
+          return false;
+
+        // Add NLAs to the non-root portion of the NLA.  This only needs to
+        // add symbols for NLAs which are after the first one.  We reused the
+        // old symbol name for the first NLA.
+        NamedAttrList newAnnotation;
+        for (auto rootAndSym : newTops.drop_front()) {
+          for (auto pair : anno.getDict()) {
+            if (pair.getName().getValue() != "circt.nonlocal") {
+              newAnnotation.push_back(pair);
+              continue;
+            }
+            newAnnotation.push_back(
+                {pair.getName(),
+                 FlatSymbolRefAttr::get(rootAndSym.getName())});
+          }
+          newAnnotations.push_back(
+              DictionaryAttr::get(fmodule.getContext(), newAnnotation));
+        }
+      }
+      return false;
+    };
+
+    // Update annotations on the operations in the module body.
     for (auto &op : *fmodule.getBodyBlock()) {
       AnnotationSet annotations(&op);
       // Early exit to avoid adding an empty annotations attribute to operations
       // which did not previously have annotations.
       if (annotations.empty())
         continue;
-
-      SmallVector<Attribute> newAnnotations;
-      auto processNLAs = [&](Annotation anno) -> bool {
-        if (auto sym = anno.getMember<FlatSymbolRefAttr>("circt.nonlocal")) {
-          // If the symbol isn't in the NLA map, just skip it.  This avoids
-          // problems where the nlaMap "[]" will try to construct a default
-          // MutableNLA map (which it should never do).
-          if (!nlaMap.count(sym.getAttr()))
-            return false;
-
-          auto mnla = nlaMap[sym.getAttr()];
-
-          // Garbage collect dead NLA references.  This cleans up NLAs that go
-          // through modules which we never visited.
-          if (mnla.isDead())
-            return true;
-
-          // Do nothing if there are no additional NLAs to add or if we're
-          // dealing with a root module.  Root modules have already been updated
-          // earlier in the pass.  We only need to update NLA paths which are
-          // not the root.
-          auto newTops = mnla.getAdditionalSymbols();
-          if (newTops.size() == 0 || mnla.hasRoot(fmodule))
-            return false;
-
-          // Add NLAs to the non-root portion of the NLA.  This only needs to
-          // add symbols for NLAs which are after the first one.  We reused the
-          // old symbol name for the first NLA.
-          NamedAttrList newAnnotation;
-          for (auto rootAndSym : newTops.drop_front()) {
-            for (auto pair : anno.getDict()) {
-              if (pair.getName().getValue() != "circt.nonlocal") {
-                newAnnotation.push_back(pair);
-                continue;
-              }
-              newAnnotation.push_back(
-                  {pair.getName(),
-                   FlatSymbolRefAttr::get(rootAndSym.getName())});
-            }
-            newAnnotations.push_back(
-                DictionaryAttr::get(op.getContext(), newAnnotation));
-          }
-        }
-        return false;
-      };
-
-      // Update annotations on the module.
+      newAnnotations.clear();
       annotations.removeAnnotations(processNLAs);
       annotations.addAnnotations(newAnnotations);
       annotations.applyToOperation(&op);
+    }
 
-      // Update annotations on the ports.
-      SmallVector<Attribute> newPortAnnotations;
-      for (auto port : fmodule.getPorts()) {
-        newAnnotations.clear();
-        port.annotations.removeAnnotations(processNLAs);
-        port.annotations.addAnnotations(newAnnotations);
-        newPortAnnotations.push_back(
-            ArrayAttr::get(op.getContext(), port.annotations.getArray()));
-      }
-      fmodule->setAttr("portAnnotations",
-                       ArrayAttr::get(op.getContext(), newPortAnnotations));
+    // Update annotations on the ports. This only depends on the module, so do
+    // it once rather than once per annotated operation of the body.
+    SmallVector<Attribute> newPortAnnotations;
+    bool portsChanged = false;
+    for (auto port : fmodule.getPorts()) {
+      newAnnotations.clear();
+      portsChanged |= port.annotations.removeAnnotations(processNLAs);
+      portsChanged |= !newAnnotations.empty();
+      port.annotations.addAnnotations(newAnnotations);
+      newPortAnnotations.push_back(
+          ArrayAttr::get(fmodule.getContext(), port.annotations.getArray()));
     }
+    if (portsChanged)
+      fmodule->setAttr("portAnnotations",
+                       ArrayAttr::get(fmodule.getContext(), newPortAnnotations));
   }
 }
 
@@ -1412,8 +1433,9 @@ class InlinerPass : public InlinerBase<InlinerPass> {
     LLVM_DEBUG(llvm::dbgs()
                << "===- Running Module Inliner Pass "
                   "--------------------------------------------===\n");
-    Inliner inliner(getOperation());
+    Inliner inliner(getOperation(), getAnalysis<InstanceGraph>());
     inliner.run();
+    markAnalysesPreserved<InstanceGraph>();
     LLVM_DEBUG(llvm::dbgs() << "===--------------------------------------------"
                                "------------------------------===\n");
   }
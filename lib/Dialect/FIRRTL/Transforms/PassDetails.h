@@ -35,6 +35,10 @@ namespace firrtl {
 #define GEN_PASS_CLASSES
 #include "circt/Dialect/FIRRTL/Passes.h.inc"
 
+/// Merge the field-level connections of `module` into aggregate connections,
+/// as done by the MergeConnections pass. Return true if the module changed.
+bool mergeConnections(FModuleOp module, bool enableAggressiveMerging);
+
 } // namespace firrtl
 } // namespace circt
 
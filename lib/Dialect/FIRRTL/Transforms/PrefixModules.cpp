@@ -96,6 +96,7 @@ class PrefixModulesPass : public PrefixModulesBase<PrefixModulesPass> {
   void renameModule(FModuleOp module);
   void renameExtModule(FExtModuleOp extModule);
   void renameMemModule(FMemModuleOp memModule);
+  Optional<StringRef> getTargetPrefix(FModuleLike target);
   void runOnOperation() override;
 
   /// Mutate Grand Central Interface definitions (an Annotation on the circuit)
@@ -114,6 +115,10 @@ class PrefixModulesPass : public PrefixModulesBase<PrefixModulesPass> {
   /// A map of Grand Central interface ID to prefix.
   DenseMap<Attribute, std::string> interfacePrefixMap;
 
+  /// A map of instantiated modules to their inclusive prefix, or None if their
+  /// instances are not updated. See `getTargetPrefix`.
+  DenseMap<Operation *, Optional<StringRef>> targetPrefixes;
+
   /// Cached instance graph analysis.
   InstanceGraph *instanceGraph = nullptr;
 
@@ -160,6 +165,31 @@ void PrefixModulesPass::removeDeadAnnotations(StringAttr moduleName,
       op, std::bind(canRemoveAnno, std::placeholders::_1, op));
 }
 
+/// Return the inclusive prefix of a module instantiated by a renamed module, or
+/// None if the instances of the module are left alone.  This only depends on
+/// the annotations of the module, which are not changed before the module
+/// itself is renamed, after all the modules instantiating it, so it is only
+/// computed once per module.
+Optional<StringRef> PrefixModulesPass::getTargetPrefix(FModuleLike target) {
+  auto [it, inserted] = targetPrefixes.try_emplace(target.getOperation(), None);
+  if (!inserted)
+    return it->second;
+
+  // Skip all external modules, unless one of the following conditions
+  // is true:
+  //   - This is a Grand Central Data Tap
+  //   - This is a Grand Central Mem Tap
+  if (auto extModule = dyn_cast<FExtModuleOp>(target.getOperation())) {
+    auto isDataTap =
+        AnnotationSet(extModule).hasAnnotation(dataTapsBlackboxClass);
+    auto isMemTap =
+        AnnotationSet::forPort(extModule, 0).hasAnnotation(memTapPortClass);
+    if (!isDataTap && !isMemTap)
+      return None;
+  }
+  return it->second = getPrefix(target);
+}
+
 /// Applies the prefix to the module.  This will update the required prefixes of
 /// any referenced module in the prefix map.
 void PrefixModulesPass::renameModuleBody(std::string prefix, FModuleOp module) {
@@ -196,26 +226,16 @@ void PrefixModulesPass::renameModuleBody(std::string prefix, FModuleOp module) {
     } else if (auto instanceOp = dyn_cast<InstanceOp>(op)) {
       auto target = dyn_cast<FModuleLike>(
           *instanceGraph->getReferencedModule(instanceOp));
-
-      // Skip all external modules, unless one of the following conditions
-      // is true:
-      //   - This is a Grand Central Data Tap
-      //   - This is a Grand Central Mem Tap
-      if (auto *extModule = dyn_cast_or_null<FExtModuleOp>(&target)) {
-        auto isDataTap =
-            AnnotationSet(*extModule).hasAnnotation(dataTapsBlackboxClass);
-        auto isMemTap = AnnotationSet::forPort(*extModule, 0)
-                            .hasAnnotation(memTapPortClass);
-        if (!isDataTap && !isMemTap)
-          return;
-      }
+      auto targetPrefix = getTargetPrefix(target);
+      if (!targetPrefix)
+        return;
 
       // Record that we must prefix the target module with the current prefix.
       recordPrefix(prefixMap, target.moduleName(), prefix);
 
       // Fixup this instance op to use the prefixed module name.  Note that the
       // referenced FModuleOp will be renamed later.
-      auto newTarget = StringAttr::get(context, prefix + getPrefix(target) +
+      auto newTarget = StringAttr::get(context, prefix + *targetPrefix +
                                                     target.moduleName());
       AnnotationSet instAnnos(instanceOp);
       // If the instance has HierPathOp, then update its module name also.
@@ -232,8 +252,9 @@ void PrefixModulesPass::renameModuleBody(std::string prefix, FModuleOp module) {
       // Now get the NLAs that pass through the InstanceOp and update them also.
       DenseSet<HierPathOp> instNLAs;
       nlaTable->getInstanceNLAs(instanceOp, instNLAs);
-      for (auto nla : instNLAs)
-        nlaTable->updateModuleInNLA(nla, oldModName, newTarget);
+      nlaTable->updateModuleInNLAs(
+          SmallVector<HierPathOp>(instNLAs.begin(), instNLAs.end()), oldModName,
+          newTarget);
 
       instanceOp.setModuleNameAttr(FlatSymbolRefAttr::get(context, newTarget));
     }
@@ -268,11 +289,11 @@ void PrefixModulesPass::renameModule(FModuleOp module) {
   auto &firstPrefix = prefixes.front();
 
   auto fixNLAsRootedAt = [&](StringAttr oldModName, StringAttr newModuleName) {
-    DenseSet<HierPathOp> nlas;
-    nlaTable->getNLAsInModule(oldModName, nlas);
-    for (auto n : nlas)
+    SmallVector<HierPathOp> nlas;
+    for (auto n : nlaTable->lookup(oldModName))
       if (n.root() == oldModName)
-        nlaTable->updateModuleInNLA(n, oldModName, newModuleName);
+        nlas.push_back(n);
+    nlaTable->updateModuleInNLAs(nlas, oldModName, newModuleName);
   };
   // Rename the module for each required prefix. This will clone the module
   // once for each prefix but the first.
@@ -453,6 +474,7 @@ void PrefixModulesPass::runOnOperation() {
   prefixMap.clear();
   prefixIdMap.clear();
   interfacePrefixMap.clear();
+  targetPrefixes.clear();
   if (!anythingChanged)
     markAllAnalysesPreserved();
 }
@@ -74,22 +74,27 @@ private:
   /// runOnOperation.
   NLATable *nlaTable;
 
-  /// Internal implementation that updates an Annotation to add a "target" field
-  /// based on the current location of the annotation in the circuit.  The value
-  /// of the "target" will be a local target if the Annotation is local and a
-  /// non-local target if the Annotation is non-local.
-  bool updateTargetImpl(Annotation &anno, FModuleLike &module,
-                        FIRRTLBaseType type, StringRef name) {
-    if (!anno.isClass(traceAnnoClass))
-      return false;
-
-    LLVM_DEBUG(llvm::dbgs() << "  - before: " << anno.getDict() << "\n");
+  /// The targets of a module, keyed by the non-local anchor of an Annotation,
+  /// or by a null attribute for the local target.  Each module has its own, as
+  /// modules are processed in parallel.
+  using ModuleTargetCache = DenseMap<Attribute, std::string>;
+
+  /// Return the target of the module, e.g. "~Circuit|Top/inst:Module", which
+  /// is local or non-local depending on the Annotation.  All Annotations of a
+  /// module share a few of these, so they are only built once.
+  StringRef getModuleTarget(FModuleLike &module, Annotation &anno,
+                            ModuleTargetCache &cache) {
+    auto nla = anno.getMember<FlatSymbolRefAttr>("circt.nonlocal");
+    auto [it, inserted] =
+        cache.try_emplace(nla ? nla.getAttr() : Attribute(), "");
+    if (!inserted)
+      return it->second;
 
     SmallString<64> newTarget("~");
     newTarget.append(module->getParentOfType<CircuitOp>().getName());
     newTarget.append("|");
 
-    if (auto nla = anno.getMember<FlatSymbolRefAttr>("circt.nonlocal")) {
+    if (nla) {
       HierPathOp path = nlaTable->getNLA(nla.getAttr());
       for (auto part : path.getNamepath().getValue().drop_back()) {
         auto inst = cast<hw::InnerRefAttr>(part);
@@ -100,6 +105,23 @@ private:
       }
     }
     newTarget.append(module.moduleName());
+    it->second = std::string(newTarget);
+    return it->second;
+  }
+
+  /// Internal implementation that updates an Annotation to add a "target" field
+  /// based on the current location of the annotation in the circuit.  The value
+  /// of the "target" will be a local target if the Annotation is local and a
+  /// non-local target if the Annotation is non-local.
+  bool updateTargetImpl(Annotation &anno, FModuleLike &module,
+                        FIRRTLBaseType type, StringRef name,
+                        ModuleTargetCache &cache) {
+    if (!anno.isClass(traceAnnoClass))
+      return false;
+
+    LLVM_DEBUG(llvm::dbgs() << "  - before: " << anno.getDict() << "\n");
+
+    SmallString<64> newTarget(getModuleTarget(module, anno, cache));
     newTarget.append(">");
 
     newTarget.append(name);
@@ -136,19 +158,21 @@ private:
   /// Add a "target" field to a port Annotation that indicates the current
   /// location of the port in the circuit.
   bool updatePortTarget(FModuleLike &module, Annotation &anno,
-                        unsigned portIdx) {
+                        unsigned portIdx, ModuleTargetCache &cache) {
 
     FIRRTLBaseType type =
         TypeSwitch<Type, FIRRTLBaseType>(module.getPortType(portIdx))
             .Case<FIRRTLBaseType>([](FIRRTLBaseType t) { return t; })
             .Case<RefType>([](RefType t) { return t.getType(); });
 
-    return updateTargetImpl(anno, module, type, module.getPortName(portIdx));
+    return updateTargetImpl(anno, module, type, module.getPortName(portIdx),
+                            cache);
   }
 
   /// Add a "target" field to an Annotation that indicates the current location
   /// of a component in the circuit.
-  bool updateTarget(FModuleLike &module, Operation *op, Annotation &anno) {
+  bool updateTarget(FModuleLike &module, Operation *op, Annotation &anno,
+                    ModuleTargetCache &cache) {
 
     // If this is operation doesn't have a single result (and no way to know
     // what its type is) or if it doesn't have a name, then do nothing.
@@ -163,34 +187,21 @@ private:
             .Case<FIRRTLBaseType>([](FIRRTLBaseType t) { return t; })
             .Case<RefType>([](RefType t) { return t.getType(); });
 
-    return updateTargetImpl(anno, module, type, name);
+    return updateTargetImpl(anno, module, type, name, cache);
   }
 
   /// Add a "target" field to an Annotation on a Module that indicates the
   /// current location of the module.  This will be local or non-local depending
   /// on the Annotation.
-  bool updateModuleTarget(FModuleLike &module, Annotation &anno) {
+  bool updateModuleTarget(FModuleLike &module, Annotation &anno,
+                          ModuleTargetCache &cache) {
 
     if (!anno.isClass(traceAnnoClass))
       return false;
 
     LLVM_DEBUG(llvm::dbgs() << "  - before: " << anno.getDict() << "\n");
 
-    SmallString<64> newTarget("~");
-    newTarget.append(module->getParentOfType<CircuitOp>().getName());
-    newTarget.append("|");
-
-    if (auto nla = anno.getMember<FlatSymbolRefAttr>("circt.nonlocal")) {
-      HierPathOp path = nlaTable->getNLA(nla.getAttr());
-      for (auto part : path.getNamepath().getValue().drop_back()) {
-        auto inst = cast<hw::InnerRefAttr>(part);
-        newTarget.append(inst.getModule());
-        newTarget.append("/");
-        newTarget.append(inst.getName());
-        newTarget.append(":");
-      }
-    }
-    newTarget.append(module.moduleName());
+    SmallString<64> newTarget(getModuleTarget(module, anno, cache));
 
     anno.setMember("target", StringAttr::get(module->getContext(), newTarget));
 
@@ -223,6 +234,9 @@ void ResolveTracesPass::runOnOperation() {
     // Output Trace Annotations from this module only.
     SmallVector<Annotation> outputAnnotations;
 
+    // The targets of this module, shared by all its Annotations.
+    ModuleTargetCache targets;
+
     // A lazily constructed module namespace.
     Optional<ModuleNamespace> moduleNamespace = None;
 
@@ -235,7 +249,7 @@ void ResolveTracesPass::runOnOperation() {
 
     // Visit the module.
     AnnotationSet::removeAnnotations(moduleLike, [&](Annotation anno) {
-      if (!updateModuleTarget(moduleLike, anno))
+      if (!updateModuleTarget(moduleLike, anno, targets))
         return false;
 
       outputAnnotations.push_back(anno);
@@ -245,7 +259,7 @@ void ResolveTracesPass::runOnOperation() {
     // Visit port annotations.
     AnnotationSet::removePortAnnotations(
         moduleLike, [&](unsigned portIdx, Annotation anno) {
-          if (!updatePortTarget(moduleLike, anno, portIdx))
+          if (!updatePortTarget(moduleLike, anno, portIdx, targets))
             return false;
 
           getOrAddInnerSym(moduleLike, portIdx, moduleLike.getPortName(portIdx),
@@ -257,7 +271,7 @@ void ResolveTracesPass::runOnOperation() {
     // Visit component annotations.
     moduleLike.walk([&](Operation *component) {
       AnnotationSet::removeAnnotations(component, [&](Annotation anno) {
-        if (!updateTarget(moduleLike, component, anno))
+        if (!updateTarget(moduleLike, component, anno, targets))
           return false;
 
         auto module = cast<FModuleOp>(moduleLike);
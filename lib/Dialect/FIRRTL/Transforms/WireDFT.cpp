@@ -19,7 +19,9 @@
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/ADT/SetVector.h"
 
 using namespace circt;
@@ -109,14 +111,15 @@ void WireDFTPass::runOnOperation() {
   Value enableSignal;
   FModuleOp enableModule;
 
-  // Walk all modules looking for the DUT module and the annotated enable
-  // signal.
+  // Look for the DUT module.
+  SmallVector<FModuleOp> modules;
   for (auto &op : *circuit.getBodyBlock()) {
     auto module = dyn_cast<FModuleOp>(op);
 
     // If this isn't a regular module, continue.
     if (!module)
       continue;
+    modules.push_back(module);
 
     // Check if this module is the DUT.
     AnnotationSet annos(module);
@@ -130,61 +133,58 @@ void WireDFTPass::runOnOperation() {
       }
       dut = module;
     }
+  }
 
-    // See if this module has any port marked as the DFT enable.
-    bool error = false;
-    AnnotationSet::removePortAnnotations(module, [&](unsigned i,
-                                                     Annotation anno) {
-      // If we have already encountered an error or this is not the right
-      // annotation kind, continue.
-      if (error || !anno.isClass(dftTestModeEnableAnnoClass))
-        return false;
+  // Walk the ports and bodies of all modules in parallel, looking for anything
+  // marked as the DFT enable. Each module records its enable signals along
+  // with the operation owning the annotation, and the results are checked in
+  // module order afterwards so that diagnostics stay deterministic.
+  SmallVector<SmallVector<std::pair<Value, Operation *>, 1>> enables(
+      modules.size());
+  mlir::parallelForEach(
+      &getContext(), llvm::seq<size_t>(0, modules.size()), [&](size_t index) {
+        auto module = modules[index];
+        auto &found = enables[index];
+        AnnotationSet::removePortAnnotations(
+            module, [&](unsigned i, Annotation anno) {
+              if (!anno.isClass(dftTestModeEnableAnnoClass))
+                return false;
+              // Grab the enable value and remove the annotation.
+              found.push_back(
+                  {getValueByFieldID(ImplicitLocOpBuilder::atBlockBegin(
+                                         module->getLoc(),
+                                         module.getBodyBlock()),
+                                     module.getArgument(i), anno.getFieldID()),
+                   module});
+              return true;
+            });
+        module->walk([&](Operation *op) {
+          AnnotationSet::removeAnnotations(op, [&](Annotation anno) {
+            if (!anno.isClass(dftTestModeEnableAnnoClass))
+              return false;
+            // Grab the enable value and remove the annotation.
+            found.push_back(
+                {getValueByFieldID(ImplicitLocOpBuilder::atBlockEnd(
+                                       op->getLoc(), op->getBlock()),
+                                   op->getResult(0), anno.getFieldID()),
+                 op});
+            return true;
+          });
+        });
+      });
+
+  for (auto [index, found] : llvm::enumerate(enables)) {
+    for (auto [signal, owner] : found) {
       // If we have already found a DFT enable, emit an error.
       if (enableSignal) {
         auto diag =
-            module->emitError("more than one thing marked as a DFT enable");
+            owner->emitError("more than one thing marked as a DFT enable");
         diag.attachNote(enableSignal.getLoc()) << "first thing defined here";
-        error = true;
-        return false;
+        return signalPassFailure();
       }
-      // Grab the enable value and remove the annotation.
-      enableSignal =
-          getValueByFieldID(ImplicitLocOpBuilder::atBlockBegin(
-                                module->getLoc(), module.getBodyBlock()),
-                            module.getArgument(i), anno.getFieldID());
-      enableModule = module;
-      return true;
-    });
-    if (error)
-      return signalPassFailure();
-
-    // Walk the module body looking for any operation marked as the DFT enable.
-    auto walkResult = module->walk([&](Operation *op) {
-      AnnotationSet::removeAnnotations(op, [&](Annotation anno) {
-        // If we have already encountered an error or this is not the right
-        // annotation kind, continue.
-        if (error || !anno.isClass(dftTestModeEnableAnnoClass))
-          return false;
-        if (enableSignal) {
-          auto diag =
-              op->emitError("more than one thing marked as a DFT enable");
-          diag.attachNote(enableSignal.getLoc()) << "first thing defined here";
-          error = true;
-          return false;
-        }
-        // Grab the enable value and remove the annotation.
-        enableSignal = getValueByFieldID(
-            ImplicitLocOpBuilder::atBlockEnd(op->getLoc(), op->getBlock()),
-            op->getResult(0), anno.getFieldID());
-        enableModule = module;
-        return true;
-      });
-      if (error)
-        return WalkResult::interrupt();
-      return WalkResult::advance();
-    });
-    if (walkResult.wasInterrupted())
-      return signalPassFailure();
+      enableSignal = signal;
+      enableModule = modules[index];
+    }
   }
 
   // No enable signal means we have no work to do.
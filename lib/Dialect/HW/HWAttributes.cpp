@@ -812,6 +812,14 @@ TypedAttr ParamExprAttr::get(PEO opcode, ArrayRef<TypedAttr> operandsIn) {
   assert(llvm::all_of(operandsIn.drop_front(),
                       [&](auto op) { return op.getType() == type; }));
 
+  // Canonicalization recursively rebuilds subexpressions, reuse the result if
+  // this exact expression has been built before.
+  auto &cache =
+      type.getContext()->getLoadedDialect<HWDialect>()->paramExprCache;
+  SmallVector<Attribute, 4> key(operandsIn.begin(), operandsIn.end());
+  if (auto cached = cache.lookupCanonical(unsigned(opcode), key))
+    return cached.cast<TypedAttr>();
+
   SmallVector<TypedAttr, 4> operands(operandsIn.begin(), operandsIn.end());
 
   // Verify and canonicalize parameter expressions.
@@ -862,10 +870,11 @@ TypedAttr ParamExprAttr::get(PEO opcode, ArrayRef<TypedAttr> operandsIn) {
   }
 
   // If we folded to an operand, return it.
-  if (result)
-    return result;
+  if (!result)
+    result = Base::get(operands[0].getContext(), opcode, operands, type);
 
-  return Base::get(operands[0].getContext(), opcode, operands, type);
+  cache.addCanonical(unsigned(opcode), key, result);
+  return result;
 }
 
 Attribute ParamExprAttr::parse(AsmParser &p, Type type) {
@@ -903,36 +912,59 @@ void ParamExprAttr::print(AsmPrinter &p) const {
   p << '>';
 }
 
+namespace {
+/// The state of a single parametric evaluation: the provided parameter values
+/// keyed by name, and the already substituted subexpressions. Parameter
+/// expressions are uniqued, so subexpressions shared between several operands
+/// are only rewritten once.
+struct ParamSubstitution {
+  ParamSubstitution(ArrayAttr parameters) {
+    for (auto param : parameters) {
+      auto paramDecl = param.cast<ParamDeclAttr>();
+      values[paramDecl.getName()] = paramDecl.getValue();
+    }
+  }
+
+  DenseMap<StringAttr, Attribute> values;
+  DenseMap<Attribute, Attribute> replaced;
+};
+} // namespace
+
 // Replaces any ParamDeclRefAttr within a parametric expression with its
 // corresponding value from the map of provided parameters.
-static FailureOr<Attribute>
-replaceDeclRefInExpr(Location loc,
-                     const std::map<std::string, Attribute> &parameters,
-                     Attribute paramAttr) {
+static FailureOr<Attribute> replaceDeclRefInExpr(Location loc,
+                                                 ParamSubstitution &state,
+                                                 Attribute paramAttr) {
   if (paramAttr.dyn_cast<IntegerAttr>()) {
     // Nothing to do, constant value.
     return paramAttr;
   }
   if (auto paramRefAttr = paramAttr.dyn_cast<hw::ParamDeclRefAttr>()) {
     // Get the value from the provided parameters.
-    auto it = parameters.find(paramRefAttr.getName().str());
-    if (it == parameters.end())
+    auto it = state.values.find(paramRefAttr.getName());
+    if (it == state.values.end())
       return emitError(loc)
              << "Could not find parameter " << paramRefAttr.getName().str()
              << " in the provided parameters for the expression!";
     return it->second;
   }
   if (auto paramExprAttr = paramAttr.dyn_cast<hw::ParamExprAttr>()) {
+    auto cached = state.replaced.find(paramAttr);
+    if (cached != state.replaced.end())
+      return cached->second;
+
     // Recurse into all operands of the expression.
     llvm::SmallVector<TypedAttr, 4> replacedOperands;
     for (auto operand : paramExprAttr.getOperands()) {
-      auto res = replaceDeclRefInExpr(loc, parameters, operand);
+      auto res = replaceDeclRefInExpr(loc, state, operand);
       if (failed(res))
         return {failure()};
-      replacedOperands.push_back(*res);
+      replacedOperands.push_back(res->cast<TypedAttr>());
     }
-    return {
-        hw::ParamExprAttr::get(paramExprAttr.getOpcode(), replacedOperands)};
+    Attribute result =
+        hw::ParamExprAttr::get(paramExprAttr.getOpcode(), replacedOperands);
+    state.replaced[paramAttr] = result;
+    return result;
   }
   llvm_unreachable("Unhandled parametric attribute");
   return {};
@@ -941,33 +973,25 @@ replaceDeclRefInExpr(Location loc,
 FailureOr<Attribute> hw::evaluateParametricAttr(Location loc,
                                                 ArrayAttr parameters,
                                                 Attribute paramAttr) {
-  // Create a map of the provided parameters for faster lookup.
-  std::map<std::string, Attribute> parameterMap;
-  for (auto param : parameters) {
-    auto paramDecl = param.cast<ParamDeclAttr>();
-    parameterMap[paramDecl.getName().str()] = paramDecl.getValue();
-  }
-
-  // First, replace any ParamDeclRefAttr in the expression with its
-  // corresponding value in 'parameters'.
-  auto paramAttrRes = replaceDeclRefInExpr(loc, parameterMap, paramAttr);
-  if (failed(paramAttrRes))
-    return {failure()};
-  paramAttr = *paramAttrRes;
-
-  // Then, evaluate the parametric attribute.
-  if (paramAttr.isa<IntegerAttr>() || paramAttr.isa<hw::ParamDeclRefAttr>())
+  // Constants evaluate to themselves, don't bother building the parameter map.
+  if (paramAttr.isa<IntegerAttr>())
     return paramAttr;
-  if (auto paramExprAttr = paramAttr.dyn_cast<hw::ParamExprAttr>()) {
-    // Since any ParamDeclRefAttr was replaced within the expression,
-    // we re-evaluate the expression through the existing ParamExprAttr
-    // canonicalizer.
-    return ParamExprAttr::get(paramExprAttr.getOpcode(),
-                              paramExprAttr.getOperands());
-  }
 
-  llvm_unreachable("Unhandled parametric attribute");
-  return Attribute();
+  auto &cache =
+      paramAttr.getContext()->getLoadedDialect<HWDialect>()->paramExprCache;
+  if (auto cached = cache.lookupEvaluated(parameters, paramAttr))
+    return cached;
+
+  // First, replace any ParamDeclRefAttr in the expression with its
+  // corresponding value in 'parameters'. Since ParamExprAttr::get runs the
+  // canonicalizer on the rewritten operands, the result is already evaluated.
+  ParamSubstitution state(parameters);
+  auto result = replaceDeclRefInExpr(loc, state, paramAttr);
+  // Only successful evaluations are cached, failures need to be diagnosed at
+  // every location.
+  if (succeeded(result))
+    cache.addEvaluated(parameters, paramAttr, *result);
+  return result;
 }
 
 FailureOr<Type> hw::evaluateParametricType(Location loc, ArrayAttr parameters,
@@ -0,0 +1,38 @@
+//===- HWDebugSignals.cpp - Frontend-visible signals ----------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/HW/HWDebugSignals.h"
+
+using namespace circt;
+using namespace hw;
+
+bool hw::isDebugSignal(Operation *op) {
+  return op && op->hasAttr("hw.debug.name");
+}
+
+DebugSignals::DebugSignals(Operation *operation) {
+  operation->walk([&](HWModuleOp module) {
+    auto &moduleSignals = signals[module];
+    for (auto &port : module.getAllPorts())
+      if (port.debugAttr && !port.debugAttr.getValue().empty())
+        moduleSignals.push_back(port.name);
+    module.getBodyBlock()->walk([&](Operation *op) {
+      if (!isDebugSignal(op))
+        return;
+      if (auto name = op->getAttrOfType<StringAttr>("name"))
+        moduleSignals.push_back(name);
+    });
+  });
+}
+
+ArrayRef<StringAttr> DebugSignals::getSignals(HWModuleOp module) const {
+  auto it = signals.find(module);
+  if (it == signals.end())
+    return {};
+  return it->second;
+}
@@ -51,10 +51,11 @@ struct HWInlinerInterface : public mlir::DialectInlinerInterface {
   bool isLegalToInline(Operation *op, Region *, bool,
                        BlockAndValueMapping &) const final {
     return isa<ConstantOp>(op) || isa<BitcastOp>(op) ||
-           isa<ArrayCreateOp>(op) || isa<ArrayConcatOp>(op) ||
-           isa<ArraySliceOp>(op) || isa<ArrayGetOp>(op) ||
-           isa<StructCreateOp>(op) || isa<StructInjectOp>(op) ||
-           isa<UnionCreateOp>(op) || isa<UnionExtractOp>(op);
+           isa<ArrayCreateOp>(op) || isa<ArrayConstantOp>(op) ||
+           isa<ArrayConcatOp>(op) || isa<ArraySliceOp>(op) ||
+           isa<ArrayGetOp>(op) || isa<StructCreateOp>(op) ||
+           isa<StructInjectOp>(op) || isa<UnionCreateOp>(op) ||
+           isa<UnionExtractOp>(op);
   }
 
   bool isLegalToInline(Region *, Region *, bool,
@@ -93,6 +94,11 @@ Operation *HWDialect::materializeConstant(OpBuilder &builder, Attribute value,
     if (auto attrValue = value.dyn_cast<IntegerAttr>())
       return builder.create<ConstantOp>(loc, type, attrValue);
 
+  // Dense integer attributes materialize into hw.array_constant.
+  if (type.isa<ArrayType>())
+    if (auto attrValue = value.dyn_cast<DenseIntElementsAttr>())
+      return builder.create<ArrayConstantOp>(loc, type, attrValue);
+
   // Parameter expressions materialize into hw.param.value.
   auto parentOp = builder.getBlock()->getParentOp();
   auto curModule = dyn_cast<HWModuleOp>(parentOp);
@@ -1654,6 +1654,37 @@ Value ArrayCreateOp::getUniformElement() {
   return {};
 }
 
+//===----------------------------------------------------------------------===//
+// ArrayConstantOp
+//===----------------------------------------------------------------------===//
+
+void ArrayConstantOp::build(OpBuilder &b, OperationState &state,
+                            DenseIntElementsAttr value) {
+  auto type = ArrayType::get(value.getElementType(), value.getNumElements());
+  build(b, state, type, value);
+}
+
+LogicalResult ArrayConstantOp::verify() {
+  auto type = hw::type_cast<ArrayType>(getType());
+  auto value = getValue();
+  if (value.getType().getRank() != 1)
+    return emitOpError("value must be a one-dimensional attribute");
+  if (value.getNumElements() != int64_t(type.getSize()))
+    return emitOpError("value has ")
+           << value.getNumElements() << " elements, but the array has "
+           << type.getSize();
+  if (value.getElementType() != type.getElementType())
+    return emitOpError("value element type ")
+           << value.getElementType() << " does not match array element type "
+           << type.getElementType();
+  return success();
+}
+
+OpFoldResult ArrayConstantOp::fold(ArrayRef<Attribute> constants) {
+  assert(constants.empty() && "constant has no operands");
+  return getValueAttr();
+}
+
 static Optional<uint64_t> getUIntFromValue(Value value) {
   auto idxOp = dyn_cast_or_null<ConstantOp>(value.getDefiningOp());
   if (!idxOp)
@@ -2358,6 +2389,17 @@ void ArrayGetOp::build(OpBuilder &builder, OperationState &result, Value input,
 // the index. If the array is constructed from a constant by a bitcast
 // operation, we can fold into a constant.
 OpFoldResult ArrayGetOp::fold(ArrayRef<Attribute> operands) {
+  // array_get(array_constant(c), i) -> c[i]
+  if (auto constArray = operands[0].dyn_cast_or_null<DenseIntElementsAttr>()) {
+    IntegerAttr constIdx = operands[1].dyn_cast_or_null<IntegerAttr>();
+    if (!constIdx || constIdx.getValue().getBitWidth() > 64)
+      return {};
+    uint64_t idx = constIdx.getValue().getLimitedValue();
+    if (idx >= uint64_t(constArray.getNumElements()))
+      return {};
+    return constArray.getValues<IntegerAttr>()[idx];
+  }
+
   // array_get(bitcast(c), i) -> c[i*w+w-1:i*w]
   if (auto bitcast = getInput().getDefiningOp<hw::BitcastOp>()) {
     auto intTy = getType().dyn_cast<IntegerType>();
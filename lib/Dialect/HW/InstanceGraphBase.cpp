@@ -8,6 +8,8 @@
 
 #include "circt/Dialect/HW/InstanceGraphBase.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/PostOrderIterator.h"
 
 using namespace circt;
 using namespace hw;
@@ -71,6 +73,7 @@ InstanceGraphNode *InstanceGraphBase::addModule(HWModuleLike module) {
   node->module = module;
   nodeMap[module.moduleNameAttr()] = node;
   nodes.push_back(node);
+  invalidateTraversals();
   return node;
 }
 
@@ -82,6 +85,7 @@ void InstanceGraphBase::erase(InstanceGraphNode *node) {
     instance->erase();
   nodeMap.erase(node->getModule().moduleNameAttr());
   nodes.erase(node);
+  invalidateTraversals();
 }
 
 InstanceGraphNode *InstanceGraphBase::lookup(StringAttr name) {
@@ -117,6 +121,58 @@ void InstanceGraphBase::replaceInstance(HWInstanceLike inst,
   (*it)->instance = newInst;
 }
 
+InstanceRecord *InstanceGraphBase::addInstance(HWInstanceLike instance) {
+  auto module = instance->getParentOfType<HWModuleLike>();
+  assert(module && "instance must be nested in a module");
+  auto *targetNode = lookup(instance.referencedModuleNameAttr());
+  invalidateTraversals();
+  return lookup(module)->addInstance(instance, targetNode);
+}
+
+void InstanceGraphBase::addInstances(ArrayRef<HWInstanceLike> instances) {
+  for (auto instance : instances)
+    addInstance(instance);
+}
+
+void InstanceGraphBase::eraseInstance(HWInstanceLike instance) {
+  eraseInstances(instance);
+}
+
+void InstanceGraphBase::eraseInstances(ArrayRef<HWInstanceLike> instances) {
+  // Group the instances by the module containing them.
+  llvm::MapVector<InstanceGraphNode *, DenseSet<Operation *>> erasedInstances;
+  for (auto instance : instances) {
+    auto module = instance->getParentOfType<HWModuleLike>();
+    assert(module && "instance must be nested in a module");
+    erasedInstances[lookup(module)].insert(instance.getOperation());
+  }
+
+  for (auto &[node, erased] : erasedInstances) {
+    for (auto *record : llvm::make_early_inc_range(*node))
+      if (erased.erase(record->getInstance().getOperation()))
+        record->erase();
+    assert(erased.empty() && "Instance of module not recorded in graph");
+  }
+  invalidateTraversals();
+}
+
+ArrayRef<InstanceGraphNode *> InstanceGraphBase::getPostOrder() {
+  if (postOrder.empty())
+    for (auto *node : llvm::post_order(this))
+      postOrder.push_back(node);
+  return postOrder;
+}
+
+ArrayRef<InstanceGraphNode *> InstanceGraphBase::getInverseTopologicalOrder() {
+  if (inverseTopologicalOrder.empty()) {
+    DenseSet<InstanceGraphNode *> visited;
+    for (auto *root : *this)
+      for (auto *node : llvm::post_order_ext(root, visited))
+        inverseTopologicalOrder.push_back(node);
+  }
+  return inverseTopologicalOrder;
+}
+
 bool InstanceGraphBase::isAncestor(HWModuleLike child, HWModuleLike parent) {
   DenseSet<InstanceGraphNode *> seen;
   SmallVector<InstanceGraphNode *> worklist;
@@ -241,6 +297,68 @@ ArrayRef<InstancePath> InstancePathCache::getAbsolutePaths(HWModuleLike op) {
   return pathList;
 }
 
+size_t InstancePathCache::getNumAbsolutePaths(HWModuleLike op) {
+  InstanceGraphNode *node = instanceGraph[op];
+
+  // The circuit root has a single, empty path.
+  if (node == instanceGraph.getTopLevelNode())
+    return 1;
+
+  auto cached = numAbsolutePathsCache.find(op);
+  if (cached != numAbsolutePathsCache.end())
+    return cached->second;
+
+  // If the paths are already materialized, just count them.
+  size_t numPaths = 0;
+  auto cachedPaths = absolutePathsCache.find(op);
+  if (cachedPaths != absolutePathsCache.end()) {
+    numPaths = cachedPaths->second.size();
+  } else {
+    for (auto *inst : node->uses())
+      if (auto module = inst->getParent()->getModule())
+        numPaths += getNumAbsolutePaths(module);
+  }
+  numAbsolutePathsCache.insert({op, numPaths});
+  return numPaths;
+}
+
+void InstancePathCache::walkAbsolutePaths(
+    HWModuleLike op, llvm::function_ref<void(InstancePath)> callback) {
+  // The instances from the visited module down to `op`, innermost first, and
+  // the buffer the paths handed to the callback are assembled in.
+  SmallVector<HWInstanceLike, 8> reversedSuffix;
+  SmallVector<HWInstanceLike, 8> path;
+
+  std::function<void(InstanceGraphNode *)> walk = [&](InstanceGraphNode *node) {
+    // If we have reached the circuit root, the suffix is a complete path.
+    if (node == instanceGraph.getTopLevelNode()) {
+      path.assign(reversedSuffix.rbegin(), reversedSuffix.rend());
+      callback(path);
+      return;
+    }
+
+    // If the paths to this module are cached, extend each of them.
+    auto cached = absolutePathsCache.find(node->getModule());
+    if (cached != absolutePathsCache.end()) {
+      for (auto prefix : cached->second) {
+        path.assign(prefix.begin(), prefix.end());
+        path.append(reversedSuffix.rbegin(), reversedSuffix.rend());
+        callback(path);
+      }
+      return;
+    }
+
+    for (auto *inst : node->uses()) {
+      if (!inst->getParent()->getModule())
+        continue;
+      reversedSuffix.push_back(inst->getInstance());
+      walk(inst->getParent());
+      reversedSuffix.pop_back();
+    }
+  };
+  walk(instanceGraph[op]);
+}
+
 InstancePath InstancePathCache::appendInstance(InstancePath path,
                                                HWInstanceLike inst) {
   size_t n = path.size() + 1;
@@ -229,6 +229,22 @@ LogicalResult instance_like_impl::verifyInstanceOfHWModule(
                                                         moduleRef, module)))
     return failure();
 
+  // Most instances match the signature of their module exactly. The names are
+  // uniqued arrays and types are uniqued, such that this is a handful of
+  // pointer comparisons. Only instances of parametric modules, and those that
+  // do not match, have their port types resolved and compared one by one, to
+  // point out the mismatch.
+  auto [modArgNames, modResultNames] =
+      instance_like_impl::getHWModuleArgAndResultNames(module);
+  auto moduleType = getModuleType(module);
+  auto modParameters = module->getAttrOfType<ArrayAttr>("parameters");
+  if ((!parameters || parameters.empty()) &&
+      (!modParameters || modParameters.empty()) && argNames == modArgNames &&
+      resultNames == modResultNames &&
+      llvm::equal(inputs.getTypes(), moduleType.getInputs()) &&
+      llvm::equal(results, moduleType.getResults()))
+    return success();
+
   // Emit an error message on the instance, with a note indicating which module
   // is being referenced. The error message on the instance is added by the
   // verification function this lambda is passed to.
@@ -240,14 +256,11 @@ LogicalResult instance_like_impl::verifyInstanceOfHWModule(
       };
 
   // Check that input types are consistent with the referenced module.
-  auto [modArgNames, modResultNames] =
-      instance_like_impl::getHWModuleArgAndResultNames(module);
-
-  ArrayRef<Type> resolvedModInputTypesRef = getModuleType(module).getInputs();
+  ArrayRef<Type> resolvedModInputTypesRef = moduleType.getInputs();
   SmallVector<Type> resolvedModInputTypes;
   if (parameters) {
     if (failed(instance_like_impl::resolveParametricTypes(
-            instance->getLoc(), parameters, getModuleType(module).getInputs(),
+            instance->getLoc(), parameters, moduleType.getInputs(),
             resolvedModInputTypes, emitError)))
       return failure();
     resolvedModInputTypesRef = resolvedModInputTypes;
@@ -258,11 +271,11 @@ LogicalResult instance_like_impl::verifyInstanceOfHWModule(
     return failure();
 
   // Check that result types are consistent with the referenced module.
-  ArrayRef<Type> resolvedModResultTypesRef = getModuleType(module).getResults();
+  ArrayRef<Type> resolvedModResultTypesRef = moduleType.getResults();
   SmallVector<Type> resolvedModResultTypes;
   if (parameters) {
     if (failed(instance_like_impl::resolveParametricTypes(
-            instance->getLoc(), parameters, getModuleType(module).getResults(),
+            instance->getLoc(), parameters, moduleType.getResults(),
             resolvedModResultTypes, emitError)))
       return failure();
     resolvedModResultTypesRef = resolvedModResultTypes;
@@ -274,7 +287,6 @@ LogicalResult instance_like_impl::verifyInstanceOfHWModule(
 
   if (parameters) {
     // Check that the parameters are consistent with the referenced module.
-    ArrayAttr modParameters = module->getAttrOfType<ArrayAttr>("parameters");
     if (failed(instance_like_impl::verifyParameters(parameters, modParameters,
                                                     emitError)))
       return failure();
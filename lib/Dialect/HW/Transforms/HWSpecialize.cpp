@@ -22,6 +22,7 @@
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "llvm/ADT/TypeSwitch.h"
 
@@ -254,22 +255,26 @@ static LogicalResult registerNestedParametricInstanceOps(
   return failure(walkResult.wasInterrupted());
 }
 
-// Specializes the provided 'base' module into the 'target' module. By doing
-// so, we create a new module which
+// A single module specialization: the parametric 'source' module, the
+// parameters it is instantiated with and the 'target' module they specialize
+// it into.
+struct Specialization {
+  HWModuleOp source;
+  ArrayAttr parameters;
+  HWModuleOp target;
+};
+
+// Creates the module that the provided 'source' module specializes into. By
+// doing so, we create a new module which
 // 1. has no parameters
-// 2. has a name composing the name of 'base' as well as the 'parameters'
+// 2. has a name composing the name of 'source' as well as the 'parameters'
 // parameters.
 // 3. Has a top-level interface with any parametric types resolved.
-// 4. Any references to module parameters have been replaced with the
-// parameter value.
-static LogicalResult specializeModule(
-    OpBuilder builder, ArrayAttr parameters, SymbolCache &sc, Namespace &ns,
-    HWModuleOp source, HWModuleOp &target,
-    const ParameterSpecializationRegistry &currentRegistry,
-    ParameterSpecializationRegistry &nextRegistry,
-    llvm::DenseMap<hw::HWModuleOp,
-                   llvm::DenseMap<ArrayAttr, llvm::SmallVector<hw::InstanceOp>>>
-        &parametersUsers) {
+// The body of the module is populated by 'elaborateSpecializedModule'.
+static FailureOr<HWModuleOp> createSpecializedModule(OpBuilder &builder,
+                                                     ArrayAttr parameters,
+                                                     Namespace &ns,
+                                                     HWModuleOp source) {
   auto *ctx = builder.getContext();
   // Update the types of the source module ports based on evaluating any
   // parametric in/output ports.
@@ -290,39 +295,54 @@ static LogicalResult specializeModule(
   }
 
   // Create the specialized module using the evaluated port info.
-  target = builder.create<HWModuleOp>(
+  auto target = builder.create<HWModuleOp>(
       source.getLoc(),
       StringAttr::get(ctx, generateModuleName(ns, source, parameters)), ports);
 
   // Erase the default created hw.output op - we'll copy the correct operation
   // during body elaboration.
   (*target.getOps<hw::OutputOp>().begin()).erase();
+  return target;
+}
+
+// Populates the body of a module created by 'createSpecializedModule' such
+// that any references to module parameters have been replaced with the
+// parameter value. This only touches 'target' and reads 'source', so
+// specializations may be elaborated in parallel.
+static LogicalResult
+elaborateSpecializedModule(const Specialization &specialization) {
+  auto source = specialization.source;
+  auto target = specialization.target;
+  auto parameters = specialization.parameters;
+  auto *ctx = target.getContext();
 
   // Clone body of the source into the target. Use ValueMapper to ensure safe
   // cloning in the presence of backedges.
+  OpBuilder builder(ctx);
+  builder.setInsertionPointToStart(target.getBodyBlock());
   BackedgeBuilder bb(builder, source.getLoc());
   ValueMapper mapper(&bb);
   for (auto &&[src, dst] :
        llvm::zip(source.getArguments(), target.getArguments()))
     mapper.set(src, dst);
-  builder.setInsertionPointToStart(target.getBodyBlock());
 
+  Region &sourceBody = source.getBody();
   for (auto &op : source.getOps()) {
+    // Map the operands of 'op' and of any operation nested within it which are
+    // defined in the source body, such that the clone never refers to values
+    // of the source module.
     BlockAndValueMapping bvMapper;
-    for (auto operand : op.getOperands())
-      bvMapper.map(operand, mapper.get(operand));
+    op.walk([&](Operation *nested) {
+      for (auto operand : nested->getOperands())
+        if (operand.getParentRegion() == &sourceBody)
+          bvMapper.map(operand, mapper.get(operand));
+    });
     auto *newOp = builder.clone(op, bvMapper);
     for (auto &&[oldRes, newRes] :
          llvm::zip(op.getResults(), newOp->getResults()))
       mapper.set(oldRes, newRes);
   }
 
-  // Register any nested parametric instance ops for the next loop
-  auto nestedRegistrationResult = registerNestedParametricInstanceOps(
-      target, parameters, sc, currentRegistry, nextRegistry, parametersUsers);
-  if (failed(nestedRegistrationResult))
-    return failure();
-
   // We've now created a separate copy of the source module with a rewritten
   // top-level interface. Next, we enter the module to convert parametric
   // types within operations.
@@ -383,23 +403,46 @@ void HWSpecializePass::runOnOperation() {
   // registered for the next loop. We loop until no new nested modules have been
   // registered.
   while (!registry.uniqueModuleParameters.empty()) {
-    // The registry for the next specialization loop
-    ParameterSpecializationRegistry nextRegistry;
+    // Create the specialized modules of this loop up front. Naming and
+    // inserting modules into the top-level module must happen serially, and
+    // in registration order, to keep the output deterministic.
+    SmallVector<Specialization> worklist;
     for (auto it : registry.uniqueModuleParameters) {
       for (auto parameters : it.second) {
-        HWModuleOp specializedModule;
-        if (failed(specializeModule(builder, parameters, sc, ns, it.first,
-                                    specializedModule, registry, nextRegistry,
-                                    parametersUsers))) {
+        auto specializedModule =
+            createSpecializedModule(builder, parameters, ns, it.first);
+        if (failed(specializedModule)) {
           signalPassFailure();
           return;
         }
 
         // Extend the symbol cache with the newly created module.
-        sc.addDefinition(specializedModule.getNameAttr(), specializedModule);
+        sc.addDefinition(specializedModule->getNameAttr(), *specializedModule);
 
         // Add the specialization
-        specializations[it.first][parameters] = specializedModule;
+        specializations[it.first][parameters] = *specializedModule;
+        worklist.push_back({it.first, parameters, *specializedModule});
+      }
+    }
+
+    // Every specialization only modifies its own module, so the bodies can be
+    // cloned and folded in parallel.
+    if (failed(failableParallelForEach(&getContext(), worklist,
+                                       elaborateSpecializedModule))) {
+      signalPassFailure();
+      return;
+    }
+
+    // Register any nested parametric instance ops for the next loop. The
+    // parameters of nested instances are not affected by the elaboration, so
+    // this happens in worklist order once all bodies are in place.
+    ParameterSpecializationRegistry nextRegistry;
+    for (auto &specialization : worklist) {
+      if (failed(registerNestedParametricInstanceOps(
+              specialization.target, specialization.parameters, sc, registry,
+              nextRegistry, parametersUsers))) {
+        signalPassFailure();
+        return;
       }
     }
 
@@ -1350,7 +1350,7 @@ llvm::SmallVector<handshake::MemStoreInterface> MemoryOp::getStorePorts() {
 
 bool handshake::MemoryOp::allocateMemory(
     llvm::DenseMap<unsigned, unsigned> &memoryMap,
-    std::vector<std::vector<llvm::Any>> &store,
+    MemoryStore &store,
     std::vector<double> &storeTimes) {
   if (memoryMap.count(getId()))
     return false;
@@ -1369,22 +1369,12 @@ bool handshake::MemoryOp::allocateMemory(
       allocationSize *= llvm::any_cast<APInt>(in[count++]).getSExtValue();
     }
   }
-  unsigned ptr = store.size();
-  store.resize(ptr + 1);
-  storeTimes.resize(ptr + 1);
-  store[ptr].resize(allocationSize);
-  storeTimes[ptr] = 0.0;
   mlir::Type elementType = type.getElementType();
-  int width = elementType.getIntOrFloatBitWidth();
-  for (int i = 0; i < allocationSize; i++) {
-    if (elementType.isa<mlir::IntegerType>()) {
-      store[ptr][i] = APInt(width, 0);
-    } else if (elementType.isa<mlir::FloatType>()) {
-      store[ptr][i] = APFloat(0.0);
-    } else {
-      llvm_unreachable("Unknown result type!\n");
-    }
-  }
+  if (!elementType.isa<mlir::IntegerType, mlir::FloatType>())
+    llvm_unreachable("Unknown result type!\n");
+  unsigned ptr = store.size();
+  store.emplace_back(elementType, allocationSize);
+  storeTimes.push_back(0.0);
 
   memoryMap[getId()] = ptr;
   return true;
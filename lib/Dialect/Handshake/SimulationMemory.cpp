@@ -0,0 +1,126 @@
+//===- SimulationMemory.cpp - Handshake simulation memory model -----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the memory model used when simulating the standard and
+// handshake dialects.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/Handshake/SimulationMemory.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MathExtras.h"
+
+using namespace circt;
+using namespace handshake;
+using namespace llvm;
+using namespace llvm::support;
+
+MemoryBank::MemoryBank(mlir::Type elementType, size_t size)
+    : numElements(size) {
+  assert(elementType.isa<mlir::IntegerType, mlir::FloatType>() &&
+         "unsupported memory element type");
+  width = elementType.getIntOrFloatBitWidth();
+  if (auto floatType = elementType.dyn_cast<mlir::FloatType>())
+    semantics = &floatType.getFloatSemantics();
+  unsigned bytes = divideCeil(width, 8);
+  elementBytes = bytes <= 8 ? PowerOf2Ceil(bytes) : alignTo(bytes, 8);
+  data.resize(size * elementBytes);
+}
+
+APInt MemoryBank::loadInt(size_t index) const {
+  assert(index < numElements && "out-of-bounds load");
+  const uint8_t *element = data.data() + index * elementBytes;
+  uint64_t word;
+  switch (elementBytes) {
+  case 0:
+    return APInt(width, 0);
+  case 1:
+    word = *element;
+    break;
+  case 2:
+    word = endian::read16le(element);
+    break;
+  case 4:
+    word = endian::read32le(element);
+    break;
+  case 8:
+    word = endian::read64le(element);
+    break;
+  default: {
+    SmallVector<uint64_t, 4> words;
+    for (unsigned i = 0; i < elementBytes; i += 8)
+      words.push_back(endian::read64le(element + i));
+    return APInt(width, words);
+  }
+  }
+  // Bits above the width may be set by binary input data.
+  return APInt(width, word & maskTrailingOnes<uint64_t>(width));
+}
+
+APFloat MemoryBank::loadFloat(size_t index) const {
+  assert(isFloat() && "not a float memory");
+  return APFloat(*semantics, loadInt(index));
+}
+
+void MemoryBank::storeInt(size_t index, const APInt &value) {
+  assert(index < numElements && "out-of-bounds store");
+  uint8_t *element = data.data() + index * elementBytes;
+  APInt bits = value.zextOrTrunc(width);
+  switch (elementBytes) {
+  case 0:
+    break;
+  case 1:
+    *element = bits.getZExtValue();
+    break;
+  case 2:
+    endian::write16le(element, bits.getZExtValue());
+    break;
+  case 4:
+    endian::write32le(element, bits.getZExtValue());
+    break;
+  case 8:
+    endian::write64le(element, bits.getZExtValue());
+    break;
+  default:
+    for (unsigned i = 0, e = elementBytes / 8; i < e; ++i)
+      endian::write64le(element + i * 8,
+                        i < bits.getNumWords() ? bits.getRawData()[i] : 0);
+  }
+}
+
+void MemoryBank::storeFloat(size_t index, const APFloat &value) {
+  assert(isFloat() && "not a float memory");
+  if (&value.getSemantics() == semantics)
+    return storeInt(index, value.bitcastToAPInt());
+
+  APFloat converted = value;
+  bool losesInfo;
+  converted.convert(*semantics, APFloat::rmNearestTiesToEven, &losesInfo);
+  storeInt(index, converted.bitcastToAPInt());
+}
+
+Any MemoryBank::load(size_t index) const {
+  if (isFloat())
+    return loadFloat(index);
+  return loadInt(index);
+}
+
+void MemoryBank::store(size_t index, const Any &value) {
+  if (isFloat())
+    storeFloat(index, any_cast<APFloat>(value));
+  else
+    storeInt(index, any_cast<APInt>(value));
+}
+
+bool MemoryBank::loadBinary(StringRef bytes) {
+  if (bytes.size() != data.size())
+    return false;
+  std::copy(bytes.bytes_begin(), bytes.bytes_end(), data.begin());
+  return true;
+}
@@ -11,8 +11,11 @@
 //===----------------------------------------------------------------------===//
 
 #include "PassDetails.h"
+#include "circt/Dialect/Handshake/HandshakeGraph.h"
 #include "circt/Dialect/Handshake/HandshakeOps.h"
 #include "circt/Dialect/Handshake/HandshakePasses.h"
+#include "circt/Scheduling/Algorithms.h"
+#include "circt/Scheduling/Problems.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/Rewrite/FrozenRewritePatternSet.h"
 #include "mlir/Transforms/DialectConversion.h"
@@ -20,6 +23,7 @@
 using namespace circt;
 using namespace handshake;
 using namespace mlir;
+using namespace circt::scheduling;
 
 namespace {
 
@@ -59,7 +63,8 @@ static bool isUnbufferedChannel(Operation *definingOp, Operation *usingOp) {
 }
 
 static void insertBuffer(Location loc, Value operand, OpBuilder &builder,
-                         unsigned numSlots, BufferTypeEnum bufferType) {
+                         unsigned numSlots, BufferTypeEnum bufferType,
+                         HandshakeGraph &graph) {
   auto ip = builder.saveInsertionPoint();
   builder.setInsertionPointAfterValue(operand);
   auto bufferOp = builder.create<handshake::BufferOp>(
@@ -68,28 +73,30 @@ static void insertBuffer(Location loc, Value operand, OpBuilder &builder,
       bufferOp, function_ref<bool(OpOperand &)>([](OpOperand &operand) -> bool {
         return !isa<handshake::BufferOp>(operand.getOwner());
       }));
+  graph.insertNode(bufferOp);
   builder.restoreInsertionPoint(ip);
 }
 
 // Inserts buffers at all results of an operation
 static void bufferResults(OpBuilder &builder, Operation *op, unsigned numSlots,
-                          BufferTypeEnum bufferType) {
+                          BufferTypeEnum bufferType, HandshakeGraph &graph) {
   for (auto res : op->getResults()) {
     Operation *user = *res.getUsers().begin();
     if (isa<handshake::BufferOp>(user))
       continue;
-    insertBuffer(op->getLoc(), res, builder, numSlots, bufferType);
+    insertBuffer(op->getLoc(), res, builder, numSlots, bufferType, graph);
   }
 }
 
 // Add a buffer to any un-buffered channel.
 static void bufferAllStrategy(Region &r, OpBuilder &builder, unsigned numSlots,
+                              HandshakeGraph &graph,
                               BufferTypeEnum bufferType = BufferTypeEnum::seq) {
 
   for (auto &arg : r.getArguments()) {
     if (!shouldBufferArgument(arg))
       continue;
-    insertBuffer(arg.getLoc(), arg, builder, numSlots, bufferType);
+    insertBuffer(arg.getLoc(), arg, builder, numSlots, bufferType, graph);
   }
 
   for (auto &defOp : r.getOps()) {
@@ -97,35 +104,42 @@ static void bufferAllStrategy(Region &r, OpBuilder &builder, unsigned numSlots,
       for (auto *useOp : res.getUsers()) {
         if (!isUnbufferedChannel(&defOp, useOp))
           continue;
-        insertBuffer(res.getLoc(), res, builder, numSlots, bufferType);
+        insertBuffer(res.getLoc(), res, builder, numSlots, bufferType, graph);
       }
     }
   }
 }
 
 // Returns true if 'src' is within a cycle. 'breaksCycle' is a function which
-// determines whether an operation breaks a cycle.
+// determines whether an operation breaks a cycle. Any such cycle lies within
+// the SCC of 'src', so the search does not leave it.
 static bool inCycle(Operation *src,
-                    llvm::function_ref<bool(Operation *)> breaksCycle) {
-  SetVector<Operation *> visited;
-  SmallVector<Operation *> stack = {src};
+                    llvm::function_ref<bool(Operation *)> breaksCycle,
+                    const HandshakeGraph &graph) {
+  if (!graph.isInCycle(src))
+    return false;
+
+  unsigned srcNode = *graph.lookupNode(src);
+  unsigned scc = graph.getSCC(srcNode);
+  DenseSet<unsigned> visited;
+  SmallVector<unsigned> stack = {srcNode};
 
   while (!stack.empty()) {
-    Operation *curr = stack.pop_back_val();
+    unsigned curr = stack.pop_back_val();
 
-    if (visited.contains(curr))
+    if (!visited.insert(curr).second)
       continue;
-    visited.insert(curr);
 
-    if (breaksCycle(curr))
+    if (breaksCycle(graph.getOp(curr)))
       continue;
 
-    for (auto *user : curr->getUsers()) {
+    for (unsigned user : graph.getSuccessors(curr)) {
       // If visiting the source node, then we're in a cycle.
-      if (src == user)
+      if (srcNode == user)
         return true;
 
-      stack.push_back(user);
+      if (graph.getSCC(user) == scc)
+        stack.push_back(user);
     }
   }
   return false;
@@ -134,6 +148,7 @@ static bool inCycle(Operation *src,
 // Perform a depth first search and insert buffers when cycles are detected.
 static void
 bufferCyclesStrategy(Region &r, OpBuilder &builder, unsigned numSlots,
+                     HandshakeGraph &graph,
                      BufferTypeEnum /*bufferType*/ = BufferTypeEnum::seq) {
   // Cycles can only occur at merge-like operations so those are our buffering
   // targets. Placing the buffer at the output of the merge-like op,
@@ -149,9 +164,10 @@ bufferCyclesStrategy(Region &r, OpBuilder &builder, unsigned numSlots,
     // We insert a sequential buffer whenever the op is determined to be
     // within a cycle (to break combinational cycles). Else, place a FIFO
     // buffer.
-    bool sequential = inCycle(mergeOp, isSeqBuffer);
+    bool sequential = inCycle(mergeOp, isSeqBuffer, graph);
     bufferResults(builder, mergeOp, numSlots,
-                  sequential ? BufferTypeEnum::seq : BufferTypeEnum::fifo);
+                  sequential ? BufferTypeEnum::seq : BufferTypeEnum::fifo,
+                  graph);
   }
 }
 
@@ -159,24 +175,157 @@ bufferCyclesStrategy(Region &r, OpBuilder &builder, unsigned numSlots,
 // sequential buffer on graph cycles, and add FIFO buffers on all other
 // connections.
 static void bufferAllFIFOStrategy(Region &r, OpBuilder &builder,
-                                  unsigned numSlots) {
+                                  unsigned numSlots, HandshakeGraph &graph) {
   // First, buffer cycles with sequential buffers
-  bufferCyclesStrategy(r, builder, /*numSlots=*/numSlots,
+  bufferCyclesStrategy(r, builder, /*numSlots=*/numSlots, graph,
                        /*bufferType=*/BufferTypeEnum::seq);
   // Then, buffer remaining channels with transparent FIFO buffers
-  bufferAllStrategy(r, builder, numSlots,
+  bufferAllStrategy(r, builder, numSlots, graph,
                     /*bufferType=*/BufferTypeEnum::fifo);
 }
 
+// The latency model of the throughput strategy: a sequential buffer takes a
+// cycle per slot, memory accesses and instances take a cycle, and everything
+// else is combinational.
+static unsigned getThroughputLatency(Operation *op) {
+  if (auto bufferOp = dyn_cast<handshake::BufferOp>(op))
+    return bufferOp.isSequential() ? bufferOp.getNumSlots() : 0;
+  if (isa<handshake::LoadOp, handshake::StoreOp, handshake::MemoryOp,
+          handshake::ExternalMemoryOp, handshake::InstanceOp>(op))
+    return 1;
+  return 0;
+}
+
+// Returns the channels which close a cycle of the dataflow graph, found by a
+// depth first search in block order.
+static DenseSet<OpOperand *> findBackEdges(Block &block) {
+  DenseSet<OpOperand *> backEdges;
+  // Operations on the current search path map to true, finished ones to false.
+  DenseMap<Operation *, bool> onPath;
+  struct Frame {
+    Operation *op;
+    SmallVector<OpOperand *> uses;
+    unsigned next = 0;
+  };
+  auto makeFrame = [](Operation *op) {
+    Frame frame{op, {}};
+    for (Value res : op->getResults())
+      for (OpOperand &use : res.getUses())
+        frame.uses.push_back(&use);
+    return frame;
+  };
+
+  for (Operation &root : block) {
+    if (onPath.count(&root))
+      continue;
+    SmallVector<Frame> stack = {makeFrame(&root)};
+    onPath[&root] = true;
+    while (!stack.empty()) {
+      Frame &frame = stack.back();
+      if (frame.next == frame.uses.size()) {
+        onPath[frame.op] = false;
+        stack.pop_back();
+        continue;
+      }
+      OpOperand *use = frame.uses[frame.next++];
+      Operation *user = use->getOwner();
+      auto it = onPath.find(user);
+      if (it == onPath.end()) {
+        onPath[user] = true;
+        stack.push_back(makeFrame(user));
+      } else if (it->second) {
+        backEdges.insert(use);
+      }
+    }
+  }
+  return backEdges;
+}
+
+// Break every cycle with a single-slot sequential buffer, then schedule the
+// dataflow graph as a cyclic problem and add FIFO buffers deep enough to hold
+// the tokens which arrive early on reconvergent paths.
+static LogicalResult bufferThroughputStrategy(Region &r, OpBuilder &builder,
+                                              unsigned initiationInterval,
+                                              HandshakeGraph &graph) {
+  auto isSeqBuffer = [](auto op) {
+    auto bufferOp = dyn_cast<handshake::BufferOp>(op);
+    return bufferOp && bufferOp.isSequential();
+  };
+  for (auto mergeOp : llvm::make_early_inc_range(
+           r.getOps<MergeLikeOpInterface>()))
+    if (inCycle(mergeOp, isSeqBuffer, graph))
+      bufferResults(builder, mergeOp, /*numSlots=*/1, BufferTypeEnum::seq,
+                    graph);
+
+  Block &block = r.front();
+  Operation *parentOp = r.getParentOp();
+  auto problem = CyclicProblem::get(parentOp);
+  for (Operation &op : block) {
+    unsigned latency = getThroughputLatency(&op);
+    auto opr =
+        problem.getOrInsertOperatorType(("latency" + Twine(latency)).str());
+    problem.setLatency(opr, latency);
+    problem.insertOperation(&op);
+    problem.setLinkedOperatorType(&op, opr);
+  }
+  DenseSet<OpOperand *> backEdges = findBackEdges(block);
+  for (OpOperand *use : backEdges)
+    problem.setDistance(use, 1);
+
+  if (failed(problem.check()) ||
+      failed(scheduleSimplex(problem, block.getTerminator())) ||
+      failed(problem.verify()))
+    return failure();
+
+  unsigned ii = *problem.getInitiationInterval();
+  if (ii > initiationInterval)
+    parentOp->emitWarning() << "target initiation interval "
+                            << initiationInterval
+                            << " is not reachable, buffering for " << ii;
+  ii = std::max(ii, std::max(initiationInterval, 1u));
+
+  // A channel needs a slot for every II cycles its consumer starts after the
+  // token is available. Buffers already on a channel are left alone.
+  SmallVector<std::pair<OpOperand *, unsigned>> fifos;
+  for (Operation &op : block) {
+    if (isa<handshake::BufferOp>(op))
+      continue;
+    for (OpOperand &use : op.getOpOperands()) {
+      Operation *defOp = use.get().getDefiningOp();
+      if (!defOp || isa<handshake::BufferOp>(defOp))
+        continue;
+      int64_t slack = int64_t(*problem.getStartTime(&op)) -
+                      *problem.getStartTime(defOp) -
+                      getThroughputLatency(defOp);
+      if (backEdges.contains(&use))
+        slack += ii;
+      if (slack > 0)
+        fifos.push_back({&use, (slack + ii - 1) / ii});
+    }
+  }
+  for (auto [use, numSlots] : fifos)
+    insertBuffer(use->getOwner()->getLoc(), use->get(), builder, numSlots,
+                 BufferTypeEnum::fifo, graph);
+  return success();
+}
+
 LogicalResult circt::handshake::bufferRegion(Region &r, OpBuilder &builder,
                                              StringRef strategy,
-                                             unsigned bufferSize) {
+                                             unsigned bufferSize,
+                                             unsigned initiationInterval,
+                                             HandshakeGraph *graph) {
+  Optional<HandshakeGraph> regionGraph;
+  if (!graph)
+    graph = &regionGraph.emplace(r.getParentOp());
+
+  if (strategy == "throughput")
+    return bufferThroughputStrategy(r, builder, initiationInterval, *graph);
   if (strategy == "cycles")
-    bufferCyclesStrategy(r, builder, bufferSize);
+    bufferCyclesStrategy(r, builder, bufferSize, *graph);
   else if (strategy == "all")
-    bufferAllStrategy(r, builder, bufferSize);
+    bufferAllStrategy(r, builder, bufferSize, *graph);
   else if (strategy == "allFIFO")
-    bufferAllFIFOStrategy(r, builder, bufferSize);
+    bufferAllFIFOStrategy(r, builder, bufferSize, *graph);
   else
     return r.getParentOp()->emitOpError()
            << "Unknown buffer strategy: " << strategy;
@@ -187,9 +336,11 @@ LogicalResult circt::handshake::bufferRegion(Region &r, OpBuilder &builder,
 namespace {
 struct HandshakeInsertBuffersPass
     : public HandshakeInsertBuffersBase<HandshakeInsertBuffersPass> {
-  HandshakeInsertBuffersPass(const std::string &strategy, unsigned bufferSize) {
+  HandshakeInsertBuffersPass(const std::string &strategy, unsigned bufferSize,
+                             unsigned initiationInterval) {
     this->strategy = strategy;
     this->bufferSize = bufferSize;
+    this->initiationInterval = initiationInterval;
   }
 
   void runOnOperation() override {
@@ -199,8 +350,12 @@ struct HandshakeInsertBuffersPass
 
     OpBuilder builder(f.getContext());
 
-    if (failed(bufferRegion(f.getBody(), builder, strategy, bufferSize)))
-      signalPassFailure();
+    // The graph is kept up to date as buffers are inserted.
+    auto &graph = getAnalysis<HandshakeGraph>();
+    if (failed(bufferRegion(f.getBody(), builder, strategy, bufferSize,
+                            initiationInterval, &graph)))
+      return signalPassFailure();
+    markAnalysesPreserved<HandshakeGraph>();
   }
 };
 
@@ -212,7 +367,9 @@ circt::handshake::createHandshakeRemoveBuffersPass() {
 }
 
 std::unique_ptr<mlir::OperationPass<handshake::FuncOp>>
-circt::handshake::createHandshakeInsertBuffersPass(const std::string &strategy,
-                                                   unsigned bufferSize) {
-  return std::make_unique<HandshakeInsertBuffersPass>(strategy, bufferSize);
+circt::handshake::createHandshakeInsertBuffersPass(
+    const std::string &strategy, unsigned bufferSize,
+    unsigned initiationInterval) {
+  return std::make_unique<HandshakeInsertBuffersPass>(strategy, bufferSize,
+                                                      initiationInterval);
 }
@@ -0,0 +1,154 @@
+//===- HandshakeGraph.cpp - Handshake dataflow graph analysis ---*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Contains the definitions of the handshake dataflow graph analysis.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/Handshake/HandshakeGraph.h"
+#include "mlir/IR/Operation.h"
+#include "llvm/ADT/STLExtras.h"
+
+using namespace circt;
+using namespace handshake;
+using namespace mlir;
+
+HandshakeGraph::HandshakeGraph(Operation *funcOp) {
+  for (Region &region : funcOp->getRegions())
+    for (Block &block : region)
+      for (Operation &op : block) {
+        nodes[&op] = ops.size();
+        ops.push_back(&op);
+      }
+
+  successors.resize(ops.size());
+  predecessors.resize(ops.size());
+  for (unsigned node = 0, e = ops.size(); node < e; ++node)
+    updateEdges(node);
+  computeSCCs();
+}
+
+Optional<unsigned> HandshakeGraph::lookupNode(Operation *op) const {
+  auto it = nodes.find(op);
+  if (it == nodes.end())
+    return None;
+  return it->second;
+}
+
+bool HandshakeGraph::isInCycle(Operation *op) const {
+  auto node = lookupNode(op);
+  return node && sccIsCyclic[sccs[*node]];
+}
+
+void HandshakeGraph::updateEdges(unsigned node) {
+  Operation *op = ops[node];
+  auto &succs = successors[node];
+  succs.clear();
+  for (Value result : op->getResults())
+    for (Operation *user : result.getUsers())
+      if (auto userNode = lookupNode(user))
+        succs.push_back(*userNode);
+
+  auto &preds = predecessors[node];
+  preds.clear();
+  for (Value operand : op->getOperands())
+    if (Operation *defOp = operand.getDefiningOp())
+      if (auto defNode = lookupNode(defOp))
+        preds.push_back(*defNode);
+}
+
+void HandshakeGraph::insertNode(Operation *op) {
+  assert(!nodes.count(op) && "op is already in the graph");
+  unsigned node = ops.size();
+  nodes[op] = node;
+  ops.push_back(op);
+  successors.emplace_back();
+  predecessors.emplace_back();
+  updateEdges(node);
+
+  // The channels of the neighbours now end or start at the new node.
+  for (unsigned pred : predecessors[node])
+    updateEdges(pred);
+  for (unsigned succ : successors[node])
+    updateEdges(succ);
+
+  // A split channel was on a cycle if both its ends are in the same cyclic
+  // SCC, in which case the new node joins that SCC.
+  for (unsigned pred : predecessors[node]) {
+    unsigned scc = sccs[pred];
+    if (!sccIsCyclic[scc])
+      continue;
+    if (llvm::any_of(successors[node],
+                     [&](unsigned succ) { return sccs[succ] == scc; })) {
+      sccs.push_back(scc);
+      return;
+    }
+  }
+  sccs.push_back(sccIsCyclic.size());
+  sccIsCyclic.push_back(false);
+}
+
+/// Compute the SCCs with an iterative version of Tarjan's algorithm.
+void HandshakeGraph::computeSCCs() {
+  constexpr unsigned unvisited = ~0u;
+  unsigned numNodes = ops.size();
+  SmallVector<unsigned> index(numNodes, unvisited), lowLink(numNodes);
+  SmallVector<bool> onStack(numNodes, false);
+  SmallVector<unsigned> stack;
+  SmallVector<std::pair<unsigned, unsigned>> path;
+  unsigned nextIndex = 0;
+
+  sccs.assign(numNodes, 0);
+  sccIsCyclic.clear();
+
+  auto visit = [&](unsigned node) {
+    index[node] = lowLink[node] = nextIndex++;
+    stack.push_back(node);
+    onStack[node] = true;
+    path.push_back({node, 0});
+  };
+
+  for (unsigned root = 0; root < numNodes; ++root) {
+    if (index[root] != unvisited)
+      continue;
+    visit(root);
+    while (!path.empty()) {
+      auto &[node, nextSucc] = path.back();
+      if (nextSucc < successors[node].size()) {
+        unsigned succ = successors[node][nextSucc++];
+        if (index[succ] == unvisited)
+          visit(succ);
+        else if (onStack[succ])
+          lowLink[node] = std::min(lowLink[node], index[succ]);
+        continue;
+      }
+
+      unsigned finished = node;
+      path.pop_back();
+      if (!path.empty()) {
+        unsigned parent = path.back().first;
+        lowLink[parent] = std::min(lowLink[parent], lowLink[finished]);
+      }
+      if (lowLink[finished] != index[finished])
+        continue;
+
+      // 'finished' is the root of an SCC, which holds the nodes above it on
+      // the stack.
+      unsigned scc = sccIsCyclic.size();
+      bool cyclic = stack.back() != finished ||
+                    llvm::is_contained(successors[finished], finished);
+      unsigned member;
+      do {
+        member = stack.pop_back_val();
+        onStack[member] = false;
+        sccs[member] = scc;
+      } while (member != finished);
+      sccIsCyclic.push_back(cyclic);
+    }
+  }
+}
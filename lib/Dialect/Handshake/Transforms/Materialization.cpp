@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "PassDetails.h"
+#include "circt/Dialect/Handshake/HandshakeGraph.h"
 #include "circt/Dialect/Handshake/HandshakeOps.h"
 #include "circt/Dialect/Handshake/HandshakePasses.h"
 #include "circt/Support/LLVM.h"
@@ -139,6 +140,15 @@ struct HandshakeMaterializeForksSinksPass
         addSinkOps(op.getRegion(), builder).failed() ||
         verifyAllValuesHasOneUse(op).failed())
       return signalPassFailure();
+
+    // Forks and sinks only split and terminate channels, so a graph computed
+    // by an earlier pass can be updated rather than rebuilt by a later one.
+    if (auto graph = getCachedAnalysis<HandshakeGraph>()) {
+      for (Operation &innerOp : op.getOps())
+        if (isa<ForkOp, SinkOp>(innerOp) && !graph->get().lookupNode(&innerOp))
+          graph->get().insertNode(&innerOp);
+      markAnalysesPreserved<HandshakeGraph>();
+    }
   };
 };
 
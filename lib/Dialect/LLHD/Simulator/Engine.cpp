@@ -15,8 +15,18 @@
 
 #include "mlir/ExecutionEngine/ExecutionEngine.h"
 #include "mlir/IR/Builders.h"
+#include "mlir/Support/FileUtilities.h"
 
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 using namespace circt::llhd::sim;
 
@@ -24,12 +34,28 @@ Engine::Engine(
     llvm::raw_ostream &out, ModuleOp module,
     llvm::function_ref<mlir::LogicalResult(mlir::ModuleOp)> mlirTransformer,
     llvm::function_ref<llvm::Error(llvm::Module *)> llvmTransformer,
-    std::string root, TraceMode tm, ArrayRef<StringRef> sharedLibPaths)
+    std::string root, TraceMode tm, ArrayRef<StringRef> sharedLibPaths,
+    StringRef objectFile, bool enableObjectDump)
     : out(out), root(root), traceMode(tm) {
   state = std::make_unique<State>();
   state->root = root + '.' + root;
 
   buildLayout(module);
+  this->module = module;
+
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+
+  // Load the units compiled ahead of time, instead of lowering and compiling
+  // the module.
+  if (!objectFile.empty()) {
+    if (auto err = loadObject(objectFile, sharedLibPaths)) {
+      llvm::errs() << "Failed to load " << objectFile << ": "
+                   << llvm::toString(std::move(err)) << "\n";
+      exit(EXIT_FAILURE);
+    }
+    return;
+  }
 
   auto rootEntity = module.lookupSymbol<EntityOp>(root);
 
@@ -45,14 +71,10 @@ Engine::Engine(
     exit(EXIT_FAILURE);
   }
 
-  this->module = module;
-
-  llvm::InitializeNativeTarget();
-  llvm::InitializeNativeTargetAsmPrinter();
-
   mlir::ExecutionEngineOptions options;
   options.transformer = llvmTransformer;
   options.sharedLibPaths = sharedLibPaths;
+  options.enableObjectDump = enableObjectDump;
   auto maybeEngine = mlir::ExecutionEngine::create(this->module, options);
   assert(maybeEngine && "failed to create JIT");
   engine = std::move(*maybeEngine);
@@ -60,12 +82,211 @@ Engine::Engine(
 
 Engine::~Engine() = default;
 
+llvm::Error Engine::loadObject(StringRef objectFile,
+                               ArrayRef<StringRef> sharedLibPaths) {
+  auto buffer = llvm::MemoryBuffer::getFile(objectFile, /*IsText=*/false,
+                                            /*RequiresNullTerminator=*/false);
+  if (!buffer)
+    return llvm::errorCodeToError(buffer.getError());
+
+  auto jit = llvm::orc::LLJITBuilder().create();
+  if (!jit)
+    return jit.takeError();
+  objectJit = std::move(*jit);
+
+  // Resolve the runtime library calls and the libc functions used by the
+  // units, like the ExecutionEngine does.
+  auto &mainDylib = objectJit->getMainJITDylib();
+  auto prefix = objectJit->getDataLayout().getGlobalPrefix();
+  for (auto path : sharedLibPaths) {
+    auto generator =
+        llvm::orc::DynamicLibrarySearchGenerator::Load(path.str().c_str(),
+                                                       prefix);
+    if (!generator)
+      return generator.takeError();
+    mainDylib.addGenerator(std::move(*generator));
+  }
+  auto processGenerator =
+      llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(prefix);
+  if (!processGenerator)
+    return processGenerator.takeError();
+  mainDylib.addGenerator(std::move(*processGenerator));
+
+  return objectJit->addObjectFile(std::move(*buffer));
+}
+
+llvm::Expected<void (*)(void **)> Engine::lookupPacked(StringRef name) {
+  if (engine)
+    return engine->lookupPacked(name);
+
+  // The object contains the packed wrappers generated by the ExecutionEngine
+  // that compiled it.
+  auto symbol = objectJit->lookup(("_mlir_" + name).str());
+  if (!symbol)
+    return symbol.takeError();
+  return reinterpret_cast<void (*)(void **)>(symbol->getAddress());
+}
+
+int Engine::dumpObject(StringRef path) {
+  assert(engine && "objects can only be dumped from a JIT-compiled module");
+  // Compilation is lazy, make sure the module is compiled before dumping it.
+  if (auto fptr = lookupPacked("llhd_init"); !fptr) {
+    llvm::errs() << "Failed to compile the module: "
+                 << llvm::toString(fptr.takeError()) << "\n";
+    return -1;
+  }
+  engine->dumpToObjectFile(path);
+  return 0;
+}
+
+namespace {
+/// A fixed set of worker threads evaluating the woken up instances of a delta
+/// cycle in parallel, with the calling thread as the first worker. Workers
+/// claim one instance at a time, such that long-running units do not hold up
+/// the others. While the workers run, every event they schedule is deferred to
+/// a per-worker buffer, which are merged into the event queue once all
+/// instances of the delta have been evaluated.
+class InstanceEvaluator {
+public:
+  InstanceEvaluator(State &state, unsigned numThreads) : state(state) {
+    state.workers.resize(numThreads);
+    state.workers[0].thread = std::this_thread::get_id();
+    for (unsigned i = 1; i < numThreads; ++i) {
+      threads.emplace_back([this, i] { workerLoop(i); });
+      state.workers[i].thread = threads.back().get_id();
+    }
+  }
+
+  ~InstanceEvaluator() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    start.notify_all();
+    for (auto &thread : threads)
+      thread.join();
+    state.workers.clear();
+  }
+
+  /// Evaluate all `wakeups` with `runInstance`, and apply their events.
+  void run(ArrayRef<unsigned> wakeups,
+           llvm::function_ref<void(unsigned)> runInstance) {
+    this->wakeups = wakeups;
+    this->runInstance = runInstance;
+    next = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      state.deferEvents = true;
+      active = threads.size();
+      ++generation;
+    }
+    start.notify_all();
+
+    work(0);
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      done.wait(lock, [&] { return active == 0; });
+      state.deferEvents = false;
+    }
+    state.applyDeferredEvents();
+  }
+
+private:
+  void work(unsigned worker) {
+    auto &events = state.workers[worker];
+    for (unsigned i; (i = next.fetch_add(1)) < wakeups.size();) {
+      events.position = i;
+      events.instance = wakeups[i];
+      runInstance(wakeups[i]);
+    }
+  }
+
+  void workerLoop(unsigned worker) {
+    unsigned seen = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        start.wait(lock, [&] { return stop || generation != seen; });
+        if (stop)
+          return;
+        seen = generation;
+      }
+      work(worker);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--active == 0)
+          done.notify_one();
+      }
+    }
+  }
+
+  State &state;
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable start, done;
+  unsigned generation = 0, active = 0;
+  bool stop = false;
+  std::atomic<unsigned> next{0};
+  ArrayRef<unsigned> wakeups;
+  llvm::function_ref<void(unsigned)> runInstance;
+};
+} // namespace
+
+void Engine::enableProfiling() {
+  profiling = true;
+  state->profiling = true;
+}
+
+void Engine::printProfile(llvm::raw_ostream &os) const {
+  os << "::------------------- Profile ------------------::\n";
+  os << "real-time steps: " << simProfile.realSteps << "\n";
+  os << "delta steps: " << simProfile.deltaSteps << "\n";
+  os << "queued changes: " << simProfile.changes << "\n";
+  os << "signal updates: " << simProfile.updates << "\n";
+  os << "queued wakeups: " << simProfile.wakeups << "\n";
+
+  // List the instances by the time spent evaluating them.
+  SmallVector<const Instance *> instances;
+  for (auto &inst : state->instances)
+    instances.push_back(&inst);
+  llvm::stable_sort(instances, [](auto *lhs, auto *rhs) {
+    return lhs->profile.time > rhs->profile.time;
+  });
+
+  os << llvm::format("%12s %12s %12s %12s %12s  %s\n", "time (ms)",
+                     "activations", "delta", "drives", "wakeups", "instance");
+  for (auto *inst : instances) {
+    auto &profile = inst->profile;
+    os << llvm::format("%12.3f %12llu %12llu %12llu %12llu  ",
+                       profile.time.count() / 1e6,
+                       (unsigned long long)profile.activations,
+                       (unsigned long long)profile.deltaActivations,
+                       (unsigned long long)profile.drives,
+                       (unsigned long long)profile.wakeups)
+       << inst->path << "\n";
+  }
+  os << "::----------------------------------------------::\n";
+}
+
 void Engine::dumpStateLayout() { state->dumpLayout(); }
 
 void Engine::dumpStateSignalTriggers() { state->dumpSignalTriggers(); }
 
-int Engine::simulate(int n, uint64_t maxTime) {
-  assert(engine && "engine not found");
+int Engine::saveState(StringRef path) {
+  std::string errorMessage;
+  auto output = mlir::openOutputFile(path, &errorMessage);
+  if (!output) {
+    llvm::errs() << errorMessage << "\n";
+    return -1;
+  }
+  state->save(output->os());
+  output->keep();
+  return 0;
+}
+
+int Engine::simulate(int n, uint64_t maxTime, unsigned numThreads,
+                     StringRef checkpoint) {
+  assert((engine || objectJit) && "engine not found");
   assert(state && "state not found");
 
   auto tm = static_cast<TraceMode>(traceMode);
@@ -73,11 +294,32 @@ int Engine::simulate(int n, uint64_t maxTime) {
 
   SmallVector<void *, 1> arg({&state});
   // Initialize tbe simulation state.
-  auto invocationResult = engine->invokePacked("llhd_init", arg);
-  if (invocationResult) {
-    llvm::errs() << "Failed invocation of llhd_init: " << invocationResult;
+  auto initFPtr = lookupPacked("llhd_init");
+  if (!initFPtr) {
+    llvm::errs() << "Failed invocation of llhd_init: "
+                 << llvm::toString(initFPtr.takeError()) << "\n";
     return -1;
   }
+  (**initFPtr)(arg.data());
+  state->packSignals();
+  auto &signals = state->signalTable;
+
+  // Overwrite the initial state with the checkpoint to resume from.
+  bool restored = !checkpoint.empty();
+  if (restored) {
+    auto file = llvm::MemoryBuffer::getFile(checkpoint, /*IsText=*/false,
+                                            /*RequiresNullTerminator=*/false);
+    if (!file) {
+      llvm::errs() << "Could not open checkpoint " << checkpoint << ": "
+                   << file.getError().message() << "\n";
+      return -1;
+    }
+    if (auto err = state->restore((*file)->getBuffer())) {
+      llvm::errs() << "Failed to restore " << checkpoint << ": "
+                   << llvm::toString(std::move(err)) << "\n";
+      return -1;
+    }
+  }
 
   if (traceMode != TraceMode::None) {
     // Add changes for all the signals' initial values.
@@ -86,9 +328,10 @@ int Engine::simulate(int n, uint64_t maxTime) {
     }
   }
 
-  // Add a dummy event to get the simulation started.
-  state->queue.push_back(Slot(Time()));
-  ++state->queue.events;
+  // Add a dummy event to get the simulation started. A restored simulation
+  // continues with the checkpoint's pending events instead.
+  if (!restored)
+    state->queue.getOrCreateSlot(Time());
 
   // Keep track of the instances that need to wakeup.
   llvm::SmallVector<unsigned, 8> wakeupQueue;
@@ -96,9 +339,10 @@ int Engine::simulate(int n, uint64_t maxTime) {
   // Add all instances to the wakeup queue for the first run and add the jitted
   // function pointers to all of the instances to make them readily available.
   for (size_t i = 0, e = state->instances.size(); i < e; ++i) {
-    wakeupQueue.push_back(i);
+    if (!restored)
+      wakeupQueue.push_back(i);
     auto &inst = state->instances[i];
-    auto expectedFPtr = engine->lookupPacked(inst.unit);
+    auto expectedFPtr = lookupPacked(inst.unit);
     if (!expectedFPtr) {
       llvm::errs() << "Could not lookup " << inst.unit << "!\n";
       return -1;
@@ -106,6 +350,37 @@ int Engine::simulate(int n, uint64_t maxTime) {
     inst.unitFPtr = *expectedFPtr;
   }
 
+  auto runInstance = [&](unsigned i) {
+    auto &inst = state->instances[i];
+    auto signalTable = inst.sensitivityList.data();
+
+    // Gather the instance arguments for unit invocation.
+    SmallVector<void *, 3> args;
+    if (inst.isEntity)
+      args.assign({&state, &inst.entityState, &signalTable});
+    else {
+      args.assign({&state, &inst.procState, &signalTable});
+    }
+    if (!profiling) {
+      // Run the unit.
+      (*inst.unitFPtr)(args.data());
+      return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    (*inst.unitFPtr)(args.data());
+    inst.profile.time += std::chrono::steady_clock::now() - start;
+    ++inst.profile.activations;
+    if (state->time.getDelta() || state->time.getEps())
+      ++inst.profile.deltaActivations;
+  };
+
+  // The instances of a delta cycle only communicate through the event queue,
+  // so they can be evaluated in parallel.
+  std::unique_ptr<InstanceEvaluator> evaluator;
+  if (numThreads > 1)
+    evaluator = std::make_unique<InstanceEvaluator>(*state, numThreads);
+
   int cycle = 0;
   while (state->queue.events > 0) {
     const auto &pop = state->queue.top();
@@ -119,35 +394,42 @@ int Engine::simulate(int n, uint64_t maxTime) {
     // Update the simulation time.
     state->time = pop.time;
 
+    if (profiling) {
+      ++(pop.time.getDelta() || pop.time.getEps() ? simProfile.deltaSteps
+                                                    : simProfile.realSteps);
+      simProfile.changes += pop.changes.size();
+      simProfile.wakeups += pop.scheduled.size();
+    }
+
     if (traceMode != TraceMode::None)
       trace.flush();
 
     // Process signal changes.
-    size_t i = 0, e = pop.changesSize;
-    while (i < e) {
-      const auto sigIndex = pop.changes[i].first;
-      auto &curr = state->signals[sigIndex];
-      APInt buff(curr.getSize() * 8, 0);
-      llvm::LoadIntFromMemory(buff, curr.getValue(), curr.getSize());
-
-      // Apply the changes to the buffer until we reach the next signal.
-      while (i < e && pop.changes[i].first == sigIndex) {
-        const auto &change = pop.buffers[pop.changes[i].second];
-        const auto offset = change.first;
-        const auto &drive = change.second;
+    for (const auto &driven : pop.drivenSignals) {
+      const auto sigIndex = driven.index;
+      auto sigSize = signals.getSize(sigIndex);
+      APInt buff(sigSize * 8, 0);
+      llvm::LoadIntFromMemory(buff, signals.getValue(sigIndex), sigSize);
+
+      // Apply the changes of the signal to the buffer.
+      for (auto i = driven.first; i != Slot::noChange;
+           i = pop.changes[i].next) {
+        const auto &change = pop.changes[i];
+        const auto offset = change.bitOffset;
+        const auto drive = pop.getValue(change);
         if (drive.getBitWidth() < buff.getBitWidth())
           buff.insertBits(drive, offset);
         else
           buff = drive;
-
-        ++i;
       }
 
-      if (!curr.updateWhenChanged(buff.getRawData()))
+      if (!signals.updateWhenChanged(sigIndex, buff.getRawData()))
         continue;
+      if (profiling)
+        ++simProfile.updates;
 
       // Add sensitive instances.
-      for (auto inst : curr.getTriggeredInstanceIndices()) {
+      for (auto inst : signals.getTriggeredInstanceIndices(sigIndex)) {
         // Skip if the process is not currently sensible to the signal.
         if (!state->instances[inst].isEntity) {
           const auto &sensList = state->instances[inst].sensitivityList;
@@ -184,20 +466,13 @@ int Engine::simulate(int n, uint64_t maxTime) {
                       wakeupQueue.end());
 
     // Run the instances present in the wakeup queue.
-    for (auto i : wakeupQueue) {
-      auto &inst = state->instances[i];
-      auto signalTable = inst.sensitivityList.data();
-
-      // Gather the instance arguments for unit invocation.
-      SmallVector<void *, 3> args;
-      if (inst.isEntity)
-        args.assign({&state, &inst.entityState, &signalTable});
-      else {
-        args.assign({&state, &inst.procState, &signalTable});
+    if (evaluator && wakeupQueue.size() > 1)
+      evaluator->run(wakeupQueue, runInstance);
+    else
+      for (auto i : wakeupQueue) {
+        state->activeInstance = i;
+        runInstance(i);
       }
-      // Run the unit.
-      (*inst.unitFPtr)(args.data());
-    }
 
     // Clear wakeup queue.
     wakeupQueue.clear();
@@ -13,9 +13,15 @@
 
 #include "circt/Dialect/LLHD/Simulator/State.h"
 
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/MemAlloc.h"
+#include "llvm/Support/SwapByteOrder.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <string>
 
 using namespace llvm;
@@ -57,9 +63,55 @@ std::string Signal::toHexString(unsigned elemIndex) const {
   return ret;
 }
 
-Signal::~Signal() {
-  std::free(value);
-  value = nullptr;
+//===----------------------------------------------------------------------===//
+// SignalTable
+//===----------------------------------------------------------------------===//
+
+SignalTable::~SignalTable() {
+  if (arena)
+    deallocate_buffer(arena, arenaSize, alignof(uint64_t));
+}
+
+void SignalTable::pack(MutableArrayRef<Signal> signals,
+                       MutableArrayRef<Instance> instances) {
+  assert(!arena && "signals are already packed");
+
+  // Reserve twice the size of every value, like LLHDToLLVM does, such that
+  // shifting a signal does not read past its end.
+  offsets.reserve(signals.size());
+  sizes.reserve(signals.size());
+  for (auto &sig : signals) {
+    offsets.push_back(arenaSize);
+    sizes.push_back(sig.getSize());
+    arenaSize += alignTo(2 * sig.getSize(), alignof(uint64_t));
+  }
+  arenaSize = std::max<size_t>(arenaSize, alignof(uint64_t));
+  arena = static_cast<uint8_t *>(allocate_buffer(arenaSize, alignof(uint64_t)));
+  std::memset(arena, 0, arenaSize);
+
+  // Redirect every reference to a value to its copy in the arena.
+  for (auto &inst : instances)
+    for (auto &detail : inst.sensitivityList)
+      if (detail.value)
+        detail.value = getValue(detail.globalIndex) +
+                       (detail.value - signals[detail.globalIndex].getValue());
+
+  for (unsigned i = 0, e = signals.size(); i < e; ++i) {
+    auto *value = signals[i].getValue();
+    if (!value)
+      continue;
+    std::memcpy(getValue(i), value, sizes[i]);
+    std::free(value);
+    signals[i].store(getValue(i), sizes[i]);
+  }
+
+  triggerOffsets.reserve(signals.size() + 1);
+  for (auto &sig : signals) {
+    triggerOffsets.push_back(triggers.size());
+    auto indices = sig.getTriggeredInstanceIndices();
+    triggers.insert(triggers.end(), indices.begin(), indices.end());
+  }
+  triggerOffsets.push_back(triggers.size());
 }
 
 //===----------------------------------------------------------------------===//
@@ -70,28 +122,60 @@ bool Slot::operator<(const Slot &rhs) const { return time < rhs.time; }
 
 bool Slot::operator>(const Slot &rhs) const { return rhs.time < time; }
 
+/// Copy the `size` bytes of a signal value at `bytes` to 64-bit words.
+static void loadWords(uint64_t *words, const uint8_t *bytes, unsigned size) {
+  if (sys::IsLittleEndianHost) {
+    std::memcpy(words, bytes, size);
+    return;
+  }
+  APInt buffer(size * 8, 0);
+  llvm::LoadIntFromMemory(buffer, bytes, size);
+  std::memcpy(words, buffer.getRawData(), buffer.getNumWords() * 8);
+}
+
 void Slot::insertChange(int index, int bitOffset, uint8_t *bytes,
                         unsigned width) {
-  // Get the amount of 64 bit words required to store the value in an APInt.
+  Change change{static_cast<unsigned>(bitOffset), width, noChange, 0};
   auto size = llvm::divideCeil(width, 8);
-
-  APInt buffer(width, 0);
-  llvm::LoadIntFromMemory(buffer, bytes, size);
-  auto offsetBufferPair = std::make_pair(bitOffset, buffer);
-
-  if (changesSize >= buffers.size()) {
-    // Create a new change buffer if we don't have any unused one available for
-    // reuse.
-    buffers.push_back(offsetBufferPair);
+  if (width <= 64) {
+    loadWords(&change.value, bytes, size);
   } else {
-    // Reuse the first available buffer.
-    buffers[changesSize] = offsetBufferPair;
+    // Store wide values in the slot's arena, which is reused across slots.
+    change.value = wideValues.size();
+    wideValues.resize(wideValues.size() + llvm::divideCeil(width, 64), 0);
+    loadWords(&wideValues[change.value], bytes, size);
+  }
+
+  // Append the change to the list of its signal, such that the changes of one
+  // signal can be processed together, in the order they were driven.
+  unsigned changeIndex = changes.size();
+  changes.push_back(change);
+  auto [it, inserted] =
+      signalPositions.try_emplace(index, drivenSignals.size());
+  if (inserted) {
+    drivenSignals.push_back(
+        {static_cast<unsigned>(index), changeIndex, changeIndex});
+    return;
   }
+  auto &signal = drivenSignals[it->second];
+  changes[signal.last].next = changeIndex;
+  signal.last = changeIndex;
+}
+
+APInt Slot::getValue(const Change &change) const {
+  if (change.width <= 64)
+    return APInt(change.width, change.value);
+  return APInt(change.width,
+               makeArrayRef(wideValues)
+                   .slice(change.value, llvm::divideCeil(change.width, 64)));
+}
 
-  // Map the signal index to the change buffer so we can retrieve
-  // it after sorting.
-  changes.push_back(std::make_pair(index, changesSize));
-  ++changesSize;
+void Slot::clear() {
+  changes.clear();
+  wideValues.clear();
+  drivenSignals.clear();
+  signalPositions.clear();
+  scheduled.clear();
 }
 
 void Slot::insertChange(unsigned inst) { scheduled.push_back(inst); }
@@ -111,84 +195,65 @@ void UpdateQueue::insertOrUpdate(Time time, unsigned inst) {
 }
 
 Slot &UpdateQueue::getOrCreateSlot(Time time) {
-  auto &top = begin()[topSlot];
-
-  // Directly add to top slot.
-  if (!top.unused && time == top.time) {
-    return top;
-  }
-
-  // We need to search through the queue for an existing slot only if we're
-  // spawning an event later than the top slot. Adding to an existing slot
-  // scheduled earlier than the top slot should never happens, as then it should
-  // be the top.
-  if (events > 0 && top.time < time) {
-    for (size_t i = 0, e = size(); i < e; ++i) {
-      if (time == begin()[i].time) {
-        return begin()[i];
-      }
-    }
-  }
-
-  // Spawn new event using an existing slot.
+  // Return the slot if one is already scheduled at the given time.
+  auto [it, inserted] = slotIndex.try_emplace(time, 0);
+  if (!inserted)
+    return begin()[it->second];
+
+  // Spawn new event, reusing an existing slot if possible, or generating a new
+  // one if we do not have pre-allocated slots available.
+  unsigned index;
   if (!unused.empty()) {
-    auto firstUnused = unused.pop_back_val();
-    auto &newSlot = begin()[firstUnused];
+    index = unused.pop_back_val();
+    auto &newSlot = begin()[index];
     newSlot.unused = false;
     newSlot.time = time;
-
-    // Update the top of the queue either if it is currently unused or the new
-    // timestamp is earlier than it.
-    if (top.unused || time < top.time)
-      topSlot = firstUnused;
-
-    ++events;
-    return newSlot;
+  } else {
+    index = size();
+    push_back(Slot(time));
   }
+  it->second = index;
 
-  // We do not have pre-allocated slots available, generate a new one.
-  push_back(Slot(time));
-
-  // Update the top of the queue either if it is currently unused or the new
-  // timestamp is earlier than it.
-  if (top.unused || time < top.time)
-    topSlot = size() - 1;
-
+  pending.push_back(index);
+  std::push_heap(pending.begin(), pending.end(),
+                 [&](unsigned a, unsigned b) { return isLater(a, b); });
   ++events;
-  return back();
+  return begin()[index];
 }
 
 const Slot &UpdateQueue::top() {
-  assert(topSlot < size() && "top is pointing out of bounds!");
-
-  // Sort the changes of the top slot such that all changes to the same signal
-  // are in succession.
-  auto &top = begin()[topSlot];
-  llvm::sort(top.changes.begin(), top.changes.begin() + top.changesSize);
+  assert(!pending.empty() && "top of an empty queue!");
+
+  // Process the driven signals of the top slot in the order of their index.
+  // The changes are already bucketed by signal, so only the distinct signals
+  // need sorting.
+  auto &top = begin()[pending.front()];
+  llvm::sort(top.drivenSignals, [](const auto &lhs, const auto &rhs) {
+    return lhs.index < rhs.index;
+  });
   return top;
 }
 
 void UpdateQueue::pop() {
+  assert(!pending.empty() && "pop of an empty queue!");
+
+  // Remove the current top from the queue, which moves the next earliest slot
+  // to the top.
+  unsigned topSlot = pending.front();
+  std::pop_heap(pending.begin(), pending.end(),
+                [&](unsigned a, unsigned b) { return isLater(a, b); });
+  pending.pop_back();
+
   // Reset internal structures and decrease the event counter.
   auto &curr = begin()[topSlot];
+  slotIndex.erase(curr.time);
   curr.unused = true;
-  curr.changesSize = 0;
-  curr.scheduled.clear();
-  curr.changes.clear();
+  curr.clear();
   curr.time = Time();
   --events;
 
   // Add to unused slots list for easy retrieval.
   unused.push_back(topSlot);
-
-  // Update the current top of the queue.
-  topSlot = std::distance(
-      begin(),
-      std::min_element(begin(), end(), [](const auto &a, const auto &b) {
-        // a is "smaller" than b if either a's timestamp is earlier than b's, or
-        // b is unused (i.e. b has no actual meaning).
-        return !a.unused && (a < b || b.unused);
-      }));
 }
 
 //===----------------------------------------------------------------------===//
@@ -212,6 +277,12 @@ State::~State() {
       std::free(inst.procState->senses);
     }
   }
+  // Once packed, the signal values are owned by the signal table. Before that,
+  // free them since they are allocated using 'malloc' in the LLVM code
+  // generated by LLHDToLLVM.
+  if (!signalTable.isPacked())
+    for (auto &sig : signals)
+      std::free(sig.getValue());
 }
 
 Slot State::popQueue() {
@@ -223,10 +294,70 @@ Slot State::popQueue() {
 
 void State::pushQueue(Time t, unsigned inst) {
   Time newTime = time + t;
-  queue.insertOrUpdate(newTime, inst);
+  if (profiling)
+    ++instances[inst].profile.wakeups;
+  if (auto *deferred = getDeferredEvents())
+    deferred->wakeups.push_back({deferred->position, newTime, inst});
+  else
+    queue.insertOrUpdate(newTime, inst);
   instances[inst].expectedWakeup = newTime;
 }
 
+void State::pushDrive(Time t, unsigned index, int bitOffset, uint8_t *bytes,
+                      unsigned width) {
+  auto *deferred = getDeferredEvents();
+  if (profiling)
+    ++instances[deferred ? deferred->instance : activeInstance].profile.drives;
+  if (!deferred) {
+    queue.insertOrUpdate(t, index, bitOffset, bytes, width);
+    return;
+  }
+  deferred->drives.push_back(
+      {deferred->position, t, index, bitOffset, width,
+       SmallVector<uint8_t, 8>(bytes, bytes + divideCeil(width, 8))});
+}
+
+DeferredEvents *State::getDeferredEvents() {
+  if (!deferEvents)
+    return nullptr;
+  auto thread = std::this_thread::get_id();
+  for (auto &worker : workers)
+    if (worker.thread == thread)
+      return &worker;
+  return nullptr;
+}
+
+void State::applyDeferredEvents() {
+  // Every instance is evaluated by a single worker, which claims instances in
+  // ascending position. A stable sort by position therefore yields the order
+  // of a sequential evaluation.
+  SmallVector<DeferredEvents::Drive *> drives;
+  SmallVector<DeferredEvents::Wakeup *> wakeups;
+  for (auto &worker : workers) {
+    for (auto &drive : worker.drives)
+      drives.push_back(&drive);
+    for (auto &wakeup : worker.wakeups)
+      wakeups.push_back(&wakeup);
+  }
+  std::stable_sort(drives.begin(), drives.end(), [](auto *lhs, auto *rhs) {
+    return lhs->position < rhs->position;
+  });
+  std::stable_sort(wakeups.begin(), wakeups.end(), [](auto *lhs, auto *rhs) {
+    return lhs->position < rhs->position;
+  });
+
+  for (auto *drive : drives)
+    queue.insertOrUpdate(drive->time, drive->index, drive->bitOffset,
+                         drive->bytes.data(), drive->width);
+  for (auto *wakeup : wakeups)
+    queue.insertOrUpdate(wakeup->time, wakeup->inst);
+
+  for (auto &worker : workers) {
+    worker.drives.clear();
+    worker.wakeups.clear();
+  }
+}
+
 llvm::SmallVectorTemplateCommon<Instance>::iterator
 State::getInstanceIterator(std::string instName) {
   auto it =
@@ -243,12 +374,14 @@ int State::addSignal(std::string name, std::string owner) {
   return signals.size() - 1;
 }
 
-void State::addProcPtr(std::string name, ProcState *procStatePtr) {
+void State::addProcPtr(std::string name, ProcState *procStatePtr,
+                       uint64_t size) {
   auto it = getInstanceIterator(name);
 
   // Store instance index in process state.
   procStatePtr->inst = it - instances.begin();
   (*it).procState = procStatePtr;
+  (*it).procStateSize = size;
 }
 
 int State::addSignalData(int index, std::string owner, uint8_t *value,
@@ -277,6 +410,233 @@ void State::addSignalElement(unsigned index, unsigned offset, unsigned size) {
   signals[index].pushElement(std::make_pair(offset, size));
 }
 
+void State::packSignals() { signalTable.pack(signals, instances); }
+
+//===----------------------------------------------------------------------===//
+// Checkpoints
+//===----------------------------------------------------------------------===//
+
+static constexpr StringLiteral checkpointMagic = "LLHDSIM";
+static constexpr uint32_t checkpointVersion = 1;
+
+/// The persisted values of a process follow the fixed process state fields.
+/// The instance index and the senses pointer are layout dependent and kept
+/// as initialized.
+static constexpr size_t procPersistenceOffset =
+    offsetof(ProcState, resumeState);
+
+namespace {
+/// Write the fields of a checkpoint in little endian.
+struct CheckpointWriter {
+  CheckpointWriter(raw_ostream &os) : writer(os, support::little) {}
+
+  void write(uint64_t value) { writer.write(value); }
+
+  void write(const Time &time) {
+    write(time.getTime());
+    write(time.getDelta());
+    write(time.getEps());
+  }
+
+  void writeBytes(const uint8_t *bytes, uint64_t size) {
+    write(size);
+    writer.OS.write(reinterpret_cast<const char *>(bytes), size);
+  }
+
+  support::endian::Writer writer;
+};
+
+/// Read the fields of a checkpoint, recording the first read past its end.
+struct CheckpointReader {
+  CheckpointReader(StringRef data) : data(data) {}
+
+  uint64_t read() {
+    if (data.size() < sizeof(uint64_t)) {
+      failed = true;
+      data = {};
+      return 0;
+    }
+    auto value = support::endian::read64le(data.data());
+    data = data.drop_front(sizeof(uint64_t));
+    return value;
+  }
+
+  Time readTime() {
+    auto time = read();
+    auto delta = read();
+    auto eps = read();
+    return Time(time, delta, eps);
+  }
+
+  /// Read a byte sequence, which has to be `size` bytes long.
+  const uint8_t *readBytes(uint64_t size) {
+    if (read() != size || data.size() < size) {
+      failed = true;
+      data = {};
+      return nullptr;
+    }
+    auto *bytes = reinterpret_cast<const uint8_t *>(data.data());
+    data = data.drop_front(size);
+    return bytes;
+  }
+
+  /// Read a byte sequence of any length.
+  ArrayRef<uint8_t> readBytes() {
+    auto size = read();
+    if (failed || data.size() < size) {
+      failed = true;
+      data = {};
+      return {};
+    }
+    ArrayRef<uint8_t> bytes(reinterpret_cast<const uint8_t *>(data.data()),
+                            size);
+    data = data.drop_front(size);
+    return bytes;
+  }
+
+  StringRef data;
+  bool failed = false;
+};
+} // namespace
+
+void State::save(raw_ostream &os) const {
+  os << checkpointMagic;
+  CheckpointWriter writer(os);
+  writer.write(checkpointVersion);
+  writer.write(time);
+
+  writer.write(signals.size());
+  for (unsigned i = 0, e = signals.size(); i < e; ++i)
+    writer.writeBytes(signalTable.getValue(i), signalTable.getSize(i));
+
+  writer.write(instances.size());
+  for (auto &inst : instances) {
+    writer.write(inst.expectedWakeup);
+    writer.writeBytes(inst.entityState,
+                      inst.entityState ? inst.entityStateSize : 0);
+    if (!inst.procState) {
+      writer.write(0);
+      continue;
+    }
+    writer.write(1);
+    writer.write(inst.procState->resume);
+    writer.writeBytes(reinterpret_cast<const uint8_t *>(inst.procState->senses),
+                      inst.sensitivityList.size());
+    auto *procState = reinterpret_cast<const uint8_t *>(inst.procState);
+    auto persistenceSize = inst.procStateSize > procPersistenceOffset
+                               ? inst.procStateSize - procPersistenceOffset
+                               : 0;
+    writer.writeBytes(procState + procPersistenceOffset, persistenceSize);
+  }
+
+  // Store the pending slots with their changes in the order they are applied.
+  auto pending = queue.getPendingSlots();
+  writer.write(pending.size());
+  SmallVector<uint8_t, 8> bytes;
+  for (auto slotIndex : pending) {
+    auto &slot = queue[slotIndex];
+    writer.write(slot.time);
+    writer.write(slot.changes.size());
+    for (auto &driven : slot.drivenSignals) {
+      for (auto i = driven.first; i != Slot::noChange;
+           i = slot.changes[i].next) {
+        auto &change = slot.changes[i];
+        writer.write(driven.index);
+        writer.write(change.bitOffset);
+        writer.write(change.width);
+        bytes.assign(divideCeil(change.width, 8), 0);
+        StoreIntToMemory(slot.getValue(change), bytes.data(), bytes.size());
+        writer.writeBytes(bytes.data(), bytes.size());
+      }
+    }
+    writer.write(slot.scheduled.size());
+    for (auto inst : slot.scheduled)
+      writer.write(inst);
+  }
+}
+
+Error State::restore(StringRef data) {
+  auto mismatch = [] {
+    return createStringError(inconvertibleErrorCode(),
+                             "checkpoint does not match the simulated design");
+  };
+  if (!data.consume_front(checkpointMagic))
+    return createStringError(inconvertibleErrorCode(),
+                             "file is not an llhd-sim checkpoint");
+  CheckpointReader reader(data);
+  if (reader.read() != checkpointVersion)
+    return createStringError(inconvertibleErrorCode(),
+                             "unsupported checkpoint version");
+  auto restoredTime = reader.readTime();
+
+  if (reader.read() != signals.size())
+    return mismatch();
+  for (unsigned i = 0, e = signals.size(); i < e; ++i) {
+    auto size = signalTable.getSize(i);
+    auto *bytes = reader.readBytes(size);
+    if (reader.failed)
+      return mismatch();
+    std::memcpy(signalTable.getValue(i), bytes, size);
+  }
+
+  if (reader.read() != instances.size())
+    return mismatch();
+  for (auto &inst : instances) {
+    inst.expectedWakeup = reader.readTime();
+    auto entityStateSize = inst.entityState ? inst.entityStateSize : 0;
+    auto *entityState = reader.readBytes(entityStateSize);
+    if (reader.failed)
+      return mismatch();
+    if (entityStateSize)
+      std::memcpy(inst.entityState, entityState, entityStateSize);
+
+    if (reader.read() != (inst.procState != nullptr))
+      return mismatch();
+    if (!inst.procState)
+      continue;
+    inst.procState->resume = reader.read();
+    auto *senses = reader.readBytes(inst.sensitivityList.size());
+    auto persistenceSize = inst.procStateSize > procPersistenceOffset
+                               ? inst.procStateSize - procPersistenceOffset
+                               : 0;
+    auto *persistence = reader.readBytes(persistenceSize);
+    if (reader.failed)
+      return mismatch();
+    std::memcpy(inst.procState->senses, senses, inst.sensitivityList.size());
+    std::memcpy(reinterpret_cast<uint8_t *>(inst.procState) +
+                    procPersistenceOffset,
+                persistence, persistenceSize);
+  }
+
+  // Replace the pending events.
+  while (queue.events > 0)
+    queue.pop();
+  for (uint64_t i = 0, e = reader.read(); i < e && !reader.failed; ++i) {
+    auto &slot = queue.getOrCreateSlot(reader.readTime());
+    for (uint64_t j = 0, f = reader.read(); j < f && !reader.failed; ++j) {
+      unsigned index = reader.read();
+      unsigned bitOffset = reader.read();
+      unsigned width = reader.read();
+      auto bytes = reader.readBytes();
+      if (index >= signals.size() || bytes.size() != divideCeil(width, 8))
+        return mismatch();
+      SmallVector<uint8_t, 8> buffer(bytes.begin(), bytes.end());
+      slot.insertChange(index, bitOffset, buffer.data(), width);
+    }
+    for (uint64_t j = 0, f = reader.read(); j < f && !reader.failed; ++j) {
+      unsigned inst = reader.read();
+      if (inst >= instances.size())
+        return mismatch();
+      slot.insertChange(inst);
+    }
+  }
+  if (reader.failed || !reader.data.empty())
+    return mismatch();
+
+  time = restoredTime;
+  return Error::success();
+}
+
 void State::dumpSignal(llvm::raw_ostream &out, int index) {
   auto &sig = signals[index];
   for (auto inst : sig.getTriggeredInstanceIndices()) {
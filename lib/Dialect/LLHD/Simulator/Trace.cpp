@@ -13,8 +13,12 @@
 
 #include "circt/Dialect/LLHD/Simulator/Trace.h"
 
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <cstring>
+
 using namespace circt::llhd::sim;
 
 Trace::Trace(std::unique_ptr<State> const &state, llvm::raw_ostream &out,
@@ -23,7 +27,7 @@ Trace::Trace(std::unique_ptr<State> const &state, llvm::raw_ostream &out,
   auto root = state->root;
   for (auto &sig : state->signals) {
     bool done = (mode != TraceMode::Full && mode != TraceMode::Merged &&
-                 !sig.isOwner(root)) ||
+                 mode != TraceMode::VCD && !sig.isOwner(root)) ||
                 (mode == TraceMode::NamedOnly && sig.isValidSigName());
     isTraced.push_back(!done);
   }
@@ -87,6 +91,15 @@ void Trace::addChange(unsigned sigIndex) {
     } else if (mode == TraceMode::Merged || mode == TraceMode::MergedReduce ||
                mode == TraceMode::NamedOnly) {
       addChangeMerged(sigIndex);
+    } else if (mode == TraceMode::VCD) {
+      // Only remember which signal changed, the values are compared against
+      // the last dumped ones when flushing.
+      if (vcdValues.empty())
+        writeVCDHeader();
+      if (!vcdIsChanged[sigIndex]) {
+        vcdIsChanged[sigIndex] = true;
+        vcdChanged.push_back(sigIndex);
+      }
     }
   }
 }
@@ -125,6 +138,9 @@ void Trace::flush(bool force) {
            mode == TraceMode::NamedOnly)
     if (state->time.getTime() > currentTime.getTime() || force)
       flushMerged();
+  if (mode == TraceMode::VCD)
+    if (state->time.getTime() > currentTime.getTime() || force)
+      flushVCD();
 }
 
 void Trace::flushFull() {
@@ -170,3 +186,137 @@ void Trace::flushMerged() {
     changes.clear();
   }
 }
+
+//===----------------------------------------------------------------------===//
+// VCD format
+//===----------------------------------------------------------------------===//
+
+/// Print the VCD identifier code of the value with the given index.
+static void printVCDIdentifier(llvm::raw_ostream &os, unsigned index) {
+  // Identifier codes are composed of the printable ASCII characters from '!'
+  // to '~'.
+  do {
+    os << static_cast<char>('!' + index % 94);
+    index /= 94;
+  } while (index);
+}
+
+void Trace::writeVCDHeader() {
+  // Assign every traced signal and signal element an identifier. The signal
+  // elements are only known once the simulation state is initialized.
+  vcdFirstValue.resize(state->signals.size());
+  vcdIsChanged.resize(state->signals.size());
+  for (size_t i = 0, e = state->signals.size(); i < e; ++i) {
+    auto &sig = state->signals[i];
+    vcdFirstValue[i] = vcdValues.size();
+    if (!isTraced[i])
+      continue;
+    auto addValue = [&](int elem, size_t offset, size_t size) {
+      vcdValues.push_back({i, elem, offset, vcdLastBytes.size(), size});
+      vcdLastBytes.resize(vcdLastBytes.size() + size);
+    };
+    if (!sig.hasElement()) {
+      addValue(-1, 0, sig.getSize());
+      continue;
+    }
+    for (size_t elem = 0, ee = sig.getElementSize(); elem < ee; ++elem) {
+      auto element = sig.getElement(elem);
+      addValue(elem, element.first, element.second);
+    }
+  }
+
+  // Declare each value in the scope of every instance it is connected to,
+  // sharing the identifier among all of them. The scopes are ordered by their
+  // hierarchical path, such that every instance directly follows its parent.
+  std::map<std::vector<std::string>, std::vector<unsigned>> scopes;
+  for (size_t index = 0, e = vcdValues.size(); index < e; ++index) {
+    auto &sig = state->signals[vcdValues[index].sigIndex];
+    for (auto inst : sig.getTriggeredInstanceIndices()) {
+      std::vector<std::string> path;
+      llvm::StringRef rest = state->instances[inst].path;
+      while (!rest.empty()) {
+        auto split = rest.split('/');
+        path.push_back(split.first.str());
+        rest = split.second;
+      }
+      scopes[path].push_back(index);
+    }
+  }
+
+  out << "$timescale 1ps $end\n";
+  std::vector<std::string> current;
+  for (auto &scope : scopes) {
+    auto &path = scope.first;
+    // Close the scopes which are not a prefix of this one and open the new
+    // ones.
+    size_t common = 0;
+    while (common < current.size() && common < path.size() &&
+           current[common] == path[common])
+      ++common;
+    for (size_t i = common, e = current.size(); i < e; ++i)
+      out << "$upscope $end\n";
+    for (size_t i = common, e = path.size(); i < e; ++i)
+      out << "$scope module " << path[i] << " $end\n";
+    current = path;
+
+    for (auto index : scope.second) {
+      auto &value = vcdValues[index];
+      out << "$var wire " << value.size * 8 << ' ';
+      printVCDIdentifier(out, index);
+      out << ' ' << state->signals[value.sigIndex].getName();
+      if (value.elem >= 0)
+        out << '[' << value.elem << ']';
+      out << " $end\n";
+    }
+  }
+  for (size_t i = 0, e = current.size(); i < e; ++i)
+    out << "$upscope $end\n";
+  out << "$enddefinitions $end\n";
+}
+
+void Trace::flushVCD() {
+  if (vcdChanged.empty())
+    return;
+
+  // Dump the values in identifier order, and only the ones whose raw bytes
+  // differ from the last dumped ones. The first flush dumps all values.
+  llvm::sort(vcdChanged);
+  bool timeDumped = false;
+  for (auto sigIndex : vcdChanged) {
+    vcdIsChanged[sigIndex] = false;
+    auto *bytes = state->signals[sigIndex].getValue();
+    auto end = sigIndex + 1 < vcdFirstValue.size() ? vcdFirstValue[sigIndex + 1]
+                                                   : vcdValues.size();
+    for (auto index = vcdFirstValue[sigIndex]; index < end; ++index) {
+      auto &value = vcdValues[index];
+      auto *current = bytes + value.sigOffset;
+      auto *last = vcdLastBytes.data() + value.lastOffset;
+      if (vcdDumpedAll && std::memcmp(current, last, value.size) == 0)
+        continue;
+      std::memcpy(last, current, value.size);
+
+      if (!timeDumped) {
+        out << '#' << currentTime.getTime() << '\n';
+        timeDumped = true;
+      }
+
+      // Print the value in binary, most significant bit first, dropping any
+      // leading zeros.
+      out << 'b';
+      bool leading = true;
+      for (size_t byte = value.size; byte-- > 0;)
+        for (int bit = 7; bit >= 0; --bit) {
+          bool set = (current[byte] >> bit) & 1;
+          if (leading && !set && (byte || bit))
+            continue;
+          leading = false;
+          out << (set ? '1' : '0');
+        }
+      out << ' ';
+      printVCDIdentifier(out, index);
+      out << '\n';
+    }
+  }
+  vcdChanged.clear();
+  vcdDumpedAll = true;
+}
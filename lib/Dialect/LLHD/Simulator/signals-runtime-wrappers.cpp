@@ -41,16 +41,19 @@ void addSigStructElement(State *state, unsigned index, unsigned offset,
   state->addSignalElement(index, offset, size);
 }
 
-void allocProc(State *state, char *owner, ProcState *procState) {
+void allocProc(State *state, char *owner, ProcState *procState,
+               int64_t size) {
   assert(state && "alloc_proc: state not found");
   std::string sOwner(owner);
-  state->addProcPtr(sOwner, procState);
+  state->addProcPtr(sOwner, procState, size);
 }
 
-void allocEntity(State *state, char *owner, uint8_t *entityState) {
+void allocEntity(State *state, char *owner, uint8_t *entityState,
+                 int64_t size) {
   assert(state && "alloc_entity: state not found");
   auto it = state->getInstanceIterator(owner);
   (*it).entityState = entityState;
+  (*it).entityStateSize = size;
 }
 
 void driveSignal(State *state, SignalDetail *detail, uint8_t *value,
@@ -61,11 +64,17 @@ void driveSignal(State *state, SignalDetail *detail, uint8_t *value,
   auto offset = detail->offset;
 
   int bitOffset =
-      (detail->value - state->signals[globalIndex].getValue()) * 8 + offset;
+      (detail->value - state->signalTable.getValue(globalIndex)) * 8 + offset;
 
   // Spawn a new event.
-  state->queue.insertOrUpdate(state->time + Time(time, delta, eps), globalIndex,
-                              bitOffset, value, width);
+  state->pushDrive(state->time + Time(time, delta, eps), globalIndex, bitOffset,
+                   value, width);
+}
+
+void driveSignals(State *state, PendingDrive *drives, uint64_t count) {
+  for (auto &drive : llvm::makeArrayRef(drives, count))
+    driveSignal(state, drive.signal, drive.value, drive.width, drive.time,
+                drive.delta, drive.eps);
 }
 
 void llhdSuspend(State *state, ProcState *procState, int time, int delta,
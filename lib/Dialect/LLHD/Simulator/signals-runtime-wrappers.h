@@ -17,6 +17,17 @@
 
 extern "C" {
 
+/// A drive recorded by the code generated by LLHDToLLVM with `batch-drives`.
+/// This must match the struct of the drive buffers built by LLHDToLLVM.
+struct PendingDrive {
+  circt::llhd::sim::SignalDetail *signal;
+  uint8_t *value;
+  uint64_t width;
+  int64_t time;
+  int64_t delta;
+  int64_t eps;
+};
+
 //===----------------------------------------------------------------------===//
 // Runtime interfaces
 //===----------------------------------------------------------------------===//
@@ -36,19 +47,23 @@ void addSigArrayElements(circt::llhd::sim::State *state, unsigned index,
 void addSigStructElement(circt::llhd::sim::State *state, unsigned index,
                          unsigned offset, unsigned size);
 
-/// Add allocated constructs to a process instance.
+/// Add allocated constructs of `size` bytes to a process instance.
 void allocProc(circt::llhd::sim::State *state, char *owner,
-               circt::llhd::sim::ProcState *procState);
+               circt::llhd::sim::ProcState *procState, int64_t size);
 
-/// Add allocated entity state to the given instance.
+/// Add allocated entity state of `size` bytes to the given instance.
 void allocEntity(circt::llhd::sim::State *state, char *owner,
-                 uint8_t *entityState);
+                 uint8_t *entityState, int64_t size);
 
 /// Drive a value onto a signal.
 void driveSignal(circt::llhd::sim::State *state,
                  circt::llhd::sim::SignalDetail *index, uint8_t *value,
                  uint64_t width, int time, int delta, int eps);
 
+/// Drive the `count` recorded drives, in order.
+void driveSignals(circt::llhd::sim::State *state, PendingDrive *drives,
+                  uint64_t count);
+
 /// Suspend a process.
 void llhdSuspend(circt::llhd::sim::State *state,
                  circt::llhd::sim::ProcState *procState, int time, int delta,
@@ -0,0 +1,90 @@
+//===- EntityInliningPass.cpp - Implement Entity Inlining Pass ------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Implement pass to inline entity instances into their parent entity.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt/Dialect/LLHD/IR/LLHDOps.h"
+#include "circt/Dialect/LLHD/Transforms/Passes.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/SymbolTable.h"
+#include "llvm/ADT/DenseSet.h"
+
+using namespace circt;
+using namespace llhd;
+
+namespace {
+
+struct EntityInliningPass
+    : public llhd::EntityInliningBase<EntityInliningPass> {
+  void runOnOperation() override;
+
+  /// Inline all entity instances in `entity`, after inlining the instances in
+  /// the instantiated entities.
+  void inlineInstances(EntityOp entity);
+
+  SymbolTable *symbolTable;
+  // The entities whose instances are inlined, or are being inlined.
+  DenseSet<Operation *> done, inProgress;
+};
+
+/// Replace `inst` with a copy of the body of `child`, prefixing the names of
+/// the copied signals and instances with the instance name.
+static void inlineInstance(InstOp inst, EntityOp child) {
+  BlockAndValueMapping mapping;
+  auto *body = child.getBodyBlock();
+  for (auto [arg, operand] :
+       llvm::zip(body->getArguments(), inst.getOperands()))
+    mapping.map(arg, operand);
+
+  OpBuilder builder(inst);
+  auto prefix = (inst.getName() + "/").str();
+  for (auto &op : *body) {
+    auto *clone = builder.clone(op, mapping);
+    if (auto sig = dyn_cast<SigOp>(clone))
+      sig.setNameAttr(builder.getStringAttr(prefix + sig.getName()));
+    else if (auto nested = dyn_cast<InstOp>(clone))
+      nested.setNameAttr(builder.getStringAttr(prefix + nested.getName()));
+  }
+  inst.erase();
+}
+
+void EntityInliningPass::inlineInstances(EntityOp entity) {
+  if (done.count(entity) || !inProgress.insert(entity).second)
+    return;
+
+  for (auto inst :
+       llvm::make_early_inc_range(entity.getBodyBlock()->getOps<InstOp>())) {
+    auto child = symbolTable->lookup<EntityOp>(inst.getCallee());
+    // Keep process and recursive instances.
+    if (!child || inProgress.count(child))
+      continue;
+    inlineInstances(child);
+    inlineInstance(inst, child);
+  }
+
+  inProgress.erase(entity);
+  done.insert(entity);
+}
+
+void EntityInliningPass::runOnOperation() {
+  SymbolTable table(getOperation());
+  symbolTable = &table;
+
+  for (auto entity : getOperation().getOps<EntityOp>())
+    inlineInstances(entity);
+}
+} // namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+circt::llhd::createEntityInliningPass() {
+  return std::make_unique<EntityInliningPass>();
+}
@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "PassDetails.h"
+#include "TemporalRegions.h"
 #include "circt/Dialect/LLHD/Transforms/Passes.h"
 #include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -30,8 +31,8 @@ struct MemoryToBlockArgumentPass
 
 /// Add the dominance fontier blocks of 'frontierOf' to the 'df' set
 static void getDominanceFrontier(Block *frontierOf, Operation *op,
+                                 mlir::DominanceInfo &dom,
                                  std::set<Block *> &df) {
-  mlir::DominanceInfo dom(op);
   for (Block &block : op->getRegion(0).getBlocks()) {
     for (Block *pred : block.getPredecessors()) {
       if (dom.dominates(frontierOf, pred) &&
@@ -46,15 +47,16 @@ static void getDominanceFrontier(Block *frontierOf, Operation *op,
 /// Add the blocks in the closure of the dominance fontier relation of all the
 /// block in 'initialSet' to 'closure'
 static void getDFClosure(SmallVectorImpl<Block *> &initialSet, Operation *op,
+                         mlir::DominanceInfo &dom,
                          std::set<Block *> &closure) {
   unsigned numElements;
   for (Block *block : initialSet) {
-    getDominanceFrontier(block, op, closure);
+    getDominanceFrontier(block, op, dom, closure);
   }
   do {
     numElements = closure.size();
     for (Block *block : closure) {
-      getDominanceFrontier(block, op, closure);
+      getDominanceFrontier(block, op, dom, closure);
     }
   } while (numElements < closure.size());
 }
@@ -92,7 +94,11 @@ void MemoryToBlockArgumentPass::runOnOperation() {
     return WalkResult::advance();
   });
   if (result.wasInterrupted())
-    return;
+    return markAllAnalysesPreserved();
+
+  // Only block arguments and memory operations are added and removed, the CFG
+  // stays the same for all variables.
+  auto &dom = getAnalysis<mlir::DominanceInfo>();
 
   // Get all variables defined in the body of this operation
   // Note that variables that are passed as a function argument are not
@@ -129,7 +135,7 @@ void MemoryToBlockArgumentPass::runOnOperation() {
 
     // Calculate initial set of join points
     std::set<Block *> joinPoints;
-    getDFClosure(defBlocks, operation, joinPoints);
+    getDFClosure(defBlocks, operation, dom, joinPoints);
 
     for (Block *jp : joinPoints) {
       // Add a block argument for the variable at each join point
@@ -238,6 +244,8 @@ void MemoryToBlockArgumentPass::runOnOperation() {
     op->dropAllReferences();
     op->erase();
   }
+
+  markAnalysesPreserved<llhd::TemporalRegionAnalysis, mlir::DominanceInfo>();
 }
 
 std::unique_ptr<OperationPass<llhd::ProcOp>>
@@ -14,6 +14,7 @@
 #include "circt/Dialect/LLHD/IR/LLHDOps.h"
 #include "circt/Dialect/LLHD/Transforms/Passes.h"
 #include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/IR/Visitors.h"
 
 using namespace mlir;
@@ -117,11 +118,16 @@ static LogicalResult isProcValidToLower(llhd::ProcOp op) {
 void ProcessLoweringPass::runOnOperation() {
   ModuleOp module = getOperation();
 
-  WalkResult result = module.walk([](llhd::ProcOp op) -> WalkResult {
-    // Check invariants
-    if (failed(isProcValidToLower(op)))
-      return WalkResult::interrupt();
+  // Check the invariants of all processes in parallel before lowering any of
+  // them, which is where most of the time goes. The lowering itself replaces
+  // the processes in the module and has to be done serially.
+  SmallVector<llhd::ProcOp> procs;
+  module.walk([&](llhd::ProcOp op) { procs.push_back(op); });
+  if (failed(mlir::failableParallelForEach(&getContext(), procs,
+                                           isProcValidToLower)))
+    return signalPassFailure();
 
+  for (auto op : procs) {
     OpBuilder builder(op);
 
     // Replace proc with entity
@@ -161,12 +167,7 @@ void ProcessLoweringPass::runOnOperation() {
     terminator->dropAllReferences();
     terminator->dropAllUses();
     terminator->erase();
-
-    return WalkResult::advance();
-  });
-
-  if (result.wasInterrupted())
-    signalPassFailure();
+  }
 }
 } // namespace
 
@@ -20,6 +20,10 @@
 namespace circt {
 namespace llhd {
 
+/// The temporal regions of a process. This can be used as an analysis of the
+/// pass manager, `getAnalysis<TemporalRegionAnalysis>()` on a process, such
+/// that it is computed once and shared by the passes which do not change the
+/// CFG of the process.
 struct TemporalRegionAnalysis {
   using BlockMapT = DenseMap<Block *, int>;
   using TRMapT = DenseMap<int, SmallVector<Block *, 8>>;
@@ -11,7 +11,11 @@
 #include "circt/Dialect/MSFT/MSFTOps.h"
 
 #include "mlir/IR/Builders.h"
+#include "mlir/Support/FileUtilities.h"
 #include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ToolOutputFile.h"
 
 using namespace circt;
 using namespace msft;
@@ -52,22 +56,100 @@ PrimitiveDB::DimPrimitiveType &PrimitiveDB::getLeaf(PhysLocationAttr loc) {
 
 void PrimitiveDB::foreach (
     function_ref<void(PhysLocationAttr)> callback) const {
-  for (auto x : placements)
-    for (auto y : x.second)
-      for (auto n : y.second)
+  foreachLocation([&](PrimitiveType p, uint64_t x, uint64_t y, uint64_t num) {
+    callback(PhysLocationAttr::get(ctxt, PrimitiveTypeAttr::get(ctxt, p), x, y,
+                                   num));
+  });
+}
+
+void PrimitiveDB::foreachLocation(
+    function_ref<void(PrimitiveType, uint64_t, uint64_t, uint64_t)> callback)
+    const {
+  for (auto &x : placements)
+    for (auto &y : x.second)
+      for (auto &n : y.second)
         for (auto p : n.second)
-          callback(PhysLocationAttr::get(ctxt, PrimitiveTypeAttr::get(ctxt, p),
-                                         x.first, y.first, n.first));
+          callback(p, x.first, y.first, n.first);
+}
+
+// A PrimitiveDB file is a header followed by one record per primitive, all
+// little-endian:
+//
+//   header: char magic[8], uint32_t version, uint64_t numRecords
+//   record: uint64_t x, uint64_t y, uint64_t num, uint32_t primitiveType
+static constexpr char primitiveDBMagic[8] = {'M', 'S', 'F', 'T',
+                                             'P', 'R', 'I', 'M'};
+static constexpr uint32_t primitiveDBVersion = 1;
+static constexpr size_t primitiveDBHeaderSize = 8 + 4 + 8;
+static constexpr size_t primitiveDBRecordSize = 8 + 8 + 8 + 4;
+
+LogicalResult PrimitiveDB::save(StringRef path) const {
+  std::string errorMessage;
+  auto output = mlir::openOutputFile(path, &errorMessage);
+  if (!output)
+    return mlir::emitError(UnknownLoc::get(ctxt)) << errorMessage;
+
+  uint64_t numRecords = 0;
+  foreachLocation([&](PrimitiveType, uint64_t, uint64_t, uint64_t) {
+    ++numRecords;
+  });
+
+  llvm::support::endian::Writer writer(output->os(), llvm::support::little);
+  output->os().write(primitiveDBMagic, sizeof(primitiveDBMagic));
+  writer.write<uint32_t>(primitiveDBVersion);
+  writer.write<uint64_t>(numRecords);
+  foreachLocation([&](PrimitiveType p, uint64_t x, uint64_t y, uint64_t num) {
+    writer.write<uint64_t>(x);
+    writer.write<uint64_t>(y);
+    writer.write<uint64_t>(num);
+    writer.write<uint32_t>(static_cast<uint32_t>(p));
+  });
+
+  output->keep();
+  return success();
+}
+
+LogicalResult PrimitiveDB::load(StringRef path) {
+  auto error = [&]() {
+    return mlir::emitError(UnknownLoc::get(ctxt))
+           << "cannot load primitive DB '" << path << "': ";
+  };
+
+  auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false,
+                                            /*RequiresNullTerminator=*/false);
+  if (!buffer)
+    return error() << buffer.getError().message();
+
+  using namespace llvm::support;
+  StringRef data = (*buffer)->getBuffer();
+  if (data.size() < primitiveDBHeaderSize ||
+      !data.startswith(StringRef(primitiveDBMagic, sizeof(primitiveDBMagic))))
+    return error() << "not a primitive DB file";
+  const char *ptr = data.data() + sizeof(primitiveDBMagic);
+  uint32_t version = endian::readNext<uint32_t, little, unaligned>(ptr);
+  if (version != primitiveDBVersion)
+    return error() << "unsupported version " << version;
+  uint64_t numRecords = endian::readNext<uint64_t, little, unaligned>(ptr);
+  if ((data.size() - primitiveDBHeaderSize) / primitiveDBRecordSize <
+      numRecords)
+    return error() << "truncated file";
+
+  for (uint64_t i = 0; i < numRecords; ++i) {
+    uint64_t x = endian::readNext<uint64_t, little, unaligned>(ptr);
+    uint64_t y = endian::readNext<uint64_t, little, unaligned>(ptr);
+    uint64_t num = endian::readNext<uint64_t, little, unaligned>(ptr);
+    uint32_t rawPrim = endian::readNext<uint32_t, little, unaligned>(ptr);
+    Optional<PrimitiveType> prim = symbolizePrimitiveType(rawPrim);
+    if (!prim)
+      return error() << "unknown primitive type " << rawPrim;
+    placements[x][y][num].insert(*prim);
+  }
+  return success();
 }
 
 //===----------------------------------------------------------------------===//
 // PlacementDB.
 //===----------------------------------------------------------------------===//
-// NOTE: Nothing in this implementation is in any way the most optimal
-// implementation. We put off deciding what the correct data structure is until
-// we have a better handle of the operations it must accelerate. Performance is
-// not an immediate goal.
-//===----------------------------------------------------------------------===//
 
 PlacementDB::PlacementDB(mlir::ModuleOp topMod)
     : ctxt(topMod->getContext()), topMod(topMod), seeded(false) {
@@ -76,7 +158,10 @@ PlacementDB::PlacementDB(mlir::ModuleOp topMod)
 PlacementDB::PlacementDB(mlir::ModuleOp topMod, const PrimitiveDB &seed)
     : ctxt(topMod->getContext()), topMod(topMod), seeded(false) {
 
-  seed.foreach ([this](PhysLocationAttr loc) { (void)getLeaf(loc); });
+  seed.foreachLocation(
+      [this](PrimitiveType prim, uint64_t x, uint64_t y, uint64_t num) {
+        (void)placements[x][y][num][prim];
+      });
   seeded = true;
   addDesignPlacements();
 }
@@ -298,51 +383,87 @@ void PlacementDB::movePlacement(DynInstDataOpInterface op,
 
 /// Lookup the instance at a particular location.
 DynInstDataOpInterface PlacementDB::getInstanceAt(PhysLocationAttr loc) {
-  auto innerMap = placements[loc.getX()][loc.getY()][loc.getNum()];
-  auto instF = innerMap.find(loc.getPrimitiveType().getValue());
-  if (instF == innerMap.end())
-    return {};
-  if (!instF->getSecond().locOp)
+  PlacementCell *leaf = findLeaf(loc);
+  if (!leaf)
     return {};
-  return instF->getSecond().locOp;
+  return leaf->locOp;
 }
 
 PhysLocationAttr PlacementDB::getNearestFreeInColumn(PrimitiveType prim,
                                                      uint64_t columnNum,
                                                      uint64_t nearestToY) {
-  // Simplest possible algorithm.
-  PhysLocationAttr nearest = {};
-  walkPlacements(
-      [&nearest, nearestToY](PhysLocationAttr loc, Operation *locOp) {
-        if (locOp)
-          return;
-        if (!nearest) {
-          nearest = loc;
-          return;
-        }
-        int64_t curDist =
-            std::abs((int64_t)nearestToY - (int64_t)nearest.getY());
-        int64_t replDist = std::abs((int64_t)nearestToY - (int64_t)loc.getY());
-        if (replDist < curDist)
-          nearest = loc;
-      },
-      std::make_tuple(columnNum, columnNum, -1, -1), prim);
-  return nearest;
+  auto colF = placements.find(columnNum);
+  if (colF == placements.end())
+    return {};
+  DimYMap &rows = colF->second;
+
+  // Return the location of the first free `prim` in a row, if any.
+  auto getFree = [&](DimYMap::iterator rowF) -> PhysLocationAttr {
+    for (auto &numF : rowF->second) {
+      auto devF = numF.second.find(prim);
+      if (devF != numF.second.end() && !devF->second.locOp)
+        return PhysLocationAttr::get(ctxt, PrimitiveTypeAttr::get(ctxt, prim),
+                                     columnNum, rowF->first, numF.first);
+    }
+    return {};
+  };
+
+  // Search outwards from `nearestToY` for the closest free row in either
+  // direction. On a tie, the lower row wins.
+  PhysLocationAttr above, below;
+  auto split = rows.lower_bound(nearestToY);
+  for (auto rowF = split; rowF != rows.end() && !above; ++rowF)
+    above = getFree(rowF);
+  for (auto rowF = split; rowF != rows.begin() && !below;)
+    below = getFree(--rowF);
+
+  if (!above || !below)
+    return above ? above : below;
+  uint64_t aboveDist = above.getY() - nearestToY;
+  uint64_t belowDist = nearestToY - below.getY();
+  return aboveDist < belowDist ? above : below;
 }
 
 PlacementDB::PlacementCell *PlacementDB::getLeaf(PhysLocationAttr loc) {
+  if (seeded)
+    return findLeaf(loc);
   PrimitiveType primType = loc.getPrimitiveType().getValue();
+  return &placements[loc.getX()][loc.getY()][loc.getNum()][primType];
+}
 
-  DimNumMap &nums = placements[loc.getX()][loc.getY()];
-  if (!seeded)
-    return &nums[loc.getNum()][primType];
-  if (!nums.count(loc.getNum()))
+PlacementDB::PlacementCell *PlacementDB::findLeaf(PhysLocationAttr loc) {
+  auto colF = placements.find(loc.getX());
+  if (colF == placements.end())
     return {};
-
-  DimDevType &primitives = nums[loc.getNum()];
-  if (primitives.count(primType) == 0)
+  auto rowF = colF->second.find(loc.getY());
+  if (rowF == colF->second.end())
+    return {};
+  auto numF = rowF->second.find(loc.getNum());
+  if (numF == rowF->second.end())
     return {};
-  return &primitives[primType];
+  auto devF = numF->second.find(loc.getPrimitiveType().getValue());
+  if (devF == numF->second.end())
+    return {};
+  return &devF->second;
+}
+
+/// Call `callback` on the entries of the sorted `map` with keys in [lo, hi],
+/// in descending order of their keys for DESC and in ascending order otherwise.
+template <typename MapT, typename CallbackT>
+static void walkRange(MapT &map, uint64_t lo, uint64_t hi,
+                      PlacementDB::Direction direction, CallbackT callback) {
+  if (lo > hi)
+    return;
+  auto begin = map.lower_bound(lo), end = map.upper_bound(hi);
+  if (direction == PlacementDB::Direction::DESC) {
+    for (auto it = std::make_reverse_iterator(end),
+              e = std::make_reverse_iterator(begin);
+         it != e; ++it)
+      callback(it->first, it->second);
+    return;
+  }
+  for (auto it = begin; it != end; ++it)
+    callback(it->first, it->second);
 }
 
 /// Walker for placements.
@@ -357,66 +478,37 @@ void PlacementDB::walkPlacements(
   uint64_t ymax = std::get<3>(bounds) < 0 ? std::numeric_limits<uint64_t>::max()
                                           : (uint64_t)std::get<3>(bounds);
 
-  // TODO: Since the data structures we're using aren't sorted, the best we can
-  // do is iterate and filter. If a specific order is requested, we sort the
-  // keys by that as we go. Once we get to performance, we'll figure out the
-  // right data structure.
-
-  auto maybeSort = [](auto &container, auto direction) {
-    if (!direction.has_value())
-      return;
-    if (*direction == Direction::NONE)
-      return;
-
-    llvm::sort(container, [direction](auto colA, auto colB) {
-      if (*direction == Direction::ASC)
-        return colA.first < colB.first;
-
-      return colA.first > colB.first;
-    });
-  };
+  // Without a walk order, the dimensions are walked in ascending order.
+  Direction colOrder = walkOrder ? walkOrder->columns : Direction::NONE;
+  Direction rowOrder = walkOrder ? walkOrder->rows : Direction::NONE;
 
   // X loop.
-  SmallVector<std::pair<size_t, DimYMap>> cols(placements.begin(),
-                                               placements.end());
-  maybeSort(cols, walkOrder.transform([](auto wo) { return wo.columns; }));
-  for (auto colF : cols) {
-    size_t x = colF.first;
-    if (x < xmin || x > xmax)
-      continue;
-    DimYMap yMap = colF.second;
-
+  walkRange(placements, xmin, xmax, colOrder, [&](size_t x, DimYMap &yMap) {
     // Y loop.
-    SmallVector<std::pair<size_t, DimNumMap>> rows(yMap.begin(), yMap.end());
-    maybeSort(rows, walkOrder.transform([](auto wo) { return wo.rows; }));
-    for (auto rowF : rows) {
-      size_t y = rowF.first;
-      if (y < ymin || y > ymax)
-        continue;
-      DimNumMap numMap = rowF.second;
-
+    walkRange(yMap, ymin, ymax, rowOrder, [&](size_t y, DimNumMap &numMap) {
       // Num loop.
-      for (auto numF = numMap.begin(), numE = numMap.end(); numF != numE;
-           ++numF) {
-        size_t num = numF->getFirst();
-        DimDevType devMap = numF->getSecond();
+      for (auto &numF : numMap) {
+        size_t num = numF.first;
+        DimDevType &devMap = numF.second;
 
         // DevType loop.
-        for (auto devF = devMap.begin(), devE = devMap.end(); devF != devE;
-             ++devF) {
-          PrimitiveType devtype = devF->getFirst();
-          if (primType && devtype != *primType)
-            continue;
-          PlacementCell &inst = devF->getSecond();
-
+        auto emit = [&](PrimitiveType devtype, PlacementCell &inst) {
           // Marshall and run the callback.
           PhysLocationAttr loc = PhysLocationAttr::get(
               ctxt, PrimitiveTypeAttr::get(ctxt, devtype), x, y, num);
           callback(loc, inst.locOp);
+        };
+        if (primType) {
+          auto devF = devMap.find(*primType);
+          if (devF != devMap.end())
+            emit(devF->first, devF->second);
+          continue;
         }
+        for (auto &devF : devMap)
+          emit(devF.first, devF.second);
       }
-    }
-  }
+    });
+  });
 }
 
 /// Walk the region placement information.
@@ -22,6 +22,8 @@
 #include "circt/Dialect/Seq/SeqOps.h"
 #include "circt/Support/LLVM.h"
 #include "mlir/IR/Builders.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Tools/mlir-translate/Translation.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/TypeSwitch.h"
@@ -78,11 +80,67 @@ Operation *TclEmitter::getDefinition(FlatSymbolRefAttr sym) {
 
 // TODO: Currently assumes Stratix 10 and QuartusPro. Make more general.
 namespace {
-/// Utility struct to assist in output and track other relevent state which are
-/// not specific to the entity hierarchy (global WRT to the entity hierarchy).
+/// Utility struct to track the state which is shared by all the Tcl emitted for
+/// a module: the symbol references of the verbatim op and the Tcl paths of the
+/// global refs. Many placements share a global ref, so its path is only built
+/// once.
 struct TclOutputState {
-  TclOutputState(TclEmitter &emitter, llvm::raw_ostream &os)
-      : os(os), emitter(emitter) {}
+  TclOutputState(TclEmitter &emitter) : emitter(emitter) {}
+
+  TclEmitter &emitter;
+  SmallVector<Attribute> symbolRefs;
+
+  /// Return the index of a symbol reference in the verbatim op, adding it on
+  /// first use.
+  size_t getSymbolRefIndex(Attribute ref) {
+    auto [it, inserted] = symbolRefIndices.try_emplace(ref, symbolRefs.size());
+    if (inserted)
+      symbolRefs.push_back(ref);
+    return it->second;
+  }
+
+  /// Get the GlobalRefOp to which the given operation is pointing. Add it to
+  /// the set of used global refs and build its path.
+  GlobalRefOp getRefOp(DynInstDataOpInterface op) {
+    auto ref = dyn_cast_or_null<hw::GlobalRefOp>(
+        emitter.getDefinition(op.getGlobalRefSym()));
+    if (!ref) {
+      op.emitOpError("could not find hw.globalRef named ")
+          << op.getGlobalRefSym();
+      return {};
+    }
+    emitter.usedRef(ref);
+    auto [it, inserted] = paths.try_emplace(ref);
+    if (inserted) {
+      llvm::raw_string_ostream os(it->second);
+      // Traverse each part of the path.
+      llvm::interleave(
+          ref.getNamepathAttr().getAsRange<hw::InnerRefAttr>(), os,
+          [&](hw::InnerRefAttr part) {
+            os << "{{" << getSymbolRefIndex(part) << "}}";
+          },
+          "|");
+    }
+    return ref;
+  }
+
+  /// Return the path of a global ref resolved by `getRefOp`.
+  StringRef getPath(GlobalRefOp ref) const {
+    return paths.find(ref)->second;
+  }
+
+private:
+  DenseMap<Attribute, size_t> symbolRefIndices;
+  DenseMap<Operation *, std::string> paths;
+};
+
+/// Writes the Tcl of a single operation. It only reads the output state, so
+/// that operations can be written concurrently once all their global refs are
+/// resolved.
+struct TclOpWriter {
+  TclOpWriter(const TclOutputState &state, GlobalRefOp ref,
+              llvm::raw_ostream &os)
+      : os(os), state(state), ref(ref) {}
 
   llvm::raw_ostream &os;
   llvm::raw_ostream &indent() {
@@ -90,63 +148,31 @@ struct TclOutputState {
     return os;
   };
 
-  TclEmitter &emitter;
-  SmallVector<Attribute> symbolRefs;
+  const TclOutputState &state;
+  /// The global ref of the operation being written.
+  GlobalRefOp ref;
 
   void emit(PhysLocationAttr);
-  LogicalResult emitLocationAssignment(DynInstDataOpInterface refOp,
-                                       PhysLocationAttr,
-                                       Optional<StringRef> subpath);
+  void emitLocationAssignment(PhysLocationAttr, Optional<StringRef> subpath);
 
   LogicalResult emit(PDPhysRegionOp region);
   LogicalResult emit(PDPhysLocationOp loc);
   LogicalResult emit(PDRegPhysLocationOp);
   LogicalResult emit(DynamicInstanceVerbatimAttrOp attr);
 
-  void emitPath(hw::GlobalRefOp ref, Optional<StringRef> subpath);
-  void emitInnerRefPart(hw::InnerRefAttr innerRef);
-
-  /// Get the GlobalRefOp to which the given operation is pointing. Add it to
-  /// the set of used global refs.
-  GlobalRefOp getRefOp(DynInstDataOpInterface op) {
-    auto ref = dyn_cast_or_null<hw::GlobalRefOp>(
-        emitter.getDefinition(op.getGlobalRefSym()));
-    if (ref)
-      emitter.usedRef(ref);
-    else
-      op.emitOpError("could not find hw.globalRef named ")
-          << op.getGlobalRefSym();
-    return ref;
-  }
+  void emitPath(Optional<StringRef> subpath);
 };
 } // anonymous namespace
 
-void TclOutputState::emitInnerRefPart(hw::InnerRefAttr innerRef) {
-  // We append new symbolRefs to the state, so s.symbolRefs.size() is the
-  // index of the InnerRefAttr we are about to add.
-  os << "{{" << symbolRefs.size() << "}}";
-
-  // Append a new inner reference for the template above.
-  symbolRefs.push_back(innerRef);
-}
-
-void TclOutputState::emitPath(hw::GlobalRefOp ref,
-                              Optional<StringRef> subpath) {
-  // Traverse each part of the path.
-  auto parts = ref.getNamepathAttr().getAsRange<hw::InnerRefAttr>();
-  auto lastPart = std::prev(parts.end());
-  for (auto part : parts) {
-    emitInnerRefPart(part);
-    if (part != *lastPart)
-      os << '|';
-  }
+void TclOpWriter::emitPath(Optional<StringRef> subpath) {
+  os << state.getPath(ref);
 
   // Some placements don't require subpaths.
   if (subpath)
     os << subpath;
 }
 
-void TclOutputState::emit(PhysLocationAttr pla) {
+void TclOpWriter::emit(PhysLocationAttr pla) {
   // Different devices have different 'number' letters (the 'N' in 'N0'). M20Ks
   // and DSPs happen to have the same one, probably because they never co-exist
   // at the same location.
@@ -174,35 +200,29 @@ void TclOutputState::emit(PhysLocationAttr pla) {
 /// Emit tcl in the form of:
 /// "set_location_assignment MPDSP_X34_Y285_N0 -to
 /// $parent|fooInst|entityName(subpath)"
-LogicalResult
-TclOutputState::emitLocationAssignment(DynInstDataOpInterface refOp,
-                                       PhysLocationAttr loc,
-                                       Optional<StringRef> subpath) {
+void TclOpWriter::emitLocationAssignment(PhysLocationAttr loc,
+                                         Optional<StringRef> subpath) {
   indent() << "set_location_assignment ";
   emit(loc);
 
   // To which entity does this apply?
   os << " -to $parent|";
-  emitPath(getRefOp(refOp), subpath);
-
-  return success();
+  emitPath(subpath);
 }
 
-LogicalResult TclOutputState::emit(PDPhysLocationOp loc) {
-  if (failed(emitLocationAssignment(loc, loc.getLoc(), loc.getSubPath())))
-    return failure();
+LogicalResult TclOpWriter::emit(PDPhysLocationOp loc) {
+  emitLocationAssignment(loc.getLoc(), loc.getSubPath());
   os << '\n';
   return success();
 }
 
-LogicalResult TclOutputState::emit(PDRegPhysLocationOp locs) {
+LogicalResult TclOpWriter::emit(PDRegPhysLocationOp locs) {
   ArrayRef<PhysLocationAttr> locArr = locs.getLocs().getLocs();
   for (size_t i = 0, e = locArr.size(); i < e; ++i) {
     PhysLocationAttr pla = locArr[i];
     if (!pla)
       continue;
-    if (failed(emitLocationAssignment(locs, pla, {})))
-      return failure();
+    emitLocationAssignment(pla, {});
     os << "[" << i << "]\n";
   }
   return success();
@@ -210,14 +230,13 @@ LogicalResult TclOutputState::emit(PDRegPhysLocationOp locs) {
 
 /// Emit tcl in the form of:
 /// "set_global_assignment -name NAME VALUE -to $parent|fooInst|entityName"
-LogicalResult TclOutputState::emit(DynamicInstanceVerbatimAttrOp attr) {
-  GlobalRefOp ref = getRefOp(attr);
+LogicalResult TclOpWriter::emit(DynamicInstanceVerbatimAttrOp attr) {
   indent() << "set_instance_assignment -name " << attr.getName() << " "
            << attr.getValue();
 
   // To which entity does this apply?
   os << " -to $parent|";
-  emitPath(ref, attr.getSubPath());
+  emitPath(attr.getSubPath());
   os << '\n';
   return success();
 }
@@ -227,11 +246,9 @@ LogicalResult TclOutputState::emit(DynamicInstanceVerbatimAttrOp attr) {
 /// set_instance_assignment -name RESERVE_PLACE_REGION OFF -to $parent|a|b|c
 /// set_instance_assignment -name CORE_ONLY_PLACE_REGION ON -to $parent|a|b|c
 /// set_instance_assignment -name REGION_NAME test_region -to $parent|a|b|c
-LogicalResult TclOutputState::emit(PDPhysRegionOp region) {
-  GlobalRefOp ref = getRefOp(region);
-
+LogicalResult TclOpWriter::emit(PDPhysRegionOp region) {
   auto physicalRegion = dyn_cast_or_null<DeclPhysicalRegionOp>(
-      emitter.getDefinition(region.getPhysRegionRefAttr()));
+      state.emitter.getDefinition(region.getPhysRegionRefAttr()));
   if (!physicalRegion)
     return region.emitOpError(
                "could not find physical region declaration named ")
@@ -253,26 +270,26 @@ LogicalResult TclOutputState::emit(PDPhysRegionOp region) {
   os << '"';
 
   os << " -to $parent|";
-  emitPath(ref, region.getSubPath());
+  emitPath(region.getSubPath());
   os << '\n';
 
   // RESERVE_PLACE_REGION directive.
   indent() << "set_instance_assignment -name RESERVE_PLACE_REGION OFF";
   os << " -to $parent|";
-  emitPath(ref, region.getSubPath());
+  emitPath(region.getSubPath());
   os << '\n';
 
   // CORE_ONLY_PLACE_REGION directive.
   indent() << "set_instance_assignment -name CORE_ONLY_PLACE_REGION ON";
   os << " -to $parent|";
-  emitPath(ref, region.getSubPath());
+  emitPath(region.getSubPath());
   os << '\n';
 
   // REGION_NAME directive.
   indent() << "set_instance_assignment -name REGION_NAME ";
   os << physicalRegion.getName();
   os << " -to $parent|";
-  emitPath(ref, region.getSubPath());
+  emitPath(region.getSubPath());
   os << '\n';
   return success();
 }
@@ -287,36 +304,60 @@ LogicalResult TclEmitter::emit(Operation *hwMod, StringRef outputFile) {
   // Build up the output Tcl, tracking symbol references in state.
   std::string s;
   llvm::raw_string_ostream os(s);
-  TclOutputState state(*this, os);
+  TclOutputState state(*this);
+  MLIRContext *context = hwMod->getContext();
 
   // Iterate through all the "instances" for 'hwMod' and produce a tcl proc for
   // each one.
   for (auto tclOpsForInstancesKV : tclOpsForModInstance[hwMod]) {
     StringAttr instName = tclOpsForInstancesKV.first;
-    os << "proc {{" << state.symbolRefs.size() << "}}";
+    os << "proc {{" << state.getSymbolRefIndex(SymbolRefAttr::get(hwMod))
+       << "}}";
     if (instName)
       os << '_' << instName.getValue();
     os << "_config { parent } {\n";
-    state.symbolRefs.push_back(SymbolRefAttr::get(hwMod));
 
-    // Loop through the ops relevant to the specified root module "instance".
-    LogicalResult ret = success();
+    // Resolve the global refs of the ops relevant to the specified root module
+    // "instance" first, which builds the symbol references in order. The ops
+    // which cannot be resolved are skipped.
     auto &tclOpsForMod = tclOpsForInstancesKV.second;
-    for (Operation *tclOp : tclOpsForMod) {
-      LogicalResult rc =
-          TypeSwitch<Operation *, LogicalResult>(tclOp)
-              .Case([&](PDPhysLocationOp op) { return state.emit(op); })
-              .Case([&](PDRegPhysLocationOp op) { return state.emit(op); })
-              .Case([&](PDPhysRegionOp op) { return state.emit(op); })
-              .Case([&](DynamicInstanceVerbatimAttrOp op) {
-                return state.emit(op);
-              })
-              .Default([](Operation *op) {
-                return op->emitOpError("could not determine how to output tcl");
-              });
-      if (failed(rc))
-        ret = failure();
+    SmallVector<GlobalRefOp, 0> refs;
+    refs.reserve(tclOpsForMod.size());
+    for (DynInstDataOpInterface tclOp : tclOpsForMod)
+      refs.push_back(state.getRefOp(tclOp));
+
+    // Then write the ops into separate buffers, in parallel if enabled, and
+    // concatenate them in order.
+    SmallVector<std::string, 0> buffers(tclOpsForMod.size());
+    auto emitOp = [&](size_t i) {
+      if (!refs[i])
+        return;
+      llvm::raw_string_ostream opOS(buffers[i]);
+      TclOpWriter writer(state, refs[i], opOS);
+      (void)TypeSwitch<Operation *, LogicalResult>(tclOpsForMod[i])
+          .Case([&](PDPhysLocationOp op) { return writer.emit(op); })
+          .Case([&](PDRegPhysLocationOp op) { return writer.emit(op); })
+          .Case([&](PDPhysRegionOp op) { return writer.emit(op); })
+          .Case([&](DynamicInstanceVerbatimAttrOp op) {
+            return writer.emit(op);
+          })
+          .Default([](Operation *op) {
+            return op->emitOpError("could not determine how to output tcl");
+          });
+    };
+    if (context->isMultithreadingEnabled()) {
+      ParallelDiagnosticHandler diagHandler(context);
+      mlir::parallelFor(context, 0, tclOpsForMod.size(), [&](size_t i) {
+        diagHandler.setOrderIDForThread(i);
+        emitOp(i);
+        diagHandler.eraseOrderIDForThread();
+      });
+    } else {
+      for (size_t i = 0, e = tclOpsForMod.size(); i < e; ++i)
+        emitOp(i);
     }
+    for (auto &buffer : buffers)
+      os << buffer;
     os << "}\n\n";
   }
 
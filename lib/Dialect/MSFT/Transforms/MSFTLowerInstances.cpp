@@ -19,6 +19,7 @@
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassRegistry.h"
 #include "mlir/Transforms/DialectConversion.h"
@@ -45,21 +46,20 @@ struct LowerInstancesPass : public LowerInstancesBase<LowerInstancesPass> {
   // Cache the top-level symbols. Insert the new ones we're creating for new
   // global ref ops.
   SymbolCache topSyms;
+  // The suffix to try first for the next global ref op symbol. Since symbols
+  // are only ever added, all the ones before it are known to be taken.
+  unsigned nextRefSymCtr = 0;
 
-  // In order to be efficient, cache the "symbols" in each module.
+  // In order to be efficient, cache the "symbols" in each module. The caches
+  // are built up front, in parallel.
   DenseMap<MSFTModuleOp, SymbolCache> perModSyms;
-  // Accessor for `perModSyms` which lazily constructs each cache.
+  // Accessor for `perModSyms` which lazily constructs any missing cache.
   const SymbolCache &getSyms(MSFTModuleOp mod);
 };
 } // anonymous namespace
 
-const SymbolCache &LowerInstancesPass::getSyms(MSFTModuleOp mod) {
-  auto symsFound = perModSyms.find(mod);
-  if (symsFound != perModSyms.end())
-    return symsFound->getSecond();
-
-  // Build the cache.
-  SymbolCache &syms = perModSyms[mod];
+/// Populate `syms` with the "symbols" in `mod`.
+static void buildSyms(MSFTModuleOp mod, SymbolCache &syms) {
   mod.walk([&syms, mod](Operation *op) {
     if (op == mod)
       return;
@@ -67,6 +67,16 @@ const SymbolCache &LowerInstancesPass::getSyms(MSFTModuleOp mod) {
             op->getAttrOfType<StringAttr>(SymbolTable::getSymbolAttrName()))
       syms.addDefinition(name, op);
   });
+}
+
+const SymbolCache &LowerInstancesPass::getSyms(MSFTModuleOp mod) {
+  auto symsFound = perModSyms.find(mod);
+  if (symsFound != perModSyms.end())
+    return symsFound->getSecond();
+
+  // Build the cache.
+  SymbolCache &syms = perModSyms[mod];
+  buildSyms(mod, syms);
   return syms;
 }
 
@@ -83,12 +93,14 @@ LogicalResult LowerInstancesPass::lower(DynamicInstanceOp inst,
       })) {
 
     // Come up with a unique symbol name.
-    auto refSym = StringAttr::get(&getContext(), "instref");
-    auto origRefSym = refSym;
-    unsigned ctr = 0;
+    auto getRefSym = [&](unsigned ctr) {
+      if (ctr == 0)
+        return StringAttr::get(&getContext(), "instref");
+      return StringAttr::get(&getContext(), "instref_" + Twine(ctr));
+    };
+    auto refSym = getRefSym(nextRefSymCtr);
     while (topSyms.getDefinition(refSym))
-      refSym = StringAttr::get(&getContext(),
-                               origRefSym.getValue() + "_" + Twine(++ctr));
+      refSym = getRefSym(++nextRefSymCtr);
 
     // Create a global ref to replace us.
     ArrayAttr globalRefPath = inst.globalRefPath();
@@ -151,6 +163,15 @@ void LowerInstancesPass::runOnOperation() {
   // Populate the top level symbol cache.
   topSyms.addDefinitions(top);
 
+  // Build the per-module symbol caches. Create all the entries first so that
+  // the map is not modified while the caches are being populated.
+  SmallVector<MSFTModuleOp> mods(top.getOps<MSFTModuleOp>());
+  for (MSFTModuleOp mod : mods)
+    perModSyms[mod];
+  mlir::parallelForEach(ctxt, mods, [&](MSFTModuleOp mod) {
+    buildSyms(mod, perModSyms.find(mod)->getSecond());
+  });
+
   size_t numFailed = 0;
   OpBuilder builder(ctxt);
 
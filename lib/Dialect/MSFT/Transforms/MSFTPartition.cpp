@@ -117,8 +117,11 @@ static bool isDrivenByPartOpsOnly(Operation *op,
 
 /// Move the list of tagged operations in to 'partBlock' and copy/move any free
 /// (wire) ops connecting them in also. If 'extendMaximalUp` is specified,
-/// attempt to copy all the way up to the block args.
-void copyIntoPart(ArrayRef<Operation *> taggedOps, Block *partBlock,
+/// attempt to copy all the way up to the block args. 'allTaggedOps' is the set
+/// of ops carrying a partition tag in the module, so that the tags need not be
+/// looked up again for every user.
+void copyIntoPart(ArrayRef<Operation *> taggedOps,
+                  const DenseSet<Operation *> &allTaggedOps, Block *partBlock,
                   bool extendMaximalUp) {
   BlockAndValueMapping map;
   if (taggedOps.empty())
@@ -182,7 +185,7 @@ void copyIntoPart(ArrayRef<Operation *> taggedOps, Block *partBlock,
     // Move any "free" consumers which we can.
     for (auto *user : llvm::make_early_inc_range(op.getUsers())) {
       // Stop if it's not "free" or already in a partition.
-      if (!isWireManipulationOp(user) || getPart(user) ||
+      if (!isWireManipulationOp(user) || allTaggedOps.contains(user) ||
           user->getBlock() == partBlock)
         continue;
       // Op must also only have its operands driven (or indirectly driven) by
@@ -203,30 +206,41 @@ void copyIntoPart(ArrayRef<Operation *> taggedOps, Block *partBlock,
 }
 
 /// Move tagged ops into separate blocks. Copy any wire ops connecting them as
-/// well.
+/// well. The ops are classified in a single walk, then each partition's ops are
+/// copied in one go, in the order the partitions were found.
 void copyInto(MSFTModuleOp mod, DenseMap<SymbolRefAttr, Block *> &perPartBlocks,
               Block *nonLocalBlock) {
-  DenseMap<SymbolRefAttr, SmallVector<Operation *, 8>> perPartTaggedOps;
+  DenseMap<SymbolRefAttr, unsigned> partIndices;
+  SmallVector<std::pair<Block *, SmallVector<Operation *, 8>>> perPartTaggedOps;
   SmallVector<Operation *, 16> nonLocalTaggedOps;
+  DenseSet<Operation *> allTaggedOps;
 
   // Bucket the ops by partition tag.
   mod.walk([&](Operation *op) {
     auto partRef = getPart(op);
     if (!partRef)
       return;
-    auto partBlockF = perPartBlocks.find(partRef);
-    if (partBlockF != perPartBlocks.end())
-      perPartTaggedOps[partRef].push_back(op);
-    else
-      nonLocalTaggedOps.push_back(op);
+    allTaggedOps.insert(op);
+    auto partIdxF = partIndices.find(partRef);
+    if (partIdxF == partIndices.end()) {
+      auto partBlockF = perPartBlocks.find(partRef);
+      if (partBlockF == perPartBlocks.end()) {
+        nonLocalTaggedOps.push_back(op);
+        return;
+      }
+      partIdxF =
+          partIndices.try_emplace(partRef, perPartTaggedOps.size()).first;
+      perPartTaggedOps.emplace_back(partBlockF->second,
+                                    SmallVector<Operation *, 8>());
+    }
+    perPartTaggedOps[partIdxF->second].second.push_back(op);
   });
 
   // Copy into the appropriate partition block.
-  for (auto &partOpQueuePair : perPartTaggedOps) {
-    copyIntoPart(partOpQueuePair.second, perPartBlocks[partOpQueuePair.first],
+  for (auto &partBlockOpsPair : perPartTaggedOps)
+    copyIntoPart(partBlockOpsPair.second, allTaggedOps, partBlockOpsPair.first,
                  false);
-  }
-  copyIntoPart(nonLocalTaggedOps, nonLocalBlock, true);
+  copyIntoPart(nonLocalTaggedOps, allTaggedOps, nonLocalBlock, true);
 }
 
 void PartitionPass::partition(MSFTModuleOp mod) {
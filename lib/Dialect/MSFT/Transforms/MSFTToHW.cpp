@@ -18,10 +18,12 @@
 #include "circt/Dialect/SV/SVOps.h"
 #include "circt/Dialect/Seq/SeqOps.h"
 #include "circt/Support/Namespace.h"
+#include "circt/Support/SymCache.h"
 
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassRegistry.h"
 #include "mlir/Transforms/DialectConversion.h"
@@ -36,21 +38,28 @@ using namespace msft;
 
 namespace {
 /// Lower MSFT's InstanceOp to HW's. Currently trivial since `msft.instance` is
-/// currently a subset of `hw.instance`.
+/// currently a subset of `hw.instance`. The referenced modules are resolved
+/// through a symbol cache of the top level, which is shared by all the modules
+/// being converted.
 struct InstanceOpLowering : public OpConversionPattern<InstanceOp> {
 public:
-  using OpConversionPattern::OpConversionPattern;
+  InstanceOpLowering(MLIRContext *context, const SymbolCache &topSyms)
+      : OpConversionPattern::OpConversionPattern(context), topSyms(topSyms) {}
 
   LogicalResult
   matchAndRewrite(InstanceOp, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const final;
+
+private:
+  const SymbolCache &topSyms;
 };
 } // anonymous namespace
 
 LogicalResult
 InstanceOpLowering::matchAndRewrite(InstanceOp msftInst, OpAdaptor adaptor,
                                     ConversionPatternRewriter &rewriter) const {
-  Operation *referencedModule = msftInst.getReferencedModule();
+  Operation *referencedModule =
+      topSyms.getDefinition(msftInst.getModuleNameAttr());
   if (!referencedModule)
     return rewriter.notifyMatchFailure(msftInst,
                                        "Could not find referenced module");
@@ -215,14 +224,26 @@ void LowerToHWPass::runOnOperation() {
   if (failed(applyPartialConversion(top, target, std::move(patterns))))
     signalPassFailure();
 
-  // Then, convert the InstanceOps
+  // Then, convert the InstanceOps. They only reference modules at the top
+  // level, so each module can be converted on its own, concurrently, against a
+  // symbol cache which is populated before any conversion starts.
   target.addDynamicallyLegalDialect<MSFTDialect>([](Operation *op) {
     return isa<DynInstDataOpInterface, DeclPhysicalRegionOp,
                InstanceHierarchyOp>(op);
   });
-  RewritePatternSet instancePatterns(ctxt);
-  instancePatterns.insert<InstanceOpLowering>(ctxt);
-  if (failed(applyPartialConversion(top, target, std::move(instancePatterns))))
+  SymbolCache topSyms;
+  topSyms.addDefinitions(top);
+  RewritePatternSet instancePatternSet(ctxt);
+  instancePatternSet.insert<InstanceOpLowering>(ctxt, topSyms);
+  FrozenRewritePatternSet instancePatterns(std::move(instancePatternSet));
+
+  SmallVector<Operation *> mods;
+  for (Operation &op : top.getOps())
+    if (op.getNumRegions() > 0)
+      mods.push_back(&op);
+  if (failed(mlir::failableParallelForEach(ctxt, mods, [&](Operation *mod) {
+        return applyPartialConversion(mod, target, instancePatterns);
+      })))
     signalPassFailure();
 }
 
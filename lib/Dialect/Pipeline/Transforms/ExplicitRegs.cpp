@@ -11,7 +11,6 @@
 //===----------------------------------------------------------------------===//
 
 #include "PassDetails.h"
-#include "circt/Support/BackedgeBuilder.h"
 
 using namespace mlir;
 using namespace circt;
@@ -24,106 +23,108 @@ public:
   void runOnOperation() override;
 
 private:
-  // Recursively routes value v backwards through the pipeline, adding new
-  // registers to 'stage' if the value was not already registered in the stage.
-  // Returns the registerred version of 'v' through 'stage'.
-  Value routeThroughStage(OpOperand &v, PipelineStageOp stage);
-
-  // A mapping storing whether a given stage register constains a registerred
-  // version of a given value. The registered version will be a backedge during
-  // pipeline body analysis. Once the entire body has been analyzed, the
-  // pipeline.stage operations will be replaced with pipeline.stage.register
-  // operations containing the requested regs, and the backedge will be
-  // replaced. MapVector ensures deterministic iteration order, which in turn
-  // ensures determinism during stage op IR emission.
-  DenseMap<PipelineStageOp, llvm::MapVector<Value, Backedge>> stageRegMap;
-
-  // A linked list of stages in the pipeline. Allows for easily looking up the
-  // predecessor stage of a given stage.
-  DenseMap<PipelineStageOp, PipelineStageOp> stagePredecessor;
-
-  std::shared_ptr<BackedgeBuilder> bb;
+  // The registers of a single stage, in the order in which they were first
+  // requested. Indices are the positions in 'regs'.
+  struct StageRegs {
+    SmallVector<Value> regs;
+    DenseMap<Value, unsigned> indices;
+  };
+
+  // Registers 'v' in every stage from 'fromStage' up to and including
+  // 'toStage'.
+  void addRegs(Value v, unsigned fromStage, unsigned toStage);
+
+  // The stage index of each value defined in the pipeline body. Stage index 0
+  // contains the block arguments and the ops before the first stage op, stage
+  // index i contains the i'th stage op and the ops following it.
+  DenseMap<Value, unsigned> defStage;
+
+  // The last stage through which each stage-crossing value has been
+  // registered so far.
+  DenseMap<Value, unsigned> registeredUpTo;
+
+  // The registers of each stage op, indexed by stage index - 1.
+  SmallVector<StageRegs> stageRegs;
 };
 
 } // end anonymous namespace
 
-// NOLINTNEXTLINE(misc-no-recursion)
-Value ExplicitRegsPass::routeThroughStage(OpOperand &v, PipelineStageOp stage) {
-  Value retVal = v.get();
-  if (!stage) {
-    // Recursive base case - nothing to route (v is a block operand).
-    return retVal;
+void ExplicitRegsPass::addRegs(Value v, unsigned fromStage, unsigned toStage) {
+  for (unsigned stage = fromStage; stage <= toStage; ++stage) {
+    StageRegs &regs = stageRegs[stage - 1];
+    regs.indices.try_emplace(v, regs.regs.size());
+    regs.regs.push_back(v);
   }
-
-  auto regIt = stageRegMap[stage].find(retVal);
-  if (regIt != stageRegMap[stage].end()) {
-    // 'v' is already registered in 'stage'.
-    return regIt->second;
-  }
-
-  auto *definingOp = retVal.getDefiningOp();
-  if (!definingOp || definingOp->isBeforeInBlock(stage)) {
-    // Value is defined before the provided stage - route it through the stage.
-    auto regBackedge = bb->get(retVal.getType());
-    stageRegMap[stage].insert({retVal, regBackedge});
-    retVal = regBackedge;
-  } else {
-    // Value is defined after the provided stage - early exit here.
-    return retVal;
-  }
-
-  // Recurse - recursion will only create a new backedge if necessary.
-  auto predStageIt = stagePredecessor.find(stage);
-  assert(predStageIt != stagePredecessor.end() &&
-         "stage should have been registered before calling this function");
-  PipelineStageOp predecessorStage = predStageIt->second;
-  if (predecessorStage)
-    routeThroughStage(v, predecessorStage);
-
-  return retVal;
 }
 
 void ExplicitRegsPass::runOnOperation() {
   auto pipeline = getOperation();
   OpBuilder b(getOperation().getContext());
-  bb = std::make_shared<BackedgeBuilder>(b, getOperation().getLoc());
+  Block *body = pipeline.getBodyBlock();
 
   // A list of stages in the pipeline in the order which they appear.
   SmallVector<PipelineStageOp> stageList;
-  PipelineStageOp currStage = nullptr;
-  // Iterate over the pipeline body in-order (!).
-  for (auto &op : *pipeline.getBodyBlock()) {
+  // The uses which cross a stage boundary, along with the stage index of the
+  // user.
+  SmallVector<std::pair<OpOperand *, unsigned>> crossingUses;
+
+  for (BlockArgument arg : body->getArguments())
+    defStage[arg] = 0;
+
+  // Iterate over the pipeline body in-order (!), and determine in this single
+  // pass which values are live across each stage. A value used in stage 'u'
+  // and defined in stage 'd < u' is registered by the stages 'd+1' to 'u'.
+  // Values are added to a stage in the order of the first use requiring
+  // them, which keeps the stage register order deterministic.
+  for (auto &op : *body) {
     if (auto stageOp = dyn_cast<PipelineStageOp>(&op)) {
-      stagePredecessor[stageOp] = currStage;
-      currStage = stageOp;
+      stageList.push_back(stageOp);
+      stageRegs.emplace_back();
+      defStage[stageOp.getValid()] = stageList.size();
       continue;
     }
 
-    // Check the operands of this operation to see if any of them cross a
-    // stage boundary.
+    unsigned currStage = stageList.size();
     for (OpOperand &operand : op.getOpOperands()) {
-      Value reroutedValue = routeThroughStage(operand, currStage);
-      if (reroutedValue != operand.get())
-        op.setOperand(operand.getOperandNumber(), reroutedValue);
+      // Values which are not yet defined at this point are not routed.
+      auto defIt = defStage.find(operand.get());
+      if (defIt == defStage.end() || defIt->second == currStage)
+        continue;
+      auto regIt =
+          registeredUpTo.try_emplace(operand.get(), defIt->second).first;
+      if (regIt->second < currStage) {
+        addRegs(operand.get(), regIt->second + 1, currStage);
+        regIt->second = currStage;
+      }
+      crossingUses.push_back({&operand, currStage});
     }
+
+    for (Value result : op.getResults())
+      defStage[result] = stageList.size();
   }
 
   // All values have been recorded through the stages. Now, replace the
-  // stages with new stage operations containing the required registers.
-  for (auto &[stageOp, regMap] : stageRegMap) {
+  // stages with new stage operations containing the required registers, in
+  // order, such that each stage can directly take the registered values of
+  // its predecessor.
+  SmallVector<PipelineStageRegisterOp> newStageOps;
+  for (auto &it : llvm::enumerate(stageList)) {
+    size_t stageIdx = it.index();
+    PipelineStageOp stageOp = it.value();
     b.setInsertionPoint(stageOp);
-    auto predStageOp = stagePredecessor[stageOp];
 
     // Gather register inputs to this stage, either from a predecessor stage
     // or from the original op.
     llvm::SmallVector<Value> regIns;
-    for (auto &[value, backedge] : regMap) {
-      if (predStageOp) {
+    for (Value value : stageRegs[stageIdx].regs) {
+      if (stageIdx > 0) {
         // Grab the value if registerred through the predecessor op, else,
         // use the raw value.
-        auto predRegIt = stageRegMap[predStageOp].find(value);
-        if (predRegIt != stageRegMap[predStageOp].end()) {
-          regIns.push_back(predRegIt->second);
+        auto &predIndices = stageRegs[stageIdx - 1].indices;
+        auto predRegIt = predIndices.find(value);
+        if (predRegIt != predIndices.end()) {
+          regIns.push_back(
+              newStageOps.back().getRegOuts()[predRegIt->second]);
           continue;
         }
       }
@@ -131,22 +132,25 @@ void ExplicitRegsPass::runOnOperation() {
       regIns.push_back(value);
     }
 
-    auto newStageOp = b.create<PipelineStageRegisterOp>(
-        stageOp.getLoc(), stageOp.getWhen(), regIns);
-    stageOp.getValid().replaceAllUsesWith(newStageOp.getValid());
+    newStageOps.push_back(b.create<PipelineStageRegisterOp>(
+        stageOp.getLoc(), stageOp.getWhen(), regIns));
+  }
 
-    // Replace backedges with the outputs of the new stage.
-    for (auto &it : llvm::enumerate(regMap)) {
-      auto index = it.index();
-      auto &[value, backedge] = it.value();
-      backedge.setValue(newStageOp.getRegOuts()[index]);
-    }
+  // Reroute the stage-crossing uses through the registers of their stage.
+  for (auto [operand, stage] : crossingUses) {
+    unsigned index = stageRegs[stage - 1].indices.lookup(operand->get());
+    operand->set(newStageOps[stage - 1].getRegOuts()[index]);
+  }
+
+  for (auto [stageOp, newStageOp] : llvm::zip(stageList, newStageOps)) {
+    stageOp.getValid().replaceAllUsesWith(newStageOp.getValid());
     stageOp.erase();
   }
 
   // Clear internal state. See https://github.com/llvm/circt/issues/3235
-  stageRegMap.clear();
-  stagePredecessor.clear();
+  defStage.clear();
+  registeredUpTo.clear();
+  stageRegs.clear();
 }
 
 std::unique_ptr<mlir::Pass> circt::pipeline::createExplicitRegsPass() {
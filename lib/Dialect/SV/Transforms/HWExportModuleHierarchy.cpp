@@ -19,6 +19,7 @@
 #include "circt/Support/Path.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/Support/FileUtilities.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/JSON.h"
 #include "llvm/Support/Path.h"
@@ -39,42 +40,58 @@ struct HWExportModuleHierarchyPass
   void runOnOperation() override;
 };
 
-/// Recursively print the module hierarchy as serialized as JSON.
-static void printHierarchy(hw::InstanceOp &inst, SymbolTable &symbolTable,
-                           llvm::json::OStream &j) {
-  auto moduleOp = symbolTable.lookup(inst.getModuleNameAttr().getValue());
-
-  j.object([&] {
-    j.attribute("instance_name", inst.instanceName());
-    j.attribute("module_name", hw::getVerilogModuleName(moduleOp));
-    j.attributeArray("instances", [&] {
-      // Only recurse on module ops, not extern or generated ops, whose internal
-      // are opaque.
-      if (auto module = dyn_cast<hw::HWModuleOp>(moduleOp)) {
-        for (auto op : module.getOps<hw::InstanceOp>()) {
-          printHierarchy(op, symbolTable, j);
-        }
+namespace {
+/// Streams the instance hierarchy below a top module as JSON. If `dedup` is
+/// set, the instances of a module are only expanded the first time the module
+/// is encountered; every later instance of it refers back to that expansion by
+/// its module name in an "instances_ref" field.
+struct HierarchyPrinter {
+  HierarchyPrinter(SymbolTable &symbolTable, llvm::json::OStream &j,
+                   bool dedup)
+      : symbolTable(symbolTable), j(j), dedup(dedup) {}
+
+  /// Print an instance of `moduleOp` named `instanceName`.
+  void print(StringRef instanceName, Operation *moduleOp) {
+    auto moduleName = hw::getVerilogModuleName(moduleOp);
+    // Only recurse on module ops, not extern or generated ops, whose internal
+    // are opaque.
+    auto module = dyn_cast<hw::HWModuleOp>(moduleOp);
+    j.object([&] {
+      j.attribute("instance_name", instanceName);
+      j.attribute("module_name", moduleName);
+      if (dedup && module && !module.getOps<hw::InstanceOp>().empty() &&
+          !expanded.insert(moduleOp).second) {
+        j.attribute("instances_ref", moduleName);
+        return;
       }
+      j.attributeArray("instances", [&] {
+        if (!module)
+          return;
+        for (auto inst : module.getOps<hw::InstanceOp>())
+          print(inst.instanceName(), symbolTable.lookup(
+                                         inst.getModuleNameAttr().getValue()));
+      });
     });
-  });
-}
+  }
+
+private:
+  SymbolTable &symbolTable;
+  llvm::json::OStream &j;
+  bool dedup;
+  /// The modules whose instances have already been printed.
+  DenseSet<Operation *> expanded;
+};
+} // namespace
 
-/// Return the JSON-serialized module hierarchy for the given module as the top
+/// Stream the JSON-serialized module hierarchy for the given module as the top
 /// of the hierarchy.
 static void extractHierarchyFromTop(hw::HWModuleOp op, SymbolTable &symbolTable,
-                                    llvm::raw_ostream &os) {
+                                    llvm::raw_ostream &os, bool dedup) {
   llvm::json::OStream j(os, 2);
 
   // As a special case for top-level module, set instance name to module name,
   // since the top-level module is not instantiated.
-  j.object([&] {
-    j.attribute("instance_name", op.getName());
-    j.attribute("module_name", hw::getVerilogModuleName(op));
-    j.attributeArray("instances", [&] {
-      for (auto op : op.getOps<hw::InstanceOp>())
-        printHierarchy(op, symbolTable, j);
-    });
-  });
+  HierarchyPrinter(symbolTable, j, dedup).print(op.getName(), op);
 }
 
 /// Find the modules corresponding to the firrtl mainModule and DesignUnderTest,
@@ -114,7 +131,7 @@ void HWExportModuleHierarchyPass::runOnOperation() {
         return;
       }
 
-      extractHierarchyFromTop(op, *symbolTable, outputFile->os());
+      extractHierarchyFromTop(op, *symbolTable, outputFile->os(), dedupModules);
 
       outputFile->keep();
     }
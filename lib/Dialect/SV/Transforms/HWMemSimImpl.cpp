@@ -20,6 +20,8 @@
 #include "mlir/IR/ImplicitLocOpBuilder.h"
 #include "llvm/ADT/TypeSwitch.h"
 
+#include <map>
+
 using namespace circt;
 using namespace hw;
 
@@ -40,7 +42,21 @@ struct FirMemory {
   size_t readUnderWrite;
   WUW writeUnderWrite;
   SmallVector<int32_t> writeClockIDs;
+
+  std::tuple<size_t, size_t, size_t, size_t, size_t, size_t, size_t, size_t,
+             size_t, WUW, SmallVector<int32_t>>
+  getTuple() const {
+    return std::tie(numReadPorts, numWritePorts, numReadWritePorts, dataWidth,
+                    depth, maskGran, readLatency, writeLatency, readUnderWrite,
+                    writeUnderWrite, writeClockIDs);
+  }
 };
+
+/// Generated memories with the same parameters, the same ports and the same
+/// output file are implemented by a single behavioral model.
+using MemoryModelKey =
+    std::tuple<decltype(std::declval<FirMemory>().getTuple()), const void *,
+               const void *, const void *, const void *>;
 } // end anonymous namespace
 
 namespace {
@@ -83,6 +99,7 @@ struct HWMemSimImplPass : public sv::HWMemSimImplBase<HWMemSimImplPass> {
   using sv::HWMemSimImplBase<HWMemSimImplPass>::disableRegRandomization;
   using sv::HWMemSimImplBase<
       HWMemSimImplPass>::addVivadoRAMAddressConflictSynthesisBugWorkaround;
+  using sv::HWMemSimImplBase<HWMemSimImplPass>::disableMemDedup;
 };
 
 } // end anonymous namespace
@@ -593,6 +610,7 @@ void HWMemSimImplPass::runOnOperation() {
 
   SmallVector<HWModuleGeneratedOp> toErase;
   bool anythingChanged = false;
+  std::map<MemoryModelKey, HWModuleOp> memoryModels;
 
   for (auto op :
        llvm::make_early_inc_range(topModule->getOps<HWModuleGeneratedOp>())) {
@@ -620,15 +638,36 @@ void HWMemSimImplPass::runOnOperation() {
       } else {
         auto newModule = builder.create<HWModuleOp>(
             oldModule.getLoc(), nameAttr, oldModule.getPorts());
-        if (auto outdir = oldModule->getAttr("output_file"))
+        auto outdir = oldModule->getAttr("output_file");
+        if (outdir)
           newModule->setAttr("output_file", outdir);
         newModule.setCommentAttr(
             builder.getStringAttr("VCS coverage exclude_file"));
 
-        HWMemSimImpl(ignoreReadEnableMem, stripMuxPragmas,
-                     disableMemRandomization, disableRegRandomization,
-                     addVivadoRAMAddressConflictSynthesisBugWorkaround)
-            .generateMemory(newModule, mem);
+        // If an identical memory has already been implemented, only emit a
+        // wrapper instantiating its model.
+        HWModuleOp &model =
+            memoryModels[{mem.getTuple(),
+                          oldModule.getFunctionType().getAsOpaquePointer(),
+                          oldModule->getAttr("argNames").getAsOpaquePointer(),
+                          oldModule->getAttr("resultNames").getAsOpaquePointer(),
+                          outdir.getAsOpaquePointer()}];
+        if (model && !disableMemDedup) {
+          auto b = ImplicitLocOpBuilder::atBlockBegin(
+              oldModule.getLoc(), newModule.getBodyBlock());
+          auto inst = b.create<InstanceOp>(
+              model, model.getName(),
+              SmallVector<Value>(newModule.getArguments()));
+          newModule.getBodyBlock()->getTerminator()->setOperands(
+              inst.getResults());
+        } else {
+          HWMemSimImpl(ignoreReadEnableMem, stripMuxPragmas,
+                       disableMemRandomization, disableRegRandomization,
+                       addVivadoRAMAddressConflictSynthesisBugWorkaround)
+              .generateMemory(newModule, mem);
+          if (!model)
+            model = newModule;
+        }
       }
 
       oldModule.erase();
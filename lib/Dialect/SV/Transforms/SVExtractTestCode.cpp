@@ -21,7 +21,9 @@
 #include "circt/Dialect/SV/SVPasses.h"
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
+#include "mlir/IR/Threading.h"
 
+#include <array>
 #include <set>
 
 using namespace mlir;
@@ -156,6 +158,39 @@ static SetVector<Operation *> computeCloneSet(SetVector<Operation *> &roots) {
   return results;
 }
 
+namespace {
+/// The ops of one kind of test code found in a module, and the data-flow and
+/// structural ops to clone along with them.  This only reads the module, so
+/// the cuts of all modules can be computed in parallel.
+struct CutAnalysis {
+  SetVector<Operation *> roots;
+  SetVector<Operation *> opsToClone;
+  bool hasError = false;
+};
+} // end anonymous namespace
+
+static CutAnalysis analyzeCut(hw::HWModuleOp module,
+                              const std::function<bool(Operation *)> &fn) {
+  CutAnalysis cut;
+  // Find Operations of interest.
+  module->walk([&](Operation *op) {
+    if (fn(op)) {
+      cut.roots.insert(op);
+      if (op->getNumResults()) {
+        op->emitError("Extracting op with result");
+        cut.hasError = true;
+      }
+    }
+  });
+
+  // Find the data-flow and structural ops to clone.  Result includes roots.
+  // The slices of all roots share a single visited set, so common fan-in is
+  // only walked once.
+  if (!cut.hasError && !cut.roots.empty())
+    cut.opsToClone = computeCloneSet(cut.roots);
+  return cut;
+}
+
 // Find instances that directly feed the clone set, and add them if possible.
 // This also returns a list of ops that should be erased, which includes such
 // instances and their forward dataflow slices.
@@ -515,32 +550,18 @@ struct SVExtractTestCodeImplPass
 
 private:
   // Run the extraction on a module, and return true if test code was extracted.
-  bool doModule(hw::HWModuleOp module, std::function<bool(Operation *)> fn,
-                StringRef suffix, Attribute path, Attribute bindFile,
-                BindTable &bindTable,
+  bool doModule(hw::HWModuleOp module, CutAnalysis &cut, StringRef suffix,
+                Attribute path, Attribute bindFile, BindTable &bindTable,
                 SmallPtrSetImpl<Operation *> &opsToErase) {
-    bool hasError = false;
-    // Find Operations of interest.
-    SetVector<Operation *> roots;
-    module->walk([&fn, &roots, &hasError](Operation *op) {
-      if (fn(op)) {
-        roots.insert(op);
-        if (op->getNumResults()) {
-          op->emitError("Extracting op with result");
-          hasError = true;
-        }
-      }
-    });
-    if (hasError) {
+    if (cut.hasError) {
       signalPassFailure();
       return false;
     }
     // No Ops?  No problem.
+    auto &roots = cut.roots;
     if (roots.empty())
       return false;
-
-    // Find the data-flow and structural ops to clone.  Result includes roots.
-    auto opsToClone = computeCloneSet(roots);
+    auto &opsToClone = cut.opsToClone;
 
     // Find the dataflow into the clone set
     SetVector<Value> inputs;
@@ -686,34 +707,81 @@ void SVExtractTestCodeImplPass::runOnOperation() {
   BindTable bindTable;
   addExistingBinds(topLevelModule, bindTable);
 
+  // The kinds of test code to extract, in extraction order.
+  struct ExtractionKind {
+    std::function<bool(Operation *)> fn;
+    StringRef suffix;
+    Attribute path;
+    Attribute bindFile;
+  };
+  constexpr size_t numKinds = 3;
+  ExtractionKind kinds[numKinds] = {
+      {isAssert, "_assert", assertDir, assertBindFile},
+      {isAssume, "_assume", assumeDir, assumeBindFile},
+      {isCover, "_cover", coverDir, coverBindFile}};
+
+  // Extraction is skipped for modules where any instance is bound, to avoid
+  // problems where certain simulators dislike having binds that target bound
+  // modules.  If the module is in test harness, we don't have to extract from
+  // it either.
+  auto shouldExtract = [&](hw::HWModuleOp rtlmod) {
+    return !isBound(rtlmod, *instanceGraph) &&
+           !rtlmod->hasAttr("firrtl.extract.do_not_extract");
+  };
+
+  // Computing the cones is the expensive part of the pass and only reads the
+  // IR, so do it for all modules in parallel up front.  Creating the extracted
+  // modules, binds and inlining remains serial below.
+  SmallVector<hw::HWModuleOp> candidates;
+  for (auto rtlmod : topLevelModule->getOps<hw::HWModuleOp>())
+    if (shouldExtract(rtlmod))
+      candidates.push_back(rtlmod);
+  SmallVector<std::array<CutAnalysis, numKinds>> cuts(candidates.size());
+  mlir::parallelFor(&getContext(), 0, candidates.size(), [&](size_t i) {
+    for (size_t k = 0; k != numKinds; ++k)
+      cuts[i][k] = analyzeCut(candidates[i], kinds[k].fn);
+  });
+  DenseMap<Operation *, size_t> cutIndex;
+  for (auto &en : llvm::enumerate(candidates))
+    cutIndex[en.value()] = en.index();
+
+  // Modules that have had an input-only module inlined into them.  Their
+  // precomputed cuts may refer to erased instances and are recomputed.
+  SmallPtrSet<Operation *, 8> modifiedModules;
+
   for (auto &op : llvm::make_early_inc_range(topLevelModule->getOperations())) {
     if (auto rtlmod = dyn_cast<hw::HWModuleOp>(op)) {
       // Extract two sets of ops to different modules.  This will add modules,
-      // but not affect modules in the symbol table.  If any instance of the
-      // module is bound, then extraction is skipped.  This avoids problems
-      // where certain simulators dislike having binds that target bound
-      // modules.
+      // but not affect modules in the symbol table.
       if (isBound(rtlmod, *instanceGraph))
         continue;
 
-      // In the module is in test harness, we don't have to extract from it.
       if (rtlmod->hasAttr("firrtl.extract.do_not_extract")) {
         rtlmod->removeAttr("firrtl.extract.do_not_extract");
         continue;
       }
 
+      std::array<CutAnalysis, numKinds> moduleCuts;
+      auto it = cutIndex.find(rtlmod);
+      if (it != cutIndex.end() && !modifiedModules.contains(rtlmod))
+        moduleCuts = std::move(cuts[it->second]);
+      else
+        for (size_t k = 0; k != numKinds; ++k)
+          moduleCuts[k] = analyzeCut(rtlmod, kinds[k].fn);
+
       SmallPtrSet<Operation *, 32> opsToErase;
       bool anyThingExtracted = false;
-      anyThingExtracted |= doModule(rtlmod, isAssert, "_assert", assertDir,
-                                    assertBindFile, bindTable, opsToErase);
-      anyThingExtracted |= doModule(rtlmod, isAssume, "_assume", assumeDir,
-                                    assumeBindFile, bindTable, opsToErase);
-      anyThingExtracted |= doModule(rtlmod, isCover, "_cover", coverDir,
-                                    coverBindFile, bindTable, opsToErase);
+      for (size_t k = 0; k != numKinds; ++k)
+        anyThingExtracted |=
+            doModule(rtlmod, moduleCuts[k], kinds[k].suffix, kinds[k].path,
+                     kinds[k].bindFile, bindTable, opsToErase);
 
       // Inline any modules that only have inputs for test code.
-      if (!disableModuleInlining && anyThingExtracted)
+      if (!disableModuleInlining && anyThingExtracted) {
+        for (auto *use : instanceGraph->lookup(rtlmod)->uses())
+          modifiedModules.insert(use->getParent()->getModule().getOperation());
         inlineInputOnly(rtlmod, *instanceGraph, bindTable, opsToErase);
+      }
 
       // Erase any instances that were extracted, and their forward dataflow.
       // Also erase old instances that were inlined and can now be cleaned up.
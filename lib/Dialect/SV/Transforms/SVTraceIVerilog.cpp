@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "PassDetail.h"
+#include "circt/Dialect/HW/HWDebugSignals.h"
 #include "circt/Dialect/HW/HWInstanceGraph.h"
 #include "circt/Dialect/HW/HWOps.h"
 #include "circt/Dialect/SV/SVPasses.h"
@@ -32,6 +33,13 @@ namespace {
 struct SVTraceIVerilogPass
     : public sv::SVTraceIVerilogBase<SVTraceIVerilogPass> {
   void runOnOperation() override;
+
+private:
+  /// Collect the hierarchical paths of the frontend-visible signals of
+  /// `module` and of the instances below it, relative to `module`.
+  void collectDebugSignals(hw::HWModuleOp module, const Twine &prefix,
+                           const hw::DebugSignals &debugSignals,
+                           SmallVectorImpl<std::string> &paths);
 };
 
 } // end anonymous namespace
@@ -55,6 +63,11 @@ void SVTraceIVerilogPass::runOnOperation() {
     targetModuleName.setValue(top.getName().str());
   }
 
+  // The signals are only looked up if a selective trace is requested.
+  Optional<hw::DebugSignals> signalTable;
+  if (debugSignals && signals.empty())
+    signalTable.emplace(mod);
+
   for (auto hwmod : mod.getOps<hw::HWModuleOp>()) {
     if (!targetModuleName.empty() &&
         hwmod.getName() != targetModuleName.getValue())
@@ -64,12 +77,38 @@ void SVTraceIVerilogPass::runOnOperation() {
     llvm::raw_string_ostream ss(traceMacro);
     auto modName = hwmod.getName();
     ss << "initial begin\n  $dumpfile (\"" << directoryName.getValue()
-       << modName << ".vcd\");\n  $dumpvars (0, " << modName
-       << ");\n  #1;\nend\n";
+       << modName << ".vcd\");\n";
+    if (!signals.empty()) {
+      for (auto &signal : signals)
+        ss << "  $dumpvars (0, " << signal << ");\n";
+    } else if (signalTable) {
+      SmallVector<std::string> paths;
+      collectDebugSignals(hwmod, "", *signalTable, paths);
+      for (auto &path : paths)
+        ss << "  $dumpvars (0, " << path << ");\n";
+    } else {
+      ss << "  $dumpvars (0, " << modName << ");\n";
+    }
+    ss << "  #1;\nend\n";
     builder.create<sv::VerbatimOp>(hwmod.getLoc(), ss.str());
   }
 }
 
+void SVTraceIVerilogPass::collectDebugSignals(
+    hw::HWModuleOp module, const Twine &prefix,
+    const hw::DebugSignals &debugSignals,
+    SmallVectorImpl<std::string> &paths) {
+  for (auto signal : debugSignals.getSignals(module))
+    paths.push_back((prefix + signal.getValue()).str());
+  for (auto inst : module.getBodyBlock()->getOps<hw::InstanceOp>()) {
+    auto child =
+        dyn_cast_or_null<hw::HWModuleOp>(inst.getReferencedModule(nullptr));
+    if (child)
+      collectDebugSignals(child, prefix + inst.getInstanceName() + ".",
+                          debugSignals, paths);
+  }
+}
+
 std::unique_ptr<Pass> circt::sv::createSVTraceIVerilogPass() {
   return std::make_unique<SVTraceIVerilogPass>();
 }
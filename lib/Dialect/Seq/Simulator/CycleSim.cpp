@@ -0,0 +1,345 @@
+//===- CycleSim.cpp - Compiled cycle-based simulator ------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// The simulated module is compiled into one function computing its outputs,
+// and one function per clock computing the next values of the registers it
+// clocks. Each function loads the inputs and the registers from the arena,
+// evaluates a copy of the levelized combinational logic of the module, and
+// only then stores its results, such that all registers of a clock update at
+// once.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/Seq/Simulator/CycleSim.h"
+#include "circt/Conversion/CombToLLVM.h"
+#include "circt/Conversion/HWToLLVM.h"
+#include "circt/Dialect/Comb/CombOps.h"
+#include "circt/Dialect/HW/HWOps.h"
+#include "circt/Dialect/Seq/SeqOps.h"
+#include "mlir/Conversion/FuncToLLVM/ConvertFuncToLLVM.h"
+#include "mlir/Conversion/LLVMCommon/ConversionTarget.h"
+#include "mlir/Conversion/LLVMCommon/TypeConverter.h"
+#include "mlir/Conversion/ReconcileUnrealizedCasts/ReconcileUnrealizedCasts.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
+#include "mlir/Transforms/DialectConversion.h"
+#include "llvm/Support/TargetSelect.h"
+
+using namespace mlir;
+using namespace circt;
+using namespace circt::seq::sim;
+
+namespace {
+/// A register of the simulated module.
+struct Register {
+  Operation *op;
+  Value clock;
+  Value next;
+  Value reset;
+  Value resetValue;
+  unsigned signal;
+};
+} // namespace
+
+/// Order the operations of `body` such that every operation comes after the
+/// operations defining its operands. Register results are available from the
+/// start, so only combinational cycles prevent an order.
+static LogicalResult levelize(Block *body,
+                              const DenseSet<Operation *> &registerOps,
+                              SmallVectorImpl<Operation *> &order) {
+  DenseMap<Operation *, unsigned> pending;
+  SmallVector<Operation *> ready;
+  for (auto &op : *body) {
+    if (registerOps.contains(&op) || isa<hw::OutputOp>(op))
+      continue;
+    unsigned count = 0;
+    for (Value operand : op.getOperands())
+      if (auto *def = operand.getDefiningOp(); def && !registerOps.count(def))
+        ++count;
+    if (count)
+      pending[&op] = count;
+    else
+      ready.push_back(&op);
+  }
+
+  while (!ready.empty()) {
+    Operation *op = ready.pop_back_val();
+    order.push_back(op);
+    for (Operation *user : op->getUsers()) {
+      auto it = pending.find(user);
+      if (it != pending.end() && --it->second == 0)
+        ready.push_back(user);
+    }
+  }
+
+  for (auto &op : *body) {
+    auto it = pending.find(&op);
+    if (it != pending.end() && it->second != 0)
+      return op.emitError("operation is part of a combinational cycle");
+  }
+  return success();
+}
+
+std::unique_ptr<CycleSim> CycleSim::create(ModuleOp module, StringRef top,
+                                           unsigned optLevel) {
+  auto hwModule = module.lookupSymbol<hw::HWModuleOp>(top);
+  if (!hwModule) {
+    module.emitError() << "no module named '" << top << "'";
+    return {};
+  }
+  std::unique_ptr<CycleSim> sim(new CycleSim());
+  Block *body = hwModule.getBodyBlock();
+  Location loc = hwModule.getLoc();
+  MLIRContext *context = module.getContext();
+  context->loadDialect<func::FuncDialect, LLVM::LLVMDialect>();
+  registerLLVMDialectTranslation(*context);
+
+  SmallVector<Register> registers;
+  DenseSet<Operation *> registerOps;
+  for (auto &op : *body) {
+    if (auto reg = dyn_cast<seq::CompRegOp>(op))
+      registers.push_back({&op, reg.getClk(), reg.getInput(), reg.getReset(),
+                           reg.getResetValue(), 0});
+    else if (auto reg = dyn_cast<seq::FirRegOp>(op))
+      registers.push_back({&op, reg.getClk(), reg.getNext(), reg.getReset(),
+                           reg.getResetValue(), 0});
+    else if (isa<hw::InstanceOp>(op)) {
+      op.emitError("instances are not supported by the cycle simulator, "
+                   "inline them first");
+      return {};
+    } else if (!isa_and_nonnull<hw::HWDialect, comb::CombDialect>(
+                   op.getDialect())) {
+      op.emitError("operation is not supported by the cycle simulator");
+      return {};
+    } else
+      continue;
+    registerOps.insert(&op);
+  }
+
+  SmallVector<Operation *> order;
+  if (failed(levelize(body, registerOps, order)))
+    return {};
+
+  // Lay out the signals in the arena, each aligned to 64 bits.
+  unsigned offset = 0;
+  auto addSignal = [&](Operation *op, StringRef name, Signal::Kind kind,
+                       Type type) -> Optional<unsigned> {
+    int64_t width = hw::getBitWidth(type);
+    if (width <= 0) {
+      op->emitError() << "signal '" << name << "' of type " << type
+                      << " is not supported by the cycle simulator";
+      return None;
+    }
+    sim->signals.push_back({name.str(), kind, unsigned(width), offset});
+    offset += alignTo(divideCeil(width, 8), 8);
+    return sim->signals.size() - 1;
+  };
+
+  DenseMap<Value, unsigned> clockIndices;
+  for (auto &reg : registers) {
+    auto arg = reg.clock.dyn_cast<BlockArgument>();
+    if (!arg || arg.getOwner() != body) {
+      reg.op->emitError("registers must be clocked by an input port of the "
+                        "module");
+      return {};
+    }
+    clockIndices.insert({reg.clock, 0});
+  }
+
+  SmallVector<unsigned> argSignals;
+  for (auto arg : body->getArguments()) {
+    auto name = hw::getModuleArgumentName(hwModule, arg.getArgNumber());
+    bool isClock = clockIndices.count(arg);
+    auto signal =
+        addSignal(hwModule, name,
+                  isClock ? Signal::Kind::Clock : Signal::Kind::Input,
+                  arg.getType());
+    if (!signal)
+      return {};
+    argSignals.push_back(*signal);
+    if (isClock) {
+      clockIndices[arg] = sim->clocks.size();
+      sim->clocks.push_back(*signal);
+    }
+  }
+
+  SmallVector<unsigned> outputSignals;
+  auto outputOp = cast<hw::OutputOp>(body->getTerminator());
+  for (auto [i, type] : llvm::enumerate(hwModule.getResultTypes())) {
+    auto signal = addSignal(hwModule, hw::getModuleResultName(hwModule, i),
+                            Signal::Kind::Output, type);
+    if (!signal)
+      return {};
+    outputSignals.push_back(*signal);
+  }
+
+  for (auto [i, reg] : llvm::enumerate(registers)) {
+    auto name = reg.op->getAttrOfType<StringAttr>("name").getValue();
+    std::string fallback = "reg" + std::to_string(i);
+    auto signal = addSignal(reg.op, name.empty() ? fallback : name,
+                            Signal::Kind::Register,
+                            reg.op->getResult(0).getType());
+    if (!signal)
+      return {};
+    reg.signal = *signal;
+  }
+  sim->arena.resize(std::max<size_t>(divideCeil(offset, 8), 1));
+
+  // Build the evaluation functions, which take the address of the arena.
+  auto simModule = ModuleOp::create(loc);
+  OwningOpRef<ModuleOp> owner(simModule);
+  OpBuilder builder = OpBuilder::atBlockBegin(simModule.getBody());
+  auto i64Type = builder.getI64Type();
+
+  auto getAddress = [&](OpBuilder &b, Value arena, const Signal &signal) {
+    Value signalOffset = b.create<LLVM::ConstantOp>(
+        loc, i64Type, b.getI64IntegerAttr(signal.offset));
+    Value address = b.create<LLVM::AddOp>(loc, i64Type, arena, signalOffset);
+    auto pointerType =
+        LLVM::LLVMPointerType::get(b.getIntegerType(signal.width));
+    return b.create<LLVM::IntToPtrOp>(loc, pointerType, address);
+  };
+  auto load = [&](OpBuilder &b, Value arena, unsigned signal,
+                  Type type) -> Value {
+    auto &info = sim->signals[signal];
+    Value value = b.create<LLVM::LoadOp>(loc, b.getIntegerType(info.width),
+                                         getAddress(b, arena, info));
+    if (value.getType() != type)
+      value = b.create<hw::BitcastOp>(loc, type, value);
+    return value;
+  };
+  auto store = [&](OpBuilder &b, Value arena, unsigned signal, Value value) {
+    auto &info = sim->signals[signal];
+    auto intType = b.getIntegerType(info.width);
+    if (value.getType() != intType)
+      value = b.create<hw::BitcastOp>(loc, intType, value);
+    b.create<LLVM::StoreOp>(loc, value, getAddress(b, arena, info));
+  };
+
+  auto buildFunction = [&](StringRef name,
+                           llvm::function_ref<void(OpBuilder &, Value,
+                                                   BlockAndValueMapping &)>
+                               storeResults) {
+    auto func = builder.create<func::FuncOp>(
+        loc, name, builder.getFunctionType({i64Type}, {}));
+    auto b = OpBuilder::atBlockBegin(func.addEntryBlock());
+    Value arena = func.getArgument(0);
+    BlockAndValueMapping mapping;
+    for (auto [arg, signal] : llvm::zip(body->getArguments(), argSignals))
+      mapping.map(arg, load(b, arena, signal, arg.getType()));
+    for (auto &reg : registers)
+      mapping.map(reg.op->getResult(0),
+                  load(b, arena, reg.signal, reg.op->getResult(0).getType()));
+    for (Operation *op : order)
+      b.clone(*op, mapping);
+    storeResults(b, arena, mapping);
+    b.create<func::ReturnOp>(loc);
+  };
+
+  buildFunction("eval_comb", [&](OpBuilder &b, Value arena,
+                                 BlockAndValueMapping &mapping) {
+    for (auto [operand, signal] :
+         llvm::zip(outputOp.getOperands(), outputSignals))
+      store(b, arena, signal, mapping.lookup(operand));
+  });
+  for (unsigned clock = 0, e = sim->clocks.size(); clock != e; ++clock) {
+    buildFunction(
+        "eval_clock" + std::to_string(clock),
+        [&](OpBuilder &b, Value arena, BlockAndValueMapping &mapping) {
+          for (auto &reg : registers) {
+            if (clockIndices.lookup(reg.clock) != clock)
+              continue;
+            Value next = mapping.lookup(reg.next);
+            if (reg.reset)
+              next = b.create<comb::MuxOp>(loc, mapping.lookup(reg.reset),
+                                           mapping.lookup(reg.resetValue),
+                                           next);
+            store(b, arena, reg.signal, next);
+          }
+        });
+  }
+
+  // Lower the functions to the LLVM dialect.
+  LLVMTypeConverter converter(context);
+  populateHWToLLVMTypeConversions(converter);
+  RewritePatternSet patterns(context);
+  populateFuncToLLVMConversionPatterns(converter, patterns);
+  populateHWToLLVMConversionPatterns(converter, patterns);
+  populateCombToLLVMConversionPatterns(converter, patterns);
+  LLVMConversionTarget target(*context);
+  target.addLegalOp<ModuleOp>();
+  if (failed(applyFullConversion(simModule, target, std::move(patterns))))
+    return {};
+
+  RewritePatternSet castPatterns(context);
+  populateReconcileUnrealizedCastsPatterns(castPatterns);
+  target.addIllegalOp<UnrealizedConversionCastOp>();
+  if (failed(applyFullConversion(simModule, target, std::move(castPatterns))))
+    return {};
+
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  mlir::ExecutionEngineOptions options;
+  options.transformer = makeOptimizingTransformer(optLevel, /*sizeLevel=*/0,
+                                                  /*targetMachine=*/nullptr);
+  auto maybeEngine = mlir::ExecutionEngine::create(simModule, options);
+  if (!maybeEngine) {
+    hwModule.emitError() << "failed to compile the module: "
+                         << llvm::toString(maybeEngine.takeError());
+    return {};
+  }
+  sim->engine = std::move(*maybeEngine);
+  return sim;
+}
+
+CycleSim::~CycleSim() = default;
+
+int CycleSim::lookupSignal(StringRef name) const {
+  for (auto [i, signal] : llvm::enumerate(signals))
+    if (signal.name == name)
+      return i;
+  return -1;
+}
+
+void CycleSim::setValue(unsigned signal, const APInt &value) {
+  auto &info = signals[signal];
+  assert(value.getBitWidth() == info.width && "value of the wrong width");
+  // The arena holds values in the little-endian layout of the host.
+  memcpy(reinterpret_cast<uint8_t *>(arena.data()) + info.offset,
+         value.getRawData(), divideCeil(info.width, 8));
+}
+
+APInt CycleSim::getValue(unsigned signal) const {
+  auto &info = signals[signal];
+  SmallVector<uint64_t, 1> words(divideCeil(info.width, 64));
+  memcpy(words.data(),
+         reinterpret_cast<const uint8_t *>(arena.data()) + info.offset,
+         divideCeil(info.width, 8));
+  return APInt(info.width, words);
+}
+
+LogicalResult CycleSim::invoke(StringRef function) {
+  auto address = uint64_t(reinterpret_cast<uintptr_t>(arena.data()));
+  void *args[] = {&address};
+  if (auto error = engine->invokePacked(function, args)) {
+    llvm::errs() << "failed to run '" << function
+                 << "': " << llvm::toString(std::move(error)) << "\n";
+    return failure();
+  }
+  return success();
+}
+
+LogicalResult CycleSim::evalComb() { return invoke("eval_comb"); }
+
+LogicalResult CycleSim::evalClock(unsigned clock) {
+  return invoke("eval_clock" + std::to_string(clock));
+}
@@ -46,10 +46,17 @@ struct SeqFIRRTLToSVPass
 
 namespace {
 /// Lower CompRegOp to `sv.reg` and `sv.alwaysff`. Use a posedge clock and
-/// synchronous reset.
+/// synchronous reset. If an always block cache is provided, all of the
+/// registers of a block with the same clock and reset share one `sv.alwaysff`,
+/// placed at the end of the block.
 struct CompRegLower : public OpConversionPattern<CompRegOp> {
 public:
-  using OpConversionPattern::OpConversionPattern;
+  /// The always blocks created so far, by block, clock and reset.
+  using AlwaysFFCache =
+      DenseMap<std::tuple<Block *, Value, Value>, sv::AlwaysFFOp>;
+
+  CompRegLower(MLIRContext *context, AlwaysFFCache *alwaysBlocks = nullptr)
+      : OpConversionPattern(context), alwaysBlocks(alwaysBlocks) {}
 
   LogicalResult
   matchAndRewrite(CompRegOp reg, OpAdaptor adaptor,
@@ -69,7 +76,9 @@ public:
       circt::sv::setSVAttributes(svReg, attribute);
 
     auto regVal = rewriter.create<sv::ReadInOutOp>(loc, svReg);
-    if (reg.getReset() && reg.getResetValue()) {
+    if (alwaysBlocks) {
+      addToAlwaysBlock(reg, svReg, rewriter);
+    } else if (reg.getReset() && reg.getResetValue()) {
       rewriter.create<sv::AlwaysFFOp>(
           loc, sv::EventControl::AtPosEdge, reg.getClk(), ResetType::SyncReset,
           sv::EventControl::AtPosEdge, reg.getReset(),
@@ -87,6 +96,39 @@ public:
     rewriter.replaceOp(reg, {regVal});
     return success();
   }
+
+private:
+  /// Add the assignments of 'reg' to the shared always block of its clock and
+  /// reset, creating it if necessary.
+  void addToAlwaysBlock(CompRegOp reg, sv::RegOp svReg,
+                        ConversionPatternRewriter &rewriter) const {
+    Location loc = reg.getLoc();
+    Value reset =
+        reg.getReset() && reg.getResetValue() ? reg.getReset() : Value();
+    Block *block = reg->getBlock();
+    auto &alwaysOp = (*alwaysBlocks)[{block, reg.getClk(), reset}];
+
+    OpBuilder::InsertionGuard guard(rewriter);
+    if (!alwaysOp) {
+      rewriter.setInsertionPoint(block->getTerminator());
+      if (reset)
+        alwaysOp = rewriter.create<sv::AlwaysFFOp>(
+            loc, sv::EventControl::AtPosEdge, reg.getClk(),
+            ResetType::SyncReset, sv::EventControl::AtPosEdge, reset);
+      else
+        alwaysOp = rewriter.create<sv::AlwaysFFOp>(
+            loc, sv::EventControl::AtPosEdge, reg.getClk());
+    }
+
+    rewriter.setInsertionPointToEnd(alwaysOp.getBodyBlock());
+    rewriter.create<sv::PAssignOp>(loc, svReg, reg.getInput());
+    if (reset) {
+      rewriter.setInsertionPointToEnd(alwaysOp.getResetBlock());
+      rewriter.create<sv::PAssignOp>(loc, svReg, reg.getResetValue());
+    }
+  }
+
+  AlwaysFFCache *alwaysBlocks;
 };
 } // namespace
 
@@ -525,7 +567,9 @@ void SeqToSVPass::runOnOperation() {
   target.addIllegalDialect<SeqDialect>();
   target.addLegalDialect<sv::SVDialect>();
   RewritePatternSet patterns(&ctxt);
-  patterns.add<CompRegLower>(&ctxt);
+  CompRegLower::AlwaysFFCache alwaysBlocks;
+  patterns.add<CompRegLower>(&ctxt,
+                             mergeAlwaysBlocks ? &alwaysBlocks : nullptr);
 
   if (failed(applyPartialConversion(top, target, std::move(patterns))))
     signalPassFailure();
@@ -0,0 +1,323 @@
+//===- Firtool.cpp - Definitions for the firtool pipeline -------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Firtool/Firtool.h"
+#include "circt/Conversion/ExportChiselInterface.h"
+#include "circt/Conversion/ExportVerilog.h"
+#include "circt/Conversion/FIRRTLToHW.h"
+#include "circt/Dialect/FIRRTL/FIRRTLOps.h"
+#include "circt/Dialect/HW/HWOps.h"
+#include "circt/Dialect/SV/SVPasses.h"
+#include "circt/Dialect/Seq/SeqPasses.h"
+#include "circt/Transforms/Passes.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/Support/Path.h"
+
+using namespace llvm;
+using namespace mlir;
+using namespace circt;
+
+std::unique_ptr<Pass> firtool::createSimpleCanonicalizerPass(
+    std::shared_ptr<CanonicalizerProfile> profile) {
+  mlir::GreedyRewriteConfig config;
+  config.useTopDownTraversal = true;
+  config.enableRegionSimplification = false;
+  if (profile)
+    return createProfileCanonicalizerPass(config, std::move(profile));
+  return mlir::createCanonicalizerPass(config);
+}
+
+LogicalResult firtool::populatePreprocessTransforms(PassManager &pm,
+                                                    const FirtoolOptions &opt) {
+  pm.nest<firrtl::CircuitOp>().addPass(firrtl::createLowerFIRRTLAnnotationsPass(
+      opt.disableAnnotationsUnknown, opt.disableAnnotationsClassless));
+  return success();
+}
+
+/// Return true if the field-level connections are merged into aggregate ones.
+static bool shouldMergeConnections(const firtool::FirtoolOptions &opt) {
+  return !opt.disableOptimization &&
+         opt.preserveAggregate != firrtl::PreserveAggregate::None &&
+         !opt.disableMergeConnections;
+}
+
+/// Return true if ExpandWhens merges the connections, in which case the
+/// MergeConnections pass is not needed.
+static bool isMergeConnectionsFused(const firtool::FirtoolOptions &opt) {
+  return opt.fuseMergeConnections && shouldMergeConnections(opt) &&
+         !opt.disableLowerTypes && !opt.disableExpandWhens;
+}
+
+LogicalResult firtool::populateCHIRRTLToLowFIRRTL(PassManager &pm,
+                                                  const FirtoolOptions &opt,
+                                                  ModuleOp module,
+                                                  StringRef inputFilename) {
+  // The pass manager merges the module pipelines of consecutive module passes,
+  // and runs every module through the whole merged pipeline independently of
+  // the other modules. Circuit passes are barriers between these pipelines, so
+  // module passes which do not depend on the circuit passes around them are
+  // kept next to each other.
+
+  // TODO: Move this to the O1 pipeline.
+  pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
+      firrtl::createDropNamesPass(opt.preserveMode));
+
+  if (!opt.disableOptimization)
+    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
+        createCSEPass());
+
+  // InjectDUTHierarchy only moves the body of the DUT into a new module, so
+  // CHIRRTL is lowered before it, along with the module passes above.
+  if (!opt.disableLowerChirrtl)
+    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
+        firrtl::createLowerCHIRRTLPass());
+
+  if (!opt.disableInjectDutHierarchy)
+    pm.nest<firrtl::CircuitOp>().addPass(
+        firrtl::createInjectDUTHierarchyPass());
+
+  // Width inference creates canonicalization opportunities.
+  if (!opt.disableInferWidths)
+    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createInferWidthsPass());
+
+  if (!opt.disableMemToRegOfVec)
+    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createMemToRegOfVecPass(
+        opt.replSeqMem, opt.ignoreReadEnableMem));
+
+  if (!opt.disableInferResets)
+    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createInferResetsPass());
+
+  if (opt.exportChiselInterface) {
+    if (opt.chiselInterfaceOutDirectory.empty()) {
+      pm.nest<firrtl::CircuitOp>().addPass(createExportChiselInterfacePass());
+    } else {
+      pm.nest<firrtl::CircuitOp>().addPass(createExportSplitChiselInterfacePass(
+          opt.chiselInterfaceOutDirectory));
+    }
+  }
+
+  if (!opt.disableOptimization && opt.dedup)
+    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createDedupPass());
+
+  if (!opt.disableWireDFT)
+    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createWireDFTPass());
+
+  if (!opt.lowerMemories)
+    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
+        firrtl::createFlattenMemoryPass());
+
+  // The input mlir file could be firrtl dialect so we might need to clean
+  // things up.
+  if (!opt.disableLowerTypes) {
+    pm.addNestedPass<firrtl::CircuitOp>(firrtl::createLowerFIRRTLTypesPass(
+        opt.preserveAggregate, opt.preservePublicTypes, opt.insertDebugInfo));
+
+    // Only enable expand whens if lower types is also enabled.
+    if (!opt.disableExpandWhens) {
+      auto &modulePM = pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>();
+      modulePM.addPass(firrtl::createExpandWhensPass(
+          isMergeConnectionsFused(opt), opt.mergeConnectionsAggressively));
+      modulePM.addPass(firrtl::createSFCCompatPass());
+    }
+  }
+
+  if (!opt.disableInliner)
+    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createInlinerPass());
+
+  // The check does not change the IR, and runs before the registers are
+  // randomized such that the randomization and the cleanups after it form a
+  // single module pipeline.
+  if (!opt.disableCheckCombCycles) {
+    // TODO: Currently CheckCombCyles pass doesn't support aggregates so skip
+    // the pass for now.
+    if (opt.preserveAggregate == firrtl::PreserveAggregate::None)
+      pm.nest<firrtl::CircuitOp>().addPass(firrtl::createCheckCombCyclesPass());
+    else
+      emitWarning(module->getLoc())
+          << "CheckCombCyclesPass doens't support aggregate "
+             "values yet so it is skipped\n";
+  }
+
+  // Preset the random initialization parameters for each module. The current
+  // implementation assumes it can run at a time where every register is
+  // currently in the final module it will be emitted in, all registers have
+  // been created, and no registers have yet been removed.
+  if (!opt.disableRegRandomization)
+    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
+        firrtl::createRandomizeRegisterInitPass());
+
+  // If we parsed a FIRRTL file and have optimizations enabled, clean it up.
+  if (!opt.disableOptimization)
+    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
+        createSimpleCanonicalizerPass(opt.canonicalizerProfile));
+
+  // Run the infer-rw pass, which merges read and write ports of a memory with
+  // mutually exclusive enables.
+  if (!opt.disableInferRW)
+    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
+        firrtl::createInferReadWritePass());
+
+  if (opt.replSeqMem && !opt.disableLowerMemory)
+    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createLowerMemoryPass());
+
+  if (!opt.disablePrefixModules)
+    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createPrefixModulesPass());
+
+  if (!opt.disableIMCP && !opt.disableOptimization)
+    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createIMConstPropPass());
+
+  if (!opt.disableAddSeqMemPorts)
+    pm.addNestedPass<firrtl::CircuitOp>(firrtl::createAddSeqMemPortsPass());
+
+  if (opt.emitMetadata)
+    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createCreateSiFiveMetadataPass(
+        opt.replSeqMem, opt.replSeqMemCircuit, opt.replSeqMemFile));
+
+  if (!opt.disableExtractInstances)
+    pm.addNestedPass<firrtl::CircuitOp>(
+        firrtl::createExtractInstancesPass(opt.batchExtractInstances));
+
+  // Run passes to resolve Grand Central features.  This should run before
+  // BlackBoxReader because Grand Central needs to inform BlackBoxReader where
+  // certain black boxes should be placed.
+  if (!opt.disableGrandCentral) {
+    auto &circuitPM = pm.nest<firrtl::CircuitOp>();
+    circuitPM.addPass(firrtl::createGrandCentralPass());
+    circuitPM.addPass(firrtl::createGrandCentralTapsPass());
+    circuitPM.addPass(
+        firrtl::createGrandCentralSignalMappingsPass(opt.outputFilename));
+  }
+
+  // Run SymbolDCE after GC for hierpathop's and just for general cleanup.
+  pm.addNestedPass<firrtl::CircuitOp>(mlir::createSymbolDCEPass());
+
+  // Read black box source files into the IR.
+  StringRef blackBoxRoot = opt.blackBoxRootPath.empty()
+                               ? llvm::sys::path::parent_path(inputFilename)
+                               : StringRef(opt.blackBoxRootPath);
+  pm.nest<firrtl::CircuitOp>().addPass(
+      firrtl::createBlackBoxReaderPass(blackBoxRoot));
+
+  pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
+      firrtl::createDropNamesPass(opt.preserveMode));
+
+  // Run InnerSymbolDCE as late as possible, but before IMDCE.
+  pm.addPass(firrtl::createInnerSymbolDCEPass());
+
+  // The above passes, IMConstProp in particular, introduce additional
+  // canonicalization opportunities that we should pick up here before we
+  // proceed to output-specific pipelines.
+  if (!opt.disableOptimization) {
+    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
+        createSimpleCanonicalizerPass(opt.canonicalizerProfile));
+    if (!opt.disableIMDCE)
+      pm.nest<firrtl::CircuitOp>().addPass(firrtl::createIMDeadCodeElimPass());
+  }
+
+  if (opt.emitOMIR)
+    pm.nest<firrtl::CircuitOp>().addPass(
+        firrtl::createEmitOMIRPass(opt.omirOutFile));
+
+  if (shouldMergeConnections(opt) && !isMergeConnectionsFused(opt))
+    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
+        firrtl::createMergeConnectionsPass(opt.mergeConnectionsAggressively));
+
+  return success();
+}
+
+LogicalResult firtool::populateLowFIRRTLToHW(PassManager &pm,
+                                             const FirtoolOptions &opt) {
+  // Remove TraceAnnotations and write their updated paths to an output
+  // annotation file.
+  pm.nest<firrtl::CircuitOp>().addPass(
+      firrtl::createResolveTracesPass(opt.outputAnnotationFilename));
+
+  // Lower the ref.resolve and ref.send ops and remove the RefType ports.
+  // LowerToHW cannot handle RefType so, this pass must be run to remove all
+  // RefType ports and ops.
+  pm.nest<firrtl::CircuitOp>().addPass(firrtl::createLowerXMRPass());
+
+  pm.addPass(createLowerFIRRTLToHWPass(
+      opt.enableAnnotationWarning, opt.emitChiselAssertsAsSVA,
+      opt.stripMuxPragmas, opt.disableMemRandomization,
+      opt.disableRegRandomization, opt.lowMemory, opt.maxMemory));
+  return success();
+}
+
+LogicalResult firtool::populateHWToSV(PassManager &pm,
+                                      const FirtoolOptions &opt) {
+  // If enabled, run the optimizer.
+  if (!opt.disableOptimization) {
+    auto &modulePM = pm.nest<hw::HWModuleOp>();
+    modulePM.addPass(createCSEPass());
+    modulePM.addPass(createSimpleCanonicalizerPass(opt.canonicalizerProfile));
+    modulePM.addPass(createCSEPass());
+  }
+
+  pm.nest<hw::HWModuleOp>().addPass(seq::createSeqFIRRTLLowerToSVPass(
+      {/*disableRandomization=*/opt.disableRegRandomization,
+       /*addVivadoRAMAddressConflictSynthesisBugWorkaround=*/
+       opt.addVivadoRAMAddressConflictSynthesisBugWorkaround}));
+  pm.addPass(sv::createHWMemSimImplPass(
+      opt.replSeqMem, opt.ignoreReadEnableMem, opt.stripMuxPragmas,
+      opt.disableMemRandomization, opt.disableRegRandomization,
+      opt.addVivadoRAMAddressConflictSynthesisBugWorkaround));
+
+  if (opt.extractTestCode)
+    pm.addPass(sv::createSVExtractTestCodePass(opt.etcDisableInstanceExtraction,
+                                               opt.etcDisableModuleInlining));
+
+  // If enabled, run the optimizer.
+  if (!opt.disableOptimization) {
+    auto &modulePM = pm.nest<hw::HWModuleOp>();
+    modulePM.addPass(createCSEPass());
+    modulePM.addPass(createSimpleCanonicalizerPass(opt.canonicalizerProfile));
+    modulePM.addPass(createCSEPass());
+    modulePM.addPass(sv::createHWCleanupPass());
+  }
+  return success();
+}
+
+/// Add the passes which run right before the emission of Verilog.
+static void
+populatePrepareForExportVerilog(PassManager &pm,
+                                const firtool::FirtoolOptions &opt) {
+  // Legalize unsupported operations within the modules.
+  pm.nest<hw::HWModuleOp>().addPass(sv::createHWLegalizeModulesPass());
+
+  // Tidy up the IR to improve verilog emission quality.
+  if (!opt.disableOptimization)
+    pm.nest<hw::HWModuleOp>().addPass(sv::createPrettifyVerilogPass());
+
+  if (opt.stripFirDebugInfo)
+    pm.addPass(circt::createStripDebugInfoWithPredPass([](mlir::Location loc) {
+      if (auto fileLoc = loc.dyn_cast<FileLineColLoc>())
+        return fileLoc.getFilename().getValue().endswith(".fir");
+      return false;
+    }));
+
+  if (opt.stripDebugInfo)
+    pm.addPass(mlir::createStripDebugInfoPass());
+}
+
+LogicalResult firtool::populateExportVerilog(PassManager &pm,
+                                             const FirtoolOptions &opt,
+                                             llvm::raw_ostream &os) {
+  populatePrepareForExportVerilog(pm, opt);
+  pm.addPass(createExportVerilogPass(os));
+  return success();
+}
+
+LogicalResult firtool::populateExportSplitVerilog(PassManager &pm,
+                                                  const FirtoolOptions &opt,
+                                                  StringRef directory) {
+  populatePrepareForExportVerilog(pm, opt);
+  pm.addPass(createExportSplitVerilogPass(directory));
+  return success();
+}
@@ -21,6 +21,48 @@ using namespace circt::scheduling;
 
 using Dependence = Problem::Dependence;
 
+namespace {
+/// The latencies and physical delays of a chaining problem's operations. They
+/// are looked up once through the linked operator types, and are stored in the
+/// order of the problem's operations, together with a flag to track which
+/// operations have been visited by the topological traversals below.
+struct DelayTable {
+  struct Entry {
+    unsigned latency;
+    float incomingDelay, outgoingDelay;
+    bool handled = false;
+  };
+
+  explicit DelayTable(ChainingProblem &prob) {
+    auto &ops = prob.getOperations();
+    ids.reserve(ops.size());
+    entries.reserve(ops.size());
+    for (auto *op : ops) {
+      auto opr = *prob.getLinkedOperatorType(op);
+      ids[op] = entries.size();
+      entries.push_back({*prob.getLatency(opr), *prob.getIncomingDelay(opr),
+                         *prob.getOutgoingDelay(opr)});
+    }
+  }
+
+  unsigned getId(Operation *op) const { return ids.find(op)->second; }
+  Entry &operator[](unsigned id) { return entries[id]; }
+
+  /// Return true if all operations with a def-use dependence to \p op have
+  /// been handled.
+  bool arePredecessorsHandled(ChainingProblem &prob, Operation *op) {
+    return llvm::all_of(prob.getDependences(op), [&](Dependence dep) {
+      // Auxiliary deps don't carry values.
+      return dep.isAuxiliary() || entries[getId(dep.getSource())].handled;
+    });
+  }
+
+private:
+  DenseMap<Operation *, unsigned> ids;
+  SmallVector<Entry, 0> entries;
+};
+} // anonymous namespace
+
 LogicalResult scheduling::computeChainBreakingDependences(
     ChainingProblem &prob, float cycleTime,
     SmallVectorImpl<Dependence> &result) {
@@ -33,15 +75,27 @@ LogicalResult scheduling::computeChainBreakingDependences(
              << "Delays of operator type '" << opr.getValue()
              << "' exceed maximum cycle time: " << cycleTime;
 
+  DelayTable delays(prob);
+
   // chains[v][u] denotes the accumulated delay incoming at `v`, of the longest
-  // combinational chain originating from `u`.
-  DenseMap<Operation *, SmallDenseMap<Operation *, float>> chains;
+  // combinational chain originating from `u`. The outer vector is indexed by
+  // `v`'s position in the delay table.
+  SmallVector<SmallDenseMap<Operation *, float>, 0> chains(
+      prob.getOperations().size());
 
   // Do a simple DFA-style pass over the dependence graph to determine
   // combinational chains and their respective accumulated delays.
   return handleOperationsInTopologicalOrder(prob, [&](Operation *op) {
+    // Check the predecessors first, so that an early attempt does not leave a
+    // partial result behind.
+    if (!delays.arePredecessorsHandled(prob, op))
+      return failure();
+
+    unsigned id = delays.getId(op);
+    auto &incomingChains = chains[id];
+
     // Mark `op` to be the origin of its own chain.
-    chains[op][op] = 0.0f;
+    incomingChains[op] = 0.0f;
 
     for (auto dep : prob.getDependences(op)) {
       // Skip auxiliary deps, as these don't carry values.
@@ -49,49 +103,56 @@ LogicalResult scheduling::computeChainBreakingDependences(
         continue;
 
       Operation *pred = dep.getSource();
-      if (!chains.count(pred))
-        return failure(); // Predecessor hasn't been handled yet.
-
-      auto predOpr = *prob.getLinkedOperatorType(pred);
-      if (*prob.getLatency(predOpr) > 0) {
+      unsigned predId = delays.getId(pred);
+      auto &predDelays = delays[predId];
+      if (predDelays.latency > 0) {
         // `pred` is not combinational, so none of its incoming chains are
         // extended. Hence, it only contributes its outgoing delay to `op`'s
         // incoming delay.
-        chains[op][pred] = *prob.getOutgoingDelay(predOpr);
+        float &delay = incomingChains[pred];
+        delay = std::max(predDelays.outgoingDelay, delay);
         continue;
       }
 
       // Otherwise, `pred` is combinational. This means that all of its incoming
       // chains, extended by `pred`, are incoming chains for `op`.
-      for (auto incomingChain : chains[pred]) {
+      for (auto incomingChain : chains[predId]) {
         Operation *origin = incomingChain.first;
-        float delay = incomingChain.second;
-        chains[op][origin] = std::max(delay + *prob.getOutgoingDelay(predOpr),
-                                      chains[op][origin]);
+        float &delay = incomingChains[origin];
+        float extended = incomingChain.second + predDelays.outgoingDelay;
+        delay = std::max(extended, delay);
       }
     }
 
     // All chains/accumulated delays incoming at `op` are now known.
-    auto opr = *prob.getLinkedOperatorType(op);
-    for (auto incomingChain : chains[op]) {
+    float incomingDelay = delays[id].incomingDelay;
+    for (auto incomingChain : incomingChains) {
       Operation *origin = incomingChain.first;
       float delay = incomingChain.second;
       // Check whether `op` could be appended to the incoming chain without
       // violating the cycle time constraint.
-      if (delay + *prob.getIncomingDelay(opr) > cycleTime) {
+      if (delay + incomingDelay > cycleTime) {
         // If not, add a chain-breaking auxiliary dep ...
         result.emplace_back(origin, op);
         // ... and end the chain here.
-        chains[op].erase(origin);
+        incomingChains.erase(origin);
       }
     }
 
+    delays[id].handled = true;
     return success();
   });
 }
 
 LogicalResult scheduling::computeStartTimesInCycle(ChainingProblem &prob) {
+  DelayTable delays(prob);
+
   return handleOperationsInTopologicalOrder(prob, [&](Operation *op) {
+    // Existing start times in cycle may be stale, so track the handled
+    // operations explicitly.
+    if (!delays.arePredecessorsHandled(prob, op))
+      return failure();
+
     // `op` will start within its abstract time step as soon as all operand
     // values have reached it.
     unsigned startTime = *prob.getStartTime(op);
@@ -103,13 +164,9 @@ LogicalResult scheduling::computeStartTimesInCycle(ChainingProblem &prob) {
         continue;
 
       Operation *pred = dep.getSource();
-      auto predStartTimeInCycle = prob.getStartTimeInCycle(pred);
-      if (!predStartTimeInCycle)
-        return failure(); // Predecessor hasn't been handled yet.
-
-      auto predOpr = *prob.getLinkedOperatorType(pred);
+      auto &predDelays = delays[delays.getId(pred)];
       unsigned predStartTime = *prob.getStartTime(pred);
-      unsigned predEndTime = predStartTime + *prob.getLatency(predOpr);
+      unsigned predEndTime = predStartTime + predDelays.latency;
 
       if (predEndTime < startTime)
         // Incoming value is completely registered/available with the beginning
@@ -120,12 +177,14 @@ LogicalResult scheduling::computeStartTimesInCycle(ChainingProblem &prob) {
       assert(predEndTime == startTime);
       // If `pred` uses a multi-cycle operator, only its outgoing delay counts.
       float predEndTimeInCycle =
-          (predStartTime == predEndTime ? *predStartTimeInCycle : 0.0f) +
-          *prob.getOutgoingDelay(predOpr);
+          (predStartTime == predEndTime ? *prob.getStartTimeInCycle(pred)
+                                        : 0.0f) +
+          predDelays.outgoingDelay;
       startTimeInCycle = std::max(predEndTimeInCycle, startTimeInCycle);
     }
 
     prob.setStartTimeInCycle(op, startTimeInCycle);
+    delays[delays.getId(op)].handled = true;
     return success();
   });
 }
@@ -33,6 +33,8 @@ LogicalResult Problem::insertDependence(Dependence dep) {
   if (!src || !dst)
     return failure();
 
+  assert(!isFinalized() && "cannot modify a finalized problem");
+
   // record auxiliary dependences explicitly
   if (dep.isAuxiliary())
     auxDependences[dst].insert(src);
@@ -55,6 +57,37 @@ Problem::DependenceRange Problem::getDependences(Operation *op) {
                          DependenceIterator(*this, op, /*end=*/true));
 }
 
+void Problem::finalize() {
+  if (isFinalized())
+    return;
+
+  auto opIndices = std::make_shared<OperationIndexMap>();
+  opIndices->reserve(operations.size());
+  for (auto it : llvm::enumerate(operations))
+    opIndices->try_emplace(it.value(), it.index());
+
+  auto depIndices = std::make_shared<DependenceIndexMap>();
+  dependenceOffsets.reserve(operations.size() + 1);
+  for (auto *op : operations) {
+    dependenceOffsets.push_back(dependences.size());
+    for (auto dep : getDependences(op)) {
+      depIndices->try_emplace(dep, dependences.size());
+      dependences.push_back(dep);
+      dependenceSources.push_back(opIndices->lookup(dep.getSource()));
+    }
+  }
+  dependenceOffsets.push_back(dependences.size());
+
+  operationIndices = std::move(opIndices);
+  dependenceIndices = std::move(depIndices);
+  finalizeProperties();
+}
+
+void Problem::finalizeProperties() {
+  linkedOperatorType.finalize(operationIndices);
+  startTime.finalize(operationIndices);
+}
+
 Problem::PropertyStringVector Problem::getProperties(Operation *op) {
   PropertyStringVector psv;
   if (auto linkedOpr = getLinkedOperatorType(op))
@@ -146,6 +179,11 @@ LogicalResult Problem::verify() {
 // CyclicProblem
 //===----------------------------------------------------------------------===//
 
+void CyclicProblem::finalizeProperties() {
+  Problem::finalizeProperties();
+  distance.finalize(dependenceIndices);
+}
+
 Problem::PropertyStringVector CyclicProblem::getProperties(Dependence dep) {
   auto psv = Problem::getProperties(dep);
   if (auto distance = getDistance(dep))
@@ -197,6 +235,11 @@ LogicalResult CyclicProblem::verify() {
 // ChainingProblem
 //===----------------------------------------------------------------------===//
 
+void ChainingProblem::finalizeProperties() {
+  Problem::finalizeProperties();
+  startTimeInCycle.finalize(operationIndices);
+}
+
 Problem::PropertyStringVector ChainingProblem::getProperties(Operation *op) {
   auto psv = Problem::getProperties(op);
   if (auto stic = getStartTimeInCycle(op))
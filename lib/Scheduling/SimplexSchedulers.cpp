@@ -17,10 +17,12 @@
 #include "mlir/IR/Operation.h"
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Format.h"
 
 #include <algorithm>
+#include <array>
 #include <limits>
 
 #define DEBUG_TYPE "simplex-schedulers"
@@ -33,6 +35,69 @@ using llvm::format;
 
 namespace {
 
+/// The simplex tableau of the schedulers below, stored as compressed rows plus
+/// an index of the rows with a non-zero entry in each column. Every row of a
+/// scheduling LP only refers to a handful of variables, so this keeps the
+/// memory linear in the size of the problem, and lets the row operations skip
+/// the zero entries. The leading parameter columns are populated in most
+/// rows, and are therefore stored densely.
+class SparseTableau {
+public:
+  static constexpr unsigned nDenseColumns = 3;
+  /// A non-zero entry in a sparse column, as (column, value) pair.
+  using Entry = std::pair<unsigned, int>;
+
+  void resize(unsigned nRows, unsigned nColumns) {
+    rows.resize(nRows);
+    columnIndex.resize(nColumns);
+  }
+
+  int get(unsigned row, unsigned col) const {
+    auto &r = rows[row];
+    if (col < nDenseColumns)
+      return r.dense[col];
+    auto it = findEntry(r.sparse, col);
+    return it != r.sparse.end() && it->first == col ? it->second : 0;
+  }
+  void set(unsigned row, unsigned col, int val);
+  /// Return a reference to an entry in one of the dense columns.
+  int &getDense(unsigned row, unsigned col) {
+    assert(col < nDenseColumns);
+    return rows[row].dense[col];
+  }
+
+  /// Return the non-zero entries of \p row in the sparse columns, ordered by
+  /// column.
+  ArrayRef<Entry> getSparseEntries(unsigned row) const {
+    return rows[row].sparse;
+  }
+  /// Return the rows with a non-zero entry in the sparse column \p col.
+  const DenseSet<unsigned> &getColumn(unsigned col) const {
+    assert(col >= nDenseColumns);
+    return columnIndex[col];
+  }
+
+  void multiplyRow(unsigned row, int factor);
+  void addMultipleOfRow(unsigned sourceRow, int factor, unsigned targetRow);
+
+private:
+  struct Row {
+    std::array<int, nDenseColumns> dense = {};
+    SmallVector<Entry, 4> sparse;
+  };
+
+  static const Entry *findEntry(ArrayRef<Entry> entries, unsigned col) {
+    return std::lower_bound(
+        entries.begin(), entries.end(), col,
+        [](const Entry &entry, unsigned col) { return entry.first < col; });
+  }
+
+  SmallVector<Row, 0> rows;
+  SmallVector<DenseSet<unsigned>, 0> columnIndex;
+  /// Reused storage for merging two rows.
+  SmallVector<Entry, 8> scratch;
+};
+
 /// This class provides a framework to model certain scheduling problems as
 /// lexico-parametric linear programs (LP), which are then solved with an
 /// extended version of the dual simplex algorithm.
@@ -85,7 +150,7 @@ protected:
   ///  firstNonBasicVariableColumn ^
   ///                              ─────────── ──────────
   ///                       nonBasicVariables   basicVariables
-  SmallVector<SmallVector<int>> tableau;
+  SparseTableau tableau;
 
   /// During the pivot operation, one column in the elided part of the tableau
   /// is modified; this vector temporarily catches the changes.
@@ -143,15 +208,26 @@ protected:
   /// All other (explicitly stored) columns represent non-basic variables.
   static constexpr unsigned firstNonBasicVariableColumn = nParameters;
 
+  /// A copy of the tableau and the variable locations, to return to a solved
+  /// state without repeating the pivot steps that led away from it.
+  struct TableauSnapshot {
+    SparseTableau tableau;
+    SmallVector<unsigned> nonBasicVariables, basicVariables;
+    SmallVector<int> startTimeLocations;
+    int parameterT;
+  };
+
   /// Allow subclasses to collect additional constraints that are not part of
   /// the input problem, but should be modeled in the linear problem.
   SmallVector<Problem::Dependence> additionalConstraints;
 
+  /// The non-zero coefficients of a row being filled, keyed by column.
+  using TableauRow = SmallDenseMap<unsigned, int, 8>;
+
   virtual Problem &getProblem() = 0;
-  virtual bool fillObjectiveRow(SmallVector<int> &row, unsigned obj);
-  virtual void fillConstraintRow(SmallVector<int> &row,
-                                 Problem::Dependence dep);
-  virtual void fillAdditionalConstraintRow(SmallVector<int> &row,
+  virtual bool fillObjectiveRow(TableauRow &row, unsigned obj);
+  virtual void fillConstraintRow(TableauRow &row, Problem::Dependence dep);
+  virtual void fillAdditionalConstraintRow(TableauRow &row,
                                            Problem::Dependence dep);
   void buildTableau();
 
@@ -167,6 +243,8 @@ protected:
   void pivot(unsigned pivotRow, unsigned pivotColumn);
   LogicalResult solveTableau();
   LogicalResult restoreDualFeasibility();
+  void saveTableau(TableauSnapshot &snapshot);
+  void restoreTableau(const TableauSnapshot &snapshot);
   bool isInBasis(unsigned startTimeVariable);
   unsigned freeze(unsigned startTimeVariable, unsigned timeStep);
   void translate(unsigned column, int factor1, int factorS, int factorT);
@@ -209,8 +287,7 @@ private:
 
 protected:
   Problem &getProblem() override { return prob; }
-  void fillConstraintRow(SmallVector<int> &row,
-                         Problem::Dependence dep) override;
+  void fillConstraintRow(TableauRow &row, Problem::Dependence dep) override;
 
 public:
   CyclicSimplexScheduler(CyclicProblem &prob, Operation *lastOp)
@@ -255,11 +332,12 @@ private:
   SmallVector<unsigned> asapTimes, alapTimes;
   SmallVector<Operation *> unscheduled, scheduled;
   MRT mrt;
+  TableauSnapshot asapTableau;
 
 protected:
   Problem &getProblem() override { return prob; }
   enum { OBJ_LATENCY = 0, OBJ_AXAP /* i.e. either ASAP or ALAP */ };
-  bool fillObjectiveRow(SmallVector<int> &row, unsigned obj) override;
+  bool fillObjectiveRow(TableauRow &row, unsigned obj) override;
   void updateMargins();
   void incrementII();
   void scheduleOperation(Operation *n);
@@ -279,7 +357,7 @@ private:
 
 protected:
   Problem &getProblem() override { return prob; }
-  void fillAdditionalConstraintRow(SmallVector<int> &row,
+  void fillAdditionalConstraintRow(TableauRow &row,
                                    Problem::Dependence dep) override;
 
 public:
@@ -291,19 +369,91 @@ public:
 
 } // anonymous namespace
 
+//===----------------------------------------------------------------------===//
+// SparseTableau
+//===----------------------------------------------------------------------===//
+
+void SparseTableau::set(unsigned row, unsigned col, int val) {
+  auto &r = rows[row];
+  if (col < nDenseColumns) {
+    r.dense[col] = val;
+    return;
+  }
+
+  auto *it = r.sparse.begin() + (findEntry(r.sparse, col) - r.sparse.begin());
+  bool present = it != r.sparse.end() && it->first == col;
+  if (val == 0) {
+    if (present) {
+      r.sparse.erase(it);
+      columnIndex[col].erase(row);
+    }
+    return;
+  }
+  if (present) {
+    it->second = val;
+    return;
+  }
+  r.sparse.insert(it, {col, val});
+  columnIndex[col].insert(row);
+}
+
+void SparseTableau::multiplyRow(unsigned row, int factor) {
+  assert(factor != 0);
+  auto &r = rows[row];
+  for (int &elem : r.dense)
+    elem *= factor;
+  for (auto &entry : r.sparse)
+    entry.second *= factor;
+}
+
+void SparseTableau::addMultipleOfRow(unsigned sourceRow, int factor,
+                                     unsigned targetRow) {
+  assert(factor != 0 && sourceRow != targetRow);
+  auto &src = rows[sourceRow];
+  auto &tgt = rows[targetRow];
+  for (unsigned col = 0; col < nDenseColumns; ++col)
+    tgt.dense[col] += src.dense[col] * factor;
+
+  // Merge the sparse entries, which are ordered by column, and keep the column
+  // index up to date with the entries that appear or cancel out.
+  scratch.clear();
+  auto *srcIt = src.sparse.begin(), *srcEnd = src.sparse.end();
+  auto *tgtIt = tgt.sparse.begin(), *tgtEnd = tgt.sparse.end();
+  while (srcIt != srcEnd || tgtIt != tgtEnd) {
+    if (srcIt == srcEnd || (tgtIt != tgtEnd && tgtIt->first < srcIt->first)) {
+      scratch.push_back(*tgtIt++);
+      continue;
+    }
+    unsigned col = srcIt->first;
+    int val = srcIt->second * factor;
+    ++srcIt;
+    if (tgtIt == tgtEnd || col < tgtIt->first) {
+      scratch.push_back({col, val});
+      columnIndex[col].insert(targetRow);
+      continue;
+    }
+    val += tgtIt->second;
+    ++tgtIt;
+    if (val != 0)
+      scratch.push_back({col, val});
+    else
+      columnIndex[col].erase(targetRow);
+  }
+  std::swap(tgt.sparse, scratch);
+}
+
 //===----------------------------------------------------------------------===//
 // SimplexSchedulerBase
 //===----------------------------------------------------------------------===//
 
-bool SimplexSchedulerBase::fillObjectiveRow(SmallVector<int> &row,
-                                            unsigned obj) {
+bool SimplexSchedulerBase::fillObjectiveRow(TableauRow &row, unsigned obj) {
   assert(obj == 0);
   // Minimize start time of user-specified last operation.
   row[startTimeLocations[startTimeVariables[lastOp]]] = 1;
   return false;
 }
 
-void SimplexSchedulerBase::fillConstraintRow(SmallVector<int> &row,
+void SimplexSchedulerBase::fillConstraintRow(TableauRow &row,
                                              Problem::Dependence dep) {
   auto &prob = getProblem();
   Operation *src = dep.getSource();
@@ -317,7 +467,7 @@ void SimplexSchedulerBase::fillConstraintRow(SmallVector<int> &row,
 }
 
 void SimplexSchedulerBase::fillAdditionalConstraintRow(
-    SmallVector<int> &row, Problem::Dependence dep) {
+    TableauRow &row, Problem::Dependence dep) {
   // Handling is subclass-specific, so do nothing by default.
   (void)row;
   (void)dep;
@@ -342,54 +492,54 @@ void SimplexSchedulerBase::buildTableau() {
   // one column for each parameter (1,S,T), and for all operations
   nColumns = nParameters + nonBasicVariables.size();
 
-  // Helper to grow both the tableau and the implicit column vector.
-  auto addRow = [&]() -> SmallVector<int> & {
-    implicitBasicVariableColumnVector.push_back(0);
-    return tableau.emplace_back(nColumns, 0);
-  };
+  // Collect the rows' coefficients first, and then store them in the tableau,
+  // whose size is only known at the end.
+  SmallVector<TableauRow, 0> rows;
 
   // Set up the objective rows.
   nObjectives = 0;
   bool hasMoreObjectives;
   do {
-    auto &objRowVec = addRow();
-    hasMoreObjectives = fillObjectiveRow(objRowVec, nObjectives);
+    hasMoreObjectives = fillObjectiveRow(rows.emplace_back(), nObjectives);
     ++nObjectives;
   } while (hasMoreObjectives);
 
   // Now set up rows/constraints for the dependences.
   for (auto *op : prob.getOperations()) {
     for (auto &dep : prob.getDependences(op)) {
-      auto &consRowVec = addRow();
-      fillConstraintRow(consRowVec, dep);
+      fillConstraintRow(rows.emplace_back(), dep);
       basicVariables.push_back(var);
       ++var;
     }
   }
   for (auto &dep : additionalConstraints) {
-    auto &consRowVec = addRow();
-    fillAdditionalConstraintRow(consRowVec, dep);
+    fillAdditionalConstraintRow(rows.emplace_back(), dep);
     basicVariables.push_back(var);
     ++var;
   }
 
   // one row per objective + one row per dependence
-  nRows = tableau.size();
+  nRows = rows.size();
+  tableau.resize(nRows, nColumns);
+  implicitBasicVariableColumnVector.assign(nRows, 0);
+  for (unsigned row = 0; row < nRows; ++row)
+    for (auto &entry : rows[row])
+      tableau.set(row, entry.first, entry.second);
 }
 
 int SimplexSchedulerBase::getParametricConstant(unsigned row) {
-  auto &rowVec = tableau[row];
   // Compute the dot-product ~B[row] * u between the constant matrix and the
   // parameter vector.
-  return rowVec[parameter1Column] + rowVec[parameterSColumn] * parameterS +
-         rowVec[parameterTColumn] * parameterT;
+  return tableau.get(row, parameter1Column) +
+         tableau.get(row, parameterSColumn) * parameterS +
+         tableau.get(row, parameterTColumn) * parameterT;
 }
 
 SmallVector<int> SimplexSchedulerBase::getObjectiveVector(unsigned column) {
   SmallVector<int> objVec;
   // Extract the column vector C^T[column] from the cost matrix.
   for (unsigned obj = 0; obj < nObjectives; ++obj)
-    objVec.push_back(tableau[obj][column]);
+    objVec.push_back(tableau.get(obj, column));
   return objVec;
 }
 
@@ -412,12 +562,12 @@ SimplexSchedulerBase::findDualPivotColumn(unsigned pivotRow,
   // tableau). If multiple candidates exist, take the one corresponding to the
   // lexicographical maximum (over the objective rows) of the quotients:
   //   tableau[<objective row>][col] / pivotCand
-  for (unsigned col = firstNonBasicVariableColumn; col < nColumns; ++col) {
+  // Zero entries are never candidates, so we only visit the row's non-zeros.
+  for (auto [col, pivotCand] : tableau.getSparseEntries(pivotRow)) {
     if (frozenVariables.count(
             nonBasicVariables[col - firstNonBasicVariableColumn]))
       continue;
 
-    int pivotCand = tableau[pivotRow][col];
     // Only negative candidates bring us closer to the optimal solution.
     // However, when freezing variables to a certain value, we accept that the
     // value of the objective function degrades.
@@ -427,7 +577,7 @@ SimplexSchedulerBase::findDualPivotColumn(unsigned pivotRow,
 
       SmallVector<int> quot;
       for (unsigned obj = 0; obj < nObjectives; ++obj)
-        quot.push_back(tableau[obj][col] / pivotCand);
+        quot.push_back(tableau.get(obj, col) / pivotCand);
 
       if (std::lexicographical_compare(maxQuot.begin(), maxQuot.end(),
                                        quot.begin(), quot.end())) {
@@ -466,13 +616,16 @@ SimplexSchedulerBase::findPrimalPivotRow(unsigned pivotColumn) {
   // tableau). If multiple candidates exist, take the one corresponding to the
   // minimum of the quotient:
   //   parametricConstant(row) / pivotCand
-  for (unsigned row = firstConstraintRow; row < nRows; ++row) {
-    int pivotCand = tableau[row][pivotColumn];
+  // Ties are broken in favor of the topmost row.
+  for (unsigned row : tableau.getColumn(pivotColumn)) {
+    if (row < firstConstraintRow)
+      continue;
+    int pivotCand = tableau.get(row, pivotColumn);
     if (pivotCand > 0) {
       // The constraint matrix has only {-1, 0, 1} entries by construction.
       assert(pivotCand == 1);
       int quot = getParametricConstant(row) / pivotCand;
-      if (quot < minQuot) {
+      if (quot < minQuot || (quot == minQuot && pivotRow && row < *pivotRow)) {
         minQuot = quot;
         pivotRow = row;
       }
@@ -483,18 +636,14 @@ SimplexSchedulerBase::findPrimalPivotRow(unsigned pivotColumn) {
 }
 
 void SimplexSchedulerBase::multiplyRow(unsigned row, int factor) {
-  assert(factor != 0);
-  for (unsigned col = 0; col < nColumns; ++col)
-    tableau[row][col] *= factor;
+  tableau.multiplyRow(row, factor);
   // Also multiply the corresponding entry in the temporary column vector.
   implicitBasicVariableColumnVector[row] *= factor;
 }
 
 void SimplexSchedulerBase::addMultipleOfRow(unsigned sourceRow, int factor,
                                             unsigned targetRow) {
-  assert(factor != 0 && sourceRow != targetRow);
-  for (unsigned col = 0; col < nColumns; ++col)
-    tableau[targetRow][col] += tableau[sourceRow][col] * factor;
+  tableau.addMultipleOfRow(sourceRow, factor, targetRow);
   // Again, perform row operation on the temporary column vector as well.
   implicitBasicVariableColumnVector[targetRow] +=
       implicitBasicVariableColumnVector[sourceRow] * factor;
@@ -509,29 +658,30 @@ void SimplexSchedulerBase::pivot(unsigned pivotRow, unsigned pivotColumn) {
   // The implicit columns are part of an identity matrix.
   implicitBasicVariableColumnVector[pivotRow] = 1;
 
-  int pivotElem = tableau[pivotRow][pivotColumn];
+  int pivotElem = tableau.get(pivotRow, pivotColumn);
   // The constraint matrix has only {-1, 0, 1} entries by construction.
   assert(pivotElem * pivotElem == 1);
   // Make `tableau[pivotRow][pivotColumn]` := 1
   multiplyRow(pivotRow, 1 / pivotElem);
 
-  for (unsigned row = 0; row < nRows; ++row) {
+  // Only the rows with a non-zero entry in the pivot column are affected. The
+  // row operations below modify the column index, so take a copy first.
+  SmallVector<unsigned> affectedRows(tableau.getColumn(pivotColumn).begin(),
+                                     tableau.getColumn(pivotColumn).end());
+  for (unsigned row : affectedRows) {
     if (row == pivotRow)
       continue;
 
-    int elem = tableau[row][pivotColumn];
-    if (elem == 0)
-      continue; // nothing to do
-
     // Make `tableau[row][pivotColumn]` := 0.
-    addMultipleOfRow(pivotRow, -elem, row);
+    addMultipleOfRow(pivotRow, -tableau.get(row, pivotColumn), row);
   }
 
   // Swap the pivot column with the implicitly constructed column vector.
   // We really only need to copy in one direction here, as the former pivot
-  // column is a unit vector, which is not stored explicitly.
-  for (unsigned row = 0; row < nRows; ++row) {
-    tableau[row][pivotColumn] = implicitBasicVariableColumnVector[row];
+  // column is a unit vector, which is not stored explicitly. The implicit
+  // column is zero outside of the affected rows.
+  for (unsigned row : affectedRows) {
+    tableau.set(row, pivotColumn, implicitBasicVariableColumnVector[row]);
     implicitBasicVariableColumnVector[row] = 0; // Reset for next pivot step.
   }
 
@@ -565,8 +715,8 @@ LogicalResult SimplexSchedulerBase::solveTableau() {
     // positive entries, and the problem is in principle infeasible. However, if
     // the entry in the `parameterTColumn` is positive, we can make the LP
     // feasible again by increasing the II.
-    int entry1Col = tableau[*pivotRow][parameter1Column];
-    int entryTCol = tableau[*pivotRow][parameterTColumn];
+    int entry1Col = tableau.get(*pivotRow, parameter1Column);
+    int entryTCol = tableau.get(*pivotRow, parameterTColumn);
     if (entryTCol > 0) {
       // The negation of `entry1Col` is not in the paper. I think this is an
       // oversight, because `entry1Col` certainly is negative (otherwise the row
@@ -608,6 +758,22 @@ LogicalResult SimplexSchedulerBase::restoreDualFeasibility() {
   return success();
 }
 
+void SimplexSchedulerBase::saveTableau(TableauSnapshot &snapshot) {
+  snapshot.tableau = tableau;
+  snapshot.nonBasicVariables = nonBasicVariables;
+  snapshot.basicVariables = basicVariables;
+  snapshot.startTimeLocations = startTimeLocations;
+  snapshot.parameterT = parameterT;
+}
+
+void SimplexSchedulerBase::restoreTableau(const TableauSnapshot &snapshot) {
+  tableau = snapshot.tableau;
+  nonBasicVariables = snapshot.nonBasicVariables;
+  basicVariables = snapshot.basicVariables;
+  startTimeLocations = snapshot.startTimeLocations;
+  parameterT = snapshot.parameterT;
+}
+
 bool SimplexSchedulerBase::isInBasis(unsigned startTimeVariable) {
   assert(startTimeVariable < startTimeLocations.size());
   int loc = startTimeLocations[startTimeVariable];
@@ -647,15 +813,24 @@ unsigned SimplexSchedulerBase::freeze(unsigned startTimeVariable,
 
 void SimplexSchedulerBase::translate(unsigned column, int factor1, int factorS,
                                      int factorT) {
-  for (unsigned row = 0; row < nRows; ++row) {
-    auto &rowVec = tableau[row];
-    int elem = rowVec[column];
+  auto translateRow = [&](unsigned row) {
+    int elem = tableau.get(row, column);
     if (elem == 0)
-      continue;
+      return;
+
+    tableau.getDense(row, parameter1Column) += -elem * factor1;
+    tableau.getDense(row, parameterSColumn) += -elem * factorS;
+    tableau.getDense(row, parameterTColumn) += -elem * factorT;
+  };
 
-    rowVec[parameter1Column] += -elem * factor1;
-    rowVec[parameterSColumn] += -elem * factorS;
-    rowVec[parameterTColumn] += -elem * factorT;
+  // Only the parameter columns are modified, hence iterating over the column
+  // index is safe.
+  if (column < firstNonBasicVariableColumn) {
+    for (unsigned row = 0; row < nRows; ++row)
+      translateRow(row);
+  } else {
+    for (unsigned row : tableau.getColumn(column))
+      translateRow(row);
   }
 }
 
@@ -759,7 +934,7 @@ void SimplexSchedulerBase::dumpTableau() {
     for (unsigned j = 0; j < nColumns; ++j) {
       if (j == firstNonBasicVariableColumn)
         dbgs() << " |";
-      dbgs() << format(" %3d", tableau[i][j]);
+      dbgs() << format(" %3d", tableau.get(i, j));
     }
     if (i >= firstConstraintRow)
       dbgs() << format(" |< %2d", basicVariables[i - firstConstraintRow]);
@@ -808,7 +983,7 @@ LogicalResult SimplexScheduler::schedule() {
 // CyclicSimplexScheduler
 //===----------------------------------------------------------------------===//
 
-void CyclicSimplexScheduler::fillConstraintRow(SmallVector<int> &row,
+void CyclicSimplexScheduler::fillConstraintRow(TableauRow &row,
                                                Problem::Dependence dep) {
   SimplexSchedulerBase::fillConstraintRow(row, dep);
   if (auto dist = prob.getDistance(dep))
@@ -969,7 +1144,7 @@ void ModuloSimplexScheduler::MRT::release(Operation *op) {
   revTab.erase(it);
 }
 
-bool ModuloSimplexScheduler::fillObjectiveRow(SmallVector<int> &row,
+bool ModuloSimplexScheduler::fillObjectiveRow(TableauRow &row,
                                               unsigned obj) {
   switch (obj) {
   case OBJ_LATENCY:
@@ -988,22 +1163,27 @@ bool ModuloSimplexScheduler::fillObjectiveRow(SmallVector<int> &row,
 }
 
 void ModuloSimplexScheduler::updateMargins() {
-  // Assumption: current secondary objective is "ASAP".
-  // Negate the objective row once to effectively maximize the sum of start
-  // times, which yields the "ALAP" times after solving the tableau. Then,
-  // negate it again to restore the "ASAP" objective, and store these times as
-  // well.
-  for (auto *axapTimes : {&alapTimes, &asapTimes}) {
-    multiplyRow(OBJ_AXAP, -1);
-    // This should not fail for a feasible tableau.
-    auto dualFeasRestored = restoreDualFeasibility();
-    auto solved = solveTableau();
-    assert(succeeded(dualFeasRestored) && succeeded(solved));
-    (void)dualFeasRestored, (void)solved;
-
-    for (unsigned stv = 0; stv < startTimeLocations.size(); ++stv)
-      (*axapTimes)[stv] = getStartTime(stv);
-  }
+  // Assumption: current secondary objective is "ASAP", and the tableau is
+  // solved, so it already holds the "ASAP" times.
+  for (unsigned stv = 0; stv < startTimeLocations.size(); ++stv)
+    asapTimes[stv] = getStartTime(stv);
+
+  // Negate the objective row to effectively maximize the sum of start times,
+  // which yields the "ALAP" times after solving the tableau. Afterwards, we
+  // return to the "ASAP" objective by restoring the solved tableau, instead of
+  // negating the row again and pivoting back.
+  saveTableau(asapTableau);
+  multiplyRow(OBJ_AXAP, -1);
+  // This should not fail for a feasible tableau.
+  auto dualFeasRestored = restoreDualFeasibility();
+  auto solved = solveTableau();
+  assert(succeeded(dualFeasRestored) && succeeded(solved));
+  (void)dualFeasRestored, (void)solved;
+
+  for (unsigned stv = 0; stv < startTimeLocations.size(); ++stv)
+    alapTimes[stv] = getStartTime(stv);
+
+  restoreTableau(asapTableau);
 }
 
 void ModuloSimplexScheduler::incrementII() {
@@ -1176,7 +1356,7 @@ LogicalResult ModuloSimplexScheduler::schedule() {
 //===----------------------------------------------------------------------===//
 
 void ChainingSimplexScheduler::fillAdditionalConstraintRow(
-    SmallVector<int> &row, Problem::Dependence dep) {
+    TableauRow &row, Problem::Dependence dep) {
   fillConstraintRow(row, dep);
   // One _extra_ time step breaks the chain (note that the latency is negative
   // in the tableau).
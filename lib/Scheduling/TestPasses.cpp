@@ -18,6 +18,9 @@
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/Pass/Pass.h"
 
+#include <chrono>
+#include <type_traits>
+
 using namespace mlir;
 using namespace circt;
 using namespace circt::scheduling;
@@ -181,6 +184,9 @@ void TestProblemPass::runOnOperation() {
     return signalPassFailure();
   }
 
+  // the imported solution is stored densely
+  prob.finalize();
+
   // get schedule from the test case
   for (auto *op : prob.getOperations())
     if (auto startTimeAttr = op->getAttrOfType<IntegerAttr>("problemStartTime"))
@@ -221,6 +227,9 @@ void TestCyclicProblemPass::runOnOperation() {
     return signalPassFailure();
   }
 
+  // the imported solution is stored densely
+  prob.finalize();
+
   // get II from the test case
   if (auto attr = func->getAttrOfType<IntegerAttr>("problemInitiationInterval"))
     prob.setInitiationInterval(attr.getInt());
@@ -265,6 +274,9 @@ void TestChainingProblemPass::runOnOperation() {
     return signalPassFailure();
   }
 
+  // the imported solution is stored densely
+  prob.finalize();
+
   // get schedule and physical start times from the test case
   for (auto *op : prob.getOperations()) {
     if (auto startTimeAttr = op->getAttrOfType<IntegerAttr>("problemStartTime"))
@@ -730,6 +742,155 @@ void TestCPSATSchedulerPass::runOnOperation() {
 
 #endif // SCHEDULING_OR_TOOLS
 
+//===----------------------------------------------------------------------===//
+// Scheduling of SSP instances
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct TestSSPSchedulerPass
+    : public PassWrapper<TestSSPSchedulerPass, OperationPass<ModuleOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(TestSSPSchedulerPass)
+
+  TestSSPSchedulerPass() = default;
+  TestSSPSchedulerPass(const TestSSPSchedulerPass &) {}
+  Option<std::string> scheduler{
+      *this, "scheduler", llvm::cl::init("simplex"),
+      llvm::cl::desc("One of 'asap', 'simplex', 'lp' or 'cpsat'")};
+  Option<std::string> lastOpName{
+      *this, "last-op",
+      llvm::cl::desc("Name of the operation whose start time is minimized "
+                     "(default: the last operation in the graph)")};
+  Option<float> cycleTime{
+      *this, "cycle-time", llvm::cl::init(0.0f),
+      llvm::cl::desc("Cycle time for the chaining problem")};
+  Option<bool> metrics{
+      *this, "metrics", llvm::cl::init(false),
+      llvm::cl::desc("Report latency, II and solver time as remarks")};
+  void runOnOperation() override;
+  StringRef getArgument() const override { return "test-ssp-scheduler"; }
+  StringRef getDescription() const override {
+    return "Schedule SSP instances with the selected scheduler";
+  }
+
+private:
+  template <typename ProblemT>
+  LogicalResult schedule(InstanceOp instOp);
+  template <typename ProblemT>
+  LogicalResult runScheduler(ProblemT &prob, Operation *lastOp,
+                             InstanceOp instOp);
+};
+} // anonymous namespace
+
+template <typename ProblemT>
+LogicalResult TestSSPSchedulerPass::runScheduler(ProblemT &prob,
+                                                 Operation *lastOp,
+                                                 InstanceOp instOp) {
+  if (scheduler == "asap") {
+    if constexpr (std::is_same_v<ProblemT, Problem>)
+      return scheduleASAP(prob);
+  } else if (scheduler == "simplex") {
+    if constexpr (std::is_same_v<ProblemT, ChainingProblem>) {
+      if (cycleTime <= 0.0f)
+        return instOp.emitError("the chaining problem needs a cycle-time");
+      return scheduleSimplex(prob, lastOp, cycleTime);
+    } else {
+      return scheduleSimplex(prob, lastOp);
+    }
+  }
+#ifdef SCHEDULING_OR_TOOLS
+  else if (scheduler == "lp") {
+    if constexpr (std::is_same_v<ProblemT, Problem> ||
+                  std::is_same_v<ProblemT, CyclicProblem>)
+      return scheduleLP(prob, lastOp);
+  } else if (scheduler == "cpsat") {
+    if constexpr (std::is_same_v<ProblemT, SharedOperatorsProblem>)
+      return scheduleCPSAT(prob, lastOp);
+  }
+#endif
+
+  return instOp.emitError() << "scheduler '" << scheduler
+                            << "' does not support problem class '"
+                            << instOp.getProblemName() << "'";
+}
+
+template <typename ProblemT>
+LogicalResult TestSSPSchedulerPass::schedule(InstanceOp instOp) {
+  auto prob = loadProblem<ProblemT>(instOp);
+  if (failed(prob.check()))
+    return failure();
+
+  Operation *lastOp = nullptr;
+  if (lastOpName.empty()) {
+    if (!prob.getOperations().empty())
+      lastOp = prob.getOperations().back();
+  } else {
+    for (auto *op : prob.getOperations())
+      if (auto name = prob.getOperationName(op))
+        if (name.getValue() == lastOpName)
+          lastOp = op;
+  }
+  if (!lastOp)
+    return instOp.emitError("instance has no last operation to schedule");
+
+  auto start = std::chrono::steady_clock::now();
+  if (failed(runScheduler(prob, lastOp, instOp)))
+    return instOp.emitError("scheduling failed");
+  std::chrono::duration<double, std::micro> time =
+      std::chrono::steady_clock::now() - start;
+
+  if (failed(prob.verify()))
+    return instOp.emitError("schedule verification failed");
+
+  OpBuilder builder(instOp);
+  InstanceOp scheduledOp = saveProblem<ProblemT>(prob, builder);
+  if (!metrics)
+    return success();
+
+  // The latency is the time step in which all operations have finished.
+  unsigned latency = 0;
+  for (auto *op : prob.getOperations())
+    latency = std::max(latency, *prob.getStartTime(op) +
+                                    *prob.getLatency(
+                                        *prob.getLinkedOperatorType(op)));
+  auto diag = scheduledOp.emitRemark() << "latency = " << latency;
+  if constexpr (std::is_base_of_v<CyclicProblem, ProblemT>)
+    diag << ", II = " << *prob.getInitiationInterval();
+  diag << ", time = " << (uint64_t)time.count() << " us";
+  return success();
+}
+
+void TestSSPSchedulerPass::runOnOperation() {
+  ModuleOp module = getOperation();
+  SmallVector<InstanceOp> instanceOps;
+  module.walk([&](ssp::InstanceOp op) { instanceOps.push_back(op); });
+
+  // Attempt all instances, so that the diagnostics (e.g. the metrics) cover
+  // the whole input even if some instances cannot be scheduled.
+  bool anyFailed = false;
+  for (auto op : instanceOps) {
+    StringRef probName = op.getProblemName();
+    LogicalResult result = failure();
+    if (probName.equals("Problem"))
+      result = schedule<Problem>(op);
+    else if (probName.equals("CyclicProblem"))
+      result = schedule<CyclicProblem>(op);
+    else if (probName.equals("ChainingProblem"))
+      result = schedule<ChainingProblem>(op);
+    else if (probName.equals("SharedOperatorsProblem"))
+      result = schedule<SharedOperatorsProblem>(op);
+    else if (probName.equals("ModuloProblem"))
+      result = schedule<ModuloProblem>(op);
+    else
+      op->emitError("Unhandled problem class: ") << probName;
+
+    anyFailed |= failed(result);
+  }
+
+  llvm::for_each(instanceOps, [](InstanceOp op) { op.erase(); });
+  if (anyFailed)
+    signalPassFailure();
+}
+
 //===----------------------------------------------------------------------===//
 // Pass registration
 //===----------------------------------------------------------------------===//
@@ -761,6 +922,9 @@ void registerSchedulingTestPasses() {
   mlir::registerPass([]() -> std::unique_ptr<::mlir::Pass> {
     return std::make_unique<TestSSPRoundtripPass>();
   });
+  mlir::registerPass([]() -> std::unique_ptr<::mlir::Pass> {
+    return std::make_unique<TestSSPSchedulerPass>();
+  });
 #ifdef SCHEDULING_OR_TOOLS
   mlir::registerPass([]() -> std::unique_ptr<::mlir::Pass> {
     return std::make_unique<TestLPSchedulerPass>();
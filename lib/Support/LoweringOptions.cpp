@@ -46,6 +46,8 @@ parseWireSpillingHeuristic(StringRef option) {
              llvm::Optional<LoweringOptions::WireSpillingHeuristic>>(option)
       .Case("spillLargeTermsWithNamehints",
             LoweringOptions::SpillLargeTermsWithNamehints)
+      .Case("spillLargeDuplicatedExpressions",
+            LoweringOptions::SpillLargeDuplicatedExpressions)
       .Default(llvm::None);
 }
 
@@ -76,6 +78,8 @@ void LoweringOptions::parse(StringRef text, ErrorHandlerT errorHandler) {
       explicitBitcast = true;
     } else if (option == "emitReplicatedOpsToHeader") {
       emitReplicatedOpsToHeader = true;
+    } else if (option == "skipUnchangedFiles") {
+      skipUnchangedFiles = true;
     } else if (option.consume_front("maximumNumberOfTermsPerExpression=")) {
       if (option.getAsInteger(10, maximumNumberOfTermsPerExpression)) {
         errorHandler("expected integer source width");
@@ -99,7 +103,8 @@ void LoweringOptions::parse(StringRef text, ErrorHandlerT errorHandler) {
       if (auto heuristic = parseWireSpillingHeuristic(option)) {
         wireSpillingHeuristicSet |= *heuristic;
       } else {
-        errorHandler("expected ''spillLargeTermsWithNamehints'");
+        errorHandler("expected 'spillLargeTermsWithNamehints' or "
+                     "'spillLargeDuplicatedExpressions'");
       }
     } else if (option.consume_front("wireSpillingNamehintTermLimit=")) {
       if (option.getAsInteger(10, wireSpillingNamehintTermLimit)) {
@@ -107,6 +112,12 @@ void LoweringOptions::parse(StringRef text, ErrorHandlerT errorHandler) {
             "expected integer for number of namehint heurstic term limit");
         wireSpillingNamehintTermLimit = DEFAULT_NAMEHINT_TERM_LIMIT;
       }
+    } else if (option.consume_front("wireSpillingDuplicateTermLimit=")) {
+      if (option.getAsInteger(10, wireSpillingDuplicateTermLimit)) {
+        errorHandler(
+            "expected integer for number of duplicate heurstic term limit");
+        wireSpillingDuplicateTermLimit = DEFAULT_DUPLICATE_TERM_LIMIT;
+      }
     } else {
       errorHandler(llvm::Twine("unknown style option \'") + option + "\'");
       // We continue parsing options after a failure.
@@ -131,6 +142,8 @@ std::string LoweringOptions::toString() const {
     options += "explicitBitcast,";
   if (emitReplicatedOpsToHeader)
     options += "emitReplicatedOpsToHeader,";
+  if (skipUnchangedFiles)
+    options += "skipUnchangedFiles,";
   if (locationInfoStyle == LocationInfoStyle::WrapInAtSquareBracket)
     options += "locationInfoStyle=wrapInAtSquareBracket,";
   if (locationInfoStyle == LocationInfoStyle::None)
@@ -142,6 +155,9 @@ std::string LoweringOptions::toString() const {
   if (isWireSpillingHeuristicEnabled(
           WireSpillingHeuristic::SpillLargeTermsWithNamehints))
     options += "wireSpillingHeuristic=spillLargeTermsWithNamehints,";
+  if (isWireSpillingHeuristicEnabled(
+          WireSpillingHeuristic::SpillLargeDuplicatedExpressions))
+    options += "wireSpillingHeuristic=spillLargeDuplicatedExpressions,";
   if (disallowExpressionInliningInPorts)
     options += "disallowExpressionInliningInPorts,";
   if (disallowMuxInlining)
@@ -152,6 +168,9 @@ std::string LoweringOptions::toString() const {
   if (maximumNumberOfTermsPerExpression != DEFAULT_TERM_LIMIT)
     options += "maximumNumberOfTermsPerExpression=" +
                std::to_string(maximumNumberOfTermsPerExpression) + ',';
+  if (wireSpillingDuplicateTermLimit != DEFAULT_DUPLICATE_TERM_LIMIT)
+    options += "wireSpillingDuplicateTermLimit=" +
+               std::to_string(wireSpillingDuplicateTermLimit) + ',';
 
   // Remove a trailing comma if present.
   if (!options.empty()) {
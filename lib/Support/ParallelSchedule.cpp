@@ -0,0 +1,21 @@
+//===- ParallelSchedule.cpp - Ordering of parallel work ---------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the work estimates used to order parallel tasks.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Support/ParallelSchedule.h"
+
+using namespace circt;
+
+size_t circt::estimateWork(Operation *op) {
+  size_t numOps = 0;
+  op->walk([&](Operation *) { ++numOps; });
+  return numOps;
+}
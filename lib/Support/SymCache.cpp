@@ -26,4 +26,79 @@ void SymbolCacheBase::addDefinitions(mlir::Operation *top) {
       for (auto symOp : block.getOps<mlir::SymbolOpInterface>())
         addSymbol(symOp);
 }
+
+//===----------------------------------------------------------------------===//
+// LazySymbolCache
+//===----------------------------------------------------------------------===//
+
+void LazySymbolCache::populate() const {
+  std::call_once(populated, [&] {
+    for (auto &region : top->getRegions())
+      for (auto &block : region.getBlocks())
+        for (auto symOp : block.getOps<mlir::SymbolOpInterface>())
+          getShard(symOp.getNameAttr())
+              .symbolCache.try_emplace(symOp.getNameAttr(), symOp);
+  });
+}
+
+void LazySymbolCache::addDefinition(mlir::Attribute key, mlir::Operation *op) {
+  populate();
+  auto &shard = getShard(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.symbolCache.try_emplace(key, op);
+}
+
+mlir::Operation *LazySymbolCache::getDefinition(mlir::Attribute attr) const {
+  populate();
+  auto &shard = getShard(attr);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.symbolCache.find(attr);
+  if (it == shard.symbolCache.end())
+    return nullptr;
+  return it->second;
+}
+
+struct LazySymbolCache::LazySymbolCacheIteratorImpl
+    : public SymbolCacheBase::CacheIteratorImpl {
+  using Iterator = decltype(Shard::symbolCache)::iterator;
+
+  LazySymbolCacheIteratorImpl(LazySymbolCache &cache, unsigned shard)
+      : cache(cache), shard(shard) {
+    if (shard != NumShards)
+      it = cache.shards[shard].symbolCache.begin();
+    skipEmptyShards();
+  }
+
+  /// Move to the next shard as long as the current one has been exhausted.
+  void skipEmptyShards() {
+    while (shard != NumShards && it == cache.shards[shard].symbolCache.end())
+      if (++shard != NumShards)
+        it = cache.shards[shard].symbolCache.begin();
+  }
+
+  CacheItem operator*() override { return {it->getFirst(), it->getSecond()}; }
+  void operator++() override {
+    ++it;
+    skipEmptyShards();
+  }
+  bool operator==(CacheIteratorImpl *other) override {
+    auto *rhs = static_cast<LazySymbolCacheIteratorImpl *>(other);
+    return shard == rhs->shard && (shard == NumShards || it == rhs->it);
+  }
+
+  LazySymbolCache &cache;
+  unsigned shard;
+  Iterator it;
+};
+
+SymbolCacheBase::Iterator LazySymbolCache::begin() {
+  populate();
+  return SymbolCacheBase::Iterator(
+      std::make_unique<LazySymbolCacheIteratorImpl>(*this, 0));
+}
+
+SymbolCacheBase::Iterator LazySymbolCache::end() {
+  return SymbolCacheBase::Iterator(
+      std::make_unique<LazySymbolCacheIteratorImpl>(*this, NumShards));
+}
 } // namespace circt
@@ -0,0 +1,144 @@
+//===- TaskTrace.cpp - Per-thread task timelines ----------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file records the tasks of parallel passes and writes them in the Chrome
+// trace event format.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Support/TaskTrace.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Threading.h"
+
+#include <atomic>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+using namespace circt;
+using namespace std::chrono;
+
+namespace {
+struct TaskEvent {
+  std::string name;
+  std::string detail;
+  uint64_t threadID;
+  steady_clock::time_point start;
+  steady_clock::time_point end;
+};
+
+struct TaskTrace {
+  std::atomic<bool> enabled = false;
+  steady_clock::time_point begin;
+
+  std::mutex mutex;
+  std::vector<TaskEvent> events;
+  /// The trace number of each thread, in the order of their first finished
+  /// task.
+  llvm::DenseMap<uint64_t, unsigned> threadNumbers;
+
+  unsigned getThreadNumber(uint64_t threadID) {
+    return threadNumbers.try_emplace(threadID, threadNumbers.size())
+        .first->second;
+  }
+};
+} // namespace
+
+static TaskTrace &getTaskTrace() {
+  static TaskTrace trace;
+  return trace;
+}
+
+void circt::enableTaskTrace() {
+  auto &trace = getTaskTrace();
+  std::lock_guard<std::mutex> lock(trace.mutex);
+  trace.begin = steady_clock::now();
+  trace.getThreadNumber(llvm::get_threadid());
+  trace.enabled = true;
+}
+
+bool circt::isTaskTraceEnabled() {
+  return getTaskTrace().enabled.load(std::memory_order_relaxed);
+}
+
+void circt::writeTaskTrace(llvm::raw_ostream &os) {
+  auto &trace = getTaskTrace();
+  std::vector<TaskEvent> events;
+  llvm::DenseMap<uint64_t, unsigned> threadNumbers;
+  {
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    std::swap(events, trace.events);
+    threadNumbers = trace.threadNumbers;
+  }
+
+  // Sort the tasks by thread and start time, such that the order of the file
+  // does not depend on the order in which the threads finished their tasks.
+  for (auto &event : events)
+    event.threadID = threadNumbers.lookup(event.threadID);
+  llvm::stable_sort(events, [](const TaskEvent &a, const TaskEvent &b) {
+    return std::tie(a.threadID, a.start) < std::tie(b.threadID, b.start);
+  });
+
+  auto getMicroseconds = [&](steady_clock::duration duration) {
+    return int64_t(duration_cast<microseconds>(duration).count());
+  };
+  llvm::json::OStream json(os);
+  json.object([&] {
+    json.attributeArray("traceEvents", [&] {
+      for (auto &event : events) {
+        json.object([&] {
+          json.attribute("name", event.name);
+          json.attribute("ph", "X");
+          json.attribute("pid", 1);
+          json.attribute("tid", int64_t(event.threadID));
+          json.attribute("ts", getMicroseconds(event.start - trace.begin));
+          json.attribute("dur", getMicroseconds(event.end - event.start));
+          json.attributeObject(
+              "args", [&] { json.attribute("detail", event.detail); });
+        });
+      }
+      // Name the threads, with the thread that enabled the trace first.
+      for (unsigned i = 0, e = threadNumbers.size(); i != e; ++i) {
+        json.object([&] {
+          json.attribute("name", "thread_name");
+          json.attribute("ph", "M");
+          json.attribute("pid", 1);
+          json.attribute("tid", int64_t(i));
+          json.attributeObject("args", [&] {
+            json.attribute("name", i ? "worker " + std::to_string(i)
+                                     : std::string("main"));
+          });
+        });
+      }
+    });
+    json.attribute("displayTimeUnit", "ms");
+  });
+  os << "\n";
+}
+
+TaskTraceScope::TaskTraceScope(StringRef name,
+                               llvm::function_ref<std::string()> detail)
+    : active(isTaskTraceEnabled()), name(name) {
+  if (!active)
+    return;
+  this->detail = detail();
+  start = steady_clock::now();
+}
+
+TaskTraceScope::~TaskTraceScope() {
+  if (!active)
+    return;
+  auto end = steady_clock::now();
+  auto &trace = getTaskTrace();
+  auto threadID = llvm::get_threadid();
+  std::lock_guard<std::mutex> lock(trace.mutex);
+  trace.getThreadNumber(threadID);
+  trace.events.push_back({name.str(), std::move(detail), threadID, start, end});
+}
@@ -301,6 +301,15 @@ public:
     return impl->nativeOpSpecificPatternMap;
   }
 
+  /// Return the native patterns matching the given kind, in the order they
+  /// were added. Unlike a lookup in the map above, this does not copy the list.
+  ArrayRef<PatternTy *> getSpecificNativePatterns(KeyTy key) const {
+    auto it = impl->nativeOpSpecificPatternMap.find(key);
+    if (it == impl->nativeOpSpecificPatternMap.end())
+      return {};
+    return it->second;
+  }
+
 private:
   /// The internal implementation of the frozen pattern set.
   struct Impl {
@@ -17,7 +17,7 @@ using namespace circt::ExportSystemC;
 
 void EmissionPrinter::emitOp(Operation *op) {
   currentLoc = op->getLoc();
-  auto patterns = opPatterns.getSpecificNativePatterns().lookup(op->getName());
+  auto patterns = opPatterns.getSpecificNativePatterns(op->getName());
   for (auto *pat : patterns) {
     if (pat->matchStatement(op)) {
       pat->emitStatement(op, *this);
@@ -34,8 +34,7 @@ void EmissionPrinter::emitOp(Operation *op) {
 }
 
 void EmissionPrinter::emitType(Type type) {
-  auto patterns =
-      typePatterns.getSpecificNativePatterns().lookup(type.getTypeID());
+  auto patterns = typePatterns.getSpecificNativePatterns(type.getTypeID());
   for (auto *pat : patterns) {
     if (pat->match(type)) {
       pat->emitType(type, *this);
@@ -52,8 +51,7 @@ void EmissionPrinter::emitType(Type type) {
 }
 
 void EmissionPrinter::emitAttr(Attribute attr) {
-  auto patterns =
-      attrPatterns.getSpecificNativePatterns().lookup(attr.getTypeID());
+  auto patterns = attrPatterns.getSpecificNativePatterns(attr.getTypeID());
   for (auto *pat : patterns) {
     if (pat->match(attr)) {
       pat->emitAttr(attr, *this);
@@ -72,7 +70,7 @@ InlineEmitter EmissionPrinter::getInlinable(Value value) {
                                         : value.getDefiningOp();
   Location requestLoc = currentLoc;
   currentLoc = op->getLoc();
-  auto patterns = opPatterns.getSpecificNativePatterns().lookup(op->getName());
+  auto patterns = opPatterns.getSpecificNativePatterns(op->getName());
   for (auto *pat : patterns) {
     MatchResult match = pat->matchInlinable(value);
     if (!match.failed()) {
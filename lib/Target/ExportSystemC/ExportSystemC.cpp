@@ -18,11 +18,13 @@
 #include "circt/Dialect/SystemC/SystemCDialect.h"
 #include "mlir/Dialect/EmitC/IR/EmitC.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Support/FileUtilities.h"
 #include "mlir/Tools/mlir-translate/Translation.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include <atomic>
 #include <regex>
 
 using namespace circt;
@@ -41,36 +43,75 @@ static std::string pathToMacroName(StringRef path) {
   return std::regex_replace(str, std::regex("[^a-zA-Z0-9_$]+"), "");
 }
 
-/// Emits the given operation to a file represented by the passed ostream and
-/// file-path.
-static LogicalResult emitFile(ArrayRef<Operation *> operations,
-                              StringRef filePath, raw_ostream &os) {
-  mlir::raw_indented_ostream ios(os);
+namespace {
+/// The emission patterns of all supported dialects. They are frozen once per
+/// export and shared by all the files and threads emitting them.
+struct EmissionPatterns {
+  EmissionPatterns(MLIRContext *context) {
+    OpEmissionPatternSet ops;
+    registerAllOpEmitters(ops, context);
+    opPatterns = std::move(ops);
+    TypeEmissionPatternSet types;
+    registerAllTypeEmitters(types);
+    typePatterns = std::move(types);
+    AttrEmissionPatternSet attrs;
+    registerAllAttrEmitters(attrs);
+    attrPatterns = std::move(attrs);
+  }
 
-  ios << "// " << filePath << "\n";
-  std::string macroname = pathToMacroName(filePath);
-  ios << "#ifndef " << macroname << "\n";
-  ios << "#define " << macroname << "\n\n";
+  FrozenOpEmissionPatternSet opPatterns;
+  FrozenTypeEmissionPatternSet typePatterns;
+  FrozenAttrEmissionPatternSet attrPatterns;
+};
+} // namespace
 
-  bool failed = false;
+/// Emits the given operations in sequence to the passed ostream.
+static LogicalResult emitOperations(ArrayRef<Operation *> operations,
+                                    const EmissionPatterns &patterns,
+                                    raw_ostream &os) {
+  if (operations.empty())
+    return success();
+
+  mlir::raw_indented_ostream ios(os);
+  EmissionPrinter printer(ios, patterns.opPatterns, patterns.typePatterns,
+                          patterns.attrPatterns, operations[0]->getLoc());
+  for (auto *op : operations)
+    printer.emitOp(op);
 
-  if (!operations.empty()) {
-    OpEmissionPatternSet opPatterns;
-    registerAllOpEmitters(opPatterns, operations[0]->getContext());
-    TypeEmissionPatternSet typePatterns;
-    registerAllTypeEmitters(typePatterns);
-    AttrEmissionPatternSet attrPatterns;
-    registerAllAttrEmitters(attrPatterns);
-    EmissionPrinter printer(ios, opPatterns, typePatterns, attrPatterns,
-                            operations[0]->getLoc());
+  return printer.exitState();
+}
 
-    for (auto *op : operations)
-      printer.emitOp(op);
+/// Emits the given operation to a file represented by the passed ostream and
+/// file-path. If `parallel` is set, the operations are emitted to separate
+/// buffers in parallel, which are then printed in order.
+static LogicalResult emitFile(ArrayRef<Operation *> operations,
+                              StringRef filePath,
+                              const EmissionPatterns &patterns,
+                              raw_ostream &os, bool parallel = false) {
+  os << "// " << filePath << "\n";
+  std::string macroname = pathToMacroName(filePath);
+  os << "#ifndef " << macroname << "\n";
+  os << "#define " << macroname << "\n\n";
 
-    failed = printer.exitState().failed();
+  bool failed = false;
+  if (parallel && operations.size() > 1) {
+    SmallVector<std::string> buffers(operations.size());
+    std::atomic<bool> anyFailed(false);
+    mlir::parallelFor(operations[0]->getContext(), 0, operations.size(),
+                      [&](size_t i) {
+                        llvm::raw_string_ostream bufferOs(buffers[i]);
+                        if (mlir::failed(emitOperations(operations[i], patterns,
+                                                        bufferOs)))
+                          anyFailed = true;
+                      });
+    for (auto &buffer : buffers)
+      os << buffer;
+    failed = anyFailed;
+  } else {
+    failed = mlir::failed(emitOperations(operations, patterns, os));
   }
 
-  ios << "\n#endif // " << macroname << "\n\n";
+  os << "\n#endif // " << macroname << "\n\n";
 
   return failure(failed);
 }
@@ -81,7 +122,15 @@ static LogicalResult emitFile(ArrayRef<Operation *> operations,
 
 LogicalResult ExportSystemC::exportSystemC(ModuleOp module,
                                            llvm::raw_ostream &os) {
-  return emitFile({module}, "stdout.h", os);
+  EmissionPatterns patterns(module.getContext());
+
+  // Emit the top-level operations rather than the module itself, which just
+  // emits its children in sequence, such that they can be emitted in parallel.
+  SmallVector<Operation *> operations;
+  for (Operation &op : module.getRegion().front())
+    operations.push_back(&op);
+
+  return emitFile(operations, "stdout.h", patterns, os, /*parallel=*/true);
 }
 
 LogicalResult ExportSystemC::exportSplitSystemC(ModuleOp module,
@@ -90,35 +139,42 @@ LogicalResult ExportSystemC::exportSplitSystemC(ModuleOp module,
   SmallVector<Operation *> includes;
   module->walk([&](mlir::emitc::IncludeOp op) { includes.push_back(op); });
 
-  for (Operation &op : module.getRegion().front()) {
-    if (auto symbolOp = dyn_cast<mlir::SymbolOpInterface>(op)) {
-      // Create the output directory if needed.
-      if (std::error_code error = llvm::sys::fs::create_directories(directory))
-        return module.emitError("cannot create output directory \"")
-               << directory << "\": " << error.message();
-
-      // Open or create the output file.
-      std::string fileName = symbolOp.getName().str() + ".h";
-      SmallString<128> filePath(directory);
-      llvm::sys::path::append(filePath, fileName);
-      std::string errorMessage;
-      auto output = mlir::openOutputFile(filePath, &errorMessage);
-      if (!output)
-        return module.emitError(errorMessage);
-
-      // Emit the content to the file.
-      SmallVector<Operation *> opsInThisFile(includes);
-      opsInThisFile.push_back(symbolOp);
-      if (failed(emitFile(opsInThisFile, filePath, output->os())))
-        return symbolOp->emitError("failed to emit to file \"")
-               << filePath << "\"";
-
-      // Do not delete the file if emission was successful.
-      output->keep();
-    }
-  }
-
-  return success();
+  SmallVector<mlir::SymbolOpInterface> symbolOps;
+  for (Operation &op : module.getRegion().front())
+    if (auto symbolOp = dyn_cast<mlir::SymbolOpInterface>(op))
+      symbolOps.push_back(symbolOp);
+  if (symbolOps.empty())
+    return success();
+
+  // Create the output directory if needed.
+  if (std::error_code error = llvm::sys::fs::create_directories(directory))
+    return module.emitError("cannot create output directory \"")
+           << directory << "\": " << error.message();
+
+  // Emit the files in parallel.
+  EmissionPatterns patterns(module.getContext());
+  return mlir::failableParallelForEach(
+      module.getContext(), symbolOps, [&](mlir::SymbolOpInterface symbolOp) {
+        // Open or create the output file.
+        std::string fileName = symbolOp.getName().str() + ".h";
+        SmallString<128> filePath(directory);
+        llvm::sys::path::append(filePath, fileName);
+        std::string errorMessage;
+        auto output = mlir::openOutputFile(filePath, &errorMessage);
+        if (!output)
+          return LogicalResult(symbolOp->emitError(errorMessage));
+
+        // Emit the content to the file.
+        SmallVector<Operation *> opsInThisFile(includes);
+        opsInThisFile.push_back(symbolOp);
+        if (failed(emitFile(opsInThisFile, filePath, patterns, output->os())))
+          return LogicalResult(symbolOp->emitError("failed to emit to file \"")
+                               << filePath << "\"");
+
+        // Do not delete the file if emission was successful.
+        output->keep();
+        return success();
+      });
 }
 
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,270 @@
+//===- ProfileCanonicalizer.cpp - Profile canonicalization patterns -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a canonicalizer which counts the match attempts, the
+// rewrites and the time of every canonicalization pattern, to find the
+// patterns which dominate the canonicalization time.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+#include "circt/Transforms/Passes.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Rewrite/FrozenRewritePatternSet.h"
+#include "mlir/Support/FileUtilities.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+using namespace mlir;
+using namespace circt;
+
+namespace circt {
+class CanonicalizerProfile {
+public:
+  /// The counters of one pattern, shared by all the threads running it.
+  struct Counters {
+    std::string pattern;
+    std::string root;
+    std::atomic<uint64_t> attempts{0};
+    std::atomic<uint64_t> successes{0};
+    std::atomic<uint64_t> nanoseconds{0};
+  };
+
+  explicit CanonicalizerProfile(StringRef reportFile)
+      : reportFile(reportFile.str()) {}
+  ~CanonicalizerProfile() { writeReport(); }
+
+  /// Return the counters of a pattern, keyed by its debug name and root.
+  Counters &getCounters(StringRef pattern, StringRef root) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &counters = patterns[(pattern + "|" + root).str()];
+    if (counters.pattern.empty()) {
+      counters.pattern = pattern.empty() ? "<unnamed>" : pattern.str();
+      counters.root = root.str();
+    }
+    return counters;
+  }
+
+  /// Record a run of the greedy rewrite driver, which took `nanoseconds`
+  /// including the time of the patterns.
+  void addRun(uint64_t nanoseconds, bool converged) {
+    ++runs;
+    if (!converged)
+      ++nonConvergedRuns;
+    driverNanoseconds += nanoseconds;
+  }
+
+private:
+  void writeReport();
+
+  std::string reportFile;
+  std::mutex mutex;
+  llvm::StringMap<Counters> patterns;
+  std::atomic<uint64_t> runs{0};
+  std::atomic<uint64_t> nonConvergedRuns{0};
+  std::atomic<uint64_t> driverNanoseconds{0};
+};
+} // namespace circt
+
+void CanonicalizerProfile::writeReport() {
+  std::unique_ptr<llvm::ToolOutputFile> file;
+  raw_ostream *os = &llvm::errs();
+  if (reportFile != "-") {
+    std::string errorMessage;
+    file = openOutputFile(reportFile, &errorMessage);
+    if (!file) {
+      llvm::errs() << errorMessage << "\n";
+      return;
+    }
+    os = &file->os();
+  }
+
+  SmallVector<Counters *> sorted;
+  uint64_t patternNanoseconds = 0;
+  for (auto &entry : patterns) {
+    sorted.push_back(&entry.getValue());
+    patternNanoseconds += entry.getValue().nanoseconds;
+  }
+  llvm::stable_sort(sorted, [](Counters *lhs, Counters *rhs) {
+    if (lhs->nanoseconds != rhs->nanoseconds)
+      return lhs->nanoseconds > rhs->nanoseconds;
+    return lhs->attempts > rhs->attempts;
+  });
+
+  auto toMilliseconds = [](uint64_t nanoseconds) { return nanoseconds / 1e6; };
+  *os << "===" << std::string(73, '-') << "===\n"
+      << "  Canonicalization pattern profile\n"
+      << "===" << std::string(73, '-') << "===\n"
+      << "  Rewrite runs: " << runs << ", not converged: " << nonConvergedRuns
+      << "\n"
+      << llvm::format("  %12s %12s %12s  %s\n", "Time (ms)", "Attempts",
+                      "Successes", "Pattern (root)");
+  for (auto *counters : sorted)
+    *os << llvm::format("  %12.3f %12llu %12llu  ",
+                        toMilliseconds(counters->nanoseconds),
+                        (unsigned long long)counters->attempts,
+                        (unsigned long long)counters->successes)
+        << counters->pattern << " ("
+        << (counters->root.empty() ? "any" : counters->root) << ")\n";
+
+  // The folders are invoked by the driver itself and cannot be wrapped like
+  // the patterns, so their time is included in the time of the driver.
+  uint64_t otherNanoseconds = driverNanoseconds > patternNanoseconds
+                                  ? driverNanoseconds - patternNanoseconds
+                                  : 0;
+  *os << llvm::format("  %12.3f %12s %12s  ", toMilliseconds(otherNanoseconds),
+                      "-", "-")
+      << "<folders and rewrite driver>\n";
+
+  if (file)
+    file->keep();
+}
+
+std::shared_ptr<CanonicalizerProfile>
+circt::createCanonicalizerProfile(StringRef reportFile) {
+  return std::make_shared<CanonicalizerProfile>(reportFile);
+}
+
+namespace {
+/// A pattern which forwards to a canonicalization pattern, counting its match
+/// attempts, rewrites and time.
+class ProfiledPattern : public RewritePattern {
+public:
+  template <typename... RootArgs>
+  ProfiledPattern(std::unique_ptr<RewritePattern> pattern,
+                  CanonicalizerProfile::Counters &counters,
+                  ArrayRef<StringRef> generatedNames, RootArgs &&...rootArgs)
+      : RewritePattern(std::forward<RootArgs>(rootArgs)...,
+                       pattern->getBenefit(), pattern->getContext(),
+                       generatedNames),
+        pattern(std::move(pattern)), counters(counters) {
+    setDebugName(this->pattern->getDebugName());
+    addDebugLabels(this->pattern->getDebugLabels());
+    setHasBoundedRewriteRecursion(
+        this->pattern->hasBoundedRewriteRecursion());
+  }
+
+  LogicalResult matchAndRewrite(Operation *op,
+                                PatternRewriter &rewriter) const override {
+    auto start = std::chrono::steady_clock::now();
+    auto result = pattern->matchAndRewrite(op, rewriter);
+    auto time = std::chrono::steady_clock::now() - start;
+    counters.nanoseconds +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+    ++counters.attempts;
+    if (succeeded(result))
+      ++counters.successes;
+    return result;
+  }
+
+private:
+  std::unique_ptr<RewritePattern> pattern;
+  CanonicalizerProfile::Counters &counters;
+};
+} // namespace
+
+/// Wrap `pattern` into a pattern which profiles it, with the same root.
+static std::unique_ptr<RewritePattern>
+profilePattern(std::unique_ptr<RewritePattern> pattern,
+               CanonicalizerProfile &profile) {
+  SmallVector<StringRef> generatedNames;
+  for (auto name : pattern->getGeneratedOps())
+    generatedNames.push_back(name.getStringRef());
+
+  auto root = pattern->getRootKind();
+  auto &counters = profile.getCounters(
+      pattern->getDebugName(), root ? root->getStringRef() : StringRef());
+  if (root)
+    return std::make_unique<ProfiledPattern>(std::move(pattern), counters,
+                                             generatedNames,
+                                             root->getStringRef());
+  if (auto interfaceID = pattern->getRootInterfaceID())
+    return std::make_unique<ProfiledPattern>(
+        std::move(pattern), counters, generatedNames,
+        Pattern::MatchInterfaceOpTypeTag(), *interfaceID);
+  if (auto traitID = pattern->getRootTraitID())
+    return std::make_unique<ProfiledPattern>(std::move(pattern), counters,
+                                             generatedNames,
+                                             Pattern::MatchTraitOpTypeTag(),
+                                             *traitID);
+  return std::make_unique<ProfiledPattern>(std::move(pattern), counters,
+                                           generatedNames,
+                                           Pattern::MatchAnyOpTypeTag());
+}
+
+namespace {
+struct ProfileCanonicalizer
+    : public ProfileCanonicalizerBase<ProfileCanonicalizer> {
+  ProfileCanonicalizer() = default;
+  ProfileCanonicalizer(const GreedyRewriteConfig &config,
+                       std::shared_ptr<CanonicalizerProfile> profile)
+      : profile(std::move(profile)) {
+    topDownProcessingEnabled = config.useTopDownTraversal;
+    enableRegionSimplification = config.enableRegionSimplification;
+    maxIterations = config.maxIterations;
+  }
+
+  LogicalResult initialize(MLIRContext *context) override;
+  void runOnOperation() override;
+
+  /// The profile, shared by the clones of this pass and possibly by other
+  /// instances of the pass created by a tool.
+  std::shared_ptr<CanonicalizerProfile> profile;
+  FrozenRewritePatternSet patterns;
+};
+} // namespace
+
+LogicalResult ProfileCanonicalizer::initialize(MLIRContext *context) {
+  if (!profile)
+    profile = createCanonicalizerProfile(reportFile);
+
+  // Collect the same patterns as the canonicalizer.
+  RewritePatternSet owningPatterns(context);
+  for (auto *dialect : context->getLoadedDialects())
+    dialect->getCanonicalizationPatterns(owningPatterns);
+  for (RegisteredOperationName op : context->getRegisteredOperations())
+    op.getCanonicalizationPatterns(owningPatterns, context);
+
+  for (auto &pattern : owningPatterns.getNativePatterns())
+    pattern = profilePattern(std::move(pattern), *profile);
+
+  patterns = FrozenRewritePatternSet(std::move(owningPatterns),
+                                     disabledPatterns, enabledPatterns);
+  return success();
+}
+
+void ProfileCanonicalizer::runOnOperation() {
+  GreedyRewriteConfig config;
+  config.useTopDownTraversal = topDownProcessingEnabled;
+  config.enableRegionSimplification = enableRegionSimplification;
+  config.maxIterations = maxIterations;
+
+  auto start = std::chrono::steady_clock::now();
+  auto converged = applyPatternsAndFoldGreedily(getOperation()->getRegions(),
+                                                patterns, config);
+  auto time = std::chrono::steady_clock::now() - start;
+  profile->addRun(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(time).count(),
+      succeeded(converged));
+}
+
+std::unique_ptr<Pass> circt::createProfileCanonicalizerPass() {
+  return std::make_unique<ProfileCanonicalizer>();
+}
+
+std::unique_ptr<Pass> circt::createProfileCanonicalizerPass(
+    const GreedyRewriteConfig &config,
+    std::shared_ptr<CanonicalizerProfile> profile) {
+  return std::make_unique<ProfileCanonicalizer>(config, std::move(profile));
+}
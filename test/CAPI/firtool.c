@@ -0,0 +1,60 @@
+/*===- firtool.c - Test of the firtool pipeline C API ---------------------===*\
+|*                                                                            *|
+|* Part of the LLVM Project, under the Apache License v2.0 with LLVM          *|
+|* Exceptions.                                                                *|
+|* See https://llvm.org/LICENSE.txt for license information.                  *|
+|* SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception                    *|
+|*                                                                            *|
+\*===----------------------------------------------------------------------===*/
+
+/* RUN: rm -rf %t && circt-capi-firtool-test %t 2>&1 | FileCheck %s
+ * RUN: cat %t/Top.sv | FileCheck %s --check-prefix=VERILOG
+ */
+
+#include "circt-c/Firtool.h"
+#include "mlir-c/IR.h"
+
+#include <stdio.h>
+
+int testCompileToSplitVerilog(const char *directory) {
+  MlirContext ctx = mlirContextCreate();
+  circtFirtoolLoadDialects(ctx);
+
+  const char *input =
+      "firrtl.circuit \"Top\" {\n"
+      "  firrtl.module @Top(in %a: !firrtl.uint<8>,\n"
+      "                     out %b: !firrtl.uint<8>) {\n"
+      "    firrtl.connect %b, %a : !firrtl.uint<8>, !firrtl.uint<8>\n"
+      "  }\n"
+      "}\n";
+  MlirModule module =
+      mlirModuleCreateParse(ctx, mlirStringRefCreateFromCString(input));
+  if (mlirModuleIsNull(module))
+    return 1;
+
+  CirctFirtoolOptions options = circtFirtoolOptionsGetDefault();
+  options.emitOMIR = false;
+  MlirLogicalResult result = circtFirtoolCompileToSplitVerilog(
+      module, &options, mlirStringRefCreateFromCString("Top.fir"),
+      mlirStringRefCreateFromCString(directory));
+  if (mlirLogicalResultIsFailure(result))
+    return 2;
+
+  mlirModuleDestroy(module);
+  mlirContextDestroy(ctx);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2)
+    return 1;
+
+  // CHECK-LABEL: @compile
+  // CHECK: 0
+  fprintf(stderr, "@compile\n");
+  fprintf(stderr, "%d\n", testCompileToSplitVerilog(argv[1]));
+
+  // VERILOG-LABEL: module Top(
+  // VERILOG:         assign b = a;
+  return 0;
+}
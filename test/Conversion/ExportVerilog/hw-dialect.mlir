@@ -1304,3 +1304,24 @@ hw.module @UniformArrayCreate() -> (arr: !hw.array<5xi8>) {
   // CHECK: assign arr = {5{8'h0}};
   hw.output %arr : !hw.array<5xi8>
 }
+
+// CHECK-LABEL: module ArrayConstant
+hw.module @ArrayConstant() -> (rom: !hw.array<4xi12>, zeros: !hw.array<3xi4>) {
+  %rom = hw.array_constant dense<[1, 2, 3, -1]> : tensor<4xi12> : !hw.array<4xi12>
+  %zeros = hw.array_constant dense<0> : tensor<3xi4> : !hw.array<3xi4>
+  // CHECK:      assign rom = {12'hFFF, 12'h3, 12'h2, 12'h1};
+  // CHECK-NEXT: assign zeros = {3{4'h0}};
+  hw.output %rom, %zeros : !hw.array<4xi12>, !hw.array<3xi4>
+}
+
+// Large tables are emitted in groups of elements, one group per line.
+// CHECK-LABEL: module ArrayConstantTable
+hw.module @ArrayConstantTable() -> (lut: !hw.array<20xi8>) {
+  %lut = hw.array_constant dense<[0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19]> : tensor<20xi8> : !hw.array<20xi8>
+  // CHECK:      assign lut = {
+  // CHECK-NEXT:   8'h13, 8'h12, 8'h11, 8'h10, 8'hF, 8'hE, 8'hD, 8'hC,
+  // CHECK-NEXT:   8'hB, 8'hA, 8'h9, 8'h8, 8'h7, 8'h6, 8'h5, 8'h4,
+  // CHECK-NEXT:   8'h3, 8'h2, 8'h1, 8'h0
+  // CHECK-NEXT: };
+  hw.output %lut : !hw.array<20xi8>
+}
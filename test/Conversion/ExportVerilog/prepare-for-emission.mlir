@@ -177,3 +177,27 @@ module attributes {circt.loweringOptions =
     hw.output %2 : i8
   }
 }
+
+// -----
+module attributes {circt.loweringOptions =
+                  "wireSpillingHeuristic=spillLargeDuplicatedExpressions"} {
+  // CHECK-LABEL: duplicates
+  hw.module @duplicates(%a: i128, %b: i8) -> (x: i128, y: i128, z: i8, w: i8) {
+    // Identical wide constants are merged and spilled to a wire.
+    // CHECK:      %[[CST:.+]] = hw.constant 12345678901234567890123 : i128
+    // CHECK-NEXT: %[[WIRE:.+]] = sv.wire
+    // CHECK-NEXT: sv.assign %[[WIRE]], %[[CST]] : i128
+    // CHECK-NOT:  hw.constant 12345678901234567890123 : i128
+    %0 = hw.constant 12345678901234567890123 : i128
+    %1 = hw.constant 12345678901234567890123 : i128
+    %2 = comb.xor %a, %0 : i128
+    %3 = comb.and %a, %1 : i128
+    // Narrow constants are still printed at each use.
+    // CHECK: %c5_i8 = hw.constant 5 : i8
+    // CHECK-NOT: sv.assign %{{.+}}, %c5_i8
+    %c5_i8 = hw.constant 5 : i8
+    %4 = comb.add %b, %c5_i8 : i8
+    %5 = comb.sub %b, %c5_i8 : i8
+    hw.output %2, %3, %4, %5 : i128, i128, i8, i8
+  }
+}
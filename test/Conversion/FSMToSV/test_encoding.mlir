@@ -0,0 +1,92 @@
+// RUN: circt-opt -split-input-file -convert-fsm-to-sv='state-encoding=binary' %s | FileCheck %s --check-prefix=BINARY
+// RUN: circt-opt -split-input-file -convert-fsm-to-sv='state-encoding=one-hot' %s | FileCheck %s --check-prefix=ONEHOT
+
+// BINARY-NOT:   hw.type_scope
+// BINARY-LABEL: hw.module @top(
+// BINARY:         %c0_i2 = hw.constant 0 : i2
+// BINARY-NEXT:    %to_A = sv.reg sym @A  : !hw.inout<i2>
+// BINARY:         %c1_i2 = hw.constant 1 : i2
+// BINARY-NEXT:    %to_B = sv.reg sym @B  : !hw.inout<i2>
+// BINARY:         %c-2_i2 = hw.constant -2 : i2
+// BINARY-NEXT:    %to_C = sv.reg sym @C  : !hw.inout<i2>
+// BINARY:         %state_reg = seq.compreg
+// BINARY:         sv.case %state_reg : i2
+// BINARY-NEXT:    case b00: {
+// BINARY:         case b01: {
+// BINARY:         case b10: {
+
+// ONEHOT-NOT:   hw.type_scope
+// ONEHOT-LABEL: hw.module @top(
+// ONEHOT:         %c1_i3 = hw.constant 1 : i3
+// ONEHOT-NEXT:    %to_A = sv.reg sym @A  : !hw.inout<i3>
+// ONEHOT:         %c2_i3 = hw.constant 2 : i3
+// ONEHOT-NEXT:    %to_B = sv.reg sym @B  : !hw.inout<i3>
+// ONEHOT:         %c-4_i3 = hw.constant -4 : i3
+// ONEHOT-NEXT:    %to_C = sv.reg sym @C  : !hw.inout<i3>
+// ONEHOT:         sv.case casez %state_reg : i3
+// ONEHOT-NEXT:    case bzz1: {
+// ONEHOT:         case bz1z: {
+// ONEHOT:         case b1zz: {
+
+fsm.machine @top(%a0: i1) -> (i8) attributes {initialState = "A"} {
+  %c_0 = hw.constant 0 : i8
+  %c_1 = hw.constant 1 : i8
+  fsm.state @A output  {
+    fsm.output %c_0 : i8
+  } transitions {
+    fsm.transition @B guard {
+      fsm.return %a0
+    }
+  }
+
+  fsm.state @B output  {
+    fsm.output %c_1 : i8
+  } transitions {
+    fsm.transition @C
+  }
+
+  fsm.state @C output  {
+    fsm.output %c_1 : i8
+  } transitions {
+    fsm.transition @A
+  }
+}
+
+// -----
+
+// Without guarded transitions, binary-encoded machines look up their next
+// state in a table indexed by the state register.
+
+// BINARY-LABEL: hw.module @counter(
+// BINARY:         %[[A:.+]] = sv.read_inout %to_A : !hw.inout<i2>
+// BINARY:         %[[B:.+]] = sv.read_inout %to_B : !hw.inout<i2>
+// BINARY:         %[[C:.+]] = sv.read_inout %to_C : !hw.inout<i2>
+// BINARY:         %state_reg = seq.compreg
+// BINARY:         %[[TABLE:.+]] = hw.array_create %[[A]], %[[A]], %[[C]], %[[B]] : i2
+// BINARY-NEXT:    %[[NEXT:.+]] = hw.array_get %[[TABLE]][%state_reg] : !hw.array<4xi2>
+// BINARY-NEXT:    sv.alwayscomb {
+// BINARY-NEXT:      sv.bpassign %state_next, %[[NEXT]] : i2
+// BINARY-NEXT:      sv.case %state_reg : i2
+// BINARY-NOT:       sv.bpassign %state_next
+
+fsm.machine @counter() -> (i8) attributes {initialState = "A"} {
+  %c_0 = hw.constant 0 : i8
+  %c_1 = hw.constant 1 : i8
+  fsm.state @A output  {
+    fsm.output %c_0 : i8
+  } transitions {
+    fsm.transition @B
+  }
+
+  fsm.state @B output  {
+    fsm.output %c_1 : i8
+  } transitions {
+    fsm.transition @C
+  }
+
+  fsm.state @C output  {
+    fsm.output %c_1 : i8
+  } transitions {
+    fsm.transition @A
+  }
+}
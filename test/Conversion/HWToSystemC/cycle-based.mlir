@@ -0,0 +1,58 @@
+// RUN: circt-opt --convert-hw-to-systemc=cycle-based --verify-diagnostics --split-input-file %s | FileCheck %s
+
+// CHECK-LABEL: systemc.module @counter
+// CHECK-SAME:    (%clk: !systemc.in<i1>, %rst: !systemc.in<i1>, %count: !systemc.out<!systemc.uint<8>>)
+// CHECK-NEXT:    %count_0 = systemc.cpp.variable : !systemc.uint<8>
+// CHECK-NEXT:    %eval = systemc.func  {
+// CHECK:           systemc.signal.read %clk
+// CHECK:           systemc.signal.read %rst
+// CHECK:           [[CUR:%.+]] = systemc.convert %count_0 : (!systemc.uint<8>) -> i8
+// CHECK:           [[ADD:%.+]] = comb.add [[CUR]], %c1_i8 : i8
+// CHECK:           [[OUT:%.+]] = systemc.convert [[CUR]] : (i8) -> !systemc.uint<8>
+// CHECK-NEXT:      systemc.signal.write %count, [[OUT]]
+// CHECK-NEXT:      [[MUX:%.+]] = comb.mux %{{.+}}, %c0_i8, [[ADD]] : i8
+// CHECK-NEXT:      [[NEXT:%.+]] = systemc.convert [[MUX]] : (i8) -> !systemc.uint<8>
+// CHECK-NEXT:      %count_next = systemc.cpp.variable [[NEXT]] : !systemc.uint<8>
+// CHECK-NEXT:      systemc.cpp.assign %count_0 = %count_next : !systemc.uint<8>
+// CHECK-NEXT:    }
+// CHECK-NOT:     systemc.ctor
+// CHECK-NEXT:  }
+hw.module @counter(%clk: i1, %rst: i1) -> (count: i8) {
+  %c0_i8 = hw.constant 0 : i8
+  %c1_i8 = hw.constant 1 : i8
+  %0 = comb.add %count, %c1_i8 : i8
+  %count = seq.compreg %0, %clk, %rst, %c0_i8 : i8
+  hw.output %count : i8
+}
+
+// -----
+
+// Both registers are updated with the values they had before the edge.
+
+// CHECK-LABEL: systemc.module @swap
+// CHECK:         %a_next = systemc.cpp.variable %{{.+}} : !systemc.uint<4>
+// CHECK-NEXT:    %b_next = systemc.cpp.variable %{{.+}} : !systemc.uint<4>
+// CHECK-NEXT:    systemc.cpp.assign %a = %a_next : !systemc.uint<4>
+// CHECK-NEXT:    systemc.cpp.assign %b = %b_next : !systemc.uint<4>
+hw.module @swap(%clk: i1) -> () {
+  %a = seq.compreg %b, %clk : i4
+  %b = seq.compreg %a, %clk : i4
+}
+
+// -----
+
+// expected-error @+1 {{failed to legalize operation 'hw.module'}}
+hw.module @twoClocks(%clk0: i1, %clk1: i1, %in: i4) -> () {
+  %a = seq.compreg %in, %clk0 : i4
+  // expected-error @+1 {{cycle-based models support only a single clock}}
+  %b = seq.compreg %in, %clk1 : i4
+}
+
+// -----
+
+// expected-error @+2 {{combinational cycles not supported in cycle-based models}}
+// expected-error @+1 {{failed to legalize operation 'hw.module'}}
+hw.module @combLoop(%in: i4) -> () {
+  %0 = comb.add %in, %1 : i4
+  %1 = comb.add %in, %0 : i4
+}
@@ -0,0 +1,30 @@
+// RUN: circt-opt %s --convert-llhd-to-llvm=batch-drives | FileCheck %s
+
+// CHECK-NOT:     llvm.func @driveSignal(
+// CHECK-LABEL:   llvm.func @driveSignals(!llvm.ptr<i8>, !llvm.ptr<struct<(ptr<struct<(ptr<i8>, i64, i64, i64)>>, ptr<i8>, i64, i64, i64, i64)>>, i64)
+
+// Both drives are recorded in a buffer with room for two drives, which is
+// passed to the runtime before returning.
+// CHECK-LABEL:   llvm.func @Foo(
+// CHECK-SAME:                   %[[STATE:.*]]: !llvm.ptr<i8>,
+// CHECK:           %[[BUF:.*]] = llvm.alloca %{{.*}} x !llvm.array<2 x struct<(ptr<struct<(ptr<i8>, i64, i64, i64)>>, ptr<i8>, i64, i64, i64, i64)>>
+// CHECK:           %[[START:.*]] = llvm.bitcast %[[BUF]]
+// CHECK:           %[[COUNT:.*]] = llvm.alloca %{{.*}} x i64
+// CHECK-NOT:       llvm.call
+// CHECK:           llvm.load %[[COUNT]] : !llvm.ptr<i64>
+// CHECK:           llvm.store %{{.*}}, %{{.*}} : !llvm.ptr<struct<(ptr<struct<(ptr<i8>, i64, i64, i64)>>, ptr<i8>, i64, i64, i64, i64)>>
+// CHECK-NOT:       llvm.call
+// CHECK:           llvm.load %[[COUNT]] : !llvm.ptr<i64>
+// CHECK:           llvm.store %{{.*}}, %{{.*}} : !llvm.ptr<struct<(ptr<struct<(ptr<i8>, i64, i64, i64)>>, ptr<i8>, i64, i64, i64, i64)>>
+// CHECK:           %[[N:.*]] = llvm.load %[[COUNT]] : !llvm.ptr<i64>
+// CHECK-NEXT:      llvm.call @driveSignals(%[[STATE]], %[[START]], %[[N]])
+// CHECK-NEXT:      llvm.return
+llhd.entity @Foo () -> () {
+  %0 = hw.constant 0 : i1
+  %a = llhd.sig "a" %0 : i1
+  %b = llhd.sig "b" %0 : i1
+  %1 = llhd.prb %a : !llhd.sig<i1>
+  %dt = llhd.constant_time #llhd.time<1ns, 0d, 0e>
+  llhd.drv %a, %1 after %dt : !llhd.sig<i1>
+  llhd.drv %b, %1 after %dt : !llhd.sig<i1>
+}
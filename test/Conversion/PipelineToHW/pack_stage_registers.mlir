@@ -0,0 +1,31 @@
+// RUN: circt-opt --lower-pipeline-to-hw='pack-stage-registers' %s | FileCheck %s
+
+// CHECK-LABEL:  hw.module @test0(%arg0: i32, %arg1: i32, %go: i1, %clk: i1, %rst: i1) -> (out: i32) {
+// CHECK-NEXT:    %[[ADD0:.*]] = comb.add %arg0, %arg1 : i32
+// CHECK-NEXT:    %s0_valid = seq.compreg %go, %clk : i1
+// CHECK-NEXT:    %[[S0_IN:.*]] = comb.concat %[[ADD0]], %arg0 : i32, i32
+// CHECK-NEXT:    %s0_regs = seq.compreg %[[S0_IN]], %clk : i64
+// CHECK-NEXT:    %[[S0_REG0:.*]] = comb.extract %s0_regs from 32 : (i64) -> i32
+// CHECK-NEXT:    %[[S0_REG1:.*]] = comb.extract %s0_regs from 0 : (i64) -> i32
+// CHECK-NEXT:    %[[ADD1:.*]] = comb.add %[[S0_REG0]], %[[S0_REG1]] : i32
+// CHECK-NEXT:    %s1_valid = seq.compreg %s0_valid, %clk : i1
+// CHECK-NEXT:    %[[S1_IN:.*]] = comb.concat %[[ADD1]], %[[S0_REG0]] : i32, i32
+// CHECK-NEXT:    %s1_regs = seq.compreg %[[S1_IN]], %clk : i64
+// CHECK-NEXT:    %[[S1_REG0:.*]] = comb.extract %s1_regs from 32 : (i64) -> i32
+// CHECK-NEXT:    %[[S1_REG1:.*]] = comb.extract %s1_regs from 0 : (i64) -> i32
+// CHECK-NEXT:    %[[ADD2:.*]] = comb.add %[[S1_REG0]], %[[S1_REG1]] : i32
+// CHECK-NEXT:    hw.output %[[ADD2]] : i32
+// CHECK-NEXT:  }
+
+hw.module @test0(%arg0: i32, %arg1: i32, %go: i1, %clk: i1, %rst: i1) -> (out: i32) {
+  %0 = pipeline.pipeline(%arg0, %arg1, %go) clock %clk reset %rst : (i32, i32, i1) -> i32 {
+  ^bb0(%arg0_0: i32, %arg1_1: i32, %arg2: i1):
+    %1 = comb.add %arg0_0, %arg1_1 : i32
+    %regOuts:2, %valid = pipeline.stage.register when %arg2 regs %1, %arg0_0 : i32, i32
+    %2 = comb.add %regOuts#0, %regOuts#1 : i32
+    %regOuts_2:2, %valid_3 = pipeline.stage.register when %valid regs %2, %regOuts#0 : i32, i32
+    %3 = comb.add %regOuts_2#0, %regOuts_2#1 : i32
+    pipeline.return %3 valid %valid_3 : i32
+  }
+  hw.output %0 : i32
+}
@@ -0,0 +1,52 @@
+// RUN: circt-opt %s --lower-scf-to-calyx='share-functional-units' -canonicalize -split-input-file | FileCheck %s
+
+// Test that both multiplications use the same pipelined unit, and that the
+// second one reads the first result from its register.
+
+// CHECK-LABEL:  calyx.component @main
+// CHECK:          calyx.std_mult_pipe @std_mult_pipe_0 : i1, i1, i1, i32, i32, i32, i1
+// CHECK-NOT:      calyx.std_mult_pipe
+// CHECK:          calyx.group @bb0_0  {
+// CHECK-DAG:        calyx.assign %std_mult_pipe_0.left = %in0 : i32
+// CHECK-DAG:        calyx.assign %std_mult_pipe_0.right = %in1 : i32
+// CHECK-DAG:        calyx.assign %muli_0_reg.in = %std_mult_pipe_0.out : i32
+// CHECK-DAG:        calyx.assign %muli_0_reg.write_en = %std_mult_pipe_0.done : i1
+// CHECK-DAG:        calyx.assign %std_mult_pipe_0.go = %true : i1
+// CHECK-DAG:        calyx.group_done %muli_0_reg.done : i1
+// CHECK:          }
+// CHECK:          calyx.group @bb0_1  {
+// CHECK-DAG:        calyx.assign %std_mult_pipe_0.left = %muli_0_reg.out : i32
+// CHECK-DAG:        calyx.assign %std_mult_pipe_0.right = %in1 : i32
+// CHECK-DAG:        calyx.assign %muli_1_reg.in = %std_mult_pipe_0.out : i32
+// CHECK-DAG:        calyx.assign %muli_1_reg.write_en = %std_mult_pipe_0.done : i1
+// CHECK-DAG:        calyx.assign %std_mult_pipe_0.go = %true : i1
+// CHECK-DAG:        calyx.group_done %muli_1_reg.done : i1
+// CHECK:          }
+// CHECK:          calyx.control  {
+// CHECK-NEXT:       calyx.seq  {
+// CHECK-NEXT:         calyx.enable @bb0_0
+// CHECK-NEXT:         calyx.enable @bb0_1
+module {
+  func.func @main(%a0 : i32, %a1 : i32) -> i32 {
+    %0 = arith.muli %a0, %a1 : i32
+    %1 = arith.muli %0, %a1 : i32
+    return %1 : i32
+  }
+}
+
+// -----
+
+// Test that units are only shared between operations of the same width.
+
+// CHECK-LABEL:  calyx.component @main
+// CHECK-DAG:      calyx.std_divu_pipe @std_divu_pipe_0 : i1, i1, i1, i32, i32, i32, i1
+// CHECK-DAG:      calyx.std_divu_pipe @std_divu_pipe_1 : i1, i1, i1, i8, i8, i8, i1
+// CHECK-NOT:      calyx.std_divu_pipe
+module {
+  func.func @main(%a0 : i32, %a1 : i32, %a2 : i8, %a3 : i8) -> (i32, i8) {
+    %0 = arith.divui %a0, %a1 : i32
+    %1 = arith.divui %0, %a1 : i32
+    %2 = arith.divui %a2, %a3 : i8
+    return %1, %2 : i32, i8
+  }
+}
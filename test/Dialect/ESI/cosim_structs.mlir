@@ -1,5 +1,6 @@
 // REQUIRES: capnp
 // RUN: circt-translate %s -export-esi-capnp -verify-diagnostics | FileCheck --check-prefix=CAPNP %s
+// RUN: circt-translate %s -export-esi-cosim-cpp -verify-diagnostics | FileCheck --check-prefix=CPP %s
 // RUN: circt-opt %s --lower-esi-ports --lower-esi-to-hw -verify-diagnostics | circt-opt -verify-diagnostics | FileCheck --check-prefix=COSIM %s
 
 !DataPkt = !hw.struct<encrypted: i1, compressionLevel: ui4, blob: !hw.array<32 x i8>>
@@ -17,6 +18,27 @@ hw.module @top(%clk:i1, %rst:i1) -> () {
 // CAPNP-NEXT:   compressionLevel @1 :UInt8;
 // CAPNP-NEXT:   blob             @2 :List(UInt8);
 
+// CPP-LABEL: struct I1 {
+// CPP-NEXT:    bool i;
+// CPP-LABEL: struct Struct{{.+}} {
+// CPP-NEXT:    bool encrypted;
+// CPP-NEXT:    uint8_t compressionLevel;
+// CPP-NEXT:    std::array<uint8_t, 32> blob;
+// CPP:         static constexpr size_t numWords = 7;
+// CPP:         void pack(uint64_t *words) const {
+// CPP:           words[0] = 0x0001000100000000ULL;
+// CPP-NEXT:      words[1] |= uint64_t(encrypted) << 0;
+// CPP-NEXT:      words[1] |= uint64_t(uint8_t(compressionLevel)) << 8;
+// CPP-NEXT:      words[2] = 0x0000010200000001ULL;
+// CPP-NEXT:      for (size_t i = 0; i < 32; ++i)
+// CPP-NEXT:        words[3 + i / 8] |= uint64_t(uint8_t(blob[i])) << (i % 8 * 8);
+// CPP:         bool unpack(const uint64_t *words, size_t size) {
+// CPP-NEXT:      const uint64_t *data = getRootStruct(words, size, 1, 1);
+// CPP:           encrypted = ((data[0] >> 0) & 1) != 0;
+// CPP-NEXT:      compressionLevel = uint8_t(data[0] >> 8);
+// CPP:             if (!getList(words, size, data + 1, 2, 8, 32, list, length))
+// CPP:               blob[i] = uint8_t(list[i / 8] >> (i % 8 * 8));
+
 // COSIM: hw.instance "encodeStruct{{.+}}Inst" @encodeStruct{{.+}}(clk: %clk: i1, valid: %[[#]]: i1, unencodedInput: %[[#]]: !hw.struct<encrypted: i1, compressionLevel: ui4, blob: !hw.array<32xi8>>) -> (encoded: !hw.array<448xi1>)
 // COSIM: hw.instance "Compressor" @Cosim_Endpoint<ENDPOINT_ID_EXT: none = "", SEND_TYPE_ID: ui64 = 11116741711825659895, SEND_TYPE_SIZE_BITS: i32 = 448, RECV_TYPE_ID: ui64 = 17519082812652290511, RECV_TYPE_SIZE_BITS: i32 = 128>(clk: %clk: i1, rst: %rst: i1, {{.+}}, {{.+}}, {{.+}}) -> ({{.+}})
 // COSIM: hw.module @encode{{.+}}(%clk: i1, %valid: i1, %unencodedInput: !hw.struct<encrypted: i1, compressionLevel: ui4, blob: !hw.array<32xi8>>) -> (encoded: !hw.array<448xi1>)
@@ -586,6 +586,43 @@ firrtl.circuit "NoDedup" {
   }
 }
 
+// Parents of duplicate modules are duplicates, but parents of modules marked
+// NoDedup are not.
+// CHECK-LABEL: firrtl.circuit "NoDedupParents"
+firrtl.circuit "NoDedupParents" {
+  firrtl.module @Leaf0() { }
+  firrtl.module @Leaf1() { }
+  firrtl.module @Keep0() attributes {annotations = [{class = "firrtl.transforms.NoDedupAnnotation"}]} { }
+  firrtl.module @Keep1() attributes {annotations = [{class = "firrtl.transforms.NoDedupAnnotation"}]} { }
+  // CHECK: firrtl.module @Parent0
+  firrtl.module @Parent0() {
+    firrtl.instance leaf @Leaf0()
+  }
+  // CHECK-NOT: firrtl.module @Parent1
+  firrtl.module @Parent1() {
+    firrtl.instance leaf @Leaf1()
+  }
+  // CHECK: firrtl.module @KeepParent0
+  firrtl.module @KeepParent0() {
+    firrtl.instance keep @Keep0()
+  }
+  // CHECK: firrtl.module @KeepParent1
+  firrtl.module @KeepParent1() {
+    firrtl.instance keep @Keep1()
+  }
+  // CHECK: firrtl.module @NoDedupParents
+  firrtl.module @NoDedupParents() {
+    // CHECK-NEXT: firrtl.instance parent0 @Parent0()
+    // CHECK-NEXT: firrtl.instance parent1 @Parent0()
+    // CHECK-NEXT: firrtl.instance keep0 @KeepParent0()
+    // CHECK-NEXT: firrtl.instance keep1 @KeepParent1()
+    firrtl.instance parent0 @Parent0()
+    firrtl.instance parent1 @Parent1()
+    firrtl.instance keep0 @KeepParent0()
+    firrtl.instance keep1 @KeepParent1()
+  }
+}
+
 // Check that modules marked MustDedup have been deduped.
 // CHECK-LABEL: firrtl.circuit "MustDedup"
 firrtl.circuit "MustDedup" attributes {annotations = [{
@@ -0,0 +1,19 @@
+// RUN: circt-opt --pass-pipeline='builtin.module(firrtl.circuit(firrtl.module(firrtl-expand-whens{merge-connections=true})))' %s | FileCheck %s
+
+firrtl.circuit "Merge" {
+  // The fields of %b are all driven by the matching fields of %a once the
+  // last connects are resolved, so they are merged into a single connect.
+  // CHECK-LABEL: firrtl.module @Merge(
+  // CHECK-NEXT:    firrtl.strictconnect %b, %a
+  // CHECK-NEXT:  }
+  firrtl.module @Merge(in %a: !firrtl.bundle<x: uint<1>, y: uint<1>>, out %b: !firrtl.bundle<x: uint<1>, y: uint<1>>) {
+    %0 = firrtl.subfield %a(0) : (!firrtl.bundle<x: uint<1>, y: uint<1>>) -> !firrtl.uint<1>
+    %1 = firrtl.subfield %b(0) : (!firrtl.bundle<x: uint<1>, y: uint<1>>) -> !firrtl.uint<1>
+    %2 = firrtl.subfield %a(1) : (!firrtl.bundle<x: uint<1>, y: uint<1>>) -> !firrtl.uint<1>
+    %3 = firrtl.subfield %b(1) : (!firrtl.bundle<x: uint<1>, y: uint<1>>) -> !firrtl.uint<1>
+    %c0_ui1 = firrtl.constant 0 : !firrtl.uint<1>
+    firrtl.strictconnect %1, %c0_ui1 : !firrtl.uint<1>
+    firrtl.strictconnect %1, %0 : !firrtl.uint<1>
+    firrtl.strictconnect %3, %2 : !firrtl.uint<1>
+  }
+}
@@ -0,0 +1,41 @@
+// RUN: circt-opt --firrtl-extract-instances='batched=true' %s | FileCheck %s
+
+// Instances which are extracted from the same module are moved up together,
+// with all of their ports added to the parent module and its instances at
+// once.
+
+// CHECK: firrtl.circuit "ExtractBatched"
+firrtl.circuit "ExtractBatched" {
+  firrtl.extmodule private @BlackBoxA(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>) attributes {annotations = [{class = "sifive.enterprise.firrtl.ExtractBlackBoxAnnotation", filename = "BlackBoxes.txt", prefix = "a"}], defname = "BlackBoxA"}
+  firrtl.extmodule private @BlackBoxB(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>) attributes {annotations = [{class = "sifive.enterprise.firrtl.ExtractBlackBoxAnnotation", filename = "BlackBoxes.txt", prefix = "b"}], defname = "BlackBoxB"}
+  // CHECK-LABEL: firrtl.module private @BBWrapper
+  // CHECK-DAG: out %a_0_in: !firrtl.uint<8>
+  // CHECK-DAG: in %a_0_out: !firrtl.uint<8>
+  // CHECK-DAG: out %b_0_in: !firrtl.uint<8>
+  // CHECK-DAG: in %b_0_out: !firrtl.uint<8>
+  firrtl.module private @BBWrapper(in %in: !firrtl.uint<8>, out %out: !firrtl.uint<8>) {
+    // CHECK-NOT: firrtl.instance
+    %a_in, %a_out = firrtl.instance a @BlackBoxA(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>)
+    %b_in, %b_out = firrtl.instance b @BlackBoxB(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>)
+    firrtl.strictconnect %a_in, %in : !firrtl.uint<8>
+    firrtl.strictconnect %b_in, %a_out : !firrtl.uint<8>
+    firrtl.strictconnect %out, %b_out : !firrtl.uint<8>
+  }
+  // CHECK-LABEL: firrtl.module private @DUTModule
+  firrtl.module private @DUTModule(in %in: !firrtl.uint<8>, out %out: !firrtl.uint<8>) attributes {annotations = [{class = "sifive.enterprise.firrtl.MarkDUTAnnotation"}]} {
+    // CHECK-COUNT-1: firrtl.instance mod sym {{@.+}} @BBWrapper
+    // CHECK-NOT: firrtl.instance
+    %mod_in, %mod_out = firrtl.instance mod @BBWrapper(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>)
+    firrtl.strictconnect %mod_in, %in : !firrtl.uint<8>
+    firrtl.strictconnect %out, %mod_out : !firrtl.uint<8>
+  }
+  // CHECK-LABEL: firrtl.module @ExtractBatched
+  firrtl.module @ExtractBatched(in %in: !firrtl.uint<8>, out %out: !firrtl.uint<8>) {
+    // CHECK-COUNT-1: firrtl.instance dut sym {{@.+}} @DUTModule
+    // CHECK-DAG: firrtl.instance a sym {{@.+}} @BlackBoxA
+    // CHECK-DAG: firrtl.instance b sym {{@.+}} @BlackBoxB
+    %dut_in, %dut_out = firrtl.instance dut @DUTModule(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>)
+    firrtl.strictconnect %dut_in, %in : !firrtl.uint<8>
+    firrtl.strictconnect %out, %dut_out : !firrtl.uint<8>
+  }
+}
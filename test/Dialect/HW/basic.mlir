@@ -139,6 +139,13 @@ hw.module @signed_arrays(%arg0: si8) -> (out: !hw.array<2xsi8>) {
   hw.output %result : !hw.array<2xsi8>
 }
 
+// CHECK-LABEL: hw.module @array_constant
+hw.module @array_constant() -> (out: !hw.array<4xi12>) {
+  // CHECK-NEXT: %0 = hw.array_constant dense<[1, 2, 3, -1]> : tensor<4xi12> : !hw.array<4xi12>
+  %0 = hw.array_constant dense<[1, 2, 3, -1]> : tensor<4xi12> : !hw.array<4xi12>
+  hw.output %0 : !hw.array<4xi12>
+}
+
 /// Port names that aren't valid MLIR identifiers are handled with `argNames`
 /// attribute being explicitly printed.
 // https://github.com/llvm/circt/issues/1822
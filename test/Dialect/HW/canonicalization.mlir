@@ -594,6 +594,30 @@ hw.module @concat_fold8(%arg0: i5, %arg1: i3) -> (r0: i28, r1: i28, r2: i13) {
   hw.output %1, %2, %3 : i28, i28, i13
 }
 
+// Bit-blasted concats are normalized in a single rewrite.
+// CHECK-LABEL: hw.module @concat_fold9
+hw.module @concat_fold9(%arg0: i8, %arg1: i2) -> (result: i16) {
+  // CHECK-DAG: [[CST:%.+]] = hw.constant 5 : i3
+  // CHECK-DAG: [[EXT:%.+]] = comb.extract %arg0 from 1 : (i8) -> i7
+  // CHECK-DAG: [[REPL:%.+]] = comb.replicate %arg1 : (i2) -> i6
+  // CHECK: [[RES:%.+]] = comb.concat [[CST]], [[EXT]], [[REPL]] : i3, i7, i6
+  // CHECK-NEXT: hw.output [[RES]] : i16
+  %true = hw.constant true
+  %false = hw.constant false
+  %0 = comb.extract %arg0 from 7 : (i8) -> i1
+  %1 = comb.extract %arg0 from 6 : (i8) -> i1
+  %2 = comb.extract %arg0 from 5 : (i8) -> i1
+  %3 = comb.extract %arg0 from 4 : (i8) -> i1
+  %4 = comb.extract %arg0 from 3 : (i8) -> i1
+  %5 = comb.extract %arg0 from 2 : (i8) -> i1
+  %6 = comb.extract %arg0 from 1 : (i8) -> i1
+  %7 = comb.concat %true, %false : i1, i1
+  %8 = comb.concat %7, %true, %0, %1, %2 : i2, i1, i1, i1, i1
+  %9 = comb.concat %3, %4, %5, %6, %arg1 : i1, i1, i1, i1, i2
+  %10 = comb.concat %8, %9, %arg1, %arg1 : i6, i6, i2, i2
+  hw.output %10 : i16
+}
+
 
 // CHECK-LABEL: hw.module @mux_fold0(%arg0: i3, %arg1: i3)
 // CHECK-NEXT:    hw.output %arg0 : i3
@@ -1063,6 +1087,16 @@ hw.module @array_get1(%a0: i3, %a1: i3, %a2: i3) -> (r0: i3) {
   hw.output %r0 : i3
 }
 
+// CHECK-LABEL: hw.module @array_get_constant() -> (r0: i8)
+// CHECK-NEXT:    %c7_i8 = hw.constant 7 : i8
+// CHECK-NEXT:    hw.output %c7_i8 : i8
+hw.module @array_get_constant() -> (r0: i8) {
+  %c2 = hw.constant 2 : i2
+  %arr = hw.array_constant dense<[5, 6, 7]> : tensor<3xi8> : !hw.array<3xi8>
+  %r0 = hw.array_get %arr[%c2] : !hw.array<3xi8>, i2
+  hw.output %r0 : i8
+}
+
 // CHECK-LABEL: hw.module @struct_extract1(%a0: i3, %a1: i5) -> (r0: i3)
 // CHECK-NEXT:    hw.output %a0 : i3
 hw.module @struct_extract1(%a0: i3, %a1: i5) -> (r0: i3) {
@@ -369,3 +369,17 @@ hw.module @foo() {
   %0 = hw.enum.constant D : !hw.enum<A, B, C>
   hw.output
 }
+
+// -----
+
+hw.module @foo() {
+  // expected-error @+1 {{'hw.array_constant' op value has 2 elements, but the array has 3}}
+  %0 = hw.array_constant dense<[1, 2]> : tensor<2xi8> : !hw.array<3xi8>
+}
+
+// -----
+
+hw.module @foo() {
+  // expected-error @+1 {{'hw.array_constant' op value element type 'i4' does not match array element type 'i8'}}
+  %0 = hw.array_constant dense<[1, 2]> : tensor<2xi4> : !hw.array<2xi8>
+}
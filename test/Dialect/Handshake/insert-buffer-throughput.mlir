@@ -0,0 +1,27 @@
+// RUN: circt-opt -handshake-insert-buffers=strategy=throughput %s | FileCheck %s
+
+// The path through the sequential buffer is three cycles longer, so the
+// other branch of the fork needs three slots to keep accepting a token every
+// cycle.
+// CHECK-LABEL:   handshake.func @reconvergent(
+// CHECK:           %[[FORK:.*]]:2 = fork [2] %{{.*}} : i32
+// CHECK-DAG:       %[[FIFO:.*]] = buffer [3] fifo %[[FORK]]#1 : i32
+// CHECK-DAG:       %[[SEQ:.*]] = buffer [3] seq %[[FORK]]#0 : i32
+// CHECK:           %[[SUM:.*]] = arith.addi %[[SEQ]], %[[FIFO]] : i32
+// CHECK:           return %[[SUM]], %{{.*}} : i32, none
+handshake.func @reconvergent(%arg0: i32, %ctrl: none, ...) -> (i32, none) {
+  %0:2 = fork [2] %arg0 : i32
+  %1 = buffer [3] seq %0#0 : i32
+  %2 = arith.addi %1, %0#1 : i32
+  return %2, %ctrl : i32, none
+}
+
+// Balanced paths need no buffers.
+// CHECK-LABEL:   handshake.func @balanced(
+// CHECK-NOT:       buffer
+// CHECK:           return
+handshake.func @balanced(%arg0: i32, %ctrl: none, ...) -> (i32, none) {
+  %0:2 = fork [2] %arg0 : i32
+  %1 = arith.addi %0#0, %0#1 : i32
+  return %1, %ctrl : i32, none
+}
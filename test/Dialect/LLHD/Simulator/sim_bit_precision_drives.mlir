@@ -1,5 +1,6 @@
 // REQUIRES: llhd-sim
 // RUN: llhd-sim %s -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s
+// RUN: llhd-sim %s --batch-drives -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s
 
 // CHECK: 0ps 0d 0e  root/sameByte  0xffffffff
 // CHECK-NEXT: 0ps 0d 0e  root/spanBytes  0xffffffff
@@ -0,0 +1,26 @@
+// REQUIRES: llhd-sim
+// RUN: llhd-sim %s -T 4500 -r Foo --save-state=%t.state -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s --check-prefix=SAVE
+// RUN: llhd-sim %s -T 7500 -r Foo --restore-state=%t.state -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s --check-prefix=RESTORE
+
+// SAVE: 0ps 0d 0e  Foo/toggle  0x00
+// SAVE-NEXT: 1000ps 0d 0e  Foo/toggle  0x01
+// SAVE-NEXT: 2000ps 0d 0e  Foo/toggle  0x00
+// SAVE-NEXT: 3000ps 0d 0e  Foo/toggle  0x01
+// SAVE-NEXT: 4000ps 0d 0e  Foo/toggle  0x00
+// SAVE-NOT: Foo/toggle
+
+// The restored simulation starts with the values of the checkpoint.
+// RESTORE: 4000ps 0d 0e  Foo/toggle  0x00
+// RESTORE-NEXT: 5000ps 0d 0e  Foo/toggle  0x01
+// RESTORE-NEXT: 6000ps 0d 0e  Foo/toggle  0x00
+// RESTORE-NEXT: 7000ps 0d 0e  Foo/toggle  0x01
+// RESTORE-NOT: Foo/toggle
+llhd.entity @Foo () -> () {
+  %0 = hw.constant 0 : i1
+  %toggle = llhd.sig "toggle" %0 : i1
+  %1 = llhd.prb %toggle : !llhd.sig<i1>
+  %allset = hw.constant 1 : i1
+  %2 = comb.xor %1, %allset : i1
+  %dt = llhd.constant_time #llhd.time<1ns, 0d, 0e>
+  llhd.drv %toggle, %2 after %dt : !llhd.sig<i1>
+}
@@ -4,6 +4,7 @@
 // RUN: llhd-sim %s -T 5000 --trace-format=merged -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s --check-prefix=MERGED
 // RUN: llhd-sim %s -T 5000 --trace-format=merged-reduce -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s --check-prefix=MERGEDRED
 // RUN: llhd-sim %s -T 5000 --trace-format=named-only -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s --check-prefix=NAMED
+// RUN: llhd-sim %s -T 5000 --trace-format=vcd -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s --check-prefix=VCD
 
 // FULL: 0ps 0d 0e  root/1  0x01
 // FULL: 0ps 0d 0e  root/foo/s  0x01
@@ -94,6 +95,25 @@
 // NAMED:   root/s  0xf3
 // NAMED: 5000ps
 // NAMED:   root/s  0xd9
+
+// VCD:      $timescale 1ps $end
+// VCD-NEXT: $scope module root $end
+// VCD-DAG:  $var wire 8 [[S:.+]] s $end
+// VCD-DAG:  $var wire 8 [[ONE:.+]] 1 $end
+// VCD:      $scope module foo $end
+// VCD-NEXT: $var wire 8 [[S]] s $end
+// VCD-NEXT: $upscope $end
+// VCD-NEXT: $upscope $end
+// VCD-NEXT: $enddefinitions $end
+// VCD-NEXT: #0
+// VCD-DAG:  b11 [[S]]
+// VCD-DAG:  b1 [[ONE]]
+// VCD:      #1000
+// VCD-NEXT: b1001 [[S]]
+// VCD-NEXT: #2000
+// VCD-NEXT: b11011 [[S]]
+// VCD-NOT:  [[ONE]]
+
 llhd.entity @root () -> () {
   %0 = hw.constant 1 : i8
   %s = llhd.sig "s" %0 : i8
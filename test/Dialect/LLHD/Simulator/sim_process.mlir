@@ -1,5 +1,7 @@
 // REQUIRES: llhd-sim
 // RUN: llhd-sim %s -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s
+// RUN: llhd-sim %s --threads=4 -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s
+// RUN: llhd-sim %s --batch-drives -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s
 
 // CHECK: 0ps 0d 0e  root/proc/toggle  0x01
 // CHECK-NEXT: 0ps 0d 0e  root/toggle  0x01
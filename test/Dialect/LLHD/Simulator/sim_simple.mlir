@@ -1,5 +1,8 @@
 // REQUIRES: llhd-sim
 // RUN: llhd-sim %s -n 10 -r Foo -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s
+// RUN: llhd-sim %s -r Foo --emit-object=%t.o -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext
+// RUN: llhd-sim %s -n 10 -r Foo --load-object=%t.o -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s
+// RUN: llhd-sim %s -n 10 -r Foo --profile --trace-format=none -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext 2>&1 | FileCheck %s --check-prefix=PROFILE
 
 // CHECK: 0ps 0d 0e  Foo/toggle  0x00
 // CHECK-NEXT: 1000ps 0d 0e  Foo/toggle  0x01
@@ -11,6 +14,11 @@
 // CHECK-NEXT: 7000ps 0d 0e  Foo/toggle  0x01
 // CHECK-NEXT: 8000ps 0d 0e  Foo/toggle  0x00
 // CHECK-NEXT: 9000ps 0d 0e  Foo/toggle  0x01
+
+// PROFILE: real-time steps: 10
+// PROFILE-NEXT: delta steps: 0
+// PROFILE: time (ms) activations delta drives wakeups instance
+// PROFILE-NEXT: {{[0-9.]+}} 10 0 10 0 Foo
 llhd.entity @Foo () -> () {
   %0 = hw.constant 0 : i1
   %toggle = llhd.sig "toggle" %0 : i1
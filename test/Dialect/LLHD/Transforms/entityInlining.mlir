@@ -0,0 +1,51 @@
+// RUN: circt-opt %s -llhd-inline-entities | FileCheck %s
+
+llhd.entity @child (%in : !llhd.sig<i1>) -> (%out : !llhd.sig<i1>) {
+  %0 = llhd.prb %in : !llhd.sig<i1>
+  %t = llhd.constant_time #llhd.time<0ns, 1d, 0e>
+  llhd.drv %out, %0 after %t : !llhd.sig<i1>
+}
+
+// CHECK-LABEL: llhd.entity @mid
+// CHECK-SAME:    (%[[IN:.*]] : !llhd.sig<i1>) -> (%[[OUT:.*]] : !llhd.sig<i1>)
+// CHECK:         %[[S:.*]] = llhd.sig "s"
+// CHECK-NEXT:    %[[V0:.*]] = llhd.prb %[[IN]]
+// CHECK-NEXT:    %[[T0:.*]] = llhd.constant_time
+// CHECK-NEXT:    llhd.drv %[[S]], %[[V0]] after %[[T0]]
+// CHECK-NEXT:    %[[V1:.*]] = llhd.prb %[[S]]
+// CHECK-NEXT:    %[[T1:.*]] = llhd.constant_time
+// CHECK-NEXT:    llhd.drv %[[OUT]], %[[V1]] after %[[T1]]
+// CHECK-NOT:     llhd.inst
+llhd.entity @mid (%in : !llhd.sig<i1>) -> (%out : !llhd.sig<i1>) {
+  %0 = hw.constant 0 : i1
+  %s = llhd.sig "s" %0 : i1
+  llhd.inst "c0" @child(%in) -> (%s) : (!llhd.sig<i1>) -> !llhd.sig<i1>
+  llhd.inst "c1" @child(%s) -> (%out) : (!llhd.sig<i1>) -> !llhd.sig<i1>
+}
+
+llhd.proc @proc () -> () {
+  llhd.halt
+}
+
+// The signals of inlined entities are prefixed with the instance name, and
+// process instances are kept.
+// CHECK-LABEL: llhd.entity @root
+// CHECK:         %[[A:.*]] = llhd.sig "a"
+// CHECK-NEXT:    %[[B:.*]] = llhd.sig "b"
+// CHECK-NEXT:    hw.constant false
+// CHECK-NEXT:    %[[MS:.*]] = llhd.sig "m/s"
+// CHECK-NEXT:    llhd.prb %[[A]]
+// CHECK-NEXT:    llhd.constant_time
+// CHECK-NEXT:    llhd.drv %[[MS]]
+// CHECK-NEXT:    llhd.prb %[[MS]]
+// CHECK-NEXT:    llhd.constant_time
+// CHECK-NEXT:    llhd.drv %[[B]]
+// CHECK-NEXT:    llhd.inst "p" @proc() -> () : () -> ()
+// CHECK-NOT:     llhd.inst "m"
+llhd.entity @root () -> () {
+  %0 = hw.constant 0 : i1
+  %a = llhd.sig "a" %0 : i1
+  %b = llhd.sig "b" %0 : i1
+  llhd.inst "m" @mid(%a) -> (%b) : (!llhd.sig<i1>) -> !llhd.sig<i1>
+  llhd.inst "p" @proc() -> () : () -> ()
+}
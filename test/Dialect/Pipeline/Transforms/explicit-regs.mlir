@@ -57,3 +57,24 @@ hw.module @test3(%arg0 : i32, %arg1 : i32, %go : i1, %clk : i1, %rst : i1) -> (o
   }
   hw.output %out : i32
 }
+
+// CHECK:      %0 = pipeline.pipeline(%arg0, %go) clock %clk reset %rst : (i32, i1) -> i32 {
+// CHECK-NEXT:   ^bb0(%[[ARG0:.*]]: i32, %[[ARG1:.*]]: i1):
+// CHECK-NEXT:     %[[S0_REG:.*]], %[[S0_VALID:.*]] = pipeline.stage.register when %[[ARG1]] regs %[[ARG0]] : i32
+// CHECK-NEXT:     %[[S1_REG:.*]], %[[S1_VALID:.*]] = pipeline.stage.register when %[[S0_VALID]] regs %[[S0_REG]] : i32
+// CHECK-NEXT:     %[[S2_REG:.*]], %[[S2_VALID:.*]] = pipeline.stage.register when %[[S1_VALID]] regs %[[S1_REG]] : i32
+// CHECK-NEXT:     %[[ADD0_OUT:.*]] = comb.add %[[S2_REG]], %[[S2_REG]] : i32
+// CHECK-NEXT:     pipeline.return %[[ADD0_OUT]] valid %[[S2_VALID]] : i32
+// CHECK-NEXT: }
+
+hw.module @test4(%arg0 : i32, %go : i1, %clk : i1, %rst : i1) -> (out: i32) {
+  %out = pipeline.pipeline(%arg0, %go) clock %clk reset %rst : (i32, i1) -> (i32) {
+    ^bb0(%a0 : i32, %g : i1):
+      %s0_valid = pipeline.stage when %g
+      %s1_valid = pipeline.stage when %s0_valid
+      %s2_valid = pipeline.stage when %s1_valid
+      %add0 = comb.add %a0, %a0 : i32 // %a0 crosses all stages.
+      pipeline.return %add0 valid %s2_valid : i32
+  }
+  hw.output %out : i32
+}
@@ -1,6 +1,9 @@
 // RUN: rm -rf %t
 // RUN: circt-opt -pass-pipeline='builtin.module(hw-export-module-hierarchy{dir-name=%t})' %s
 // RUN: FileCheck %s < %t/testharness_hier.json
+// RUN: rm -rf %t.dedup
+// RUN: circt-opt -pass-pipeline='builtin.module(hw-export-module-hierarchy{dir-name=%t.dedup dedup-modules})' %s
+// RUN: FileCheck %s --check-prefix=DEDUP < %t.dedup/dedup_hier.json
 
 // CHECK:      {
 // CHECK-NEXT:   "instance_name": "TestHarness",
@@ -33,3 +36,32 @@ hw.module @TestHarness() attributes {firrtl.moduleHierarchyFile = [#hw.output_fi
   %0 = hw.constant 1 : i1
   hw.instance "main_design" @MainDesign(in: %0: i1) -> (out: i1)
 }
+
+// DEDUP:      {
+// DEDUP-NEXT:   "instance_name": "DedupHarness",
+// DEDUP-NEXT:   "module_name": "DedupHarness",
+// DEDUP-NEXT:   "instances": [
+// DEDUP-NEXT:     {
+// DEDUP-NEXT:       "instance_name": "design0",
+// DEDUP-NEXT:       "module_name": "MainDesign",
+// DEDUP-NEXT:       "instances": [
+// DEDUP-NEXT:         {
+// DEDUP-NEXT:           "instance_name": "inner",
+// DEDUP-NEXT:           "module_name": "InnerModule",
+// DEDUP-NEXT:           "instances": []
+// DEDUP-NEXT:         }
+// DEDUP-NEXT:       ]
+// DEDUP-NEXT:     },
+// DEDUP-NEXT:     {
+// DEDUP-NEXT:       "instance_name": "design1",
+// DEDUP-NEXT:       "module_name": "MainDesign",
+// DEDUP-NEXT:       "instances_ref": "MainDesign"
+// DEDUP-NEXT:     }
+// DEDUP-NEXT:   ]
+// DEDUP-NEXT: }
+
+hw.module @DedupHarness() attributes {firrtl.moduleHierarchyFile = [#hw.output_file<"dedup_hier.json", excludeFromFileList>]} {
+  %0 = hw.constant 1 : i1
+  hw.instance "design0" @MainDesign(in: %0: i1) -> (out: i1)
+  hw.instance "design1" @MainDesign(in: %0: i1) -> (out: i1)
+}
@@ -400,3 +400,16 @@ hw.module.generated @ReadWriteWithHighWriteLatency, @FIRRTLMem(%rw_addr: i4, %rw
 // CHECK: [[TMP:%.+]] = comb.and %true, [[WRITE_WMODE_3R]]
 // CHECK: [[WCOND:%.+]] comb.and [[WRITE_EN_3R]], [[TMP]]
 // CHECK: [[WPTR:%.+]] = sv.array_index_inout [[MEM]][[[WRITE_ADDR_3R]]]
+
+// Memories which only differ in their name share a single model.
+
+// COMMON-LABEL: hw.module @DedupModel
+// COMMON:         sv.reg
+hw.module.generated @DedupModel, @FIRRTLMem(%rw_addr: i4, %rw_en: i1,  %rw_clock: i1, %rw_wmode: i1, %rw_wdata: i8) -> (rw_rdata: i8) attributes {depth = 16 : i64, numReadPorts = 0 : ui32, numReadWritePorts = 1 : ui32, numWritePorts = 0 : ui32, readLatency = 1 : ui32, readUnderWrite = 0 : ui32, width = 8 : ui32, writeClockIDs = [], writeLatency = 1 : ui32, writeUnderWrite = 0 : i32}
+
+// COMMON-LABEL: hw.module @DedupWrapper
+// COMMON-SAME:    (%rw_addr: i4, %rw_en: i1, %rw_clock: i1, %rw_wmode: i1, %rw_wdata: i8) -> (rw_rdata: i8)
+// COMMON-NEXT:    %[[RDATA:.+]] = hw.instance "DedupModel" @DedupModel(rw_addr: %rw_addr: i4, rw_en: %rw_en: i1, rw_clock: %rw_clock: i1, rw_wmode: %rw_wmode: i1, rw_wdata: %rw_wdata: i8) -> (rw_rdata: i8)
+// COMMON-NEXT:    hw.output %[[RDATA]] : i8
+// COMMON-NEXT:  }
+hw.module.generated @DedupWrapper, @FIRRTLMem(%rw_addr: i4, %rw_en: i1,  %rw_clock: i1, %rw_wmode: i1, %rw_wdata: i8) -> (rw_rdata: i8) attributes {depth = 16 : i64, numReadPorts = 0 : ui32, numReadWritePorts = 1 : ui32, numWritePorts = 0 : ui32, readLatency = 1 : ui32, readUnderWrite = 0 : ui32, width = 8 : ui32, writeClockIDs = [], writeLatency = 1 : ui32, writeUnderWrite = 0 : i32}
@@ -1,10 +1,39 @@
 // RUN: circt-opt --sv-trace-iverilog --export-verilog %s | FileCheck %s
+// RUN: circt-opt --sv-trace-iverilog='debug-signals' --export-verilog %s | FileCheck %s --check-prefix=DEBUG
+// RUN: circt-opt --sv-trace-iverilog='signals=a,child.w' --export-verilog %s | FileCheck %s --check-prefix=LIST
 
-// CHECK-LABEL: module top();
+// CHECK-LABEL: module top(
 // CHECK:       initial begin
 // CHECK-NEXT:    $dumpfile ("./top.vcd");
 // CHECK-NEXT:    $dumpvars (0, top);
 // CHECK-NEXT:    #1;
 // CHECK-NEXT:  end
 
-hw.module @top () {}
+// DEBUG-LABEL: module top(
+// DEBUG:       initial begin
+// DEBUG-NEXT:    $dumpfile ("./top.vcd");
+// DEBUG-NEXT:    $dumpvars (0, a);
+// DEBUG-NEXT:    $dumpvars (0, r);
+// DEBUG-NEXT:    $dumpvars (0, child.w);
+// DEBUG-NEXT:    #1;
+// DEBUG-NEXT:  end
+
+// LIST-LABEL: module top(
+// LIST:       initial begin
+// LIST-NEXT:    $dumpfile ("./top.vcd");
+// LIST-NEXT:    $dumpvars (0, a);
+// LIST-NEXT:    $dumpvars (0, child.w);
+// LIST-NEXT:    #1;
+// LIST-NEXT:  end
+
+hw.module @child(%a: i1) {
+  %w = sv.wire {hw.debug.name = "w"} : !hw.inout<i1>
+  sv.assign %w, %a : i1
+  %t = sv.wire : !hw.inout<i1>
+  sv.assign %t, %a : i1
+}
+
+hw.module @top(%a: i1, %b: i1) attributes {hw.debug.name = ["a", ""]} {
+  %r = sv.reg {hw.debug.name = "r"} : !hw.inout<i1>
+  hw.instance "child" @child(a: %b: i1) -> ()
+}
@@ -0,0 +1,33 @@
+// RUN: circt-opt %s -verify-diagnostics --lower-seq-to-sv='merge-always-blocks' | circt-opt -verify-diagnostics | FileCheck %s
+
+// CHECK-LABEL: hw.module @top
+hw.module @top(%clk: i1, %clk2: i1, %rst: i1, %i: i32, %j: i32) {
+  %rv = hw.constant 0 : i32
+
+  // CHECK: %r0 = sv.reg : !hw.inout<i32>
+  // CHECK: %r1 = sv.reg : !hw.inout<i32>
+  // CHECK: %r2 = sv.reg : !hw.inout<i32>
+  // CHECK: %r3 = sv.reg : !hw.inout<i32>
+  // CHECK: %r4 = sv.reg : !hw.inout<i32>
+  %r0 = seq.compreg %i, %clk, %rst, %rv : i32
+  %r1 = seq.compreg %i, %clk : i32
+  %r2 = seq.compreg %j, %clk, %rst, %rv : i32
+  %r3 = seq.compreg %j, %clk : i32
+  %r4 = seq.compreg %i, %clk2 : i32
+
+  // CHECK:      sv.alwaysff(posedge %clk) {
+  // CHECK-NEXT:   sv.passign %r0, %i : i32
+  // CHECK-NEXT:   sv.passign %r2, %j : i32
+  // CHECK-NEXT: }(syncreset : posedge %rst) {
+  // CHECK-NEXT:   sv.passign %r0, %c0_i32 : i32
+  // CHECK-NEXT:   sv.passign %r2, %c0_i32 : i32
+  // CHECK-NEXT: }
+  // CHECK-NEXT: sv.alwaysff(posedge %clk) {
+  // CHECK-NEXT:   sv.passign %r1, %i : i32
+  // CHECK-NEXT:   sv.passign %r3, %j : i32
+  // CHECK-NEXT: }
+  // CHECK-NEXT: sv.alwaysff(posedge %clk2) {
+  // CHECK-NEXT:   sv.passign %r4, %i : i32
+  // CHECK-NEXT: }
+  // CHECK-NEXT: hw.output
+}
@@ -0,0 +1,25 @@
+// RUN: circt-opt %s -test-ssp-scheduler=scheduler=asap -verify-diagnostics -split-input-file
+
+// expected-error @+2 {{scheduler 'asap' does not support problem class 'CyclicProblem'}}
+// expected-error @+1 {{scheduling failed}}
+ssp.instance @self_arc of "CyclicProblem" {
+  library {
+    operator_type @unit [latency<1>]
+    operator_type @_3 [latency<3>]
+  }
+  graph {
+    %0 = operation<@unit>()
+    %1 = operation<@_3> @self(%0, %0, @self [dist<1>])
+    operation<@unit>(%1)
+  }
+}
+
+// -----
+
+// expected-error @+1 {{instance has no last operation to schedule}}
+ssp.instance @empty of "Problem" {
+  library {
+  }
+  graph {
+  }
+}
@@ -0,0 +1,45 @@
+// RUN: circt-opt %s -test-ssp-scheduler=scheduler=simplex | FileCheck %s
+// RUN: circt-opt %s -test-ssp-scheduler="scheduler=simplex metrics=true" -verify-diagnostics -o /dev/null
+
+// CHECK: ssp.instance @arbitrary_latencies of "Problem" {
+// CHECK:   graph {
+// CHECK:     operation<@unit>(%{{.*}}) [t<19>]
+// CHECK:   }
+// CHECK: }
+// expected-remark @+1 {{latency = 20, time = }}
+ssp.instance @arbitrary_latencies of "Problem" {
+  library {
+    operator_type @unit [latency<1>]
+    operator_type @extr [latency<0>]
+    operator_type @add [latency<3>]
+    operator_type @mult [latency<6>]
+    operator_type @sqrt [latency<10>]
+  }
+  graph {
+    %0 = operation<@extr>()
+    %1 = operation<@extr>()
+    %2 = operation<@mult>(%0, %0)
+    %3 = operation<@mult>(%1, %1)
+    %4 = operation<@add>(%2, %3)
+    %5 = operation<@sqrt>(%4)
+    operation<@unit>(%5)
+  }
+}
+
+// CHECK: ssp.instance @self_arc of "CyclicProblem" [II<3>] {
+// CHECK:   graph {
+// CHECK:     operation<@unit>(%{{.*}}) [t<4>]
+// CHECK:   }
+// CHECK: }
+// expected-remark @+1 {{latency = 5, II = 3, time = }}
+ssp.instance @self_arc of "CyclicProblem" {
+  library {
+    operator_type @unit [latency<1>]
+    operator_type @_3 [latency<3>]
+  }
+  graph {
+    %0 = operation<@unit>()
+    %1 = operation<@_3> @self(%0, %0, @self [dist<1>])
+    operation<@unit>(%1)
+  }
+}
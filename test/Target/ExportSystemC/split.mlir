@@ -0,0 +1,24 @@
+// RUN: rm -rf %t
+// RUN: circt-translate %s --export-split-systemc --export-dir=%t
+// RUN: FileCheck %s --check-prefix=FIRST < %t/first.h
+// RUN: FileCheck %s --check-prefix=SECOND < %t/second.h
+
+// Every file gets the includes and exactly one module.
+
+// FIRST:      #include <systemc.h>
+// FIRST:      SC_MODULE(first) {
+// FIRST-NEXT:   sc_in<bool> in0;
+// FIRST-NEXT: };
+// FIRST-NOT:  SC_MODULE
+
+// SECOND:      #include <systemc.h>
+// SECOND-NOT:  SC_MODULE(first)
+// SECOND:      SC_MODULE(second) {
+// SECOND-NEXT:   sc_out<bool> out0;
+// SECOND-NEXT: };
+// SECOND-NOT:  SC_MODULE
+
+emitc.include <"systemc.h">
+
+systemc.module @first (%in0: !systemc.in<i1>) {}
+systemc.module @second (%out0: !systemc.out<i1>) {}
@@ -0,0 +1,13 @@
+// RUN: circt-opt %s --profile-canonicalize='report-file=%t.txt' -o /dev/null
+// RUN: FileCheck %s < %t.txt
+
+// CHECK: Canonicalization pattern profile
+// CHECK: Rewrite runs: 1, not converged: 0
+// CHECK: Time (ms) Attempts Successes Pattern (root)
+// CHECK-DAG: {{[0-9]+ +0  .*MuxRewriter \(comb.mux\)}}
+// CHECK-DAG: <folders and rewrite driver>
+
+hw.module @Mux(%sel: i1, %a: i8, %b: i8) -> (out: i8) {
+  %0 = comb.mux %sel, %a, %b : i8
+  hw.output %0 : i8
+}
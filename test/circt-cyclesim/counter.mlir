@@ -0,0 +1,42 @@
+// RUN: printf 'rst=1 en=1\nrst=0\n\n\nen=0\n' > %t.stim
+// RUN: circt-cyclesim %s --stimulus %t.stim --vcd %t.vcd | FileCheck %s
+// RUN: FileCheck %s --check-prefix=VCD < %t.vcd
+
+// CHECK:      cycle 0: count=0 value=0
+// CHECK-NEXT: cycle 1: count=0 value=0
+// CHECK-NEXT: cycle 2: count=1 value=1
+// CHECK-NEXT: cycle 3: count=2 value=2
+// CHECK-NEXT: cycle 4: count=3 value=3
+// CHECK-NOT:  cycle
+
+// VCD:      $scope module Counter $end
+// VCD-NEXT: $var wire 1 ! clk $end
+// VCD-NEXT: $var wire 1 " rst $end
+// VCD-NEXT: $var wire 1 # en $end
+// VCD-NEXT: $var wire 8 $ count $end
+// VCD-NEXT: $var reg 8 % value $end
+// VCD:      $enddefinitions $end
+// VCD-NEXT: #0
+// VCD-NEXT: 0!
+// VCD-NEXT: 1"
+// VCD-NEXT: 1#
+// VCD-NEXT: b0 $
+// VCD-NEXT: b0 %
+// VCD-NEXT: #5
+// VCD-NEXT: 1!
+// VCD-NEXT: #10
+// VCD-NEXT: 0!
+// VCD-NEXT: 0"
+// VCD-NEXT: #15
+// VCD-NEXT: 1!
+// VCD-NEXT: b1 $
+// VCD-NEXT: b1 %
+
+hw.module @Counter(%clk: i1, %rst: i1, %en: i1) -> (count: i8) {
+  %c0_i8 = hw.constant 0 : i8
+  %c1_i8 = hw.constant 1 : i8
+  %inc = comb.add %value, %c1_i8 : i8
+  %next = comb.mux %en, %inc, %value : i8
+  %value = seq.compreg %next, %clk, %rst, %c0_i8 : i8
+  hw.output %value : i8
+}
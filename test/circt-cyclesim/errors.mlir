@@ -0,0 +1,30 @@
+// RUN: split-file %s %t
+// RUN: not circt-cyclesim %t/instance.mlir 2>&1 | FileCheck %s --check-prefix=INSTANCE
+// RUN: not circt-cyclesim %t/cycle.mlir 2>&1 | FileCheck %s --check-prefix=CYCLE
+// RUN: not circt-cyclesim %t/clock.mlir 2>&1 | FileCheck %s --check-prefix=CLOCK
+
+//--- instance.mlir
+hw.module @Child(%a: i1) -> (b: i1) {
+  hw.output %a : i1
+}
+hw.module @Top(%a: i1) -> (b: i1) {
+  // INSTANCE: error: instances are not supported by the cycle simulator
+  %b = hw.instance "child" @Child(a: %a: i1) -> (b: i1)
+  hw.output %b : i1
+}
+
+//--- cycle.mlir
+hw.module @Top(%a: i1) -> (b: i1) {
+  // CYCLE: error: operation is part of a combinational cycle
+  %0 = comb.xor %a, %1 : i1
+  %1 = comb.and %a, %0 : i1
+  hw.output %1 : i1
+}
+
+//--- clock.mlir
+hw.module @Top(%a: i1) -> (b: i1) {
+  %clk = comb.xor %a, %a : i1
+  // CLOCK: error: registers must be clocked by an input port of the module
+  %r = seq.compreg %a, %clk : i1
+  hw.output %r : i1
+}
@@ -1,6 +1,10 @@
 // UNSUPPORTED: system-windows
 //   See https://github.com/llvm/circt/issues/4129
 // RUN: circt-reduce %s --test %S.sh --test-arg firtool --test-arg "error: sink \"x1.x\" not fully initialized" --keep-best=0 --test-must-fail | FileCheck %s
+// RUN: circt-reduce %s --test %S.sh --test-arg firtool --test-arg "error: sink \"x1.x\" not fully initialized" --keep-best=0 --test-must-fail -j 4 | FileCheck %s
+// RUN: circt-reduce %s --test %S.sh --test-arg firtool --test-arg "error: sink \"x1.x\" not fully initialized" --keep-best=0 --test-must-fail --top-down | FileCheck %s
+// RUN: circt-reduce %s --test %S.sh --test-arg firtool --test-arg "error: sink \"x1.x\" not fully initialized" --keep-best=0 --test-must-fail --test-bytecode | FileCheck %s
+// RUN: circt-reduce %s --test-pass-pipeline "firrtl.circuit(firrtl-expand-whens)" --test-diagnostic "sink \"x1.x\" not fully initialized" --keep-best=0 | FileCheck %s
 
 firrtl.circuit "Foo" {
   // CHECK-NOT: firrtl.module @FooFooFoo
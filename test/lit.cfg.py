@@ -56,8 +56,9 @@ tool_dirs = [
     config.circt_tools_dir, config.mlir_tools_dir, config.llvm_tools_dir
 ]
 tools = [
-    'firtool', 'circt-as', 'circt-dis', 'circt-opt', 'circt-reduce',
-    'circt-translate', 'circt-capi-ir-test', 'esi-tester', 'hlstool'
+    'firtool', 'circt-as', 'circt-cyclesim', 'circt-dis', 'circt-opt',
+    'circt-reduce', 'circt-translate', 'circt-capi-ir-test',
+    'circt-capi-firtool-test', 'esi-tester', 'hlstool'
 ]
 
 # Enable Verilator if it has been detected.
@@ -0,0 +1,287 @@
+//===- circt-cyclesim.cpp - Cycle-based simulator tool ----------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a command line tool to simulate flat HW, Comb and Seq
+// modules cycle by cycle with a compiled model, and to trace them as VCD.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/Comb/CombDialect.h"
+#include "circt/Dialect/HW/HWDialect.h"
+#include "circt/Dialect/HW/HWOps.h"
+#include "circt/Dialect/Seq/SeqDialect.h"
+#include "circt/Dialect/Seq/Simulator/CycleSim.h"
+#include "circt/Support/Version.h"
+
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/FileUtilities.h"
+
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+using namespace llvm;
+using namespace mlir;
+using namespace circt;
+using namespace circt::seq::sim;
+
+static cl::OptionCategory mainCategory("circt-cyclesim Options");
+
+static cl::opt<std::string> inputFilename(cl::Positional,
+                                          cl::desc("<input-file>"),
+                                          cl::init("-"), cl::cat(mainCategory));
+
+static cl::opt<std::string> outputFilename("o", cl::desc("Output filename"),
+                                           cl::value_desc("filename"),
+                                           cl::init("-"),
+                                           cl::cat(mainCategory));
+
+static cl::opt<std::string>
+    topModule("top",
+              cl::desc("The module to simulate, by default the only module "
+                       "of the input"),
+              cl::cat(mainCategory));
+
+static cl::opt<unsigned>
+    numCycles("cycles",
+              cl::desc("The number of cycles to simulate, by default one per "
+                       "line of the stimulus"),
+              cl::init(0), cl::cat(mainCategory));
+
+static cl::opt<std::string> stimulusFilename(
+    "stimulus",
+    cl::desc("Drive the inputs from this file, with one line of "
+             "whitespace-separated <input>=<value> assignments per cycle. "
+             "Inputs keep their value until they are assigned again"),
+    cl::value_desc("filename"), cl::cat(mainCategory));
+
+static cl::opt<std::string> vcdFilename("vcd",
+                                        cl::desc("Write a VCD trace to this "
+                                                 "file"),
+                                        cl::value_desc("filename"),
+                                        cl::cat(mainCategory));
+
+static cl::opt<unsigned> optimizationLevel("O",
+                                           cl::desc("Optimization level"),
+                                           cl::init(2), cl::cat(mainCategory));
+
+/// Read the stimulus, one list of input assignments per cycle.
+static LogicalResult
+readStimulus(CycleSim &sim,
+             std::vector<std::vector<std::pair<unsigned, APInt>>> &cycles) {
+  std::string errorMessage;
+  auto file = openInputFile(stimulusFilename, &errorMessage);
+  if (!file) {
+    errs() << errorMessage << "\n";
+    return failure();
+  }
+
+  SmallVector<StringRef> lines;
+  file->getBuffer().split(lines, '\n');
+  if (!lines.empty() && lines.back().trim().empty())
+    lines.pop_back();
+  for (auto [lineNo, line] : llvm::enumerate(lines)) {
+    auto &assignments = cycles.emplace_back();
+    SmallVector<StringRef> fields;
+    line.split(fields, ' ', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+    for (auto field : fields) {
+      field = field.trim();
+      if (field.empty())
+        continue;
+      auto [name, value] = field.split('=');
+      int signal = sim.lookupSignal(name);
+      if (signal < 0 ||
+          sim.getSignals()[signal].kind != Signal::Kind::Input) {
+        errs() << stimulusFilename << ":" << lineNo + 1 << ": '" << name
+               << "' is not an input\n";
+        return failure();
+      }
+      APInt parsed;
+      bool negative = value.consume_front("-");
+      if (value.getAsInteger(0, parsed)) {
+        errs() << stimulusFilename << ":" << lineNo + 1 << ": invalid value '"
+               << value << "'\n";
+        return failure();
+      }
+      parsed = parsed.zextOrTrunc(sim.getSignals()[signal].width);
+      if (negative)
+        parsed.negate();
+      assignments.push_back({unsigned(signal), parsed});
+    }
+  }
+  return success();
+}
+
+namespace {
+/// Writes the values of all signals in the Value Change Dump format, only
+/// listing the signals which changed since the last dump.
+class VCDWriter {
+public:
+  VCDWriter(raw_ostream &os, const CycleSim &sim, StringRef top)
+      : os(os), sim(sim) {
+    os << "$timescale 1ns $end\n";
+    os << "$scope module " << top << " $end\n";
+    for (auto [i, signal] : llvm::enumerate(sim.getSignals()))
+      os << "$var " << (signal.kind == Signal::Kind::Register ? "reg" : "wire")
+         << " " << signal.width << " " << getID(i) << " " << signal.name
+         << " $end\n";
+    os << "$upscope $end\n";
+    os << "$enddefinitions $end\n";
+  }
+
+  void dump(uint64_t time) {
+    os << "#" << time << "\n";
+    auto signals = sim.getSignals();
+    values.resize(signals.size());
+    for (unsigned i = 0, e = signals.size(); i != e; ++i) {
+      APInt value = sim.getValue(i);
+      if (values[i] && *values[i] == value)
+        continue;
+      if (signals[i].width == 1)
+        os << (value.isZero() ? "0" : "1") << getID(i) << "\n";
+      else
+        os << "b" << toString(value, 2, /*Signed=*/false) << " " << getID(i)
+           << "\n";
+      values[i] = value;
+    }
+  }
+
+private:
+  /// Return the short identifier of a signal, in base 94 over the printable
+  /// characters.
+  static std::string getID(unsigned signal) {
+    std::string id;
+    do {
+      id.push_back('!' + signal % 94);
+      signal /= 94;
+    } while (signal);
+    return id;
+  }
+
+  raw_ostream &os;
+  const CycleSim &sim;
+  std::vector<Optional<APInt>> values;
+};
+} // namespace
+
+/// Print the outputs and registers of the simulated module.
+static void printCycle(raw_ostream &os, const CycleSim &sim, unsigned cycle) {
+  os << "cycle " << cycle << ":";
+  for (auto [i, signal] : llvm::enumerate(sim.getSignals()))
+    if (signal.kind == Signal::Kind::Output ||
+        signal.kind == Signal::Kind::Register)
+      os << " " << signal.name << "="
+         << toString(sim.getValue(i), 10, /*Signed=*/false);
+  os << "\n";
+}
+
+int main(int argc, char **argv) {
+  InitLLVM y(argc, argv);
+
+  // Set the bug report message to indicate users should file issues on
+  // llvm/circt and not llvm/llvm-project.
+  setBugReportMsg(circtBugReportMsg);
+
+  // Hide default LLVM options, other than for this tool.
+  cl::HideUnrelatedOptions(mainCategory);
+
+  cl::ParseCommandLineOptions(argc, argv, "CIRCT cycle-based simulator\n");
+
+  std::string errorMessage;
+  auto file = openInputFile(inputFilename, &errorMessage);
+  if (!file) {
+    errs() << errorMessage << "\n";
+    return 1;
+  }
+
+  auto output = openOutputFile(outputFilename, &errorMessage);
+  if (!output) {
+    errs() << errorMessage << "\n";
+    return 1;
+  }
+
+  SourceMgr mgr;
+  mgr.AddNewSourceBuffer(std::move(file), SMLoc());
+  MLIRContext context;
+  context.loadDialect<hw::HWDialect, comb::CombDialect, seq::SeqDialect>();
+  OwningOpRef<ModuleOp> module(parseSourceFile<ModuleOp>(mgr, &context));
+  if (!module)
+    return 1;
+
+  std::string top = topModule;
+  if (top.empty()) {
+    auto modules = module->getOps<hw::HWModuleOp>();
+    if (modules.empty()) {
+      errs() << "the input has no modules\n";
+      return 1;
+    }
+    if (std::next(modules.begin()) != modules.end()) {
+      errs() << "the input has several modules, select one with --top\n";
+      return 1;
+    }
+    top = (*modules.begin()).getName().str();
+  }
+
+  auto sim = CycleSim::create(*module, top, optimizationLevel);
+  if (!sim)
+    return 1;
+
+  std::vector<std::vector<std::pair<unsigned, APInt>>> stimulus;
+  if (!stimulusFilename.empty() && failed(readStimulus(*sim, stimulus)))
+    return 1;
+  unsigned cycles =
+      numCycles ? numCycles : std::max<size_t>(stimulus.size(), 1);
+
+  std::unique_ptr<ToolOutputFile> vcdFile;
+  std::unique_ptr<VCDWriter> vcd;
+  if (!vcdFilename.empty()) {
+    vcdFile = openOutputFile(vcdFilename, &errorMessage);
+    if (!vcdFile) {
+      errs() << errorMessage << "\n";
+      return 1;
+    }
+    vcd = std::make_unique<VCDWriter>(vcdFile->os(), *sim, top);
+  }
+
+  // Every cycle applies the stimulus and computes the outputs with the clocks
+  // low, then raises all clocks, updating the registers, and computes the
+  // outputs again. The trace shows the clocks as a period of 10ns.
+  auto clocks = sim->getClocks();
+  auto setClocks = [&](bool high) {
+    for (unsigned clock : clocks)
+      sim->setValue(clock, APInt(sim->getSignals()[clock].width, high));
+  };
+  for (unsigned cycle = 0; cycle != cycles; ++cycle) {
+    if (cycle < stimulus.size())
+      for (auto &[signal, value] : stimulus[cycle])
+        sim->setValue(signal, value);
+    setClocks(false);
+    if (failed(sim->evalComb()))
+      return 1;
+    printCycle(output->os(), *sim, cycle);
+    if (vcd)
+      vcd->dump(cycle * 10);
+
+    setClocks(true);
+    for (unsigned clock = 0, e = clocks.size(); clock != e; ++clock)
+      if (failed(sim->evalClock(clock)))
+        return 1;
+    if (failed(sim->evalComb()))
+      return 1;
+    if (vcd)
+      vcd->dump(cycle * 10 + 5);
+  }
+  if (vcd)
+    vcd->dump(cycles * 10);
+
+  output->keep();
+  if (vcdFile)
+    vcdFile->keep();
+  return 0;
+}
@@ -5,6 +5,13 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 //
 //===----------------------------------------------------------------------===//
+//
+// This is a thin wrapper around the MLIR language server, which registers the
+// CIRCT dialects. Parsing, the tracking of document changes and the indexing
+// of definitions and uses are all done by the MLIR server library, which has
+// no extension points for them: every change re-parses the whole document.
+//
+//===----------------------------------------------------------------------===//
 
 #include "circt/InitAllDialects.h"
 #include "circt/Support/Version.h"
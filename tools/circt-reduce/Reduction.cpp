@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "Reduction.h"
+#include "circt/Dialect/FIRRTL/FIRRTLInstanceGraph.h"
 #include "circt/Dialect/FIRRTL/FIRRTLOps.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/InitAllDialects.h"
@@ -513,6 +514,55 @@ struct InstanceStubber : public Reduction {
   llvm::DenseSet<Operation *> erasedModules;
 };
 
+/// A variant of `InstanceStubber` that only stubs out the instances in the
+/// modules at a given depth of the instance hierarchy, where the main module is
+/// at depth zero. The depth of a module is the length of its shortest instance
+/// path from the main module.
+struct HierarchyLevelStubber : public InstanceStubber {
+  HierarchyLevelStubber(unsigned depth) : depth(depth) {}
+
+  void beforeReduction(mlir::ModuleOp op) override {
+    InstanceStubber::beforeReduction(op);
+    moduleDepths.clear();
+    for (auto circuitOp : op.getOps<firrtl::CircuitOp>()) {
+      firrtl::InstanceGraph instanceGraph(circuitOp);
+      auto *top = instanceGraph.getTopLevelNode();
+      moduleDepths.insert({top->getModule().getOperation(), 0});
+      SmallVector<hw::InstanceGraphNode *> level = {top};
+      for (unsigned d = 1; d <= depth && !level.empty(); ++d) {
+        SmallVector<hw::InstanceGraphNode *> nextLevel;
+        for (auto *node : level) {
+          for (auto *record : *node) {
+            auto *target = record->getTarget();
+            if (moduleDepths.insert({target->getModule().getOperation(), d})
+                    .second)
+              nextLevel.push_back(target);
+          }
+        }
+        level = std::move(nextLevel);
+      }
+    }
+  }
+
+  uint64_t match(Operation *op) override {
+    auto instOp = dyn_cast<firrtl::InstanceOp>(op);
+    if (!instOp)
+      return 0;
+    auto it = moduleDepths.find(
+        instOp->getParentOfType<firrtl::FModuleOp>().getOperation());
+    if (it == moduleDepths.end() || it->second != depth)
+      return 0;
+    return InstanceStubber::match(op);
+  }
+
+  std::string getName() const override {
+    return ("instance-stubber-depth-" + Twine(depth)).str();
+  }
+
+  unsigned depth;
+  DenseMap<Operation *, unsigned> moduleDepths;
+};
+
 /// A sample reduction pattern that maps `firrtl.mem` to a set of invalidated
 /// wires.
 struct MemoryStubber : public Reduction {
@@ -1144,3 +1194,7 @@ void circt::createAllReductions(
   add(std::make_unique<ConnectSourceOperandForwarder<1>>());
   add(std::make_unique<ConnectSourceOperandForwarder<2>>());
 }
+
+std::unique_ptr<Reduction> circt::createHierarchyLevelStubber(unsigned depth) {
+  return std::make_unique<HierarchyLevelStubber>(depth);
+}
@@ -110,6 +110,12 @@ void createAllReductions(
     mlir::MLIRContext *context,
     llvm::function_ref<void(std::unique_ptr<Reduction>)> add);
 
+/// Create a reduction that stubs out the FIRRTL instances in the modules at
+/// `depth` in the instance hierarchy, where the main module is at depth zero.
+/// Used by the top-down reduction strategy to remove whole subtrees of the
+/// hierarchy one level at a time.
+std::unique_ptr<Reduction> createHierarchyLevelStubber(unsigned depth);
+
 } // namespace circt
 
 #endif // CIRCT_REDUCE_REDUCTION_H
@@ -11,7 +11,17 @@
 //===----------------------------------------------------------------------===//
 
 #include "Tester.h"
+#include "circt/Support/Version.h"
+#include "mlir/Bytecode/BytecodeWriter.h"
 #include "mlir/IR/Verifier.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Pass/PassRegistry.h"
+#include "llvm/Support/CrashRecoveryContext.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 
 using namespace llvm;
@@ -27,6 +37,141 @@ Tester::Tester(StringRef scriptName, ArrayRef<std::string> scriptArgs,
     : testScript(scriptName), testScriptArgs(scriptArgs),
       testMustFail(testMustFail) {}
 
+Tester::~Tester() = default;
+
+/// Load the outcomes of previous runs from the file at `path`, if it exists,
+/// and append the outcomes of new tests to it. Each line of the file holds a
+/// cache key and a `0` or `1` outcome.
+Error Tester::useCacheFile(StringRef path) {
+  if (sys::fs::exists(path)) {
+    auto buffer = MemoryBuffer::getFile(path);
+    if (!buffer)
+      return createStringError(buffer.getError(), "cannot read test cache `%s`",
+                               path.str().c_str());
+    SmallVector<StringRef> lines;
+    (*buffer)->getBuffer().split(lines, '\n', -1, false);
+    for (StringRef line : lines) {
+      auto [key, outcome] = line.rtrim().split(' ');
+      if (!key.empty() && (outcome == "0" || outcome == "1"))
+        resultCache[key] = outcome == "1";
+    }
+  }
+
+  std::error_code ec;
+  cacheFile = std::make_unique<raw_fd_ostream>(path, ec,
+                                               sys::fs::OF_Append |
+                                                   sys::fs::OF_Text);
+  if (ec)
+    return createStringError(ec, "cannot open test cache `%s`",
+                             path.str().c_str());
+  return Error::success();
+}
+
+/// Test in-process instead of running the test script. Each test runs the pass
+/// `pipeline` on a copy of the test case in `context`.
+Error Tester::useInProcessTest(MLIRContext *context, StringRef pipeline,
+                               StringRef diagnosticPattern) {
+  // Check the pipeline and pattern up front, such that the tests never fail
+  // for reasons other than the test case.
+  PassManager pm(context);
+  std::string errorMessage;
+  llvm::raw_string_ostream errorStream(errorMessage);
+  if (failed(parsePassPipeline(pipeline, pm, errorStream)))
+    return createStringError(inconvertibleErrorCode(),
+                             "invalid test pass pipeline: %s",
+                             errorStream.str().c_str());
+  if (!diagnosticPattern.empty()) {
+    diagnosticRegex = Regex(diagnosticPattern);
+    if (!diagnosticRegex.isValid(errorMessage))
+      return createStringError(inconvertibleErrorCode(),
+                               "invalid test diagnostic `%s`: %s",
+                               diagnosticPattern.str().c_str(),
+                               errorMessage.c_str());
+  }
+
+  inProcessContext = context;
+  inProcessPipeline = pipeline.str();
+  this->diagnosticPattern = diagnosticPattern.str();
+  CrashRecoveryContext::Enable();
+  return Error::success();
+}
+
+/// Run the in-process test on a test case. A test case is interesting if the
+/// pipeline crashes, or, with `testMustFail`, if it fails. If a diagnostic
+/// pattern is set, the test case is interesting if a matching diagnostic is
+/// emitted instead.
+bool Tester::isInterestingInProcess(TestCase &test) const {
+  assert(isInProcess());
+
+  // Work on a copy of the module, or parse test cases provided on disk.
+  OwningOpRef<ModuleOp> module;
+  if (test.module)
+    module = test.module.clone();
+  else
+    module = parseSourceFile<ModuleOp>(test.filepath, inProcessContext);
+  if (!module)
+    return false;
+
+  PassManager pm(inProcessContext);
+  if (failed(parsePassPipeline(inProcessPipeline, pm)))
+    llvm_unreachable("test pass pipeline checked in useInProcessTest");
+
+  // Swallow all diagnostics, only noting whether one of them matches.
+  bool diagnosticMatched = false;
+  ScopedDiagnosticHandler handler(inProcessContext, [&](Diagnostic &diag) {
+    if (!diagnosticPattern.empty() && diagnosticRegex.match(diag.str()))
+      diagnosticMatched = true;
+    return success();
+  });
+
+  // A crash leaves the module in an unknown state, so never touch it again.
+  bool pipelineFailed = false;
+  CrashRecoveryContext crc;
+  bool crashed =
+      !crc.RunSafely([&] { pipelineFailed = failed(pm.run(*module)); });
+  if (crashed)
+    (void)module.release();
+
+  if (!diagnosticPattern.empty())
+    return diagnosticMatched;
+  return crashed || (testMustFail && pipelineFailed);
+}
+
+/// Return the key under which the outcome of a test case with the given
+/// contents is cached. The key covers the test command as well, such that a
+/// cache file is never used with the wrong test.
+std::string Tester::getCacheKey(StringRef contents) const {
+  SHA1 hasher;
+  hasher.update(testScript);
+  for (auto &arg : testScriptArgs) {
+    hasher.update(StringRef("\0", 1));
+    hasher.update(arg);
+  }
+  hasher.update(testMustFail ? StringRef("\0\1", 2) : StringRef("\0\0", 2));
+  hasher.update(inProcessPipeline);
+  hasher.update(StringRef("\0", 1));
+  hasher.update(diagnosticPattern);
+  hasher.update(StringRef("\0", 1));
+  hasher.update(contents);
+  return toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+/// Return the cached outcome of the test case with the given key, if any.
+Optional<bool> Tester::getCachedResult(StringRef key) const {
+  auto it = resultCache.find(key);
+  if (it == resultCache.end())
+    return None;
+  return it->second;
+}
+
+/// Remember the outcome of the test case with the given key.
+void Tester::cacheResult(StringRef key, bool interesting) const {
+  if (!resultCache.try_emplace(key, interesting).second || !cacheFile)
+    return;
+  *cacheFile << key << ' ' << (interesting ? '1' : '0') << '\n';
+  cacheFile->flush();
+}
+
 std::pair<bool, size_t> Tester::isInteresting(ModuleOp module) const {
   auto test = get(module);
   return std::make_pair(test.isInteresting(), test.getSize());
@@ -58,6 +203,55 @@ bool Tester::isInteresting(StringRef testCase) const {
   return result == 0;
 }
 
+/// Run the tester on all of the given test cases which are valid and have not
+/// been tested yet, with up to `numJobs` test processes at a time.
+void Tester::runConcurrently(ArrayRef<TestCase *> tests,
+                             unsigned numJobs) const {
+  // In-process tests run one at a time.
+  if (isInProcess()) {
+    for (auto *test : tests)
+      (void)test->isInteresting();
+    return;
+  }
+
+  // Write the test cases to disk up front, such that only the test processes
+  // run concurrently. Test cases with a known outcome, or identical to one
+  // already scheduled, are not run.
+  SmallVector<TestCase *> toRun;
+  StringMap<TestCase *> scheduled;
+  SmallVector<std::pair<TestCase *, TestCase *>> duplicates;
+  for (auto *test : tests) {
+    if (!test->isValid() || test->interesting)
+      continue;
+    test->ensureFileOnDisk();
+    StringRef key = test->getCacheKey();
+    if (auto cached = getCachedResult(key)) {
+      test->interesting = *cached;
+      continue;
+    }
+    auto [it, inserted] = scheduled.try_emplace(key, test);
+    if (!inserted) {
+      duplicates.push_back({test, it->second});
+      continue;
+    }
+    toRun.push_back(test);
+  }
+
+  // Each thread blocks on one test process at a time.
+  SmallVector<char> results(toRun.size(), false);
+  llvm::ThreadPool pool(llvm::hardware_concurrency(numJobs));
+  for (size_t i = 0, e = toRun.size(); i != e; ++i)
+    pool.async([&, i] { results[i] = isInteresting(toRun[i]->filepath); });
+  pool.wait();
+
+  for (size_t i = 0, e = toRun.size(); i != e; ++i) {
+    toRun[i]->interesting = results[i];
+    cacheResult(toRun[i]->getCacheKey(), results[i]);
+  }
+  for (auto [test, original] : duplicates)
+    test->interesting = original->interesting;
+}
+
 /// Create a new test case for the given `module`.
 TestCase Tester::get(mlir::ModuleOp module) const {
   return TestCase(*this, module);
@@ -92,12 +286,16 @@ StringRef TestCase::getFilepath() {
   return filepath;
 }
 
-/// Determine the size of the MLIR module on disk. Actual writing to disk is
-/// only performed on the first call; subsequent calls return the cached result.
+/// Determine the size of the MLIR module on disk. Actual printing of the module
+/// is only performed on the first call; subsequent calls return the cached
+/// result.
 size_t TestCase::getSize() {
   if (!isValid())
     return 0;
-  ensureFileOnDisk();
+  if (module)
+    ensurePrinted();
+  else
+    ensureFileOnDisk();
   return *size;
 }
 
@@ -107,39 +305,87 @@ size_t TestCase::getSize() {
 bool TestCase::isInteresting() {
   if (!isValid())
     return false;
-  ensureFileOnDisk();
-  if (!interesting)
+  if (interesting)
+    return *interesting;
+
+  StringRef key = getCacheKey();
+  interesting = tester.getCachedResult(key);
+  if (interesting)
+    return *interesting;
+
+  if (tester.isInProcess()) {
+    interesting = tester.isInterestingInProcess(*this);
+  } else {
+    ensureFileOnDisk();
     interesting = tester.isInteresting(filepath);
+  }
+  tester.cacheResult(key, *interesting);
   return *interesting;
 }
 
+/// Determine the key under which the outcome of this test case is cached by
+/// the tester. Only computed on the first call.
+StringRef TestCase::getCacheKey() {
+  if (module) {
+    ensurePrinted();
+    return cacheKey;
+  }
+  if (!cacheKey.empty())
+    return cacheKey;
+
+  // Read already-prepared files back in.
+  auto buffer = MemoryBuffer::getFile(filepath);
+  if (!buffer)
+    llvm::report_fatal_error(Twine("Error reading test case `") + filepath +
+                                 "`: " + buffer.getError().message(),
+                             false);
+  cacheKey = tester.getCacheKey((*buffer)->getBuffer());
+  return cacheKey;
+}
+
+/// Ensure `size` and `cacheKey` are populated for a test case created from a
+/// module, and that the module has been printed if it is not on disk yet.
+void TestCase::ensurePrinted() {
+  assert(module);
+  if (size)
+    return;
+  llvm::raw_string_ostream contentsStream(contents);
+  if (tester.usesBytecode())
+    writeBytecodeToFile(module, contentsStream,
+                        BytecodeWriterConfig(getCirctVersion()));
+  else
+    module.print(contentsStream);
+  size = contentsStream.str().size();
+  cacheKey = tester.getCacheKey(contents);
+}
+
 /// Ensure `filepath` and `size` are populated, and that the test case is in a
 /// file on disk.
 void TestCase::ensureFileOnDisk() {
   // Write the module to a temporary file if no already-prepared file path has
   // been provided to the test.
   if (filepath.empty()) {
-    assert(module);
+    ensurePrinted();
 
-    // Pick a temporary output file path.
+    // Pick a temporary output file path. Tools like firtool pick the parser
+    // based on the extension.
     int fd;
-    std::error_code ec =
-        llvm::sys::fs::createTemporaryFile("mlir-reduce", "mlir", fd, filepath);
+    std::error_code ec = llvm::sys::fs::createTemporaryFile(
+        "mlir-reduce", tester.usesBytecode() ? "mlirbc" : "mlir", fd,
+        filepath);
     if (ec)
       llvm::report_fatal_error(
           Twine("Error making unique filename: ") + ec.message(), false);
 
     // Write to the output.
     file = std::make_unique<llvm::ToolOutputFile>(filepath, fd);
-    module.print(file->os());
+    file->os() << contents;
     file->os().close();
     if (file->os().has_error())
       llvm::report_fatal_error(llvm::Twine("Error emitting the IR to file `") +
                                    filepath + "`",
                                false);
-
-    // Update the file size.
-    size = file->os().tell();
+    std::string().swap(contents);
     return;
   }
 
@@ -18,11 +18,14 @@
 
 #include "mlir/IR/BuiltinOps.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Regex.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Program.h"
 
 namespace llvm {
+class raw_fd_ostream;
 class ToolOutputFile;
 } // namespace llvm
 
@@ -36,10 +39,16 @@ class TestCase;
 /// interestingness and additional arguments to pass to that tool. Use `get()`
 /// to obtain a new test case that can be queried for information on an
 /// individual MLIR module.
+///
+/// The tester remembers the outcome of every test it has run, keyed by a hash
+/// of the test case contents and the test command, such that identical test
+/// cases are only tested once. The outcomes can also be kept in a file across
+/// runs, see `useCacheFile`.
 class Tester {
 public:
   Tester(llvm::StringRef testScript, llvm::ArrayRef<std::string> testScriptArgs,
          bool testMustFail);
+  ~Tester();
 
   /// Runs the interestingness testing script on a MLIR test case file. Returns
   /// true if the interesting behavior is present in the test case or false
@@ -49,6 +58,50 @@ public:
   /// Return whether the file in the given path is interesting.
   bool isInteresting(llvm::StringRef testCase) const;
 
+  /// Run the tester on all of the given test cases which are valid and have not
+  /// been tested yet, with up to `numJobs` test processes at a time. The
+  /// results are cached in the test cases, see `TestCase::isInteresting`.
+  void runConcurrently(llvm::ArrayRef<TestCase *> tests,
+                       unsigned numJobs) const;
+
+  /// Load the outcomes of previous runs from the file at `path`, if it exists,
+  /// and append the outcomes of new tests to it.
+  llvm::Error useCacheFile(llvm::StringRef path);
+
+  /// Write test cases to disk as MLIR bytecode instead of textual MLIR. Sizes
+  /// are then measured in bytes of bytecode.
+  void useBytecode() { emitBytecode = true; }
+
+  /// Return whether test cases are written as MLIR bytecode.
+  bool usesBytecode() const { return emitBytecode; }
+
+  /// Test in-process instead of running the test script. Each test runs the
+  /// pass `pipeline`, anchored on the top-level module, on a copy of the test
+  /// case in `context`. Crashes are caught by a `CrashRecoveryContext`, which
+  /// requires `context` to run single-threaded. If `diagnosticPattern` is not
+  /// empty, test cases are interesting if they produce a diagnostic matching
+  /// it, and otherwise if the pipeline crashes (or fails, with
+  /// `testMustFail`).
+  llvm::Error useInProcessTest(mlir::MLIRContext *context,
+                               llvm::StringRef pipeline,
+                               llvm::StringRef diagnosticPattern);
+
+  /// Return whether tests run in-process.
+  bool isInProcess() const { return inProcessContext != nullptr; }
+
+  /// Run the in-process test on a test case.
+  bool isInterestingInProcess(TestCase &test) const;
+
+  /// Return the key under which the outcome of a test case with the given
+  /// contents is cached.
+  std::string getCacheKey(llvm::StringRef contents) const;
+
+  /// Return the cached outcome of the test case with the given key, if any.
+  llvm::Optional<bool> getCachedResult(llvm::StringRef key) const;
+
+  /// Remember the outcome of the test case with the given key.
+  void cacheResult(llvm::StringRef key, bool interesting) const;
+
   /// Create a new test case for the given `module`.
   TestCase get(mlir::ModuleOp module) const;
 
@@ -66,6 +119,21 @@ private:
   /// Consider the testcase to be interesting if it fails rather than on exit
   /// code 0.
   bool testMustFail;
+
+  /// Whether test cases are written as MLIR bytecode.
+  bool emitBytecode = false;
+
+  /// The context, pass pipeline and diagnostic pattern of in-process tests.
+  mlir::MLIRContext *inProcessContext = nullptr;
+  std::string inProcessPipeline;
+  std::string diagnosticPattern;
+  llvm::Regex diagnosticRegex;
+
+  /// The outcomes of the tests run so far, by cache key.
+  mutable llvm::StringMap<bool> resultCache;
+
+  /// The file new outcomes are appended to, if any.
+  std::unique_ptr<llvm::raw_fd_ostream> cacheFile;
 };
 
 /// A single test case to be run by a tester.
@@ -95,19 +163,28 @@ public:
   /// result.
   llvm::StringRef getFilepath();
 
-  /// Determine the size of the MLIR module on disk. Actual writing to disk is
-  /// only performed on the first call; subsequent calls return the cached
-  /// result.
+  /// Determine the size of the MLIR module on disk. Actual printing of the
+  /// module is only performed on the first call; subsequent calls return the
+  /// cached result.
   size_t getSize();
 
   /// Run the tester on the MLIR module and return whether it is deemed
   /// interesting. Actual testing is only performed on the first call;
-  /// subsequent calls return the cached result.
+  /// subsequent calls return the cached result. The test is skipped if the
+  /// tester already knows the outcome for identical contents.
   bool isInteresting();
 
+  /// Determine the key under which the outcome of this test case is cached by
+  /// the tester. Only computed on the first call.
+  llvm::StringRef getCacheKey();
+
 private:
   friend class Tester;
 
+  /// Ensure `size` and `cacheKey` are populated for a test case created from a
+  /// module, printing the module as text or bytecode if necessary.
+  void ensurePrinted();
+
   /// Ensure `filepath` and `size` are populated, and that the test case is in a
   /// file on disk.
   void ensureFileOnDisk();
@@ -132,6 +209,10 @@ private:
   llvm::Optional<size_t> size;
   /// Whether the tester has run on this test case, and its result.
   llvm::Optional<bool> interesting;
+  /// The printed module, until it is written to disk.
+  std::string contents;
+  /// The cache key of the test case, if already computed.
+  std::string cacheKey;
 };
 
 } // namespace circt
@@ -13,11 +13,17 @@
 
 #include "Reduction.h"
 #include "Tester.h"
+#include "circt/Conversion/Passes.h"
+#include "circt/Dialect/FIRRTL/Passes.h"
+#include "circt/Dialect/HW/HWPasses.h"
+#include "circt/Dialect/SV/SVPasses.h"
+#include "circt/Dialect/Seq/SeqPasses.h"
 #include "circt/InitAllDialects.h"
 #include "circt/Support/Version.h"
 #include "mlir/IR/AsmState.h"
 #include "mlir/Parser/Parser.h"
 #include "mlir/Support/FileUtilities.h"
+#include "mlir/Transforms/Passes.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/ToolOutputFile.h"
@@ -75,15 +81,43 @@ static cl::list<std::string>
                       cl::cat(mainCategory));
 
 static cl::opt<std::string> testerCommand(
-    "test", cl::Required,
+    "test", cl::init(""),
     cl::desc("A command or script to check if output is interesting"),
     cl::cat(mainCategory));
 
+static cl::opt<std::string> testPassPipeline(
+    "test-pass-pipeline", cl::init(""),
+    cl::desc("Instead of running a test command, run this pass pipeline "
+             "in-process and consider crashes interesting"),
+    cl::cat(mainCategory));
+
+static cl::opt<std::string> testDiagnostic(
+    "test-diagnostic", cl::init(""),
+    cl::desc("With --test-pass-pipeline, consider diagnostics matching this "
+             "regex interesting instead of crashes"),
+    cl::cat(mainCategory));
+
 static cl::list<std::string>
     testerArgs("test-arg", cl::ZeroOrMore,
                cl::desc("Additional arguments to the test"),
                cl::cat(mainCategory));
 
+static cl::opt<std::string> testCache(
+    "test-cache", cl::init(""),
+    cl::desc("File to keep the outcomes of the test in across runs"),
+    cl::cat(mainCategory));
+
+static cl::opt<bool> testBytecode(
+    "test-bytecode", cl::init(false),
+    cl::desc("Write test cases as MLIR bytecode instead of textual MLIR"),
+    cl::cat(mainCategory));
+
+static cl::opt<bool> topDown(
+    "top-down", cl::init(false),
+    cl::desc("Stub out whole subtrees of the instance hierarchy, one level at "
+             "a time from the top, before applying the other reductions"),
+    cl::cat(mainCategory));
+
 static cl::opt<bool> verbose("v", cl::init(true),
                              cl::desc("Print reduction progress to stderr"),
                              cl::cat(mainCategory));
@@ -112,6 +146,13 @@ static cl::opt<unsigned>
                           "ops per chunk (granularity upper bound)"),
                  cl::cat(granularityCategory));
 
+static cl::opt<unsigned> numJobs(
+    "j", cl::init(1),
+    cl::desc("Number of reduction attempts to test concurrently. Attempts on "
+             "the following chunks are tested speculatively, and the first "
+             "interesting one is accepted."),
+    cl::cat(mainCategory));
+
 static cl::opt<bool> testMustFail(
     "test-must-fail", cl::init(false),
     cl::desc("Consider an input to be interesting on non-zero exit status."),
@@ -168,6 +209,17 @@ static LogicalResult execute(MLIRContext &context) {
     return success();
   }
 
+  if (testerCommand.empty() == testPassPipeline.empty()) {
+    mlir::emitError(UnknownLoc::get(&context))
+        << "exactly one of --test and --test-pass-pipeline must be given";
+    return failure();
+  }
+
+  // In-process tests recover from crashes on the thread running the pipeline,
+  // which requires the passes to run on that thread as well.
+  if (!testPassPipeline.empty())
+    context.disableMultithreading();
+
   // Parse the input file.
   VERBOSE(llvm::errs() << "Reading input\n");
   mlir::OwningOpRef<mlir::ModuleOp> module =
@@ -177,11 +229,31 @@ static LogicalResult execute(MLIRContext &context) {
 
   // Evaluate the unreduced input.
   VERBOSE({
-    llvm::errs() << "Testing input with `" << testerCommand << "`\n";
-    for (auto &arg : testerArgs)
-      llvm::errs() << "  with argument `" << arg << "`\n";
+    if (!testPassPipeline.empty()) {
+      llvm::errs() << "Testing input with pipeline `" << testPassPipeline
+                   << "`\n";
+    } else {
+      llvm::errs() << "Testing input with `" << testerCommand << "`\n";
+      for (auto &arg : testerArgs)
+        llvm::errs() << "  with argument `" << arg << "`\n";
+    }
   });
   Tester tester(testerCommand, testerArgs, testMustFail);
+  if (testBytecode)
+    tester.useBytecode();
+  if (!testPassPipeline.empty()) {
+    if (auto err = tester.useInProcessTest(&context, testPassPipeline,
+                                           testDiagnostic)) {
+      mlir::emitError(UnknownLoc::get(&context)) << toString(std::move(err));
+      return failure();
+    }
+  }
+  if (!testCache.empty()) {
+    if (auto err = tester.useCacheFile(testCache)) {
+      mlir::emitError(UnknownLoc::get(&context)) << toString(std::move(err));
+      return failure();
+    }
+  }
   auto initialTest = tester.get(module.get());
   if (!skipInitial && !initialTest.isInteresting()) {
     mlir::emitError(UnknownLoc::get(&context), "input is not interesting");
@@ -200,19 +272,11 @@ static LogicalResult execute(MLIRContext &context) {
         << "\x1B[1A\x1B[2K"; // move up one line ("1A"), clear line ("2K")
   };
 
-  // Iteratively reduce the input module by applying the current reduction
-  // pattern to successively smaller subsets of the operations until we find one
-  // that retains the interesting behavior.
-  // ModuleExternalizer pattern;
-  BitVector appliedOneShotPatterns(patterns.size(), false);
-  for (unsigned patternIdx = 0; patternIdx < patterns.size();) {
-    Reduction &pattern = *patterns[patternIdx];
-    if (pattern.isOneShot() && appliedOneShotPatterns[patternIdx]) {
-      LLVM_DEBUG(llvm::dbgs()
-                 << "Skipping one-shot `" << pattern.getName() << "`\n");
-      ++patternIdx;
-      continue;
-    }
+  // Iteratively reduce the input module by applying a reduction pattern to
+  // successively smaller subsets of the operations until we find one that
+  // retains the interesting behavior. Returns whether the pattern reduced the
+  // module.
+  auto reduceWithPattern = [&](Reduction &pattern) -> FailureOr<bool> {
     VERBOSE({
       clearSummary();
       llvm::errs() << "Trying reduction `" << pattern.getName() << "`\n";
@@ -222,34 +286,41 @@ static LogicalResult execute(MLIRContext &context) {
     bool patternDidReduce = false;
     bool allDidReduce = true;
 
-    while (rangeLength > 0) {
-      // Limit the number of ops processed at once to the value requested by the
-      // user.
-      if (maxChunkSize > 0)
-        rangeLength = std::min<size_t>(rangeLength, maxChunkSize);
-
-      // Apply the pattern to the subset of operations selected by `rangeBase`
-      // and `rangeLength`.
-      size_t opIdx = 0;
+    // Apply the pattern to a clone of the current module, on the subset of
+    // operations selected by `base` and `length`. Sets `numOps` to the number
+    // of operations where the pattern applies.
+    auto applyPattern = [&](size_t base, size_t length, size_t &numOps) {
       mlir::OwningOpRef<mlir::ModuleOp> newModule = module->clone();
       pattern.beforeReduction(*newModule);
       SmallVector<std::pair<Operation *, uint64_t>, 16> opBenefits;
       newModule->walk([&](Operation *op) {
         uint64_t benefit = pattern.match(op);
         if (benefit > 0) {
-          opIdx++;
+          numOps++;
           opBenefits.push_back(std::make_pair(op, benefit));
         }
       });
       std::sort(opBenefits.begin(), opBenefits.end(),
                 [](auto a, auto b) { return a.second > b.second; });
-      for (size_t i = rangeBase;
-           i < rangeBase + rangeLength && i < opBenefits.size(); i++) {
+      for (size_t i = base; i < base + length && i < opBenefits.size(); i++) {
         auto *op = opBenefits[i].first;
         if (pattern.match(op))
           (void)pattern.rewrite(op);
       }
       pattern.afterReduction(*newModule);
+      return newModule;
+    };
+
+    while (rangeLength > 0) {
+      // Limit the number of ops processed at once to the value requested by the
+      // user.
+      if (maxChunkSize > 0)
+        rangeLength = std::min<size_t>(rangeLength, maxChunkSize);
+
+      // Apply the pattern to the subset of operations selected by `rangeBase`
+      // and `rangeLength`.
+      size_t opIdx = 0;
+      auto newModule = applyPattern(rangeBase, rangeLength, opIdx);
       if (opIdx == 0) {
         VERBOSE({
           clearSummary();
@@ -277,27 +348,60 @@ static LogicalResult execute(MLIRContext &context) {
         errsPosAfterLastSummary = llvm::errs().tell();
       });
 
+      // If we are running multiple jobs, speculatively prepare the attempts on
+      // the next chunks as well, as if this one was rejected. The serial search
+      // would try exactly these next, at the same granularity.
+      SmallVector<mlir::OwningOpRef<mlir::ModuleOp>> candidates;
+      candidates.push_back(std::move(newModule));
+      for (size_t base = rangeBase + rangeLength;
+           candidates.size() < numJobs && base < opIdx; base += rangeLength) {
+        size_t numOps = 0;
+        candidates.push_back(applyPattern(base, rangeLength, numOps));
+      }
+
       // Check if this reduced module is still interesting, and its overall size
       // is smaller than what we had before.
-      auto shouldAccept = [&](TestCase &test) {
+      auto shouldTest = [&](TestCase &test) {
         if (!test.isValid())
           return false; // don't write to disk if module is busted
         if (test.getSize() >= bestSize && !pattern.acceptSizeIncrease())
           return false; // don't run test if size already bad
-        return test.isInteresting();
+        return true;
       };
-      auto test = tester.get(newModule.get());
-      if (shouldAccept(test)) {
+      SmallVector<TestCase> tests;
+      SmallVector<TestCase *> testsToRun;
+      for (auto &candidate : candidates)
+        tests.push_back(tester.get(candidate.get()));
+      for (auto &test : tests)
+        if (shouldTest(test))
+          testsToRun.push_back(&test);
+      if (testsToRun.size() > 1)
+        tester.runConcurrently(testsToRun, numJobs);
+
+      // Accept the first interesting attempt, which is the one the serial
+      // search would have accepted. The rejected attempts before it advance the
+      // search as usual.
+      size_t acceptedIdx = 0;
+      for (size_t e = tests.size(); acceptedIdx != e; ++acceptedIdx)
+        if (shouldTest(tests[acceptedIdx]) &&
+            tests[acceptedIdx].isInteresting())
+          break;
+      if (acceptedIdx > 0) {
+        allDidReduce = false;
+        rangeBase += acceptedIdx * rangeLength;
+      }
+
+      if (acceptedIdx < tests.size()) {
         // Make this reduced module the new baseline and reset our search
         // strategy to start again from the beginning, since this reduction may
         // have created additional opportunities.
         patternDidReduce = true;
-        bestSize = test.getSize();
+        bestSize = tests[acceptedIdx].getSize();
         VERBOSE({
           clearSummary();
           llvm::errs() << "- Accepting module of size " << bestSize << "\n";
         });
-        module = std::move(newModule);
+        module = std::move(candidates[acceptedIdx]);
 
         // We leave `rangeBase` and `rangeLength` untouched in this case. This
         // causes the next iteration of the loop to try the same pattern again
@@ -314,10 +418,6 @@ static LogicalResult execute(MLIRContext &context) {
         if (keepBest)
           if (failed(writeOutput(module.get())))
             return failure();
-      } else {
-        allDidReduce = false;
-        // Try the pattern on the next `rangeLength` number of operations.
-        rangeBase += rangeLength;
       }
 
       // If we have gone past the end of the input, reduce the size of the chunk
@@ -353,6 +453,45 @@ static LogicalResult execute(MLIRContext &context) {
         }
       }
     }
+    return patternDidReduce;
+  };
+
+  // Stub out whole subtrees of the instance hierarchy first, one level at a
+  // time from the top. Each level only considers the modules that survived
+  // the levels above it, such that the generic reductions below start out
+  // from the smallest hierarchy that is still interesting.
+  if (topDown) {
+    for (unsigned depth = 0;; ++depth) {
+      auto pattern = createHierarchyLevelStubber(depth);
+      pattern->beforeReduction(*module);
+      bool matches = false;
+      module->walk([&](Operation *op) {
+        if (!pattern->match(op))
+          return WalkResult::advance();
+        matches = true;
+        return WalkResult::interrupt();
+      });
+      if (!matches)
+        break;
+      if (failed(reduceWithPattern(*pattern)))
+        return failure();
+    }
+  }
+
+  // Apply the reductions in order, starting at the top again whenever one of
+  // them succeeds.
+  BitVector appliedOneShotPatterns(patterns.size(), false);
+  for (unsigned patternIdx = 0; patternIdx < patterns.size();) {
+    Reduction &pattern = *patterns[patternIdx];
+    if (pattern.isOneShot() && appliedOneShotPatterns[patternIdx]) {
+      LLVM_DEBUG(llvm::dbgs()
+                 << "Skipping one-shot `" << pattern.getName() << "`\n");
+      ++patternIdx;
+      continue;
+    }
+    auto patternDidReduce = reduceWithPattern(pattern);
+    if (failed(patternDidReduce))
+      return failure();
 
     // If this was a one-shot pattern, mark it as having been applied. This will
     // prevent further reapplication.
@@ -362,7 +501,7 @@ static LogicalResult execute(MLIRContext &context) {
     // If the pattern provided a successful reduction, restart with the first
     // pattern again, since we might have uncovered additional reduction
     // opportunities. Otherwise we just keep going to try the next pattern.
-    if (patternDidReduce && patternIdx > 0) {
+    if (*patternDidReduce && patternIdx > 0) {
       VERBOSE({
         clearSummary();
         llvm::errs() << "- Reduction `" << pattern.getName()
@@ -393,6 +532,26 @@ int main(int argc, char **argv) {
   // llvm/circt and not llvm/llvm-project.
   setBugReportMsg(circtBugReportMsg);
 
+  // Register the passes available to in-process tests.
+  {
+    // MLIR transforms:
+    // Don't use registerTransformsPasses, pulls in too much.
+    registerCSEPass();
+    registerCanonicalizerPass();
+    registerSymbolDCEPass();
+
+    // Dialect passes:
+    firrtl::registerPasses();
+    hw::registerPasses();
+    seq::registerPasses();
+    sv::registerPasses();
+
+    // Conversion and export passes:
+    registerLowerFIRRTLToHWPass();
+    registerPrepareForEmissionPass();
+    registerExportVerilogPass();
+  }
+
   // Register and hide default LLVM options, other than for this tool.
   registerMLIRContextCLOptions();
   registerAsmPrinterCLOptions();
@@ -26,8 +26,10 @@
 #include "circt/Dialect/SV/SVPasses.h"
 #include "circt/Dialect/Seq/SeqDialect.h"
 #include "circt/Dialect/Seq/SeqPasses.h"
+#include "circt/Firtool/Firtool.h"
 #include "circt/Support/LoweringOptions.h"
 #include "circt/Support/LoweringOptionsParser.h"
+#include "circt/Support/TaskTrace.h"
 #include "circt/Support/Version.h"
 #include "circt/Transforms/Passes.h"
 #include "mlir/Bytecode/BytecodeReader.h"
@@ -35,6 +37,9 @@
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/AsmState.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Threading.h"
+#include "mlir/IR/Verifier.h"
 #include "mlir/Parser/Parser.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassInstrumentation.h"
@@ -42,17 +47,29 @@
 #include "mlir/Support/FileUtilities.h"
 #include "mlir/Support/Timing.h"
 #include "mlir/Support/ToolUtilities.h"
-#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Chrono.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA256.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/ToolOutputFile.h"
 
+#include <mutex>
+
+#if LLVM_ON_UNIX
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
 using namespace llvm;
 using namespace mlir;
 using namespace circt;
@@ -148,7 +165,8 @@ static cl::opt<bool>
 
 static cl::opt<circt::firrtl::PreserveAggregate::PreserveMode>
     preserveAggregate(
-        "preserve-aggregate", cl::desc("Specify input file format:"),
+        "preserve-aggregate",
+        cl::desc("Specify which aggregate values LowerTypes preserves:"),
         llvm::cl::values(clEnumValN(circt::firrtl::PreserveAggregate::None,
                                     "none", "Preserve no aggregate"),
                          clEnumValN(circt::firrtl::PreserveAggregate::OneDimVec,
@@ -227,6 +245,12 @@ static cl::opt<bool>
                        cl::desc("Ignore the @info locations in the .fir file"),
                        cl::init(false), cl::cat(mainCategory));
 
+static cl::opt<bool> parseHierarchyOnly(
+    "parse-hierarchy-only",
+    cl::desc("Only parse the ports and instances of the modules in the .fir "
+             "file and print the result (implies --parse-only)"),
+    cl::init(false), cl::cat(mainCategory));
+
 static cl::opt<bool>
     disableLowerChirrtl("disable-lower-chirrtl",
                         cl::desc("Disable the LowerCHIRRTL pass"),
@@ -269,6 +293,17 @@ static cl::opt<bool>
                             cl::desc("Disable the ExtractInstances pass"),
                             cl::init(false), cl::Hidden, cl::cat(mainCategory));
 
+static cl::opt<std::string> profileCanonicalize(
+    "profile-canonicalize",
+    cl::desc("Count the attempts, rewrites and time of every canonicalization "
+             "pattern, and write a report to this file, or '-' for stderr"),
+    cl::value_desc("filename"), cl::Hidden, cl::cat(mainCategory));
+
+static cl::opt<bool> batchExtractInstances(
+    "batch-extract-instances",
+    cl::desc("Move all instances extracted from the same module together"),
+    cl::init(false), cl::Hidden, cl::cat(mainCategory));
+
 static cl::opt<bool>
     disableMemToRegOfVec("disable-mem-to-reg-of-vec",
                          cl::desc("Disable the MemToRegOfVec pass"),
@@ -313,6 +348,12 @@ static cl::opt<bool>
                                  cl::desc("Merge connections aggressively"),
                                  cl::init(false), cl::cat(mainCategory));
 
+static cl::opt<bool> fuseMergeConnections(
+    "fuse-merge-connections",
+    cl::desc("Merge connections in ExpandWhens rather than in a separate "
+             "pass late in the pipeline"),
+    cl::init(false), cl::cat(mainCategory));
+
 /// Enable the pass to merge the read and write ports of a memory, if their
 /// enable conditions are mutually exclusive.
 static cl::opt<bool> disableInferRW("disable-infer-rw",
@@ -360,6 +401,31 @@ static cl::opt<std::string>
     hgdbDebugFile("hgdb", cl::desc("file name for hgdb debugger file"),
                   cl::init(""));
 
+static cl::opt<circt::debug::HGDBOutputFormat::Format> hgdbDebugFormat(
+    "hgdb-format", cl::desc("Specify hgdb debugger file format:"),
+    cl::values(clEnumValN(circt::debug::HGDBOutputFormat::JSON, "json",
+                          "JSON debug table"),
+               clEnumValN(circt::debug::HGDBOutputFormat::SQL, "sql",
+                          "SQL script for the indexed hgdb symbol table")),
+    cl::init(circt::debug::HGDBOutputFormat::JSON), cl::cat(mainCategory));
+
+static cl::opt<std::string> hgdbDebugCache(
+    "hgdb-cache",
+    cl::desc("Cache file used to only regenerate the hgdb debug table of "
+             "modules that changed"),
+    cl::init(""), cl::cat(mainCategory));
+
+static cl::opt<bool> hgdbConditionCode(
+    "hgdb-condition-code",
+    cl::desc("Also emit hgdb breakpoint conditions as postfix bytecode"),
+    cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<bool> hgdbStripDebugInfo(
+    "hgdb-strip-debug-info",
+    cl::desc("Drop locations and hw.debug attributes while exporting the hgdb "
+             "debug table, instead of keeping them in the final IR"),
+    cl::init(false), cl::cat(mainCategory));
+
 enum OutputFormatKind {
   OutputParseOnly,
   OutputIRFir,
@@ -394,6 +460,12 @@ static cl::opt<bool>
                  cl::desc("Run the verifier after each transformation pass"),
                  cl::init(true), cl::cat(mainCategory));
 
+static cl::opt<bool> verifyChanged(
+    "verify-changed",
+    cl::desc("With --verify-each, only verify the modules a pass changed, in "
+             "parallel"),
+    cl::init(false), cl::cat(mainCategory));
+
 static cl::list<std::string> inputAnnotationFilenames(
     "annotation-file", cl::desc("Optional input annotation file"),
     cl::CommaSeparated, cl::value_desc("filename"), cl::cat(mainCategory));
@@ -422,6 +494,18 @@ static cl::opt<bool>
                  cl::desc("Emit bytecode when generating MLIR output"),
                  cl::init(false), cl::cat(mainCategory));
 
+static cl::opt<std::string> parseCacheDir(
+    "fir-parse-cache",
+    cl::desc("Directory to cache the parsed FIRRTL IR in as MLIR bytecode, "
+             "keyed on the contents of the .fir and annotation files"),
+    cl::value_desc("directory"), cl::init(""), cl::cat(mainCategory));
+
+static cl::opt<std::string> stageCacheDir(
+    "stage-cache",
+    cl::desc("Directory to cache the IR after LowerToHW in as MLIR bytecode, "
+             "keyed on the input and the options that affect it"),
+    cl::value_desc("directory"), cl::init(""), cl::cat(mainCategory));
+
 static cl::opt<bool> force("f", cl::desc("Enable binary output on terminals"),
                            cl::init(false), cl::cat(mainCategory));
 
@@ -435,6 +519,30 @@ static cl::opt<bool>
                           cl::desc("Log executions of toplevel module passes"),
                           cl::init(false), cl::cat(mainCategory));
 
+static cl::opt<bool> lowMemory(
+    "low-memory",
+    cl::desc("Lower module bodies to HW one at a time and release the FIRRTL "
+             "IR as early as possible, at the cost of parallelism"),
+    cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<uint64_t> maxMemory(
+    "max-memory",
+    cl::desc("Advisory heap limit in MiB; parallel lowering falls back to one "
+             "module at a time when close to it"),
+    cl::value_desc("MiB"), cl::init(0), cl::cat(mainCategory));
+
+static cl::opt<std::string> passResourceReport(
+    "pass-memory-report",
+    cl::desc("Write the memory use, CPU time and IR size before and after "
+             "each toplevel module pass to this file as JSON"),
+    cl::value_desc("filename"), cl::init(""), cl::cat(mainCategory));
+
+static cl::opt<std::string> taskTrace(
+    "task-trace",
+    cl::desc("Write when the per-module tasks of parallel passes start and "
+             "stop on each thread to this file, in the Chrome trace format"),
+    cl::value_desc("filename"), cl::init(""), cl::cat(mainCategory));
+
 static cl::opt<bool> stripFirDebugInfo(
     "strip-fir-debug-info",
     cl::desc("Disable source fir locator information in output Verilog"),
@@ -468,11 +576,69 @@ static cl::opt<BuildMode> buildMode(
 static LoweringOptionsOption loweringOptions(mainCategory);
 
 /// Create a simple canonicalizer pass.
-static std::unique_ptr<Pass> createSimpleCanonicalizerPass() {
-  mlir::GreedyRewriteConfig config;
-  config.useTopDownTraversal = true;
-  config.enableRegionSimplification = false;
-  return mlir::createCanonicalizerPass(config);
+/// Gather the options of the pass pipeline from the command line.
+static firtool::FirtoolOptions getFirtoolOptions() {
+  firtool::FirtoolOptions opt;
+  opt.disableAnnotationsUnknown = disableAnnotationsUnknown;
+  opt.disableAnnotationsClassless = disableAnnotationsClassless;
+  opt.disableOptimization = disableOptimization;
+  opt.preserveMode = preserveMode;
+  opt.dedup = dedup;
+  opt.mergeConnectionsAggressively = mergeConnectionsAgggresively;
+  opt.fuseMergeConnections = fuseMergeConnections;
+  opt.preserveAggregate = preserveAggregate;
+  opt.preservePublicTypes = preservePublicTypes;
+  opt.insertDebugInfo = !hgdbDebugFile.empty();
+  opt.replSeqMem = replSeqMem;
+  opt.replSeqMemCircuit = replSeqMemCircuit;
+  opt.replSeqMemFile = replSeqMemFile;
+  opt.ignoreReadEnableMem = ignoreReadEnableMem;
+  opt.lowerMemories = lowerMemories;
+  opt.addVivadoRAMAddressConflictSynthesisBugWorkaround =
+      addVivadoRAMAddressConflictSynthesisBugWorkaround;
+  opt.disableMemRandomization = !isRandomEnabled(RandomKind::Mem);
+  opt.disableRegRandomization = !isRandomEnabled(RandomKind::Reg);
+  opt.emitMetadata = emitMetadata;
+  opt.emitOMIR = emitOMIR;
+  opt.omirOutFile = omirOutFile;
+  opt.exportChiselInterface = exportChiselInterface;
+  opt.chiselInterfaceOutDirectory = chiselInterfaceOutDirectory;
+  opt.outputAnnotationFilename = outputAnnotationFilename;
+  opt.outputFilename = outputFilename;
+  opt.blackBoxRootPath = blackBoxRootPath;
+  opt.enableAnnotationWarning = enableAnnotationWarning;
+  opt.emitChiselAssertsAsSVA = emitChiselAssertsAsSVA;
+  opt.stripMuxPragmas = stripMuxPragmas;
+  opt.lowMemory = lowMemory;
+  opt.maxMemory = maxMemory;
+  opt.extractTestCode = extractTestCode;
+  opt.etcDisableInstanceExtraction = etcDisableInstanceExtraction;
+  opt.etcDisableModuleInlining = etcDisableModuleInlining;
+  opt.stripFirDebugInfo = stripFirDebugInfo;
+  opt.stripDebugInfo = stripDebugInfo;
+  opt.disableInliner = disableInliner;
+  opt.disableIMCP = disableIMCP;
+  opt.disableIMDCE = disableIMDCE;
+  opt.disableLowerMemory = disableLowerMemory;
+  opt.disableLowerTypes = disableLowerTypes;
+  opt.disableExpandWhens = disableExpandWhens;
+  opt.disableAddSeqMemPorts = disableAddSeqMemPorts;
+  opt.disableLowerChirrtl = disableLowerChirrtl;
+  opt.disableWireDFT = disableWireDFT;
+  opt.disableInferWidths = disableInferWidths;
+  opt.disableInferResets = disableInferResets;
+  opt.disableInjectDutHierarchy = disableInjectDutHierarchy;
+  opt.disableExtractInstances = disableExtractInstances;
+  opt.batchExtractInstances = batchExtractInstances;
+  if (!profileCanonicalize.empty())
+    opt.canonicalizerProfile = createCanonicalizerProfile(profileCanonicalize);
+  opt.disableMemToRegOfVec = disableMemToRegOfVec;
+  opt.disablePrefixModules = disablePrefixModules;
+  opt.disableGrandCentral = disableGrandCentral;
+  opt.disableCheckCombCycles = disableCheckCombCycles;
+  opt.disableMergeConnections = disableMergeConnections;
+  opt.disableInferRW = disableInferRW;
+  return opt;
 }
 
 // This class prints logs before and after of pass executions. This
@@ -515,6 +681,312 @@ public:
   }
 };
 
+/// Verifies the IR after each pass like the verifier of the pass manager, but
+/// skips the modules a pass did not change. Whether a module changed is
+/// determined by a fingerprint of its operations, their attributes, operands
+/// and result types, which is much cheaper to compute than verifying it.
+///
+/// Passes on the circuit or the MLIR module verify the top-level operations
+/// themselves without their bodies, and every changed module in parallel.
+/// Passes nested on a module verify that module if they changed it.
+class FirtoolVerifierInstrumentation : public mlir::PassInstrumentation {
+  using Fingerprints = DenseMap<Operation *, llvm::hash_code>;
+
+  /// The fingerprints taken before the passes currently running. Nested passes
+  /// run in parallel on different modules.
+  std::mutex mutex;
+  DenseMap<std::pair<Pass *, Operation *>, Fingerprints> running;
+
+  static bool isContainer(Operation *op) {
+    return isa<firrtl::CircuitOp, mlir::ModuleOp>(op);
+  }
+
+  /// Collect the operations verified separately after a pass on `op`.
+  static void collectUnits(Operation *op, SmallVectorImpl<Operation *> &units) {
+    if (!isContainer(op)) {
+      units.push_back(op);
+      return;
+    }
+    for (auto &region : op->getRegions())
+      for (auto &block : region)
+        for (auto &child : block) {
+          if (isContainer(&child))
+            collectUnits(&child, units);
+          else
+            units.push_back(&child);
+        }
+  }
+
+  static llvm::hash_code fingerprint(Operation *root) {
+    llvm::hash_code hash = 0;
+    root->walk([&](Operation *op) {
+      hash = llvm::hash_combine(hash, op, op->getName().getAsOpaquePointer(),
+                                op->getAttrDictionary());
+      for (auto operand : op->getOperands())
+        hash = llvm::hash_combine(hash, operand);
+      for (auto type : op->getResultTypes())
+        hash = llvm::hash_combine(hash, type);
+      for (auto *successor : op->getSuccessors())
+        hash = llvm::hash_combine(hash, successor);
+      for (auto &region : op->getRegions())
+        for (auto &block : region)
+          for (auto arg : block.getArguments())
+            hash = llvm::hash_combine(hash, arg.getType());
+    });
+    return hash;
+  }
+
+  static Fingerprints takeFingerprints(Operation *op) {
+    SmallVector<Operation *> units;
+    collectUnits(op, units);
+    SmallVector<llvm::hash_code> hashes(units.size());
+    mlir::parallelFor(op->getContext(), 0, units.size(),
+                      [&](size_t i) { hashes[i] = fingerprint(units[i]); });
+    Fingerprints fingerprints;
+    for (size_t i = 0, e = units.size(); i != e; ++i)
+      fingerprints.insert({units[i], hashes[i]});
+    return fingerprints;
+  }
+
+  /// Pass adaptors, which run nested pipelines, have no argument. Their nested
+  /// passes are verified on their own.
+  static bool isAdaptor(Pass *pass) { return pass->getArgument().empty(); }
+
+public:
+  void runBeforePass(Pass *pass, Operation *op) override {
+    if (isAdaptor(pass))
+      return;
+    auto fingerprints = takeFingerprints(op);
+    std::lock_guard<std::mutex> lock(mutex);
+    running[{pass, op}] = std::move(fingerprints);
+  }
+
+  void runAfterPass(Pass *pass, Operation *op) override {
+    if (isAdaptor(pass))
+      return;
+    Fingerprints before;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = running.find({pass, op});
+      before = std::move(it->second);
+      running.erase(it);
+    }
+
+    // Verify the containers themselves, but not their bodies.
+    SmallVector<Operation *> containers;
+    if (isContainer(op))
+      op->walk<WalkOrder::PreOrder>([&](Operation *nested) {
+        if (!isContainer(nested))
+          return WalkResult::skip();
+        containers.push_back(nested);
+        return WalkResult::advance();
+      });
+    bool anyFailed = llvm::any_of(containers, [](Operation *container) {
+      return failed(mlir::verify(container, /*verifyRecursively=*/false));
+    });
+
+    // Verify the units which are new or changed.
+    SmallVector<Operation *> changed;
+    for (auto &after : takeFingerprints(op)) {
+      auto it = before.find(after.first);
+      if (it == before.end() || it->second != after.second)
+        changed.push_back(after.first);
+    }
+    anyFailed |= failed(mlir::failableParallelForEach(
+        op->getContext(), changed,
+        [](Operation *unit) { return mlir::verify(unit); }));
+
+    if (anyFailed)
+      llvm::report_fatal_error(
+          "verification failed after " + pass->getArgument() +
+          "; the diagnostics above describe the invalid operations");
+  }
+
+  void runAfterPassFailed(Pass *pass, Operation *op) override {
+    if (isAdaptor(pass))
+      return;
+    std::lock_guard<std::mutex> lock(mutex);
+    running.erase({pass, op});
+  }
+};
+
+/// A snapshot of the resource use of the process and of the size of the IR.
+/// Memory figures the platform does not provide are zero.
+struct ResourceSample {
+  uint64_t numOps = 0;
+  uint64_t numAttrs = 0;
+  uint64_t numTypes = 0;
+  uint64_t rss = 0;
+  uint64_t peakRSS = 0;
+  uint64_t heap = 0;
+  llvm::sys::TimePoint<> wallTime;
+  std::chrono::nanoseconds cpuTime;
+};
+
+/// The resource use around one execution of a pass.
+struct PassResourceRecord {
+  std::string pass;
+  unsigned depth;
+  ResourceSample before;
+  ResourceSample after;
+};
+
+/// Return the current resident set size of the process in bytes.
+static uint64_t getCurrentRSS() {
+#ifdef __linux__
+  // The second field of statm is the number of resident pages.
+  auto buffer = llvm::MemoryBuffer::getFileAsStream("/proc/self/statm");
+  if (buffer) {
+    StringRef resident = (*buffer)->getBuffer().split(' ').second;
+    uint64_t pages;
+    if (!resident.split(' ').first.getAsInteger(10, pages))
+      return pages * llvm::sys::Process::getPageSizeEstimate();
+  }
+#endif
+  return 0;
+}
+
+/// Return the peak resident set size of the process in bytes.
+static uint64_t getPeakRSS() {
+#if LLVM_ON_UNIX
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return usage.ru_maxrss * 1024;
+#endif
+  }
+#endif
+  return 0;
+}
+
+/// Sample the resource use of the process and the size of the IR in `op`.
+/// Attributes and types are counted once per distinct uniqued value that is
+/// attached to an operation or used as the type of a value, which tracks how
+/// many values a pass had to intern.
+static ResourceSample sampleResources(Operation *op) {
+  ResourceSample sample;
+  DenseSet<Attribute> attrs;
+  DenseSet<Type> types;
+  op->walk([&](Operation *op) {
+    ++sample.numOps;
+    for (auto attr : op->getAttrs())
+      attrs.insert(attr.getValue());
+    types.insert(op->result_type_begin(), op->result_type_end());
+    for (auto &region : op->getRegions())
+      for (auto &block : region)
+        for (auto arg : block.getArguments())
+          types.insert(arg.getType());
+  });
+  sample.numAttrs = attrs.size();
+  sample.numTypes = types.size();
+  sample.rss = getCurrentRSS();
+  sample.peakRSS = getPeakRSS();
+  sample.heap = llvm::sys::Process::GetMallocUsage();
+
+  // Sample the clocks last, such that the IR walk is not attributed to the
+  // pass.
+  std::chrono::nanoseconds userTime, sysTime;
+  llvm::sys::Process::GetTimeUsage(sample.wallTime, userTime, sysTime);
+  sample.cpuTime = userTime + sysTime;
+  return sample;
+}
+
+// This class records the resource use of the process and the size of the IR
+// before and after pass executions. Like
+// FirtoolPassInstrumentation, it assumes that passes are not parallelized for
+// firrtl::CircuitOp and mlir::ModuleOp.
+class FirtoolResourceInstrumentation : public mlir::PassInstrumentation {
+  std::vector<PassResourceRecord> &records;
+  // This stores the records of the passes currently running.
+  llvm::SmallVector<size_t> running;
+
+public:
+  explicit FirtoolResourceInstrumentation(
+      std::vector<PassResourceRecord> &records)
+      : records(records) {}
+
+  void runBeforePass(Pass *pass, Operation *op) override {
+    if (!isa<firrtl::CircuitOp, mlir::ModuleOp>(op))
+      return;
+    PassResourceRecord record;
+    llvm::raw_string_ostream os(record.pass);
+    pass->printAsTextualPipeline(os);
+    os.flush();
+    record.depth = running.size();
+    record.before = sampleResources(op);
+    running.push_back(records.size());
+    records.push_back(std::move(record));
+  }
+
+  void runAfterPass(Pass *pass, Operation *op) override {
+    if (isa<firrtl::CircuitOp, mlir::ModuleOp>(op))
+      records[running.pop_back_val()].after = sampleResources(op);
+  }
+
+  void runAfterPassFailed(Pass *pass, Operation *op) override {
+    runAfterPass(pass, op);
+  }
+};
+
+/// Write the records of FirtoolResourceInstrumentation to the file given by
+/// `--pass-memory-report`.
+static void writePassResourceReport(ArrayRef<PassResourceRecord> records) {
+  std::string error;
+  auto output = openOutputFile(passResourceReport, &error);
+  if (!output) {
+    llvm::errs() << error;
+    return;
+  }
+
+  llvm::json::OStream json(output->os(), /*IndentSize=*/2);
+  auto writeSample = [&](StringRef key, const ResourceSample &sample) {
+    json.attributeObject(key, [&] {
+      json.attribute("ops", int64_t(sample.numOps));
+      json.attribute("attrs", int64_t(sample.numAttrs));
+      json.attribute("types", int64_t(sample.numTypes));
+      json.attribute("rss", int64_t(sample.rss));
+      json.attribute("peak_rss", int64_t(sample.peakRSS));
+      json.attribute("heap", int64_t(sample.heap));
+    });
+  };
+  json.array([&] {
+    for (auto &record : records) {
+      json.object([&] {
+        json.attribute("pass", record.pass);
+        json.attribute("depth", int64_t(record.depth));
+        writeSample("before", record.before);
+        writeSample("after", record.after);
+        // The CPU time of all threads over the wall time of the pass. Parallel
+        // passes that fall well short of the number of threads are waiting,
+        // for example on the locks of the context's uniquers.
+        auto wallTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            record.after.wallTime - record.before.wallTime);
+        auto cpuTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            record.after.cpuTime - record.before.cpuTime);
+        json.attribute("wall_us", int64_t(wallTime.count()));
+        json.attribute("cpu_us", int64_t(cpuTime.count()));
+        if (wallTime.count() > 0)
+          json.attribute("parallelism",
+                         double(cpuTime.count()) / double(wallTime.count()));
+        json.attribute("ops_delta", int64_t(record.after.numOps) -
+                                        int64_t(record.before.numOps));
+        json.attribute("attrs_delta", int64_t(record.after.numAttrs) -
+                                          int64_t(record.before.numAttrs));
+        json.attribute("types_delta", int64_t(record.after.numTypes) -
+                                          int64_t(record.before.numTypes));
+        json.attribute("rss_delta",
+                       int64_t(record.after.rss) - int64_t(record.before.rss));
+        json.attribute("peak_rss_delta", int64_t(record.after.peakRSS) -
+                                             int64_t(record.before.peakRSS));
+      });
+    }
+  });
+  output->os() << '\n';
+  output->keep();
+}
+
 /// Check output stream before writing bytecode to it.
 /// Warn and return true if output is known to be displayed.
 static bool checkBytecodeOutputToConsole(raw_ostream &os) {
@@ -537,6 +1009,124 @@ static void printOp(Operation *op, raw_ostream &os) {
     op->print(os);
 }
 
+/// Return the path of the parse cache entry for the buffers in `sourceMgr`: the
+/// .fir file followed by its annotation and OMIR files.  The key also covers
+/// the parser options and the tool version, since both change the parsed IR.
+static std::string getParseCachePath(llvm::SourceMgr &sourceMgr,
+                                     const firrtl::FIRParserOptions &options) {
+  llvm::SHA256 sha;
+  std::string header;
+  llvm::raw_string_ostream os(header);
+  os << getCirctVersion() << '\n'
+     << "ignore-info-locators=" << options.ignoreInfoLocators << '\n'
+     << "hierarchy-only=" << options.hierarchyOnly << '\n'
+     << "annotation-files=" << options.numAnnotationFiles << '\n';
+  for (unsigned i = 1, e = sourceMgr.getNumBuffers(); i <= e; ++i)
+    os << "buffer=" << sourceMgr.getMemoryBuffer(i)->getBufferSize() << '\n';
+  sha.update(os.str());
+  for (unsigned i = 1, e = sourceMgr.getNumBuffers(); i <= e; ++i)
+    sha.update(sourceMgr.getMemoryBuffer(i)->getBuffer());
+
+  SmallString<128> path(parseCacheDir);
+  llvm::sys::path::append(
+      path, llvm::toHex(sha.final(), /*LowerCase=*/true) + ".mlirbc");
+  return std::string(path);
+}
+
+/// The command line arguments that can affect the IR after LowerToHW, which
+/// are part of the stage cache key.  Populated in `main`.
+static std::vector<std::string> stageCacheArgs;
+
+/// Options that only affect the passes after LowerToHW or the output, and are
+/// therefore left out of the stage cache key.
+static bool isLateStageOption(StringRef arg) {
+  static const StringRef lateStageOptions[] = {
+      "lowering-options",
+      "ir-hw",
+      "ir-sv",
+      "ir-verilog",
+      "verilog",
+      "split-verilog",
+      "disable-output",
+      "output-final-mlir",
+      "emit-bytecode",
+      "f",
+      "strip-debug-info",
+      "strip-fir-debug-info",
+      "extract-test-code",
+      "etc-disable-instance-extraction",
+      "etc-disable-module-inlining",
+      "add-vivado-ram-address-conflict-synthesis-bug-workaround",
+      "verbose-pass-executions",
+      "fir-parse-cache",
+      "stage-cache",
+      "pass-memory-report",
+      "task-trace"};
+  if (!arg.consume_front("-"))
+    return false;
+  arg.consume_front("-");
+  arg = arg.take_until([](char c) { return c == '='; });
+  return llvm::is_contained(lateStageOptions, arg) ||
+         arg.startswith("mlir-timing");
+}
+
+/// Return the path of the stage cache entry for the buffers in `sourceMgr`.
+/// Like the parse cache key, it covers the tool version and the input buffers,
+/// and additionally the command line arguments in `stageCacheArgs`.  Files
+/// read by the passes themselves, such as black box sources, are not covered.
+static std::string getStageCachePath(llvm::SourceMgr &sourceMgr) {
+  llvm::SHA256 sha;
+  std::string header;
+  llvm::raw_string_ostream os(header);
+  os << getCirctVersion() << '\n';
+  for (auto &arg : stageCacheArgs)
+    os << "arg=" << arg.size() << ':' << arg << '\n';
+  for (unsigned i = 1, e = sourceMgr.getNumBuffers(); i <= e; ++i)
+    os << "buffer=" << sourceMgr.getMemoryBuffer(i)->getBufferSize() << '\n';
+  sha.update(os.str());
+  for (unsigned i = 1, e = sourceMgr.getNumBuffers(); i <= e; ++i)
+    sha.update(sourceMgr.getMemoryBuffer(i)->getBuffer());
+
+  SmallString<128> path(stageCacheDir);
+  llvm::sys::path::append(
+      path, llvm::toHex(sha.final(), /*LowerCase=*/true) + ".mlirbc");
+  return std::string(path);
+}
+
+/// Load a previously cached parse or stage.  A missing or unreadable entry is
+/// not an error, the caller simply recomputes the IR.
+static OwningOpRef<ModuleOp> readBytecodeCache(StringRef path,
+                                               MLIRContext &context) {
+  if (!llvm::sys::fs::exists(path))
+    return {};
+  ScopedDiagnosticHandler handler(&context,
+                                  [](Diagnostic &) { return success(); });
+  return parseSourceFile<ModuleOp>(path, &context);
+}
+
+/// Store the IR in a cache.  The bytecode is written to a temporary file first,
+/// so that concurrent runs never see a partially written entry.
+static void writeBytecodeCache(StringRef path, ModuleOp module) {
+  auto error =
+      llvm::sys::fs::create_directories(llvm::sys::path::parent_path(path));
+  int fd;
+  SmallString<128> tempPath;
+  if (!error)
+    error = llvm::sys::fs::createUniqueFile(path + ".tmp-%%%%%%", fd, tempPath);
+  if (error) {
+    llvm::errs() << "cannot write cache '" << path
+                 << "': " << error.message() << "\n";
+    return;
+  }
+  {
+    llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+    writeBytecodeToFile(module, os,
+                        mlir::BytecodeWriterConfig(getCirctVersion()));
+  }
+  if (llvm::sys::fs::rename(tempPath, path))
+    llvm::sys::fs::remove(tempPath);
+}
+
 /// Process a single buffer of the input.
 static LogicalResult
 processBuffer(MLIRContext &context, TimingScope &ts, llvm::SourceMgr &sourceMgr,
@@ -564,49 +1154,116 @@ processBuffer(MLIRContext &context, TimingScope &ts, llvm::SourceMgr &sourceMgr,
     }
   }
 
-  // Parse the input.
+  // Resume from the IR after LowerToHW if an earlier run with the same input
+  // and options cached it.  This skips parsing as well.
   mlir::OwningOpRef<mlir::ModuleOp> module;
-
-  llvm::sys::TimePoint<> parseStartTime;
-  if (verbosePassExecutions) {
-    llvm::errs() << "[firtool] Running "
-                 << (inputFormat == InputFIRFile ? "fir" : "mlir")
-                 << " parser\n";
-    parseStartTime = llvm::sys::TimePoint<>::clock::now();
+  std::string stageCachePath;
+  if (!stageCacheDir.empty() && !parseHierarchyOnly &&
+      !exportChiselInterface && outputFormat != OutputParseOnly &&
+      outputFormat != OutputIRFir) {
+    auto cacheTimer = ts.nest("Stage Cache");
+    stageCachePath = getStageCachePath(sourceMgr);
+    module = readBytecodeCache(stageCachePath, context);
   }
+  bool resumed = bool(module);
 
-  if (inputFormat == InputFIRFile) {
-    auto parserTimer = ts.nest("FIR Parser");
-    firrtl::FIRParserOptions options;
-    options.ignoreInfoLocators = ignoreFIRLocations;
-    options.numAnnotationFiles = numAnnotationFiles;
-    module = importFIRFile(sourceMgr, &context, parserTimer, options);
-  } else {
-    auto parserTimer = ts.nest("MLIR Parser");
-    assert(inputFormat == InputMLIRFile);
-    module = parseSourceFile<ModuleOp>(sourceMgr, &context);
+  // Parse the input.
+  if (!resumed) {
+    llvm::sys::TimePoint<> parseStartTime;
+    if (verbosePassExecutions) {
+      llvm::errs() << "[firtool] Running "
+                   << (inputFormat == InputFIRFile ? "fir" : "mlir")
+                   << " parser\n";
+      parseStartTime = llvm::sys::TimePoint<>::clock::now();
+    }
+
+    if (inputFormat == InputFIRFile) {
+      firrtl::FIRParserOptions options;
+      options.ignoreInfoLocators = ignoreFIRLocations;
+      options.numAnnotationFiles = numAnnotationFiles;
+      options.hierarchyOnly = parseHierarchyOnly;
+
+      std::string cachePath;
+      if (!parseCacheDir.empty()) {
+        auto cacheTimer = ts.nest("FIR Parse Cache");
+        cachePath = getParseCachePath(sourceMgr, options);
+        module = readBytecodeCache(cachePath, context);
+      }
+      if (!module) {
+        auto parserTimer = ts.nest("FIR Parser");
+        module = importFIRFile(sourceMgr, &context, parserTimer, options);
+        if (module && !cachePath.empty()) {
+          auto cacheTimer = ts.nest("Write FIR Parse Cache");
+          writeBytecodeCache(cachePath, *module);
+        }
+      }
+    } else {
+      auto parserTimer = ts.nest("MLIR Parser");
+      assert(inputFormat == InputMLIRFile);
+      module = parseSourceFile<ModuleOp>(sourceMgr, &context);
+    }
+    if (!module)
+      return failure();
+
+    if (verbosePassExecutions) {
+      auto elapsed =
+          std::chrono::duration<double>(llvm::sys::TimePoint<>::clock::now() -
+                                        parseStartTime) /
+          std::chrono::seconds(1);
+      llvm::errs() << "[firtool] -- Done in " << llvm::format("%.3f", elapsed)
+                   << " sec\n";
+    }
   }
-  if (!module)
-    return failure();
 
-  if (verbosePassExecutions) {
-    auto elapsed = std::chrono::duration<double>(
-                       llvm::sys::TimePoint<>::clock::now() - parseStartTime) /
-                   std::chrono::seconds(1);
-    llvm::errs() << "[firtool] -- Done in " << llvm::format("%.3f", elapsed)
-                 << " sec\n";
+  // The module bodies are incomplete, so annotations targeting their contents
+  // cannot be lowered.  Print the hierarchy as it was parsed.
+  if (parseHierarchyOnly) {
+    auto outputTimer = ts.nest("Print .mlir output");
+    printOp(*module, outputFile.value()->os());
+    return success();
   }
 
-  // Apply any pass manager command line options.
+  // Apply any pass manager command line options.  The passes after LowerToHW
+  // run in a separate pass manager, such that the IR in between can be cached.
+  std::vector<PassResourceRecord> resourceRecords;
+  auto writeResourceReport = llvm::make_scope_exit([&] {
+    if (!passResourceReport.empty())
+      writePassResourceReport(resourceRecords);
+  });
+  if (!taskTrace.empty())
+    enableTaskTrace();
+  auto writeTrace = llvm::make_scope_exit([&] {
+    if (taskTrace.empty())
+      return;
+    std::string error;
+    auto output = openOutputFile(taskTrace, &error);
+    if (!output) {
+      llvm::errs() << error;
+      return;
+    }
+    writeTaskTrace(output->os());
+    output->keep();
+  });
   PassManager pm(&context);
-  pm.enableVerifier(verifyPasses);
-  pm.enableTiming(ts);
-  if (verbosePassExecutions)
-    pm.addInstrumentation(std::make_unique<FirtoolPassInstrumentation>());
-  applyPassManagerCLOptions(pm);
+  PassManager hwPm(&context);
+  for (auto *passManager : {&pm, &hwPm}) {
+    passManager->enableVerifier(verifyPasses && !verifyChanged);
+    if (verifyPasses && verifyChanged)
+      passManager->addInstrumentation(
+          std::make_unique<FirtoolVerifierInstrumentation>());
+    passManager->enableTiming(ts);
+    if (verbosePassExecutions)
+      passManager->addInstrumentation(
+          std::make_unique<FirtoolPassInstrumentation>());
+    if (!passResourceReport.empty())
+      passManager->addInstrumentation(
+          std::make_unique<FirtoolResourceInstrumentation>(resourceRecords));
+    applyPassManagerCLOptions(*passManager);
+  }
 
-  pm.nest<firrtl::CircuitOp>().addPass(firrtl::createLowerFIRRTLAnnotationsPass(
-      disableAnnotationsUnknown, disableAnnotationsClassless));
+  auto options = getFirtoolOptions();
+  if (failed(firtool::populatePreprocessTransforms(pm, options)))
+    return failure();
 
   // If the user asked for --parse-only, stop after running LowerAnnotations.
   if (outputFormat == OutputParseOnly) {
@@ -617,231 +1274,44 @@ processBuffer(MLIRContext &context, TimingScope &ts, llvm::SourceMgr &sourceMgr,
     return success();
   }
 
-  // TODO: Move this to the O1 pipeline.
-  pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
-      firrtl::createDropNamesPass(preserveMode));
-
-  if (!disableOptimization)
-    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
-        createCSEPass());
-
-  if (!disableInjectDutHierarchy)
-    pm.nest<firrtl::CircuitOp>().addPass(
-        firrtl::createInjectDUTHierarchyPass());
-
-  if (!disableLowerChirrtl)
-    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
-        firrtl::createLowerCHIRRTLPass());
-
-  // Width inference creates canonicalization opportunities.
-  if (!disableInferWidths)
-    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createInferWidthsPass());
-
-  if (!disableMemToRegOfVec)
-    pm.nest<firrtl::CircuitOp>().addPass(
-        firrtl::createMemToRegOfVecPass(replSeqMem, ignoreReadEnableMem));
-
-  if (!disableInferResets)
-    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createInferResetsPass());
-
-  if (exportChiselInterface) {
-    if (chiselInterfaceOutDirectory.empty()) {
-      pm.nest<firrtl::CircuitOp>().addPass(createExportChiselInterfacePass());
-    } else {
-      pm.nest<firrtl::CircuitOp>().addPass(
-          createExportSplitChiselInterfacePass(chiselInterfaceOutDirectory));
-    }
-  }
-
-  if (!disableOptimization && dedup)
-    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createDedupPass());
-
-  if (!disableWireDFT)
-    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createWireDFTPass());
-
-  if (!lowerMemories)
-    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
-        firrtl::createFlattenMemoryPass());
-
-  // The input mlir file could be firrtl dialect so we might need to clean
-  // things up.
-  if (!disableLowerTypes) {
-    pm.addNestedPass<firrtl::CircuitOp>(firrtl::createLowerFIRRTLTypesPass(
-        preserveAggregate, preservePublicTypes, !hgdbDebugFile.empty()));
-
-    // Only enable expand whens if lower types is also enabled.
-    if (!disableExpandWhens) {
-      auto &modulePM = pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>();
-      modulePM.addPass(firrtl::createExpandWhensPass());
-      modulePM.addPass(firrtl::createSFCCompatPass());
-    }
-  }
-
-  if (!disableInliner)
-    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createInlinerPass());
-
-  // Preset the random initialization parameters for each module. The current
-  // implementation assumes it can run at a time where every register is
-  // currently in the final module it will be emitted in, all registers have
-  // been created, and no registers have yet been removed.
-  if (isRandomEnabled(RandomKind::Reg))
-    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
-        firrtl::createRandomizeRegisterInitPass());
-
-  if (!disableCheckCombCycles) {
-    // TODO: Currently CheckCombCyles pass doesn't support aggregates so skip
-    // the pass for now.
-    if (preserveAggregate == firrtl::PreserveAggregate::None)
-      pm.nest<firrtl::CircuitOp>().addPass(firrtl::createCheckCombCyclesPass());
-    else
-      emitWarning(module->getLoc())
-          << "CheckCombCyclesPass doens't support aggregate "
-             "values yet so it is skipped\n";
-  }
-
-  // If we parsed a FIRRTL file and have optimizations enabled, clean it up.
-  if (!disableOptimization)
-    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
-        createSimpleCanonicalizerPass());
-
-  // Run the infer-rw pass, which merges read and write ports of a memory with
-  // mutually exclusive enables.
-  if (!disableInferRW)
-    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
-        firrtl::createInferReadWritePass());
-
-  if (replSeqMem && !disableLowerMemory)
-    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createLowerMemoryPass());
-
-  if (!disablePrefixModules)
-    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createPrefixModulesPass());
-
-  if (!disableIMCP && !disableOptimization)
-    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createIMConstPropPass());
-
-  if (!disableAddSeqMemPorts)
-    pm.addNestedPass<firrtl::CircuitOp>(firrtl::createAddSeqMemPortsPass());
-
-  if (emitMetadata)
-    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createCreateSiFiveMetadataPass(
-        replSeqMem, replSeqMemCircuit, replSeqMemFile));
-
-  if (!disableExtractInstances)
-    pm.addNestedPass<firrtl::CircuitOp>(firrtl::createExtractInstancesPass());
-
-  // Run passes to resolve Grand Central features.  This should run before
-  // BlackBoxReader because Grand Central needs to inform BlackBoxReader where
-  // certain black boxes should be placed.
-  if (!disableGrandCentral) {
-    auto &circuitPM = pm.nest<firrtl::CircuitOp>();
-    circuitPM.addPass(firrtl::createGrandCentralPass());
-    circuitPM.addPass(firrtl::createGrandCentralTapsPass());
-    circuitPM.addPass(
-        firrtl::createGrandCentralSignalMappingsPass(outputFilename));
-  }
-
-  // Run SymbolDCE after GC for hierpathop's and just for general cleanup.
-  pm.addNestedPass<firrtl::CircuitOp>(mlir::createSymbolDCEPass());
-
-  // Read black box source files into the IR.
-  StringRef blackBoxRoot = blackBoxRootPath.empty()
-                               ? llvm::sys::path::parent_path(inputFilename)
-                               : blackBoxRootPath;
-  pm.nest<firrtl::CircuitOp>().addPass(
-      firrtl::createBlackBoxReaderPass(blackBoxRoot));
-
-  pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
-      firrtl::createDropNamesPass(preserveMode));
-
-  // Run InnerSymbolDCE as late as possible, but before IMDCE.
-  pm.addPass(firrtl::createInnerSymbolDCEPass());
-
-  // The above passes, IMConstProp in particular, introduce additional
-  // canonicalization opportunities that we should pick up here before we
-  // proceed to output-specific pipelines.
-  if (!disableOptimization) {
-    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
-        createSimpleCanonicalizerPass());
-    if (!disableIMDCE)
-      pm.nest<firrtl::CircuitOp>().addPass(firrtl::createIMDeadCodeElimPass());
-  }
-
-  if (emitOMIR)
-    pm.nest<firrtl::CircuitOp>().addPass(
-        firrtl::createEmitOMIRPass(omirOutFile));
-
-  if (!disableOptimization &&
-      preserveAggregate != firrtl::PreserveAggregate::None &&
-      !disableMergeConnections)
-    pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
-        firrtl::createMergeConnectionsPass(mergeConnectionsAgggresively));
+  if (failed(firtool::populateCHIRRTLToLowFIRRTL(pm, options, *module,
+                                                 inputFilename)))
+    return failure();
 
   // Lower if we are going to verilog or if lowering was specifically requested.
   if (outputFormat != OutputIRFir) {
-
-    // Remove TraceAnnotations and write their updated paths to an output
-    // annotation file.
-    if (outputAnnotationFilename.empty())
-      pm.nest<firrtl::CircuitOp>().addPass(firrtl::createResolveTracesPass());
-    else
-      pm.nest<firrtl::CircuitOp>().addPass(
-          firrtl::createResolveTracesPass(outputAnnotationFilename.getValue()));
-
-    // Lower the ref.resolve and ref.send ops and remove the RefType ports.
-    // LowerToHW cannot handle RefType so, this pass must be run to remove all
-    // RefType ports and ops.
-    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createLowerXMRPass());
-
-    pm.addPass(createLowerFIRRTLToHWPass(
-        enableAnnotationWarning.getValue(), emitChiselAssertsAsSVA.getValue(),
-        stripMuxPragmas.getValue(), !isRandomEnabled(RandomKind::Mem),
-        !isRandomEnabled(RandomKind::Reg)));
+    if (failed(firtool::populateLowFIRRTLToHW(pm, options)))
+      return failure();
 
     if (outputFormat == OutputIRHW) {
       if (!disableOptimization) {
-        auto &modulePM = pm.nest<hw::HWModuleOp>();
+        auto &modulePM = hwPm.nest<hw::HWModuleOp>();
         modulePM.addPass(createCSEPass());
-        modulePM.addPass(createSimpleCanonicalizerPass());
+        modulePM.addPass(firtool::createSimpleCanonicalizerPass(
+            options.canonicalizerProfile));
       }
     } else {
-      // If enabled, run the optimizer.
-      if (!disableOptimization) {
-        auto &modulePM = pm.nest<hw::HWModuleOp>();
-        modulePM.addPass(createCSEPass());
-        modulePM.addPass(createSimpleCanonicalizerPass());
-        modulePM.addPass(createCSEPass());
-      }
-
-      pm.nest<hw::HWModuleOp>().addPass(seq::createSeqFIRRTLLowerToSVPass(
-          {/*disableRandomization=*/!isRandomEnabled(RandomKind::Reg),
-           /*addVivadoRAMAddressConflictSynthesisBugWorkaround=*/
-           addVivadoRAMAddressConflictSynthesisBugWorkaround}));
-      pm.addPass(sv::createHWMemSimImplPass(
-          replSeqMem, ignoreReadEnableMem, stripMuxPragmas,
-          !isRandomEnabled(RandomKind::Mem), !isRandomEnabled(RandomKind::Reg),
-          addVivadoRAMAddressConflictSynthesisBugWorkaround));
-
-      if (extractTestCode)
-        pm.addPass(sv::createSVExtractTestCodePass(etcDisableInstanceExtraction,
-                                                   etcDisableModuleInlining));
+      if (failed(firtool::populateHWToSV(hwPm, options)))
+        return failure();
+    }
+  }
 
-      // If enabled, run the optimizer.
-      if (!disableOptimization) {
-        auto &modulePM = pm.nest<hw::HWModuleOp>();
-        modulePM.addPass(createCSEPass());
-        modulePM.addPass(createSimpleCanonicalizerPass());
-        modulePM.addPass(createCSEPass());
-        modulePM.addPass(sv::createHWCleanupPass());
-      }
+  if (!resumed) {
+    if (failed(pm.run(module.get())))
+      return failure();
+    if (!stageCachePath.empty()) {
+      auto cacheTimer = ts.nest("Write Stage Cache");
+      writeBytecodeCache(stageCachePath, *module);
     }
   }
 
   // Load the emitter options from the command line. Command line options if
-  // specified will override any module options.
+  // specified will override any module options.  This happens after caching,
+  // since the lowering options are not part of the stage cache key.
   if (loweringOptions.getNumOccurrences())
     loweringOptions.setAsAttribute(module.get());
 
-  if (failed(pm.run(module.get())))
+  if (failed(hwPm.run(module.get())))
     return failure();
 
   // Add passes specific to Verilog emission if we're going there.
@@ -853,54 +1323,46 @@ processBuffer(MLIRContext &context, TimingScope &ts, llvm::SourceMgr &sourceMgr,
     if (verbosePassExecutions)
       exportPm.addInstrumentation(
           std::make_unique<FirtoolPassInstrumentation>());
-    // Legalize unsupported operations within the modules.
-    exportPm.nest<hw::HWModuleOp>().addPass(sv::createHWLegalizeModulesPass());
-
-    // Tidy up the IR to improve verilog emission quality.
-    if (!disableOptimization) {
-      auto &modulePM = exportPm.nest<hw::HWModuleOp>();
-      modulePM.addPass(sv::createPrettifyVerilogPass());
-    }
-
-    if (stripFirDebugInfo)
-      exportPm.addPass(
-          circt::createStripDebugInfoWithPredPass([](mlir::Location loc) {
-            if (auto fileLoc = loc.dyn_cast<FileLineColLoc>())
-              return fileLoc.getFilename().getValue().endswith(".fir");
-            return false;
-          }));
-
-    if (stripDebugInfo)
-      exportPm.addPass(mlir::createStripDebugInfoPass());
+    if (!passResourceReport.empty())
+      exportPm.addInstrumentation(
+          std::make_unique<FirtoolResourceInstrumentation>(resourceRecords));
 
     // Emit a single file or multiple files depending on the output format.
+    LogicalResult populated = failure();
     switch (outputFormat) {
     default:
       llvm_unreachable("can't reach this");
     case OutputVerilog:
-      exportPm.addPass(createExportVerilogPass(outputFile.value()->os()));
+      populated = firtool::populateExportVerilog(exportPm, options,
+                                                 outputFile.value()->os());
       break;
     case OutputSplitVerilog:
-      exportPm.addPass(createExportSplitVerilogPass(outputFilename));
+      populated = firtool::populateExportSplitVerilog(exportPm, options,
+                                                      outputFilename);
       break;
     case OutputIRVerilog:
       // Run the ExportVerilog pass to get its lowering, but discard the output.
-      exportPm.addPass(createExportVerilogPass(llvm::nulls()));
+      populated =
+          firtool::populateExportVerilog(exportPm, options, llvm::nulls());
       break;
     }
+    if (failed(populated))
+      return failure();
 
     // Run module hierarchy emission after verilog emission, which ensures we
     // pick up any changes that verilog emission made.
     if (exportModuleHierarchy)
       exportPm.addPass(sv::createHWExportModuleHierarchyPass(outputFilename));
 
+    // If specified, output HGDB debug table as well. This has to run after
+    // verilog emission so that it sees the legalized names.
+    if (!hgdbDebugFile.empty())
+      exportPm.addPass(circt::debug::createExportHGDBPass(
+          hgdbDebugFile.getValue(), hgdbDebugFormat, hgdbDebugCache,
+          hgdbConditionCode, hgdbStripDebugInfo));
+
     if (failed(exportPm.run(module.get())))
       return failure();
-
-    // If specified, output HGDB debug table as well
-    if (!hgdbDebugFile.empty()) {
-      pm.addPass(circt::debug::createExportHGDBPass(hgdbDebugFile));
-    }
   }
 
   if (outputFormat == OutputIRFir || outputFormat == OutputIRHW ||
@@ -979,6 +1441,26 @@ processInput(MLIRContext &context, TimingScope &ts,
       llvm::outs());
 }
 
+/// The parsers read their input front to back, straight out of the buffer. If
+/// the input file is memory mapped, tell the kernel so it reads ahead
+/// aggressively and can evict the pages that have already been lexed.
+static void adviseSequentialRead(const llvm::MemoryBuffer &buffer) {
+#if LLVM_ON_UNIX && defined(MADV_SEQUENTIAL)
+  if (buffer.getBufferKind() != llvm::MemoryBuffer::MemoryBuffer_MMap)
+    return;
+  // madvise needs a page aligned start, but the buffer may start at an offset
+  // into the mapping
+  auto pageSize = static_cast<uintptr_t>(sys::Process::getPageSizeEstimate());
+  auto start = reinterpret_cast<uintptr_t>(buffer.getBufferStart());
+  auto end = reinterpret_cast<uintptr_t>(buffer.getBufferEnd());
+  auto alignedStart = start & ~(pageSize - 1);
+  (void)::madvise(reinterpret_cast<void *>(alignedStart), end - alignedStart,
+                  MADV_SEQUENTIAL);
+#else
+  (void)buffer;
+#endif
+}
+
 /// This implements the top-level logic for the firtool command, invoked once
 /// command line options are parsed and LLVM/MLIR are all set up and ready to
 /// go.
@@ -995,6 +1477,7 @@ static LogicalResult executeFirtool(MLIRContext &context) {
     llvm::errs() << errorMessage << "\n";
     return failure();
   }
+  adviseSequentialRead(*input);
 
   // Figure out the input format if unspecified.
   if (inputFormat == InputUnspecified) {
@@ -1096,6 +1579,11 @@ int main(int argc, char **argv) {
   // Parse pass names in main to ensure static initialization completed.
   cl::ParseCommandLineOptions(argc, argv, "MLIR-based FIRRTL compiler\n");
 
+  // Remember the arguments that make up the stage cache key.
+  for (int i = 1; i < argc; ++i)
+    if (!isLateStageOption(argv[i]))
+      stageCacheArgs.push_back(argv[i]);
+
   MLIRContext context;
 
   // Do the guts of the firtool process.
@@ -11,18 +11,34 @@
 //
 //===----------------------------------------------------------------------===//
 
-#include <list>
+#include <deque>
 
 #include "circt/Dialect/Handshake/HandshakeOps.h"
 #include "circt/Dialect/Handshake/Simulation.h"
+#include "mlir/Conversion/ArithToLLVM/ArithToLLVM.h"
+#include "mlir/Conversion/ControlFlowToLLVM/ControlFlowToLLVM.h"
+#include "mlir/Conversion/FuncToLLVM/ConvertFuncToLLVM.h"
+#include "mlir/Conversion/LLVMCommon/ConversionTarget.h"
+#include "mlir/Conversion/LLVMCommon/TypeConverter.h"
+#include "mlir/Conversion/MemRefToLLVM/MemRefToLLVM.h"
+#include "mlir/Conversion/ReconcileUnrealizedCasts/ReconcileUnrealizedCasts.h"
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/IR/AsmState.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/Transforms/DialectConversion.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetSelect.h"
 
 #define DEBUG_TYPE "runner"
 
@@ -158,18 +174,251 @@ void printAnyValueWithType(llvm::raw_ostream &out, mlir::Type type,
   }
 }
 
-void scheduleIfNeeded(std::list<mlir::Operation *> &readyList,
-                      llvm::DenseMap<mlir::Value, Any> & /*valueMap*/,
-                      mlir::Operation *op) {
-  if (std::find(readyList.begin(), readyList.end(), op) == readyList.end()) {
-    readyList.push_back(op);
+/// The operations of a handshake function which might be ready to execute, in
+/// FIFO order. An operation is queued at most once, and the consumers of every
+/// value are collected up front, so scheduling is linear in the number of
+/// users of a value.
+class ReadyList {
+public:
+  explicit ReadyList(mlir::Block &block) {
+    llvm::DenseMap<mlir::Operation *, unsigned> indices;
+    for (mlir::Operation &op : block) {
+      indices[&op] = ops.size();
+      ops.push_back(&op);
+    }
+    queued.resize(ops.size());
+
+    auto addConsumers = [&](mlir::Value value) {
+      auto &users = consumers[value];
+      for (mlir::Operation *user : value.getUsers()) {
+        assert(indices.count(user) && "expected a flat dataflow graph");
+        users.push_back(indices.lookup(user));
+      }
+    };
+    for (mlir::Value arg : block.getArguments())
+      addConsumers(arg);
+    for (mlir::Operation *op : ops)
+      for (mlir::Value result : op->getResults())
+        addConsumers(result);
   }
+
+  bool empty() const { return queue.empty(); }
+  mlir::Operation *getOp(unsigned index) const { return ops[index]; }
+
+  /// Queue the operation with the given index, unless it already is.
+  void push(unsigned index) {
+    if (queued.test(index))
+      return;
+    queued.set(index);
+    queue.push_back(index);
+  }
+
+  /// Dequeue the index of the next operation.
+  unsigned pop() {
+    unsigned index = queue.front();
+    queue.pop_front();
+    queued.reset(index);
+    return index;
+  }
+
+  /// Queue the consumers of `value`.
+  void scheduleUses(mlir::Value value) {
+    for (unsigned user : consumers.lookup(value))
+      push(user);
+  }
+
+  void print(llvm::raw_ostream &os) const {
+    for (unsigned index : queue)
+      os << "READY: " << *ops[index] << "\n";
+  }
+
+private:
+  std::vector<mlir::Operation *> ops;
+  llvm::BitVector queued;
+  std::deque<unsigned> queue;
+  llvm::DenseMap<mlir::Value, SmallVector<unsigned, 2>> consumers;
+};
+
+/// Collects where the tokens of handshake functions spend their time. Every
+/// token is recorded together with the token that determined when its
+/// producer fired, which links the latest result back along the critical path.
+class HandshakeProfile {
+public:
+  /// Record that `op` fired, consuming the tokens in `consumed` and producing
+  /// the values in `produced`, whose times are already in `timeMap`.
+  void recordFiring(mlir::Operation *op, ArrayRef<mlir::Value> consumed,
+                    ArrayRef<mlir::Value> produced,
+                    llvm::DenseMap<mlir::Value, double> &timeMap);
+
+  void print(llvm::raw_ostream &os, mlir::Operation *scope) const;
+
+private:
+  struct Token {
+    mlir::Operation *producer;
+    double time;
+    /// The consumed token that arrived last, or -1 for primary input tokens.
+    int64_t parent;
+    /// The time the token entered the buffer that produced it.
+    double bufferEntry;
+  };
+
+  struct ChannelStats {
+    uint64_t tokens = 0;
+    /// The cycles tokens waited on the channel for their consumer to fire.
+    double stall = 0.0, maxStall = 0.0;
+  };
+
+  /// Look up the token currently on `value`, recording it as a primary input
+  /// if it was not produced by a recorded firing.
+  int64_t getToken(mlir::Value value,
+                   llvm::DenseMap<mlir::Value, double> &timeMap);
+
+  std::vector<Token> tokens;
+  llvm::DenseMap<mlir::Value, int64_t> currentTokens;
+  llvm::MapVector<mlir::Operation *, uint64_t> firings;
+  llvm::MapVector<mlir::Value, ChannelStats> channels;
+  /// The residency intervals of the tokens that passed through each buffer.
+  llvm::MapVector<mlir::Operation *, std::vector<std::pair<double, double>>>
+      bufferIntervals;
+  /// The token consumed last by a return.
+  int64_t lastReturned = -1;
+};
+
+int64_t
+HandshakeProfile::getToken(mlir::Value value,
+                           llvm::DenseMap<mlir::Value, double> &timeMap) {
+  auto it = currentTokens.find(value);
+  if (it != currentTokens.end())
+    return it->second;
+  tokens.push_back({nullptr, timeMap.lookup(value), -1, 0.0});
+  return currentTokens[value] = tokens.size() - 1;
 }
-void scheduleUses(std::list<mlir::Operation *> &readyList,
-                  llvm::DenseMap<mlir::Value, Any> &valueMap,
-                  mlir::Value value) {
-  for (auto &use : value.getUses()) {
-    scheduleIfNeeded(readyList, valueMap, use.getOwner());
+
+void HandshakeProfile::recordFiring(
+    mlir::Operation *op, ArrayRef<mlir::Value> consumed,
+    ArrayRef<mlir::Value> produced,
+    llvm::DenseMap<mlir::Value, double> &timeMap) {
+  ++firings[op];
+
+  // The op fires as soon as its last token arrives; the others stall.
+  int64_t parent = -1;
+  double fireTime = 0.0;
+  SmallVector<int64_t, 4> consumedTokens;
+  for (mlir::Value value : consumed) {
+    int64_t token = getToken(value, timeMap);
+    consumedTokens.push_back(token);
+    if (parent < 0 || tokens[token].time > fireTime) {
+      parent = token;
+      fireTime = tokens[token].time;
+    }
+  }
+  for (auto [value, token] : llvm::zip(consumed, consumedTokens)) {
+    const Token &record = tokens[token];
+    auto &stats = channels[value];
+    double stall = fireTime - record.time;
+    ++stats.tokens;
+    stats.stall += stall;
+    stats.maxStall = std::max(stats.maxStall, stall);
+    if (record.producer && isa<handshake::BufferOp>(record.producer))
+      bufferIntervals[record.producer].push_back(
+          {record.bufferEntry, fireTime});
+    currentTokens.erase(value);
+  }
+
+  if (isa<handshake::ReturnOp>(op)) {
+    lastReturned = parent;
+    return;
+  }
+  double bufferEntry = isa<handshake::BufferOp>(op) ? fireTime : 0.0;
+  for (mlir::Value value : produced) {
+    tokens.push_back({op, timeMap.lookup(value), parent, bufferEntry});
+    currentTokens[value] = tokens.size() - 1;
+  }
+}
+
+void HandshakeProfile::print(llvm::raw_ostream &os,
+                             mlir::Operation *scope) const {
+  // Only the channels that stall the most are listed.
+  constexpr size_t maxChannels = 20;
+  mlir::AsmState asmState(scope);
+  auto printOp = [&](mlir::Operation *op) {
+    os << op->getName() << " at " << op->getLoc();
+  };
+
+  double endTime = 0.0;
+  for (const Token &token : tokens)
+    endTime = std::max(endTime, token.time);
+  uint64_t totalFirings = 0;
+  for (auto &firing : firings)
+    totalFirings += firing.second;
+
+  os << "Handshake profile: " << endTime << " cycles, " << totalFirings
+     << " firings\n";
+
+  os << "\n  Firings:\n";
+  SmallVector<std::pair<mlir::Operation *, uint64_t>> sortedFirings(
+      firings.begin(), firings.end());
+  llvm::stable_sort(sortedFirings, [](auto &lhs, auto &rhs) {
+    return lhs.second > rhs.second;
+  });
+  for (auto &firing : sortedFirings) {
+    os << "    " << firing.second << "  ";
+    printOp(firing.first);
+    os << "\n";
+  }
+
+  os << "\n  Channel stalls (cycles tokens waited for their consumer):\n";
+  SmallVector<std::pair<mlir::Value, ChannelStats>> sortedChannels(
+      channels.begin(), channels.end());
+  llvm::stable_sort(sortedChannels, [](auto &lhs, auto &rhs) {
+    return lhs.second.stall > rhs.second.stall;
+  });
+  if (sortedChannels.size() > maxChannels)
+    sortedChannels.resize(maxChannels);
+  for (auto &[value, stats] : sortedChannels) {
+    if (stats.stall == 0.0)
+      break;
+    os << "    ";
+    value.printAsOperand(os, asmState);
+    os << ": " << stats.stall << " total, " << stats.maxStall << " max over "
+       << stats.tokens << " tokens\n";
+  }
+
+  os << "\n  Buffer occupancy:\n";
+  for (auto &[op, intervals] : bufferIntervals) {
+    // Sweep over the residency intervals to find the peak occupancy.
+    std::vector<std::pair<double, int>> events;
+    double residency = 0.0;
+    for (auto [entry, leave] : intervals) {
+      events.push_back({entry, 1});
+      events.push_back({leave, -1});
+      residency += leave - entry;
+    }
+    llvm::sort(events);
+    int occupancy = 0, peak = 0;
+    for (auto &event : events)
+      peak = std::max(peak, occupancy += event.second);
+    os << "    " << cast<handshake::BufferOp>(op).getNumSlots()
+       << " slots, average "
+       << (endTime > 0 ? residency / endTime : 0.0) << ", peak "
+       << peak << ": ";
+    printOp(op);
+    os << "\n";
+  }
+
+  if (lastReturned < 0)
+    return;
+  SmallVector<const Token *> path;
+  for (int64_t token = lastReturned; token >= 0; token = tokens[token].parent)
+    path.push_back(&tokens[token]);
+  os << "\n  Critical path (" << path.front()->time << " cycles):\n";
+  for (const Token *token : llvm::reverse(path)) {
+    os << "    @" << token->time << "  ";
+    if (token->producer)
+      printOp(token->producer);
+    else
+      os << "input";
+    os << "\n";
   }
 }
 
@@ -177,7 +426,7 @@ void scheduleUses(std::list<mlir::Operation *> &readyList,
 // given store.  Return the pseudo-pointer to the new matrix in the
 // store (i.e. the first dimension index).
 unsigned allocateMemRef(mlir::MemRefType type, std::vector<Any> &in,
-                        std::vector<std::vector<Any>> &store,
+                        MemoryStore &store,
                         std::vector<double> &storeTimes) {
   ArrayRef<int64_t> shape = type.getShape();
   int64_t allocationSize = 1;
@@ -190,22 +439,12 @@ unsigned allocateMemRef(mlir::MemRefType type, std::vector<Any> &in,
       allocationSize *= any_cast<APInt>(in[count++]).getSExtValue();
     }
   }
-  unsigned ptr = store.size();
-  store.resize(ptr + 1);
-  storeTimes.resize(ptr + 1);
-  store[ptr].resize(allocationSize);
-  storeTimes[ptr] = 0.0;
   mlir::Type elementType = type.getElementType();
-  int64_t width = elementType.getIntOrFloatBitWidth();
-  for (int i = 0; i < allocationSize; ++i) {
-    if (elementType.isa<mlir::IntegerType>()) {
-      store[ptr][i] = APInt(width, 0);
-    } else if (elementType.isa<mlir::FloatType>()) {
-      store[ptr][i] = APFloat(0.0);
-    } else {
-      fatalValueError("Unknown result type!\n", elementType);
-    }
-  }
+  if (!elementType.isa<mlir::IntegerType, mlir::FloatType>())
+    fatalValueError("Unknown result type!\n", elementType);
+  unsigned ptr = store.size();
+  store.emplace_back(elementType, allocationSize);
+  storeTimes.push_back(0.0);
   return ptr;
 }
 
@@ -220,7 +459,7 @@ public:
                     llvm::DenseMap<mlir::Value, Any> &valueMap,
                     llvm::DenseMap<mlir::Value, double> &timeMap,
                     std::vector<Any> &results, std::vector<double> &resultTimes,
-                    std::vector<std::vector<Any>> &store,
+                    MemoryStore &store,
                     std::vector<double> &storeTimes);
 
   /// Entry point for handshake::FuncOp top-level functions
@@ -228,9 +467,10 @@ public:
                     llvm::DenseMap<mlir::Value, Any> &valueMap,
                     llvm::DenseMap<mlir::Value, double> &timeMap,
                     std::vector<Any> &results, std::vector<double> &resultTimes,
-                    std::vector<std::vector<Any>> &store,
+                    MemoryStore &store,
                     std::vector<double> &storeTimes,
-                    mlir::OwningOpRef<mlir::ModuleOp> &module);
+                    mlir::OwningOpRef<mlir::ModuleOp> &module,
+                    HandshakeProfile *profile = nullptr);
 
   bool succeeded() const { return successFlag; }
 
@@ -294,10 +534,12 @@ private:
   llvm::DenseMap<mlir::Value, double> &timeMap;
   std::vector<Any> &results;
   std::vector<double> &resultTimes;
-  std::vector<std::vector<Any>> &store;
+  MemoryStore &store;
   std::vector<double> &storeTimes;
   double time;
   mlir::OwningOpRef<mlir::ModuleOp> *module = nullptr;
+  /// Where firings are recorded, if the simulation is profiled.
+  HandshakeProfile *profile = nullptr;
 
   /// Flag indicating whether execution was successful.
   bool successFlag = true;
@@ -373,7 +615,7 @@ LogicalResult HandshakeExecuter::execute(mlir::arith::SubIOp,
 LogicalResult HandshakeExecuter::execute(mlir::arith::SubFOp,
                                          std::vector<Any> &in,
                                          std::vector<Any> &out) {
-  out[0] = any_cast<APFloat>(in[0]) + any_cast<APFloat>(in[1]);
+  out[0] = any_cast<APFloat>(in[0]) - any_cast<APFloat>(in[1]);
   return success();
 }
 
@@ -471,8 +713,7 @@ LogicalResult HandshakeExecuter::execute(mlir::memref::LoadOp op,
            << "Out-of-bounds access to memory '" << ptr << "'. Memory has "
            << ref.size() << " elements but requested element " << address;
 
-  Any result = ref[address];
-  out[0] = result;
+  out[0] = ref.load(address);
 
   double storeTime = storeTimes[ptr];
   LLVM_DEBUG(dbgs() << "STORE: " << storeTime << "\n");
@@ -498,7 +739,7 @@ LogicalResult HandshakeExecuter::execute(mlir::memref::StoreOp op,
     return op.emitOpError()
            << "Out-of-bounds access to memory '" << ptr << "'. Memory has "
            << ref.size() << " elements but requested element " << address;
-  ref[address] = in[0];
+  ref.store(address, in[0]);
 
   double storeTime = storeTimes[ptr];
   LLVM_DEBUG(dbgs() << "STORE: " << storeTime << "\n");
@@ -596,7 +837,7 @@ LogicalResult HandshakeExecuter::execute(mlir::CallOpInterface callOp,
     llvm::DenseMap<mlir::Value, double> newTimeMap;
     std::vector<Any> results(outputs);
     std::vector<double> resultTimes(outputs);
-    std::vector<std::vector<Any>> store;
+    MemoryStore store;
     std::vector<double> storeTimes;
     mlir::Block &entryBlock = funcOp.getBody().front();
     mlir::Block::BlockArgListType blockArgs = entryBlock.getArguments();
@@ -661,7 +902,7 @@ LogicalResult HandshakeExecuter::execute(handshake::InstanceOp instanceOp,
 
       // Go execute!
       HandshakeExecuter(func, scopeValueMap, scopeTimeMap, nestedResults,
-                        nestedResTimes, store, storeTimes, *module);
+                        nestedResTimes, store, storeTimes, *module, profile);
 
       // Place the output arguments in the caller scope.
       for (auto nestedRes : enumerate(nestedResults)) {
@@ -693,7 +934,7 @@ enum ExecuteStrategy { Default = 1 << 0, Continue = 1 << 1, Return = 1 << 2 };
 HandshakeExecuter::HandshakeExecuter(
     mlir::func::FuncOp &toplevel, llvm::DenseMap<mlir::Value, Any> &valueMap,
     llvm::DenseMap<mlir::Value, double> &timeMap, std::vector<Any> &results,
-    std::vector<double> &resultTimes, std::vector<std::vector<Any>> &store,
+    std::vector<double> &resultTimes, MemoryStore &store,
     std::vector<double> &storeTimes)
     : valueMap(valueMap), timeMap(timeMap), results(results),
       resultTimes(resultTimes), store(store), storeTimes(storeTimes) {
@@ -767,17 +1008,18 @@ HandshakeExecuter::HandshakeExecuter(
 HandshakeExecuter::HandshakeExecuter(
     handshake::FuncOp &func, llvm::DenseMap<mlir::Value, Any> &valueMap,
     llvm::DenseMap<mlir::Value, double> &timeMap, std::vector<Any> &results,
-    std::vector<double> &resultTimes, std::vector<std::vector<Any>> &store,
-    std::vector<double> &storeTimes, mlir::OwningOpRef<mlir::ModuleOp> &module)
+    std::vector<double> &resultTimes, MemoryStore &store,
+    std::vector<double> &storeTimes, mlir::OwningOpRef<mlir::ModuleOp> &module,
+    HandshakeProfile *profile)
     : valueMap(valueMap), timeMap(timeMap), results(results),
       resultTimes(resultTimes), store(store), storeTimes(storeTimes),
-      module(&module) {
+      module(&module), profile(profile) {
   successFlag = true;
   mlir::Block &entryBlock = func.getBody().front();
   // The arguments of the entry block.
   mlir::Block::BlockArgListType blockArgs = entryBlock.getArguments();
   // A list of operations which might be ready to execute.
-  std::list<mlir::Operation *> readyList;
+  ReadyList readyList(entryBlock);
   // A map of memory ops
   llvm::DenseMap<unsigned, unsigned> memoryMap;
 
@@ -798,35 +1040,43 @@ HandshakeExecuter::HandshakeExecuter(
       Value bufferRes = bufferOp.getResult();
       valueMap[bufferRes] = APInt(bufferRes.getType().getIntOrFloatBitWidth(),
                                   initValues.front());
-      scheduleUses(readyList, valueMap, bufferRes);
+      readyList.scheduleUses(bufferRes);
     }
   }
 
   for (auto blockArg : blockArgs)
-    scheduleUses(readyList, valueMap, blockArg);
+    readyList.scheduleUses(blockArg);
 
 #define EXTRA_DEBUG
   while (true) {
 #ifdef EXTRA_DEBUG
     LLVM_DEBUG(
-        for (auto t
-             : readyList) { dbgs() << "READY: " << *t << "\n"; } dbgs()
-            << "Live: " << valueMap.size() << "\n";
+        readyList.print(dbgs()); dbgs() << "Live: " << valueMap.size() << "\n";
         for (auto t
              : valueMap) { debugArg("Value:", t.first, t.second, 0.0); });
 #endif
-    assert(readyList.size() > 0 &&
+    assert(!readyList.empty() &&
            "Expected some instruction to be ready for execution");
-    mlir::Operation &op = *readyList.front();
-    readyList.pop_front();
+    unsigned opIndex = readyList.pop();
+    mlir::Operation &op = *readyList.getOp(opIndex);
 
     // Execute handshake ops through ExecutableOpInterface
     if (auto handshakeOp = dyn_cast<handshake::ExecutableOpInterface>(op)) {
       std::vector<mlir::Value> scheduleList;
+      // The tokens an op consumes are the operands it removes from the map.
+      SmallVector<mlir::Value, 4> available;
+      if (profile)
+        llvm::copy_if(op.getOperands(), std::back_inserter(available),
+                      [&](mlir::Value in) { return valueMap.count(in); });
       if (!handshakeOp.tryExecute(valueMap, memoryMap, timeMap, store,
                                   scheduleList))
-        readyList.push_back(&op);
+        readyList.push(opIndex);
       else {
+        if (profile) {
+          llvm::erase_if(available,
+                         [&](mlir::Value in) { return valueMap.count(in); });
+          profile->recordFiring(&op, available, scheduleList, timeMap);
+        }
         LLVM_DEBUG({
           dbgs() << "EXECUTED: " << op << "\n";
           for (auto out : op.getResults()) {
@@ -837,7 +1087,7 @@ HandshakeExecuter::HandshakeExecuter(
         });
       }
       for (mlir::Value out : scheduleList)
-        scheduleUses(readyList, valueMap, out);
+        readyList.scheduleUses(out);
       continue;
     }
 
@@ -860,7 +1110,7 @@ HandshakeExecuter::HandshakeExecuter(
     }
     if (reschedule) {
       LLVM_DEBUG(dbgs() << "Rescheduling data...\n");
-      readyList.push_back(&op);
+      readyList.push(opIndex);
       continue;
     }
     // Consume the inputs.
@@ -895,6 +1145,14 @@ HandshakeExecuter::HandshakeExecuter(
       return;
     }
 
+    if (profile) {
+      SmallVector<mlir::Value, 4> operands(op.getOperands());
+      SmallVector<mlir::Value, 4> produced(op.getResults());
+      for (mlir::Value result : produced)
+        timeMap[result] = time + 1;
+      profile->recordFiring(&op, operands, produced, timeMap);
+    }
+
     if (strat & ExecuteStrategy::Return)
       return;
 
@@ -903,22 +1161,829 @@ HandshakeExecuter::HandshakeExecuter(
       assert(outValues[out.index()].has_value());
       valueMap[out.value()] = outValues[out.index()];
       timeMap[out.value()] = time + 1;
-      scheduleUses(readyList, valueMap, out.value());
+      readyList.scheduleUses(out.value());
     }
     ++instructionsExecuted;
   }
 }
 
+//===----------------------------------------------------------------------===//
+// Pre-compiled executer
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// The storage kind of a register of the pre-compiled executer.
+enum class RegisterKind : uint8_t { Int, Float, Buffer };
+
+/// A register of the pre-compiled executer. Values are held inline instead of
+/// in an `Any`, together with the time at which they were produced.
+struct Register {
+  APInt intValue;
+  APFloat floatValue{0.0};
+  /// The pseudo-pointer of a buffer in the store.
+  unsigned buffer = 0;
+  double time = 0.0;
+};
+
+enum class Opcode : uint8_t {
+  Constant,
+  AddI,
+  XOrI,
+  AddF,
+  CmpI,
+  CmpF,
+  SubI,
+  SubF,
+  MulI,
+  MulF,
+  DivSI,
+  DivUI,
+  DivF,
+  IndexCast,
+  ExtSI,
+  ExtUI,
+  Load,
+  Store,
+  Alloc,
+  Branch,
+  CondBranch,
+  Call,
+  Return
+};
+
+struct CompiledFunction;
+
+/// A decoded operation. Operands, block argument copies, constants and memref
+/// shapes live in side tables of the function and are referenced by offset.
+struct Instruction {
+  Opcode opcode;
+  /// The comparison predicate, the constant index, or the result width of a
+  /// cast.
+  unsigned immediate = 0;
+  /// The operand and result registers, as offsets into the `operands` table of
+  /// the function.
+  unsigned firstOperand = 0, numOperands = 0;
+  unsigned firstResult = 0, numResults = 0;
+  /// Branch targets and the block argument copies performed by each of them.
+  /// The false destination is only used by conditional branches.
+  unsigned trueTarget = 0, falseTarget = 0;
+  unsigned firstTrueCopy = 0, numTrueCopies = 0;
+  unsigned firstFalseCopy = 0, numFalseCopies = 0;
+  /// The memref shape of loads and stores.
+  unsigned firstShape = 0, numShape = 0;
+  const CompiledFunction *callee = nullptr;
+  Operation *op;
+};
+
+/// A function lowered to a flat instruction array over numbered registers.
+struct CompiledFunction {
+  SmallVector<Instruction, 0> instructions;
+  /// The operand and result registers of all instructions.
+  SmallVector<unsigned, 0> operands;
+  /// (destination, source) register pairs for block arguments.
+  SmallVector<std::pair<unsigned, unsigned>, 0> copies;
+  SmallVector<APInt, 0> constants;
+  SmallVector<int64_t, 0> shapes;
+  SmallVector<RegisterKind, 0> registerKinds;
+  SmallVector<unsigned, 4> argRegisters;
+  SmallVector<RegisterKind, 4> resultKinds;
+};
+
+/// Compiles the functions reachable from a top-level function once and
+/// interprets them over typed register files.
+class PrecompiledExecuter {
+public:
+  PrecompiledExecuter(MemoryStore &store,
+                      std::vector<double> &storeTimes)
+      : store(store), storeTimes(storeTimes) {}
+
+  /// Lower `func` and every function it calls. Returns null if one of them
+  /// uses an operation the pre-compiled executer does not support.
+  const CompiledFunction *compile(mlir::func::FuncOp func);
+
+  /// Run `toplevel` on the arguments in the value and time maps, the same way
+  /// as the interpreting `HandshakeExecuter` does.
+  bool run(const CompiledFunction &toplevel,
+           mlir::Block::BlockArgListType blockArgs,
+           llvm::DenseMap<mlir::Value, Any> &valueMap,
+           llvm::DenseMap<mlir::Value, double> &timeMap,
+           std::vector<Any> &results, std::vector<double> &resultTimes);
+
+private:
+  LogicalResult execute(const CompiledFunction &function,
+                        MutableArrayRef<Register> registers,
+                        SmallVectorImpl<Register> &results);
+
+  MemoryStore &store;
+  std::vector<double> &storeTimes;
+  llvm::DenseMap<Operation *, std::unique_ptr<CompiledFunction>> functions;
+};
+
+} // namespace
+
+static Optional<RegisterKind> getRegisterKind(Type type) {
+  if (type.isa<IntegerType, IndexType>())
+    return RegisterKind::Int;
+  if (type.isa<FloatType>())
+    return RegisterKind::Float;
+  if (type.isa<MemRefType>())
+    return RegisterKind::Buffer;
+  return None;
+}
+
+const CompiledFunction *PrecompiledExecuter::compile(mlir::func::FuncOp func) {
+  auto it = functions.find(func.getOperation());
+  if (it != functions.end())
+    return it->second.get();
+  // Insert before lowering the body so that recursive calls resolve.
+  auto &compiled = functions[func.getOperation()];
+  compiled = std::make_unique<CompiledFunction>();
+  CompiledFunction &fn = *compiled;
+  auto fail = [&]() -> const CompiledFunction * {
+    functions.erase(func.getOperation());
+    return nullptr;
+  };
+
+  llvm::DenseMap<Value, unsigned> registers;
+  auto getRegister = [&](Value value) -> Optional<unsigned> {
+    auto it = registers.find(value);
+    if (it != registers.end())
+      return it->second;
+    auto kind = getRegisterKind(value.getType());
+    if (!kind)
+      return None;
+    unsigned reg = fn.registerKinds.size();
+    fn.registerKinds.push_back(*kind);
+    registers.insert({value, reg});
+    return reg;
+  };
+
+  // Every operation becomes exactly one instruction, so the block offsets are
+  // known before lowering.
+  llvm::DenseMap<Block *, unsigned> blockOffsets;
+  unsigned numInstructions = 0;
+  for (Block &block : func.getBody()) {
+    blockOffsets[&block] = numInstructions;
+    numInstructions += block.getOperations().size();
+  }
+  fn.instructions.reserve(numInstructions);
+
+  for (BlockArgument arg : func.getArguments()) {
+    auto reg = getRegister(arg);
+    if (!reg)
+      return fail();
+    fn.argRegisters.push_back(*reg);
+  }
+  for (Type type : func.getResultTypes()) {
+    auto kind = getRegisterKind(type);
+    if (!kind)
+      return fail();
+    fn.resultKinds.push_back(*kind);
+  }
+
+  auto addCopies = [&](Block *dest, OperandRange operands, unsigned &first,
+                       unsigned &num) -> bool {
+    first = fn.copies.size();
+    num = operands.size();
+    for (auto [arg, operand] : llvm::zip(dest->getArguments(), operands)) {
+      auto argReg = getRegister(arg);
+      auto operandReg = getRegister(operand);
+      if (!argReg || !operandReg)
+        return false;
+      fn.copies.push_back({*argReg, *operandReg});
+    }
+    return true;
+  };
+
+  for (Block &block : func.getBody()) {
+    for (Operation &op : block) {
+      Instruction inst;
+      inst.op = &op;
+      bool supported =
+          llvm::TypeSwitch<Operation *, bool>(&op)
+              .Case([&](mlir::arith::ConstantIndexOp op) {
+                auto attr = op->getAttrOfType<mlir::IntegerAttr>("value");
+                inst.opcode = Opcode::Constant;
+                inst.immediate = fn.constants.size();
+                fn.constants.push_back(
+                    attr.getValue().sextOrTrunc(INDEX_WIDTH));
+                return true;
+              })
+              .Case([&](mlir::arith::ConstantIntOp op) {
+                auto attr = op->getAttrOfType<mlir::IntegerAttr>("value");
+                inst.opcode = Opcode::Constant;
+                inst.immediate = fn.constants.size();
+                fn.constants.push_back(attr.getValue());
+                return true;
+              })
+              .Case([&](mlir::arith::AddIOp) {
+                inst.opcode = Opcode::AddI;
+                return true;
+              })
+              .Case([&](mlir::arith::XOrIOp) {
+                inst.opcode = Opcode::XOrI;
+                return true;
+              })
+              .Case([&](mlir::arith::AddFOp) {
+                inst.opcode = Opcode::AddF;
+                return true;
+              })
+              .Case([&](mlir::arith::CmpIOp op) {
+                inst.opcode = Opcode::CmpI;
+                inst.immediate = static_cast<unsigned>(op.getPredicate());
+                return true;
+              })
+              .Case([&](mlir::arith::CmpFOp op) {
+                inst.opcode = Opcode::CmpF;
+                inst.immediate = static_cast<unsigned>(op.getPredicate());
+                return true;
+              })
+              .Case([&](mlir::arith::SubIOp) {
+                inst.opcode = Opcode::SubI;
+                return true;
+              })
+              .Case([&](mlir::arith::SubFOp) {
+                inst.opcode = Opcode::SubF;
+                return true;
+              })
+              .Case([&](mlir::arith::MulIOp) {
+                inst.opcode = Opcode::MulI;
+                return true;
+              })
+              .Case([&](mlir::arith::MulFOp) {
+                inst.opcode = Opcode::MulF;
+                return true;
+              })
+              .Case([&](mlir::arith::DivSIOp) {
+                inst.opcode = Opcode::DivSI;
+                return true;
+              })
+              .Case([&](mlir::arith::DivUIOp) {
+                inst.opcode = Opcode::DivUI;
+                return true;
+              })
+              .Case([&](mlir::arith::DivFOp) {
+                inst.opcode = Opcode::DivF;
+                return true;
+              })
+              .Case([&](mlir::arith::IndexCastOp op) {
+                Type outType = op.getOut().getType();
+                inst.opcode = Opcode::IndexCast;
+                if (outType.isIndex())
+                  inst.immediate = IndexType::kInternalStorageBitWidth;
+                else if (outType.isIntOrFloat())
+                  inst.immediate = outType.getIntOrFloatBitWidth();
+                else
+                  return false;
+                return true;
+              })
+              .Case([&](mlir::arith::ExtSIOp op) {
+                inst.opcode = Opcode::ExtSI;
+                inst.immediate = op.getType().getIntOrFloatBitWidth();
+                return true;
+              })
+              .Case([&](mlir::arith::ExtUIOp op) {
+                inst.opcode = Opcode::ExtUI;
+                inst.immediate = op.getType().getIntOrFloatBitWidth();
+                return true;
+              })
+              .Case<memref::LoadOp, memref::StoreOp>([&](auto op) {
+                inst.opcode = isa<memref::LoadOp>(op) ? Opcode::Load
+                                                      : Opcode::Store;
+                ArrayRef<int64_t> shape = op.getMemRefType().getShape();
+                inst.firstShape = fn.shapes.size();
+                inst.numShape = shape.size();
+                fn.shapes.append(shape.begin(), shape.end());
+                return true;
+              })
+              .Case([&](memref::AllocOp op) {
+                // Dynamic dimensions are read from the operands in order.
+                inst.opcode = Opcode::Alloc;
+                mlir::Type elementType = op.getType().getElementType();
+                return elementType.isa<IntegerType, FloatType>();
+              })
+              .Case([&](mlir::cf::BranchOp op) {
+                inst.opcode = Opcode::Branch;
+                inst.trueTarget = blockOffsets[op.getDest()];
+                return addCopies(op.getDest(), op.getDestOperands(),
+                                 inst.firstTrueCopy, inst.numTrueCopies);
+              })
+              .Case([&](mlir::cf::CondBranchOp op) {
+                inst.opcode = Opcode::CondBranch;
+                inst.trueTarget = blockOffsets[op.getTrueDest()];
+                inst.falseTarget = blockOffsets[op.getFalseDest()];
+                return addCopies(op.getTrueDest(), op.getTrueOperands(),
+                                 inst.firstTrueCopy, inst.numTrueCopies) &&
+                       addCopies(op.getFalseDest(), op.getFalseOperands(),
+                                 inst.firstFalseCopy, inst.numFalseCopies);
+              })
+              .Case([&](mlir::CallOpInterface op) {
+                auto callee =
+                    dyn_cast_or_null<mlir::func::FuncOp>(op.resolveCallable());
+                if (!callee)
+                  return false;
+                inst.opcode = Opcode::Call;
+                inst.callee = compile(callee);
+                return inst.callee != nullptr;
+              })
+              .Case([&](func::ReturnOp) {
+                inst.opcode = Opcode::Return;
+                return true;
+              })
+              .Default([](auto) { return false; });
+      if (!supported) {
+        LLVM_DEBUG(dbgs() << "Cannot pre-compile " << op.getName() << "\n");
+        return fail();
+      }
+
+      // Branches read the values they forward through the block argument
+      // copies, and only the condition as an operand.
+      ValueRange operands = op.getOperands();
+      if (isa<mlir::cf::BranchOp>(op))
+        operands = ValueRange();
+      else if (isa<mlir::cf::CondBranchOp>(op))
+        operands = operands.take_front();
+      inst.firstOperand = fn.operands.size();
+      inst.numOperands = operands.size();
+      for (Value operand : operands) {
+        auto reg = getRegister(operand);
+        if (!reg)
+          return fail();
+        fn.operands.push_back(*reg);
+      }
+
+      inst.firstResult = fn.operands.size();
+      inst.numResults = op.getNumResults();
+      for (Value result : op.getResults()) {
+        auto reg = getRegister(result);
+        if (!reg)
+          return fail();
+        fn.operands.push_back(*reg);
+      }
+      fn.instructions.push_back(inst);
+    }
+  }
+  return &fn;
+}
+
+/// Convert a value of the interpreting executer into a register.
+static Register toRegister(RegisterKind kind, const Any &value, double time) {
+  Register reg;
+  switch (kind) {
+  case RegisterKind::Int:
+    reg.intValue = any_cast<APInt>(value);
+    break;
+  case RegisterKind::Float:
+    reg.floatValue = any_cast<APFloat>(value);
+    break;
+  case RegisterKind::Buffer:
+    reg.buffer = any_cast<unsigned>(value);
+    break;
+  }
+  reg.time = time;
+  return reg;
+}
+
+static Any fromRegister(RegisterKind kind, const Register &reg) {
+  switch (kind) {
+  case RegisterKind::Int:
+    return reg.intValue;
+  case RegisterKind::Float:
+    return reg.floatValue;
+  case RegisterKind::Buffer:
+    return reg.buffer;
+  }
+  llvm_unreachable("unknown register kind");
+}
+
+bool PrecompiledExecuter::run(const CompiledFunction &toplevel,
+                              mlir::Block::BlockArgListType blockArgs,
+                              llvm::DenseMap<mlir::Value, Any> &valueMap,
+                              llvm::DenseMap<mlir::Value, double> &timeMap,
+                              std::vector<Any> &results,
+                              std::vector<double> &resultTimes) {
+  SmallVector<Register, 0> registers(toplevel.registerKinds.size());
+  for (auto [arg, reg] : llvm::zip(blockArgs, toplevel.argRegisters))
+    registers[reg] = toRegister(toplevel.registerKinds[reg], valueMap[arg],
+                                timeMap[arg]);
+
+  SmallVector<Register, 4> returned;
+  if (failed(execute(toplevel, registers, returned)))
+    return false;
+
+  for (unsigned i = 0, e = returned.size(); i < e; ++i) {
+    results[i] = fromRegister(toplevel.resultKinds[i], returned[i]);
+    resultTimes[i] = returned[i].time;
+  }
+  return true;
+}
+
+/// Compute the address of a load or store from its indices.
+static unsigned getAddress(ArrayRef<int64_t> shape,
+                           MutableArrayRef<Register> registers,
+                           const unsigned *indices) {
+  unsigned address = 0;
+  for (unsigned i = 0; i < shape.size(); ++i)
+    address =
+        address * shape[i] + registers[indices[i]].intValue.getZExtValue();
+  return address;
+}
+
+LogicalResult PrecompiledExecuter::execute(const CompiledFunction &function,
+                                           MutableArrayRef<Register> registers,
+                                           SmallVectorImpl<Register> &results) {
+  SmallVector<Register, 8> forwarded;
+  for (unsigned pc = 0;;) {
+    const Instruction &inst = function.instructions[pc];
+    const unsigned *in = function.operands.data() + inst.firstOperand;
+    const unsigned *out = function.operands.data() + inst.firstResult;
+    auto arg = [&](unsigned i) -> Register & { return registers[in[i]]; };
+
+    double time = 0.0;
+    for (unsigned i = 0; i < inst.numOperands; ++i)
+      time = std::max(time, arg(i).time);
+
+    // Jump to `target`, forwarding the values of a range of copies to the
+    // block arguments. The arguments take the time of the latest value.
+    auto branch = [&](unsigned target, unsigned firstCopy, unsigned numCopies) {
+      auto copies = makeArrayRef(function.copies).slice(firstCopy, numCopies);
+      double argTime = 0.0;
+      forwarded.clear();
+      for (auto copy : copies) {
+        forwarded.push_back(registers[copy.second]);
+        argTime = std::max(argTime, registers[copy.second].time);
+      }
+      for (auto [copy, value] : llvm::zip(copies, forwarded)) {
+        registers[copy.first] = std::move(value);
+        registers[copy.first].time = argTime;
+      }
+      pc = target;
+    };
+
+    // Look up the memory and the element index accessed by a load or store,
+    // whose memref is operand `ptrIndex` followed by the indices. Accesses
+    // wait for the previous access to the same memory.
+    auto access = [&](unsigned ptrIndex, unsigned &address) -> MemoryBank * {
+      unsigned ptr = arg(ptrIndex).buffer;
+      if (ptr >= store.size()) {
+        inst.op->emitOpError()
+            << "Unknown memory identified by pointer '" << ptr << "'";
+        return nullptr;
+      }
+      ArrayRef<int64_t> shape =
+          makeArrayRef(function.shapes).slice(inst.firstShape, inst.numShape);
+      address = getAddress(shape, registers, in + ptrIndex + 1);
+      auto &ref = store[ptr];
+      if (address >= ref.size()) {
+        inst.op->emitOpError()
+            << "Out-of-bounds access to memory '" << ptr << "'. Memory has "
+            << ref.size() << " elements but requested element " << address;
+        return nullptr;
+      }
+      time = std::max(time, storeTimes[ptr]);
+      storeTimes[ptr] = time;
+      return &ref;
+    };
+
+    switch (inst.opcode) {
+    case Opcode::Branch:
+      branch(inst.trueTarget, inst.firstTrueCopy, inst.numTrueCopies);
+      continue;
+    case Opcode::CondBranch:
+      if (!arg(0).intValue.isZero())
+        branch(inst.trueTarget, inst.firstTrueCopy, inst.numTrueCopies);
+      else
+        branch(inst.falseTarget, inst.firstFalseCopy, inst.numFalseCopies);
+      continue;
+    case Opcode::Call: {
+      const CompiledFunction &callee = *inst.callee;
+      SmallVector<Register, 0> calleeRegisters(callee.registerKinds.size());
+      for (unsigned i = 0; i < inst.numOperands; ++i)
+        calleeRegisters[callee.argRegisters[i]] = arg(i);
+      SmallVector<Register, 4> calleeResults;
+      if (failed(execute(callee, calleeRegisters, calleeResults)))
+        return failure();
+      for (unsigned i = 0; i < inst.numResults; ++i)
+        registers[out[i]] = std::move(calleeResults[i]);
+      ++pc;
+      continue;
+    }
+    case Opcode::Store: {
+      unsigned address;
+      MemoryBank *bank = access(1, address);
+      if (!bank)
+        return failure();
+      if (function.registerKinds[in[0]] == RegisterKind::Int)
+        bank->storeInt(address, arg(0).intValue);
+      else
+        bank->storeFloat(address, arg(0).floatValue);
+      ++pc;
+      ++instructionsExecuted;
+      continue;
+    }
+    case Opcode::Return:
+      results.clear();
+      for (unsigned i = 0; i < inst.numOperands; ++i)
+        results.push_back(arg(i));
+      return success();
+    default:
+      break;
+    }
+
+    Register &result = registers[out[0]];
+    switch (inst.opcode) {
+    case Opcode::Constant:
+      result.intValue = function.constants[inst.immediate];
+      break;
+    case Opcode::AddI:
+      result.intValue = arg(0).intValue + arg(1).intValue;
+      break;
+    case Opcode::XOrI:
+      result.intValue = arg(0).intValue ^ arg(1).intValue;
+      break;
+    case Opcode::AddF:
+      result.floatValue = arg(0).floatValue + arg(1).floatValue;
+      break;
+    case Opcode::CmpI:
+      result.intValue = APInt(
+          1, mlir::arith::applyCmpPredicate(
+                 static_cast<mlir::arith::CmpIPredicate>(inst.immediate),
+                 arg(0).intValue, arg(1).intValue));
+      break;
+    case Opcode::CmpF:
+      result.intValue = APInt(
+          1, mlir::arith::applyCmpPredicate(
+                 static_cast<mlir::arith::CmpFPredicate>(inst.immediate),
+                 arg(0).floatValue, arg(1).floatValue));
+      break;
+    case Opcode::SubI:
+      result.intValue = arg(0).intValue - arg(1).intValue;
+      break;
+    case Opcode::SubF:
+      result.floatValue = arg(0).floatValue - arg(1).floatValue;
+      break;
+    case Opcode::MulI:
+      result.intValue = arg(0).intValue * arg(1).intValue;
+      break;
+    case Opcode::MulF:
+      result.floatValue = arg(0).floatValue * arg(1).floatValue;
+      break;
+    case Opcode::DivSI:
+      if (arg(1).intValue.isZero())
+        return inst.op->emitOpError() << "Division By Zero!";
+      result.intValue = arg(0).intValue.sdiv(arg(1).intValue);
+      break;
+    case Opcode::DivUI:
+      if (arg(1).intValue.isZero())
+        return inst.op->emitOpError() << "Division By Zero!";
+      result.intValue = arg(0).intValue.udiv(arg(1).intValue);
+      break;
+    case Opcode::DivF:
+      result.floatValue = arg(0).floatValue / arg(1).floatValue;
+      break;
+    case Opcode::IndexCast:
+      result.intValue = APInt(inst.immediate, arg(0).intValue.getZExtValue());
+      break;
+    case Opcode::ExtSI:
+      result.intValue = arg(0).intValue.sext(inst.immediate);
+      break;
+    case Opcode::ExtUI:
+      result.intValue = arg(0).intValue.zext(inst.immediate);
+      break;
+    case Opcode::Load: {
+      unsigned address;
+      MemoryBank *bank = access(0, address);
+      if (!bank)
+        return failure();
+      if (function.registerKinds[out[0]] == RegisterKind::Int)
+        result.intValue = bank->loadInt(address);
+      else
+        result.floatValue = bank->loadFloat(address);
+      break;
+    }
+    case Opcode::Alloc: {
+      std::vector<Any> sizes;
+      for (unsigned i = 0; i < inst.numOperands; ++i)
+        sizes.push_back(arg(i).intValue);
+      result.buffer =
+          allocateMemRef(cast<memref::AllocOp>(inst.op).getType(), sizes,
+                         store, storeTimes);
+      storeTimes[result.buffer] = time;
+      break;
+    }
+    default:
+      llvm_unreachable("control flow is handled above");
+    }
+    result.time = time + 1;
+    ++pc;
+    ++instructionsExecuted;
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// JIT executer
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// Compiles the standard functions of a module to native code with the MLIR
+/// execution engine and runs them on the simulator's memories. The memory
+/// banks keep their elements in the layout of the compiled code, so memrefs
+/// are passed as descriptors of the banks themselves.
+class JITExecuter {
+public:
+  JITExecuter(MemoryStore &store) : store(store) {}
+
+  /// Lower the module of `func` to the LLVM dialect and compile it. Returns
+  /// failure if the module uses operations without a lowering to LLVM, or if
+  /// the signature of `func` cannot be passed to compiled code.
+  LogicalResult compile(mlir::func::FuncOp func);
+
+  /// Run the compiled function on the arguments in the value map. Results
+  /// are produced at time zero.
+  bool run(mlir::Block::BlockArgListType blockArgs,
+           llvm::DenseMap<mlir::Value, Any> &valueMap,
+           std::vector<Any> &results, std::vector<double> &resultTimes);
+
+private:
+  MemoryStore &store;
+  mlir::FunctionType type;
+  std::string name;
+  std::unique_ptr<mlir::ExecutionEngine> engine;
+};
+
+} // namespace
+
+/// Return true if values of `type` can be passed to and returned from compiled
+/// code in a single 64-bit slot.
+static bool isJITScalarType(Type type) {
+  if (type.isIndex() || type.isF32() || type.isF64())
+    return true;
+  auto intType = type.dyn_cast<IntegerType>();
+  return intType && intType.getWidth() <= 64;
+}
+
+/// Return the number of bytes compiled code stores a scalar in, which is also
+/// its alignment within a struct of results.
+static unsigned getJITScalarBytes(Type type) {
+  if (type.isIndex())
+    return 8;
+  return PowerOf2Ceil(divideCeil(type.getIntOrFloatBitWidth(), 8));
+}
+
+static bool isJITSupported(mlir::FunctionType type) {
+  for (Type input : type.getInputs()) {
+    if (auto memrefType = input.dyn_cast<MemRefType>()) {
+      if (!memrefType.hasStaticShape() ||
+          !memrefType.getLayout().isIdentity() ||
+          memrefType.getElementType().isIndex() ||
+          !isJITScalarType(memrefType.getElementType()))
+        return false;
+    } else if (!isJITScalarType(input))
+      return false;
+  }
+  return llvm::all_of(type.getResults(), isJITScalarType);
+}
+
+LogicalResult JITExecuter::compile(mlir::func::FuncOp func) {
+  type = func.getFunctionType();
+  name = func.getName().str();
+  if (!isJITSupported(type))
+    return failure();
+
+  // Lower a copy of the module without its handshake functions, leaving the
+  // module of the interpreting executers untouched.
+  auto module = cast<ModuleOp>(func->getParentOp()).clone();
+  OwningOpRef<ModuleOp> owner(module);
+  for (auto op :
+       llvm::make_early_inc_range(module.getOps<handshake::FuncOp>()))
+    op.erase();
+
+  // Modules the JIT cannot lower are interpreted instead, so do not report
+  // the operations which failed to legalize.
+  MLIRContext *context = module.getContext();
+  ScopedDiagnosticHandler silence(context,
+                                  [](Diagnostic &) { return success(); });
+
+  LLVMTypeConverter converter(context);
+  RewritePatternSet patterns(context);
+  populateFuncToLLVMConversionPatterns(converter, patterns);
+  arith::populateArithToLLVMConversionPatterns(converter, patterns);
+  cf::populateControlFlowToLLVMConversionPatterns(converter, patterns);
+  populateMemRefToLLVMConversionPatterns(converter, patterns);
+  LLVMConversionTarget target(*context);
+  target.addLegalOp<ModuleOp>();
+  if (failed(applyFullConversion(module, target, std::move(patterns))))
+    return failure();
+
+  RewritePatternSet castPatterns(context);
+  populateReconcileUnrealizedCastsPatterns(castPatterns);
+  target.addIllegalOp<UnrealizedConversionCastOp>();
+  if (failed(applyFullConversion(module, target, std::move(castPatterns))))
+    return failure();
+
+  static bool initialized = [] {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    return true;
+  }();
+  (void)initialized;
+
+  mlir::ExecutionEngineOptions options;
+  options.transformer = mlir::makeOptimizingTransformer(
+      /*optLevel=*/2, /*sizeLevel=*/0, /*targetMachine=*/nullptr);
+  auto maybeEngine = mlir::ExecutionEngine::create(module, options);
+  if (!maybeEngine) {
+    llvm::consumeError(maybeEngine.takeError());
+    return failure();
+  }
+  engine = std::move(*maybeEngine);
+  return success();
+}
+
+bool JITExecuter::run(mlir::Block::BlockArgListType blockArgs,
+                      llvm::DenseMap<mlir::Value, Any> &valueMap,
+                      std::vector<Any> &results,
+                      std::vector<double> &resultTimes) {
+  // The packed wrapper of the function takes a pointer to every argument of
+  // the lowered function. Scalars and the fields of memref descriptors each
+  // get a 64-bit slot, whose low bytes hold narrower values on little-endian
+  // hosts.
+  SmallVector<uint64_t, 16> slots;
+  for (auto [arg, argType] : llvm::zip(blockArgs, type.getInputs())) {
+    Any &value = valueMap[arg];
+    if (auto memrefType = argType.dyn_cast<MemRefType>()) {
+      // A descriptor of the whole bank: the allocated and aligned pointers,
+      // the offset, the sizes and the row-major strides.
+      auto data = reinterpret_cast<uintptr_t>(
+          store[any_cast<unsigned>(value)].getData());
+      slots.append({uint64_t(data), uint64_t(data), 0});
+      ArrayRef<int64_t> shape = memrefType.getShape();
+      slots.append(shape.begin(), shape.end());
+      SmallVector<uint64_t, 4> strides(shape.size());
+      int64_t stride = 1;
+      for (unsigned i = shape.size(); i-- > 0;) {
+        strides[i] = stride;
+        stride *= shape[i];
+      }
+      slots.append(strides.begin(), strides.end());
+    } else if (argType.isa<FloatType>()) {
+      slots.push_back(any_cast<APFloat>(value).bitcastToAPInt().getZExtValue());
+    } else if (argType.isIndex()) {
+      slots.push_back(any_cast<APInt>(value).getSExtValue());
+    } else {
+      slots.push_back(any_cast<APInt>(value).getZExtValue());
+    }
+  }
+
+  // A single result is returned as a scalar, several as a struct, into the
+  // storage behind the last pointer.
+  SmallVector<uint64_t, 4> resultData(std::max(type.getNumResults(), 1u));
+  SmallVector<void *, 16> args;
+  for (uint64_t &slot : slots)
+    args.push_back(&slot);
+  if (type.getNumResults())
+    args.push_back(resultData.data());
+
+  if (auto error = engine->invokePacked(name, args)) {
+    errs() << "Failed to run '" << name
+           << "': " << llvm::toString(std::move(error)) << "\n";
+    return false;
+  }
+
+  auto *bytes = reinterpret_cast<const uint8_t *>(resultData.data());
+  unsigned offset = 0;
+  for (auto [i, resultType] : llvm::enumerate(type.getResults())) {
+    unsigned size = getJITScalarBytes(resultType);
+    offset = alignTo(offset, size);
+    uint64_t raw = 0;
+    memcpy(&raw, bytes + offset, size);
+    offset += size;
+    if (auto floatType = resultType.dyn_cast<FloatType>())
+      results[i] = APFloat(floatType.getFloatSemantics(),
+                           APInt(floatType.getWidth(), raw));
+    else if (resultType.isIndex())
+      results[i] = APInt(64, raw).zextOrTrunc(INDEX_WIDTH);
+    else
+      results[i] =
+          APInt(64, raw).zextOrTrunc(resultType.getIntOrFloatBitWidth());
+    resultTimes[i] = 0.0;
+  }
+  return true;
+}
+
 //===----------------------------------------------------------------------===//
 // Simulator entry point
 //===----------------------------------------------------------------------===//
 
 bool simulate(StringRef toplevelFunction, ArrayRef<std::string> inputArgs,
-              mlir::OwningOpRef<mlir::ModuleOp> &module, mlir::MLIRContext &) {
+              mlir::OwningOpRef<mlir::ModuleOp> &module, mlir::MLIRContext &,
+              const SimulationOptions &options, llvm::raw_ostream &out) {
   // The store associates each allocation in the program
   // (represented by a int) with a vector of values which can be
   // accessed by it.  Currently values are assumed to be an integer.
-  std::vector<std::vector<Any>> store;
+  MemoryStore store;
   std::vector<double> storeTimes;
 
   // The valueMap associates each SSA statement in the program
@@ -1000,11 +2065,40 @@ bool simulate(StringRef toplevelFunction, ArrayRef<std::string> inputArgs,
       unsigned buffer = allocateMemRef(memreftype, nothing, store, storeTimes);
       valueMap[blockArgs[i]] = buffer;
       timeMap[blockArgs[i]] = 0.0;
-      int64_t i = 0;
+
+      // 'binary:<file>' fills the memref with the raw little-endian element
+      // data of a file.
+      StringRef inputArg = inputArgs[i];
+      if (inputArg.consume_front("binary:")) {
+        auto file = MemoryBuffer::getFile(inputArg, /*IsText=*/false,
+                                          /*RequiresNullTerminator=*/false);
+        if (!file) {
+          errs() << "Cannot open '" << inputArg
+                 << "': " << file.getError().message() << "\n";
+          return 1;
+        }
+        if (!store[buffer].loadBinary((*file)->getBuffer())) {
+          errs() << "'" << inputArg << "' holds "
+                 << (*file)->getBufferSize() << " bytes, but argument " << i
+                 << " needs " << store[buffer].getElementBytes() << " bytes "
+                 << "for each of its " << store[buffer].size()
+                 << " elements.\n";
+          return 1;
+        }
+        continue;
+      }
+
+      size_t j = 0;
       std::stringstream arg(inputArgs[i]);
       while (!arg.eof()) {
         getline(arg, x, ',');
-        store[buffer][i++] = readValueWithType(memreftype.getElementType(), x);
+        if (j == store[buffer].size()) {
+          errs() << "Argument " << i << " has more than "
+                 << store[buffer].size() << " elements.\n";
+          return 1;
+        }
+        store[buffer].store(j++,
+                            readValueWithType(memreftype.getElementType(), x));
       }
     } else {
       Any value = readValueWithType(type, inputArgs[i]);
@@ -1018,14 +2112,34 @@ bool simulate(StringRef toplevelFunction, ArrayRef<std::string> inputArgs,
   bool succeeded = false;
   if (mlir::func::FuncOp toplevel =
           module->lookupSymbol<mlir::func::FuncOp>(toplevelFunction)) {
-    succeeded = HandshakeExecuter(toplevel, valueMap, timeMap, results,
-                                  resultTimes, store, storeTimes)
-                    .succeeded();
+    // Functions using operations the JIT or the pre-compiled executer do not
+    // support are interpreted instead.
+    JITExecuter jit(store);
+    bool jitted = options.jit && mlir::succeeded(jit.compile(toplevel));
+    PrecompiledExecuter precompiled(store, storeTimes);
+    const CompiledFunction *compiled = options.precompile && !jitted
+                                           ? precompiled.compile(toplevel)
+                                           : nullptr;
+    if (jitted)
+      succeeded = jit.run(blockArgs, valueMap, results, resultTimes);
+    else if (compiled)
+      succeeded = precompiled.run(*compiled, blockArgs, valueMap, timeMap,
+                                  results, resultTimes);
+    else
+      succeeded = HandshakeExecuter(toplevel, valueMap, timeMap, results,
+                                    resultTimes, store, storeTimes)
+                      .succeeded();
   } else if (handshake::FuncOp toplevel =
                  module->lookupSymbol<handshake::FuncOp>(toplevelFunction)) {
+    std::unique_ptr<HandshakeProfile> profile;
+    if (options.profile)
+      profile = std::make_unique<HandshakeProfile>();
     succeeded = HandshakeExecuter(toplevel, valueMap, timeMap, results,
-                                  resultTimes, store, storeTimes, module)
+                                  resultTimes, store, storeTimes, module,
+                                  profile.get())
                     .succeeded();
+    if (profile && succeeded)
+      profile->print(errs(), *module);
   }
 
   if (!succeeded)
@@ -1034,8 +2148,8 @@ bool simulate(StringRef toplevelFunction, ArrayRef<std::string> inputArgs,
   double time = 0.0;
   for (unsigned i = 0; i < results.size(); ++i) {
     mlir::Type t = ftype.getResult(i);
-    printAnyValueWithType(outs(), t, results[i]);
-    outs() << " ";
+    printAnyValueWithType(out, t, results[i]);
+    out << " ";
     time = std::max(resultTimes[i], time);
   }
   // Go back through the arguments and output any memrefs.
@@ -1048,13 +2162,14 @@ bool simulate(StringRef toplevelFunction, ArrayRef<std::string> inputArgs,
       auto elementType = memreftype.getElementType();
       for (int j = 0; j < memreftype.getNumElements(); ++j) {
         if (j != 0)
-          outs() << ",";
-        printAnyValueWithType(outs(), elementType, store[buffer][j]);
+          out << ",";
+        Any element = store[buffer].load(j);
+        printAnyValueWithType(out, elementType, element);
       }
-      outs() << " ";
+      out << " ";
     }
   }
-  outs() << "\n";
+  out << "\n";
 
   simulatedTime += (int)time;
 
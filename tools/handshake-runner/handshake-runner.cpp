@@ -17,7 +17,10 @@
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Parser/Parser.h"
+#include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/SourceMgr.h"
 
@@ -34,16 +37,112 @@ static cl::opt<std::string> inputFileName(cl::Positional,
                                           cl::desc("<input file>"),
                                           cl::init("-"), cl::cat(mainCategory));
 
-static cl::list<std::string> inputArgs(cl::Positional, cl::desc("<input args>"),
-                                       cl::ZeroOrMore, cl::cat(mainCategory));
+static cl::list<std::string>
+    inputArgs(cl::Positional,
+              cl::desc("<input args>, with memrefs given as comma separated "
+                       "elements or as binary:<file> of raw element data"),
+              cl::ZeroOrMore, cl::cat(mainCategory));
 
 static cl::opt<std::string>
     toplevelFunction("top-level-function", cl::Optional,
                      cl::desc("The top-level function to execute"),
                      cl::init("main"), cl::cat(mainCategory));
 
+static cl::opt<bool>
+    precompile("precompile",
+               cl::desc("Lower standard functions to typed instructions once "
+                        "instead of interpreting the IR"),
+               cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<bool>
+    jit("jit",
+        cl::desc("Compile standard functions to native code through the LLVM "
+                 "dialect instead of interpreting the IR"),
+        cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<bool>
+    profile("profile",
+            cl::desc("Print firing counts, channel stalls, buffer occupancy "
+                     "and the critical path of handshake functions to stderr"),
+            cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<std::string> batchFileName(
+    "batch",
+    cl::desc("Run every line of this file as a separate set of input args, "
+             "in parallel, and print the results in the same order"),
+    cl::value_desc("filename"), cl::cat(mainCategory));
+
+/// Split a line of the batch file into input args. Args are separated by
+/// whitespace, except inside the parentheses of a tuple.
+static std::vector<std::string> splitBatchArgs(StringRef line) {
+  std::vector<std::string> args;
+  std::string current;
+  unsigned depth = 0;
+  for (char c : line) {
+    if (c == '(')
+      ++depth;
+    else if (c == ')' && depth > 0)
+      --depth;
+    if (depth == 0 && isSpace(c)) {
+      if (!current.empty())
+        args.push_back(std::move(current));
+      current.clear();
+      continue;
+    }
+    current += c;
+  }
+  if (!current.empty())
+    args.push_back(std::move(current));
+  return args;
+}
+
+/// Simulate the top-level function once per line of the batch file. The
+/// vectors run concurrently on the context's thread pool, each on its own
+/// memory, and the results are printed in input order.
+static int runBatch(mlir::OwningOpRef<mlir::ModuleOp> &module,
+                    mlir::MLIRContext &context,
+                    const handshake::SimulationOptions &options) {
+  auto fileOrErr = MemoryBuffer::getFileOrSTDIN(batchFileName);
+  if (std::error_code error = fileOrErr.getError()) {
+    errs() << "could not open batch file '" << batchFileName
+           << "': " << error.message() << "\n";
+    return 1;
+  }
+
+  // Skip empty lines and '#' comments.
+  std::vector<std::vector<std::string>> vectors;
+  SmallVector<StringRef> lines;
+  (*fileOrErr)->getBuffer().split(lines, '\n');
+  for (StringRef line : lines) {
+    line = line.trim();
+    if (line.empty() || line.startswith("#"))
+      continue;
+    vectors.push_back(splitBatchArgs(line));
+  }
+
+  std::vector<std::string> outputs(vectors.size());
+  std::vector<char> failed(vectors.size());
+  mlir::parallelFor(&context, 0, vectors.size(), [&](size_t i) {
+    raw_string_ostream os(outputs[i]);
+    failed[i] = handshake::simulate(toplevelFunction, vectors[i], module,
+                                    context, options, os);
+  });
+
+  int result = 0;
+  for (size_t i = 0, e = vectors.size(); i < e; ++i) {
+    if (failed[i]) {
+      errs() << "batch vector " << i << " failed\n";
+      result = 1;
+      continue;
+    }
+    outs() << outputs[i];
+  }
+  return result;
+}
+
 int main(int argc, char **argv) {
   InitLLVM y(argc, argv);
+  mlir::registerMLIRContextCLOptions();
 
   // Set the bug report message to indicate users should file issues on
   // llvm/circt and not llvm/llvm-project.
@@ -68,6 +167,12 @@ int main(int argc, char **argv) {
   mlir::MLIRContext context;
   context.loadDialect<func::FuncDialect, memref::MemRefDialect,
                       handshake::HandshakeDialect>();
+  // The JIT lowers to the LLVM dialect, possibly on several threads in batch
+  // mode, so load it up front.
+  if (jit) {
+    context.loadDialect<LLVM::LLVMDialect>();
+    mlir::registerLLVMDialectTranslation(context);
+  }
 
   // functions feeding into HLS tools might have attributes from high(er) level
   // dialects or parsers. Allow unregistered dialects to not fail in these
@@ -89,5 +194,23 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  return handshake::simulate(toplevelFunction, inputArgs, module, context);
+  handshake::SimulationOptions options;
+  options.precompile = precompile;
+  options.jit = jit;
+  options.profile = profile;
+
+  if (!batchFileName.empty()) {
+    if (!inputArgs.empty()) {
+      errs() << "Input args cannot be combined with --batch.\n";
+      return 1;
+    }
+    if (profile) {
+      errs() << "--profile cannot be combined with --batch.\n";
+      return 1;
+    }
+    return runBatch(module, context, options);
+  }
+
+  return handshake::simulate(toplevelFunction, inputArgs, module, context,
+                             options);
 }
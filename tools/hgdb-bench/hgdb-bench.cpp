@@ -0,0 +1,239 @@
+//===- hgdb-bench.cpp - Benchmark the hgdb debug table export -------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Generate a synthetic HW design and measure how long each phase of the hgdb
+// debug table export takes on it, and how much memory it allocates.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Debug/HWDebug.h"
+#include "circt/Dialect/Comb/CombDialect.h"
+#include "circt/Dialect/HW/HWDialect.h"
+#include "circt/Dialect/HW/HWInstanceGraph.h"
+#include "circt/Dialect/SV/SVDialect.h"
+#include "circt/Support/Version.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/FileUtilities.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/WithColor.h"
+
+#include <string>
+
+using namespace llvm;
+using namespace mlir;
+using namespace circt;
+
+static constexpr const char toolName[] = "hgdb-bench";
+static cl::OptionCategory mainCategory("hgdb-bench Options");
+
+static cl::opt<unsigned> numModules("modules",
+                                    cl::desc("Number of generated modules"),
+                                    cl::init(16), cl::cat(mainCategory));
+
+static cl::opt<unsigned> numRegs("regs", cl::desc("Number of regs per module"),
+                                 cl::init(64), cl::cat(mainCategory));
+
+static cl::opt<unsigned> numWires("wires",
+                                  cl::desc("Number of wires per module"),
+                                  cl::init(64), cl::cat(mainCategory));
+
+static cl::opt<unsigned>
+    muxDepth("mux-depth",
+             cl::desc("Depth of the if/else nest around every assignment"),
+             cl::init(4), cl::cat(mainCategory));
+
+static cl::opt<unsigned>
+    numAlways("always", cl::desc("Number of always blocks per module"),
+              cl::init(8), cl::cat(mainCategory));
+
+static cl::opt<unsigned>
+    numIterations("iterations",
+                  cl::desc("Number of exports to average the results over"),
+                  cl::init(1), cl::cat(mainCategory));
+
+static cl::opt<circt::debug::HGDBOutputFormat::Format> outputFormat(
+    "format", cl::desc("Format of the exported table"),
+    cl::values(clEnumValN(circt::debug::HGDBOutputFormat::JSON, "json",
+                          "JSON debug table"),
+               clEnumValN(circt::debug::HGDBOutputFormat::SQL, "sql",
+                          "SQL script")),
+    cl::init(circt::debug::HGDBOutputFormat::JSON), cl::cat(mainCategory));
+
+static cl::opt<bool>
+    conditionCode("condition-code",
+                  cl::desc("Also emit the conditions as bytecode"),
+                  cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<std::string>
+    outputFilename("o", cl::desc("Write the exported table to this file"),
+                   cl::value_desc("filename"), cl::cat(mainCategory));
+
+static cl::opt<bool>
+    printDesign("print-design",
+                cl::desc("Print the generated design and exit"),
+                cl::init(false), cl::cat(mainCategory));
+
+/// Emit the design: `numModules` modules instantiated by a single top module.
+/// Every always block nests its assignments `muxDepth` ifs deep, and each
+/// condition is a comb op so that the expression printer is part of the
+/// measurement.
+static void generateDesign(raw_ostream &os) {
+  unsigned line = 1;
+  auto loc = [&] {
+    return ("loc(\"Bench.scala\":" + Twine(line++) + ":1)").str();
+  };
+  auto depth = std::max(1u, muxDepth.getValue());
+  auto always = std::max(1u, numAlways.getValue());
+
+  for (unsigned m = 0; m < numModules; ++m) {
+    os << "hw.module @Bench" << m << "(%clock: i1, %a: i8";
+    for (unsigned c = 0; c < depth; ++c)
+      os << ", %c" << c << ": i1";
+    os << ") {\n";
+
+    for (unsigned c = 0; c < depth; ++c)
+      os << "  %g" << c << " = comb.and %c" << c << ", %c" << (c + 1) % depth
+         << " : i1 " << loc() << "\n";
+    for (unsigned r = 0; r < numRegs; ++r)
+      os << "  %r" << r << " = sv.reg {hw.debug.name = \"r" << r
+         << "\"} : !hw.inout<i8> " << loc() << "\n";
+    for (unsigned w = 0; w < numWires; ++w) {
+      os << "  %w" << w << " = sv.wire {hw.debug.name = \"w" << w
+         << "\"} : !hw.inout<i8> " << loc() << "\n";
+      os << "  sv.assign %w" << w << ", %a {hw.debug.name = \"w" << w
+         << "\"} : i8 " << loc() << "\n";
+    }
+
+    for (unsigned b = 0; b < always; ++b) {
+      os << "  sv.always posedge %clock {\n";
+      std::string indent = "    ";
+      auto assign = [&](unsigned r) {
+        os << indent << "sv.passign %r" << r << ", %a {hw.debug.name = \"r"
+           << r << "\"} : i8 " << loc() << "\n";
+      };
+      for (unsigned d = 0; d < depth; ++d) {
+        os << indent << "sv.if %g" << d << " {\n";
+        indent += "  ";
+      }
+      for (unsigned r = b; r < numRegs; r += always)
+        assign(r);
+      for (unsigned d = depth; d > 0; --d) {
+        indent.resize(indent.size() - 2);
+        if (b < numRegs) {
+          os << indent << "} else {\n";
+          indent += "  ";
+          assign(b);
+          indent.resize(indent.size() - 2);
+        }
+        os << indent << "} " << loc() << "\n";
+      }
+      os << "  } " << loc() << "\n";
+    }
+    os << "} " << loc() << "\n";
+  }
+
+  os << "hw.module @BenchTop(%clock: i1, %a: i8";
+  for (unsigned c = 0; c < depth; ++c)
+    os << ", %c" << c << ": i1";
+  os << ") {\n";
+  for (unsigned m = 0; m < numModules; ++m) {
+    os << "  hw.instance \"bench" << m << "\" @Bench" << m
+       << "(clock: %clock: i1, a: %a: i8";
+    for (unsigned c = 0; c < depth; ++c)
+      os << ", c" << c << ": %c" << c << ": i1";
+    os << ") -> () " << loc() << "\n";
+  }
+  os << "} " << loc() << "\n";
+}
+
+static void printPhase(raw_ostream &os, StringRef name,
+                       const TimeRecord &record) {
+  os << "  " << left_justify(name, 8)
+     << format("%10.4f s", record.getWallTime() / numIterations)
+     << format("%12.1f KiB", record.getMemUsed() / 1024.0 / numIterations)
+     << "\n";
+}
+
+static LogicalResult execute(MLIRContext &context) {
+  std::string design;
+  {
+    raw_string_ostream os(design);
+    generateDesign(os);
+  }
+  if (printDesign) {
+    outs() << design;
+    return success();
+  }
+
+  auto module = parseSourceString<ModuleOp>(design, &context);
+  if (!module)
+    return failure();
+
+  std::unique_ptr<ToolOutputFile> output;
+  if (!outputFilename.empty()) {
+    std::string err;
+    output = openOutputFile(outputFilename, &err);
+    if (!output) {
+      WithColor::error(errs(), toolName) << err << "\n";
+      return failure();
+    }
+  }
+
+  hw::InstanceGraph instanceGraph(module.get());
+  debug::HGDBExportStatistics stats;
+  for (unsigned i = 0; i < numIterations; ++i) {
+    // only keep the table of the last iteration
+    bool last = i + 1 == numIterations;
+    auto &os = output && last ? output->os() : nulls();
+    debug::exportDebugTable(module.get(), instanceGraph, os, outputFormat,
+                            conditionCode, &stats);
+  }
+  if (output)
+    output->keep();
+
+  auto &os = outs();
+  os << toolName << ": " << stats.numModules / numIterations << " modules, "
+     << stats.numScopes / numIterations << " scopes, "
+     << stats.numVariables / numIterations << " variables\n";
+  printPhase(os, "visit", stats.visit);
+  printPhase(os, "merge", stats.merge);
+  printPhase(os, "emit", stats.emit);
+  auto wallTime = stats.visit.getWallTime() + stats.merge.getWallTime() +
+                  stats.emit.getWallTime();
+  if (wallTime > 0)
+    os << "  " << format("%.0f", stats.numScopes / wallTime)
+       << " scopes/s\n";
+  return success();
+}
+
+int main(int argc, char **argv) {
+  InitLLVM y(argc, argv);
+
+  // Set the bug report message to indicate users should file issues on
+  // llvm/circt and not llvm/llvm-project.
+  setBugReportMsg(circtBugReportMsg);
+
+  mlir::DialectRegistry registry;
+  registry.insert<hw::HWDialect, comb::CombDialect, sv::SVDialect>();
+
+  // Hide default LLVM options, other than for this tool.
+  cl::HideUnrelatedOptions({&mainCategory, &llvm::getColorCategory()});
+
+  cl::ParseCommandLineOptions(argc, argv, "hgdb debug table benchmark\n");
+
+  if (numIterations == 0)
+    numIterations = 1;
+
+  MLIRContext context(registry);
+  exit(failed(execute(context)));
+}
@@ -168,7 +168,7 @@ static cl::opt<bool>
 static cl::opt<std::string>
     bufferingStrategy("buffering-strategy",
                       cl::desc("Strategy to apply. Possible values are: "
-                               "cycles, allFIFO, all (default)"),
+                               "cycles, allFIFO, throughput, all (default)"),
                       cl::init("all"), cl::cat(mainCategory));
 
 static cl::opt<unsigned> bufferSize("buffer-size",
@@ -16,6 +16,7 @@
 #include "circt/Dialect/LLHD/IR/LLHDDialect.h"
 #include "circt/Dialect/LLHD/Simulator/Engine.h"
 #include "circt/Dialect/LLHD/Simulator/Trace.h"
+#include "circt/Dialect/LLHD/Transforms/Passes.h"
 #include "circt/Support/Version.h"
 
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -112,9 +113,57 @@ static cl::opt<TraceMode> traceMode(
             TraceMode::NamedOnly, "named-only",
             "Only dump changes for real-time steps, only for top-level "
             "instance and signals not having the default name '(sig)?[0-9]*'"),
+        clEnumValN(TraceMode::VCD, "vcd",
+                   "Dump a VCD waveform of the changes for real-time steps, "
+                   "for all instances"),
         clEnumValN(TraceMode::None, "none", "Don't dump a signal trace")),
     cl::cat(mainCategory));
 
+static cl::opt<unsigned> numThreads(
+    "threads",
+    cl::desc("Number of threads evaluating the instances of a delta cycle"),
+    cl::init(1), cl::cat(mainCategory));
+
+static cl::opt<std::string>
+    restoreState("restore-state",
+                 cl::desc("Resume the simulation from a saved checkpoint"),
+                 cl::value_desc("filename"), cl::cat(mainCategory));
+
+static cl::opt<std::string> saveState(
+    "save-state",
+    cl::desc("Save a checkpoint of the state the simulation stops in"),
+    cl::value_desc("filename"), cl::cat(mainCategory));
+
+static cl::opt<std::string> emitObject(
+    "emit-object",
+    cl::desc("Compile the design to an object file, to be loaded with "
+             "--load-object instead of compiling the design again"),
+    cl::value_desc("filename"), cl::cat(mainCategory));
+
+static cl::opt<std::string>
+    loadObject("load-object",
+               cl::desc("Load the compiled design from an object file "
+                        "written by --emit-object for the same input"),
+               cl::value_desc("filename"), cl::cat(mainCategory));
+
+static cl::opt<bool> inlineEntities(
+    "inline-entities",
+    cl::desc("Inline the entity instances into their parent entity, such that "
+             "the design is evaluated as fewer, larger units"),
+    cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<bool>
+    batchDrives("batch-drives",
+                cl::desc("Pass all the drives of a unit activation to the "
+                         "runtime at once, instead of one call per drive"),
+                cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<bool>
+    profile("profile",
+            cl::desc("Print how often each instance is evaluated, the events "
+                     "it schedules and the time spent evaluating it"),
+            cl::init(false), cl::cat(mainCategory));
+
 static cl::list<std::string>
     sharedLibs("shared-libs",
                cl::desc("Libraries to link dynamically. Specify absolute path "
@@ -153,7 +202,7 @@ static int dumpLLVM(ModuleOp module, MLIRContext &context) {
 static LogicalResult applyMLIRPasses(ModuleOp module) {
   PassManager pm(module.getContext());
 
-  pm.addPass(createConvertLLHDToLLVMPass());
+  pm.addPass(createConvertLLHDToLLVMPass(batchDrives));
 
   return pm.run(module);
 }
@@ -203,13 +252,30 @@ int main(int argc, char **argv) {
     return 0;
   }
 
+  // Inline the entities before the engine builds the instance layout from the
+  // module.
+  if (inlineEntities) {
+    PassManager pm(&context);
+    pm.addPass(llhd::createEntityInliningPass());
+    if (failed(pm.run(*module)))
+      return 1;
+  }
+
+  if (!emitObject.empty() && !loadObject.empty()) {
+    llvm::errs() << "--emit-object and --load-object are mutually exclusive\n";
+    return 1;
+  }
+
   SmallVector<StringRef, 1> sharedLibPaths(sharedLibs.begin(),
                                            sharedLibs.end());
 
   llhd::sim::Engine engine(
       output->os(), *module, &applyMLIRPasses,
       makeOptimizingTransformer(optimizationLevel, 0, nullptr), root, traceMode,
-      sharedLibPaths);
+      sharedLibPaths, loadObject, !emitObject.empty());
+
+  if (!emitObject.empty())
+    return engine.dumpObject(emitObject) ? 1 : 0;
 
   if (dumpLLVMDialect || dumpLLVMIR) {
     return dumpLLVM(engine.getModule(), context);
@@ -221,7 +287,17 @@ int main(int argc, char **argv) {
     return 0;
   }
 
-  engine.simulate(nSteps, maxTime);
+  if (profile)
+    engine.enableProfiling();
+
+  if (engine.simulate(nSteps, maxTime, numThreads, restoreState))
+    return 1;
+
+  if (profile)
+    engine.printProfile(llvm::errs());
+
+  if (!saveState.empty() && engine.saveState(saveState))
+    return 1;
 
   output->keep();
   return 0;
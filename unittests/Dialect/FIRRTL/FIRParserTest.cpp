@@ -0,0 +1,92 @@
+//===- FIRParserTest.cpp - FIRRTL parser unit tests -----------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/FIRRTL/FIRParser.h"
+#include "circt/Dialect/FIRRTL/FIRRTLDialect.h"
+#include "circt/Dialect/FIRRTL/FIRRTLOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Support/Timing.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+
+using namespace mlir;
+using namespace circt;
+using namespace firrtl;
+
+namespace {
+
+OwningOpRef<ModuleOp> parse(MLIRContext &context, StringRef source) {
+  llvm::SourceMgr sourceMgr;
+  sourceMgr.AddNewSourceBuffer(llvm::MemoryBuffer::getMemBufferCopy(source),
+                               llvm::SMLoc());
+  TimingScope ts;
+  return importFIRFile(sourceMgr, &context, ts);
+}
+
+TEST(FIRParserTest, CommentsAndIdentifiers) {
+  MLIRContext context;
+  context.loadDialect<FIRRTLDialect>();
+
+  // Comments end at a newline, a carriage return or the end of the buffer, and
+  // identifiers may contain '$' and '-'.
+  auto module = parse(context, "circuit Foo : ; comment\r\n"
+                               "  module Foo :;comment\n"
+                               "    input a$b : UInt<1> ; comment\r"
+                               "    output c-d : UInt<1>\n"
+                               "\t\n"
+                               "    c-d <= a$b ; comment at the end");
+  ASSERT_TRUE(module);
+
+  auto circuit = *module->getOps<CircuitOp>().begin();
+  auto foo = cast<FModuleOp>(*circuit.getOps<FModuleOp>().begin());
+  auto portNames = foo.getPortNames();
+  ASSERT_EQ(portNames.size(), 2u);
+  EXPECT_EQ(portNames[0].cast<StringAttr>().getValue(), "a$b");
+  EXPECT_EQ(portNames[1].cast<StringAttr>().getValue(), "c-d");
+}
+
+/// A lexer-bound microbenchmark: a circuit dominated by indentation, comments
+/// and identifiers. Run it with --gtest_also_run_disabled_tests.
+TEST(FIRParserTest, DISABLED_LexerThroughput) {
+  MLIRContext context;
+  context.loadDialect<FIRRTLDialect>();
+
+  constexpr unsigned numModules = 64, numPorts = 512;
+  std::string source;
+  llvm::raw_string_ostream os(source);
+  os << "circuit Bench :\n";
+  for (unsigned m = 0; m < numModules; ++m) {
+    os << "  module " << (m ? "Bench_" + std::to_string(m) : "Bench")
+       << " : ; a module with a long comment after it\n";
+    for (unsigned p = 0; p < numPorts; ++p)
+      os << "    input in_" << p << "_signal_with_a_long_name : UInt<8>"
+         << "        ; comment\n";
+    for (unsigned p = 0; p < numPorts; ++p)
+      os << "    output out_" << p << "_signal_with_a_long_name : UInt<8>\n";
+    for (unsigned p = 0; p < numPorts; ++p)
+      os << "    out_" << p << "_signal_with_a_long_name <= in_" << p
+         << "_signal_with_a_long_name ; connect the port through\n";
+  }
+  os.flush();
+
+  auto start = std::chrono::steady_clock::now();
+  auto module = parse(context, source);
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  ASSERT_TRUE(module);
+
+  double mebibytes = source.size() / (1024.0 * 1024.0);
+  llvm::errs() << "parsed " << mebibytes << " MiB in " << elapsed.count()
+               << " s (" << mebibytes / elapsed.count() << " MiB/s)\n";
+}
+
+} // namespace
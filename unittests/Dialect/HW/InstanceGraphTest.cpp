@@ -77,4 +77,63 @@ TEST(InstanceGraphTest, PostOrderTraversal) {
   ASSERT_EQ(range.end(), it);
 }
 
+TEST(InstanceGraphTest, IncrementalUpdates) {
+  MLIRContext context;
+  context.loadDialect<HWDialect>();
+
+  // Build the following graph:
+  // hw.module @Top() {
+  //   hw.instance "bear" @Bear() -> ()
+  // }
+  // hw.module private @Bear() { }
+  // hw.module private @Cat() { }
+  LocationAttr loc = UnknownLoc::get(&context);
+  auto module = ModuleOp::create(loc);
+  auto builder = ImplicitLocOpBuilder::atBlockEnd(loc, module.getBody());
+
+  auto top = builder.create<HWModuleOp>(StringAttr::get(&context, "Top"),
+                                        ArrayRef<PortInfo>{});
+  auto bear = builder.create<HWModuleOp>(StringAttr::get(&context, "Bear"),
+                                         ArrayRef<PortInfo>{});
+  auto cat = builder.create<HWModuleOp>(StringAttr::get(&context, "Cat"),
+                                        ArrayRef<PortInfo>{});
+  bear.setPrivate();
+  cat.setPrivate();
+
+  builder.setInsertionPointToStart(top.getBodyBlock());
+  builder.create<InstanceOp>(bear, "bear", ArrayRef<Value>{});
+
+  InstanceGraph graph(module);
+  auto names = [](ArrayRef<InstanceGraphNode *> nodes) {
+    SmallVector<StringRef> result;
+    for (auto *node : nodes)
+      if (auto module = node->getModule())
+        result.push_back(module.moduleName());
+    return result;
+  };
+
+  // The unused module is only part of the inverse topological order.
+  EXPECT_EQ(names(graph.getPostOrder()),
+            (SmallVector<StringRef>{"Bear", "Top"}));
+  EXPECT_EQ(names(graph.getInverseTopologicalOrder()),
+            (SmallVector<StringRef>{"Bear", "Top", "Cat"}));
+
+  // Adding instances updates the graph and the cached orders.
+  builder.setInsertionPointToStart(bear.getBodyBlock());
+  auto cat0 = builder.create<InstanceOp>(cat, "cat0", ArrayRef<Value>{});
+  auto cat1 = builder.create<InstanceOp>(cat, "cat1", ArrayRef<Value>{});
+  graph.addInstances({cat0, cat1});
+  EXPECT_EQ(graph.lookup(cat)->getNumUses(), 2u);
+  EXPECT_EQ(names(graph.getPostOrder()),
+            (SmallVector<StringRef>{"Cat", "Bear", "Top"}));
+
+  // So does erasing them.
+  graph.eraseInstances({cat0, cat1});
+  cat0.erase();
+  cat1.erase();
+  EXPECT_TRUE(graph.lookup(cat)->noUses());
+  EXPECT_EQ(names(graph.getPostOrder()),
+            (SmallVector<StringRef>{"Bear", "Top"}));
+}
+
 } // namespace
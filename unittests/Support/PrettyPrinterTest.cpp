@@ -10,6 +10,8 @@
 #include "circt/Support/PrettyPrinterHelpers.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "gtest/gtest.h"
@@ -838,4 +840,79 @@ TEST_F(TokenStreamCompareTest, Numeric) {
   test(1. / 3.);
 }
 
+//===----------------------------------------------------------------------===//
+// Throughput microbenchmarks. Run them with --gtest_also_run_disabled_tests.
+//===----------------------------------------------------------------------===//
+
+/// Print the tokens built for each breaking style a number of times to a null
+/// stream, and report the throughput and the memory held by the printer once
+/// all tokens have been added.
+template <typename BuildFn>
+static void measureThroughput(StringRef name, BuildFn &&build,
+                              unsigned iterations = 16) {
+  for (auto breaks : {Breaks::Consistent, Breaks::Inconsistent}) {
+    SmallVector<Token> tokens;
+    build(tokens, breaks);
+
+    ssize_t memUsed = 0;
+    auto start = TimeRecord::getCurrentTime(/*Start=*/true);
+    for (unsigned i = 0; i < iterations; ++i) {
+      PrettyPrinter pp(nulls(), 90);
+      pp.addTokens(tokens);
+      if (i == 0)
+        memUsed = TimeRecord::getCurrentTime(/*Start=*/false).getMemUsed() -
+                  start.getMemUsed();
+      pp.eof();
+    }
+    auto elapsed = TimeRecord::getCurrentTime(/*Start=*/false);
+    elapsed -= start;
+
+    double numTokens = double(tokens.size()) * iterations;
+    errs() << name
+           << (breaks == Breaks::Consistent ? " (consistent): "
+                                            : " (inconsistent): ")
+           << format("%.0f", numTokens / elapsed.getWallTime())
+           << " tokens/s, " << memUsed / 1024 << " KiB held\n";
+  }
+}
+
+TEST(PrettyPrinterTest, DISABLED_DeepNestingThroughput) {
+  measureThroughput("deep nesting", [](auto &tokens, Breaks breaks) {
+    constexpr unsigned numStatements = 64, depth = 512;
+    for (unsigned s = 0; s < numStatements; ++s) {
+      for (unsigned d = 0; d < depth; ++d)
+        tokens.append({StringToken("func("), BeginToken(2, breaks),
+                       BreakToken(0)});
+      tokens.push_back(StringToken("x"));
+      for (unsigned d = 0; d < depth; ++d)
+        tokens.append({BreakToken(0), EndToken(), StringToken(")")});
+      tokens.push_back(BreakToken(PrettyPrinter::kInfinity));
+    }
+  });
+}
+
+TEST(PrettyPrinterTest, DISABLED_LongExpressionThroughput) {
+  measureThroughput("long expression", [](auto &tokens, Breaks breaks) {
+    constexpr unsigned numTerms = 1 << 16;
+    tokens.append({StringToken("assign x ="), BeginToken(2, breaks),
+                   BreakToken()});
+    for (unsigned t = 0; t < numTerms; ++t)
+      tokens.append(
+          {StringToken("some_long_operand"), BreakToken(), StringToken("+")});
+    tokens.append({BreakToken(), StringToken("y;"), EndToken(),
+                   BreakToken(PrettyPrinter::kInfinity)});
+  });
+}
+
+TEST(PrettyPrinterTest, DISABLED_ShortStatementsThroughput) {
+  measureThroughput("short statements", [](auto &tokens, Breaks breaks) {
+    constexpr unsigned numStatements = 1 << 16;
+    for (unsigned s = 0; s < numStatements; ++s)
+      tokens.append({BeginToken(2, breaks), StringToken("assign"),
+                     BreakToken(), StringToken("x"), BreakToken(),
+                     StringToken("="), BreakToken(), StringToken("y;"),
+                     EndToken(), BreakToken(PrettyPrinter::kInfinity)});
+  });
+}
+
 } // end anonymous namespace
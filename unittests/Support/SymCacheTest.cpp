@@ -0,0 +1,69 @@
+//===- SymCacheTest.cpp - Symbol cache unit tests -------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Support/SymCache.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Threading.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Twine.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+
+using namespace mlir;
+using namespace circt;
+
+namespace {
+
+TEST(LazySymbolCacheTest, ConcurrentLookups) {
+  MLIRContext context;
+  auto loc = UnknownLoc::get(&context);
+  auto top = ModuleOp::create(loc);
+  OpBuilder builder = OpBuilder::atBlockEnd(top.getBody());
+
+  // Nested modules are the symbols of the top-level module.
+  constexpr unsigned numSymbols = 256;
+  SmallVector<StringAttr> names;
+  SmallVector<Operation *> ops;
+  for (unsigned i = 0; i < numSymbols; ++i) {
+    names.push_back(builder.getStringAttr("sym" + Twine(i)));
+    ops.push_back(builder.create<ModuleOp>(loc, names.back().getValue()));
+  }
+
+  LazySymbolCache cache(top);
+  std::atomic<unsigned> numMismatches(0);
+  parallelFor(&context, 0, numSymbols, [&](size_t i) {
+    if (cache.getDefinition(names[i]) != ops[i])
+      ++numMismatches;
+  });
+  EXPECT_EQ(numMismatches, 0u);
+  EXPECT_EQ(cache.getDefinition(builder.getStringAttr("missing")), nullptr);
+
+  // Definitions can be added after the symbols have been collected, and the
+  // first definition of a symbol wins.
+  auto extra = builder.getStringAttr("extra");
+  cache.addDefinition(extra, top);
+  cache.addDefinition(names[0], top);
+  EXPECT_EQ(cache.getDefinition(extra), top.getOperation());
+  EXPECT_EQ(cache.getDefinition(names[0]), ops[0]);
+
+  // Iteration visits every entry once.
+  unsigned numEntries = 0;
+  for (auto [symbol, op] : cache) {
+    (void)symbol;
+    (void)op;
+    ++numEntries;
+  }
+  EXPECT_EQ(numEntries, numSymbols + 1);
+
+  top.erase();
+}
+
+} // namespace
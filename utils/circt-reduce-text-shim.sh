@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+##===- utils/circt-reduce-text-shim.sh - Textual tests ------*- Script -*-===##
+#
+# Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+#
+##===----------------------------------------------------------------------===##
+#
+# This script lets `circt-reduce --test-bytecode` drive interestingness tests
+# that only accept textual MLIR. It converts the test case, which circt-reduce
+# passes as the last argument, back to text with circt-dis and runs the actual
+# test on the result. Set CIRCT_DIS to use a specific circt-dis binary.
+#
+# Usage circt-reduce --test-bytecode --test circt-reduce-text-shim.sh
+#                    --test-arg test.sh [--test-arg ...] input.mlir
+#
+##===----------------------------------------------------------------------===##
+set -o pipefail
+
+testcase="${@: -1}"
+if [[ "$testcase" != *.mlirbc ]]; then
+  exec "$@"
+fi
+textfile="${testcase%.mlirbc}.mlir"
+trap 'rm -f "$textfile"' EXIT
+
+"${CIRCT_DIS:-circt-dis}" "$testcase" -o "$textfile" || exit 125
+"${@:1:$#-1}" "$textfile"
@@ -0,0 +1,305 @@
+#!/usr/bin/env python3
+##===- utils/firtool-bench.py - firtool compile benchmark -*- python -*-===##
+#
+# Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+#
+##===----------------------------------------------------------------------===##
+#
+# This script measures the compile time and memory use of firtool. It generates
+# a corpus of synthetic FIRRTL circuits, each stressing a different part of the
+# pipeline (deep hierarchies, wide vectors, nested whens, many annotations and
+# many memories), at growing sizes. Every circuit is compiled with a fixed set
+# of options while firtool is restricted to 1, 4, 16 and 64 cores, and the
+# per-pass wall time and peak RSS reported by `--pass-memory-report` are
+# collected.
+#
+# The results are written as a JSON list with one record per compilation:
+#
+#   {"case": "hierarchy", "scale": 4, "threads": 16, "total": 1.27,
+#    "peak_rss": 183173120,
+#    "passes": {"LowerFIRRTLTypes": {"wall": 0.02, "peak_rss": 1814528}, ...}}
+#
+# MLIR sizes its thread pool by the CPU affinity of the process, so the thread
+# count is set by restricting the affinity. Thread counts above the number of
+# available cores are skipped.
+#
+# Usage firtool-bench.py --firtool path/to/firtool [--output results.json]
+#
+##===----------------------------------------------------------------------===##
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+SCALES = [1, 2, 4, 8]
+THREADS = [1, 4, 16, 64]
+
+# The options all circuits are compiled with, so that results stay comparable
+# across revisions.
+FIRTOOL_OPTIONS = ["--verilog", "--disable-annotation-unknown"]
+
+# --------------------------------------------------------------------------
+# Circuit generators
+# --------------------------------------------------------------------------
+
+
+class CircuitBuilder:
+  """Collects the modules and annotations of a FIRRTL circuit."""
+
+  def __init__(self, name):
+    self.name = name
+    self.modules = []
+    self.annotations = []
+
+  def module(self, name, body):
+    self.modules.append(f"  module {name}:\n" +
+                        "".join(f"    {line}\n" for line in body))
+
+  def dont_touch(self, module, name):
+    self.annotations.append({
+        "class": "firrtl.transforms.DontTouchAnnotation",
+        "target": f"~{self.name}|{module}>{name}"
+    })
+
+  def finish(self):
+    return f"circuit {self.name}:\n" + "\n".join(self.modules)
+
+
+def hierarchy(scale):
+  """A binary tree of modules, `4 + scale` levels deep, with a register and a
+  few operations in every module."""
+  b = CircuitBuilder("Top")
+  depth = 4 + scale
+  ports = ["input clock: Clock", "input in: UInt<16>", "output out: UInt<16>"]
+  b.module(f"Node{depth}", ports + [
+      "reg r: UInt<16>, clock", "r <= tail(add(in, UInt<16>(1)), 1)",
+      "out <= xor(r, in)"
+  ])
+  for level in reversed(range(depth)):
+    child = f"Node{level + 1}"
+    b.module(f"Node{level}", ports + [
+        f"inst left of {child}", f"inst right of {child}",
+        "left.clock <= clock", "right.clock <= clock", "left.in <= in",
+        "right.in <= not(in)", "reg r: UInt<16>, clock",
+        "r <= tail(add(left.out, right.out), 1)", "out <= r"
+    ])
+  b.module("Top", ports + [
+      "inst root of Node0", "root.clock <= clock", "root.in <= in",
+      "out <= root.out"
+  ])
+  return b
+
+
+def wide_vectors(scale):
+  """Vectors of `64 * scale` elements, accessed with dynamic indices and
+  registered, which stress type lowering and the vector transforms."""
+  b = CircuitBuilder("Top")
+  width = 64 * scale
+  index = max(1, (width - 1).bit_length())
+  b.module("Top", [
+      "input clock: Clock",
+      f"input in: UInt<8>[{width}]",
+      f"input rIdx: UInt<{index}>",
+      f"input wIdx: UInt<{index}>",
+      "input wData: UInt<8>",
+      f"output out: UInt<8>[{width}]",
+      "output sel: UInt<8>",
+      f"reg r: UInt<8>[{width}], clock",
+      "r <= in",
+      "r[wIdx] <= wData",
+      "out <= r",
+      "sel <= r[rIdx]",
+  ])
+  return b
+
+
+def when_nesting(scale):
+  """Nested whens, `2 * scale` levels deep, each of them driving every output
+  of the module."""
+  b = CircuitBuilder("Top")
+  depth = 2 * scale
+  outputs = 16
+  body = ["input clock: Clock", f"input cond: UInt<{depth}>"]
+  body += [f"input in{i}: UInt<8>" for i in range(outputs)]
+  body += [f"output out{i}: UInt<8>" for i in range(outputs)]
+  body += [f"out{i} <= in{i}" for i in range(outputs)]
+
+  def nest(level, indent):
+    if level == depth:
+      return []
+    pad = "  " * indent
+    lines = [f"{pad}when bits(cond, {level}, {level}):"]
+    lines += [
+        f"{pad}  out{i} <= tail(add(in{(i + level) % outputs}, "
+        f"UInt<8>({level})), 1)"
+        for i in range(outputs)
+    ]
+    lines += nest(level + 1, indent + 1)
+    lines += [f"{pad}else:"]
+    lines += [f"{pad}  out{i} <= xor(in{i}, UInt<8>({level}))"
+              for i in range(outputs)]
+    return lines
+
+  b.module("Top", body + nest(0, 0))
+  return b
+
+
+def annotations(scale):
+  """`256 * scale` wires, all of them marked don't touch through the
+  annotation file."""
+  b = CircuitBuilder("Top")
+  count = 256 * scale
+  body = ["input in: UInt<8>", "output out: UInt<8>"]
+  previous = "in"
+  for i in range(count):
+    body += [f"wire w{i}: UInt<8>", f"w{i} <= {previous}"]
+    b.dont_touch("Top", f"w{i}")
+    previous = f"w{i}"
+  body.append(f"out <= {previous}")
+  b.module("Top", body)
+  return b
+
+
+def memories(scale):
+  """`16 * scale` memories of different shapes, each with a read and a write
+  port."""
+  b = CircuitBuilder("Top")
+  count = 16 * scale
+  body = [
+      "input clock: Clock", "input en: UInt<1>", "input addr: UInt<10>",
+      "input data: UInt<32>", "output out: UInt<32>"
+  ]
+  result = "UInt<32>(0)"
+  for i in range(count):
+    depth = 1 << (4 + i % 7)
+    addrWidth = (depth - 1).bit_length()
+    body += [
+        f"mem m{i}:", "  data-type => UInt<32>", f"  depth => {depth}",
+        "  reader => r", "  writer => w", "  read-latency => 1",
+        "  write-latency => 1", "  read-under-write => undefined",
+        f"m{i}.r.clk <= clock", f"m{i}.r.en <= en",
+        f"m{i}.r.addr <= bits(addr, {addrWidth - 1}, 0)",
+        f"m{i}.w.clk <= clock", f"m{i}.w.en <= en",
+        f"m{i}.w.addr <= bits(addr, {addrWidth - 1}, 0)",
+        f"m{i}.w.mask <= UInt<1>(1)", f"m{i}.w.data <= data"
+    ]
+    result = f"xor({result}, m{i}.r.data)"
+    # Keep the expression trees shallow to not stress the parser instead.
+    body += [f"node x{i} = {result}"]
+    result = f"x{i}"
+  body.append(f"out <= {result}")
+  b.module("Top", body)
+  return b
+
+
+CASES = {
+    "hierarchy": hierarchy,
+    "wide-vectors": wide_vectors,
+    "when-nesting": when_nesting,
+    "annotations": annotations,
+    "memories": memories,
+}
+
+# --------------------------------------------------------------------------
+# Compilation
+# --------------------------------------------------------------------------
+
+
+def run(firtool, circuit, threads, workdir):
+  fir = os.path.join(workdir, "input.fir")
+  anno = os.path.join(workdir, "input.anno.json")
+  report = os.path.join(workdir, "report.json")
+  with open(fir, "w") as f:
+    f.write(circuit.finish())
+  cmd = [firtool, fir, "-o", os.devnull, f"--pass-memory-report={report}"]
+  cmd += FIRTOOL_OPTIONS
+  if circuit.annotations:
+    with open(anno, "w") as f:
+      json.dump(circuit.annotations, f)
+    cmd.append(f"--annotation-file={anno}")
+  cores = sorted(os.sched_getaffinity(0))[:threads]
+
+  # Wait for the process with wait4 to get the peak RSS of firtool alone,
+  # rather than the maximum over all children of this script.
+  with tempfile.TemporaryFile(mode="w+") as stderr:
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd,
+                            stdout=subprocess.DEVNULL,
+                            stderr=stderr,
+                            preexec_fn=lambda: os.sched_setaffinity(0, cores))
+    _, status, usage = os.wait4(proc.pid, 0)
+    total = time.perf_counter() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    if proc.returncode != 0:
+      stderr.seek(0)
+      sys.stderr.write(stderr.read())
+      raise RuntimeError(f"'{' '.join(cmd)}' failed")
+
+  passes = {}
+  with open(report) as f:
+    for record in json.load(f):
+      entry = passes.setdefault(record["pass"], {"wall": 0.0, "peak_rss": 0})
+      entry["wall"] += record["wall_us"] / 1e6
+      entry["peak_rss"] = max(entry["peak_rss"], record["after"]["peak_rss"])
+  # ru_maxrss is in kilobytes on Linux.
+  return total, usage.ru_maxrss * 1024, passes
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description="Measure the compile time and memory use of firtool.")
+  parser.add_argument("--firtool", required=True, help="Path to firtool")
+  parser.add_argument("--output", help="JSON file to write the results to")
+  parser.add_argument("--cases",
+                      nargs="+",
+                      choices=sorted(CASES),
+                      default=sorted(CASES))
+  parser.add_argument("--scales", nargs="+", type=int, default=SCALES)
+  parser.add_argument("--threads", nargs="+", type=int, default=THREADS)
+  parser.add_argument("--emit-circuit",
+                      action="store_true",
+                      help="Print the circuits instead of compiling them")
+  args = parser.parse_args()
+
+  available = len(os.sched_getaffinity(0))
+  threads = [t for t in args.threads if t <= available]
+  skipped = [t for t in args.threads if t > available]
+  if skipped and not args.emit_circuit:
+    print(f"skipping {skipped} threads, only {available} cores available",
+          file=sys.stderr)
+
+  results = []
+  with tempfile.TemporaryDirectory() as workdir:
+    for name in args.cases:
+      for scale in args.scales:
+        circuit = CASES[name](scale)
+        if args.emit_circuit:
+          print(f"; {name}, scale {scale}\n{circuit.finish()}")
+          continue
+        for count in threads:
+          total, peakRSS, passes = run(args.firtool, circuit, count, workdir)
+          results.append({
+              "case": name,
+              "scale": scale,
+              "threads": count,
+              "total": total,
+              "peak_rss": peakRSS,
+              "passes": passes
+          })
+          print(f"{name:13} x{scale:<3} {count:3} threads {total:8.4f}s "
+                f"{peakRSS / 2**20:8.1f} MiB",
+                flush=True)
+
+  if args.output and not args.emit_circuit:
+    with open(args.output, "w") as f:
+      json.dump(results, f, indent=2)
+
+
+if __name__ == "__main__":
+  main()
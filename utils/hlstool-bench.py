@@ -0,0 +1,303 @@
+#!/usr/bin/env python3
+##===- utils/hlstool-bench.py - HLS compile-time benchmark -*- python -*-===##
+#
+# Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+#
+##===----------------------------------------------------------------------===##
+#
+# This script measures the compile time of the hlstool flows. It generates a
+# set of parameterized kernels (matmul, FIR, stencil) at growing unroll
+# factors, compiles each of them with every dynamic HLS flow and collects the
+# per-pass wall times reported by `--mlir-timing`.
+#
+# The results are written as a JSON list with one record per compilation:
+#
+#   {"kernel": "fir", "unroll": 4, "flow": "dynamic-hw",
+#    "total": 0.51, "passes": {"StandardToHandshake": 0.02, ...}}
+#
+# Usage hlstool-bench.py --hlstool path/to/hlstool [--output results.json]
+#
+##===----------------------------------------------------------------------===##
+
+import argparse
+import json
+import re
+import subprocess
+import sys
+
+FLOWS = ["dynamic-firrtl", "dynamic-hw"]
+UNROLL_FACTORS = [1, 2, 4, 8, 16]
+
+# --------------------------------------------------------------------------
+# Kernel generators
+# --------------------------------------------------------------------------
+
+
+class KernelBuilder:
+  """Emits the body of a `func.func @top() -> i32` in SCF form, with fresh SSA
+  names for every value."""
+
+  def __init__(self):
+    self.lines = []
+    self.indent = 2
+    self.counter = 0
+    self.constants = {}
+
+  def fresh(self):
+    self.counter += 1
+    return f"%v{self.counter}"
+
+  def emit(self, line):
+    self.lines.append("  " * self.indent + line)
+
+  def index(self, value):
+    # Constants are hoisted to the entry block, so that they dominate all uses.
+    if value not in self.constants:
+      self.constants[value] = f"%c{value}"
+    return self.constants[value]
+
+  def op(self, text, type):
+    name = self.fresh()
+    self.emit(f"{name} = {text} : {type}")
+    return name
+
+  def add_index(self, lhs, offset):
+    if offset == 0:
+      return lhs
+    return self.op(f"arith.addi {lhs}, {self.index(offset)}", "index")
+
+  def alloc(self, size):
+    return self.op("memref.alloc()", f"memref<{size}xi32>")
+
+  def load(self, mem, size, idx):
+    return self.op(f"memref.load {mem}[{idx}]", f"memref<{size}xi32>")
+
+  def store(self, value, mem, size, idx):
+    self.emit(f"memref.store {value}, {mem}[{idx}] : memref<{size}xi32>")
+
+  def init(self, mem, size):
+    """Fill a memory with its indices."""
+    self.for_loop(
+        0, size, 1, lambda i: self.store(
+            self.op(f"arith.index_cast {i}", "index to i32"), mem, size, i))
+
+  def for_loop(self, lb, ub, step, body):
+    lb, ub, step = self.index(lb), self.index(ub), self.index(step)
+    iv = self.fresh()
+    self.emit(f"scf.for {iv} = {lb} to {ub} step {step} {{")
+    self.indent += 1
+    body(iv)
+    self.indent -= 1
+    self.emit("}")
+
+  def reduce_loop(self, lb, ub, step, init, body):
+    """Emit a loop carrying an i32 accumulator, which `body` updates."""
+    lb, ub, step = self.index(lb), self.index(ub), self.index(step)
+    iv, acc, result = self.fresh(), self.fresh(), self.fresh()
+    self.emit(f"{result} = scf.for {iv} = {lb} to {ub} step {step} "
+              f"iter_args({acc} = {init}) -> (i32) {{")
+    self.indent += 1
+    self.emit(f"scf.yield {body(iv, acc)} : i32")
+    self.indent -= 1
+    self.emit("}")
+    return result
+
+  def finish(self, result):
+    self.emit(f"return {result} : i32")
+    constants = [
+        f"    {name} = arith.constant {value} : index"
+        for value, name in self.constants.items()
+    ]
+    body = "\n".join(constants + self.lines)
+    return f"func.func @top() -> i32 {{\n{body}\n}}\n"
+
+
+def matmul(unroll, n=16):
+  """A n x n matrix multiplication with the reduction loop unrolled."""
+  b = KernelBuilder()
+  zero = b.op("arith.constant 0", "i32")
+  size = n * n
+  lhs, rhs, out = b.alloc(size), b.alloc(size), b.alloc(size)
+  b.init(lhs, size)
+  b.init(rhs, size)
+
+  def row(i):
+    rowBase = b.op(f"arith.muli {i}, {b.index(n)}", "index")
+
+    def col(j):
+
+      def dot(k, acc):
+        for u in range(unroll):
+          ku = b.add_index(k, u)
+          lidx = b.op(f"arith.addi {rowBase}, {ku}", "index")
+          kn = b.op(f"arith.muli {ku}, {b.index(n)}", "index")
+          ridx = b.op(f"arith.addi {kn}, {j}", "index")
+          prod = b.op(
+              f"arith.muli {b.load(lhs, size, lidx)}, "
+              f"{b.load(rhs, size, ridx)}", "i32")
+          acc = b.op(f"arith.addi {acc}, {prod}", "i32")
+        return acc
+
+      sum = b.reduce_loop(0, n, unroll, zero, dot)
+      b.store(sum, out, size, b.op(f"arith.addi {rowBase}, {j}", "index"))
+
+    b.for_loop(0, n, 1, col)
+
+  b.for_loop(0, n, 1, row)
+  return b.finish(b.load(out, size, b.index(size - 1)))
+
+
+def fir(unroll, taps=16, samples=64):
+  """A FIR filter with the loop over the taps unrolled."""
+  b = KernelBuilder()
+  zero = b.op("arith.constant 0", "i32")
+  xsize = samples + taps
+  x, h, y = b.alloc(xsize), b.alloc(taps), b.alloc(samples)
+  b.init(x, xsize)
+  b.init(h, taps)
+
+  def sample(i):
+
+    def mac(t, acc):
+      for u in range(unroll):
+        tu = b.add_index(t, u)
+        xidx = b.op(f"arith.addi {i}, {tu}", "index")
+        prod = b.op(
+            f"arith.muli {b.load(x, xsize, xidx)}, {b.load(h, taps, tu)}",
+            "i32")
+        acc = b.op(f"arith.addi {acc}, {prod}", "i32")
+      return acc
+
+    b.store(b.reduce_loop(0, taps, unroll, zero, mac), y, samples, i)
+
+  b.for_loop(0, samples, 1, sample)
+  return b.finish(b.load(y, samples, b.index(samples - 1)))
+
+
+def stencil(unroll, n=34):
+  """A 5-point stencil over a n x n grid with the inner loop unrolled."""
+  b = KernelBuilder()
+  size = n * n
+  src, dst = b.alloc(size), b.alloc(size)
+  b.init(src, size)
+
+  def row(i):
+    rowBase = b.op(f"arith.muli {i}, {b.index(n)}", "index")
+
+    def col(j):
+      for u in range(unroll):
+        center = b.op(f"arith.addi {rowBase}, {b.add_index(j, u)}", "index")
+        neighbours = [
+            center,
+            b.op(f"arith.subi {center}, {b.index(1)}", "index"),
+            b.add_index(center, 1),
+            b.op(f"arith.subi {center}, {b.index(n)}", "index"),
+            b.add_index(center, n),
+        ]
+        values = [b.load(src, size, idx) for idx in neighbours]
+        sum = values[0]
+        for value in values[1:]:
+          sum = b.op(f"arith.addi {sum}, {value}", "i32")
+        b.store(sum, dst, size, center)
+
+    b.for_loop(1, n - 1, unroll, col)
+
+  b.for_loop(1, n - 1, 1, row)
+  return b.finish(b.load(dst, size, b.index(n + 1)))
+
+
+KERNELS = {"matmul": matmul, "fir": fir, "stencil": stencil}
+
+# --------------------------------------------------------------------------
+# Timing report parsing
+# --------------------------------------------------------------------------
+
+# A line of the `--mlir-timing-display=list` report, such as
+#   "    0.0105 ( 51.8%)    0.0105 ( 51.8%)  Canonicalizer".
+# The last time column is the wall time.
+TIMING_LINE = re.compile(r"^\s*((?:[\d.]+ \(\s*[\d.]+%\)\s+)+)(\S.*?)\s*$")
+TIME_COLUMN = re.compile(r"([\d.]+) \(\s*[\d.]+%\)")
+TOTAL_LINE = re.compile(r"Total Execution Time: ([\d.]+) seconds")
+
+
+def parse_timing(report):
+  total = None
+  passes = {}
+  for line in report.splitlines():
+    match = TOTAL_LINE.search(line)
+    if match:
+      total = float(match.group(1))
+      continue
+    match = TIMING_LINE.match(line)
+    if not match or match.group(2) == "Total":
+      continue
+    wall = float(TIME_COLUMN.findall(match.group(1))[-1])
+    passes[match.group(2)] = passes.get(match.group(2), 0.0) + wall
+  return total, passes
+
+
+def run(hlstool, kernel, flow):
+  cmd = [
+      hlstool, "-", f"--{flow}", "--verilog", "-o", "/dev/null",
+      "--mlir-timing", "--mlir-timing-display=list"
+  ]
+  proc = subprocess.run(cmd,
+                        input=kernel,
+                        capture_output=True,
+                        universal_newlines=True)
+  if proc.returncode != 0:
+    sys.stderr.write(proc.stderr)
+    raise RuntimeError(f"'{' '.join(cmd)}' failed")
+  return parse_timing(proc.stderr)
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description="Measure the compile time of the hlstool flows.")
+  parser.add_argument("--hlstool", required=True, help="Path to hlstool")
+  parser.add_argument("--output", help="JSON file to write the timings to")
+  parser.add_argument("--kernels",
+                      nargs="+",
+                      choices=sorted(KERNELS),
+                      default=sorted(KERNELS))
+  parser.add_argument("--unroll",
+                      nargs="+",
+                      type=int,
+                      default=UNROLL_FACTORS,
+                      help="Unroll factors, which must divide 16")
+  parser.add_argument("--flows", nargs="+", choices=FLOWS, default=FLOWS)
+  parser.add_argument("--emit-kernel",
+                      action="store_true",
+                      help="Print the kernels instead of compiling them")
+  args = parser.parse_args()
+
+  if any(16 % u != 0 for u in args.unroll):
+    parser.error("unroll factors must divide 16")
+
+  results = []
+  for name in args.kernels:
+    for unroll in args.unroll:
+      kernel = KERNELS[name](unroll)
+      if args.emit_kernel:
+        print(f"// {name}, unroll {unroll}\n{kernel}")
+        continue
+      for flow in args.flows:
+        total, passes = run(args.hlstool, kernel, flow)
+        results.append({
+            "kernel": name,
+            "unroll": unroll,
+            "flow": flow,
+            "total": total,
+            "passes": passes
+        })
+        print(f"{name:8} x{unroll:<3} {flow:15} {total:8.4f}s", flush=True)
+
+  if args.output and not args.emit_kernel:
+    with open(args.output, "w") as f:
+      json.dump(results, f, indent=2)
+
+
+if __name__ == "__main__":
+  main()
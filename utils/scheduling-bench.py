@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+##===- utils/scheduling-bench.py - Scheduler benchmark -----*- python -*-===##
+#
+# Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+#
+##===----------------------------------------------------------------------===##
+#
+# This script compares the schedulers of the scheduling infrastructure on a
+# corpus of problem instances in the SSP dialect. Every input file is
+# scheduled with each scheduler by `circt-opt -test-ssp-scheduler`, which
+# reports the latency, the II (for cyclic problems) and the solver time of
+# every instance as remarks.
+#
+# The results are written as a JSON list with one record per instance and
+# scheduler:
+#
+#   {"instance": "corpus.mlir:12:1", "scheduler": "simplex", "latency": 20,
+#    "ii": null, "time_us": 35, "best": true}
+#
+# Instances a scheduler does not support or fails on carry an "error" instead.
+# An instance's best result minimizes the II first, and then the latency.
+#
+# Usage scheduling-bench.py --circt-opt path/to/circt-opt corpus.mlir ...
+#                           [--output results.json]
+#
+##===----------------------------------------------------------------------===##
+
+import argparse
+import json
+import math
+import re
+import subprocess
+
+SCHEDULERS = ["asap", "simplex", "lp", "cpsat"]
+
+REMARK_LINE = re.compile(r"^(.*?:\d+:\d+): remark: latency = (\d+)"
+                         r"(?:, II = (\d+))?, time = (\d+) us")
+ERROR_LINE = re.compile(r"^(.*?:\d+:\d+): error: (.*)$")
+
+
+def run(circt_opt, path, scheduler, cycle_time):
+  options = f"scheduler={scheduler} metrics=true"
+  if cycle_time is not None:
+    options += f" cycle-time={cycle_time}"
+  cmd = [
+      circt_opt, path, f"-test-ssp-scheduler={options}", "-o", "/dev/null",
+      "-mlir-print-op-on-diagnostic=false"
+  ]
+  # A non-zero exit code only means that some instances failed, which is
+  # recorded below.
+  proc = subprocess.run(cmd, capture_output=True, universal_newlines=True)
+
+  results = {}
+  for line in proc.stderr.splitlines():
+    match = REMARK_LINE.match(line)
+    if match:
+      loc, latency, ii, time = match.groups()
+      results[loc] = {
+          "latency": int(latency),
+          "ii": int(ii) if ii is not None else None,
+          "time_us": int(time)
+      }
+      continue
+    match = ERROR_LINE.match(line)
+    if match and match.group(1) not in results:
+      results[match.group(1)] = {"error": match.group(2)}
+  return results
+
+
+def quality(record):
+  return (record["ii"] or 0, record["latency"])
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description="Compare the schedulers on a corpus of SSP instances.")
+  parser.add_argument("--circt-opt", required=True, help="Path to circt-opt")
+  parser.add_argument("--output", help="JSON file to write the results to")
+  parser.add_argument("--schedulers",
+                      nargs="+",
+                      choices=SCHEDULERS,
+                      default=SCHEDULERS)
+  parser.add_argument("--cycle-time",
+                      type=float,
+                      help="Cycle time for chaining problems")
+  parser.add_argument("corpus", nargs="+", help="Files with SSP instances")
+  args = parser.parse_args()
+
+  records = []
+  for path in args.corpus:
+    for scheduler in args.schedulers:
+      for loc, result in run(args.circt_opt, path, scheduler,
+                             args.cycle_time).items():
+        records.append({"instance": loc, "scheduler": scheduler, **result})
+
+  # Mark the best solutions of every instance.
+  best = {}
+  for record in records:
+    if "error" not in record:
+      q = quality(record)
+      best[record["instance"]] = min(best.get(record["instance"], q), q)
+  for record in records:
+    if "error" not in record:
+      record["best"] = quality(record) == best[record["instance"]]
+
+  print(f"{'scheduler':10} {'solved':>8} {'best':>6} {'latency':>9} "
+        f"{'time (geomean)':>16}")
+  for scheduler in args.schedulers:
+    solved = [
+        r for r in records if r["scheduler"] == scheduler and "error" not in r
+    ]
+    if not solved:
+      print(f"{scheduler:10} {0:8}")
+      continue
+    numBest = sum(r["best"] for r in solved)
+    # The latency relative to the best latency among the solutions with the
+    # best II.
+    ratios = [
+        r["latency"] / max(best[r["instance"]][1], 1)
+        for r in solved
+        if (r["ii"] or 0) == best[r["instance"]][0]
+    ]
+    meanRatio = sum(ratios) / len(ratios) if ratios else math.nan
+    geomean = math.exp(
+        sum(math.log(max(r["time_us"], 1)) for r in solved) / len(solved))
+    print(f"{scheduler:10} {len(solved):8} {numBest:6} {meanRatio:8.3f}x "
+          f"{geomean:13.1f}us")
+
+  if args.output:
+    with open(args.output, "w") as f:
+      json.dump(records, f, indent=2)
+
+
+if __name__ == "__main__":
+  main()